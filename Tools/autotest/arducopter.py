@@ -15807,10 +15807,78 @@ return update, 1000
         ])
         return ret
 
+    def DroneCANTxQueue(self):
+        '''check DroneCAN ESC commands are not delayed by bulk TX traffic'''
+        self.context_push()
+        self.set_parameters({
+            "CAN_P1_DRIVER": 1,
+            # fly on DroneCAN ESCs, with stats and notify as extra traffic
+            "CAN_D1_UC_ESC_BM": 0x0f,
+            "CAN_D1_UC_SRV_RT": 400,
+            "CAN_D1_UC_NTF_RT": 100,
+            "CAN_D1_UC_OPTION": 256,
+            "SIM_CAN_SRV_MSK": 0xFF,
+            "SCR_ENABLE": 1,
+        })
+        # floods the bus with lowest priority broadcasts
+        self.install_test_script_context("dronecan_bulk.lua")
+        self.context_collect('STATUSTEXT')
+        self.reboot_sitl()
+        self.wait_statustext("DroneCAN bulk: started", check_context=True)
+
+        self.takeoff(10, mode='GUIDED')
+        self.delay_sim_time(20)
+        content = self.fetch_file_via_ftp("@SYS/dronecan_tx.txt")
+        self.land_and_disarm()
+        self.progress("Got content (%s)" % str(content))
+
+        lines = content.split("\n")
+        if not lines[0].startswith("DroneCAN1"):
+            raise NotAchievedException("Expected DroneCAN1 as first line not (%s)" % lines[0])
+        capacity = int(lines[1].split()[2].split("/")[1])
+
+        levels = {}
+        for line in lines[3:7]:
+            fields = line.split()
+            levels[int(fields[0])] = {
+                "budget_pct": int(fields[1].rstrip("%")),
+                "peak": int(fields[3]),
+                "transfers": int(fields[4]),
+                "rejected": int(fields[5]),
+                "coalesced": int(fields[6]),
+                "lat_avg_us": int(fields[7]),
+                "lat_max_us": int(fields[8]),
+            }
+
+        # the bulk traffic was sent, and held to its share of the pool
+        bulk = levels[3]
+        self.progress("Bulk level: %s" % str(bulk))
+        if bulk["transfers"] == 0:
+            raise NotAchievedException("No bulk traffic sent")
+        if bulk["rejected"] == 0:
+            raise NotAchievedException("Bulk traffic not limited")
+        bulk_budget = capacity * bulk["budget_pct"] // 100
+        if bulk["peak"] > bulk_budget:
+            raise NotAchievedException("Bulk traffic peak %u blocks over budget %u" % (bulk["peak"], bulk_budget))
+
+        # ESC commands are never refused and are not delayed by it
+        esc = levels[0]
+        self.progress("ESC level: %s" % str(esc))
+        if esc["transfers"] == 0:
+            raise NotAchievedException("No ESC commands sent")
+        if esc["rejected"] != 0:
+            raise NotAchievedException("ESC commands rejected")
+        if esc["lat_max_us"] > 10000:
+            raise NotAchievedException("ESC command latency %uus too high" % esc["lat_max_us"])
+
+        self.context_pop()
+        self.reboot_sitl()
+
     def testcan(self):
         ret = ([
             self.CANGPSCopterMission,
             self.TestLogDownloadMAVProxyCAN,
+            self.DroneCANTxQueue,
         ])
         return ret
 
@@ -7905,6 +7905,7 @@ class AutoTestPlane(vehicle_test_suite.TestSuite):
             self.ForcedDCM,
             self.DCMFallback,
             self.MAVFTP,
+            self.MAVFTPLargeFile,
             self.AUTOTUNE,
             self.AutotuneFiltering,
             self.MegaSquirt,
@@ -14702,8 +14702,10 @@ switch value'''
         if abs(new_gpi_alt2 - m.alt) > 100:
             raise NotAchievedException("Failover not detected")
 
-    def fetch_file_via_ftp(self, path, timeout=20):
-        '''returns the content of the FTP'able file at path'''
+    def fetch_file_via_ftp(self, path, timeout=20, stats=None):
+        '''returns the content of the FTP'able file at path.  If stats is
+        a dict, the wallclock transfer time is stored in it as
+        "transfer_time"'''
         self.progress("Retrieving (%s) using MAVProxy" % path)
         mavproxy = self.start_mavproxy()
         mavproxy.expect("Saved .* parameters to")
@@ -14716,6 +14718,9 @@ switch value'''
             mavproxy.send("ftp get %s %s\n" % (path, tmpfile.name))
             mavproxy.expect("Getting")
             tstart = self.get_sim_time()
+            wallclock_start = time.time()
+            # poll more often when timing the transfer
+            poll_timeout = 1 if stats is None else 0.1
             while True:
                 now = self.get_sim_time()
                 if now - tstart > timeout:
@@ -14723,10 +14728,12 @@ switch value'''
                 self.progress("Polling status")
                 mavproxy.send("ftp status\n")
                 try:
-                    mavproxy.expect("No transfer in progress", timeout=1)
+                    mavproxy.expect("No transfer in progress", timeout=poll_timeout)
                     break
                 except Exception:
                     continue
+            if stats is not None:
+                stats["transfer_time"] = time.time() - wallclock_start
             # terminate the connection, or it may still be in progress the next time an FTP is attempted:
             mavproxy.send("ftp cancel\n")
             mavproxy.expect("Terminated session")
@@ -14767,6 +14774,37 @@ switch value'''
         if ex is not None:
             raise ex
 
+    def MAVFTPLargeFile(self):
+        '''measure MAVFTP burst-read throughput on a large file'''
+        # the autopilot's working directory is our working directory,
+        # so a file written here can be fetched from the root:
+        filename = "mavftp-large-file.txt"
+        size = 512 * 1024
+        line = "".join([chr(ord('a') + (i % 26)) for i in range(63)]) + "\n"
+        content = (line * (size // len(line) + 1))[:size]
+        with open(filename, "w") as f:
+            f.write(content)
+
+        # run in real time so the wallclock transfer time is meaningful
+        self.context_push()
+        self.set_parameter("SIM_SPEEDUP", 1)
+        stats = {}
+        try:
+            fetched = self.fetch_file_via_ftp(filename, timeout=120, stats=stats)
+        finally:
+            os.unlink(filename)
+            self.context_pop()
+
+        if fetched != content:
+            raise NotAchievedException("Fetched content differs (got %u bytes, want %u)" %
+                                       (len(fetched), len(content)))
+        elapsed = stats["transfer_time"]
+        rate = size / 1024.0 / elapsed
+        self.progress("MAVFTP: fetched %u bytes in %.1fs (%.1f kB/s)" % (size, elapsed, rate))
+        min_rate = 50
+        if rate < min_rate:
+            raise NotAchievedException("MAVFTP throughput %.1f kB/s below %u kB/s" % (rate, min_rate))
+
     def write_content_to_filepath(self, content, filepath):
         '''write biunary content to filepath'''
         if not isinstance(content, bytes):
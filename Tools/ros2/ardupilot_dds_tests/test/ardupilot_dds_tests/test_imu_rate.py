@@ -0,0 +1,223 @@
+# Copyright 2023 ArduPilot.org.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+# flake8: noqa
+
+"""
+Bring up ArduPilot SITL in real time and measure the sustained IMU rate over UDP.
+
+DDS_IMU_RATE is raised with the set_parameters service, then the rate is
+measured from the header stamps of the messages received.
+
+colcon test --packages-select ardupilot_dds_tests \
+--event-handlers=console_cohesion+ --pytest-args -k test_imu_rate
+
+"""
+
+import launch_pytest
+import pytest
+import rclpy
+import rclpy.node
+import threading
+import time
+
+from pathlib import Path
+
+from ament_index_python.packages import get_package_share_directory
+
+from launch import LaunchDescription
+from launch import LaunchDescriptionSource
+from launch.actions import IncludeLaunchDescription
+
+from launch_pytest.tools import process as process_tools
+
+from rclpy.qos import QoSProfile
+from rclpy.qos import QoSReliabilityPolicy
+from rclpy.qos import QoSHistoryPolicy
+
+from rcl_interfaces.msg import Parameter
+from rcl_interfaces.srv import SetParameters
+from sensor_msgs.msg import Imu
+
+from ardupilot_sitl.launch import SITLLaunch
+
+TOPIC = "ap/imu/experimental/data"
+WAIT_FOR_START_TIMEOUT = 5.0
+PARAMETER_INTEGER = 2
+
+IMU_RATE_HZ = 400
+SETTLE_TIME = 2.0
+MEASURE_TIME = 10.0
+# fraction of the requested rate which must be achieved
+MIN_RATE_RATIO = 0.95
+
+
+class ImuRateListener(rclpy.node.Node):
+    """Set the IMU rate and count the IMU messages received."""
+
+    def __init__(self):
+        """Initialise the node."""
+        super().__init__("imu_rate_listener")
+        self.lock = threading.Lock()
+        self.counting = False
+        self.count = 0
+        self.first_stamp = None
+        self.last_stamp = None
+
+    def start(self):
+        """Start the subscriber and parameter client."""
+        self.set_cli = self.create_client(SetParameters, "ap/set_parameters")
+        while not self.set_cli.wait_for_service(timeout_sec=1.0):
+            self.get_logger().info("SetParameters service not available, waiting again...")
+
+        qos_profile = QoSProfile(
+            reliability=QoSReliabilityPolicy.BEST_EFFORT,
+            history=QoSHistoryPolicy.KEEP_LAST,
+            depth=100,
+        )
+        self.subscription = self.create_subscription(Imu, TOPIC, self.subscriber_callback, qos_profile)
+
+        # Add a spin thread.
+        self.ros_spin_thread = threading.Thread(target=lambda node: rclpy.spin(node), args=(self,))
+        self.ros_spin_thread.start()
+
+    def set_rate(self, rate_hz):
+        """Set DDS_IMU_RATE, returns True on success."""
+        req = SetParameters.Request()
+        param = Parameter()
+        param.name = "DDS_IMU_RATE"
+        param.value.type = PARAMETER_INTEGER
+        param.value.integer_value = rate_hz
+        req.parameters.append(param)
+
+        future = self.set_cli.call_async(req)
+        while not future.done():
+            time.sleep(0.1)
+        return future.result().results[0].successful
+
+    def subscriber_callback(self, msg):
+        """Count an IMU message."""
+        with self.lock:
+            if not self.counting:
+                return
+            stamp = msg.header.stamp.sec + msg.header.stamp.nanosec * 1e-9
+            if self.first_stamp is None:
+                self.first_stamp = stamp
+            else:
+                self.count += 1
+            self.last_stamp = stamp
+
+    def measure(self, duration):
+        """Return the rate in Hz over duration seconds, by the vehicle clock."""
+        with self.lock:
+            self.counting = True
+        time.sleep(duration)
+        with self.lock:
+            self.counting = False
+            if self.first_stamp is None or self.last_stamp <= self.first_stamp:
+                return 0.0
+            return self.count / (self.last_stamp - self.first_stamp)
+
+
+@pytest.fixture(scope="function")
+def sitl_copter_dds_udp_realtime(micro_ros_agent_udp, mavproxy):
+    """Fixture to bring up ArduPilot SITL DDS without speedup."""
+    mra_ld, mra_actions = micro_ros_agent_udp
+    mp_ld, mp_actions = mavproxy
+    sitl_ld, sitl_actions = SITLLaunch.generate_launch_description_with_actions()
+
+    sitl_ld_args = IncludeLaunchDescription(
+        LaunchDescriptionSource(sitl_ld),
+        launch_arguments={
+            "command": "arducopter",
+            "synthetic_clock": "True",
+            "wipe": "False",
+            "model": "quad",
+            "speedup": "1",
+            "slave": "0",
+            "instance": "0",
+            "defaults": str(
+                Path(
+                    get_package_share_directory("ardupilot_sitl"),
+                    "config",
+                    "default_params",
+                    "copter.parm",
+                )
+            )
+            + ","
+            + str(
+                Path(
+                    get_package_share_directory("ardupilot_sitl"),
+                    "config",
+                    "default_params",
+                    "dds_udp.parm",
+                )
+            ),
+        }.items(),
+    )
+
+    ld = LaunchDescription(
+        [
+            mra_ld,
+            mp_ld,
+            sitl_ld_args,
+        ]
+    )
+    actions = {}
+    actions.update(mra_actions)
+    actions.update(mp_actions)
+    actions.update(sitl_actions)
+    yield ld, actions
+
+
+@launch_pytest.fixture
+def launch_sitl_copter_dds_udp_realtime(sitl_copter_dds_udp_realtime):
+    """Fixture to create the launch description."""
+    sitl_ld, sitl_actions = sitl_copter_dds_udp_realtime
+
+    ld = LaunchDescription(
+        [
+            sitl_ld,
+            launch_pytest.actions.ReadyToTest(),
+        ]
+    )
+    yield ld, sitl_actions
+
+
+@pytest.mark.launch(fixture=launch_sitl_copter_dds_udp_realtime)
+def test_dds_udp_imu_rate(launch_context, launch_sitl_copter_dds_udp_realtime):
+    """Test the IMU is published at DDS_IMU_RATE over UDP."""
+    _, actions = launch_sitl_copter_dds_udp_realtime
+    micro_ros_agent = actions["micro_ros_agent"].action
+    mavproxy = actions["mavproxy"].action
+    sitl = actions["sitl"].action
+
+    # Wait for process to start.
+    process_tools.wait_for_start_sync(launch_context, micro_ros_agent, timeout=WAIT_FOR_START_TIMEOUT)
+    process_tools.wait_for_start_sync(launch_context, mavproxy, timeout=WAIT_FOR_START_TIMEOUT)
+    process_tools.wait_for_start_sync(launch_context, sitl, timeout=WAIT_FOR_START_TIMEOUT)
+
+    rclpy.init()
+    try:
+        node = ImuRateListener()
+        node.start()
+        assert node.set_rate(IMU_RATE_HZ), f"Could not set DDS_IMU_RATE to {IMU_RATE_HZ}"
+        time.sleep(SETTLE_TIME)
+        rate = node.measure(MEASURE_TIME)
+        node.get_logger().info(f"IMU rate {rate:.1f} Hz, requested {IMU_RATE_HZ} Hz")
+        assert rate >= IMU_RATE_HZ * MIN_RATE_RATIO, f"IMU rate {rate:.1f} Hz below {IMU_RATE_HZ} Hz"
+    finally:
+        rclpy.shutdown()
+    yield
@@ -36,6 +36,7 @@ const float OA_BENDYRULER_LOOKAHEAD_STEP2_RATIO = 1.0f; // step2's lookahead len
 const float OA_BENDYRULER_LOOKAHEAD_STEP2_MIN = 2.0f;   // step2 checks at least this many meters past step1's location
 const float OA_BENDYRULER_LOOKAHEAD_PAST_DEST = 2.0f;   // lookahead length will be at least this many meters past the destination
 const float OA_BENDYRULER_LOW_SPEED_SQUARED = (0.2f * 0.2f);    // when ground course is below this speed squared, vehicle's heading will be used
+const uint16_t OA_BENDYRULER_OBSTACLES_INCREMENT = 32;  // object database snapshot grows in increments of this many items
 
 #define VERTICAL_ENABLED APM_BUILD_COPTER_OR_HELI
 
@@ -119,6 +120,9 @@ bool AP_OABendyRuler::update(const Location& current_loc, const Location& destin
         ground_course_deg = degrees(ground_speed_vec.angle());
     }
 
+    // snapshot the fence and object database once for all paths tested below
+    update_margin_cache();
+
     bool ret;
     switch (get_type()) {
         case OABendyType::OA_BENDY_VERTICAL:
@@ -143,14 +147,11 @@ bool AP_OABendyRuler::search_xy_path(const Location& current_loc, const Location
     // check OA_BEARING_INC definition allows checking in all directions
     static_assert(360 % OA_BENDYRULER_BEARING_INC_XY == 0, "check 360 is a multiple of OA_BEARING_INC");
 
-    // search in OA_BENDYRULER_BEARING_INC degree increments around the vehicle alternating left
-    // and right. For each direction check if vehicle would avoid all obstacles
-    float best_bearing = bearing_to_dest;
-    float best_bearing_margin = -FLT_MAX;
-    bool have_best_bearing = false;
-    float best_margin = -FLT_MAX;
-    float best_margin_bearing = best_bearing;
+    static_assert(1 + 2 * (170 / OA_BENDYRULER_BEARING_INC_XY) <= OA_BENDYRULER_CANDIDATES_MAX, "OA_BENDYRULER_CANDIDATES_MAX too small");
 
+    // search in OA_BENDYRULER_BEARING_INC degree increments around the vehicle alternating left
+    // and right.  Project the test location for each bearing in the order they are checked
+    uint8_t num_candidates = 0;
     for (uint8_t i = 0; i <= (170 / OA_BENDYRULER_BEARING_INC_XY); i++) {
         for (uint8_t bdir = 0; bdir <= 1; bdir++) {
             // skip duplicate check of bearing straight towards destination
@@ -167,54 +168,84 @@ bool AP_OABendyRuler::search_xy_path(const Location& current_loc, const Location
             // test location is projected from current location at test bearing
             Location test_loc = current_loc;
             test_loc.offset_bearing(bearing_test, lookahead_step1_dist);
+            _candidate_bearings[num_candidates] = bearing_test;
+            _candidates[num_candidates].set(test_loc);
+            num_candidates++;
+        }
+    }
 
-            // calculate margin from obstacles for this scenario
-            float margin = calc_avoidance_margin(current_loc, test_loc, proximity_only);
-            if (margin > best_margin) {
-                best_margin_bearing = bearing_test;
-                best_margin = margin;
-            }
-            if (margin > _margin_max) {
-                // this bearing avoids obstacles out to the lookahead_step1_dist
-                // now check in there is a clear path in three directions towards the destination
-                if (!have_best_bearing) {
-                    best_bearing = bearing_test;
-                    best_bearing_margin = margin;
-                    have_best_bearing = true;
-                } else if (fabsf(wrap_180(ground_course_deg - bearing_test)) <
-                           fabsf(wrap_180(ground_course_deg - best_bearing))) {
-                    // replace bearing with one that is closer to our current ground course
-                    best_bearing = bearing_test;
-                    best_bearing_margin = margin;
-                }
+    PathPoint start;
+    start.set(current_loc);
 
-                // perform second stage test in three directions looking for obstacles
-                const float test_bearings[] { 0.0f, 45.0f, -45.0f };
-                const float bearing_to_dest2 = test_loc.get_bearing_to(destination) * 0.01f;
-                float distance2 = constrain_float(lookahead_step2_dist, OA_BENDYRULER_LOOKAHEAD_STEP2_MIN, test_loc.get_distance(destination));
-                for (uint8_t j = 0; j < ARRAY_SIZE(test_bearings); j++) {
-                    float bearing_test2 = wrap_180(bearing_to_dest2 + test_bearings[j]);
-                    Location test_loc2 = test_loc;
-                    test_loc2.offset_bearing(bearing_test2, distance2);
+    // for each direction check if vehicle would avoid all obstacles
+    float best_bearing = bearing_to_dest;
+    float best_bearing_margin = -FLT_MAX;
+    bool have_best_bearing = false;
+    float best_margin = -FLT_MAX;
+    float best_margin_bearing = best_bearing;
+    uint8_t num_scored = 0;
+
+    for (uint8_t k = 0; k < num_candidates; k++) {
+        // the bearing straight towards the destination is usually clear so is scored on
+        // its own.  If it is not all other bearings are scored together
+        if (k == num_scored) {
+            const uint8_t num_to_score = (k == 0) ? 1 : (num_candidates - k);
+            calc_avoidance_margins(start, &_candidates[k], num_to_score, &_candidate_margins[k], proximity_only);
+            num_scored += num_to_score;
+        }
+        const float bearing_test = _candidate_bearings[k];
+        const Location &test_loc = _candidates[k].loc;
+        const float margin = _candidate_margins[k];
 
-                    // calculate minimum margin to fence and obstacles for this scenario
-                    float margin2 = calc_avoidance_margin(test_loc, test_loc2, proximity_only);
-                    if (margin2 > _margin_max) {
-                        // if the chosen direction is directly towards the destination avoidance can be turned off
-                        // i == 0 && j == 0 implies no deviation from bearing to destination 
-                        const bool active = (i != 0 || j != 0);
-                        float final_bearing = bearing_test;
-                        float final_margin = margin;
-                        // check if we need ignore test_bearing and continue on previous bearing
-                        const bool ignore_bearing_change = resist_bearing_change(destination, current_loc, active, bearing_test, lookahead_step1_dist, margin, _destination_prev,_bearing_prev, final_bearing, final_margin, proximity_only);
+        if (margin > best_margin) {
+            best_margin_bearing = bearing_test;
+            best_margin = margin;
+        }
+        if (margin > _margin_max) {
+            // this bearing avoids obstacles out to the lookahead_step1_dist
+            // now check in there is a clear path in three directions towards the destination
+            if (!have_best_bearing) {
+                best_bearing = bearing_test;
+                best_bearing_margin = margin;
+                have_best_bearing = true;
+            } else if (fabsf(wrap_180(ground_course_deg - bearing_test)) <
+                       fabsf(wrap_180(ground_course_deg - best_bearing))) {
+                // replace bearing with one that is closer to our current ground course
+                best_bearing = bearing_test;
+                best_bearing_margin = margin;
+            }
 
-                        // all good, now project in the chosen direction by the full distance
-                        destination_new = current_loc;
-                        destination_new.offset_bearing(final_bearing, MIN(distance_to_dest, lookahead_step1_dist));
-                        _current_lookahead = MIN(_lookahead, _current_lookahead * 1.1f);
-                        Write_OABendyRuler((uint8_t)OABendyType::OA_BENDY_HORIZONTAL, active, bearing_to_dest, 0.0f, ignore_bearing_change, final_margin, destination, destination_new);
-                        return active;
-                    }
+            // perform second stage test in three directions looking for obstacles
+            const float test_bearings[] { 0.0f, 45.0f, -45.0f };
+            const float bearing_to_dest2 = test_loc.get_bearing_to(destination) * 0.01f;
+            float distance2 = constrain_float(lookahead_step2_dist, OA_BENDYRULER_LOOKAHEAD_STEP2_MIN, test_loc.get_distance(destination));
+            PathPoint test_points2[ARRAY_SIZE(test_bearings)];
+            float margins2[ARRAY_SIZE(test_bearings)];
+            for (uint8_t j = 0; j < ARRAY_SIZE(test_bearings); j++) {
+                float bearing_test2 = wrap_180(bearing_to_dest2 + test_bearings[j]);
+                Location test_loc2 = test_loc;
+                test_loc2.offset_bearing(bearing_test2, distance2);
+                test_points2[j].set(test_loc2);
+            }
+
+            // calculate minimum margin to fence and obstacles for these scenarios
+            calc_avoidance_margins(_candidates[k], test_points2, ARRAY_SIZE(test_bearings), margins2, proximity_only);
+            for (uint8_t j = 0; j < ARRAY_SIZE(test_bearings); j++) {
+                if (margins2[j] > _margin_max) {
+                    // if the chosen direction is directly towards the destination avoidance can be turned off
+                    // k == 0 && j == 0 implies no deviation from bearing to destination 
+                    const bool active = (k != 0 || j != 0);
+                    float final_bearing = bearing_test;
+                    float final_margin = margin;
+                    // check if we need ignore test_bearing and continue on previous bearing
+                    const bool ignore_bearing_change = resist_bearing_change(destination, current_loc, active, bearing_test, lookahead_step1_dist, margin, _destination_prev,_bearing_prev, final_bearing, final_margin, proximity_only);
+
+                    // all good, now project in the chosen direction by the full distance
+                    destination_new = current_loc;
+                    destination_new.offset_bearing(final_bearing, MIN(distance_to_dest, lookahead_step1_dist));
+                    _current_lookahead = MIN(_lookahead, _current_lookahead * 1.1f);
+                    Write_OABendyRuler((uint8_t)OABendyType::OA_BENDY_HORIZONTAL, active, bearing_to_dest, 0.0f, ignore_bearing_change, final_margin, destination, destination_new);
+                    return active;
                 }
             }
         }
@@ -416,159 +447,201 @@ bool AP_OABendyRuler::resist_bearing_change(const Location &destination, const L
     return resisted_change;
 }
 
+// convert a location to offsets from the EKF origin
+void AP_OABendyRuler::PathPoint::set(const Location &_loc)
+{
+    loc = _loc;
+    NE_ok = loc.get_vector_xy_from_origin_NE_cm(NE_cm);
+    int32_t alt_above_origin_cm;
+    NEU_ok = NE_ok && loc.get_alt_cm(Location::AltFrame::ABOVE_ORIGIN, alt_above_origin_cm);
+    if (NEU_ok) {
+        NEU_cm = Vector3f{NE_cm.x, NE_cm.y, float(alt_above_origin_cm)};
+    }
+}
+
+// refresh the fence and object database snapshot used to calculate margins
+void AP_OABendyRuler::update_margin_cache()
+{
+#if AP_FENCE_ENABLED
+    const AC_Fence *fence = AC_Fence::get_singleton();
+    _fence_cache.enabled = (fence != nullptr);
+    if (fence != nullptr) {
+        _fence_cache.enabled_fences = fence->get_enabled_fences();
+        _fence_cache.margin_ne_m = fence->get_margin_ne_m();
+        _fence_cache.radius_m = fence->get_radius_m();
+        _fence_cache.safe_alt_max_m = fence->get_safe_alt_max_m();
+        _fence_cache.home = AP::ahrs().get_home();
+    }
+#endif
+
+    // copy the object database so each path does not need to convert every item
+    _num_obstacles = 0;
+    _obstacles_cached = false;
+    const AP_OADatabase *oaDb = AP::oadatabase();
+    if (oaDb == nullptr || !oaDb->healthy()) {
+        return;
+    }
+    const uint16_t count = oaDb->database_count();
+    if (count > _obstacles_max) {
+        delete[] _obstacles;
+        _obstacles_max = 0;
+        _obstacles = NEW_NOTHROW Obstacle[count + OA_BENDYRULER_OBSTACLES_INCREMENT];
+        if (_obstacles == nullptr) {
+            // calc_margins_from_object_database will read the database instead
+            return;
+        }
+        _obstacles_max = count + OA_BENDYRULER_OBSTACLES_INCREMENT;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        const AP_OADatabase::OA_DbItem& item = oaDb->get_item(i);
+        _obstacles[i].pos_cm = item.pos * 100.0f;
+        _obstacles[i].radius = item.radius;
+    }
+    _num_obstacles = count;
+    _obstacles_cached = true;
+}
+
 // calculate minimum distance between a segment and any obstacle
 float AP_OABendyRuler::calc_avoidance_margin(const Location &start, const Location &end, bool proximity_only) const
 {
-    float margin_min = FLT_MAX;
+    PathPoint start_pt, end_pt;
+    start_pt.set(start);
+    end_pt.set(end);
 
-    float latest_margin;
-    
-    if (calc_margin_from_object_database(start, end, latest_margin)) {
-        margin_min = MIN(margin_min, latest_margin);
+    float margin = FLT_MAX;
+    calc_avoidance_margins(start_pt, &end_pt, 1, &margin, proximity_only);
+    return margin;
+}
+
+// calculate minimum distance between each path from start to ends[i] and any obstacle
+void AP_OABendyRuler::calc_avoidance_margins(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins, bool proximity_only) const
+{
+    for (uint8_t i = 0; i < num_ends; i++) {
+        margins[i] = FLT_MAX;
     }
-    
+
+    calc_margins_from_object_database(start, ends, num_ends, margins);
+
     if (proximity_only) {
         // only need margin from proximity data
-        return margin_min;
-    }
-    
-    if (calc_margin_from_circular_fence(start, end, latest_margin)) {
-        margin_min = MIN(margin_min, latest_margin);
+        return;
     }
-    
+
+    calc_margins_from_circular_fence(start, ends, num_ends, margins);
+
     #if VERTICAL_ENABLED 
     // alt fence only is only needed in vertical avoidance
     if (get_type() == OABendyType::OA_BENDY_VERTICAL) {
-        if (calc_margin_from_alt_fence(start, end, latest_margin)) {
-            margin_min = MIN(margin_min, latest_margin);
-        }
+        calc_margins_from_alt_fence(start, ends, num_ends, margins);
     }
     #endif
 
-    if (calc_margin_from_inclusion_and_exclusion_polygons(start, end, latest_margin)) {
-        margin_min = MIN(margin_min, latest_margin);
-    }
-
-    if (calc_margin_from_inclusion_and_exclusion_circles(start, end, latest_margin)) {
-        margin_min = MIN(margin_min, latest_margin);
-    }
+    calc_margins_from_inclusion_and_exclusion_polygons(start, ends, num_ends, margins);
 
-    // return smallest margin from any obstacle
-    return margin_min;
+    calc_margins_from_inclusion_and_exclusion_circles(start, ends, num_ends, margins);
 }
 
-// calculate minimum distance between a path and the circular fence (centered on home)
-// on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_circular_fence(const Location &start, const Location &end, float &margin) const
+// lower margins[i] to the minimum distance between each path from start to ends[i] and the circular fence (centered on home)
+void AP_OABendyRuler::calc_margins_from_circular_fence(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins) const
 {
 #if AP_FENCE_ENABLED
-    // exit immediately if polygon fence is not enabled
-    const AC_Fence *fence = AC_Fence::get_singleton();
-    if (fence == nullptr) {
-        return false;
-    }
-    if ((fence->get_enabled_fences() & AC_FENCE_TYPE_CIRCLE) == 0) {
-        return false;
+    // exit immediately if circular fence is not enabled
+    if (!_fence_cache.enabled || (_fence_cache.enabled_fences & AC_FENCE_TYPE_CIRCLE) == 0) {
+        return;
     }
 
-    // calculate start and end point's distance from home
-    const Location &ahrs_home = AP::ahrs().get_home();
-    const float start_dist_sq = ahrs_home.get_distance_NE(start).length_squared();
-    const float end_dist_sq = ahrs_home.get_distance_NE(end).length_squared();
-
     // get circular fence radius + margin
-    const float fence_radius_plus_margin = fence->get_radius_m() - fence->get_margin_ne_m();
+    const float fence_radius_plus_margin = _fence_cache.radius_m - _fence_cache.margin_ne_m;
 
-    // margin is fence radius minus the longer of start or end distance
-    margin = fence_radius_plus_margin - sqrtf(MAX(start_dist_sq, end_dist_sq));
-    return true;
-#else
-    return false;
+    // calculate start and end point's distance from home
+    const float start_dist_sq = _fence_cache.home.get_distance_NE(start.loc).length_squared();
+    for (uint8_t i = 0; i < num_ends; i++) {
+        const float end_dist_sq = _fence_cache.home.get_distance_NE(ends[i].loc).length_squared();
+
+        // margin is fence radius minus the longer of start or end distance
+        margins[i] = MIN(margins[i], fence_radius_plus_margin - sqrtf(MAX(start_dist_sq, end_dist_sq)));
+    }
 #endif // AP_FENCE_ENABLED
 }
 
-// calculate minimum distance between a path and the altitude fence
-// on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_alt_fence(const Location &start, const Location &end, float &margin) const
+// lower margins[i] to the minimum distance between each path from start to ends[i] and the altitude fence
+void AP_OABendyRuler::calc_margins_from_alt_fence(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins) const
 {
 #if AP_FENCE_ENABLED
-    // exit immediately if polygon fence is not enabled
-    const AC_Fence *fence = AC_Fence::get_singleton();
-    if (fence == nullptr) {
-        return false;
-    }
-    if ((fence->get_enabled_fences() & AC_FENCE_TYPE_ALT_MAX) == 0) {
-        return false;
+    // exit immediately if altitude fence is not enabled
+    if (!_fence_cache.enabled || (_fence_cache.enabled_fences & AC_FENCE_TYPE_ALT_MAX) == 0) {
+        return;
     }
 
-    int32_t alt_above_home_cm_start, alt_above_home_cm_end;    
-    if (!start.get_alt_cm(Location::AltFrame::ABOVE_HOME, alt_above_home_cm_start)) {
-        return false;
-    }
-    if (!end.get_alt_cm(Location::AltFrame::ABOVE_HOME, alt_above_home_cm_end )) {
-        return false;
+    int32_t alt_above_home_cm_start;
+    if (!start.loc.get_alt_cm(Location::AltFrame::ABOVE_HOME, alt_above_home_cm_start)) {
+        return;
     }
 
     // safe max alt = fence alt - fence margin
-    const float max_fence_alt = fence->get_safe_alt_max_m();
+    const float max_fence_alt = _fence_cache.safe_alt_max_m;
     const float margin_start =  max_fence_alt - alt_above_home_cm_start * 0.01f;
-    const float margin_end =  max_fence_alt - alt_above_home_cm_end * 0.01f;
 
-    // margin is minimum distance to fence from either start or end location
-    margin = MIN(margin_start,margin_end);
+    for (uint8_t i = 0; i < num_ends; i++) {
+        int32_t alt_above_home_cm_end;
+        if (!ends[i].loc.get_alt_cm(Location::AltFrame::ABOVE_HOME, alt_above_home_cm_end)) {
+            continue;
+        }
+        const float margin_end =  max_fence_alt - alt_above_home_cm_end * 0.01f;
 
-    return true;
-#else
-    return false;
+        // margin is minimum distance to fence from either start or end location
+        margins[i] = MIN(margins[i], MIN(margin_start, margin_end));
+    }
 #endif // AP_FENCE_ENABLED
 }
 
-// calculate minimum distance between a path and all inclusion and exclusion polygons
-// on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Location &start, const Location &end, float &margin) const
+// lower margins[i] to the minimum distance between each path from start to ends[i] and all inclusion and exclusion polygons
+void AP_OABendyRuler::calc_margins_from_inclusion_and_exclusion_polygons(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins) const
 {
 #if AP_FENCE_ENABLED
+    // exclusion polygons enabled along with polygon fences
+    if (!_fence_cache.enabled || (_fence_cache.enabled_fences & AC_FENCE_TYPE_POLYGON) == 0) {
+        return;
+    }
     const AC_Fence *fence = AC_Fence::get_singleton();
     if (fence == nullptr) {
-        return false;
-    }
-
-    // exclusion polygons enabled along with polygon fences
-    if ((fence->get_enabled_fences() & AC_FENCE_TYPE_POLYGON) == 0) {
-        return false;
+        return;
     }
 
     // return immediately if no inclusion nor exclusion polygons
     const uint8_t num_inclusion_polygons = fence->polyfence().get_inclusion_polygon_count();
     const uint8_t num_exclusion_polygons = fence->polyfence().get_exclusion_polygon_count();
     if ((num_inclusion_polygons == 0) && (num_exclusion_polygons == 0)) {
-        return false;
+        return;
     }
 
-    // convert start and end to offsets from EKF origin
-    Vector2f start_NE, end_NE;
-    if (!start.get_vector_xy_from_origin_NE_cm(start_NE) ||
-        !end.get_vector_xy_from_origin_NE_cm(end_NE)) {
-        return false;
+    // start and end must be offsets from EKF origin
+    if (!start.NE_ok) {
+        return;
     }
+    const Vector2f &start_NE = start.NE_cm;
 
     // get fence margin
-    const float fence_margin = fence->get_margin_ne_m();
+    const float fence_margin = _fence_cache.margin_ne_m;
 
     // iterate through inclusion polygons and calculate minimum margin
-    bool margin_updated = false;
     for (uint8_t i = 0; i < num_inclusion_polygons; i++) {
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
-     
+        const AP_PolygonIndex<float>* poly_index = fence->polyfence().get_inclusion_polygon_index(i);
+
         // if outside the fence margin is the closest distance but with negative sign
-        const float sign = Polygon_outside(start_NE, boundary, num_points) ? -1.0f : 1.0f;
+        const bool outside = (poly_index != nullptr) ? poly_index->outside(start_NE) : Polygon_outside(start_NE, boundary, num_points);
+        const float sign = outside ? -1.0f : 1.0f;
 
-        // calculate min distance (in meters) from line to polygon
-        float margin_new = (sign * Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE) * 0.01f) - fence_margin;
-        if (!margin_updated || (margin_new < margin)) {
-            margin_updated = true;
-            margin = margin_new;
+        // calculate min distance (in meters) from each line to polygon
+        for (uint8_t j = 0; j < num_ends; j++) {
+            if (!ends[j].NE_ok) {
+                continue;
+            }
+            const Vector2f &end_NE = ends[j].NE_cm;
+            const float distance = (poly_index != nullptr) ? poly_index->closest_distance_line(start_NE, end_NE) : Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE);
+            margins[j] = MIN(margins[j], (sign * distance * 0.01f) - fence_margin);
         }
     }
 
@@ -576,59 +649,55 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Lo
     for (uint8_t i = 0; i < num_exclusion_polygons; i++) {
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
-   
+        const AP_PolygonIndex<float>* poly_index = fence->polyfence().get_exclusion_polygon_index(i);
+
         // if start is inside the polygon the margin's sign is reversed
-        const float sign = Polygon_outside(start_NE, boundary, num_points) ? 1.0f : -1.0f;
+        const bool outside = (poly_index != nullptr) ? poly_index->outside(start_NE) : Polygon_outside(start_NE, boundary, num_points);
+        const float sign = outside ? 1.0f : -1.0f;
 
-        // calculate min distance (in meters) from line to polygon
-        float margin_new = (sign * Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE) * 0.01f) - fence_margin;
-        if (!margin_updated || (margin_new < margin)) {
-            margin_updated = true;
-            margin = margin_new;
+        // calculate min distance (in meters) from each line to polygon
+        for (uint8_t j = 0; j < num_ends; j++) {
+            if (!ends[j].NE_ok) {
+                continue;
+            }
+            const Vector2f &end_NE = ends[j].NE_cm;
+            const float distance = (poly_index != nullptr) ? poly_index->closest_distance_line(start_NE, end_NE) : Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE);
+            margins[j] = MIN(margins[j], (sign * distance * 0.01f) - fence_margin);
         }
     }
-
-    return margin_updated;
-#else
-    return false;
 #endif // AP_FENCE_ENABLED
 }
 
-// calculate minimum distance between a path and all inclusion and exclusion circles
-// on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Location &start, const Location &end, float &margin) const
+// lower margins[i] to the minimum distance between each path from start to ends[i] and all inclusion and exclusion circles
+void AP_OABendyRuler::calc_margins_from_inclusion_and_exclusion_circles(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins) const
 {
 #if AP_FENCE_ENABLED
-    // exit immediately if fence is not enabled
+    // inclusion/exclusion circles enabled along with polygon fences
+    if (!_fence_cache.enabled || (_fence_cache.enabled_fences & AC_FENCE_TYPE_POLYGON) == 0) {
+        return;
+    }
     const AC_Fence *fence = AC_Fence::get_singleton();
     if (fence == nullptr) {
-        return false;
-    }
-
-    // inclusion/exclusion circles enabled along with polygon fences
-    if ((fence->get_enabled_fences() & AC_FENCE_TYPE_POLYGON) == 0) {
-        return false;
+        return;
     }
 
     // return immediately if no inclusion nor exclusion circles
     const uint8_t num_inclusion_circles = fence->polyfence().get_inclusion_circle_count();
     const uint8_t num_exclusion_circles = fence->polyfence().get_exclusion_circle_count();
     if ((num_inclusion_circles == 0) && (num_exclusion_circles == 0)) {
-        return false;
+        return;
     }
 
-    // convert start and end to offsets from EKF origin
-    Vector2f start_NE, end_NE;
-    if (!start.get_vector_xy_from_origin_NE_cm(start_NE) ||
-        !end.get_vector_xy_from_origin_NE_cm(end_NE)) {
-        return false;
+    // start and end must be offsets from EKF origin
+    if (!start.NE_ok) {
+        return;
     }
+    const Vector2f &start_NE = start.NE_cm;
 
     // get fence margin
-    const float fence_margin = fence->get_margin_ne_m();
+    const float fence_margin = _fence_cache.margin_ne_m;
 
     // iterate through inclusion circles and calculate minimum margin
-    bool margin_updated = false;
     for (uint8_t i = 0; i < num_inclusion_circles; i++) {
         Vector2f center_pos_cm;
         float radius;
@@ -636,15 +705,15 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Loc
 
             // calculate start and ends distance from the center of the circle
             const float start_dist_sq = (start_NE - center_pos_cm).length_squared();
-            const float end_dist_sq = (end_NE - center_pos_cm).length_squared();
-
-            // margin is fence radius minus the longer of start or end distance
-            const float margin_new = (radius + fence_margin) - (sqrtf(MAX(start_dist_sq, end_dist_sq)) * 0.01f);
+            for (uint8_t j = 0; j < num_ends; j++) {
+                if (!ends[j].NE_ok) {
+                    continue;
+                }
+                const float end_dist_sq = (ends[j].NE_cm - center_pos_cm).length_squared();
 
-            // update margin with lowest value so far
-            if (!margin_updated || (margin_new < margin)) {
-                margin_updated = true;
-                margin = margin_new;
+                // margin is fence radius minus the longer of start or end distance
+                const float margin_new = (radius + fence_margin) - (sqrtf(MAX(start_dist_sq, end_dist_sq)) * 0.01f);
+                margins[j] = MIN(margins[j], margin_new);
             }
         }
     }
@@ -654,66 +723,85 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Loc
         Vector2f center_pos_cm;
         float radius;
         if (fence->polyfence().get_exclusion_circle(i, center_pos_cm, radius)) {
+            for (uint8_t j = 0; j < num_ends; j++) {
+                if (!ends[j].NE_ok) {
+                    continue;
+                }
 
-            // first calculate distance between circle's center and segment
-            const float dist_cm = Vector2f::closest_distance_between_line_and_point(start_NE, end_NE, center_pos_cm);
-
-            // margin is distance to the center minus the radius
-            const float margin_new = (dist_cm * 0.01f) - (radius + fence_margin);
+                // first calculate distance between circle's center and segment
+                const float dist_cm = Vector2f::closest_distance_between_line_and_point(start_NE, ends[j].NE_cm, center_pos_cm);
 
-            // update margin with lowest value so far
-            if (!margin_updated || (margin_new < margin)) {
-                margin_updated = true;
-                margin = margin_new;
+                // margin is distance to the center minus the radius
+                const float margin_new = (dist_cm * 0.01f) - (radius + fence_margin);
+                margins[j] = MIN(margins[j], margin_new);
             }
         }
     }
-
-    return margin_updated;
-#else
-    return false;
 #endif // AP_FENCE_ENABLED
 }
 
-// calculate minimum distance between a path and proximity sensor obstacles
-// on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_object_database(const Location &start, const Location &end, float &margin) const
+// lower margins[i] to the minimum distance between each path from start to ends[i] and proximity sensor obstacles
+void AP_OABendyRuler::calc_margins_from_object_database(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins) const
 {
-    // exit immediately if db is empty
-    AP_OADatabase *oaDb = AP::oadatabase();
-    if (oaDb == nullptr || !oaDb->healthy()) {
-        return false;
+    // start and end must be offsets (in cm) from EKF origin
+    if (!start.NEU_ok) {
+        return;
     }
 
-    // convert start and end to offsets (in cm) from EKF origin
-    Vector3f start_NEU,end_NEU;
-    if (!start.get_vector_from_origin_NEU_cm(start_NEU) ||
-        !end.get_vector_from_origin_NEU_cm(end_NEU)) {
-        return false;
-    }
-    if (start_NEU == end_NEU) {
-        return false;
+    if (_obstacles_cached) {
+        calc_margins_from_obstacles(start.NEU_cm, ends, num_ends, _obstacles, _num_obstacles, margins);
+        return;
     }
 
-    // check each obstacle's distance from segment
-    float smallest_margin = FLT_MAX;
+    // snapshot could not be allocated so check each item in the database
+    const AP_OADatabase *oaDb = AP::oadatabase();
+    if (oaDb == nullptr || !oaDb->healthy()) {
+        return;
+    }
     for (uint16_t i=0; i<oaDb->database_count(); i++) {
         const AP_OADatabase::OA_DbItem& item = oaDb->get_item(i);
-        const Vector3f point_cm = item.pos * 100.0f;
-        // margin is distance between line segment and obstacle minus obstacle's radius
-        const float m = Vector3f::closest_distance_between_line_and_point(start_NEU, end_NEU, point_cm) * 0.01f - item.radius;
-        if (m < smallest_margin) {
-            smallest_margin = m;
-        }
+        const Obstacle obstacle {item.pos * 100.0f, item.radius};
+        calc_margins_from_obstacles(start.NEU_cm, ends, num_ends, &obstacle, 1, margins);
     }
+}
 
-    // return smallest margin
-    if (smallest_margin < FLT_MAX) {
-        margin = smallest_margin;
-        return true;
+// lower margins[i] to the minimum distance between the path from start to ends[i] and
+// any obstacle, less the obstacle's radius.  Zero length paths are ignored
+void AP_OABendyRuler::calc_margins_from_obstacles(const Vector3f &start_NEU, const PathPoint *ends, uint8_t num_ends, const Obstacle *obstacles, uint16_t num_obstacles, float *margins)
+{
+    // length of each path, used to skip obstacles which cannot be closer than the smallest margin found so far
+    float path_length[OA_BENDYRULER_CANDIDATES_MAX];
+    float path_length_max = 0;
+    num_ends = MIN(num_ends, OA_BENDYRULER_CANDIDATES_MAX);
+    for (uint8_t j = 0; j < num_ends; j++) {
+        path_length[j] = ends[j].NEU_ok ? (ends[j].NEU_cm - start_NEU).length() : 0;
+        path_length_max = MAX(path_length_max, path_length[j]);
+    }
+
+    // obstacles are only skipped if clearly further away than the smallest margin so
+    // rounding cannot change the result.  Rounding grows with distance from the origin
+    const float tolerance = 0.01f + 1.0e-7f * (fabsf(start_NEU.x) + fabsf(start_NEU.y) + fabsf(start_NEU.z) + path_length_max);
+
+    for (uint16_t i = 0; i < num_obstacles; i++) {
+        const Obstacle &obstacle = obstacles[i];
+        const float start_dist = (obstacle.pos_cm - start_NEU).length();
+        for (uint8_t j = 0; j < num_ends; j++) {
+            const PathPoint &end = ends[j];
+            if (!end.NEU_ok || (start_NEU == end.NEU_cm)) {
+                continue;
+            }
+            // no point along the path is closer to the obstacle than its distance from the start less the path's length
+            const float margin_min = (start_dist - path_length[j]) * 0.01f - obstacle.radius;
+            if (margin_min > margins[j] + tolerance) {
+                continue;
+            }
+            // margin is distance between line segment and obstacle minus obstacle's radius
+            const float m = Vector3f::closest_distance_between_line_and_point(start_NEU, end.NEU_cm, obstacle.pos_cm) * 0.01f - obstacle.radius;
+            if (m < margins[j]) {
+                margins[j] = m;
+            }
+        }
     }
-
-    return false;
 }
 
 #endif  // AP_OAPATHPLANNER_BENDYRULER_ENABLED
@@ -9,10 +9,14 @@
 #include <AP_Math/AP_Math.h>
 #include <AP_Logger/AP_Logger_config.h>
 
+#define OA_BENDYRULER_CANDIDATES_MAX    69      // maximum number of first step paths scored together
+
 /*
  * BendyRuler avoidance algorithm for avoiding the polygon and circular fence and dynamic objects detected by the proximity sensor
  */
 class AP_OABendyRuler {
+    friend class AP_OABendyRuler_Test;
+
 public:
     AP_OABendyRuler();
 
@@ -36,6 +40,28 @@ public:
 
 private:
 
+    // path end point, converted to an offset from the EKF origin once
+    // so it can be shared by all margin calculations
+    struct PathPoint {
+        Location loc;
+        Vector2f NE_cm;         // horizontal offset in cm from the EKF origin
+        Vector3f NEU_cm;        // offset in cm from the EKF origin
+        bool NE_ok;             // true if NE_cm is valid
+        bool NEU_ok;            // true if NEU_cm is valid
+
+        void set(const Location &_loc);
+    };
+
+    // object database item as used to calculate margins
+    struct Obstacle {
+        Vector3f pos_cm;        // position as an offset in cm from the EKF origin
+        float radius;           // radius in meters
+    };
+
+    // lower margins[i] to the minimum distance between the path from start to ends[i] and
+    // any obstacle, less the obstacle's radius.  Zero length paths are ignored
+    static void calc_margins_from_obstacles(const Vector3f &start_NEU, const PathPoint *ends, uint8_t num_ends, const Obstacle *obstacles, uint16_t num_obstacles, float *margins);
+
     // return type of BendyRuler in use
     OABendyType get_type() const;
 
@@ -45,31 +71,32 @@ private:
     // search for path in the Vertical directions
     bool search_vertical_path(const Location &current_loc, const Location &destination, Location &destination_new, float lookahead_step1_dist, float lookahead_step2_dist, float bearing_to_dest, float distance_to_dest, bool proximity_only);
 
+    // refresh the fence and object database snapshot used to calculate margins
+    void update_margin_cache();
+
     // calculate minimum distance between a path and any obstacle
     float calc_avoidance_margin(const Location &start, const Location &end, bool proximity_only) const;
 
+    // calculate minimum distance between each path from start to ends[i] and any obstacle
+    void calc_avoidance_margins(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins, bool proximity_only) const;
+
     // determine if BendyRuler should accept the new bearing or try and resist it. Returns true if bearing is not changed  
     bool resist_bearing_change(const Location &destination, const Location &current_loc, bool active, float bearing_test, float lookahead_step1_dist, float margin, Location &prev_dest, float &prev_bearing, float &final_bearing, float &final_margin, bool proximity_only) const;    
 
-    // calculate minimum distance between a path and the circular fence (centered on home)
-    // on success returns true and updates margin
-    bool calc_margin_from_circular_fence(const Location &start, const Location &end, float &margin) const;
+    // lower margins[i] to the minimum distance between each path from start to ends[i] and the circular fence (centered on home)
+    void calc_margins_from_circular_fence(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins) const;
 
-    // calculate minimum distance between a path and the altitude fence
-    // on success returns true and updates margin
-    bool calc_margin_from_alt_fence(const Location &start, const Location &end, float &margin) const;
+    // lower margins[i] to the minimum distance between each path from start to ends[i] and the altitude fence
+    void calc_margins_from_alt_fence(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins) const;
 
-    // calculate minimum distance between a path and all inclusion and exclusion polygons
-    // on success returns true and updates margin
-    bool calc_margin_from_inclusion_and_exclusion_polygons(const Location &start, const Location &end, float &margin) const;
+    // lower margins[i] to the minimum distance between each path from start to ends[i] and all inclusion and exclusion polygons
+    void calc_margins_from_inclusion_and_exclusion_polygons(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins) const;
 
-    // calculate minimum distance between a path and all inclusion and exclusion circles
-    // on success returns true and updates margin
-    bool calc_margin_from_inclusion_and_exclusion_circles(const Location &start, const Location &end, float &margin) const;
+    // lower margins[i] to the minimum distance between each path from start to ends[i] and all inclusion and exclusion circles
+    void calc_margins_from_inclusion_and_exclusion_circles(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins) const;
 
-    // calculate minimum distance between a path and proximity sensor obstacles
-    // on success returns true and updates margin
-    bool calc_margin_from_object_database(const Location &start, const Location &end, float &margin) const;
+    // lower margins[i] to the minimum distance between each path from start to ends[i] and proximity sensor obstacles
+    void calc_margins_from_object_database(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins) const;
 
     // Logging function
 #if HAL_LOGGING_ENABLED
@@ -91,6 +118,25 @@ private:
     float _current_lookahead;       // distance (in meters) ahead of the vehicle we are looking for obstacles
     float _bearing_prev;            // stored bearing in degrees 
     Location _destination_prev;     // previous destination, to check if there has been a change in destination
+
+    // first step paths being scored by search_xy_path
+    PathPoint _candidates[OA_BENDYRULER_CANDIDATES_MAX];
+    float _candidate_bearings[OA_BENDYRULER_CANDIDATES_MAX];
+    float _candidate_margins[OA_BENDYRULER_CANDIDATES_MAX];
+
+    // snapshot of the fence and object database taken at the start of each update
+    struct {
+        bool enabled;               // true if the fence exists
+        uint8_t enabled_fences;     // bitmask of enabled fences
+        float margin_ne_m;          // horizontal fence margin in meters
+        float radius_m;             // circular fence radius in meters
+        float safe_alt_max_m;       // altitude fence less its margin in meters
+        Location home;
+    } _fence_cache;
+    Obstacle *_obstacles;           // copy of the object database items
+    uint16_t _obstacles_max;        // number of items _obstacles can hold
+    uint16_t _num_obstacles;
+    bool _obstacles_cached;         // true if _obstacles holds the whole object database
 };
 
 #endif  // AP_OAPATHPLANNER_BENDYRULER_ENABLED
@@ -40,6 +40,9 @@ extern const AP_HAL::HAL& hal;
     #define AP_OADATABASE_DISTANCE_FROM_HOME 3
 #endif
 
+#define AP_OADATABASE_RADIUS_MAX_UPDATE_MS  1000    // largest proximity item radius is recalculated at this interval
+#define AP_OADATABASE_WHEEL_SLOT_MS_MIN     100     // expiry wheel slots cover at least this many milliseconds
+
 const AP_Param::GroupInfo AP_OADatabase::var_info[] = {
 
     // @Param: SIZE
@@ -135,6 +138,11 @@ void AP_OADatabase::init()
         GCS_SEND_TEXT(MAV_SEVERITY_INFO, "DB init failed . Sizes queue:%u, db:%u", (unsigned int)_queue.size, (unsigned int)_database.size);
         delete _queue.items;
         delete[] _database.items;
+        delete[] _hash.head;
+        delete[] _hash.next;
+        delete[] _wheel.next;
+        delete[] _wheel.prev;
+        delete[] _wheel.slot;
         return;
     }
 }
@@ -146,7 +154,7 @@ void AP_OADatabase::update()
     }
 
     process_queue();
-    database_items_remove_all_expired();
+    database_items_remove_all_expired(AP_HAL::millis());
 }
 
 // Push an object into the database. Pos is the offset in meters from the EKF origin, measurement timestamp in ms, distance in meters
@@ -222,6 +230,28 @@ void AP_OADatabase::init_database()
     }
 
     _database.items = NEW_NOTHROW OA_DbItem[_database.size];
+
+    // spatial hash with at least as many buckets as items
+    uint32_t num_buckets = 1;
+    while (num_buckets < _database.size) {
+        num_buckets <<= 1;
+    }
+    _hash.mask = num_buckets - 1;
+    _hash.head = NEW_NOTHROW uint16_t[num_buckets];
+    _hash.next = NEW_NOTHROW uint16_t[_database.size];
+    _wheel.next = NEW_NOTHROW uint16_t[_database.size];
+    _wheel.prev = NEW_NOTHROW uint16_t[_database.size];
+    _wheel.slot = NEW_NOTHROW uint8_t[_database.size];
+    if (_hash.head == nullptr || _hash.next == nullptr ||
+        _wheel.next == nullptr || _wheel.prev == nullptr || _wheel.slot == nullptr) {
+        // database is unusable without its indexes
+        delete[] _database.items;
+        _database.items = nullptr;
+        return;
+    }
+    memset(_hash.head, 0xFF, num_buckets * sizeof(uint16_t));
+    memset(_wheel.head, 0xFF, sizeof(_wheel.head));
+    _wheel.slot_ms = 1000;
 }
 
 // get bitmask of gcs channels item should be sent to based on its importance
@@ -303,21 +333,55 @@ bool AP_OADatabase::process_queue()
 
         item.send_to_gcs = get_send_to_gcs_flags(item.importance);
 
-        // compare item to all items in database. If found a similar item, update the existing, else add it as a new one
-        bool found = false;
+        // look for a similar item in the database. If found update the existing, else add it as a new one
+        uint16_t index;
+        if (database_item_find(item, index)) {
+            database_item_refresh(index, item);
+        } else {
+            database_item_add(item);
+        }
+    }
+    return (_queue.items->available() > 0);
+}
+
+// find the lowest index item in the database matching item.  returns false if there is none
+bool AP_OADatabase::database_item_find(const OA_DbItem &item, uint16_t &index) const
+{
+    index = AP_OADATABASE_INDEX_NONE;
+
+    // proximity items can only match items within the larger of their radii
+    int32_t x_lo = 0, x_hi = -1, y_lo = 0, y_hi = -1;
+    bool search_all = true;
+    if (item.source == OA_DbItem::Source::proximity) {
+        const float reach = MAX(item.radius, _hash.proximity_radius_max);
+        x_lo = cell_of(item.pos.x - reach);
+        x_hi = cell_of(item.pos.x + reach);
+        y_lo = cell_of(item.pos.y - reach);
+        y_hi = cell_of(item.pos.y + reach);
+        search_all = ((uint64_t)(x_hi - x_lo + 1) * (uint64_t)(y_hi - y_lo + 1) >= _database.count);
+    }
+
+    if (search_all) {
+        // AIS items are matched by ID which is not indexed but these are few and infrequent
         for (uint16_t i=0; i<_database.count; i++) {
             if (item_match(_database.items[i], item)) {
-                database_item_refresh(_database.items[i], item);
-                found = true;
-                break;
+                index = i;
+                return true;
             }
         }
+        return false;
+    }
 
-        if (!found) {
-            database_item_add(item);
+    for (int32_t cx = x_lo; cx <= x_hi; cx++) {
+        for (int32_t cy = y_lo; cy <= y_hi; cy++) {
+            for (uint16_t i = _hash.head[cell_hash(cx, cy) & _hash.mask]; i != AP_OADATABASE_INDEX_NONE; i = _hash.next[i]) {
+                if ((i < index) && item_match(_database.items[i], item)) {
+                    index = i;
+                }
+            }
         }
     }
-    return (_queue.items->available() > 0);
+    return (index != AP_OADATABASE_INDEX_NONE);
 }
 
 void AP_OADatabase::database_item_add(const OA_DbItem &item)
@@ -327,6 +391,8 @@ void AP_OADatabase::database_item_add(const OA_DbItem &item)
     }
     _database.items[_database.count] = item;
     _database.items[_database.count].send_to_gcs = get_send_to_gcs_flags(_database.items[_database.count].importance);
+    hash_link(_database.count);
+    wheel_link(_database.count);
     _database.count++;
 }
 
@@ -340,6 +406,8 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
     // radius of 0 tells the GCS we don't care about it any more (aka it expired)
     _database.items[index].radius = 0;
     _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+    hash_unlink(index);
+    wheel_unlink(index);
 
     _database.count--;
     if (_database.count == 0) {
@@ -350,11 +418,14 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
         // copy last object in array over expired object
         _database.items[index] = _database.items[_database.count];
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+        hash_move(_database.count, index);
+        wheel_move(_database.count, index);
     }
 }
 
-void AP_OADatabase::database_item_refresh(OA_DbItem &current_item, const OA_DbItem &new_item) const
+void AP_OADatabase::database_item_refresh(const uint16_t index, const OA_DbItem &new_item)
 {
+    OA_DbItem &current_item = _database.items[index];
     const bool is_different =
             (!is_equal(current_item.radius, new_item.radius)) ||
             (new_item.timestamp_ms - current_item.timestamp_ms >= 500);
@@ -362,36 +433,190 @@ void AP_OADatabase::database_item_refresh(OA_DbItem &current_item, const OA_DbIt
     if (is_different) {
         // update timestamp and radius on close object so it stays around longer
         // and trigger resending to GCS
+        wheel_unlink(index);
         current_item.timestamp_ms = new_item.timestamp_ms;
         current_item.radius = new_item.radius;
         current_item.send_to_gcs = get_send_to_gcs_flags(current_item.importance);
+        wheel_link(index);
 
         if (current_item.source == OA_DbItem::Source::AIS) {
             // Update position for AIS items, these tend to be large and update slowly
+            hash_unlink(index);
             current_item.pos = new_item.pos;
+            hash_link(index);
+        }
+
+        if ((current_item.source == OA_DbItem::Source::proximity) && (current_item.radius > _hash.proximity_radius_max)) {
+            _hash.proximity_radius_max = current_item.radius;
         }
     }
 }
 
-void AP_OADatabase::database_items_remove_all_expired()
+void AP_OADatabase::database_items_remove_all_expired(uint32_t now_ms)
 {
     // calculate age of all items in the _database
 
+    // largest radius only grows as items are added so is occasionally recalculated
+    hash_update_radius_max(now_ms);
+
     if (_database_expiry_seconds <= 0) {
         // zero means never expire. This is not normal behavior but perhaps you could send a static
         // environment once that you don't want to have to constantly update
         return;
     }
 
-    const uint32_t now_ms = AP_HAL::millis();
     const uint32_t expiry_ms = (uint32_t)_database_expiry_seconds * 1000;
-    uint16_t index = 0;
-    while (index < _database.count) {
-        if (now_ms - _database.items[index].timestamp_ms > expiry_ms) {
-            database_item_remove(index);
-        } else {
-            index++;
+    if (expiry_ms != _wheel.expiry_ms) {
+        wheel_rebuild(expiry_ms, now_ms);
+    }
+
+    // items with timestamps before cutoff_ms have expired.  These can only be in slots from
+    // the one holding check_from_ms to the one holding cutoff_ms
+    const uint32_t cutoff_ms = now_ms - expiry_ms;
+    uint32_t num_slots = 1;
+    if ((int32_t)(cutoff_ms - _wheel.check_from_ms) > 0) {
+        num_slots = MIN((cutoff_ms - _wheel.check_from_ms) / _wheel.slot_ms + 1, uint32_t(AP_OADATABASE_WHEEL_SLOTS));
+    }
+    uint32_t slot_start_ms = _wheel.check_from_ms;
+    for (uint32_t n = 0; n < num_slots; n++) {
+        uint16_t index = _wheel.head[wheel_slot(slot_start_ms)];
+        while (index != AP_OADATABASE_INDEX_NONE) {
+            uint16_t next = _wheel.next[index];
+            if (now_ms - _database.items[index].timestamp_ms > expiry_ms) {
+                const uint16_t last = _database.count - 1;
+                database_item_remove(index);
+                if (next == last) {
+                    // last item has been moved into the removed item's place
+                    next = index;
+                }
+            }
+            index = next;
+        }
+        slot_start_ms += _wheel.slot_ms;
+    }
+    _wheel.check_from_ms = cutoff_ms - (cutoff_ms % _wheel.slot_ms);
+}
+
+// add an item to the bucket for its position
+void AP_OADatabase::hash_link(uint16_t index)
+{
+    const OA_DbItem &item = _database.items[index];
+    const uint16_t bucket = hash_bucket(item);
+    _hash.next[index] = _hash.head[bucket];
+    _hash.head[bucket] = index;
+
+    if ((item.source == OA_DbItem::Source::proximity) && (item.radius > _hash.proximity_radius_max)) {
+        _hash.proximity_radius_max = item.radius;
+    }
+}
+
+// remove an item from the bucket for its position
+void AP_OADatabase::hash_unlink(uint16_t index)
+{
+    uint16_t *link = &_hash.head[hash_bucket(_database.items[index])];
+    while (*link != AP_OADATABASE_INDEX_NONE) {
+        if (*link == index) {
+            *link = _hash.next[index];
+            return;
+        }
+        link = &_hash.next[*link];
+    }
+}
+
+// an item has been copied from index "from" to index "to", update its bucket to match
+void AP_OADatabase::hash_move(uint16_t from, uint16_t to)
+{
+    uint16_t *link = &_hash.head[hash_bucket(_database.items[to])];
+    while (*link != AP_OADATABASE_INDEX_NONE) {
+        if (*link == from) {
+            *link = to;
+            _hash.next[to] = _hash.next[from];
+            return;
         }
+        link = &_hash.next[*link];
+    }
+}
+
+// recalculate the largest proximity item radius so it shrinks as large items expire
+void AP_OADatabase::hash_update_radius_max(uint32_t now_ms)
+{
+    if (now_ms - _hash.radius_max_update_ms < AP_OADATABASE_RADIUS_MAX_UPDATE_MS) {
+        return;
+    }
+    _hash.radius_max_update_ms = now_ms;
+
+    float proximity_radius_max = 0;
+    for (uint16_t i=0; i<_database.count; i++) {
+        const OA_DbItem &item = _database.items[i];
+        if (item.source == OA_DbItem::Source::proximity) {
+            proximity_radius_max = MAX(proximity_radius_max, item.radius);
+        }
+    }
+    _hash.proximity_radius_max = proximity_radius_max;
+}
+
+// add an item to the slot for its timestamp.  Items older than check_from_ms go in the
+// oldest slot which is checked next
+void AP_OADatabase::wheel_link(uint16_t index)
+{
+    uint32_t timestamp_ms = _database.items[index].timestamp_ms;
+    if ((int32_t)(timestamp_ms - _wheel.check_from_ms) < 0) {
+        timestamp_ms = _wheel.check_from_ms;
+    }
+    const uint8_t slot = wheel_slot(timestamp_ms);
+    _wheel.slot[index] = slot;
+    _wheel.prev[index] = AP_OADATABASE_INDEX_NONE;
+    _wheel.next[index] = _wheel.head[slot];
+    if (_wheel.head[slot] != AP_OADATABASE_INDEX_NONE) {
+        _wheel.prev[_wheel.head[slot]] = index;
+    }
+    _wheel.head[slot] = index;
+}
+
+// remove an item from its slot
+void AP_OADatabase::wheel_unlink(uint16_t index)
+{
+    const uint16_t prev = _wheel.prev[index];
+    const uint16_t next = _wheel.next[index];
+    if (prev != AP_OADATABASE_INDEX_NONE) {
+        _wheel.next[prev] = next;
+    } else {
+        _wheel.head[_wheel.slot[index]] = next;
+    }
+    if (next != AP_OADATABASE_INDEX_NONE) {
+        _wheel.prev[next] = prev;
+    }
+}
+
+// an item has been copied from index "from" to index "to", update its slot to match
+void AP_OADatabase::wheel_move(uint16_t from, uint16_t to)
+{
+    const uint16_t prev = _wheel.prev[from];
+    const uint16_t next = _wheel.next[from];
+    _wheel.slot[to] = _wheel.slot[from];
+    _wheel.prev[to] = prev;
+    _wheel.next[to] = next;
+    if (prev != AP_OADATABASE_INDEX_NONE) {
+        _wheel.next[prev] = to;
+    } else {
+        _wheel.head[_wheel.slot[to]] = to;
+    }
+    if (next != AP_OADATABASE_INDEX_NONE) {
+        _wheel.prev[next] = to;
+    }
+}
+
+// size the wheel's slots for a new expiry time and re-add all items
+void AP_OADatabase::wheel_rebuild(uint32_t expiry_ms, uint32_t now_ms)
+{
+    // wheel covers twice the expiry time
+    _wheel.expiry_ms = expiry_ms;
+    _wheel.slot_ms = MAX(expiry_ms / (AP_OADATABASE_WHEEL_SLOTS / 2), uint32_t(AP_OADATABASE_WHEEL_SLOT_MS_MIN));
+    const uint32_t cutoff_ms = now_ms - expiry_ms;
+    _wheel.check_from_ms = cutoff_ms - (cutoff_ms % _wheel.slot_ms);
+    memset(_wheel.head, 0xFF, sizeof(_wheel.head));
+    for (uint16_t i=0; i<_database.count; i++) {
+        wheel_link(i);
     }
 }
 
@@ -9,7 +9,16 @@
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <AP_Param/AP_Param.h>
 
+#ifndef AP_OADATABASE_GRID_CELL_SIZE
+    #define AP_OADATABASE_GRID_CELL_SIZE    4.0f    // size of each side of the spatial hash's grid cells in meters
+#endif
+
+#define AP_OADATABASE_WHEEL_SLOTS   16      // number of time slots in the expiry wheel
+#define AP_OADATABASE_INDEX_NONE    UINT16_MAX
+
 class AP_OADatabase {
+    friend class AP_OADatabase_Test;
+
 public:
 
     AP_OADatabase();
@@ -77,9 +86,28 @@ private:
 
     // database item management
     void database_item_add(const OA_DbItem &item);
-    void database_item_refresh(OA_DbItem &current_item, const OA_DbItem &new_item) const;
+    void database_item_refresh(const uint16_t index, const OA_DbItem &new_item);
     void database_item_remove(const uint16_t index);
-    void database_items_remove_all_expired();
+    void database_items_remove_all_expired(uint32_t now_ms);
+
+    // find the lowest index item in the database matching item.  returns false if there is none
+    bool database_item_find(const OA_DbItem &item, uint16_t &index) const;
+
+    // spatial hash of items by the grid cell holding their position
+    static int32_t cell_of(float pos_m) { return (int32_t)floorf(constrain_float(pos_m * (1.0f / AP_OADATABASE_GRID_CELL_SIZE), -1.0e6f, 1.0e6f)); }
+    static uint32_t cell_hash(int32_t cell_x, int32_t cell_y) { return ((uint32_t)cell_x * 73856093U) ^ ((uint32_t)cell_y * 19349663U); }
+    uint16_t hash_bucket(const OA_DbItem &item) const { return cell_hash(cell_of(item.pos.x), cell_of(item.pos.y)) & _hash.mask; }
+    void hash_link(uint16_t index);
+    void hash_unlink(uint16_t index);
+    void hash_move(uint16_t from, uint16_t to);
+    void hash_update_radius_max(uint32_t now_ms);
+
+    // expiry wheel of items by timestamp, so expiry only checks items old enough to have expired
+    uint8_t wheel_slot(uint32_t timestamp_ms) const { return (timestamp_ms / _wheel.slot_ms) % AP_OADATABASE_WHEEL_SLOTS; }
+    void wheel_link(uint16_t index);
+    void wheel_unlink(uint16_t index);
+    void wheel_move(uint16_t from, uint16_t to);
+    void wheel_rebuild(uint32_t expiry_ms, uint32_t now_ms);
 
     // get bitmask of gcs channels item should be sent to based on its importance
     // returns 0xFF (send to all channels) if should be sent or 0 if it should not be sent
@@ -119,6 +147,24 @@ private:
         uint16_t        size;                               // cached value of _database_size_param that sticks after initialized
     } _database;
 
+    struct {
+        uint16_t        *head;                              // first item in each bucket
+        uint16_t        *next;                              // next item in the same bucket, indexed by item
+        uint16_t        mask;                               // number of buckets - 1
+        float           proximity_radius_max;               // largest radius of any proximity item
+        uint32_t        radius_max_update_ms;               // system time proximity_radius_max was last recalculated
+    } _hash;
+
+    struct {
+        uint16_t        head[AP_OADATABASE_WHEEL_SLOTS];    // first item in each slot
+        uint16_t        *next;                              // next item in the same slot, indexed by item
+        uint16_t        *prev;                              // previous item in the same slot, indexed by item
+        uint8_t         *slot;                              // slot holding each item
+        uint32_t        slot_ms;                            // time covered by each slot
+        uint32_t        check_from_ms;                      // start of the oldest slot which may hold unexpired items
+        uint32_t        expiry_ms;                          // expiry time the wheel was built for
+    } _wheel;
+
     uint16_t _next_index_to_send[MAVLINK_COMM_NUM_BUFFERS]; // index of next object in _database to send to GCS
     uint16_t _highest_index_sent[MAVLINK_COMM_NUM_BUFFERS]; // highest index in _database sent to GCS
     uint32_t _last_send_to_gcs_ms[MAVLINK_COMM_NUM_BUFFERS];// system time that send_adsb_vehicle was last called
@@ -31,13 +31,47 @@
 #define OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK  32      // expanding arrays for fence points and paths to destination will grow in increments of 20 elements
 #define OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX        255     // index use to indicate we do not have a tentative short path for a node
 #define OA_DIJKSTRA_ERROR_REPORTING_INTERVAL_MS         5000    // failure messages sent to GCS every 5 seconds
+#define OA_DIJKSTRA_FENCE_ITEMS_PER_CHUNK               8       // expanding arrays for fence items will grow in increments of 8 elements
+
+// FNV-1a hash of an array of floats, used to detect fences which are unchanged after a reload
+static uint32_t hash_floats(uint32_t hash, const float *values, uint16_t num_values)
+{
+    const uint8_t *b = (const uint8_t *)values;
+    for (uint32_t i = 0; i < num_values * sizeof(float); i++) {
+        hash ^= b[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+// signature of a fence's definition and margin
+static uint32_t fence_signature(const Vector2f *points, uint16_t num_points, float margin_cm)
+{
+    const uint32_t hash = hash_floats(2166136261U, &margin_cm, 1);
+    return hash_floats(hash, (const float *)points, num_points * 2);
+}
+
+// bounding box of a fence's points
+static void fence_bounding_box(const Vector2f *points, uint16_t num_points, Vector2f &bb_min, Vector2f &bb_max)
+{
+    bb_min = bb_max = (num_points > 0) ? points[0] : Vector2f();
+    for (uint16_t i = 1; i < num_points; i++) {
+        bb_min.x = MIN(bb_min.x, points[i].x);
+        bb_min.y = MIN(bb_min.y, points[i].y);
+        bb_max.x = MAX(bb_max.x, points[i].x);
+        bb_max.y = MAX(bb_max.y, points[i].y);
+    }
+}
 
 /// Constructor
 AP_OADijkstra::AP_OADijkstra(AP_Int16 &options) :
+        _fence_items(OA_DIJKSTRA_FENCE_ITEMS_PER_CHUNK),
+        _visgraph_fence_items(OA_DIJKSTRA_FENCE_ITEMS_PER_CHUNK),
         _inclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_circle_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _short_path_data(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _open_set(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _path(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _options(options)
 {
@@ -335,6 +369,7 @@ bool AP_OADijkstra::create_inclusion_polygon_with_margin(float margin_cm, AP_OAD
 
     // clear all points
     _inclusion_polygon_numpoints = 0;
+    clear_fence_items(FenceItemType::INCLUSION_POLYGON);
 
     // return immediately if no polygons
     const uint8_t num_inclusion_polygons = fence->polyfence().get_inclusion_polygon_count();
@@ -344,6 +379,12 @@ bool AP_OADijkstra::create_inclusion_polygon_with_margin(float margin_cm, AP_OAD
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
 
+        // test points against the polygon's index if it has one
+        const AP_PolygonIndex<float>* poly_index = fence->polyfence().get_inclusion_polygon_index(i);
+        auto outside_polygon = [&](const Vector2f &point) {
+            return (poly_index != nullptr) ? poly_index->outside(point) : Polygon_outside(point, boundary, num_points);
+        };
+
         // for each point in inclusion polygon
         // Note: boundary is "unclosed" meaning the last point is *not* the same as the first
         uint16_t new_points = 0;
@@ -372,10 +413,10 @@ bool AP_OADijkstra::create_inclusion_polygon_with_margin(float margin_cm, AP_OAD
 
             // find final point which is outside the inside polygon
             Vector2f temp_point = boundary[j] + intermediate_pt;
-            if (Polygon_outside(temp_point, boundary, num_points)) {
+            if (outside_polygon(temp_point)) {
                 intermediate_pt *= -1.0;
                 temp_point = boundary[j] + intermediate_pt;
-                if (Polygon_outside(temp_point, boundary, num_points)) {
+                if (outside_polygon(temp_point)) {
                     // could not find a point on either side that was outside the exclusion polygon so fail
                     // this may happen if the exclusion polygon has overlapping lines
                     err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OVERLAPPING_POLYGON_LINES;
@@ -398,6 +439,14 @@ bool AP_OADijkstra::create_inclusion_polygon_with_margin(float margin_cm, AP_OAD
             new_points++;
         }
 
+        // record which points were created from this polygon
+        Vector2f bb_min, bb_max;
+        fence_bounding_box(boundary, num_points, bb_min, bb_max);
+        if (!add_fence_item(FenceItemType::INCLUSION_POLYGON, fence_signature(boundary, num_points, margin_cm), bb_min, bb_max, _inclusion_polygon_numpoints, new_points)) {
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
+
         // update total number of points
         _inclusion_polygon_numpoints += new_points;
     }
@@ -436,6 +485,7 @@ bool AP_OADijkstra::create_exclusion_polygon_with_margin(float margin_cm, AP_OAD
 
     // clear all points
     _exclusion_polygon_numpoints = 0;
+    clear_fence_items(FenceItemType::EXCLUSION_POLYGON);
 
     // return immediately if no exclusion polygons
     const uint8_t num_exclusion_polygons = fence->polyfence().get_exclusion_polygon_count();
@@ -444,6 +494,12 @@ bool AP_OADijkstra::create_exclusion_polygon_with_margin(float margin_cm, AP_OAD
     for (uint8_t i = 0; i < num_exclusion_polygons; i++) {
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
+
+        // test points against the polygon's index if it has one
+        const AP_PolygonIndex<float>* poly_index = fence->polyfence().get_exclusion_polygon_index(i);
+        auto outside_polygon = [&](const Vector2f &point) {
+            return (poly_index != nullptr) ? poly_index->outside(point) : Polygon_outside(point, boundary, num_points);
+        };
    
         // for each point in exclusion polygon
         // Note: boundary is "unclosed" meaning the last point is *not* the same as the first
@@ -473,10 +529,10 @@ bool AP_OADijkstra::create_exclusion_polygon_with_margin(float margin_cm, AP_OAD
 
             // find final point which is outside the original polygon
             Vector2f temp_point = boundary[j] + intermediate_pt;
-            if (!Polygon_outside(temp_point, boundary, num_points)) {
+            if (!outside_polygon(temp_point)) {
                 intermediate_pt *= -1;
                 temp_point = boundary[j] + intermediate_pt;
-                if (!Polygon_outside(temp_point, boundary, num_points)) {
+                if (!outside_polygon(temp_point)) {
                     // could not find a point on either side that was outside the exclusion polygon so fail
                     // this may happen if the exclusion polygon has overlapping lines
                     err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OVERLAPPING_POLYGON_LINES;
@@ -499,6 +555,14 @@ bool AP_OADijkstra::create_exclusion_polygon_with_margin(float margin_cm, AP_OAD
             new_points++;
         }
 
+        // record which points were created from this polygon
+        Vector2f bb_min, bb_max;
+        fence_bounding_box(boundary, num_points, bb_min, bb_max);
+        if (!add_fence_item(FenceItemType::EXCLUSION_POLYGON, fence_signature(boundary, num_points, margin_cm), bb_min, bb_max, _exclusion_polygon_numpoints, new_points)) {
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
+
         // update total number of points
         _exclusion_polygon_numpoints += new_points;
     }
@@ -530,6 +594,7 @@ bool AP_OADijkstra::create_exclusion_circle_with_margin(float margin_cm, AP_OADi
 
     // clear all points
     _exclusion_circle_numpoints = 0;
+    clear_fence_items(FenceItemType::EXCLUSION_CIRCLE);
 
     // unit length offsets for polygon points around circles
     const Vector2f unit_offsets[] = {
@@ -557,6 +622,15 @@ bool AP_OADijkstra::create_exclusion_circle_with_margin(float margin_cm, AP_OADi
             // scaler to ensure lines between points do not intersect circle
             const float scaler = (1.0f / cosf(radians(180.0f / (float)num_points_per_circle))) * ((radius * 100.0f) + margin_cm);
 
+            // record which points will be created from this circle
+            const Vector2f circle_def[] {circle_pos_cm, Vector2f{radius, 0}};
+            const Vector2f radius_cm_vec{radius * 100.0f, radius * 100.0f};
+            if (!add_fence_item(FenceItemType::EXCLUSION_CIRCLE, fence_signature(circle_def, ARRAY_SIZE(circle_def), margin_cm),
+                                circle_pos_cm - radius_cm_vec, circle_pos_cm + radius_cm_vec, _exclusion_circle_numpoints, num_points_per_circle)) {
+                err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+                return false;
+            }
+
             // add points to array
             for (uint8_t j = 0; j < num_points_per_circle; j++) {
                 _exclusion_circle_pts[_exclusion_circle_numpoints] = circle_pos_cm + (unit_offsets[j] * scaler);
@@ -577,6 +651,49 @@ uint16_t AP_OADijkstra::total_numpoints() const
     return _inclusion_polygon_numpoints + _exclusion_polygon_numpoints + _exclusion_circle_numpoints;
 }
 
+// remove all fence items of the given type
+void AP_OADijkstra::clear_fence_items(FenceItemType type)
+{
+    uint16_t num_kept = 0;
+    for (uint16_t i = 0; i < _fence_items_num; i++) {
+        if (_fence_items[i].type != type) {
+            _fence_items[num_kept++] = _fence_items[i];
+        }
+    }
+    _fence_items_num = num_kept;
+}
+
+// record a fence item, returns false if out of memory
+bool AP_OADijkstra::add_fence_item(FenceItemType type, uint32_t signature, const Vector2f &bb_min, const Vector2f &bb_max, uint16_t first_point, uint16_t num_points)
+{
+    if (!_fence_items.expand_to_hold(_fence_items_num + 1)) {
+        return false;
+    }
+    _fence_items[_fence_items_num++] = {signature, bb_min, bb_max, first_point, num_points, type, false};
+    return true;
+}
+
+// returns the index of an item's first point across all fence types
+uint16_t AP_OADijkstra::fence_item_first_point(const FenceItem &item) const
+{
+    switch (item.type) {
+    case FenceItemType::INCLUSION_POLYGON:
+        return item.first_point;
+    case FenceItemType::EXCLUSION_POLYGON:
+        return _inclusion_polygon_numpoints + item.first_point;
+    case FenceItemType::EXCLUSION_CIRCLE:
+        return _inclusion_polygon_numpoints + _exclusion_polygon_numpoints + item.first_point;
+    }
+    return 0;
+}
+
+// returns true if the line segment's bounding box overlaps the item's bounding box
+bool AP_OADijkstra::segment_near_fence_item(const Vector2f &seg_start, const Vector2f &seg_end, const FenceItem &item)
+{
+    return (MAX(seg_start.x, seg_end.x) >= item.bb_min.x) && (MIN(seg_start.x, seg_end.x) <= item.bb_max.x) &&
+           (MAX(seg_start.y, seg_end.y) >= item.bb_min.y) && (MIN(seg_start.y, seg_end.y) <= item.bb_max.y);
+}
+
 // get a single point across the total list of points from all fence types
 bool AP_OADijkstra::get_point(uint16_t index, Vector2f &point) const
 {
@@ -622,8 +739,13 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
     uint16_t num_points = 0;
     for (uint8_t i = 0; i < fence->polyfence().get_inclusion_polygon_count(); i++) {
         const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
-        if (boundary != nullptr) {
-            Vector2f intersection;
+        const AP_PolygonIndex<float>* poly_index = fence->polyfence().get_inclusion_polygon_index(i);
+        Vector2f intersection;
+        if (poly_index != nullptr) {
+            if (poly_index->intersects(seg_start, seg_end, intersection)) {
+                return true;
+            }
+        } else if (boundary != nullptr) {
             if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
                 return true;
             }
@@ -633,8 +755,13 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
     // determine if segment crosses any of the exclusion polygons
     for (uint8_t i = 0; i < fence->polyfence().get_exclusion_polygon_count(); i++) {
         const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
-        if (boundary != nullptr) {
-            Vector2f intersection;
+        const AP_PolygonIndex<float>* poly_index = fence->polyfence().get_exclusion_polygon_index(i);
+        Vector2f intersection;
+        if (poly_index != nullptr) {
+            if (poly_index->intersects(seg_start, seg_end, intersection)) {
+                return true;
+            }
+        } else if (boundary != nullptr) {
             if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
                 return true;
             }
@@ -688,28 +815,135 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
         return false;
     }
 
+    // the graph will be modified so cannot be reused if we fail part way through
+    const bool prev_graph_ok = _visgraph_fence_items_ok;
+    _visgraph_fence_items_ok = false;
+
     // fail if more fence points than algorithm can handle
-    if (total_numpoints() >= OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
+    const uint16_t num_points = total_numpoints();
+    if (num_points >= OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_TOO_MANY_FENCE_POINTS;
         return false;
     }
 
-    // clear fence points visibility graph
-    _fence_visgraph.clear();
+    // inclusion circles do not create points but may block any line so the graph is rebuilt if they change
+    uint32_t inclusion_circle_signature = 2166136261U;
+    for (uint8_t i = 0; i < fence->polyfence().get_inclusion_circle_count(); i++) {
+        Vector2f center_pos_cm;
+        float radius;
+        if (fence->polyfence().get_inclusion_circle(i, center_pos_cm, radius)) {
+            const float circle_def[] {center_pos_cm.x, center_pos_cm.y, radius};
+            inclusion_circle_signature = hash_floats(inclusion_circle_signature, circle_def, ARRAY_SIZE(circle_def));
+        }
+    }
+
+    // match fences to those used when the graph was last created.  Points created from an unchanged fence
+    // are identical so lines between them only need to be checked against fences which have been added or removed
+    uint8_t prev_to_new_id[OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX];   // previous point id to current point id
+    bool point_kept[OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX] {};        // true if current point id was in the previous graph
+    memset(prev_to_new_id, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, sizeof(prev_to_new_id));
+    uint16_t num_kept = 0;
+    for (uint16_t n = 0; n < _fence_items_num; n++) {
+        _fence_items[n].matched = false;
+    }
+    for (uint16_t p = 0; p < _visgraph_fence_items_num; p++) {
+        _visgraph_fence_items[p].matched = false;
+    }
+    bool incremental = prev_graph_ok && (inclusion_circle_signature == _visgraph_inclusion_circle_signature);
+    for (uint16_t n = 0; incremental && (n < _fence_items_num); n++) {
+        FenceItem &item = _fence_items[n];
+        for (uint16_t p = 0; p < _visgraph_fence_items_num; p++) {
+            FenceItem &prev_item = _visgraph_fence_items[p];
+            if (prev_item.matched || (prev_item.type != item.type) ||
+                (prev_item.signature != item.signature) || (prev_item.num_points != item.num_points)) {
+                continue;
+            }
+            prev_item.matched = item.matched = true;
+            const uint16_t first_point = fence_item_first_point(item);
+            for (uint16_t k = 0; k < item.num_points; k++) {
+                prev_to_new_id[prev_item.first_point + k] = first_point + k;
+                point_kept[first_point + k] = true;
+            }
+            num_kept += item.num_points;
+            break;
+        }
+    }
+
+    // lines between kept points which were in the previous graph, stored as a triangular bit array
+    uint8_t *kept_lines = nullptr;
+    if (incremental && (num_kept > 1)) {
+        kept_lines = NEW_NOTHROW uint8_t[(num_points * (num_points - 1) / 2 + 7) / 8] {};
+    }
+    incremental = (kept_lines != nullptr);
+
+    // returns true if the segment is near an added (when added is true) or removed fence
+    auto near_changed_fence = [&](const Vector2f &seg_start, const Vector2f &seg_end, bool added) {
+        const AP_ExpandingArray<FenceItem> &items = added ? _fence_items : _visgraph_fence_items;
+        const uint16_t items_num = added ? _fence_items_num : _visgraph_fence_items_num;
+        for (uint16_t k = 0; k < items_num; k++) {
+            if (!items[k].matched && segment_near_fence_item(seg_start, seg_end, items[k])) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    if (incremental) {
+        // keep lines between kept points unless an added fence now blocks them
+        uint16_t num_items = 0;
+        for (uint16_t i = 0; i < _fence_visgraph.num_items(); i++) {
+            AP_OAVisGraph::VisGraphItem item = _fence_visgraph[i];
+            const uint8_t id1 = prev_to_new_id[item.id1.id_num];
+            const uint8_t id2 = prev_to_new_id[item.id2.id_num];
+            if ((id1 == OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) || (id2 == OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX)) {
+                continue;
+            }
+            Vector2f start_seg, end_seg;
+            if (!get_point(id1, start_seg) || !get_point(id2, end_seg)) {
+                continue;
+            }
+            if (near_changed_fence(start_seg, end_seg, true) && intersects_fence(start_seg, end_seg)) {
+                continue;
+            }
+            item.id1.id_num = id1;
+            item.id2.id_num = id2;
+            _fence_visgraph.set_item(num_items++, item);
+            const uint16_t lo = MIN(id1, id2);
+            const uint16_t hi = MAX(id1, id2);
+            const uint16_t bit = hi * (hi - 1) / 2 + lo;
+            kept_lines[bit / 8] |= 1U << (bit % 8);
+        }
+        _fence_visgraph.truncate(num_items);
+    } else {
+        // clear fence points visibility graph
+        _fence_visgraph.clear();
+    }
 
     // calculate distance from each point to all other points
-    for (uint8_t i = 0; i < total_numpoints() - 1; i++) {
+    for (uint16_t i = 0; i + 1 < num_points; i++) {
         Vector2f start_seg;
         if (get_point(i, start_seg)) {
-            for (uint8_t j = i + 1; j < total_numpoints(); j++) {
+            for (uint16_t j = i + 1; j < num_points; j++) {
                 Vector2f end_seg;
                 if (get_point(j, end_seg)) {
+                    if (incremental && point_kept[i] && point_kept[j]) {
+                        // skip lines already in the graph
+                        const uint16_t bit = j * (j - 1) / 2 + i;
+                        if ((kept_lines[bit / 8] & (1U << (bit % 8))) != 0) {
+                            continue;
+                        }
+                        // lines which were blocked are still blocked unless a removed fence was in the way
+                        if (!near_changed_fence(start_seg, end_seg, false)) {
+                            continue;
+                        }
+                    }
                     // if line segment does not intersect with any inclusion or exclusion zones add to visgraph
                     if (!intersects_fence(start_seg, end_seg)) {
-                        if (!_fence_visgraph.add_item({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i},
-                                                      {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, j},
+                        if (!_fence_visgraph.add_item({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)i},
+                                                      {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)j},
                                                       (start_seg - end_seg).length())) {
                             // failure to add a point can only be caused by out-of-memory
+                            delete[] kept_lines;
                             err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
                             return false;
                         }
@@ -718,6 +952,22 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
             }
         }
     }
+    delete[] kept_lines;
+
+    // index the graph by point so the shortest path search can quickly find each point's neighbours
+    // if this fails the search falls back to checking every item
+    _fence_visgraph.build_index(num_points);
+
+    // record the fences used to create this graph so the next update can reuse it
+    if (_visgraph_fence_items.expand_to_hold(_fence_items_num)) {
+        for (uint16_t n = 0; n < _fence_items_num; n++) {
+            _visgraph_fence_items[n] = _fence_items[n];
+            _visgraph_fence_items[n].first_point = fence_item_first_point(_fence_items[n]);
+        }
+        _visgraph_fence_items_num = _fence_items_num;
+        _visgraph_inclusion_circle_signature = inclusion_circle_signature;
+        _visgraph_fence_items_ok = true;
+    }
 
     return true;
 }
@@ -778,6 +1028,21 @@ void AP_OADijkstra::update_visible_node_distances(node_index curr_node_idx)
             continue;
         }
 
+        // use the graph's index to find items visible from current node
+        if (curr_visgraph.index_ok() && (curr_node.id.id_type == AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT)) {
+            const uint16_t *item_idx;
+            const uint16_t num_items = curr_visgraph.items_for(curr_node.id.id_num, item_idx);
+            for (uint16_t i = 0; i < num_items; i++) {
+                const AP_OAVisGraph::VisGraphItem &item = curr_visgraph[item_idx[i]];
+                const AP_OAVisGraph::OAItemID &matching_id = (curr_node.id == item.id1) ? item.id2 : item.id1;
+                node_index item_node_idx;
+                if (find_node_from_id(matching_id, item_node_idx)) {
+                    update_node_distance(curr_node_idx, item_node_idx, item.distance_cm);
+                }
+            }
+            continue;
+        }
+
         // search visibility graph for items visible from current_node
         for (uint16_t i = 0; i < curr_visgraph.num_items(); i++) {
             const AP_OAVisGraph::VisGraphItem &item = curr_visgraph[i];
@@ -787,19 +1052,32 @@ void AP_OADijkstra::update_visible_node_distances(node_index curr_node_idx)
                 // find item's id in node array
                 node_index item_node_idx;
                 if (find_node_from_id(matching_id, item_node_idx)) {
-                    // if current node's distance + distance to item is less than item's current distance, update item's distance
-                    const float dist_to_item_via_current_node = _short_path_data[curr_node_idx].distance_cm + item.distance_cm;
-                    if (dist_to_item_via_current_node < _short_path_data[item_node_idx].distance_cm) {
-                        // update item's distance and set "distance_from_idx" to current node's index
-                        _short_path_data[item_node_idx].distance_cm = dist_to_item_via_current_node;
-                        _short_path_data[item_node_idx].distance_from_idx = curr_node_idx;
-                    }
+                    update_node_distance(curr_node_idx, item_node_idx, item.distance_cm);
                 }
             }
         }
     }
 }
 
+// update distance to node_idx via curr_node_idx
+void AP_OADijkstra::update_node_distance(node_index curr_node_idx, node_index node_idx, float distance_cm)
+{
+    // the shortest distance to visited nodes is already known
+    ShortPathNode &node = _short_path_data[node_idx];
+    if (node.visited) {
+        return;
+    }
+
+    // if current node's distance + distance to item is less than item's current distance, update item's distance
+    const float dist_to_item_via_current_node = _short_path_data[curr_node_idx].distance_cm + distance_cm;
+    if (dist_to_item_via_current_node < node.distance_cm) {
+        // update item's distance and set "distance_from_idx" to current node's index
+        node.distance_cm = dist_to_item_via_current_node;
+        node.distance_from_idx = curr_node_idx;
+        open_set_update(node_idx);
+    }
+}
+
 // find a node's index into _short_path_data array from it's id (i.e. id type and id number)
 // returns true if successful and node_idx is updated
 bool AP_OADijkstra::find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const
@@ -832,45 +1110,87 @@ bool AP_OADijkstra::find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_in
     return false;
 }
 
-// find index of node with lowest tentative distance (ignore visited nodes)
-// returns true if successful and node_idx argument is updated
-bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx) const
+// returns the distance from source plus heuristic of the node at position pos in the open set
+float AP_OADijkstra::open_set_cost(uint16_t pos) const
 {
-    node_index lowest_idx = 0;
-    float lowest_dist = FLT_MAX;
+    const ShortPathNode &node = _short_path_data[_open_set[pos]];
+    return node.distance_cm + node.heuristic_cm;
+}
 
-    // scan through all nodes looking for closest
-    for (node_index i=0; i<_short_path_data_numpoints; i++) {
-        const ShortPathNode &node = _short_path_data[i];
-        if (node.visited || is_equal(_short_path_data[i].distance_cm, FLT_MAX)) {
-            // if node is already visited OR cannot be reached yet, we can't use it
-            continue;
+// move the node at position pos towards the front of the open set until the heap is ordered
+void AP_OADijkstra::open_set_sift_up(uint16_t pos)
+{
+    const node_index node_idx = _open_set[pos];
+    const float cost = open_set_cost(pos);
+    while (pos > 0) {
+        const uint16_t parent = (pos - 1) / 2;
+        if (open_set_cost(parent) <= cost) {
+            break;
         }
-        // figure out the pos of this node
-        Vector2f node_pos;
-        float dist_with_heuristics = FLT_MAX;
-        if (convert_node_to_point(node.id, node_pos)) {
-            // heuristics is is simple Euclidean distance from the node to the destination
-            // This should be admissible, therefore optimal path is guaranteed
-            const float heuristics = (node_pos-_path_destination).length();
-            dist_with_heuristics = node.distance_cm + heuristics;
-        } else {
-            // shouldn't happen
-            return false;
+        _open_set[pos] = _open_set[parent];
+        _short_path_data[_open_set[pos]].open_set_pos = pos;
+        pos = parent;
+    }
+    _open_set[pos] = node_idx;
+    _short_path_data[node_idx].open_set_pos = pos;
+}
+
+// move the node at position pos towards the back of the open set until the heap is ordered
+void AP_OADijkstra::open_set_sift_down(uint16_t pos)
+{
+    const node_index node_idx = _open_set[pos];
+    const float cost = open_set_cost(pos);
+    while (true) {
+        uint16_t child = 2 * pos + 1;
+        if (child >= _open_set_num) {
+            break;
         }
-        if (dist_with_heuristics < lowest_dist) {
-            // for NOW, this is the closest node
-            lowest_idx = i;
-            lowest_dist = dist_with_heuristics;
+        if ((child + 1 < _open_set_num) && (open_set_cost(child + 1) < open_set_cost(child))) {
+            child++;
         }
+        if (cost <= open_set_cost(child)) {
+            break;
+        }
+        _open_set[pos] = _open_set[child];
+        _short_path_data[_open_set[pos]].open_set_pos = pos;
+        pos = child;
     }
+    _open_set[pos] = node_idx;
+    _short_path_data[node_idx].open_set_pos = pos;
+}
 
-    if (lowest_dist < FLT_MAX) {
-        // found the closest node
-        node_idx = lowest_idx;
-        return true;
+// add node to the open set or, if already present, move it forward after its distance has reduced
+void AP_OADijkstra::open_set_update(node_index node_idx)
+{
+    uint16_t pos = _short_path_data[node_idx].open_set_pos;
+    if (pos == UINT16_MAX) {
+        // open set was expanded to hold all nodes in calc_shortest_path
+        pos = _open_set_num++;
+        _open_set[pos] = node_idx;
+        _short_path_data[node_idx].open_set_pos = pos;
     }
-    return false;
+    open_set_sift_up(pos);
+}
+
+// remove node with lowest distance from source plus heuristic from the open set
+// heuristic is simple Euclidean distance from the node to the destination.  This is
+// admissible and consistent so the optimal path is guaranteed and a node's distance
+// is final once it is removed from the open set
+// returns true if successful and node_idx argument is updated
+bool AP_OADijkstra::open_set_pop(node_index &node_idx)
+{
+    if (_open_set_num == 0) {
+        return false;
+    }
+    node_idx = _open_set[0];
+    _short_path_data[node_idx].open_set_pos = UINT16_MAX;
+    _open_set_num--;
+    if (_open_set_num > 0) {
+        _open_set[0] = _open_set[_open_set_num];
+        _short_path_data[_open_set[0]].open_set_pos = 0;
+        open_set_sift_down(0);
+    }
+    return true;
 }
 
 // calculate shortest path from origin to destination
@@ -880,12 +1200,23 @@ bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx) const
 bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &destination, AP_OADijkstra_Error &err_id)
 {
     // convert origin and destination to offsets from EKF origin
-    if (!origin.get_vector_xy_from_origin_NE_cm(_path_source) ||
-        !destination.get_vector_xy_from_origin_NE_cm(_path_destination)) {
+    Vector2f origin_cm, destination_cm;
+    if (!origin.get_vector_xy_from_origin_NE_cm(origin_cm) ||
+        !destination.get_vector_xy_from_origin_NE_cm(destination_cm)) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_NO_POSITION_ESTIMATE;
         return false;
     }
 
+    return calc_shortest_path(origin_cm, destination_cm, err_id);
+}
+
+// calculate shortest path from origin to destination, both offsets (in cm) from the EKF origin
+// returns true on success.  returns false on failure and err_id is updated
+bool AP_OADijkstra::calc_shortest_path(const Vector2f &origin_cm, const Vector2f &destination_cm, AP_OADijkstra_Error &err_id)
+{
+    _path_source = origin_cm;
+    _path_destination = destination_cm;
+
     // create visgraphs of origin and destination to fence points
     if (!update_visgraph(_source_visgraph, {AP_OAVisGraph::OATYPE_SOURCE, 0}, _path_source, true, _path_destination)) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
@@ -896,21 +1227,33 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
         return false;
     }
 
-    // expand _short_path_data if necessary
-    if (!_short_path_data.expand_to_hold(2 + total_numpoints())) {
+    // index destination visgraph so the nodes visible from the destination can be found quickly
+    // if this fails update_visible_node_distances falls back to searching the graph
+    _destination_visgraph.build_index(total_numpoints());
+
+    // expand _short_path_data and open set if necessary
+    if (!_short_path_data.expand_to_hold(2 + total_numpoints()) ||
+        !_open_set.expand_to_hold(2 + total_numpoints())) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
         return false;
     }
 
-    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm) to short_path_data array
-    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0};
-    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm, heuristic_cm, open_set_pos) to short_path_data array
+    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0, (_path_source - _path_destination).length(), UINT16_MAX};
+    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, 0, UINT16_MAX};
     _short_path_data_numpoints = 2;
 
-    // add all inclusion and exclusion fence points to short_path_data array (node_type, id, visited, distance_from_idx, distance_cm)
+    // add all inclusion and exclusion fence points to short_path_data array
     for (uint8_t i=0; i<total_numpoints(); i++) {
-        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+        Vector2f node_pos;
+        if (!get_point(i, node_pos)) {
+            // shouldn't happen
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
+            return false;
+        }
+        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, (node_pos - _path_destination).length(), UINT16_MAX};
     }
+    _open_set_num = 0;
 
     // start algorithm from source point
     node_index current_node_idx = 0;
@@ -919,8 +1262,7 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
     for (uint16_t i = 0; i < _source_visgraph.num_items(); i++) {
         node_index node_idx;
         if (find_node_from_id(_source_visgraph[i].id2, node_idx)) {
-            _short_path_data[node_idx].distance_cm = _source_visgraph[i].distance_cm;
-            _short_path_data[node_idx].distance_from_idx = current_node_idx;
+            update_node_distance(current_node_idx, node_idx, _source_visgraph[i].distance_cm);
         } else {
             err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
             return false;
@@ -929,19 +1271,19 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
     // mark source node as visited
     _short_path_data[current_node_idx].visited = true;
 
-    // move current_node_idx to node with lowest distance
-    while (find_closest_node_idx(current_node_idx)) {
+    // move current_node_idx to the most promising node in the open set
+    while (open_set_pop(current_node_idx)) {
         node_index dest_node;
         // See if this next "closest" node is actually the destination
         if (find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION,0}, dest_node) && current_node_idx == dest_node) {
             // We have discovered destination.. Don't bother with the rest of the graph
             break;
         }
-        // update distances to all neighbours of current node
-        update_visible_node_distances(current_node_idx);
-
         // mark current node as visited
         _short_path_data[current_node_idx].visited = true;
+
+        // update distances to all neighbours of current node
+        update_visible_node_distances(current_node_idx);
     }
 
     // extract path starting from destination
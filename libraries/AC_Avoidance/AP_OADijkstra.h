@@ -15,6 +15,8 @@
  */
 
 class AP_OADijkstra {
+    friend class AP_OADijkstra_Test;
+
 public:
 
     AP_OADijkstra(AP_Int16 &options);
@@ -120,15 +122,59 @@ private:
     bool intersects_fence(const Vector2f &seg_start, const Vector2f &seg_end) const;
 
     // create visibility graph for all fence (with margin) points
+    // only the parts of the graph affected by fences which have been added or removed
+    // since the last successful call are recalculated
     // returns true on success.  returns false on failure and err_id is updated
     bool create_fence_visgraph(AP_OADijkstra_Error &err_id);
 
+    // fence (with margin) items.  Each inclusion polygon, exclusion polygon and exclusion
+    // circle contributes a contiguous run of points to the visibility graph
+    enum class FenceItemType : uint8_t {
+        INCLUSION_POLYGON = 0,
+        EXCLUSION_POLYGON,
+        EXCLUSION_CIRCLE,
+    };
+    struct FenceItem {
+        uint32_t signature;     // hash of the fence's definition and margin, used to detect unchanged fences after a reload
+        Vector2f bb_min;        // bounding box of the original fence (without margin)
+        Vector2f bb_max;
+        uint16_t first_point;   // index of the fence's first point within the points for its type (across all types once the visgraph is created)
+        uint16_t num_points;    // number of points created for this fence
+        FenceItemType type;
+        bool matched;           // true if the same fence was found before and after a reload (only used while creating the visgraph)
+    };
+
+    // remove all fence items of the given type
+    void clear_fence_items(FenceItemType type);
+
+    // record a fence item, returns false if out of memory
+    bool add_fence_item(FenceItemType type, uint32_t signature, const Vector2f &bb_min, const Vector2f &bb_max, uint16_t first_point, uint16_t num_points);
+
+    // returns the index of an item's first point across all fence types
+    uint16_t fence_item_first_point(const FenceItem &item) const;
+
+    // returns true if the line segment's bounding box overlaps the item's bounding box
+    static bool segment_near_fence_item(const Vector2f &seg_start, const Vector2f &seg_end, const FenceItem &item);
+
+    // fence items for points currently held in _inclusion_polygon_pts, _exclusion_polygon_pts and _exclusion_circle_pts
+    AP_ExpandingArray<FenceItem> _fence_items;
+    uint16_t _fence_items_num;              // number of items held in above array
+    // fence items and inclusion circle signature as they were when the fence visgraph was last successfully created
+    AP_ExpandingArray<FenceItem> _visgraph_fence_items;
+    uint16_t _visgraph_fence_items_num;
+    uint32_t _visgraph_inclusion_circle_signature;
+    bool _visgraph_fence_items_ok;
+
     // calculate shortest path from origin to destination
     // returns true on success.  returns false on failure and err_id is updated
     // requires create_polygon_fence_with_margin and create_polygon_fence_visgraph to have been run
     // resulting path is stored in _shortest_path array as vector offsets from EKF origin
     bool calc_shortest_path(const Location &origin, const Location &destination, AP_OADijkstra_Error &err_id);
 
+    // calculate shortest path from origin to destination, both offsets (in cm) from the EKF origin
+    // returns true on success.  returns false on failure and err_id is updated
+    bool calc_shortest_path(const Vector2f &origin_cm, const Vector2f &destination_cm, AP_OADijkstra_Error &err_id);
+
     // shortest path state variables
     bool _inclusion_polygon_with_margin_ok;
     bool _exclusion_polygon_with_margin_ok;
@@ -174,22 +220,42 @@ private:
         bool visited;                   // true if all this node's neighbour's distances have been updated
         node_index distance_from_idx;   // index into _short_path_data from where distance was updated (or 255 if not set)
         float distance_cm;              // distance from source (number is tentative until this node is the current node and/or visited = true)
+        float heuristic_cm;             // straight line distance from node to destination
+        uint16_t open_set_pos;          // position of node in _open_set (or UINT16_MAX if not in the open set)
     };
     AP_ExpandingArray<ShortPathNode> _short_path_data;
-    node_index _short_path_data_numpoints;  // number of elements in _short_path_data array
+    uint16_t _short_path_data_numpoints;    // number of elements in _short_path_data array
+
+    // nodes which have been reached but not yet visited, held as a binary heap ordered by
+    // distance from source plus heuristic so the most promising node is always first
+    AP_ExpandingArray<node_index> _open_set;
+    uint16_t _open_set_num;
+
+    // add node to the open set or, if already present, move it forward after its distance has reduced
+    void open_set_update(node_index node_idx);
+
+    // remove most promising node from the open set
+    // returns true if successful and node_idx argument is updated
+    bool open_set_pop(node_index &node_idx);
+
+    // returns the distance from source plus heuristic of the node at position pos in the open set
+    float open_set_cost(uint16_t pos) const;
+
+    // move the node at position pos towards the front or back of the open set until the heap is ordered
+    void open_set_sift_up(uint16_t pos);
+    void open_set_sift_down(uint16_t pos);
 
     // update total distance for all nodes visible from current node
     // curr_node_idx is an index into the _short_path_data array
     void update_visible_node_distances(node_index curr_node_idx);
 
+    // update distance to node_idx via curr_node_idx
+    void update_node_distance(node_index curr_node_idx, node_index node_idx, float distance_cm);
+
     // find a node's index into _short_path_data array from it's id (i.e. id type and id number)
     // returns true if successful and node_idx is updated
     bool find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const;
 
-    // find index of node with lowest tentative distance (ignore visited nodes)
-    // returns true if successful and node_idx argument is updated
-    bool find_closest_node_idx(node_index &node_idx) const;
-
     // final path variables and functions
     AP_ExpandingArray<AP_OAVisGraph::OAItemID> _path;   // ids of points on return path in reverse order (i.e. destination is first element)
     uint8_t _path_numpoints;                            // number of points on return path
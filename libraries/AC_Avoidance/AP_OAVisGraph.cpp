@@ -41,7 +41,79 @@ bool AP_OAVisGraph::add_item(const OAItemID &id1, const OAItemID &id2, float dis
     // add item
     _items[_num_items] = {id1, id2, distance_cm};
     _num_items++;
+    clear_index();
     return true;
 }
 
+// build an index of the items which include each intermediate point
+// returns false if out of memory
+bool AP_OAVisGraph::build_index(uint16_t num_ids)
+{
+    clear_index();
+
+    _index_start = NEW_NOTHROW uint32_t[num_ids + 1];
+    if (_index_start == nullptr) {
+        return false;
+    }
+    memset(_index_start, 0, (num_ids + 1) * sizeof(uint32_t));
+    _index_num_ids = num_ids;
+
+    // count the items for each id
+    for (uint16_t i = 0; i < _num_items; i++) {
+        const VisGraphItem &item = _items[i];
+        if (item.id1.id_type == OATYPE_INTERMEDIATE_POINT && item.id1.id_num < num_ids) {
+            _index_start[item.id1.id_num]++;
+        }
+        if (item.id2.id_type == OATYPE_INTERMEDIATE_POINT && item.id2.id_num < num_ids) {
+            _index_start[item.id2.id_num]++;
+        }
+    }
+
+    // convert counts to the end of each id's items
+    for (uint16_t n = 1; n <= num_ids; n++) {
+        _index_start[n] += _index_start[n-1];
+    }
+    const uint32_t total = (num_ids > 0) ? _index_start[num_ids-1] : 0;
+    _index_start[num_ids] = total;
+
+    _index_items = NEW_NOTHROW uint16_t[MAX(total, 1U)];
+    if (_index_items == nullptr) {
+        clear_index();
+        return false;
+    }
+
+    // fill each id's items from its end, leaving _index_start at the start
+    for (uint16_t i = 0; i < _num_items; i++) {
+        const VisGraphItem &item = _items[i];
+        if (item.id1.id_type == OATYPE_INTERMEDIATE_POINT && item.id1.id_num < num_ids) {
+            _index_items[--_index_start[item.id1.id_num]] = i;
+        }
+        if (item.id2.id_type == OATYPE_INTERMEDIATE_POINT && item.id2.id_num < num_ids) {
+            _index_items[--_index_start[item.id2.id_num]] = i;
+        }
+    }
+
+    return true;
+}
+
+// get indices of the items which include intermediate point id_num
+uint16_t AP_OAVisGraph::items_for(oaid_num id_num, const uint16_t *&item_idx) const
+{
+    if (_index_start == nullptr || id_num >= _index_num_ids) {
+        return 0;
+    }
+    item_idx = &_index_items[_index_start[id_num]];
+    return _index_start[id_num+1] - _index_start[id_num];
+}
+
+// free the index
+void AP_OAVisGraph::clear_index()
+{
+    delete[] _index_start;
+    _index_start = nullptr;
+    delete[] _index_items;
+    _index_items = nullptr;
+    _index_num_ids = 0;
+}
+
 #endif  // AP_OAPATHPLANNER_ENABLED
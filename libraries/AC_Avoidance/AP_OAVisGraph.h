@@ -6,6 +6,7 @@
 
 #include <AP_Common/AP_Common.h>
 #include <AP_Common/AP_ExpandingArray.h>
+#include <AP_Math/AP_Math.h>
 
 /*
  * Visibility graph used by Dijkstra's algorithm for path planning around fence, stay-out zones and moving obstacles
@@ -13,6 +14,7 @@
 class AP_OAVisGraph {
 public:
     AP_OAVisGraph();
+    ~AP_OAVisGraph() { clear_index(); }
 
     CLASS_NO_COPY(AP_OAVisGraph);  /* Do not allow copies */
 
@@ -41,7 +43,7 @@ public:
     };
 
     // clear all elements from graph
-    void clear() { _num_items = 0; }
+    void clear() { _num_items = 0; clear_index(); }
 
     // get number of items in visibility graph table
     uint16_t num_items() const { return _num_items; }
@@ -49,14 +51,45 @@ public:
     // add item to visiblity graph, returns true on success, false if graph is full
     bool add_item(const OAItemID &id1, const OAItemID &id2, float distance_cm);
 
+    // replace an existing item, used to compact the graph in place
+    // Note: no protection against out-of-bounds accesses so use with num_items()
+    void set_item(uint16_t i, const VisGraphItem &item) { _items[i] = item; clear_index(); }
+
+    // remove all items from num onwards
+    void truncate(uint16_t num) { _num_items = MIN(_num_items, num); clear_index(); }
+
     // allow accessing graph as an array, 0 indexed
     // Note: no protection against out-of-bounds accesses so use with num_items()
     const VisGraphItem& operator[](uint16_t i) const { return _items[i]; }
 
+    // build an index of the items which include each intermediate point so
+    // that a point's neighbours can be found without searching the whole graph.
+    // num_ids is one more than the highest intermediate point id in the graph.
+    // the index is discarded whenever the graph is changed
+    // returns false if out of memory
+    bool build_index(uint16_t num_ids);
+
+    // true if build_index has been run since the graph was last changed
+    bool index_ok() const { return _index_start != nullptr; }
+
+    // get indices of the items which include intermediate point id_num
+    // returns the number of items, item_idx points to their indices
+    // requires index_ok() to be true
+    uint16_t items_for(oaid_num id_num, const uint16_t *&item_idx) const;
+
 private:
 
+    // free the index
+    void clear_index();
+
     AP_ExpandingArray<VisGraphItem> _items;
     uint16_t _num_items;
+
+    // item indices grouped by intermediate point id: the items for id n
+    // are _index_items[_index_start[n]] to _index_items[_index_start[n+1]-1]
+    uint32_t *_index_start = nullptr;
+    uint16_t *_index_items = nullptr;
+    uint16_t _index_num_ids;
 };
 
 #endif  // AP_OAPATHPLANNER_ENABLED
@@ -0,0 +1,92 @@
+#include <AP_gbenchmark.h>
+
+#include <AC_Avoidance/AP_OABendyRuler.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define BENDYRULER_PATHS        69      // number of first step paths checked by search_xy_path
+#define BENDYRULER_LOOKAHEAD    1500.0f // path length in cm
+
+class AP_OABendyRuler_Test
+{
+public:
+    typedef AP_OABendyRuler::PathPoint PathPoint;
+    typedef AP_OABendyRuler::Obstacle Obstacle;
+
+    static void calc_margins_from_obstacles(const Vector3f &start_NEU, const PathPoint *ends, uint8_t num_ends, const Obstacle *obstacles, uint16_t num_obstacles, float *margins) {
+        AP_OABendyRuler::calc_margins_from_obstacles(start_NEU, ends, num_ends, obstacles, num_obstacles, margins);
+    }
+};
+
+typedef AP_OABendyRuler_Test::PathPoint PathPoint;
+typedef AP_OABendyRuler_Test::Obstacle Obstacle;
+
+// obstacles scattered around the vehicle, as from a busy proximity sensor
+static uint16_t make_obstacles(Obstacle *obstacles, uint16_t num_obstacles)
+{
+    for (uint16_t i = 0; i < num_obstacles; i++) {
+        const float angle = i * 2.39996f;
+        const float dist = 300.0f + (i * 7919 % 5000);
+        obstacles[i].pos_cm = Vector3f{dist * cosf(angle), dist * sinf(angle), float(i % 7) * 50.0f};
+        obstacles[i].radius = 0.5f;
+    }
+    return num_obstacles;
+}
+
+static void make_paths(PathPoint *ends)
+{
+    for (uint8_t i = 0; i < BENDYRULER_PATHS; i++) {
+        const float angle = radians(i * 5.0f);
+        ends[i].NEU_cm = Vector3f{BENDYRULER_LOOKAHEAD * cosf(angle), BENDYRULER_LOOKAHEAD * sinf(angle), 100.0f};
+        ends[i].NEU_ok = true;
+    }
+}
+
+// each path checked against every obstacle in turn
+static void BM_BendyRulerObstaclesPerPath(benchmark::State& state)
+{
+    static Obstacle obstacles[1000];
+    const uint16_t num_obstacles = make_obstacles(obstacles, state.range(0));
+    PathPoint ends[BENDYRULER_PATHS];
+    make_paths(ends);
+    const Vector3f start{0.0f, 0.0f, 100.0f};
+    float margins[BENDYRULER_PATHS];
+
+    while (state.KeepRunning()) {
+        for (uint8_t j = 0; j < BENDYRULER_PATHS; j++) {
+            float smallest_margin = FLT_MAX;
+            for (uint16_t i = 0; i < num_obstacles; i++) {
+                const float m = Vector3f::closest_distance_between_line_and_point(start, ends[j].NEU_cm, obstacles[i].pos_cm) * 0.01f - obstacles[i].radius;
+                if (m < smallest_margin) {
+                    smallest_margin = m;
+                }
+            }
+            margins[j] = smallest_margin;
+        }
+        gbenchmark_escape(margins);
+    }
+}
+
+// all paths checked together
+static void BM_BendyRulerObstaclesBatched(benchmark::State& state)
+{
+    static Obstacle obstacles[1000];
+    const uint16_t num_obstacles = make_obstacles(obstacles, state.range(0));
+    PathPoint ends[BENDYRULER_PATHS];
+    make_paths(ends);
+    const Vector3f start{0.0f, 0.0f, 100.0f};
+    float margins[BENDYRULER_PATHS];
+
+    while (state.KeepRunning()) {
+        for (uint8_t j = 0; j < BENDYRULER_PATHS; j++) {
+            margins[j] = FLT_MAX;
+        }
+        AP_OABendyRuler_Test::calc_margins_from_obstacles(start, ends, BENDYRULER_PATHS, obstacles, num_obstacles, margins);
+        gbenchmark_escape(margins);
+    }
+}
+
+BENCHMARK(BM_BendyRulerObstaclesPerPath)->Arg(100)->Arg(1000);
+BENCHMARK(BM_BendyRulerObstaclesBatched)->Arg(100)->Arg(1000);
+
+BENCHMARK_MAIN();
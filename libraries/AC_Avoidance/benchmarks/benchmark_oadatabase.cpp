@@ -0,0 +1,126 @@
+#include <AP_gbenchmark.h>
+
+#include <AC_Avoidance/AP_OADatabase.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define OADATABASE_EXPIRY_MS    3000    // item expiry time in ms
+#define OADATABASE_ITEM_MS      100000  // timestamp of the items in the database
+
+typedef AP_OADatabase::OA_DbItem OA_DbItem;
+
+class AP_OADatabase_Test
+{
+public:
+    static void init(AP_OADatabase &db, uint16_t size)
+    {
+        db._database_size_param.set(size);
+        db._queue_size_param.set(10);
+        db._database_expiry_seconds.set(OADATABASE_EXPIRY_MS / 1000);
+        db.init_database();
+        db.init_queue();
+    }
+    static bool find(const AP_OADatabase &db, const OA_DbItem &item, uint16_t &index) { return db.database_item_find(item, index); }
+    static bool item_match(const AP_OADatabase &db, const OA_DbItem &a, const OA_DbItem &b) { return db.item_match(a, b); }
+    static void add(AP_OADatabase &db, const OA_DbItem &item) { db.database_item_add(item); }
+    static void remove_expired(AP_OADatabase &db, uint32_t now_ms) { db.database_items_remove_all_expired(now_ms); }
+    static void remove_all(AP_OADatabase &db)
+    {
+        while (db._database.count > 0) {
+            db.database_item_remove(db._database.count - 1);
+        }
+    }
+};
+
+static AP_OADatabase db;
+
+// lidar-like returns 5m to 40m from the vehicle
+static OA_DbItem make_item(uint32_t i, uint32_t timestamp_ms)
+{
+    OA_DbItem item {};
+    const float angle = i * 2.39996f;
+    const float dist = 5.0f + (i * 7919 % 3500) * 0.01f;
+    item.pos = Vector3f{dist * cosf(angle), dist * sinf(angle), 0.0f};
+    item.radius = dist * 0.0175f;
+    item.timestamp_ms = timestamp_ms;
+    item.source = OA_DbItem::Source::proximity;
+    return item;
+}
+
+// fill the database with count items
+static void fill_database(uint16_t count)
+{
+    if (!db.healthy()) {
+        AP_OADatabase_Test::init(db, 4000);
+    }
+    AP_OADatabase_Test::remove_all(db);
+    for (uint32_t i = 0; db.database_count() < count; i++) {
+        const OA_DbItem item = make_item(i, OADATABASE_ITEM_MS);
+        uint16_t index;
+        if (!AP_OADatabase_Test::find(db, item, index)) {
+            AP_OADatabase_Test::add(db, item);
+        }
+    }
+}
+
+// look up new measurements using the spatial hash
+static void BM_OADatabaseFindHash(benchmark::State& state)
+{
+    fill_database(state.range(0));
+    uint32_t i = 100000;
+    while (state.KeepRunning()) {
+        uint16_t index;
+        bool found = AP_OADatabase_Test::find(db, make_item(i++, OADATABASE_ITEM_MS), index);
+        gbenchmark_escape(&found);
+    }
+}
+
+// look up new measurements by checking every item
+static void BM_OADatabaseFindAll(benchmark::State& state)
+{
+    fill_database(state.range(0));
+    uint32_t i = 100000;
+    while (state.KeepRunning()) {
+        const OA_DbItem item = make_item(i++, OADATABASE_ITEM_MS);
+        bool found = false;
+        for (uint16_t j = 0; j < db.database_count(); j++) {
+            if (AP_OADatabase_Test::item_match(db, db.get_item(j), item)) {
+                found = true;
+                break;
+            }
+        }
+        gbenchmark_escape(&found);
+    }
+}
+
+// check for expired items using the expiry wheel, as done on each update.  None have expired
+static void BM_OADatabaseExpireWheel(benchmark::State& state)
+{
+    fill_database(state.range(0));
+    while (state.KeepRunning()) {
+        AP_OADatabase_Test::remove_expired(db, OADATABASE_ITEM_MS + 1000);
+    }
+}
+
+// check for expired items by checking every item's age
+static void BM_OADatabaseExpireAll(benchmark::State& state)
+{
+    fill_database(state.range(0));
+    const uint32_t now_ms = OADATABASE_ITEM_MS + 1000;
+    while (state.KeepRunning()) {
+        uint16_t num_expired = 0;
+        for (uint16_t j = 0; j < db.database_count(); j++) {
+            if (now_ms - db.get_item(j).timestamp_ms > OADATABASE_EXPIRY_MS) {
+                num_expired++;
+            }
+        }
+        gbenchmark_escape(&num_expired);
+    }
+}
+
+BENCHMARK(BM_OADatabaseFindHash)->Arg(100)->Arg(1000)->Arg(3000);
+BENCHMARK(BM_OADatabaseFindAll)->Arg(100)->Arg(1000)->Arg(3000);
+BENCHMARK(BM_OADatabaseExpireWheel)->Arg(100)->Arg(1000)->Arg(3000);
+BENCHMARK(BM_OADatabaseExpireAll)->Arg(100)->Arg(1000)->Arg(3000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,225 @@
+/*
+ * Benchmarks for the visibility graph used by Dijkstra's path planner
+ * over a large synthetic fence
+ */
+#include <AP_gbenchmark.h>
+
+#include <AC_Avoidance/AP_OAVisGraph.h>
+#include <AP_Math/AP_PolygonIndex.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define NUM_INCLUSION_POINTS    200     // points in the circular inclusion polygon
+#define NUM_EXCLUSION_SQUARES   20      // square exclusion polygons inside the inclusion polygon
+
+struct SyntheticFence {
+    Vector2f inclusion[NUM_INCLUSION_POINTS];
+    Vector2f exclusion[NUM_EXCLUSION_SQUARES][4];
+    Vector2f nodes[NUM_INCLUSION_POINTS/4 + NUM_EXCLUSION_SQUARES*4];
+    uint16_t num_nodes;
+};
+
+// a survey-sized (10km) inclusion polygon with a grid of 500m exclusion zones.
+// nodes are placed just inside the inclusion polygon and just outside each
+// exclusion zone, as AP_OADijkstra does with its fence margin
+static void make_fence(SyntheticFence &fence)
+{
+    const float radius_cm = 500000;
+    for (uint16_t i = 0; i < NUM_INCLUSION_POINTS; i++) {
+        const float angle = radians(360.0f * i / NUM_INCLUSION_POINTS);
+        fence.inclusion[i] = Vector2f{cosf(angle), sinf(angle)} * radius_cm;
+        if (i % 4 == 0) {
+            fence.nodes[fence.num_nodes++] = fence.inclusion[i] * 0.98f;
+        }
+    }
+    for (uint16_t i = 0; i < NUM_EXCLUSION_SQUARES; i++) {
+        const Vector2f center{-300000.0f + (i % 5) * 150000.0f, -200000.0f + (i / 5) * 130000.0f};
+        const Vector2f corners[] {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+        for (uint8_t j = 0; j < 4; j++) {
+            fence.exclusion[i][j] = center + corners[j] * 25000.0f;
+            fence.nodes[fence.num_nodes++] = center + corners[j] * 26000.0f;
+        }
+    }
+}
+
+static bool brute_force_intersects(const SyntheticFence &fence, const Vector2f &seg_start, const Vector2f &seg_end)
+{
+    Vector2f intersection;
+    if (Polygon_intersects(fence.inclusion, NUM_INCLUSION_POINTS, seg_start, seg_end, intersection)) {
+        return true;
+    }
+    for (uint16_t i = 0; i < NUM_EXCLUSION_SQUARES; i++) {
+        if (Polygon_intersects(fence.exclusion[i], 4, seg_start, seg_end, intersection)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// each polygon indexed as AC_PolyFence_loader indexes the loaded fences
+struct FenceIndex {
+    AP_PolygonIndex<float> inclusion;
+    AP_PolygonIndex<float> exclusion[NUM_EXCLUSION_SQUARES];
+};
+
+static void index_fence(const SyntheticFence &fence, FenceIndex &index)
+{
+    index.inclusion.init(fence.inclusion, NUM_INCLUSION_POINTS);
+    for (uint16_t i = 0; i < NUM_EXCLUSION_SQUARES; i++) {
+        index.exclusion[i].init(fence.exclusion[i], 4);
+    }
+}
+
+static bool indexed_intersects(const FenceIndex &index, const Vector2f &seg_start, const Vector2f &seg_end)
+{
+    Vector2f intersection;
+    if (index.inclusion.intersects(seg_start, seg_end, intersection)) {
+        return true;
+    }
+    for (uint16_t i = 0; i < NUM_EXCLUSION_SQUARES; i++) {
+        if (index.exclusion[i].intersects(seg_start, seg_end, intersection)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// build the node to node visibility graph checking every fence line
+static void BM_VisgraphBruteForce(benchmark::State& state)
+{
+    SyntheticFence *fence = new SyntheticFence();
+    make_fence(*fence);
+    AP_OAVisGraph *visgraph = new AP_OAVisGraph();
+
+    while (state.KeepRunning()) {
+        visgraph->clear();
+        for (uint16_t i = 0; i + 1 < fence->num_nodes; i++) {
+            for (uint16_t j = i + 1; j < fence->num_nodes; j++) {
+                if (!brute_force_intersects(*fence, fence->nodes[i], fence->nodes[j])) {
+                    visgraph->add_item({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)i},
+                                       {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)j},
+                                       (fence->nodes[i] - fence->nodes[j]).length());
+                }
+            }
+        }
+        gbenchmark_escape(visgraph);
+    }
+    delete visgraph;
+    delete fence;
+}
+
+// build the same graph checking only the fence lines in the bands each segment crosses
+static void BM_VisgraphPolygonIndex(benchmark::State& state)
+{
+    SyntheticFence *fence = new SyntheticFence();
+    make_fence(*fence);
+    AP_OAVisGraph *visgraph = new AP_OAVisGraph();
+    FenceIndex *index = new FenceIndex();
+
+    while (state.KeepRunning()) {
+        index_fence(*fence, *index);
+        visgraph->clear();
+        for (uint16_t i = 0; i + 1 < fence->num_nodes; i++) {
+            for (uint16_t j = i + 1; j < fence->num_nodes; j++) {
+                if (!indexed_intersects(*index, fence->nodes[i], fence->nodes[j])) {
+                    visgraph->add_item({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)i},
+                                       {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)j},
+                                       (fence->nodes[i] - fence->nodes[j]).length());
+                }
+            }
+        }
+        visgraph->build_index(fence->num_nodes);
+        gbenchmark_escape(visgraph);
+    }
+    delete index;
+    delete visgraph;
+    delete fence;
+}
+
+// a single line check, as made for each node when the source or destination changes
+static void BM_IntersectsBruteForce(benchmark::State& state)
+{
+    SyntheticFence *fence = new SyntheticFence();
+    make_fence(*fence);
+
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        bool ret = brute_force_intersects(*fence, Vector2f{}, fence->nodes[i]);
+        gbenchmark_escape(&ret);
+        i = (i + 1) % fence->num_nodes;
+    }
+    delete fence;
+}
+
+static void BM_IntersectsPolygonIndex(benchmark::State& state)
+{
+    SyntheticFence *fence = new SyntheticFence();
+    make_fence(*fence);
+    FenceIndex *index = new FenceIndex();
+    index_fence(*fence, *index);
+
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        bool ret = indexed_intersects(*index, Vector2f{}, fence->nodes[i]);
+        gbenchmark_escape(&ret);
+        i = (i + 1) % fence->num_nodes;
+    }
+    delete index;
+    delete fence;
+}
+
+// find every neighbour of every node, as the shortest path search does
+static void BM_NeighboursScan(benchmark::State& state)
+{
+    SyntheticFence *fence = new SyntheticFence();
+    make_fence(*fence);
+    FenceIndex *index = new FenceIndex();
+    index_fence(*fence, *index);
+    AP_OAVisGraph *visgraph = new AP_OAVisGraph();
+    for (uint16_t i = 0; i + 1 < fence->num_nodes; i++) {
+        for (uint16_t j = i + 1; j < fence->num_nodes; j++) {
+            if (!indexed_intersects(*index, fence->nodes[i], fence->nodes[j])) {
+                visgraph->add_item({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)i},
+                                   {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)j},
+                                   (fence->nodes[i] - fence->nodes[j]).length());
+            }
+        }
+    }
+    const bool use_index = state.range(0) != 0;
+    if (use_index) {
+        visgraph->build_index(fence->num_nodes);
+    }
+
+    while (state.KeepRunning()) {
+        float total_cm = 0;
+        for (uint16_t n = 0; n < fence->num_nodes; n++) {
+            const AP_OAVisGraph::OAItemID id {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)n};
+            if (use_index) {
+                const uint16_t *item_idx;
+                const uint16_t num_items = visgraph->items_for(id.id_num, item_idx);
+                for (uint16_t k = 0; k < num_items; k++) {
+                    total_cm += (*visgraph)[item_idx[k]].distance_cm;
+                }
+            } else {
+                for (uint16_t k = 0; k < visgraph->num_items(); k++) {
+                    const AP_OAVisGraph::VisGraphItem &item = (*visgraph)[k];
+                    if ((item.id1 == id) || (item.id2 == id)) {
+                        total_cm += item.distance_cm;
+                    }
+                }
+            }
+        }
+        gbenchmark_escape(&total_cm);
+    }
+    delete visgraph;
+    delete index;
+    delete fence;
+}
+
+BENCHMARK(BM_VisgraphBruteForce);
+BENCHMARK(BM_VisgraphPolygonIndex);
+BENCHMARK(BM_IntersectsBruteForce);
+BENCHMARK(BM_IntersectsPolygonIndex);
+BENCHMARK(BM_NeighboursScan)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
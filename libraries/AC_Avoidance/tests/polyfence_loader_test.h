@@ -0,0 +1,79 @@
+/*
+  load fences straight into AC_PolyFence_loader's loaded fence arrays,
+  bypassing storage and the EKF origin, for the path planner tests
+ */
+#pragma once
+
+#include <AC_Fence/AC_Fence.h>
+
+#if AP_FENCE_ENABLED
+
+struct TestPolygon {
+    const Vector2f *points;
+    uint8_t count;
+};
+
+struct TestCircle {
+    Vector2f center_cm;     // offset from the EKF origin in cm
+    float radius;           // radius in meters
+};
+
+class AC_PolyFence_loader_Test
+{
+public:
+    // replace the loaded fences, as load_from_storage() does
+    static void load(AC_PolyFence_loader &loader,
+                     const TestPolygon *inclusions, uint8_t num_inclusions,
+                     const TestPolygon *exclusions, uint8_t num_exclusions,
+                     const TestCircle *inclusion_circles, uint8_t num_inclusion_circles,
+                     const TestCircle *exclusion_circles, uint8_t num_exclusion_circles,
+                     uint32_t load_time_ms)
+    {
+        loader.unload();
+
+        loader._loaded_inclusion_boundary = NEW_NOTHROW AC_PolyFence_loader::InclusionBoundary[num_inclusions];
+        for (uint8_t i = 0; i < num_inclusions; i++) {
+            AC_PolyFence_loader::InclusionBoundary &boundary = loader._loaded_inclusion_boundary[i];
+            boundary.points = const_cast<Vector2f *>(inclusions[i].points);
+            boundary.count = inclusions[i].count;
+#if AC_POLYFENCE_POLYGON_INDEX_ENABLED
+            IGNORE_RETURN(boundary.points_index.init(boundary.points, boundary.count));
+#endif
+        }
+        loader._num_loaded_inclusion_boundaries = num_inclusions;
+
+        loader._loaded_exclusion_boundary = NEW_NOTHROW AC_PolyFence_loader::ExclusionBoundary[num_exclusions];
+        for (uint8_t i = 0; i < num_exclusions; i++) {
+            AC_PolyFence_loader::ExclusionBoundary &boundary = loader._loaded_exclusion_boundary[i];
+            boundary.points = const_cast<Vector2f *>(exclusions[i].points);
+            boundary.count = exclusions[i].count;
+#if AC_POLYFENCE_POLYGON_INDEX_ENABLED
+            IGNORE_RETURN(boundary.points_index.init(boundary.points, boundary.count));
+#endif
+        }
+        loader._num_loaded_exclusion_boundaries = num_exclusions;
+
+        loader._loaded_circle_inclusion_boundary = NEW_NOTHROW AC_PolyFence_loader::InclusionCircle[num_inclusion_circles];
+        for (uint8_t i = 0; i < num_inclusion_circles; i++) {
+            loader._loaded_circle_inclusion_boundary[i].pos_cm = inclusion_circles[i].center_cm;
+            loader._loaded_circle_inclusion_boundary[i].radius = inclusion_circles[i].radius;
+        }
+        loader._num_loaded_circle_inclusion_boundaries = num_inclusion_circles;
+
+        loader._loaded_circle_exclusion_boundary = NEW_NOTHROW AC_PolyFence_loader::ExclusionCircle[num_exclusion_circles];
+        for (uint8_t i = 0; i < num_exclusion_circles; i++) {
+            loader._loaded_circle_exclusion_boundary[i].pos_cm = exclusion_circles[i].center_cm;
+            loader._loaded_circle_exclusion_boundary[i].radius = exclusion_circles[i].radius;
+        }
+        loader._num_loaded_circle_exclusion_boundaries = num_exclusion_circles;
+
+        loader._load_time_ms = load_time_ms;
+    }
+
+    static void unload(AC_PolyFence_loader &loader)
+    {
+        loader.unload();
+    }
+};
+
+#endif  // AP_FENCE_ENABLED
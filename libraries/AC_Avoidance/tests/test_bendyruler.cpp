@@ -0,0 +1,430 @@
+/*
+  check that BendyRuler's batched margin calculations give exactly the
+  margins the per-path calculations they replaced did.  The reference
+  functions below are the old per-path functions with the conversion of
+  the path's end points to offsets from the EKF origin moved out
+ */
+#include <AP_gtest.h>
+
+#include <AC_Avoidance/AC_Avoidance_config.h>
+#include <AC_Fence/AC_Fence.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_OAPATHPLANNER_BENDYRULER_ENABLED && AP_FENCE_ENABLED
+
+#include <AC_Avoidance/AP_OABendyRuler.h>
+#include "polyfence_loader_test.h"
+
+static AC_Fence fence;
+
+class AP_OABendyRuler_Test
+{
+public:
+    typedef AP_OABendyRuler::PathPoint PathPoint;
+    typedef AP_OABendyRuler::Obstacle Obstacle;
+
+    // allocated so its members start zeroed, as they do on the vehicle
+    AP_OABendyRuler_Test() : bendy(NEW_NOTHROW AP_OABendyRuler()) {
+        bendy->_bendy_type.set((int8_t)AP_OABendyRuler::OABendyType::OA_BENDY_HORIZONTAL);
+    }
+    ~AP_OABendyRuler_Test() {
+        bendy->_obstacles = nullptr;
+        delete bendy;
+    }
+
+    CLASS_NO_COPY(AP_OABendyRuler_Test);
+
+    // set the fence snapshot normally taken by update_margin_cache()
+    void set_fence(uint8_t enabled_fences, float margin_ne_m, float radius_m, float safe_alt_max_m, const Location &home) {
+        bendy->_fence_cache.enabled = true;
+        bendy->_fence_cache.enabled_fences = enabled_fences;
+        bendy->_fence_cache.margin_ne_m = margin_ne_m;
+        bendy->_fence_cache.radius_m = radius_m;
+        bendy->_fence_cache.safe_alt_max_m = safe_alt_max_m;
+        bendy->_fence_cache.home = home;
+    }
+
+    // set the object database snapshot normally taken by update_margin_cache()
+    void set_obstacles(Obstacle *obstacles, uint16_t num_obstacles) {
+        bendy->_obstacles = obstacles;
+        bendy->_obstacles_max = num_obstacles;
+        bendy->_num_obstacles = num_obstacles;
+        bendy->_obstacles_cached = true;
+    }
+
+    static void calc_margins_from_obstacles(const Vector3f &start_NEU, const PathPoint *ends, uint8_t num_ends, const Obstacle *obstacles, uint16_t num_obstacles, float *margins) {
+        AP_OABendyRuler::calc_margins_from_obstacles(start_NEU, ends, num_ends, obstacles, num_obstacles, margins);
+    }
+    void calc_avoidance_margins(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins, bool proximity_only) const {
+        bendy->calc_avoidance_margins(start, ends, num_ends, margins, proximity_only);
+    }
+    void calc_margins_from_alt_fence(const PathPoint &start, const PathPoint *ends, uint8_t num_ends, float *margins) const {
+        bendy->calc_margins_from_alt_fence(start, ends, num_ends, margins);
+    }
+
+private:
+    AP_OABendyRuler *bendy;
+};
+
+typedef AP_OABendyRuler_Test::PathPoint PathPoint;
+typedef AP_OABendyRuler_Test::Obstacle Obstacle;
+
+/*
+  the old per-path margin calculations
+ */
+
+static bool old_margin_from_circular_fence(const Location &home, float radius_m, float margin_ne_m, const Location &start, const Location &end, float &margin)
+{
+    // calculate start and end point's distance from home
+    const float start_dist_sq = home.get_distance_NE(start).length_squared();
+    const float end_dist_sq = home.get_distance_NE(end).length_squared();
+
+    // get circular fence radius + margin
+    const float fence_radius_plus_margin = radius_m - margin_ne_m;
+
+    // margin is fence radius minus the longer of start or end distance
+    margin = fence_radius_plus_margin - sqrtf(MAX(start_dist_sq, end_dist_sq));
+    return true;
+}
+
+static bool old_margin_from_alt_fence(float safe_alt_max_m, const Location &start, const Location &end, float &margin)
+{
+    int32_t alt_above_home_cm_start, alt_above_home_cm_end;
+    if (!start.get_alt_cm(Location::AltFrame::ABOVE_HOME, alt_above_home_cm_start)) {
+        return false;
+    }
+    if (!end.get_alt_cm(Location::AltFrame::ABOVE_HOME, alt_above_home_cm_end )) {
+        return false;
+    }
+
+    // safe max alt = fence alt - fence margin
+    const float max_fence_alt = safe_alt_max_m;
+    const float margin_start =  max_fence_alt - alt_above_home_cm_start * 0.01f;
+    const float margin_end =  max_fence_alt - alt_above_home_cm_end * 0.01f;
+
+    // margin is minimum distance to fence from either start or end location
+    margin = MIN(margin_start,margin_end);
+
+    return true;
+}
+
+static bool old_margin_from_inclusion_and_exclusion_polygons(float fence_margin, const Vector2f &start_NE, const Vector2f &end_NE, float &margin)
+{
+    const uint8_t num_inclusion_polygons = fence.polyfence().get_inclusion_polygon_count();
+    const uint8_t num_exclusion_polygons = fence.polyfence().get_exclusion_polygon_count();
+
+    // iterate through inclusion polygons and calculate minimum margin
+    bool margin_updated = false;
+    for (uint8_t i = 0; i < num_inclusion_polygons; i++) {
+        uint16_t num_points;
+        const Vector2f* boundary = fence.polyfence().get_inclusion_polygon(i, num_points);
+        const AP_PolygonIndex<float>* poly_index = fence.polyfence().get_inclusion_polygon_index(i);
+
+        // if outside the fence margin is the closest distance but with negative sign
+        const bool outside = (poly_index != nullptr) ? poly_index->outside(start_NE) : Polygon_outside(start_NE, boundary, num_points);
+        const float sign = outside ? -1.0f : 1.0f;
+
+        // calculate min distance (in meters) from line to polygon
+        const float distance = (poly_index != nullptr) ? poly_index->closest_distance_line(start_NE, end_NE) : Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE);
+        float margin_new = (sign * distance * 0.01f) - fence_margin;
+        if (!margin_updated || (margin_new < margin)) {
+            margin_updated = true;
+            margin = margin_new;
+        }
+    }
+
+    // iterate through exclusion polygons and calculate minimum margin
+    for (uint8_t i = 0; i < num_exclusion_polygons; i++) {
+        uint16_t num_points;
+        const Vector2f* boundary = fence.polyfence().get_exclusion_polygon(i, num_points);
+        const AP_PolygonIndex<float>* poly_index = fence.polyfence().get_exclusion_polygon_index(i);
+
+        // if start is inside the polygon the margin's sign is reversed
+        const bool outside = (poly_index != nullptr) ? poly_index->outside(start_NE) : Polygon_outside(start_NE, boundary, num_points);
+        const float sign = outside ? 1.0f : -1.0f;
+
+        // calculate min distance (in meters) from line to polygon
+        const float distance = (poly_index != nullptr) ? poly_index->closest_distance_line(start_NE, end_NE) : Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE);
+        float margin_new = (sign * distance * 0.01f) - fence_margin;
+        if (!margin_updated || (margin_new < margin)) {
+            margin_updated = true;
+            margin = margin_new;
+        }
+    }
+
+    return margin_updated;
+}
+
+static bool old_margin_from_inclusion_and_exclusion_circles(float fence_margin, const Vector2f &start_NE, const Vector2f &end_NE, float &margin)
+{
+    const uint8_t num_inclusion_circles = fence.polyfence().get_inclusion_circle_count();
+    const uint8_t num_exclusion_circles = fence.polyfence().get_exclusion_circle_count();
+
+    // iterate through inclusion circles and calculate minimum margin
+    bool margin_updated = false;
+    for (uint8_t i = 0; i < num_inclusion_circles; i++) {
+        Vector2f center_pos_cm;
+        float radius;
+        if (fence.polyfence().get_inclusion_circle(i, center_pos_cm, radius)) {
+
+            // calculate start and ends distance from the center of the circle
+            const float start_dist_sq = (start_NE - center_pos_cm).length_squared();
+            const float end_dist_sq = (end_NE - center_pos_cm).length_squared();
+
+            // margin is fence radius minus the longer of start or end distance
+            const float margin_new = (radius + fence_margin) - (sqrtf(MAX(start_dist_sq, end_dist_sq)) * 0.01f);
+
+            // update margin with lowest value so far
+            if (!margin_updated || (margin_new < margin)) {
+                margin_updated = true;
+                margin = margin_new;
+            }
+        }
+    }
+
+    // iterate through exclusion circles and calculate minimum margin
+    for (uint8_t i = 0; i < num_exclusion_circles; i++) {
+        Vector2f center_pos_cm;
+        float radius;
+        if (fence.polyfence().get_exclusion_circle(i, center_pos_cm, radius)) {
+
+            // first calculate distance between circle's center and segment
+            const float dist_cm = Vector2f::closest_distance_between_line_and_point(start_NE, end_NE, center_pos_cm);
+
+            // margin is distance to the center minus the radius
+            const float margin_new = (dist_cm * 0.01f) - (radius + fence_margin);
+
+            // update margin with lowest value so far
+            if (!margin_updated || (margin_new < margin)) {
+                margin_updated = true;
+                margin = margin_new;
+            }
+        }
+    }
+
+    return margin_updated;
+}
+
+static bool old_margin_from_object_database(const Obstacle *obstacles, uint16_t num_obstacles, const Vector3f &start_NEU, const Vector3f &end_NEU, float &margin)
+{
+    if (start_NEU == end_NEU) {
+        return false;
+    }
+
+    // check each obstacle's distance from segment
+    float smallest_margin = FLT_MAX;
+    for (uint16_t i=0; i<num_obstacles; i++) {
+        // margin is distance between line segment and obstacle minus obstacle's radius
+        const float m = Vector3f::closest_distance_between_line_and_point(start_NEU, end_NEU, obstacles[i].pos_cm) * 0.01f - obstacles[i].radius;
+        if (m < smallest_margin) {
+            smallest_margin = m;
+        }
+    }
+
+    // return smallest margin
+    if (smallest_margin < FLT_MAX) {
+        margin = smallest_margin;
+        return true;
+    }
+
+    return false;
+}
+
+// the old calc_avoidance_margin() for horizontal BendyRuler
+static float old_avoidance_margin(const Obstacle *obstacles, uint16_t num_obstacles, const Location &home, float radius_m, float margin_ne_m,
+                                  const PathPoint &start, const PathPoint &end, bool proximity_only)
+{
+    float margin_min = FLT_MAX;
+
+    float latest_margin;
+
+    if (start.NEU_ok && end.NEU_ok && old_margin_from_object_database(obstacles, num_obstacles, start.NEU_cm, end.NEU_cm, latest_margin)) {
+        margin_min = MIN(margin_min, latest_margin);
+    }
+
+    if (proximity_only) {
+        // only need margin from proximity data
+        return margin_min;
+    }
+
+    if (old_margin_from_circular_fence(home, radius_m, margin_ne_m, start.loc, end.loc, latest_margin)) {
+        margin_min = MIN(margin_min, latest_margin);
+    }
+
+    if (start.NE_ok && end.NE_ok && old_margin_from_inclusion_and_exclusion_polygons(margin_ne_m, start.NE_cm, end.NE_cm, latest_margin)) {
+        margin_min = MIN(margin_min, latest_margin);
+    }
+
+    if (start.NE_ok && end.NE_ok && old_margin_from_inclusion_and_exclusion_circles(margin_ne_m, start.NE_cm, end.NE_cm, latest_margin)) {
+        margin_min = MIN(margin_min, latest_margin);
+    }
+
+    // return smallest margin from any obstacle
+    return margin_min;
+}
+
+/*
+  test data
+ */
+
+static uint32_t rand_state = 1;
+
+// uniformly distributed in [lo, hi)
+static float rand_float(float lo, float hi)
+{
+    rand_state = rand_state * 1664525U + 1013904223U;
+    return lo + (hi - lo) * ((rand_state >> 8) * (1.0f / (1U << 24)));
+}
+
+// obstacles scattered around pos_cm, as from a busy proximity sensor
+static void make_obstacles(const Vector3f &pos_cm, Obstacle *obstacles, uint16_t num_obstacles)
+{
+    for (uint16_t i = 0; i < num_obstacles; i++) {
+        obstacles[i].pos_cm = pos_cm + Vector3f{rand_float(-3000, 3000), rand_float(-3000, 3000), rand_float(-500, 500)};
+        obstacles[i].radius = rand_float(0, 2);
+    }
+}
+
+// a path end point offset_cm from origin, which is at pos_cm from the EKF origin
+static PathPoint make_point(const Location &origin, const Vector3f &pos_cm, const Vector3f &offset_cm)
+{
+    PathPoint point {};
+    point.loc = origin;
+    point.loc.offset(offset_cm.x * 0.01f, offset_cm.y * 0.01f);
+    point.loc.set_alt_cm(origin.alt + int32_t(offset_cm.z), Location::AltFrame::ABOVE_HOME);
+    point.NEU_cm = pos_cm + offset_cm;
+    point.NE_cm = point.NEU_cm.xy();
+    point.NE_ok = point.NEU_ok = true;
+    return point;
+}
+
+// first step paths as search_xy_path() projects them: every 5 degrees, plus
+// a zero length path and paths which could not be converted to offsets
+static uint8_t make_paths(const Location &origin, const Vector3f &pos_cm, float lookahead_cm, PathPoint *ends)
+{
+    uint8_t num_ends = 0;
+    for (uint8_t i = 0; i < 66; i++) {
+        const float angle = radians(i * 5.0f + rand_float(0, 5));
+        const Vector3f offset {lookahead_cm * cosf(angle), lookahead_cm * sinf(angle), rand_float(-300, 300)};
+        ends[num_ends++] = make_point(origin, pos_cm, offset);
+    }
+    ends[num_ends++] = make_point(origin, pos_cm, Vector3f{});
+    ends[num_ends] = make_point(origin, pos_cm, Vector3f{lookahead_cm, 0, 0});
+    ends[num_ends++].NEU_ok = false;
+    ends[num_ends] = make_point(origin, pos_cm, Vector3f{0, lookahead_cm, 0});
+    ends[num_ends].NE_ok = ends[num_ends].NEU_ok = false;
+    num_ends++;
+    return num_ends;
+}
+
+TEST(AP_OABendyRuler, ObstacleMargins)
+{
+    static Obstacle obstacles[1000];
+    PathPoint ends[OA_BENDYRULER_CANDIDATES_MAX];
+    const Location origin {-353632620, 1491652370, 1000, Location::AltFrame::ABOVE_HOME};
+
+    // near the EKF origin and far from it, where rounding is larger
+    const Vector3f positions[] {{0, 0, 1000}, {150000, -80000, 3000}, {2000000, 3000000, 10000}};
+    for (const Vector3f &pos_cm : positions) {
+        for (uint16_t num_obstacles : {0, 1, 10, 100, 1000}) {
+            make_obstacles(pos_cm, obstacles, num_obstacles);
+            for (float lookahead_cm : {500.0f, 1500.0f, 5000.0f}) {
+                const uint8_t num_ends = make_paths(origin, pos_cm, lookahead_cm, ends);
+                ASSERT_LE(num_ends, OA_BENDYRULER_CANDIDATES_MAX);
+
+                float margins[OA_BENDYRULER_CANDIDATES_MAX];
+                for (uint8_t j = 0; j < num_ends; j++) {
+                    margins[j] = FLT_MAX;
+                }
+                AP_OABendyRuler_Test::calc_margins_from_obstacles(pos_cm, ends, num_ends, obstacles, num_obstacles, margins);
+
+                for (uint8_t j = 0; j < num_ends; j++) {
+                    float expected = FLT_MAX;
+                    if (ends[j].NEU_ok) {
+                        IGNORE_RETURN(old_margin_from_object_database(obstacles, num_obstacles, pos_cm, ends[j].NEU_cm, expected));
+                    }
+                    EXPECT_EQ(margins[j], expected) << "obstacles " << num_obstacles << " path " << unsigned(j);
+                }
+            }
+        }
+    }
+}
+
+TEST(AP_OABendyRuler, AvoidanceMargins)
+{
+    // a concave inclusion polygon with a notch cut into its east side
+    static const Vector2f inclusion[] {
+        {-20000, -20000}, {20000, -20000}, {20000, -2000}, {5000, -1500},
+        {5000, 1500}, {20000, 2000}, {20000, 20000}, {-20000, 20000},
+    };
+    static const Vector2f exclusion1[] {{-8000, -8000}, {-4000, -8000}, {-4000, -4000}, {-8000, -4000}};
+    static const Vector2f exclusion2[] {{8000, 8000}, {12000, 9000}, {10000, 13000}};
+    const TestPolygon inclusions[] {{inclusion, ARRAY_SIZE(inclusion)}};
+    const TestPolygon exclusions[] {{exclusion1, ARRAY_SIZE(exclusion1)}, {exclusion2, ARRAY_SIZE(exclusion2)}};
+    const TestCircle inclusion_circles[] {{{0, 0}, 300}, {{1000, -500}, 250}};
+    const TestCircle exclusion_circles[] {{{-6000, 8000}, 20}, {{9000, -7000}, 35}};
+    AC_PolyFence_loader_Test::load(fence.polyfence(), inclusions, ARRAY_SIZE(inclusions), exclusions, ARRAY_SIZE(exclusions),
+                                   inclusion_circles, ARRAY_SIZE(inclusion_circles), exclusion_circles, ARRAY_SIZE(exclusion_circles), 1000);
+
+    const Location home {-353632620, 1491652370, 0, Location::AltFrame::ABOVE_HOME};
+    const float margin_ne_m = 2;
+    const float radius_m = 250;
+    const float safe_alt_max_m = 60;
+
+    static Obstacle obstacles[200];
+    PathPoint ends[OA_BENDYRULER_CANDIDATES_MAX];
+
+    AP_OABendyRuler_Test bendy;
+    bendy.set_fence(AC_FENCE_TYPE_CIRCLE | AC_FENCE_TYPE_POLYGON | AC_FENCE_TYPE_ALT_MAX, margin_ne_m, radius_m, safe_alt_max_m, home);
+    bendy.set_obstacles(obstacles, ARRAY_SIZE(obstacles));
+
+    // vehicle positions inside the fence, inside an exclusion polygon, in the
+    // notch and outside the inclusion polygon
+    const Vector3f positions[] {{0, 0, 1000}, {-6000, -6000, 2000}, {10000, 0, 500}, {-15000, 12000, 3000}, {25000, 0, 1000}};
+    for (const Vector3f &pos_cm : positions) {
+        Location vehicle = home;
+        vehicle.offset(pos_cm.x * 0.01f, pos_cm.y * 0.01f);
+        vehicle.set_alt_cm(int32_t(pos_cm.z), Location::AltFrame::ABOVE_HOME);
+        const PathPoint start = make_point(vehicle, pos_cm, Vector3f{});
+
+        make_obstacles(pos_cm, obstacles, ARRAY_SIZE(obstacles));
+        for (float lookahead_cm : {1500.0f, 8000.0f}) {
+            const uint8_t num_ends = make_paths(vehicle, pos_cm, lookahead_cm, ends);
+
+            for (bool proximity_only : {false, true}) {
+                float margins[OA_BENDYRULER_CANDIDATES_MAX];
+                bendy.calc_avoidance_margins(start, ends, num_ends, margins, proximity_only);
+                for (uint8_t j = 0; j < num_ends; j++) {
+                    const float expected = old_avoidance_margin(obstacles, ARRAY_SIZE(obstacles), home, radius_m, margin_ne_m, start, ends[j], proximity_only);
+                    EXPECT_EQ(margins[j], expected) << "path " << unsigned(j) << " proximity_only " << proximity_only;
+                }
+
+                // the same paths scored one at a time
+                for (uint8_t j = 0; j < num_ends; j++) {
+                    float margin;
+                    bendy.calc_avoidance_margins(start, &ends[j], 1, &margin, proximity_only);
+                    EXPECT_EQ(margin, margins[j]) << "path " << unsigned(j);
+                }
+            }
+
+            // the altitude fence, only used by vertical BendyRuler
+            float margins[OA_BENDYRULER_CANDIDATES_MAX];
+            for (uint8_t j = 0; j < num_ends; j++) {
+                margins[j] = FLT_MAX;
+            }
+            bendy.calc_margins_from_alt_fence(start, ends, num_ends, margins);
+            for (uint8_t j = 0; j < num_ends; j++) {
+                float expected = FLT_MAX;
+                IGNORE_RETURN(old_margin_from_alt_fence(safe_alt_max_m, start.loc, ends[j].loc, expected));
+                EXPECT_EQ(margins[j], expected) << "path " << unsigned(j);
+            }
+        }
+    }
+
+    AC_PolyFence_loader_Test::unload(fence.polyfence());
+}
+
+#endif  // AP_OAPATHPLANNER_BENDYRULER_ENABLED && AP_FENCE_ENABLED
+
+AP_GTEST_MAIN()
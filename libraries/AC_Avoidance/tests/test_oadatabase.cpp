@@ -0,0 +1,216 @@
+/*
+  check that the object database's spatial hash finds the same item as
+  a search of every item, and that the expiry wheel removes the same
+  items as a check of every item's age
+ */
+#include <AP_gtest.h>
+
+#include <AC_Avoidance/AC_Avoidance_config.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_OADATABASE_ENABLED
+
+#include <AC_Avoidance/AP_OADatabase.h>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+typedef AP_OADatabase::OA_DbItem OA_DbItem;
+
+class AP_OADatabase_Test
+{
+public:
+    static void init(AP_OADatabase &db, uint16_t size)
+    {
+        if (db.healthy()) {
+            return;
+        }
+        db._database_size_param.set(size);
+        db._queue_size_param.set(10);
+        db.init_database();
+        db.init_queue();
+    }
+
+    static void set_expiry(AP_OADatabase &db, int16_t expiry_seconds) { db._database_expiry_seconds.set(expiry_seconds); }
+
+    // add an item or refresh the item it matches, as process_queue() does
+    static void push(AP_OADatabase &db, const OA_DbItem &item)
+    {
+        uint16_t index;
+        if (db.database_item_find(item, index)) {
+            db.database_item_refresh(index, item);
+        } else {
+            db.database_item_add(item);
+        }
+    }
+
+    static bool find(const AP_OADatabase &db, const OA_DbItem &item, uint16_t &index) { return db.database_item_find(item, index); }
+
+    // find the lowest index matching item by checking every item
+    static bool find_all(const AP_OADatabase &db, const OA_DbItem &item, uint16_t &index)
+    {
+        for (uint16_t i = 0; i < db._database.count; i++) {
+            if (db.item_match(db._database.items[i], item)) {
+                index = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void remove(AP_OADatabase &db, uint16_t index) { db.database_item_remove(index); }
+    static void remove_expired(AP_OADatabase &db, uint32_t now_ms) { db.database_items_remove_all_expired(now_ms); }
+
+    static void remove_all(AP_OADatabase &db)
+    {
+        while (db._database.count > 0) {
+            db.database_item_remove(db._database.count - 1);
+        }
+    }
+};
+
+static AP_OADatabase db;
+
+static uint32_t rand_state = 1;
+
+static uint32_t rand_u32()
+{
+    rand_state = rand_state * 1664525U + 1013904223U;
+    return rand_state >> 8;
+}
+
+// uniformly distributed in [lo, hi)
+static float rand_float(float lo, float hi)
+{
+    return lo + (hi - lo) * (rand_u32() * (1.0f / (1U << 24)));
+}
+
+static OA_DbItem proximity_item(uint32_t timestamp_ms)
+{
+    OA_DbItem item {};
+    item.pos = Vector3f{rand_float(-100, 100), rand_float(-100, 100), rand_float(-5, 5)};
+    // mostly small, with some larger than a grid cell
+    item.radius = (rand_u32() % 10 == 0) ? rand_float(4, 12) : rand_float(0.1f, 2);
+    item.timestamp_ms = timestamp_ms;
+    item.source = OA_DbItem::Source::proximity;
+    return item;
+}
+
+static OA_DbItem ais_item(uint32_t timestamp_ms)
+{
+    OA_DbItem item {};
+    item.pos = Vector3f{rand_float(-1000, 1000), rand_float(-1000, 1000), 0};
+    item.radius = rand_float(10, 50);
+    item.timestamp_ms = timestamp_ms;
+    item.id = rand_u32() % 20;
+    item.source = OA_DbItem::Source::AIS;
+    return item;
+}
+
+struct ItemKey {
+    float x, y, radius;
+    uint32_t timestamp_ms;
+    bool operator<(const ItemKey &o) const {
+        return std::tie(x, y, radius, timestamp_ms) < std::tie(o.x, o.y, o.radius, o.timestamp_ms);
+    }
+    bool operator==(const ItemKey &o) const {
+        return x == o.x && y == o.y && radius == o.radius && timestamp_ms == o.timestamp_ms;
+    }
+};
+
+// the items in the database which have not expired at now_ms, sorted
+static std::vector<ItemKey> unexpired_items(uint32_t now_ms, uint32_t expiry_ms)
+{
+    std::vector<ItemKey> items;
+    for (uint16_t i = 0; i < db.database_count(); i++) {
+        const OA_DbItem &item = db.get_item(i);
+        if ((expiry_ms == 0) || (now_ms - item.timestamp_ms <= expiry_ms)) {
+            items.push_back({item.pos.x, item.pos.y, item.radius, item.timestamp_ms});
+        }
+    }
+    std::sort(items.begin(), items.end());
+    return items;
+}
+
+TEST(AP_OADatabase, HashLookup)
+{
+    AP_OADatabase_Test::init(db, 2000);
+    ASSERT_TRUE(db.healthy());
+    AP_OADatabase_Test::set_expiry(db, 0);
+
+    uint32_t now_ms = 1000;
+    uint16_t num_found = 0;
+    for (uint16_t step = 0; step < 5000; step++) {
+        now_ms += 10;
+        const OA_DbItem item = (step % 50 == 0) ? ais_item(now_ms) : proximity_item(now_ms);
+
+        uint16_t index = 0, index_all = 0;
+        const bool found = AP_OADatabase_Test::find(db, item, index);
+        const bool found_all = AP_OADatabase_Test::find_all(db, item, index_all);
+        ASSERT_EQ(found, found_all) << "step " << step;
+        if (found) {
+            EXPECT_EQ(index, index_all) << "step " << step;
+            num_found++;
+        }
+        AP_OADatabase_Test::push(db, item);
+
+        // remove some items so others are moved into their place
+        if (step % 4 == 0) {
+            AP_OADatabase_Test::remove(db, rand_u32() % db.database_count());
+        }
+    }
+    // both matches and new items were tested
+    EXPECT_GT(num_found, 500);
+    EXPECT_GT(db.database_count(), 500);
+
+    AP_OADatabase_Test::remove_all(db);
+}
+
+TEST(AP_OADatabase, WheelExpiry)
+{
+    AP_OADatabase_Test::init(db, 2000);
+    ASSERT_TRUE(db.healthy());
+
+    // start just before the system time wraps
+    uint32_t now_ms = UINT32_MAX - 30000;
+    int16_t expiry_seconds = 3;
+    AP_OADatabase_Test::set_expiry(db, expiry_seconds);
+
+    uint32_t num_expired = 0;
+    for (uint32_t step = 0; step < 10000; step++) {
+        now_ms += rand_u32() % 20;
+        if (step % 1000 == 999) {
+            // changing the expiry time rebuilds the wheel.  Zero disables expiry
+            expiry_seconds = rand_u32() % 5;
+            AP_OADatabase_Test::set_expiry(db, expiry_seconds);
+        }
+        if (step % 3000 == 1500) {
+            // a gap in updates longer than the wheel covers
+            now_ms += 20000;
+        }
+
+        // mostly recent measurements, some older than the oldest slot checked
+        const uint32_t age_ms = (rand_u32() % 20 == 0) ? rand_u32() % 8000 : rand_u32() % 100;
+        const OA_DbItem item = (step % 100 == 0) ? ais_item(now_ms - age_ms) : proximity_item(now_ms - age_ms);
+        AP_OADatabase_Test::push(db, item);
+
+        const uint32_t expiry_ms = uint32_t(expiry_seconds) * 1000;
+        const std::vector<ItemKey> expected = unexpired_items(now_ms, expiry_ms);
+        num_expired += db.database_count() - expected.size();
+
+        AP_OADatabase_Test::remove_expired(db, now_ms);
+        ASSERT_EQ(db.database_count(), expected.size()) << "step " << step;
+        ASSERT_EQ(unexpired_items(now_ms, 0), expected) << "step " << step;
+    }
+    // expiry was exercised, and the database did not fill
+    EXPECT_GT(num_expired, 5000U);
+    EXPECT_LT(db.database_count(), 2000);
+
+    AP_OADatabase_Test::remove_all(db);
+}
+
+#endif  // AP_OADATABASE_ENABLED
+
+AP_GTEST_MAIN()
@@ -0,0 +1,214 @@
+/*
+  check that the fence visibility graph built incrementally after a
+  fence reload is the same as one built from scratch, and that both
+  give the same shortest path
+ */
+#include <AP_gtest.h>
+
+#include <AC_Avoidance/AC_Avoidance_config.h>
+#include <AC_Fence/AC_Fence.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_OAPATHPLANNER_DIJKSTRA_ENABLED && AP_FENCE_ENABLED
+
+#include <AC_Avoidance/AP_OADijkstra.h>
+#include "polyfence_loader_test.h"
+
+static AC_Fence fence;
+
+class AP_OADijkstra_Test
+{
+public:
+    // allocated so its members start zeroed, as they do on the vehicle
+    AP_OADijkstra_Test() : dijkstra(NEW_NOTHROW AP_OADijkstra(options)) {}
+    ~AP_OADijkstra_Test() { delete dijkstra; }
+
+    CLASS_NO_COPY(AP_OADijkstra_Test);
+
+    // create the fence points and visgraph as AP_OADijkstra::update() does after a fence reload
+    bool update_fence()
+    {
+        AP_OADijkstra::AP_OADijkstra_Error err_id;
+        const float margin_cm = dijkstra->_polyfence_margin * 100.0f;
+        return dijkstra->create_inclusion_polygon_with_margin(margin_cm, err_id) &&
+               dijkstra->create_exclusion_polygon_with_margin(margin_cm, err_id) &&
+               dijkstra->create_exclusion_circle_with_margin(margin_cm, err_id) &&
+               dijkstra->create_fence_visgraph(err_id);
+    }
+
+    // number of fences whose points were carried over from the previous graph
+    uint16_t num_kept_fences() const
+    {
+        uint16_t count = 0;
+        for (uint16_t n = 0; n < dijkstra->_fence_items_num; n++) {
+            if (dijkstra->_fence_items[n].matched) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    uint16_t num_points() const { return dijkstra->total_numpoints(); }
+    uint16_t num_lines() const { return dijkstra->_fence_visgraph.num_items(); }
+
+    // true if the fence visgraph holds a line between points i and j, distance_cm is its length
+    bool has_line(uint8_t i, uint8_t j, float &distance_cm) const
+    {
+        const AP_OAVisGraph::OAItemID id_i {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i};
+        const AP_OAVisGraph::OAItemID id_j {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, j};
+        for (uint16_t k = 0; k < dijkstra->_fence_visgraph.num_items(); k++) {
+            const AP_OAVisGraph::VisGraphItem &item = dijkstra->_fence_visgraph[k];
+            if (((item.id1 == id_i) && (item.id2 == id_j)) || ((item.id1 == id_j) && (item.id2 == id_i))) {
+                distance_cm = item.distance_cm;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool point(uint16_t i, Vector2f &pos) const { return dijkstra->get_point(i, pos); }
+
+    bool shortest_path(const Vector2f &origin_cm, const Vector2f &destination_cm)
+    {
+        AP_OADijkstra::AP_OADijkstra_Error err_id;
+        return dijkstra->calc_shortest_path(origin_cm, destination_cm, err_id);
+    }
+    uint8_t path_numpoints() const { return dijkstra->get_shortest_path_numpoints(); }
+    bool path_point(uint8_t i, Vector2f &pos) const { return dijkstra->get_shortest_path_point(i, pos); }
+
+private:
+    AP_Int16 options;
+    AP_OADijkstra *dijkstra;
+};
+
+// a 2km wide octagon, and a 1.6km wide square for when the inclusion fence is changed
+static Vector2f octagon[8];
+static const Vector2f square[] {{-80000, -80000}, {80000, -80000}, {80000, 80000}, {-80000, 80000}};
+
+// candidate 100m exclusion squares in a rough grid, kept clear of the path ends below
+static Vector2f exclusions[9][4];
+
+static void make_fences()
+{
+    for (uint8_t i = 0; i < ARRAY_SIZE(octagon); i++) {
+        const float angle = radians(22.5f + 45.0f * i);
+        octagon[i] = Vector2f{cosf(angle), sinf(angle)} * 100000.0f;
+    }
+    const Vector2f centers[] {
+        {-50000, -48000}, {1000, -50000}, {50000, -52000},
+        {-49000, 2000}, {0, 0}, {51000, -1000},
+        {-50000, 50000}, {-2000, 49000}, {50000, 51000},
+    };
+    const Vector2f corners[] {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+    for (uint8_t i = 0; i < ARRAY_SIZE(centers); i++) {
+        for (uint8_t j = 0; j < 4; j++) {
+            exclusions[i][j] = centers[i] + corners[j] * 5000.0f;
+        }
+    }
+}
+
+// load the inclusion polygon and the exclusion squares selected by mask
+static void load_fences(const Vector2f *inclusion, uint8_t inclusion_count, uint16_t mask, uint32_t load_time_ms)
+{
+    const TestPolygon inclusions[] {{inclusion, inclusion_count}};
+    TestPolygon excl[ARRAY_SIZE(exclusions)];
+    uint8_t num_exclusions = 0;
+    for (uint8_t i = 0; i < ARRAY_SIZE(exclusions); i++) {
+        if ((mask & (1U << i)) != 0) {
+            excl[num_exclusions++] = {exclusions[i], 4};
+        }
+    }
+    AC_PolyFence_loader_Test::load(fence.polyfence(), inclusions, ARRAY_SIZE(inclusions), excl, num_exclusions,
+                                   nullptr, 0, nullptr, 0, load_time_ms);
+}
+
+TEST(AP_OADijkstra, IncrementalVisgraph)
+{
+    make_fences();
+
+    // each step reloads the fence, adding, removing or replacing exclusion zones
+    const struct {
+        bool octagon;
+        uint16_t mask;
+    } steps[] {
+        { true,  0x1FF },
+        { true,  0x1EF },   // the centre one removed
+        { true,  0x1AB },   // two more removed
+        { true,  0x1BB },   // the centre one added back
+        { true,  0x0D6 },   // several added and removed
+        { false, 0x0D6 },   // inclusion polygon changed
+        { false, 0x010 },
+        { true,  0x1FF },
+        { true,  0x1FF },   // reloaded unchanged
+    };
+
+    const Vector2f path_ends[][2] {
+        {{-62000, -62000}, {62000, 62000}},
+        {{-62000, 1000}, {62000, 5000}},
+        {{3000, -62000}, {-1000, 62000}},
+        {{62000, -62000}, {-62000, 62000}},
+    };
+
+    AP_OADijkstra_Test incremental;
+    for (uint8_t s = 0; s < ARRAY_SIZE(steps); s++) {
+        if (steps[s].octagon) {
+            load_fences(octagon, ARRAY_SIZE(octagon), steps[s].mask, 1000 * (s + 1));
+        } else {
+            load_fences(square, ARRAY_SIZE(square), steps[s].mask, 1000 * (s + 1));
+        }
+        ASSERT_TRUE(incremental.update_fence()) << "step " << unsigned(s);
+        if (s > 0) {
+            // unchanged fences have been carried over
+            EXPECT_GT(incremental.num_kept_fences(), 0) << "step " << unsigned(s);
+        }
+
+        AP_OADijkstra_Test full;
+        ASSERT_TRUE(full.update_fence()) << "step " << unsigned(s);
+        EXPECT_EQ(full.num_kept_fences(), 0);
+
+        // same points
+        ASSERT_EQ(incremental.num_points(), full.num_points()) << "step " << unsigned(s);
+        for (uint16_t i = 0; i < full.num_points(); i++) {
+            Vector2f inc_pos, full_pos;
+            ASSERT_TRUE(incremental.point(i, inc_pos));
+            ASSERT_TRUE(full.point(i, full_pos));
+            EXPECT_EQ(inc_pos, full_pos) << "step " << unsigned(s) << " point " << i;
+        }
+
+        // same lines between them
+        EXPECT_EQ(incremental.num_lines(), full.num_lines()) << "step " << unsigned(s);
+        for (uint16_t i = 0; i + 1 < full.num_points(); i++) {
+            for (uint16_t j = i + 1; j < full.num_points(); j++) {
+                float inc_dist = 0, full_dist = 0;
+                const bool inc_line = incremental.has_line(i, j, inc_dist);
+                const bool full_line = full.has_line(i, j, full_dist);
+                EXPECT_EQ(inc_line, full_line) << "step " << unsigned(s) << " line " << i << "-" << j;
+                if (inc_line && full_line) {
+                    EXPECT_FLOAT_EQ(inc_dist, full_dist);
+                }
+            }
+        }
+
+        // same shortest paths
+        for (const auto &ends : path_ends) {
+            const bool inc_ok = incremental.shortest_path(ends[0], ends[1]);
+            const bool full_ok = full.shortest_path(ends[0], ends[1]);
+            EXPECT_TRUE(full_ok) << "step " << unsigned(s);
+            ASSERT_EQ(inc_ok, full_ok) << "step " << unsigned(s);
+            ASSERT_EQ(incremental.path_numpoints(), full.path_numpoints()) << "step " << unsigned(s);
+            for (uint8_t i = 0; i < full.path_numpoints(); i++) {
+                Vector2f inc_pos, full_pos;
+                EXPECT_TRUE(incremental.path_point(i, inc_pos));
+                EXPECT_TRUE(full.path_point(i, full_pos));
+                EXPECT_EQ(inc_pos, full_pos) << "step " << unsigned(s) << " path point " << unsigned(i);
+            }
+        }
+    }
+
+    AC_PolyFence_loader_Test::unload(fence.polyfence());
+}
+
+#endif  // AP_OAPATHPLANNER_DIJKSTRA_ENABLED && AP_FENCE_ENABLED
+
+AP_GTEST_MAIN()
@@ -31,3 +31,9 @@
 #ifndef AC_POLYFENCE_CIRCLE_INT_SUPPORT_ENABLED
 #define AC_POLYFENCE_CIRCLE_INT_SUPPORT_ENABLED 1
 #endif  // AC_POLYFENCE_CIRCLE_INT_SUPPORT_ENABLED
+
+// index fence polygons so breach checks and path planning only test
+// the polygon edges near each query
+#ifndef AC_POLYFENCE_POLYGON_INDEX_ENABLED
+#define AC_POLYFENCE_POLYGON_INDEX_ENABLED (HAL_PROGRAM_SIZE_LIMIT_KB > 1024)
+#endif
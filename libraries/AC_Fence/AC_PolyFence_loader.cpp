@@ -227,6 +227,30 @@ bool AC_PolyFence_loader::breached() const
     return breached(loc);
 }
 
+// same as Polygon_outside(pos, boundary.points_lla, boundary.count), using the boundary's index if it has one
+template <typename Boundary>
+static bool boundary_outside(const Boundary &boundary, const Vector2l &pos)
+{
+#if AC_POLYFENCE_POLYGON_INDEX_ENABLED
+    if (boundary.points_lla_index.valid()) {
+        return boundary.points_lla_index.outside(pos);
+    }
+#endif
+    return Polygon_outside(pos, boundary.points_lla, boundary.count);
+}
+
+// same as Polygon_closest_distance_point(boundary.points, boundary.count, pos, closest), using the boundary's index if it has one
+template <typename Boundary>
+static bool boundary_closest_distance_point(const Boundary &boundary, const Vector2f &pos, Vector2f &closest)
+{
+#if AC_POLYFENCE_POLYGON_INDEX_ENABLED
+    if (boundary.points_index.valid()) {
+        return boundary.points_index.closest_distance_point(pos, closest);
+    }
+#endif
+    return Polygon_closest_distance_point(boundary.points, boundary.count, pos, closest);
+}
+
 // check if a position (expressed as lat/lng) is within the boundary
 //   returns true if location is outside the boundary
 bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_fence, Vector2f& fence_direction) const
@@ -248,9 +272,9 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
     // check we are inside each inclusion zone:
     for (uint8_t i=0; i<_num_loaded_inclusion_boundaries; i++) {
         const InclusionBoundary &boundary = _loaded_inclusion_boundary[i];
-        bool valid_distance = Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, fence_direction);
+        bool valid_distance = boundary_closest_distance_point(boundary, scaled_pos, fence_direction);
         float distance = fence_direction.length() * 0.01f; // convert back to meters
-        if (Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+        if (boundary_outside(boundary, pos)) {
             num_inclusion_outside++;
             if (valid_distance) {
                 if (is_positive(distance_outside_fence)) {
@@ -267,9 +291,9 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
     // check we are outside each exclusion zone:
     for (uint8_t i=0; i<_num_loaded_exclusion_boundaries; i++) {
         const ExclusionBoundary &boundary = _loaded_exclusion_boundary[i];
-        bool valid_distance = Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, fence_direction);
+        bool valid_distance = boundary_closest_distance_point(boundary, scaled_pos, fence_direction);
         float distance = fence_direction.length() * 0.01f; // convert back to meters
-        if (!Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+        if (!boundary_outside(boundary, pos)) {
             if (valid_distance) {
                 distance_outside_fence = distance;
             } else {
@@ -782,6 +806,11 @@ bool AC_PolyFence_loader::load_from_storage()
                 storage_valid = false;
                 break;
             }
+#if AC_POLYFENCE_POLYGON_INDEX_ENABLED
+            // queries fall back to checking every point if these fail
+            IGNORE_RETURN(boundary.points_index.init(boundary.points, boundary.count));
+            IGNORE_RETURN(boundary.points_lla_index.init(boundary.points_lla, boundary.count));
+#endif
             _num_loaded_inclusion_boundaries++;
             break;
         }
@@ -801,6 +830,11 @@ bool AC_PolyFence_loader::load_from_storage()
                 storage_valid = false;
                 break;
             }
+#if AC_POLYFENCE_POLYGON_INDEX_ENABLED
+            // queries fall back to checking every point if these fail
+            IGNORE_RETURN(boundary.points_index.init(boundary.points, boundary.count));
+            IGNORE_RETURN(boundary.points_lla_index.init(boundary.points_lla, boundary.count));
+#endif
             _num_loaded_exclusion_boundaries++;
             break;
         }
@@ -924,6 +958,17 @@ Vector2f* AC_PolyFence_loader::get_exclusion_polygon(uint16_t index, uint16_t &n
     return boundary.points;
 }
 
+/// returns the spatial index of an exclusion polygon's points, or nullptr if it is not indexed
+const AP_PolygonIndex<float>* AC_PolyFence_loader::get_exclusion_polygon_index(uint16_t index) const
+{
+#if AC_POLYFENCE_POLYGON_INDEX_ENABLED
+    if (index < _num_loaded_exclusion_boundaries && _loaded_exclusion_boundary[index].points_index.valid()) {
+        return &_loaded_exclusion_boundary[index].points_index;
+    }
+#endif
+    return nullptr;
+}
+
 /// returns pointer to array of inclusion polygon points and num_points is filled in with the number of points in the polygon
 /// points are offsets in cm from EKF origin in NE frame
 Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &num_points) const
@@ -938,6 +983,17 @@ Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &n
     return boundary.points;
 }
 
+/// returns the spatial index of an inclusion polygon's points, or nullptr if it is not indexed
+const AP_PolygonIndex<float>* AC_PolyFence_loader::get_inclusion_polygon_index(uint16_t index) const
+{
+#if AC_POLYFENCE_POLYGON_INDEX_ENABLED
+    if (index < _num_loaded_inclusion_boundaries && _loaded_inclusion_boundary[index].points_index.valid()) {
+        return &_loaded_inclusion_boundary[index].points_index;
+    }
+#endif
+    return nullptr;
+}
+
 /// returns the specified exclusion circle
 /// circle center offsets in cm from EKF origin in NE frame, radius is in meters
 bool AC_PolyFence_loader::get_exclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const
@@ -1696,6 +1752,8 @@ bool AC_PolyFence_loader::get_item(const uint16_t seq, AC_PolyFenceItem &item) {
 
 Vector2f* AC_PolyFence_loader::get_exclusion_polygon(uint16_t index, uint16_t &num_points) const { return nullptr; }
 Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &num_points) const { return nullptr; }
+const AP_PolygonIndex<float>* AC_PolyFence_loader::get_exclusion_polygon_index(uint16_t index) const { return nullptr; }
+const AP_PolygonIndex<float>* AC_PolyFence_loader::get_inclusion_polygon_index(uint16_t index) const { return nullptr; }
 
 bool AC_PolyFence_loader::get_exclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const { return false; }
 bool AC_PolyFence_loader::get_inclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const { return false; }
@@ -2,6 +2,7 @@
 
 #include "AC_Fence_config.h"
 #include <AP_Math/AP_Math.h>
+#include <AP_Math/AP_PolygonIndex.h>
 
 // CIRCLE_INCLUSION_INT stores the radius an a 32-bit integer in
 // metres.  This was a bug, and CIRCLE_INCLUSION was created to store
@@ -54,6 +55,7 @@ public:
 
 class AC_PolyFence_loader
 {
+    friend class AC_PolyFence_loader_Test;
 
 public:
 
@@ -83,6 +85,9 @@ public:
     /// points are offsets in cm from EKF origin in NE frame
     Vector2f* get_exclusion_polygon(uint16_t index, uint16_t &num_points) const;
 
+    /// returns the spatial index of an exclusion polygon's points, or nullptr if it is not indexed
+    const AP_PolygonIndex<float>* get_exclusion_polygon_index(uint16_t index) const;
+
     /// return system time of last update to the exclusion polygon points
     uint32_t get_exclusion_polygon_update_ms() const {
         return _load_time_ms;
@@ -100,6 +105,9 @@ public:
     /// points are offsets in cm from EKF origin in NE frame
     Vector2f* get_inclusion_polygon(uint16_t index, uint16_t &num_points) const;
 
+    /// returns the spatial index of an inclusion polygon's points, or nullptr if it is not indexed
+    const AP_PolygonIndex<float>* get_inclusion_polygon_index(uint16_t index) const;
+
     /// return system time of last update to the inclusion polygon points
     uint32_t get_inclusion_polygon_update_ms() const {
         return _load_time_ms;
@@ -307,6 +315,10 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla array
         uint8_t count; // count of points in the boundary
+#if AC_POLYFENCE_POLYGON_INDEX_ENABLED
+        AP_PolygonIndex<float> points_index; // index of points, invalid if it could not be allocated
+        AP_PolygonIndex<int32_t> points_lla_index; // index of points_lla, invalid if it could not be allocated
+#endif
     };
     InclusionBoundary *_loaded_inclusion_boundary;
 
@@ -317,6 +329,10 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla_lla array
         uint8_t count; // count of points in the boundary
+#if AC_POLYFENCE_POLYGON_INDEX_ENABLED
+        AP_PolygonIndex<float> points_index; // index of points, invalid if it could not be allocated
+        AP_PolygonIndex<int32_t> points_lla_index; // index of points_lla, invalid if it could not be allocated
+#endif
     };
     ExclusionBoundary *_loaded_exclusion_boundary;
 
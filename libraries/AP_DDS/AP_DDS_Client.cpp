@@ -42,6 +42,7 @@
 #include "AP_DDS_ExternalControl.h"
 #endif // AP_EXTERNAL_CONTROL_ENABLED
 #include "AP_DDS_Frames.h"
+#include "AP_DDS_Serialize.h"
 
 #include "AP_DDS_Client.h"
 #include "AP_DDS_Topic_Table.h"
@@ -52,39 +53,6 @@
 
 // Enable DDS at runtime by default
 static constexpr uint8_t ENABLED_BY_DEFAULT = 1;
-#if AP_DDS_TIME_PUB_ENABLED
-static constexpr uint16_t DELAY_TIME_TOPIC_MS = AP_DDS_DELAY_TIME_TOPIC_MS;
-#endif // AP_DDS_TIME_PUB_ENABLED
-#if AP_DDS_BATTERY_STATE_PUB_ENABLED
-static constexpr uint16_t DELAY_BATTERY_STATE_TOPIC_MS = AP_DDS_DELAY_BATTERY_STATE_TOPIC_MS;
-#endif // AP_DDS_BATTERY_STATE_PUB_ENABLED
-#if AP_DDS_IMU_PUB_ENABLED
-static constexpr uint16_t DELAY_IMU_TOPIC_MS = AP_DDS_DELAY_IMU_TOPIC_MS;
-#endif // AP_DDS_IMU_PUB_ENABLED
-#if AP_DDS_LOCAL_POSE_PUB_ENABLED
-static constexpr uint16_t DELAY_LOCAL_POSE_TOPIC_MS = AP_DDS_DELAY_LOCAL_POSE_TOPIC_MS;
-#endif // AP_DDS_LOCAL_POSE_PUB_ENABLED
-#if AP_DDS_LOCAL_VEL_PUB_ENABLED
-static constexpr uint16_t DELAY_LOCAL_VELOCITY_TOPIC_MS = AP_DDS_DELAY_LOCAL_VELOCITY_TOPIC_MS;
-#endif // AP_DDS_LOCAL_VEL_PUB_ENABLED
-#if AP_DDS_AIRSPEED_PUB_ENABLED
-static constexpr uint16_t DELAY_AIRSPEED_TOPIC_MS = AP_DDS_DELAY_AIRSPEED_TOPIC_MS;
-#endif // AP_DDS_AIRSPEED_PUB_ENABLED
-#if AP_DDS_RC_PUB_ENABLED
-static constexpr uint16_t DELAY_RC_TOPIC_MS = AP_DDS_DELAY_RC_TOPIC_MS;
-#endif // AP_DDS_RC_PUB_ENABLED
-#if AP_DDS_GEOPOSE_PUB_ENABLED
-static constexpr uint16_t DELAY_GEO_POSE_TOPIC_MS = AP_DDS_DELAY_GEO_POSE_TOPIC_MS;
-#endif // AP_DDS_GEOPOSE_PUB_ENABLED
-#if AP_DDS_GOAL_PUB_ENABLED
-static constexpr uint16_t DELAY_GOAL_TOPIC_MS = AP_DDS_DELAY_GOAL_TOPIC_MS ;
-#endif // AP_DDS_GOAL_PUB_ENABLED
-#if AP_DDS_CLOCK_PUB_ENABLED
-static constexpr uint16_t DELAY_CLOCK_TOPIC_MS =AP_DDS_DELAY_CLOCK_TOPIC_MS;
-#endif // AP_DDS_CLOCK_PUB_ENABLED
-#if AP_DDS_GPS_GLOBAL_ORIGIN_PUB_ENABLED
-static constexpr uint16_t DELAY_GPS_GLOBAL_ORIGIN_TOPIC_MS = AP_DDS_DELAY_GPS_GLOBAL_ORIGIN_TOPIC_MS;
-#endif // AP_DDS_GPS_GLOBAL_ORIGIN_PUB_ENABLED
 static constexpr uint16_t DELAY_PING_MS = 500;
 #if AP_DDS_STATUS_PUB_ENABLED
 static constexpr uint16_t DELAY_STATUS_TOPIC_MS = AP_DDS_DELAY_STATUS_TOPIC_MS;
@@ -117,6 +85,8 @@ rcl_interfaces_srv_GetParameters_Response AP_DDS_Client::get_parameters_response
 rcl_interfaces_msg_Parameter AP_DDS_Client::param {};
 #endif
 
+#define PUB_INDEX(x) static_cast<uint8_t>(Publisher::x)
+
 const AP_Param::GroupInfo AP_DDS_Client::var_info[] {
 
     // @Param: _ENABLE
@@ -169,10 +139,309 @@ const AP_Param::GroupInfo AP_DDS_Client::var_info[] {
     // @User: Standard
     AP_GROUPINFO("_MAX_RETRY", 6, AP_DDS_Client, ping_max_retry, 10),
 
+    // @Param: _MAX_BPS
+    // @DisplayName: DDS bandwidth budget
+    // @Description: Maximum bytes per second published by DDS. Topics which would exceed the budget are skipped, lowest priority first. Set to 0 to use the serial baud rate, or no limit on UDP.
+    // @Units: B/s
+    // @Range: 0 10000000
+    // @User: Advanced
+    AP_GROUPINFO("_MAX_BPS", 7, AP_DDS_Client, max_bytes_per_second, 0),
+
+#if AP_DDS_TIME_PUB_ENABLED
+    // @Param: _TIME_RATE
+    // @DisplayName: DDS time rate
+    // @Description: Rate at which the time topic is published. Set to 0 to disable the topic.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("_TIME_RATE", 8, AP_DDS_Client, pub_rate_hz[PUB_INDEX(TIME)], 1000 / AP_DDS_DELAY_TIME_TOPIC_MS),
+
+    // @Param: _TIME_PRI
+    // @DisplayName: DDS time priority
+    // @Description: Priority of the time topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_TIME_PRI", 9, AP_DDS_Client, pub_priority[PUB_INDEX(TIME)], 6),
+#endif // AP_DDS_TIME_PUB_ENABLED
+
+#if AP_DDS_NAVSATFIX_PUB_ENABLED
+    // @Param: _NAVSAT_RATE
+    // @DisplayName: DDS NavSatFix rate
+    // @Description: Rate at which the NavSatFix topic is published. Set to -1 to publish each new GPS fix as soon as it arrives, or 0 to disable the topic.
+    // @Units: Hz
+    // @Range: -1 1000
+    // @User: Advanced
+    AP_GROUPINFO("_NAVSAT_RATE", 10, AP_DDS_Client, pub_rate_hz[PUB_INDEX(NAV_SAT_FIX)], AP_DDS_DELAY_NAV_SAT_FIX_TOPIC_MS > 0 ? 1000 / AP_DDS_DELAY_NAV_SAT_FIX_TOPIC_MS : -1),
+
+    // @Param: _NAVSAT_PRI
+    // @DisplayName: DDS NavSatFix priority
+    // @Description: Priority of the NavSatFix topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_NAVSAT_PRI", 11, AP_DDS_Client, pub_priority[PUB_INDEX(NAV_SAT_FIX)], 5),
+#endif // AP_DDS_NAVSATFIX_PUB_ENABLED
+
+#if AP_DDS_BATTERY_STATE_PUB_ENABLED
+    // @Param: _BATT_RATE
+    // @DisplayName: DDS battery state rate
+    // @Description: Rate at which the battery state topic is published. Set to 0 to disable the topic.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("_BATT_RATE", 12, AP_DDS_Client, pub_rate_hz[PUB_INDEX(BATTERY_STATE)], 1000 / AP_DDS_DELAY_BATTERY_STATE_TOPIC_MS),
+
+    // @Param: _BATT_PRI
+    // @DisplayName: DDS battery state priority
+    // @Description: Priority of the battery state topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_BATT_PRI", 13, AP_DDS_Client, pub_priority[PUB_INDEX(BATTERY_STATE)], 2),
+#endif // AP_DDS_BATTERY_STATE_PUB_ENABLED
+
+#if AP_DDS_LOCAL_POSE_PUB_ENABLED
+    // @Param: _POSE_RATE
+    // @DisplayName: DDS local pose rate
+    // @Description: Rate at which the local pose topic is published. Set to 0 to disable the topic.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("_POSE_RATE", 14, AP_DDS_Client, pub_rate_hz[PUB_INDEX(LOCAL_POSE)], 1000 / AP_DDS_DELAY_LOCAL_POSE_TOPIC_MS),
+
+    // @Param: _POSE_PRI
+    // @DisplayName: DDS local pose priority
+    // @Description: Priority of the local pose topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_POSE_PRI", 15, AP_DDS_Client, pub_priority[PUB_INDEX(LOCAL_POSE)], 8),
+#endif // AP_DDS_LOCAL_POSE_PUB_ENABLED
+
+#if AP_DDS_LOCAL_VEL_PUB_ENABLED
+    // @Param: _TWIST_RATE
+    // @DisplayName: DDS local velocity rate
+    // @Description: Rate at which the local velocity topic is published. Set to 0 to disable the topic.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("_TWIST_RATE", 16, AP_DDS_Client, pub_rate_hz[PUB_INDEX(LOCAL_VELOCITY)], 1000 / AP_DDS_DELAY_LOCAL_VELOCITY_TOPIC_MS),
+
+    // @Param: _TWIST_PRI
+    // @DisplayName: DDS local velocity priority
+    // @Description: Priority of the local velocity topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_TWIST_PRI", 17, AP_DDS_Client, pub_priority[PUB_INDEX(LOCAL_VELOCITY)], 8),
+#endif // AP_DDS_LOCAL_VEL_PUB_ENABLED
+
+#if AP_DDS_AIRSPEED_PUB_ENABLED
+    // @Param: _ASPD_RATE
+    // @DisplayName: DDS airspeed rate
+    // @Description: Rate at which the airspeed topic is published. Set to 0 to disable the topic.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("_ASPD_RATE", 18, AP_DDS_Client, pub_rate_hz[PUB_INDEX(AIRSPEED)], 1000 / AP_DDS_DELAY_AIRSPEED_TOPIC_MS),
+
+    // @Param: _ASPD_PRI
+    // @DisplayName: DDS airspeed priority
+    // @Description: Priority of the airspeed topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_ASPD_PRI", 19, AP_DDS_Client, pub_priority[PUB_INDEX(AIRSPEED)], 4),
+#endif // AP_DDS_AIRSPEED_PUB_ENABLED
+
+#if AP_DDS_RC_PUB_ENABLED
+    // @Param: _RC_RATE
+    // @DisplayName: DDS RC rate
+    // @Description: Rate at which the RC topic is published. Set to 0 to disable the topic.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("_RC_RATE", 20, AP_DDS_Client, pub_rate_hz[PUB_INDEX(RC)], 1000 / AP_DDS_DELAY_RC_TOPIC_MS),
+
+    // @Param: _RC_PRI
+    // @DisplayName: DDS RC priority
+    // @Description: Priority of the RC topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_RC_PRI", 21, AP_DDS_Client, pub_priority[PUB_INDEX(RC)], 4),
+#endif // AP_DDS_RC_PUB_ENABLED
+
+#if AP_DDS_IMU_PUB_ENABLED
+    // @Param: _IMU_RATE
+    // @DisplayName: DDS IMU rate
+    // @Description: Rate at which the IMU topic is published. Set to 0 to disable the topic.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("_IMU_RATE", 22, AP_DDS_Client, pub_rate_hz[PUB_INDEX(IMU)], 1000 / AP_DDS_DELAY_IMU_TOPIC_MS),
+
+    // @Param: _IMU_PRI
+    // @DisplayName: DDS IMU priority
+    // @Description: Priority of the IMU topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_IMU_PRI", 23, AP_DDS_Client, pub_priority[PUB_INDEX(IMU)], 9),
+#endif // AP_DDS_IMU_PUB_ENABLED
+
+#if AP_DDS_GEOPOSE_PUB_ENABLED
+    // @Param: _GEOPOSE_RATE
+    // @DisplayName: DDS GeoPose rate
+    // @Description: Rate at which the GeoPose topic is published. Set to 0 to disable the topic.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("_GEOPOSE_RATE", 24, AP_DDS_Client, pub_rate_hz[PUB_INDEX(GEO_POSE)], 1000 / AP_DDS_DELAY_GEO_POSE_TOPIC_MS),
+
+    // @Param: _GEOPOSE_PRI
+    // @DisplayName: DDS GeoPose priority
+    // @Description: Priority of the GeoPose topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_GEOPOSE_PRI", 25, AP_DDS_Client, pub_priority[PUB_INDEX(GEO_POSE)], 7),
+#endif // AP_DDS_GEOPOSE_PUB_ENABLED
+
+#if AP_DDS_CLOCK_PUB_ENABLED
+    // @Param: _CLOCK_RATE
+    // @DisplayName: DDS clock rate
+    // @Description: Rate at which the clock topic is published. Set to 0 to disable the topic.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("_CLOCK_RATE", 26, AP_DDS_Client, pub_rate_hz[PUB_INDEX(CLOCK)], 1000 / AP_DDS_DELAY_CLOCK_TOPIC_MS),
+
+    // @Param: _CLOCK_PRI
+    // @DisplayName: DDS clock priority
+    // @Description: Priority of the clock topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_CLOCK_PRI", 27, AP_DDS_Client, pub_priority[PUB_INDEX(CLOCK)], 6),
+#endif // AP_DDS_CLOCK_PUB_ENABLED
+
+#if AP_DDS_GPS_GLOBAL_ORIGIN_PUB_ENABLED
+    // @Param: _ORIGIN_RATE
+    // @DisplayName: DDS GPS global origin rate
+    // @Description: Rate at which the GPS global origin topic is published. Set to 0 to disable the topic.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("_ORIGIN_RATE", 28, AP_DDS_Client, pub_rate_hz[PUB_INDEX(GPS_GLOBAL_ORIGIN)], 1000 / AP_DDS_DELAY_GPS_GLOBAL_ORIGIN_TOPIC_MS),
+
+    // @Param: _ORIGIN_PRI
+    // @DisplayName: DDS GPS global origin priority
+    // @Description: Priority of the GPS global origin topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_ORIGIN_PRI", 29, AP_DDS_Client, pub_priority[PUB_INDEX(GPS_GLOBAL_ORIGIN)], 1),
+#endif // AP_DDS_GPS_GLOBAL_ORIGIN_PUB_ENABLED
+
+#if AP_DDS_GOAL_PUB_ENABLED
+    // @Param: _GOAL_RATE
+    // @DisplayName: DDS goal rate
+    // @Description: Rate at which the goal topic is published. Set to 0 to disable the topic.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("_GOAL_RATE", 30, AP_DDS_Client, pub_rate_hz[PUB_INDEX(GOAL)], 1000 / AP_DDS_DELAY_GOAL_TOPIC_MS),
+
+    // @Param: _GOAL_PRI
+    // @DisplayName: DDS goal priority
+    // @Description: Priority of the goal topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_GOAL_PRI", 31, AP_DDS_Client, pub_priority[PUB_INDEX(GOAL)], 3),
+#endif // AP_DDS_GOAL_PUB_ENABLED
+
+#if AP_DDS_STATUS_PUB_ENABLED
+    // @Param: _STATUS_RATE
+    // @DisplayName: DDS status rate
+    // @Description: Rate at which the status topic is published. Set to 0 to disable the topic.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("_STATUS_RATE", 32, AP_DDS_Client, pub_rate_hz[PUB_INDEX(STATUS)], 1000 / AP_DDS_DELAY_STATUS_TOPIC_MS),
+
+    // @Param: _STATUS_PRI
+    // @DisplayName: DDS status priority
+    // @Description: Priority of the status topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_STATUS_PRI", 33, AP_DDS_Client, pub_priority[PUB_INDEX(STATUS)], 5),
+#endif // AP_DDS_STATUS_PUB_ENABLED
+
+#if AP_DDS_TOPIC_STATUS_PUB_ENABLED
+    // @Param: _TSTAT_RATE
+    // @DisplayName: DDS topic status rate
+    // @Description: Rate at which the topic status topic is published. Set to 0 to disable the topic.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("_TSTAT_RATE", 34, AP_DDS_Client, pub_rate_hz[PUB_INDEX(TOPIC_STATUS)], 1000 / AP_DDS_DELAY_TOPIC_STATUS_TOPIC_MS),
+
+    // @Param: _TSTAT_PRI
+    // @DisplayName: DDS topic status priority
+    // @Description: Priority of the topic status topic. When several topics are due at once, or the bandwidth budget is exceeded, higher priority topics are published first.
+    // @Range: 0 9
+    // @User: Advanced
+    AP_GROUPINFO("_TSTAT_PRI", 35, AP_DDS_Client, pub_priority[PUB_INDEX(TOPIC_STATUS)], 0),
+#endif // AP_DDS_TOPIC_STATUS_PUB_ENABLED
+
     AP_GROUPEND
 };
 
-#if AP_DDS_STATIC_TF_PUB_ENABLED | AP_DDS_LOCAL_POSE_PUB_ENABLED | AP_DDS_GEOPOSE_PUB_ENABLED | AP_DDS_IMU_PUB_ENABLED
+struct AP_DDS_Client::Publish_table {
+    Publisher id;
+    TopicIndex topic;
+    void (AP_DDS_Client::*publish)();
+};
+
+// topics run by the scheduler, in the order they are published when
+// of equal priority
+const struct AP_DDS_Client::Publish_table AP_DDS_Client::publishers[] = {
+#if AP_DDS_TIME_PUB_ENABLED
+    { Publisher::TIME, TopicIndex::TIME_PUB, &AP_DDS_Client::publish_time },
+#endif // AP_DDS_TIME_PUB_ENABLED
+#if AP_DDS_NAVSATFIX_PUB_ENABLED
+    { Publisher::NAV_SAT_FIX, TopicIndex::NAV_SAT_FIX_PUB, &AP_DDS_Client::publish_nav_sat_fix },
+#endif // AP_DDS_NAVSATFIX_PUB_ENABLED
+#if AP_DDS_BATTERY_STATE_PUB_ENABLED
+    { Publisher::BATTERY_STATE, TopicIndex::BATTERY_STATE_PUB, &AP_DDS_Client::publish_battery_state },
+#endif // AP_DDS_BATTERY_STATE_PUB_ENABLED
+#if AP_DDS_LOCAL_POSE_PUB_ENABLED
+    { Publisher::LOCAL_POSE, TopicIndex::LOCAL_POSE_PUB, &AP_DDS_Client::publish_local_pose },
+#endif // AP_DDS_LOCAL_POSE_PUB_ENABLED
+#if AP_DDS_LOCAL_VEL_PUB_ENABLED
+    { Publisher::LOCAL_VELOCITY, TopicIndex::LOCAL_VELOCITY_PUB, &AP_DDS_Client::publish_local_velocity },
+#endif // AP_DDS_LOCAL_VEL_PUB_ENABLED
+#if AP_DDS_AIRSPEED_PUB_ENABLED
+    { Publisher::AIRSPEED, TopicIndex::LOCAL_AIRSPEED_PUB, &AP_DDS_Client::publish_airspeed },
+#endif // AP_DDS_AIRSPEED_PUB_ENABLED
+#if AP_DDS_RC_PUB_ENABLED
+    { Publisher::RC, TopicIndex::LOCAL_RC_PUB, &AP_DDS_Client::publish_rc },
+#endif // AP_DDS_RC_PUB_ENABLED
+#if AP_DDS_IMU_PUB_ENABLED
+    { Publisher::IMU, TopicIndex::IMU_PUB, &AP_DDS_Client::publish_imu },
+#endif // AP_DDS_IMU_PUB_ENABLED
+#if AP_DDS_GEOPOSE_PUB_ENABLED
+    { Publisher::GEO_POSE, TopicIndex::GEOPOSE_PUB, &AP_DDS_Client::publish_geo_pose },
+#endif // AP_DDS_GEOPOSE_PUB_ENABLED
+#if AP_DDS_CLOCK_PUB_ENABLED
+    { Publisher::CLOCK, TopicIndex::CLOCK_PUB, &AP_DDS_Client::publish_clock },
+#endif // AP_DDS_CLOCK_PUB_ENABLED
+#if AP_DDS_GPS_GLOBAL_ORIGIN_PUB_ENABLED
+    { Publisher::GPS_GLOBAL_ORIGIN, TopicIndex::GPS_GLOBAL_ORIGIN_PUB, &AP_DDS_Client::publish_gps_global_origin },
+#endif // AP_DDS_GPS_GLOBAL_ORIGIN_PUB_ENABLED
+#if AP_DDS_GOAL_PUB_ENABLED
+    { Publisher::GOAL, TopicIndex::GOAL_PUB, &AP_DDS_Client::publish_goal },
+#endif // AP_DDS_GOAL_PUB_ENABLED
+#if AP_DDS_STATUS_PUB_ENABLED
+    { Publisher::STATUS, TopicIndex::STATUS_PUB, &AP_DDS_Client::publish_status },
+#endif // AP_DDS_STATUS_PUB_ENABLED
+#if AP_DDS_TOPIC_STATUS_PUB_ENABLED
+    { Publisher::TOPIC_STATUS, TopicIndex::TOPIC_STATUS_PUB, &AP_DDS_Client::publish_topic_status },
+#endif // AP_DDS_TOPIC_STATUS_PUB_ENABLED
+};
+
+#if AP_DDS_STATIC_TF_PUB_ENABLED | AP_DDS_GEOPOSE_PUB_ENABLED
 static void initialize(geometry_msgs_msg_Quaternion& q)
 {
     q.x = 0.0;
@@ -180,7 +449,7 @@ static void initialize(geometry_msgs_msg_Quaternion& q)
     q.z = 0.0;
     q.w = 1.0;
 }
-#endif // AP_DDS_STATIC_TF_PUB_ENABLED | AP_DDS_LOCAL_POSE_PUB_ENABLED | AP_DDS_GEOPOSE_PUB_ENABLED | AP_DDS_IMU_PUB_ENABLED
+#endif // AP_DDS_STATIC_TF_PUB_ENABLED | AP_DDS_GEOPOSE_PUB_ENABLED
 
 AP_DDS_Client::~AP_DDS_Client()
 {
@@ -410,10 +679,23 @@ void AP_DDS_Client::update_topic(sensor_msgs_msg_BatteryState& msg, const uint8_
 #endif // AP_DDS_BATTERY_STATE_PUB_ENABLED
 
 #if AP_DDS_LOCAL_POSE_PUB_ENABLED
-void AP_DDS_Client::update_topic(geometry_msgs_msg_PoseStamped& msg)
+/*
+  serialize the local pose straight into the output stream
+ */
+void AP_DDS_Client::write_local_pose_topic()
 {
-    update_topic(msg.header.stamp);
-    STRCPY(msg.header.frame_id, BASE_LINK_FRAME_ID);
+    WITH_SEMAPHORE(csem);
+    if (!connected) {
+        return;
+    }
+    ucdrBuffer ub {};
+    constexpr uint32_t topic_size = AP_DDS_Serialize::pose_stamped_size(BASE_LINK_FRAME_ID);
+    if (prepare_output_stream(topics[to_underlying(TopicIndex::LOCAL_POSE_PUB)].dw_id, &ub, topic_size) == UXR_INVALID_REQUEST_ID) {
+        return;
+    }
+    builtin_interfaces_msg_Time stamp;
+    update_topic(stamp);
+    AP_DDS_Serialize::header(&ub, stamp, BASE_LINK_FRAME_ID);
 
     auto &ahrs = AP::ahrs();
     WITH_SEMAPHORE(ahrs.get_semaphore());
@@ -432,10 +714,9 @@ void AP_DDS_Client::update_topic(geometry_msgs_msg_PoseStamped& msg)
 
     Vector3f position;
     if (ahrs.get_relative_position_NED_home(position)) {
-        msg.pose.position.x = position[1];
-        msg.pose.position.y = position[0];
-        msg.pose.position.z = -position[2];
+        local_position_enu = Vector3f{position[1], position[0], -position[2]};
     }
+    AP_DDS_Serialize::vector3(&ub, local_position_enu.x, local_position_enu.y, local_position_enu.z);
 
     // In ROS REP 103, axis orientation uses the following convention:
     // X - Forward
@@ -450,21 +731,31 @@ void AP_DDS_Client::update_topic(geometry_msgs_msg_PoseStamped& msg)
         Quaternion aux(orientation[0], orientation[2], orientation[1], -orientation[3]); //NED to ENU transformation
         Quaternion transformation (sqrtF(2) * 0.5,0,0,sqrtF(2) * 0.5); // Z axis 90 degree rotation
         orientation = aux * transformation;
-        msg.pose.orientation.w = orientation[0];
-        msg.pose.orientation.x = orientation[1];
-        msg.pose.orientation.y = orientation[2];
-        msg.pose.orientation.z = orientation[3];
+        AP_DDS_Serialize::quaternion(&ub, orientation[1], orientation[2], orientation[3], orientation[0]);
     } else {
-        initialize(msg.pose.orientation);
+        AP_DDS_Serialize::quaternion(&ub, 0, 0, 0, 1);
     }
 }
 #endif // AP_DDS_LOCAL_POSE_PUB_ENABLED
 
 #if AP_DDS_LOCAL_VEL_PUB_ENABLED
-void AP_DDS_Client::update_topic(geometry_msgs_msg_TwistStamped& msg)
+/*
+  serialize the local velocity straight into the output stream
+ */
+void AP_DDS_Client::write_tx_local_velocity_topic()
 {
-    update_topic(msg.header.stamp);
-    STRCPY(msg.header.frame_id, BASE_LINK_FRAME_ID);
+    WITH_SEMAPHORE(csem);
+    if (!connected) {
+        return;
+    }
+    ucdrBuffer ub {};
+    constexpr uint32_t topic_size = AP_DDS_Serialize::twist_stamped_size(BASE_LINK_FRAME_ID);
+    if (prepare_output_stream(topics[to_underlying(TopicIndex::LOCAL_VELOCITY_PUB)].dw_id, &ub, topic_size) == UXR_INVALID_REQUEST_ID) {
+        return;
+    }
+    builtin_interfaces_msg_Time stamp;
+    update_topic(stamp);
+    AP_DDS_Serialize::header(&ub, stamp, BASE_LINK_FRAME_ID);
 
     auto &ahrs = AP::ahrs();
     WITH_SEMAPHORE(ahrs.get_semaphore());
@@ -482,10 +773,9 @@ void AP_DDS_Client::update_topic(geometry_msgs_msg_TwistStamped& msg)
     // as well as invert Z
     Vector3f velocity;
     if (ahrs.get_velocity_NED(velocity)) {
-        msg.twist.linear.x = velocity[1];
-        msg.twist.linear.y = velocity[0];
-        msg.twist.linear.z = -velocity[2];
+        local_velocity_enu = Vector3f{velocity[1], velocity[0], -velocity[2]};
     }
+    AP_DDS_Serialize::vector3(&ub, local_velocity_enu.x, local_velocity_enu.y, local_velocity_enu.z);
 
     // In ROS REP 103, axis orientation uses the following convention:
     // X - Forward
@@ -497,10 +787,8 @@ void AP_DDS_Client::update_topic(geometry_msgs_msg_TwistStamped& msg)
     // Y - Right
     // Z - Down
     // As a consequence, to follow ROS REP 103, it is necessary to invert Y and Z
-    Vector3f angular_velocity = ahrs.get_gyro();
-    msg.twist.angular.x = angular_velocity[0];
-    msg.twist.angular.y = -angular_velocity[1];
-    msg.twist.angular.z = -angular_velocity[2];
+    const Vector3f &angular_velocity = ahrs.get_gyro();
+    AP_DDS_Serialize::vector3(&ub, angular_velocity[0], -angular_velocity[1], -angular_velocity[2]);
 }
 #endif // AP_DDS_LOCAL_VEL_PUB_ENABLED
 #if AP_DDS_AIRSPEED_PUB_ENABLED
@@ -640,10 +928,23 @@ bool AP_DDS_Client::update_topic_goal(geographic_msgs_msg_GeoPointStamped& msg)
 #endif // AP_DDS_GOAL_PUB_ENABLED
 
 #if AP_DDS_IMU_PUB_ENABLED
-void AP_DDS_Client::update_topic(sensor_msgs_msg_Imu& msg)
+/*
+  serialize the IMU data straight into the output stream
+ */
+void AP_DDS_Client::write_imu_topic()
 {
-    update_topic(msg.header.stamp);
-    STRCPY(msg.header.frame_id, BASE_LINK_NED_FRAME_ID);
+    WITH_SEMAPHORE(csem);
+    if (!connected) {
+        return;
+    }
+    ucdrBuffer ub {};
+    constexpr uint32_t topic_size = AP_DDS_Serialize::imu_size(BASE_LINK_NED_FRAME_ID);
+    if (prepare_output_stream(topics[to_underlying(TopicIndex::IMU_PUB)].dw_id, &ub, topic_size) == UXR_INVALID_REQUEST_ID) {
+        return;
+    }
+    builtin_interfaces_msg_Time stamp;
+    update_topic(stamp);
+    AP_DDS_Serialize::header(&ub, stamp, BASE_LINK_NED_FRAME_ID);
 
     auto &imu = AP::ins();
     auto &ahrs = AP::ahrs();
@@ -652,27 +953,21 @@ void AP_DDS_Client::update_topic(sensor_msgs_msg_Imu& msg)
 
     Quaternion orientation;
     if (ahrs.get_quaternion(orientation)) {
-        msg.orientation.x = orientation[0];
-        msg.orientation.y = orientation[1];
-        msg.orientation.z = orientation[2];
-        msg.orientation.w = orientation[3];
+        AP_DDS_Serialize::quaternion(&ub, orientation[0], orientation[1], orientation[2], orientation[3]);
     } else {
-        initialize(msg.orientation);
+        AP_DDS_Serialize::quaternion(&ub, 0, 0, 0, 1);
     }
+    AP_DDS_Serialize::zero_covariance(&ub);
 
     uint8_t accel_index = ahrs.get_primary_accel_index();
     uint8_t gyro_index = ahrs.get_primary_gyro_index();
-    const Vector3f accel_data = imu.get_accel(accel_index);
-    const Vector3f gyro_data = imu.get_gyro(gyro_index);
+    const Vector3f &accel_data = imu.get_accel(accel_index);
+    const Vector3f &gyro_data = imu.get_gyro(gyro_index);
 
-    // Populate the message fields
-    msg.linear_acceleration.x = accel_data.x;
-    msg.linear_acceleration.y = accel_data.y;
-    msg.linear_acceleration.z = accel_data.z;
-
-    msg.angular_velocity.x = gyro_data.x;
-    msg.angular_velocity.y = gyro_data.y;
-    msg.angular_velocity.z = gyro_data.z;
+    AP_DDS_Serialize::vector3(&ub, gyro_data.x, gyro_data.y, gyro_data.z);
+    AP_DDS_Serialize::zero_covariance(&ub);
+    AP_DDS_Serialize::vector3(&ub, accel_data.x, accel_data.y, accel_data.z);
+    AP_DDS_Serialize::zero_covariance(&ub);
 }
 #endif // AP_DDS_IMU_PUB_ENABLED
 
@@ -1266,6 +1561,7 @@ void AP_DDS_Client::main_loop(void)
             return;
         }
         connected = true;
+        reset_publishers();
         GCS_SEND_TEXT(MAV_SEVERITY_INFO, "%s Initialization passed", msg_prefix);
 
 #if AP_DDS_STATIC_TF_PUB_ENABLED
@@ -1544,7 +1840,7 @@ void AP_DDS_Client::write_time_topic()
     if (connected) {
         ucdrBuffer ub {};
         const uint32_t topic_size = builtin_interfaces_msg_Time_size_of_topic(&time_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::TIME_PUB)].dw_id, &ub, topic_size);
+        prepare_output_stream(topics[to_underlying(TopicIndex::TIME_PUB)].dw_id, &ub, topic_size);
         const bool success = builtin_interfaces_msg_Time_serialize_topic(&ub, &time_topic);
         if (!success) {
             // TODO sometimes serialization fails on bootup. Determine why.
@@ -1560,7 +1856,7 @@ void AP_DDS_Client::write_nav_sat_fix_topic()
     if (connected) {
         ucdrBuffer ub {};
         const uint32_t topic_size = sensor_msgs_msg_NavSatFix_size_of_topic(&nav_sat_fix_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::NAV_SAT_FIX_PUB)].dw_id, &ub, topic_size);
+        prepare_output_stream(topics[to_underlying(TopicIndex::NAV_SAT_FIX_PUB)].dw_id, &ub, topic_size);
         const bool success = sensor_msgs_msg_NavSatFix_serialize_topic(&ub, &nav_sat_fix_topic);
         if (!success) {
             // TODO sometimes serialization fails on bootup. Determine why.
@@ -1577,7 +1873,7 @@ void AP_DDS_Client::write_static_transforms()
     if (connected) {
         ucdrBuffer ub {};
         const uint32_t topic_size = tf2_msgs_msg_TFMessage_size_of_topic(&tx_static_transforms_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::STATIC_TRANSFORMS_PUB)].dw_id, &ub, topic_size);
+        prepare_output_stream(topics[to_underlying(TopicIndex::STATIC_TRANSFORMS_PUB)].dw_id, &ub, topic_size);
         const bool success = tf2_msgs_msg_TFMessage_serialize_topic(&ub, &tx_static_transforms_topic);
         if (!success) {
             // TODO sometimes serialization fails on bootup. Determine why.
@@ -1594,7 +1890,7 @@ void AP_DDS_Client::write_battery_state_topic()
     if (connected) {
         ucdrBuffer ub {};
         const uint32_t topic_size = sensor_msgs_msg_BatteryState_size_of_topic(&battery_state_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::BATTERY_STATE_PUB)].dw_id, &ub, topic_size);
+        prepare_output_stream(topics[to_underlying(TopicIndex::BATTERY_STATE_PUB)].dw_id, &ub, topic_size);
         const bool success = sensor_msgs_msg_BatteryState_serialize_topic(&ub, &battery_state_topic);
         if (!success) {
             // TODO sometimes serialization fails on bootup. Determine why.
@@ -1604,39 +1900,6 @@ void AP_DDS_Client::write_battery_state_topic()
 }
 #endif // AP_DDS_BATTERY_STATE_PUB_ENABLED
 
-#if AP_DDS_LOCAL_POSE_PUB_ENABLED
-void AP_DDS_Client::write_local_pose_topic()
-{
-    WITH_SEMAPHORE(csem);
-    if (connected) {
-        ucdrBuffer ub {};
-        const uint32_t topic_size = geometry_msgs_msg_PoseStamped_size_of_topic(&local_pose_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::LOCAL_POSE_PUB)].dw_id, &ub, topic_size);
-        const bool success = geometry_msgs_msg_PoseStamped_serialize_topic(&ub, &local_pose_topic);
-        if (!success) {
-            // TODO sometimes serialization fails on bootup. Determine why.
-            // AP_HAL::panic("FATAL: DDS_Client failed to serialize");
-        }
-    }
-}
-#endif // AP_DDS_LOCAL_POSE_PUB_ENABLED
-
-#if AP_DDS_LOCAL_VEL_PUB_ENABLED
-void AP_DDS_Client::write_tx_local_velocity_topic()
-{
-    WITH_SEMAPHORE(csem);
-    if (connected) {
-        ucdrBuffer ub {};
-        const uint32_t topic_size = geometry_msgs_msg_TwistStamped_size_of_topic(&tx_local_velocity_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::LOCAL_VELOCITY_PUB)].dw_id, &ub, topic_size);
-        const bool success = geometry_msgs_msg_TwistStamped_serialize_topic(&ub, &tx_local_velocity_topic);
-        if (!success) {
-            // TODO sometimes serialization fails on bootup. Determine why.
-            // AP_HAL::panic("FATAL: DDS_Client failed to serialize");
-        }
-    }
-}
-#endif // AP_DDS_LOCAL_VEL_PUB_ENABLED
 #if AP_DDS_AIRSPEED_PUB_ENABLED
 void AP_DDS_Client::write_tx_local_airspeed_topic()
 {
@@ -1644,7 +1907,7 @@ void AP_DDS_Client::write_tx_local_airspeed_topic()
     if (connected) {
         ucdrBuffer ub {};
         const uint32_t topic_size = ardupilot_msgs_msg_Airspeed_size_of_topic(&tx_local_airspeed_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::LOCAL_AIRSPEED_PUB)].dw_id, &ub, topic_size);
+        prepare_output_stream(topics[to_underlying(TopicIndex::LOCAL_AIRSPEED_PUB)].dw_id, &ub, topic_size);
         const bool success = ardupilot_msgs_msg_Airspeed_serialize_topic(&ub, &tx_local_airspeed_topic);
         if (!success) {
             // TODO sometimes serialization fails on bootup. Determine why.
@@ -1660,7 +1923,7 @@ void AP_DDS_Client::write_tx_local_rc_topic()
     if (connected) {
         ucdrBuffer ub {};
         const uint32_t topic_size = ardupilot_msgs_msg_Rc_size_of_topic(&tx_local_rc_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::LOCAL_RC_PUB)].dw_id, &ub, topic_size);
+        prepare_output_stream(topics[to_underlying(TopicIndex::LOCAL_RC_PUB)].dw_id, &ub, topic_size);
         const bool success = ardupilot_msgs_msg_Rc_serialize_topic(&ub, &tx_local_rc_topic);
         if (!success) {
             // TODO sometimes serialization fails on bootup. Determine why.
@@ -1669,23 +1932,6 @@ void AP_DDS_Client::write_tx_local_rc_topic()
     }
 }
 #endif // AP_DDS_RC_PUB_ENABLED
-#if AP_DDS_IMU_PUB_ENABLED
-void AP_DDS_Client::write_imu_topic()
-{
-    WITH_SEMAPHORE(csem);
-    if (connected) {
-        ucdrBuffer ub {};
-        const uint32_t topic_size = sensor_msgs_msg_Imu_size_of_topic(&imu_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::IMU_PUB)].dw_id, &ub, topic_size);
-        const bool success = sensor_msgs_msg_Imu_serialize_topic(&ub, &imu_topic);
-        if (!success) {
-            // TODO sometimes serialization fails on bootup. Determine why.
-            // AP_HAL::panic("FATAL: DDS_Client failed to serialize");
-        }
-    }
-}
-#endif // AP_DDS_IMU_PUB_ENABLED
-
 #if AP_DDS_GEOPOSE_PUB_ENABLED
 void AP_DDS_Client::write_geo_pose_topic()
 {
@@ -1693,7 +1939,7 @@ void AP_DDS_Client::write_geo_pose_topic()
     if (connected) {
         ucdrBuffer ub {};
         const uint32_t topic_size = geographic_msgs_msg_GeoPoseStamped_size_of_topic(&geo_pose_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::GEOPOSE_PUB)].dw_id, &ub, topic_size);
+        prepare_output_stream(topics[to_underlying(TopicIndex::GEOPOSE_PUB)].dw_id, &ub, topic_size);
         const bool success = geographic_msgs_msg_GeoPoseStamped_serialize_topic(&ub, &geo_pose_topic);
         if (!success) {
             // TODO sometimes serialization fails on bootup. Determine why.
@@ -1710,7 +1956,7 @@ void AP_DDS_Client::write_clock_topic()
     if (connected) {
         ucdrBuffer ub {};
         const uint32_t topic_size = rosgraph_msgs_msg_Clock_size_of_topic(&clock_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::CLOCK_PUB)].dw_id, &ub, topic_size);
+        prepare_output_stream(topics[to_underlying(TopicIndex::CLOCK_PUB)].dw_id, &ub, topic_size);
         const bool success = rosgraph_msgs_msg_Clock_serialize_topic(&ub, &clock_topic);
         if (!success) {
             // TODO sometimes serialization fails on bootup. Determine why.
@@ -1727,7 +1973,7 @@ void AP_DDS_Client::write_gps_global_origin_topic()
     if (connected) {
         ucdrBuffer ub {};
         const uint32_t topic_size = geographic_msgs_msg_GeoPointStamped_size_of_topic(&gps_global_origin_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::GPS_GLOBAL_ORIGIN_PUB)].dw_id, &ub, topic_size);
+        prepare_output_stream(topics[to_underlying(TopicIndex::GPS_GLOBAL_ORIGIN_PUB)].dw_id, &ub, topic_size);
         const bool success = geographic_msgs_msg_GeoPointStamped_serialize_topic(&ub, &gps_global_origin_topic);
         if (!success) {
             // AP_HAL::panic("FATAL: DDS_Client failed to serialize");
@@ -1743,7 +1989,7 @@ void AP_DDS_Client::write_goal_topic()
     if (connected) {
         ucdrBuffer ub {};
         const uint32_t topic_size = geographic_msgs_msg_GeoPointStamped_size_of_topic(&goal_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::GOAL_PUB)].dw_id, &ub, topic_size);
+        prepare_output_stream(topics[to_underlying(TopicIndex::GOAL_PUB)].dw_id, &ub, topic_size);
         const bool success = geographic_msgs_msg_GeoPointStamped_serialize_topic(&ub, &goal_topic);
         if (!success) {
             // AP_HAL::panic("FATAL: DDS_Client failed to serialize");
@@ -1759,7 +2005,7 @@ void AP_DDS_Client::write_status_topic()
     if (connected) {
         ucdrBuffer ub {};
         const uint32_t topic_size = ardupilot_msgs_msg_Status_size_of_topic(&status_topic, 0);
-        uxr_prepare_output_stream(&session, reliable_out, topics[to_underlying(TopicIndex::STATUS_PUB)].dw_id, &ub, topic_size);
+        prepare_output_stream(topics[to_underlying(TopicIndex::STATUS_PUB)].dw_id, &ub, topic_size);
         const bool success = ardupilot_msgs_msg_Status_serialize_topic(&ub, &status_topic);
         if (!success) {
             // TODO sometimes serialization fails on bootup. Determine why.
@@ -1769,111 +2015,325 @@ void AP_DDS_Client::write_status_topic()
 }
 #endif // AP_DDS_STATUS_PUB_ENABLED
 
-void AP_DDS_Client::update()
+#if AP_DDS_TOPIC_STATUS_PUB_ENABLED
+void AP_DDS_Client::write_topic_status_topic()
 {
     WITH_SEMAPHORE(csem);
-    const auto cur_time_ms = AP_HAL::millis64();
+    if (connected) {
+        ucdrBuffer ub {};
+        const uint32_t topic_size = ardupilot_msgs_msg_TopicStatus_size_of_topic(&topic_status_topic, 0);
+        prepare_output_stream(topics[to_underlying(TopicIndex::TOPIC_STATUS_PUB)].dw_id, &ub, topic_size);
+        const bool success = ardupilot_msgs_msg_TopicStatus_serialize_topic(&ub, &topic_status_topic);
+        if (!success) {
+            // AP_HAL::panic("FATAL: DDS_Client failed to serialize");
+        }
+    }
+}
+#endif // AP_DDS_TOPIC_STATUS_PUB_ENABLED
 
-#if AP_DDS_TIME_PUB_ENABLED
-    if (cur_time_ms - last_time_time_ms > DELAY_TIME_TOPIC_MS) {
-        update_topic(time_topic);
-        last_time_time_ms = cur_time_ms;
-        write_time_topic();
+/*
+  prepare the reliable output stream for a sample. The size is
+  counted against the topic being published by run_publishers()
+ */
+uint16_t AP_DDS_Client::prepare_output_stream(const uxrObjectId &dw_id, ucdrBuffer *ub, uint32_t topic_size)
+{
+    const uint16_t request_id = uxr_prepare_output_stream(&session, reliable_out, dw_id, ub, topic_size);
+    if (request_id == UXR_INVALID_REQUEST_ID) {
+        // the sample doesn't fit in the output stream
+        stream_failed = true;
+    } else {
+        stream_bytes += topic_size;
     }
+    return request_id;
+}
+
+#if AP_DDS_TIME_PUB_ENABLED
+void AP_DDS_Client::publish_time()
+{
+    update_topic(time_topic);
+    write_time_topic();
+}
 #endif // AP_DDS_TIME_PUB_ENABLED
+
 #if AP_DDS_NAVSATFIX_PUB_ENABLED
+void AP_DDS_Client::publish_nav_sat_fix()
+{
     for (uint8_t gps_instance = 0; gps_instance < GPS_MAX_INSTANCES; gps_instance++) {
         if (update_topic(nav_sat_fix_topic, gps_instance)) {
             write_nav_sat_fix_topic();
         }
     }
+}
 #endif // AP_DDS_NAVSATFIX_PUB_ENABLED
+
 #if AP_DDS_BATTERY_STATE_PUB_ENABLED
-    if (cur_time_ms - last_battery_state_time_ms > DELAY_BATTERY_STATE_TOPIC_MS) {
-        for (uint8_t battery_instance = 0; battery_instance < AP_BATT_MONITOR_MAX_INSTANCES; battery_instance++) {
-            update_topic(battery_state_topic, battery_instance);
-            if (battery_state_topic.present) {
-                write_battery_state_topic();
-            }
+void AP_DDS_Client::publish_battery_state()
+{
+    for (uint8_t battery_instance = 0; battery_instance < AP_BATT_MONITOR_MAX_INSTANCES; battery_instance++) {
+        update_topic(battery_state_topic, battery_instance);
+        if (battery_state_topic.present) {
+            write_battery_state_topic();
         }
-        last_battery_state_time_ms = cur_time_ms;
     }
+}
 #endif // AP_DDS_BATTERY_STATE_PUB_ENABLED
+
 #if AP_DDS_LOCAL_POSE_PUB_ENABLED
-    if (cur_time_ms - last_local_pose_time_ms > DELAY_LOCAL_POSE_TOPIC_MS) {
-        update_topic(local_pose_topic);
-        last_local_pose_time_ms = cur_time_ms;
-        write_local_pose_topic();
-    }
+void AP_DDS_Client::publish_local_pose()
+{
+    write_local_pose_topic();
+}
 #endif // AP_DDS_LOCAL_POSE_PUB_ENABLED
+
 #if AP_DDS_LOCAL_VEL_PUB_ENABLED
-    if (cur_time_ms - last_local_velocity_time_ms > DELAY_LOCAL_VELOCITY_TOPIC_MS) {
-        update_topic(tx_local_velocity_topic);
-        last_local_velocity_time_ms = cur_time_ms;
-        write_tx_local_velocity_topic();
-    }
+void AP_DDS_Client::publish_local_velocity()
+{
+    write_tx_local_velocity_topic();
+}
 #endif // AP_DDS_LOCAL_VEL_PUB_ENABLED
+
 #if AP_DDS_AIRSPEED_PUB_ENABLED
-    if (cur_time_ms - last_airspeed_time_ms > DELAY_AIRSPEED_TOPIC_MS) {
-        last_airspeed_time_ms = cur_time_ms;
-        if (update_topic(tx_local_airspeed_topic)) {
-            write_tx_local_airspeed_topic();
-        }
+void AP_DDS_Client::publish_airspeed()
+{
+    if (update_topic(tx_local_airspeed_topic)) {
+        write_tx_local_airspeed_topic();
     }
+}
 #endif // AP_DDS_AIRSPEED_PUB_ENABLED
+
 #if AP_DDS_RC_PUB_ENABLED
-    if (cur_time_ms - last_rc_time_ms > DELAY_RC_TOPIC_MS) {
-        last_rc_time_ms = cur_time_ms;
-        if (update_topic(tx_local_rc_topic)) {
-            write_tx_local_rc_topic();
-        }
+void AP_DDS_Client::publish_rc()
+{
+    if (update_topic(tx_local_rc_topic)) {
+        write_tx_local_rc_topic();
     }
+}
 #endif // AP_DDS_RC_PUB_ENABLED
+
 #if AP_DDS_IMU_PUB_ENABLED
-    if (cur_time_ms - last_imu_time_ms > DELAY_IMU_TOPIC_MS) {
-        update_topic(imu_topic);
-        last_imu_time_ms = cur_time_ms;
-        write_imu_topic();
-    }
+void AP_DDS_Client::publish_imu()
+{
+    write_imu_topic();
+}
 #endif // AP_DDS_IMU_PUB_ENABLED
+
 #if AP_DDS_GEOPOSE_PUB_ENABLED
-    if (cur_time_ms - last_geo_pose_time_ms > DELAY_GEO_POSE_TOPIC_MS) {
-        update_topic(geo_pose_topic);
-        last_geo_pose_time_ms = cur_time_ms;
-        write_geo_pose_topic();
-    }
+void AP_DDS_Client::publish_geo_pose()
+{
+    update_topic(geo_pose_topic);
+    write_geo_pose_topic();
+}
 #endif // AP_DDS_GEOPOSE_PUB_ENABLED
+
 #if AP_DDS_CLOCK_PUB_ENABLED
-    if (cur_time_ms - last_clock_time_ms > DELAY_CLOCK_TOPIC_MS) {
-        update_topic(clock_topic);
-        last_clock_time_ms = cur_time_ms;
-        write_clock_topic();
-    }
+void AP_DDS_Client::publish_clock()
+{
+    update_topic(clock_topic);
+    write_clock_topic();
+}
 #endif // AP_DDS_CLOCK_PUB_ENABLED
+
 #if AP_DDS_GPS_GLOBAL_ORIGIN_PUB_ENABLED
-    if (cur_time_ms - last_gps_global_origin_time_ms > DELAY_GPS_GLOBAL_ORIGIN_TOPIC_MS) {
-        update_topic(gps_global_origin_topic);
-        last_gps_global_origin_time_ms = cur_time_ms;
-        write_gps_global_origin_topic();
-    }
+void AP_DDS_Client::publish_gps_global_origin()
+{
+    update_topic(gps_global_origin_topic);
+    write_gps_global_origin_topic();
+}
 #endif // AP_DDS_GPS_GLOBAL_ORIGIN_PUB_ENABLED
+
 #if AP_DDS_GOAL_PUB_ENABLED
-    if (cur_time_ms - last_goal_time_ms > DELAY_GOAL_TOPIC_MS) {
-        if (update_topic_goal(goal_topic)) {
-            write_goal_topic();
-        }
-        last_goal_time_ms = cur_time_ms;
+void AP_DDS_Client::publish_goal()
+{
+    if (update_topic_goal(goal_topic)) {
+        write_goal_topic();
     }
+}
 #endif // AP_DDS_GOAL_PUB_ENABLED
+
 #if AP_DDS_STATUS_PUB_ENABLED
-    if (cur_time_ms - last_status_check_time_ms > DELAY_STATUS_TOPIC_MS) {
-        if (update_topic(status_topic)) {
-            write_status_topic();
-        }
-        last_status_check_time_ms = cur_time_ms;
+void AP_DDS_Client::publish_status()
+{
+    if (update_topic(status_topic)) {
+        write_status_topic();
     }
+}
 #endif // AP_DDS_STATUS_PUB_ENABLED
 
+#if AP_DDS_TOPIC_STATUS_PUB_ENABLED
+/*
+  publish the statistics of each of the other scheduled topics
+ */
+void AP_DDS_Client::publish_topic_status()
+{
+    update_topic(topic_status_topic.header.stamp);
+    for (const auto &p : publishers) {
+        if (p.id == Publisher::TOPIC_STATUS) {
+            continue;
+        }
+        const uint8_t i = static_cast<uint8_t>(p.id);
+        const auto &state = pub_state[i];
+        // skip the "rt/" prefix to give the ROS topic name
+        STRCPY(topic_status_topic.topic, topics[to_underlying(p.topic)].topic_name + 3);
+        topic_status_topic.requested_rate = MAX(pub_rate_hz[i].get(), 0);
+        topic_status_topic.achieved_rate = state.achieved_rate_hz;
+        topic_status_topic.published = state.published;
+        topic_status_topic.dropped = state.dropped;
+        topic_status_topic.bytes = state.bytes;
+        write_topic_status_topic();
+    }
+}
+#endif // AP_DDS_TOPIC_STATUS_PUB_ENABLED
+
+/*
+  bandwidth budget in bytes per second, 0 for no limit
+ */
+uint32_t AP_DDS_Client::bandwidth_limit() const
+{
+    if (max_bytes_per_second > 0) {
+        return max_bytes_per_second;
+    }
+    if (is_using_serial && serial.port != nullptr) {
+        // 10 bits per byte on the wire
+        return serial.port->get_baud_rate() / 10;
+    }
+    return 0;
+}
+
+/*
+  add tokens for the time since the last update and remove the bytes
+  which have been written to the transport since then
+ */
+void AP_DDS_Client::update_bandwidth(uint64_t now_ms)
+{
+    const uint32_t limit = bandwidth_limit();
+    const uint32_t dt_ms = MIN(now_ms - bw_last_ms, 1000U);
+    bw_last_ms = now_ms;
+
+    // allow a burst of up to 100ms of bandwidth, or one full packet
+    // on slow links
+    const int32_t max_tokens = MAX(limit / 10, uint32_t(DDS_MTU));
+    const int32_t tokens = bw_tokens + int32_t(uint64_t(limit) * dt_ms / 1000) - int32_t(transport_tx_bytes);
+    bw_tokens = MIN(tokens, max_tokens);
+    transport_tx_bytes = 0;
+}
+
+/*
+  reset the schedule and statistics at the start of a session
+ */
+void AP_DDS_Client::reset_publishers()
+{
+    const uint64_t now_ms = AP_HAL::millis64();
+    const uint64_t now_us = AP_HAL::micros64();
+    memset(pub_state, 0, sizeof(pub_state));
+    for (auto &state : pub_state) {
+        state.next_us = now_us;
+    }
+    rate_window_start_ms = now_ms;
+    bw_tokens = MAX(bandwidth_limit() / 10, uint32_t(DDS_MTU));
+    bw_last_ms = now_ms;
+    transport_tx_bytes = 0;
+}
+
+/*
+  publish the topics which are due, highest priority first. Topics
+  which will be due within a quarter of their period are published
+  early so that they share a flush of the output stream with the
+  topics which are due now. Topics with a negative rate are run on
+  every update and publish whenever they have new data
+ */
+void AP_DDS_Client::run_publishers(uint64_t now_us)
+{
+    bool any_due = false;
+    for (const auto &p : publishers) {
+        const uint8_t i = static_cast<uint8_t>(p.id);
+        if (pub_rate_hz[i] > 0 && now_us >= pub_state[i].next_us) {
+            any_due = true;
+            break;
+        }
+    }
+
+    uint8_t order[ARRAY_SIZE(publishers)];
+    uint8_t n = 0;
+    for (uint8_t t=0; t<ARRAY_SIZE(publishers); t++) {
+        const uint8_t i = static_cast<uint8_t>(publishers[t].id);
+        const int16_t rate_hz = pub_rate_hz[i];
+        if (rate_hz == 0) {
+            continue;
+        }
+        if (rate_hz > 0) {
+            const uint32_t period_us = 1000000U / rate_hz;
+            if (!any_due || now_us + MIN(period_us / 4, 5000U) < pub_state[i].next_us) {
+                continue;
+            }
+        }
+        // insertion sort by priority, keeping table order for equal priorities
+        const int8_t priority = pub_priority[i];
+        uint8_t j = n++;
+        while (j > 0 && pub_priority[static_cast<uint8_t>(publishers[order[j-1]].id)] < priority) {
+            order[j] = order[j-1];
+            j--;
+        }
+        order[j] = t;
+    }
+
+    const uint32_t limit = bandwidth_limit();
+    int32_t pending = 0;
+    for (uint8_t k=0; k<n; k++) {
+        const Publish_table &p = publishers[order[k]];
+        auto &state = pub_state[static_cast<uint8_t>(p.id)];
+        const int16_t rate_hz = pub_rate_hz[static_cast<uint8_t>(p.id)];
+
+        if (rate_hz > 0) {
+            // samples which have been missed completely are dropped
+            const uint32_t period_us = 1000000U / rate_hz;
+            state.next_us += period_us;
+            if (state.next_us <= now_us) {
+                const uint64_t missed = (now_us - state.next_us) / period_us + 1;
+                state.dropped += missed;
+                state.next_us += missed * period_us;
+            }
+        }
+
+        if (limit != 0 && bw_tokens - pending < int32_t(state.last_size)) {
+            // over budget, leave the bandwidth for higher priority topics
+            state.dropped++;
+            continue;
+        }
+
+        stream_bytes = 0;
+        stream_failed = false;
+        (this->*p.publish)();
+        if (stream_failed) {
+            state.dropped++;
+        }
+        if (stream_bytes > 0) {
+            state.published++;
+            state.window_published++;
+            state.bytes += stream_bytes;
+            state.last_size = MIN(stream_bytes, uint32_t(UINT16_MAX));
+            pending += stream_bytes;
+        }
+    }
+
+    const uint64_t now_ms = now_us / 1000;
+    const uint32_t window_ms = now_ms - rate_window_start_ms;
+    if (window_ms >= 1000) {
+        for (auto &state : pub_state) {
+            state.achieved_rate_hz = state.window_published * 1000.0f / window_ms;
+            state.window_published = 0;
+        }
+        rate_window_start_ms = now_ms;
+    }
+}
+
+void AP_DDS_Client::update()
+{
+    WITH_SEMAPHORE(csem);
+    const uint64_t now_us = AP_HAL::micros64();
+
+    update_bandwidth(now_us / 1000);
+    run_publishers(now_us);
+
     status_ok = uxr_run_session_time(&session, 1);
 }
 
@@ -23,18 +23,15 @@
 #if AP_DDS_BATTERY_STATE_PUB_ENABLED
 #include "sensor_msgs/msg/BatteryState.h"
 #endif // AP_DDS_BATTERY_STATE_PUB_ENABLED
-#if AP_DDS_IMU_PUB_ENABLED
-#include "sensor_msgs/msg/Imu.h"
-#endif // AP_DDS_IMU_PUB_ENABLED
 #if AP_DDS_STATUS_PUB_ENABLED
 #include "ardupilot_msgs/msg/Status.h"
 #endif // AP_DDS_STATUS_PUB_ENABLED
+#if AP_DDS_TOPIC_STATUS_PUB_ENABLED
+#include "ardupilot_msgs/msg/TopicStatus.h"
+#endif // AP_DDS_TOPIC_STATUS_PUB_ENABLED
 #if AP_DDS_JOY_SUB_ENABLED
 #include "sensor_msgs/msg/Joy.h"
 #endif // AP_DDS_JOY_SUB_ENABLED
-#if AP_DDS_LOCAL_POSE_PUB_ENABLED
-#include "geometry_msgs/msg/PoseStamped.h"
-#endif // AP_DDS_LOCAL_POSE_PUB_ENABLED
 #if AP_DDS_NEEDS_TWIST
 #include "geometry_msgs/msg/TwistStamped.h"
 #endif // AP_DDS_NEEDS_TWIST
@@ -102,8 +99,6 @@ private:
 
 #if AP_DDS_TIME_PUB_ENABLED
     builtin_interfaces_msg_Time time_topic;
-    // The last ms timestamp AP_DDS wrote a Time message
-    uint64_t last_time_time_ms;
     //! @brief Serialize the current time state and publish to the IO stream(s)
     void write_time_topic();
     static void update_topic(builtin_interfaces_msg_Time& msg);
@@ -111,8 +106,6 @@ private:
 
 #if AP_DDS_GPS_GLOBAL_ORIGIN_PUB_ENABLED
     geographic_msgs_msg_GeoPointStamped gps_global_origin_topic;
-    // The last ms timestamp AP_DDS wrote a gps global origin message
-    uint64_t last_gps_global_origin_time_ms;
     //! @brief Serialize the current gps global origin and publish to the IO stream(s)
     void write_gps_global_origin_topic();
     static void update_topic(geographic_msgs_msg_GeoPointStamped& msg);
@@ -120,8 +113,6 @@ private:
 
 #if AP_DDS_GOAL_PUB_ENABLED
     geographic_msgs_msg_GeoPointStamped goal_topic;
-    // The last ms timestamp AP_DDS wrote a goal message
-    uint64_t last_goal_time_ms;
     //! @brief Serialize the current goal and publish to the IO stream(s)
     void write_goal_topic();
     bool update_topic_goal(geographic_msgs_msg_GeoPointStamped& msg);
@@ -130,35 +121,27 @@ private:
 
 #if AP_DDS_GEOPOSE_PUB_ENABLED
     geographic_msgs_msg_GeoPoseStamped geo_pose_topic;
-    // The last ms timestamp AP_DDS wrote a GeoPose message
-    uint64_t last_geo_pose_time_ms;
     //! @brief Serialize the current geo_pose and publish to the IO stream(s)
     void write_geo_pose_topic();
     static void update_topic(geographic_msgs_msg_GeoPoseStamped& msg);
 #endif // AP_DDS_GEOPOSE_PUB_ENABLED
 
 #if AP_DDS_LOCAL_POSE_PUB_ENABLED
-    geometry_msgs_msg_PoseStamped local_pose_topic;
-    // The last ms timestamp AP_DDS wrote a Local Pose message
-    uint64_t last_local_pose_time_ms;
+    // position kept from the last sample when the AHRS has none
+    Vector3f local_position_enu;
     //! @brief Serialize the current local_pose and publish to the IO stream(s)
     void write_local_pose_topic();
-    static void update_topic(geometry_msgs_msg_PoseStamped& msg);
 #endif // AP_DDS_LOCAL_POSE_PUB_ENABLED
 
 #if AP_DDS_LOCAL_VEL_PUB_ENABLED
-    geometry_msgs_msg_TwistStamped tx_local_velocity_topic;
-    // The last ms timestamp AP_DDS wrote a Local Velocity message
-    uint64_t last_local_velocity_time_ms;
+    // velocity kept from the last sample when the AHRS has none
+    Vector3f local_velocity_enu;
     //! @brief Serialize the current local velocity and publish to the IO stream(s)
     void write_tx_local_velocity_topic();
-    static void update_topic(geometry_msgs_msg_TwistStamped& msg);
 #endif // AP_DDS_LOCAL_VEL_PUB_ENABLED
 
 #if AP_DDS_AIRSPEED_PUB_ENABLED
     ardupilot_msgs_msg_Airspeed tx_local_airspeed_topic;
-    // The last ms timestamp AP_DDS wrote a airspeed message
-    uint64_t last_airspeed_time_ms;
     //! @brief Serialize the current local airspeed and publish to the IO stream(s)
     void write_tx_local_airspeed_topic();
     static bool update_topic(ardupilot_msgs_msg_Airspeed& msg);
@@ -166,8 +149,6 @@ private:
 
 #if AP_DDS_RC_PUB_ENABLED
     ardupilot_msgs_msg_Rc tx_local_rc_topic;
-    // The last ms timestamp AP_DDS wrote a rc message
-    uint64_t last_rc_time_ms;
     //! @brief Serialize the current local rc and publish to the IO stream(s)
     void write_tx_local_rc_topic();
     static bool update_topic(ardupilot_msgs_msg_Rc& msg);
@@ -175,8 +156,6 @@ private:
 
 #if AP_DDS_BATTERY_STATE_PUB_ENABLED
     sensor_msgs_msg_BatteryState battery_state_topic;
-    // The last ms timestamp AP_DDS wrote a BatteryState message
-    uint64_t last_battery_state_time_ms;
     //! @brief Serialize the current nav_sat_fix state and publish it to the IO stream(s)
     void write_battery_state_topic();
     static void update_topic(sensor_msgs_msg_BatteryState& msg, const uint8_t instance);
@@ -192,18 +171,12 @@ private:
 #endif // AP_DDS_NAVSATFIX_PUB_ENABLED
 
 #if AP_DDS_IMU_PUB_ENABLED
-    sensor_msgs_msg_Imu imu_topic;
-    // The last ms timestamp AP_DDS wrote an IMU message
-    uint64_t last_imu_time_ms;
-    static void update_topic(sensor_msgs_msg_Imu& msg);
     //! @brief Serialize the current IMU data and publish to the IO stream(s)
     void write_imu_topic();
 #endif // AP_DDS_IMU_PUB_ENABLED
 
 #if AP_DDS_CLOCK_PUB_ENABLED
     rosgraph_msgs_msg_Clock clock_topic;
-    // The last ms timestamp AP_DDS wrote a Clock message
-    uint64_t last_clock_time_ms;
     //! @brief Serialize the current clock and publish to the IO stream(s)
     void write_clock_topic();
     static void update_topic(rosgraph_msgs_msg_Clock& msg);
@@ -212,8 +185,7 @@ private:
 #if AP_DDS_STATUS_PUB_ENABLED
     ardupilot_msgs_msg_Status status_topic;
     bool update_topic(ardupilot_msgs_msg_Status& msg);
-    // The last ms timestamps AP_DDS wrote/checked/published a status message
-    uint64_t last_status_check_time_ms;
+    // The last ms timestamp AP_DDS published a status message
     uint64_t last_status_publish_time_ms;
     // last status values;
     ardupilot_msgs_msg_Status last_status_msg_;
@@ -221,6 +193,120 @@ private:
     void write_status_topic();
 #endif // AP_DDS_STATUS_PUB_ENABLED
 
+#if AP_DDS_TOPIC_STATUS_PUB_ENABLED
+    ardupilot_msgs_msg_TopicStatus topic_status_topic;
+    //! @brief Serialize the publishing statistics of one topic and publish to the IO stream(s)
+    void write_topic_status_topic();
+#endif // AP_DDS_TOPIC_STATUS_PUB_ENABLED
+
+    //! @brief Topics published by the scheduler. These index the rate
+    //         and priority parameters so must not be reordered
+    enum class Publisher : uint8_t {
+        TIME,
+        NAV_SAT_FIX,
+        BATTERY_STATE,
+        LOCAL_POSE,
+        LOCAL_VELOCITY,
+        AIRSPEED,
+        RC,
+        IMU,
+        GEO_POSE,
+        CLOCK,
+        GPS_GLOBAL_ORIGIN,
+        GOAL,
+        STATUS,
+        TOPIC_STATUS,
+        NUM_PUBLISHERS
+    };
+    static constexpr uint8_t num_publishers = static_cast<uint8_t>(Publisher::NUM_PUBLISHERS);
+
+    //! @brief Entry in the table of topics run by the scheduler
+    struct Publish_table;
+    static const struct Publish_table publishers[];
+
+    //! @brief Publish rate in Hz and priority of each topic
+    AP_Int16 pub_rate_hz[num_publishers];
+    AP_Int8 pub_priority[num_publishers];
+
+    //! @brief Bandwidth budget in bytes per second, 0 to use the serial baud rate
+    AP_Int32 max_bytes_per_second;
+
+    //! @brief Scheduling state and statistics of each topic
+    struct {
+        uint64_t next_us;           // time the next sample is due
+        uint32_t published;         // samples written this session
+        uint32_t dropped;           // samples missed, over the bandwidth budget or not fitting the output stream
+        uint32_t bytes;             // bytes written this session
+        uint16_t last_size;         // bytes written by the last sample
+        uint16_t window_published;  // samples written in the current rate window
+        float achieved_rate_hz;     // rate over the last rate window
+    } pub_state[num_publishers];
+    uint64_t rate_window_start_ms;
+
+    //! @brief Bytes and failures from prepare_output_stream() while a topic is published
+    uint32_t stream_bytes;
+    bool stream_failed;
+
+    //! @brief Bandwidth accounting. Tokens are added at the budget rate
+    //         and removed for each byte written to the transport
+    int32_t bw_tokens;
+    uint64_t bw_last_ms;
+    uint32_t transport_tx_bytes;
+    uint32_t bandwidth_limit() const;
+    void update_bandwidth(uint64_t now_ms);
+
+    //! @brief Reset the schedule and statistics at the start of a session
+    void reset_publishers();
+    //! @brief Publish the topics which are due, highest priority first
+    void run_publishers(uint64_t now_us);
+
+    //! @brief Prepare the reliable output stream for a sample, counting it against the topic being published
+    uint16_t prepare_output_stream(const uxrObjectId &dw_id, ucdrBuffer *ub, uint32_t topic_size);
+
+    // functions run by the scheduler to update and write each topic
+#if AP_DDS_TIME_PUB_ENABLED
+    void publish_time();
+#endif // AP_DDS_TIME_PUB_ENABLED
+#if AP_DDS_NAVSATFIX_PUB_ENABLED
+    void publish_nav_sat_fix();
+#endif // AP_DDS_NAVSATFIX_PUB_ENABLED
+#if AP_DDS_BATTERY_STATE_PUB_ENABLED
+    void publish_battery_state();
+#endif // AP_DDS_BATTERY_STATE_PUB_ENABLED
+#if AP_DDS_LOCAL_POSE_PUB_ENABLED
+    void publish_local_pose();
+#endif // AP_DDS_LOCAL_POSE_PUB_ENABLED
+#if AP_DDS_LOCAL_VEL_PUB_ENABLED
+    void publish_local_velocity();
+#endif // AP_DDS_LOCAL_VEL_PUB_ENABLED
+#if AP_DDS_AIRSPEED_PUB_ENABLED
+    void publish_airspeed();
+#endif // AP_DDS_AIRSPEED_PUB_ENABLED
+#if AP_DDS_RC_PUB_ENABLED
+    void publish_rc();
+#endif // AP_DDS_RC_PUB_ENABLED
+#if AP_DDS_IMU_PUB_ENABLED
+    void publish_imu();
+#endif // AP_DDS_IMU_PUB_ENABLED
+#if AP_DDS_GEOPOSE_PUB_ENABLED
+    void publish_geo_pose();
+#endif // AP_DDS_GEOPOSE_PUB_ENABLED
+#if AP_DDS_CLOCK_PUB_ENABLED
+    void publish_clock();
+#endif // AP_DDS_CLOCK_PUB_ENABLED
+#if AP_DDS_GPS_GLOBAL_ORIGIN_PUB_ENABLED
+    void publish_gps_global_origin();
+#endif // AP_DDS_GPS_GLOBAL_ORIGIN_PUB_ENABLED
+#if AP_DDS_GOAL_PUB_ENABLED
+    void publish_goal();
+#endif // AP_DDS_GOAL_PUB_ENABLED
+#if AP_DDS_STATUS_PUB_ENABLED
+    void publish_status();
+#endif // AP_DDS_STATUS_PUB_ENABLED
+#if AP_DDS_TOPIC_STATUS_PUB_ENABLED
+    void publish_topic_status();
+#endif // AP_DDS_TOPIC_STATUS_PUB_ENABLED
+
 #if AP_DDS_STATIC_TF_PUB_ENABLED
     // outgoing transforms
     tf2_msgs_msg_TFMessage tx_static_transforms_topic;
@@ -47,6 +47,7 @@ size_t AP_DDS_Client::serial_transport_write(uxrCustomTransport *t, const uint8_
         *error = 1;
         return 0;
     }
+    dds->transport_tx_bytes += bytes_written;
     //! @todo populate the error code correctly
     *error = 0;
     return bytes_written;
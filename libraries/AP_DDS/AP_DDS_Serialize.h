@@ -0,0 +1,97 @@
+// Serializers which write high rate topics straight into an XRCE output
+// stream, without filling in a message struct first.
+//
+// The layout follows the code microxrceddsgen generates for the IDL, so
+// the bytes written are identical to the generated *_serialize_topic()
+// functions. Sizes are computed at compile time for a given frame id.
+
+#pragma once
+
+#include "AP_DDS_config.h"
+
+#if AP_DDS_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <ucdr/microcdr.h>
+
+#include "builtin_interfaces/msg/Time.h"
+
+class AP_DDS_Serialize
+{
+public:
+
+    // Sizes return the offset after a field which starts at offset
+    static constexpr uint32_t align(uint32_t offset, uint32_t data_size)
+    {
+        return offset + ((data_size - (offset % data_size)) & (data_size - 1));
+    }
+
+    static constexpr uint32_t string_length(const char *s)
+    {
+        uint32_t len = 0;
+        while (s[len] != '\0') {
+            len++;
+        }
+        return len;
+    }
+
+    static constexpr uint32_t doubles_size(uint32_t offset, uint32_t n)
+    {
+        return align(offset, 8) + n * 8;
+    }
+
+    static constexpr uint32_t header_size(uint32_t offset, const char *frame_id)
+    {
+        // stamp sec and nanosec, then the frame id length, characters and terminator
+        return align(align(align(offset, 4) + 4, 4) + 4, 4) + 4 + string_length(frame_id) + 1;
+    }
+
+    // std_msgs/Header, Quaternion, 3 covariances and 2 Vector3
+    static constexpr uint32_t imu_size(const char *frame_id)
+    {
+        return doubles_size(header_size(0, frame_id), 4 + 9 + 3 + 9 + 3 + 9);
+    }
+
+    // std_msgs/Header, Point and Quaternion
+    static constexpr uint32_t pose_stamped_size(const char *frame_id)
+    {
+        return doubles_size(header_size(0, frame_id), 3 + 4);
+    }
+
+    // std_msgs/Header, linear and angular Vector3
+    static constexpr uint32_t twist_stamped_size(const char *frame_id)
+    {
+        return doubles_size(header_size(0, frame_id), 3 + 3);
+    }
+
+    static void header(ucdrBuffer *ub, const builtin_interfaces_msg_Time &stamp, const char *frame_id)
+    {
+        ucdr_serialize_int32_t(ub, stamp.sec);
+        ucdr_serialize_uint32_t(ub, stamp.nanosec);
+        ucdr_serialize_string(ub, frame_id);
+    }
+
+    static void vector3(ucdrBuffer *ub, double x, double y, double z)
+    {
+        ucdr_serialize_double(ub, x);
+        ucdr_serialize_double(ub, y);
+        ucdr_serialize_double(ub, z);
+    }
+
+    static void quaternion(ucdrBuffer *ub, double x, double y, double z, double w)
+    {
+        ucdr_serialize_double(ub, x);
+        ucdr_serialize_double(ub, y);
+        ucdr_serialize_double(ub, z);
+        ucdr_serialize_double(ub, w);
+    }
+
+    // 3x3 covariance matrix of zeros, meaning the covariance is unknown
+    static void zero_covariance(ucdrBuffer *ub)
+    {
+        static const double zero[9] {};
+        ucdr_serialize_array_double(ub, zero, ARRAY_SIZE(zero));
+    }
+};
+
+#endif // AP_DDS_ENABLED
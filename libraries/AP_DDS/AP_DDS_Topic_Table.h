@@ -57,6 +57,9 @@ enum class TopicIndex: uint8_t {
 #if AP_DDS_STATUS_PUB_ENABLED
     STATUS_PUB,
 #endif // AP_DDS_STATUS_PUB_ENABLED
+#if AP_DDS_TOPIC_STATUS_PUB_ENABLED
+    TOPIC_STATUS_PUB,
+#endif // AP_DDS_TOPIC_STATUS_PUB_ENABLED
 #if AP_DDS_JOY_SUB_ENABLED
     JOY_SUB,
 #endif // AP_DDS_JOY_SUB_ENABLED
@@ -331,6 +334,24 @@ constexpr struct AP_DDS_Client::Topic_table AP_DDS_Client::topics[] = {
         },
     },
 #endif // AP_DDS_STATUS_PUB_ENABLED
+#if AP_DDS_TOPIC_STATUS_PUB_ENABLED
+    {
+        .topic_id = to_underlying(TopicIndex::TOPIC_STATUS_PUB),
+        .pub_id = to_underlying(TopicIndex::TOPIC_STATUS_PUB),
+        .sub_id = to_underlying(TopicIndex::TOPIC_STATUS_PUB),
+        .dw_id = uxrObjectId{.id=to_underlying(TopicIndex::TOPIC_STATUS_PUB), .type=UXR_DATAWRITER_ID},
+        .dr_id = uxrObjectId{.id=to_underlying(TopicIndex::TOPIC_STATUS_PUB), .type=UXR_DATAREADER_ID},
+        .topic_rw = Topic_rw::DataWriter,
+        .topic_name = "rt/ap/topic_status",
+        .type_name = "ardupilot_msgs::msg::dds_::TopicStatus_",
+        .qos = {
+            .durability = UXR_DURABILITY_VOLATILE,
+            .reliability = UXR_RELIABILITY_BEST_EFFORT,
+            .history = UXR_HISTORY_KEEP_LAST,
+            .depth = 5,
+        },
+    },
+#endif // AP_DDS_TOPIC_STATUS_PUB_ENABLED
 #if AP_DDS_JOY_SUB_ENABLED
     {
         .topic_id = to_underlying(TopicIndex::JOY_SUB),
@@ -47,6 +47,7 @@ size_t AP_DDS_Client::udp_transport_write(uxrCustomTransport *t, const uint8_t*
         *error = errno;
         return 0;
     }
+    dds->transport_tx_bytes += ret;
     return ret;
 }
 
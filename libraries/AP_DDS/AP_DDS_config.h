@@ -46,6 +46,11 @@
 #define AP_DDS_NAVSATFIX_PUB_ENABLED AP_GPS_ENABLED
 #endif
 
+// 0 publishes each new GPS fix as soon as it arrives
+#ifndef AP_DDS_DELAY_NAV_SAT_FIX_TOPIC_MS
+#define AP_DDS_DELAY_NAV_SAT_FIX_TOPIC_MS 0
+#endif
+
 #ifndef AP_DDS_STATIC_TF_PUB_ENABLED
 #define AP_DDS_STATIC_TF_PUB_ENABLED AP_GPS_ENABLED
 #endif
@@ -129,6 +134,14 @@
 #define AP_DDS_STATUS_PUB_ENABLED 1
 #endif
 
+#ifndef AP_DDS_TOPIC_STATUS_PUB_ENABLED
+#define AP_DDS_TOPIC_STATUS_PUB_ENABLED 1
+#endif
+
+#ifndef AP_DDS_DELAY_TOPIC_STATUS_TOPIC_MS
+#define AP_DDS_DELAY_TOPIC_STATUS_TOPIC_MS 1000
+#endif
+
 #ifndef AP_DDS_JOY_SUB_ENABLED
 #define AP_DDS_JOY_SUB_ENABLED 1
 #endif
@@ -0,0 +1,110 @@
+#include <AP_gtest.h>
+
+#include <AP_DDS/AP_DDS_Serialize.h>
+#include <AP_DDS/AP_DDS_Frames.h>
+#include "sensor_msgs/msg/Imu.h"
+#include "geometry_msgs/msg/PoseStamped.h"
+#include "geometry_msgs/msg/TwistStamped.h"
+#include <AP_HAL/AP_HAL.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+static constexpr builtin_interfaces_msg_Time stamp { 1678668735, 729410000 };
+
+// the direct serializers must produce the same bytes as the generated ones
+static void expect_same(const uint8_t *expected, uint32_t expected_len, const ucdrBuffer &ub, const uint8_t *buf)
+{
+    EXPECT_FALSE(ub.error);
+    ASSERT_EQ(ucdr_buffer_length(&ub), expected_len);
+    EXPECT_EQ(memcmp(expected, buf, expected_len), 0);
+}
+
+TEST(AP_DDS_SERIALIZE, test_imu)
+{
+    sensor_msgs_msg_Imu msg {};
+    msg.header.stamp = stamp;
+    strncpy(msg.header.frame_id, BASE_LINK_NED_FRAME_ID, sizeof(msg.header.frame_id));
+    msg.orientation = { 0.1, 0.2, 0.3, 0.9 };
+    msg.angular_velocity = { 0.01, -0.02, 0.03 };
+    msg.linear_acceleration = { 0.5, -0.25, -9.81 };
+
+    constexpr uint32_t size = AP_DDS_Serialize::imu_size(BASE_LINK_NED_FRAME_ID);
+    ASSERT_EQ(size, sensor_msgs_msg_Imu_size_of_topic(&msg, 0));
+
+    uint8_t expected[size] {};
+    ucdrBuffer ub;
+    ucdr_init_buffer(&ub, expected, sizeof(expected));
+    ASSERT_TRUE(sensor_msgs_msg_Imu_serialize_topic(&ub, &msg));
+
+    uint8_t buf[size] {};
+    ucdr_init_buffer(&ub, buf, sizeof(buf));
+    AP_DDS_Serialize::header(&ub, stamp, BASE_LINK_NED_FRAME_ID);
+    AP_DDS_Serialize::quaternion(&ub, 0.1, 0.2, 0.3, 0.9);
+    AP_DDS_Serialize::zero_covariance(&ub);
+    AP_DDS_Serialize::vector3(&ub, 0.01, -0.02, 0.03);
+    AP_DDS_Serialize::zero_covariance(&ub);
+    AP_DDS_Serialize::vector3(&ub, 0.5, -0.25, -9.81);
+    AP_DDS_Serialize::zero_covariance(&ub);
+    expect_same(expected, size, ub, buf);
+}
+
+TEST(AP_DDS_SERIALIZE, test_pose_stamped)
+{
+    geometry_msgs_msg_PoseStamped msg {};
+    msg.header.stamp = stamp;
+    strncpy(msg.header.frame_id, BASE_LINK_FRAME_ID, sizeof(msg.header.frame_id));
+    msg.pose.position = { 10.0, -20.0, 5.5 };
+    msg.pose.orientation = { 0.0, 0.0, 0.7071, 0.7071 };
+
+    constexpr uint32_t size = AP_DDS_Serialize::pose_stamped_size(BASE_LINK_FRAME_ID);
+    ASSERT_EQ(size, geometry_msgs_msg_PoseStamped_size_of_topic(&msg, 0));
+
+    uint8_t expected[size] {};
+    ucdrBuffer ub;
+    ucdr_init_buffer(&ub, expected, sizeof(expected));
+    ASSERT_TRUE(geometry_msgs_msg_PoseStamped_serialize_topic(&ub, &msg));
+
+    uint8_t buf[size] {};
+    ucdr_init_buffer(&ub, buf, sizeof(buf));
+    AP_DDS_Serialize::header(&ub, stamp, BASE_LINK_FRAME_ID);
+    AP_DDS_Serialize::vector3(&ub, 10.0, -20.0, 5.5);
+    AP_DDS_Serialize::quaternion(&ub, 0.0, 0.0, 0.7071, 0.7071);
+    expect_same(expected, size, ub, buf);
+}
+
+TEST(AP_DDS_SERIALIZE, test_twist_stamped)
+{
+    geometry_msgs_msg_TwistStamped msg {};
+    msg.header.stamp = stamp;
+    strncpy(msg.header.frame_id, BASE_LINK_FRAME_ID, sizeof(msg.header.frame_id));
+    msg.twist.linear = { 1.5, -2.5, 0.25 };
+    msg.twist.angular = { 0.1, -0.1, 0.05 };
+
+    constexpr uint32_t size = AP_DDS_Serialize::twist_stamped_size(BASE_LINK_FRAME_ID);
+    ASSERT_EQ(size, geometry_msgs_msg_TwistStamped_size_of_topic(&msg, 0));
+
+    uint8_t expected[size] {};
+    ucdrBuffer ub;
+    ucdr_init_buffer(&ub, expected, sizeof(expected));
+    ASSERT_TRUE(geometry_msgs_msg_TwistStamped_serialize_topic(&ub, &msg));
+
+    uint8_t buf[size] {};
+    ucdr_init_buffer(&ub, buf, sizeof(buf));
+    AP_DDS_Serialize::header(&ub, stamp, BASE_LINK_FRAME_ID);
+    AP_DDS_Serialize::vector3(&ub, 1.5, -2.5, 0.25);
+    AP_DDS_Serialize::vector3(&ub, 0.1, -0.1, 0.05);
+    expect_same(expected, size, ub, buf);
+}
+
+// frame ids of other lengths change the padding before the doubles
+TEST(AP_DDS_SERIALIZE, test_header_padding)
+{
+    static constexpr const char *frames[] { "", "a", "ab", "abc", "abcd", "map", "base_link_ned" };
+    for (const char *frame : frames) {
+        geometry_msgs_msg_TwistStamped msg {};
+        strncpy(msg.header.frame_id, frame, sizeof(msg.header.frame_id));
+        EXPECT_EQ(AP_DDS_Serialize::twist_stamped_size(frame), geometry_msgs_msg_TwistStamped_size_of_topic(&msg, 0));
+    }
+}
+
+AP_GTEST_MAIN()
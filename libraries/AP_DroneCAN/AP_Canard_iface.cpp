@@ -5,6 +5,7 @@
 #include <canard/handler_list.h>
 #include <canard/transfer_object.h>
 #include <AP_Math/AP_Math.h>
+#include <AP_Common/ExpandingString.h>
 #include <dronecan_msgs.h>
 extern const AP_HAL::HAL& hal;
 #define LOG_TAG "DroneCANIface"
@@ -14,6 +15,17 @@ extern const AP_HAL::HAL& hal;
 #define DEBUG_PKTS 0
 
 #define CANARD_MSG_TYPE_FROM_ID(x)                         ((uint16_t)(((x) >> 8U)  & 0xFFFFU))
+#define CANARD_PRIORITY_FROM_ID(x)                         ((uint8_t)(((x) >> 24U) & 0x1FU))
+#define CANARD_IS_SERVICE_ID(x)                            (((x) & (1U << 7U)) != 0)
+
+// the last byte of each frame holds the position of the frame in its transfer
+#define CANARD_TAIL_BYTE(frame)                            ((frame).data[(frame).data_len - 1U])
+#define CANARD_TAIL_START_OF_TRANSFER                      0x80U
+#define CANARD_TAIL_END_OF_TRANSFER                        0x40U
+#define CANARD_TAIL_TRANSFER_ID_MASK                       0x1FU
+
+// percentage of the memory pool each TX priority level may use
+static const uint8_t tx_level_budget_pct[] { 100, 75, 50, 25 };
 
 DEFINE_HANDLER_LIST_HEADS();
 DEFINE_HANDLER_LIST_SEMAPHORES();
@@ -74,6 +86,13 @@ bool CanardInterface::broadcast(const Canard::Transfer &bcast_transfer) {
     }
     WITH_SEMAPHORE(_sem_tx);
 
+    const uint8_t level = tx_level(bcast_transfer.priority);
+    tx_coalesce(bcast_transfer.data_type_id, level);
+    if (!tx_admit(bcast_transfer, level)) {
+        protocol_stats.tx_errors++;
+        return false;
+    }
+
 #if AP_TEST_DRONECAN_DRIVERS
     if (this == &test_iface) {
         test_iface_sem.take_blocking();
@@ -107,6 +126,7 @@ bool CanardInterface::broadcast(const Canard::Transfer &bcast_transfer) {
         protocol_stats.tx_errors++;
     } else {
         protocol_stats.tx_frames += ret;
+        tx_queued(level, ret);
     }
     return ret > 0;
 }
@@ -117,6 +137,12 @@ bool CanardInterface::request(uint8_t destination_node_id, const Canard::Transfe
     }
     WITH_SEMAPHORE(_sem_tx);
 
+    const uint8_t level = tx_level(req_transfer.priority);
+    if (!tx_admit(req_transfer, level)) {
+        protocol_stats.tx_errors++;
+        return false;
+    }
+
     tx_transfer = {
         .transfer_type = req_transfer.transfer_type,
         .data_type_signature = req_transfer.data_type_signature,
@@ -139,6 +165,7 @@ bool CanardInterface::request(uint8_t destination_node_id, const Canard::Transfe
         protocol_stats.tx_errors++;
     } else {
         protocol_stats.tx_frames += ret;
+        tx_queued(level, ret);
     }
     return ret > 0;
 }
@@ -149,6 +176,12 @@ bool CanardInterface::respond(uint8_t destination_node_id, const Canard::Transfe
     }
     WITH_SEMAPHORE(_sem_tx);
 
+    const uint8_t level = tx_level(res_transfer.priority);
+    if (!tx_admit(res_transfer, level)) {
+        protocol_stats.tx_errors++;
+        return false;
+    }
+
     tx_transfer = {
         .transfer_type = res_transfer.transfer_type,
         .data_type_signature = res_transfer.data_type_signature,
@@ -171,6 +204,7 @@ bool CanardInterface::respond(uint8_t destination_node_id, const Canard::Transfe
         protocol_stats.tx_errors++;
     } else {
         protocol_stats.tx_frames += ret;
+        tx_queued(level, ret);
     }
     return ret > 0;
 }
@@ -201,6 +235,7 @@ void CanardInterface::processTestRx() {
         }
         canardPopTxQueue(&test_iface.canard);
     }
+    test_iface.update_tx_levels();
 }
 #endif
 
@@ -264,6 +299,7 @@ void CanardInterface::processTx(bool raw_commands_only = false) {
                 // try sending to interfaces, clearing the mask if we succeed
                 if (ifaces[iface]->send(txmsg, txf->deadline_usec, 0) > 0) {
                     txf->iface_mask &= ~(1U<<iface);
+                    tx_sent(*txf);
                 } else {
                     // if we fail to send then we try sending on next interface
                     if (!iface_down) {
@@ -283,6 +319,201 @@ void CanardInterface::processTx(bool raw_commands_only = false) {
 
 }
 
+/*
+  TX priority level of a transfer, 0 being the highest. ESC and
+  actuator commands are sent at CANARD_TRANSFER_PRIORITY_HIGH or above
+ */
+uint8_t CanardInterface::tx_level(uint8_t priority)
+{
+    if (priority <= CANARD_TRANSFER_PRIORITY_HIGH) {
+        return 0;
+    }
+    if (priority <= CANARD_TRANSFER_PRIORITY_MEDIUM) {
+        return 1;
+    }
+    if (priority <= CANARD_TRANSFER_PRIORITY_LOW) {
+        return 2;
+    }
+    return 3;
+}
+
+/*
+  check a transfer fits in the share of the memory pool for its
+  level, so bulk traffic such as firmware updates and parameter
+  transfers can't use the blocks needed for ESC commands. The blocks
+  held by lower levels count against the budget too, so the share
+  above a level's budget is always left for the levels above it
+ */
+bool CanardInterface::tx_admit(const Canard::Transfer &transfer, uint8_t level)
+{
+    const CanardPoolAllocatorStatistics pool = canardGetPoolAllocatorStatistics(&canard);
+#if CANARD_ENABLE_CANFD
+    const uint16_t frame_payload = transfer.canfd ? 63 : 7;
+#else
+    const uint16_t frame_payload = 7;
+#endif
+    // multi-frame transfers also carry a 2 byte CRC
+    uint32_t frames = 1;
+    if (transfer.payload_len > frame_payload) {
+        frames = (transfer.payload_len + 2 + frame_payload - 1) / frame_payload;
+    }
+    const uint32_t budget = uint32_t(pool.capacity_blocks) * tx_level_budget_pct[level] / 100;
+    uint32_t blocks = frames;
+    for (uint8_t i = level; i < TX_LEVELS; i++) {
+        blocks += tx_levels[i].blocks;
+    }
+    if (blocks > budget) {
+        tx_levels[level].rejected++;
+        return false;
+    }
+    return true;
+}
+
+// account for the frames of a transfer queued by libcanard
+void CanardInterface::tx_queued(uint8_t level, int16_t ret)
+{
+    TxLevel &l = tx_levels[level];
+    l.transfers++;
+    l.blocks += ret;
+    l.blocks_peak = MAX(l.blocks_peak, l.blocks);
+    if (l.probe_start_us == 0) {
+        // sample the latency of this transfer, identified by its deadline
+        l.probe_start_us = AP_HAL::micros64();
+        l.probe_deadline_usec = tx_transfer.deadline_usec;
+    }
+}
+
+// called when a frame has been given to an interface
+void CanardInterface::tx_sent(const CanardCANFrame &frame)
+{
+    TxLevel &l = tx_levels[tx_level(CANARD_PRIORITY_FROM_ID(frame.id))];
+    if (l.probe_start_us == 0 || frame.deadline_usec != l.probe_deadline_usec) {
+        return;
+    }
+    const uint32_t latency_us = AP_HAL::micros64() - l.probe_start_us;
+    l.latency_max_us = MAX(l.latency_max_us, latency_us);
+    l.latency_sum_us += latency_us;
+    l.latency_count++;
+    l.probe_start_us = 0;
+}
+
+/*
+  ESC raw commands carry the demand for every ESC, so any still
+  queued are out of date once a new one is sent. Drop them rather than
+  sending both, libcanard frees the frames when cleaning up stale
+  transfers. A transfer with any frame already sent is left alone, as
+  dropping the rest of it would leave the ESCs with a partial transfer
+ */
+void CanardInterface::tx_coalesce(uint16_t data_type_id, uint8_t level)
+{
+    if (data_type_id != UAVCAN_EQUIPMENT_ESC_RAWCOMMAND_ID &&
+        data_type_id != COM_HOBBYWING_ESC_RAWCOMMAND_ID) {
+        return;
+    }
+#if CANARD_MULTI_IFACE
+    const uint8_t all_ifaces = uint8_t((1<<num_ifaces) - 1);
+#endif
+    TxLevel &l = tx_levels[level];
+    bool coalesced = false;
+    // the transfer being checked, from its first frame
+    CanardTxQueueItem *start = nullptr;
+    bool unsent = false;
+    // the queue is sorted by priority, so stop at the first lower level frame
+    for (auto txq = canard.tx_queue; txq != nullptr; txq = txq->next) {
+        auto &txf = txq->frame;
+        if (tx_level(CANARD_PRIORITY_FROM_ID(txf.id)) > level) {
+            break;
+        }
+        if (txf.data_len == 0 ||
+            CANARD_IS_SERVICE_ID(txf.id) ||
+            CANARD_MSG_TYPE_FROM_ID(txf.id) != data_type_id) {
+            continue;
+        }
+        const uint8_t tail = CANARD_TAIL_BYTE(txf);
+        if (tail & CANARD_TAIL_START_OF_TRANSFER) {
+            start = txq;
+            unsent = true;
+        } else if (start == nullptr || !tx_same_transfer(start->frame, txf)) {
+            // the first frame has been sent and freed, or the frame
+            // is from another transfer
+            continue;
+        }
+#if CANARD_MULTI_IFACE
+        unsent &= txf.iface_mask == all_ifaces;
+#endif
+        if ((tail & CANARD_TAIL_END_OF_TRANSFER) == 0) {
+            continue;
+        }
+        if (unsent) {
+            for (auto f = start; f != txq->next; f = f->next) {
+                if (tx_same_transfer(f->frame, txf)) {
+                    f->frame.iface_mask = 0;
+                }
+            }
+            coalesced = true;
+            if (l.probe_start_us != 0 && txf.deadline_usec == l.probe_deadline_usec) {
+                l.probe_start_us = 0;
+            }
+        }
+        start = nullptr;
+    }
+    if (coalesced) {
+        l.coalesced++;
+    }
+}
+
+// true if two frames are from the same transfer
+bool CanardInterface::tx_same_transfer(const CanardCANFrame &a, const CanardCANFrame &b)
+{
+    return a.id == b.id &&
+        (CANARD_TAIL_BYTE(a) & CANARD_TAIL_TRANSFER_ID_MASK) == (CANARD_TAIL_BYTE(b) & CANARD_TAIL_TRANSFER_ID_MASK);
+}
+
+/*
+  count the pool blocks held by each level after stale frames have
+  been freed
+ */
+void CanardInterface::update_tx_levels()
+{
+    uint16_t blocks[TX_LEVELS] {};
+    for (auto txq = canard.tx_queue; txq != nullptr; txq = txq->next) {
+        blocks[tx_level(CANARD_PRIORITY_FROM_ID(txq->frame.id))]++;
+    }
+    const uint64_t now = AP_HAL::micros64();
+    for (uint8_t i = 0; i < TX_LEVELS; i++) {
+        TxLevel &l = tx_levels[i];
+        l.blocks = blocks[i];
+        if (l.probe_start_us != 0 && now > l.probe_deadline_usec) {
+            // the sampled transfer expired before it was sent
+            l.probe_start_us = 0;
+        }
+    }
+}
+
+void CanardInterface::tx_stats(ExpandingString &str)
+{
+    WITH_SEMAPHORE(_sem_tx);
+    const CanardPoolAllocatorStatistics pool = canardGetPoolAllocatorStatistics(&canard);
+    str.printf("pool blocks: %u/%u peak %u\n",
+               unsigned(pool.current_usage_blocks),
+               unsigned(pool.capacity_blocks),
+               unsigned(pool.peak_usage_blocks));
+    str.printf("level budget blocks peak transfers rejected coalesced lat_avg_us lat_max_us\n");
+    for (uint8_t i = 0; i < TX_LEVELS; i++) {
+        const TxLevel &l = tx_levels[i];
+        str.printf("%5u %5u%% %6u %4u %9u %8u %9u %10u %10u\n",
+                   unsigned(i),
+                   unsigned(tx_level_budget_pct[i]),
+                   unsigned(l.blocks),
+                   unsigned(l.blocks_peak),
+                   unsigned(l.transfers),
+                   unsigned(l.rejected),
+                   unsigned(l.coalesced),
+                   unsigned(l.latency_count > 0 ? l.latency_sum_us / l.latency_count : 0),
+                   unsigned(l.latency_max_us));
+    }
+}
+
 void CanardInterface::update_rx_protocol_stats(int16_t res)
 {
     switch (-res) {
@@ -394,6 +625,10 @@ void CanardInterface::process(uint32_t duration_ms) {
     const uint64_t deadline = AP_HAL::micros64() + duration_ms*1000;
     while (AP_HAL::micros64() < deadline) {
         processTestRx();
+        {
+            WITH_SEMAPHORE(_sem_tx);
+            update_tx_levels();
+        }
         hal.scheduler->delay_microseconds(1000);
     }
 #else
@@ -405,6 +640,7 @@ void CanardInterface::process(uint32_t duration_ms) {
             WITH_SEMAPHORE(_sem_rx);
             WITH_SEMAPHORE(_sem_tx);
             canardCleanupStaleTransfers(&canard, AP_HAL::micros64());
+            update_tx_levels();
         }
         const uint64_t now = AP_HAL::micros64();
         if (now < deadline) {
@@ -6,6 +6,7 @@
 
 class AP_DroneCAN;
 class CANSensor;
+class ExpandingString;
 
 class CanardInterface : public Canard::Interface {
     friend class AP_DroneCAN;
@@ -68,7 +69,39 @@ public:
     // get reference to the semaphore that is held during message receive
     HAL_Semaphore &get_sem_rx(void) { return _sem_rx; }
 
+    // report memory pool and per priority level TX statistics
+    void tx_stats(ExpandingString &str);
+
 private:
+    /*
+      transfers are grouped into levels by priority, each of which may
+      only use a share of the memory pool. libcanard keeps the frames
+      in a single queue sorted by CAN ID, so higher levels are always
+      sent first
+     */
+    static constexpr uint8_t TX_LEVELS = 4;
+    struct TxLevel {
+        uint16_t blocks;                // pool blocks held by queued frames
+        uint16_t blocks_peak;
+        uint32_t transfers;
+        uint32_t rejected;              // refused as over the level's budget
+        uint32_t coalesced;             // superseded before being sent
+        // queueing latency, sampled one transfer at a time
+        uint32_t latency_max_us;
+        uint32_t latency_count;
+        uint64_t latency_sum_us;
+        uint64_t probe_deadline_usec;
+        uint64_t probe_start_us;
+    } tx_levels[TX_LEVELS];
+
+    static uint8_t tx_level(uint8_t priority);
+    bool tx_admit(const Canard::Transfer &transfer, uint8_t level);
+    void tx_queued(uint8_t level, int16_t ret);
+    void tx_sent(const CanardCANFrame &frame);
+    void tx_coalesce(uint16_t data_type_id, uint8_t level);
+    static bool tx_same_transfer(const CanardCANFrame &a, const CanardCANFrame &b);
+    void update_tx_levels();
+
     CanardInstance canard;
     AP_HAL::CANIface* ifaces[HAL_NUM_CAN_IFACES];
 #if AP_TEST_DRONECAN_DRIVERS
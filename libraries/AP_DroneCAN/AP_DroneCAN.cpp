@@ -16,6 +16,7 @@
  */
 
 #include <AP_Common/AP_Common.h>
+#include <AP_Common/ExpandingString.h>
 #include <AP_HAL/AP_HAL.h>
 
 #if HAL_ENABLE_DRONECAN_DRIVERS
@@ -308,6 +309,18 @@ AP_DroneCAN *AP_DroneCAN::get_dronecan(uint8_t driver_index)
     return static_cast<AP_DroneCAN*>(AP::can().get_driver(driver_index));
 }
 
+void AP_DroneCAN::tx_stats(ExpandingString &str)
+{
+    for (uint8_t i = 0; i < HAL_MAX_CAN_PROTOCOL_DRIVERS; i++) {
+        AP_DroneCAN *dronecan = get_dronecan(i);
+        if (dronecan == nullptr) {
+            continue;
+        }
+        str.printf("DroneCAN%u\n", unsigned(i + 1));
+        dronecan->canard_iface.tx_stats(str);
+    }
+}
+
 bool AP_DroneCAN::add_interface(AP_HAL::CANIface* can_iface)
 {
     if (!canard_iface.add_interface(can_iface)) {
@@ -88,6 +88,9 @@ public:
 
     // Return uavcan from @driver_index or nullptr if it's not ready or doesn't exist
     static AP_DroneCAN *get_dronecan(uint8_t driver_index);
+
+    // TX queue statistics of all DroneCAN drivers, for @SYS/dronecan_tx.txt
+    static void tx_stats(ExpandingString &str);
     bool prearm_check(char* fail_msg, uint8_t fail_msg_len) const;
 
     __INITFUNC__ void init(uint8_t driver_index) override;
@@ -52,10 +52,9 @@ int AP_Filesystem_Mission::open(const char *fname, int flags, bool allow_absolut
     for (idx=0; idx<max_open_file; idx++) {
         if (now - file[idx].last_op_ms > IDLE_TIMEOUT_MS) {
             file[idx].open = false;
-            delete file[idx].writebuf;
-            file[idx].writebuf = nullptr;
+            free_upload(file[idx]);
         }
-        if (!readonly && file[idx].writebuf != nullptr) {
+        if (!readonly && file[idx].upload != nullptr) {
             // only one upload at a time
             return -1;
         }
@@ -74,9 +73,14 @@ int AP_Filesystem_Mission::open(const char *fname, int flags, bool allow_absolut
     r.num_items = get_num_items(r.mtype);
     if (!readonly) {
         // setup for upload
-        r.writebuf = NEW_NOTHROW ExpandingString();
+        r.upload = NEW_NOTHROW upload {};
+        if (r.upload == nullptr) {
+            r.open = false;
+            errno = ENOMEM;
+            return -1;
+        }
     } else {
-        r.writebuf = nullptr;
+        r.upload = nullptr;
     }
     r.last_op_ms = now;
 
@@ -91,10 +95,9 @@ int AP_Filesystem_Mission::close(int fd)
     }
     struct rfile &r = file[fd];
     r.open = false;
-    if (r.writebuf != nullptr) {
+    if (r.upload != nullptr) {
         bool ok = finish_upload(r);
-        delete r.writebuf;
-        r.writebuf = nullptr;
+        free_upload(r);
         if (!ok) {
             errno = EINVAL;
             return -1;
@@ -125,7 +128,7 @@ int32_t AP_Filesystem_Mission::read(int fd, void *buf, uint32_t count)
 
     struct rfile &r = file[fd];
 
-    if (r.writebuf != nullptr) {
+    if (r.upload != nullptr) {
         errno = EBADF;
         return -1;
     }
@@ -305,7 +308,12 @@ uint32_t AP_Filesystem_Mission::get_num_items(enum MAV_MISSION_TYPE mtype) const
 }
 
 /*
-  support mission upload
+  support mission upload. Items are decoded as each write arrives so
+  memory use doesn't depend on the size of the upload. A write beyond
+  the data received so far, such as one sent after a lost packet, is
+  held until the gap is filled. Only max_pending bytes after a single
+  gap can be held; other writes fail with ENOSPC and must be sent
+  again once the gap is filled
  */
 int32_t AP_Filesystem_Mission::write(int fd, const void *buf, uint32_t count)
 {
@@ -314,38 +322,90 @@ int32_t AP_Filesystem_Mission::write(int fd, const void *buf, uint32_t count)
         return -1;
     }
     struct rfile &r = file[fd];
-    if (r.writebuf == nullptr) {
+    if (r.upload == nullptr) {
         errno = EBADF;
         return -1;
     }
     r.last_op_ms = AP_HAL::millis();
-    struct header hdr;
-    if (r.file_ofs == 0 && count >= sizeof(hdr)) {
-        // pre-expand the buffer to the full size when we get the header
-        memcpy(&hdr, buf, sizeof(hdr));
-        if (hdr.num_items < 0xFFFF) {
-            const uint32_t flen = sizeof(hdr) + hdr.num_items * MAVLINK_MSG_ID_MISSION_ITEM_INT_LEN;
-            if (flen > r.writebuf->get_length()) {
-                if (!r.writebuf->append(nullptr, flen - r.writebuf->get_length())) {
-                    // not enough memory
-                    errno = ENOSPC;
-                    return -1;
-                }
+    struct upload &u = *r.upload;
+    if (u.failed) {
+        errno = EINVAL;
+        return -1;
+    }
+    const uint8_t item_size = MAVLINK_MSG_ID_MISSION_ITEM_INT_LEN;
+    if (u.received >= sizeof(u.hdr) &&
+        r.file_ofs + count > sizeof(u.hdr) + u.hdr.num_items * item_size) {
+        // more data than the header said there would be
+        u.failed = true;
+        errno = EINVAL;
+        return -1;
+    }
+    if (r.file_ofs > u.received) {
+        if (u.pending == nullptr) {
+            u.pending = NEW_NOTHROW uint8_t[max_pending];
+            if (u.pending == nullptr) {
+                errno = ENOMEM;
+                return -1;
             }
         }
-    }
-    if (r.file_ofs + count > r.writebuf->get_length()) {
-        if (!r.writebuf->append(nullptr, r.file_ofs + count - r.writebuf->get_length())) {
+        if (!pending_write(u, r.file_ofs, (const uint8_t *)buf, count)) {
             errno = ENOSPC;
             return -1;
         }
+        r.file_ofs += count;
+        return count;
+    }
+    // skip anything we already have
+    const uint32_t skip = u.received - r.file_ofs;
+    // a failed upload gives EINVAL unless it sets a more specific errno
+    errno = 0;
+    bool ok = count <= skip || upload_data(r, (const uint8_t *)buf + skip, count - skip);
+    if (ok && u.pending_len > 0 && u.received >= u.pending_ofs) {
+        // the gap has been filled, so decode the data held after it
+        const uint32_t pending_skip = u.received - u.pending_ofs;
+        ok = pending_skip >= u.pending_len ||
+            upload_data(r, &u.pending[pending_skip], u.pending_len - pending_skip);
+        u.pending_len = 0;
+    }
+    if (!ok) {
+        u.failed = true;
+        if (errno == 0) {
+            errno = EINVAL;
+        }
+        return -1;
     }
-    uint8_t *b = (uint8_t *)r.writebuf->get_writeable_string();
-    memcpy(&b[r.file_ofs], buf, count);
     r.file_ofs += count;
     return count;
 }
 
+/*
+  hold data written after a gap. The held data must stay in one piece,
+  so a write is refused if it would leave a second gap or need more
+  than max_pending bytes
+ */
+bool AP_Filesystem_Mission::pending_write(struct upload &u, uint32_t ofs, const uint8_t *b, uint32_t count)
+{
+    if (u.pending_len == 0) {
+        u.pending_ofs = ofs;
+    }
+    const uint32_t pending_end = u.pending_ofs + u.pending_len;
+    if (ofs > pending_end || ofs + count < u.pending_ofs) {
+        return false;
+    }
+    const uint32_t new_ofs = MIN(ofs, u.pending_ofs);
+    const uint32_t new_end = MAX(ofs + count, pending_end);
+    if (new_end - new_ofs > max_pending) {
+        return false;
+    }
+    if (new_ofs < u.pending_ofs) {
+        memmove(&u.pending[u.pending_ofs - new_ofs], u.pending, u.pending_len);
+    }
+    memcpy(&u.pending[ofs - new_ofs], b, count);
+    u.pending_ofs = new_ofs;
+    u.pending_len = new_end - new_ofs;
+    return true;
+}
+
 // see if a block of memory is all zero
 bool AP_Filesystem_Mission::all_zero(const uint8_t *b, uint8_t len) const
 {
@@ -358,48 +418,138 @@ bool AP_Filesystem_Mission::all_zero(const uint8_t *b, uint8_t len) const
 }
 
 /*
-  finish mission upload
+  consume uploaded bytes, starting the upload once the header is
+  complete and storing each item as it is completed
  */
-bool AP_Filesystem_Mission::finish_upload(const rfile &r)
+bool AP_Filesystem_Mission::upload_data(const rfile &r, const uint8_t *b, uint32_t count)
 {
-    const uint32_t flen = r.writebuf->get_length();
-    const uint8_t *b = (const uint8_t *)r.writebuf->get_string();
-    struct header hdr;
-    if (flen < sizeof(hdr)) {
-        return false;
-    }
+    struct upload &u = *r.upload;
     const uint8_t item_size = MAVLINK_MSG_ID_MISSION_ITEM_INT_LEN;
-    const uint32_t nitems = (flen - sizeof(hdr)) / item_size;
 
-    memcpy(&hdr, b, sizeof(hdr));
-    if (hdr.magic != mission_magic) {
-        return false;
+    while (count > 0) {
+        if (u.received < sizeof(u.hdr)) {
+            const uint8_t n = MIN(sizeof(u.hdr) - u.received, count);
+            memcpy(&((uint8_t *)&u.hdr)[u.received], b, n);
+            u.received += n;
+            b += n;
+            count -= n;
+            if (u.received == sizeof(u.hdr) && !start_upload(r)) {
+                return false;
+            }
+            continue;
+        }
+        if (u.num_decoded >= u.hdr.num_items) {
+            // more data than the header said there would be
+            return false;
+        }
+        const uint8_t item_ofs = (u.received - sizeof(u.hdr)) % item_size;
+        const uint8_t n = MIN(uint32_t(item_size - item_ofs), count);
+        memcpy(&u.item[item_ofs], b, n);
+        u.received += n;
+        b += n;
+        count -= n;
+        if (item_ofs + n < item_size) {
+            continue;
+        }
+
+        // if any item is all zeros then reject, it means client didn't
+        // fill in the whole file
+        if (all_zero(u.item, item_size)) {
+            return false;
+        }
+        mavlink_mission_item_int_t m {};
+        memcpy(&m, u.item, item_size);
+        if (!upload_item(r, m)) {
+            return false;
+        }
+        u.num_decoded++;
     }
-    if (nitems != hdr.num_items) {
+    return true;
+}
+
+/*
+  check the header and prepare to receive items
+ */
+bool AP_Filesystem_Mission::start_upload(const rfile &r)
+{
+    struct upload &u = *r.upload;
+    if (u.hdr.magic != mission_magic) {
         return false;
     }
 
-    // if any item is all zeros then reject, it means client didn't
-    // fill in the whole file
-    for (uint32_t i=0; i<nitems; i++) {
-        const uint8_t *b2 = b + sizeof(hdr) + i*item_size;
-        if (all_zero(b2, item_size)) {
-            return false;
-        }
+    switch (r.mtype) {
+#if AP_MISSION_ENABLED
+    case MAV_MISSION_TYPE_MISSION:
+        return start_upload_mission(u);
+#endif
+#if HAL_RALLY_ENABLED
+    case MAV_MISSION_TYPE_RALLY:
+        return start_upload_rally(u);
+#endif
+#if AP_FENCE_ENABLED
+    case MAV_MISSION_TYPE_FENCE:
+        return start_upload_fence(u);
+#endif
+    default:
+        // really should not get here....
+        break;
     }
 
+    return false;
+}
+
+/*
+  validate and store one item
+ */
+bool AP_Filesystem_Mission::upload_item(const rfile &r, const mavlink_mission_item_int_t &m)
+{
+    struct upload &u = *r.upload;
+
     switch (r.mtype) {
 #if AP_MISSION_ENABLED
     case MAV_MISSION_TYPE_MISSION:
-        return finish_upload_mission(hdr, r, b);
+        return upload_mission_item(u, m);
 #endif
 #if HAL_RALLY_ENABLED
     case MAV_MISSION_TYPE_RALLY:
-        return finish_upload_rally(hdr, r, b);
+        return MissionItemProtocol_Rally::convert_MISSION_ITEM_INT_to_RallyLocation(m, u.rally_items[u.num_decoded]) == MAV_MISSION_ACCEPTED;
 #endif
 #if AP_FENCE_ENABLED
     case MAV_MISSION_TYPE_FENCE:
-        return finish_upload_fence(hdr, r, b);
+        return MissionItemProtocol_Fence::convert_MISSION_ITEM_INT_to_AC_PolyFenceItem(m, u.fence_items[u.num_decoded]) == MAV_MISSION_ACCEPTED;
+#endif
+    default:
+        break;
+    }
+
+    return false;
+}
+
+/*
+  finish mission upload
+ */
+bool AP_Filesystem_Mission::finish_upload(const rfile &r)
+{
+    const struct upload &u = *r.upload;
+    const uint8_t item_size = MAVLINK_MSG_ID_MISSION_ITEM_INT_LEN;
+    if (u.failed ||
+        u.received < sizeof(u.hdr) ||
+        u.received != sizeof(u.hdr) + u.hdr.num_items * item_size) {
+        return false;
+    }
+
+    switch (r.mtype) {
+#if AP_MISSION_ENABLED
+    case MAV_MISSION_TYPE_MISSION:
+        return finish_upload_mission(u);
+#endif
+#if HAL_RALLY_ENABLED
+    case MAV_MISSION_TYPE_RALLY:
+        return finish_upload_rally(u);
+#endif
+#if AP_FENCE_ENABLED
+    case MAV_MISSION_TYPE_FENCE:
+        return finish_upload_fence(u);
 #endif
     default:
         // really should not get here....
@@ -409,128 +559,164 @@ bool AP_Filesystem_Mission::finish_upload(const rfile &r)
     return false;
 }
 
+// free an upload and anything it has allocated
+void AP_Filesystem_Mission::free_upload(rfile &r)
+{
+    if (r.upload == nullptr) {
+        return;
+    }
+    delete[] r.upload->pending;
+#if AP_FENCE_ENABLED
+    delete[] r.upload->fence_items;
+#endif
+#if HAL_RALLY_ENABLED
+    delete[] r.upload->rally_items;
+#endif
+    delete r.upload;
+    r.upload = nullptr;
+}
+
 #if AP_MISSION_ENABLED
-bool AP_Filesystem_Mission::finish_upload_mission(const struct header &hdr, const rfile &r, const uint8_t *b)
+/*
+  mission items are staged at the end of mission storage and copied
+  into place when the upload completes, so a failed upload leaves the
+  current mission untouched. An upload which doesn't fit alongside the
+  current mission fails with ENOSPC
+ */
+bool AP_Filesystem_Mission::start_upload_mission(struct upload &u)
 {
     auto *mission = AP::mission();
     if (mission == nullptr) {
         return false;
     }
     WITH_SEMAPHORE(mission->get_semaphore());
-    if ((hdr.options & unsigned(Options::NO_CLEAR)) == 0) {
-        mission->clear();
-    }
-    for (uint32_t i=0; i<hdr.num_items; i++) {
-        mavlink_mission_item_int_t m {};
-        AP_Mission::Mission_Command cmd;
-        const uint8_t item_size = MAVLINK_MSG_ID_MISSION_ITEM_INT_LEN;
-        memcpy(&m, &b[sizeof(hdr)+i*item_size], item_size);
-        const MAV_MISSION_RESULT res = AP_Mission::mavlink_int_to_mission_cmd(m, cmd);
-        if (res != MAV_MISSION_ACCEPTED) {
-            return false;
-        }
-        if (cmd.id == MAV_CMD_DO_JUMP &&
-            (cmd.content.jump.target >= hdr.num_items || cmd.content.jump.target == 0)) {
-            return false;
-        }
-        uint16_t idx = i + hdr.start;
-        if (idx == mission->num_commands()) {
-            if (!mission->add_cmd(cmd)) {
-                return false;
-            }
-        } else {
-            if (!mission->replace_cmd(idx, cmd)) {
-                return false;
-            }
-        }
+    if (!mission->begin_staged_upload(u.hdr.start, u.hdr.num_items)) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "No room to stage mission upload");
+        errno = ENOSPC;
+        return false;
     }
     return true;
 }
-#endif  // AP_MISSION_ENABLED
 
-#if AP_FENCE_ENABLED
-bool AP_Filesystem_Mission::finish_upload_fence(const struct header &hdr, const rfile &r, const uint8_t *b)
+bool AP_Filesystem_Mission::upload_mission_item(struct upload &u, const mavlink_mission_item_int_t &m)
 {
-    bool success = false;
+    auto *mission = AP::mission();
+    if (mission == nullptr) {
+        return false;
+    }
+    AP_Mission::Mission_Command cmd;
+    const MAV_MISSION_RESULT res = AP_Mission::mavlink_int_to_mission_cmd(m, cmd);
+    if (res != MAV_MISSION_ACCEPTED) {
+        return false;
+    }
+    if (cmd.id == MAV_CMD_DO_JUMP &&
+        (cmd.content.jump.target >= u.hdr.num_items || cmd.content.jump.target == 0)) {
+        return false;
+    }
+    WITH_SEMAPHORE(mission->get_semaphore());
+    return mission->write_staged_cmd(u.num_decoded, cmd);
+}
 
-    AC_PolyFenceItem *new_items = nullptr;
+bool AP_Filesystem_Mission::finish_upload_mission(const struct upload &u)
+{
+    auto *mission = AP::mission();
+    if (mission == nullptr) {
+        return false;
+    }
+    WITH_SEMAPHORE(mission->get_semaphore());
+    return mission->commit_staged_upload((u.hdr.options & unsigned(Options::NO_CLEAR)) == 0);
+}
+#endif  // AP_MISSION_ENABLED
 
+#if AP_FENCE_ENABLED
+/*
+  fence items are converted to AC_PolyFenceItem as they arrive, which
+  is bounded by the size of fence storage
+ */
+bool AP_Filesystem_Mission::start_upload_fence(struct upload &u)
+{
     auto *fence = AP::fence();
     if (fence == nullptr) {
-        goto OUT;
+        return false;
     }
 
-    if ((hdr.options & unsigned(Options::NO_CLEAR)) != 0) {
+    if ((u.hdr.options & unsigned(Options::NO_CLEAR)) != 0) {
         // Only complete fences can be uploaded for now.
-        goto OUT;
+        return false;
+    }
+
+    if (u.hdr.num_items > fence->polyfence().max_items()) {
+        return false;
     }
 
     // passing nullptr and 0 items through to Polyfence loader is
     // absolutely OK:
-    if (hdr.num_items != 0) {
-        new_items = NEW_NOTHROW AC_PolyFenceItem[hdr.num_items];
-        if (new_items == nullptr) {
+    if (u.hdr.num_items != 0) {
+        u.fence_items = NEW_NOTHROW AC_PolyFenceItem[u.hdr.num_items];
+        if (u.fence_items == nullptr) {
             GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Out of memory for upload");
-            goto OUT;
+            return false;
         }
     }
+    return true;
+}
 
-    // convert from MISSION_ITEM_INT to AC_PolyFenceItem:
-    for (uint32_t i=0; i<hdr.num_items; i++) {
-        mavlink_mission_item_int_t m {};
-        const uint8_t item_size = MAVLINK_MSG_ID_MISSION_ITEM_INT_LEN;
-        memcpy(&m, &b[sizeof(hdr)+i*item_size], item_size);
-        const MAV_MISSION_RESULT res = MissionItemProtocol_Fence::convert_MISSION_ITEM_INT_to_AC_PolyFenceItem(m, new_items[i]);
-        if (res != MAV_MISSION_ACCEPTED) {
-            goto OUT;
-        }
+bool AP_Filesystem_Mission::finish_upload_fence(const struct upload &u)
+{
+    auto *fence = AP::fence();
+    if (fence == nullptr) {
+        return false;
     }
-
-    success = fence->polyfence().write_fence(new_items, hdr.num_items);
-
-OUT:
-
-    delete[] new_items;
-
-    return success;
+    return fence->polyfence().write_fence(u.fence_items, u.hdr.num_items);
 }
 #endif  // AP_FENCE_ENABLED
 
 #if HAL_RALLY_ENABLED
-bool AP_Filesystem_Mission::finish_upload_rally(const struct header &hdr, const rfile &r, const uint8_t *b)
+/*
+  rally points are converted to RallyLocation as they arrive, which is
+  bounded by the size of rally storage
+ */
+bool AP_Filesystem_Mission::start_upload_rally(struct upload &u)
 {
-    bool success = false;
-
     auto *rally = AP::rally();
     if (rally == nullptr) {
-        goto OUT;
+        return false;
     }
 
-    if ((hdr.options & unsigned(Options::NO_CLEAR)) != 0) {
+    if ((u.hdr.options & unsigned(Options::NO_CLEAR)) != 0) {
         //only complete sets of rally points can be added ATM
-        goto OUT;
+        return false;
     }
 
-    rally->truncate(0);
+    if (u.hdr.num_items > rally->get_rally_max()) {
+        return false;
+    }
 
-    for (uint32_t i=0; i<hdr.num_items; i++) {
-        mavlink_mission_item_int_t m {};
-        RallyLocation cmd;
-        const uint8_t item_size = MAVLINK_MSG_ID_MISSION_ITEM_INT_LEN;
-        memcpy(&m, &b[sizeof(hdr)+i*item_size], item_size);
-        const MAV_MISSION_RESULT res = MissionItemProtocol_Rally::convert_MISSION_ITEM_INT_to_RallyLocation(m, cmd);
-        if (res != MAV_MISSION_ACCEPTED) {
-            goto OUT;
+    if (u.hdr.num_items != 0) {
+        u.rally_items = NEW_NOTHROW RallyLocation[u.hdr.num_items];
+        if (u.rally_items == nullptr) {
+            GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Out of memory for upload");
+            return false;
         }
+    }
+    return true;
+}
 
-        if (!rally->append(cmd)) {
-            goto OUT;
-        }
+bool AP_Filesystem_Mission::finish_upload_rally(const struct upload &u)
+{
+    auto *rally = AP::rally();
+    if (rally == nullptr) {
+        return false;
     }
-    success = true;
 
-OUT:
-    return success;
+    rally->truncate(0);
+
+    for (uint32_t i=0; i<u.hdr.num_items; i++) {
+        if (!rally->append(u.rally_items[i])) {
+            return false;
+        }
+    }
+    return true;
 }
 #endif  // HAL_RALLY_ENABLED
 
@@ -21,7 +21,9 @@
 
 #include "AP_Filesystem_backend.h"
 #include <GCS_MAVLink/GCS_MAVLink.h>
-#include <AP_Common/ExpandingString.h>
+
+class AC_PolyFenceItem;
+struct RallyLocation;
 
 class AP_Filesystem_Mission : public AP_Filesystem_Backend
 {
@@ -40,6 +42,11 @@ private:
 
     static constexpr uint16_t mission_magic = 0x763d;
 
+    // data written after a gap is held until the gap is filled; this
+    // is room for the few FTP write packets a GCS has in flight when
+    // one is lost
+    static constexpr uint16_t max_pending = 1024;
+
     enum class Options {
         NO_CLEAR = (1U<<0), // don't clear the old mission
     };
@@ -53,9 +60,27 @@ private:
         uint16_t num_items;
     };
 
+    /*
+      upload in progress. Items are validated and stored as they
+      arrive so only one partially received item is ever buffered,
+      plus up to max_pending bytes written after a gap
+     */
+    struct upload {
+        struct header hdr;
+        uint32_t received;          // bytes of the file received so far
+        uint8_t item[MAVLINK_MSG_ID_MISSION_ITEM_INT_LEN];
+        uint16_t num_decoded;       // number of complete items received
+        bool failed;
+        uint8_t *pending;           // data written after a gap, starting at pending_ofs
+        uint32_t pending_ofs;
+        uint16_t pending_len;
+        AC_PolyFenceItem *fence_items;
+        RallyLocation *rally_items;
+    };
+
     struct rfile {
         bool open;
-        ExpandingString *writebuf;
+        struct upload *upload;
         uint32_t file_ofs;
         uint32_t num_items;
         enum MAV_MISSION_TYPE mtype;
@@ -70,11 +95,30 @@ private:
     // get number of items
     uint32_t get_num_items(enum MAV_MISSION_TYPE mtype) const;
 
+    // consume uploaded bytes, decoding items as they complete
+    bool upload_data(const rfile &r, const uint8_t *b, uint32_t count);
+
+    // start loading items once the header has been received
+    bool start_upload(const rfile &r);
+    bool start_upload_mission(struct upload &u);
+    bool start_upload_fence(struct upload &u);
+    bool start_upload_rally(struct upload &u);
+
+    // validate and store one item
+    bool upload_item(const rfile &r, const mavlink_mission_item_int_t &m);
+    bool upload_mission_item(struct upload &u, const mavlink_mission_item_int_t &m);
+
+    // hold data written after a gap until the gap is filled
+    bool pending_write(struct upload &u, uint32_t ofs, const uint8_t *b, uint32_t count);
+
     // finish loading items
     bool finish_upload(const rfile &r);
-    bool finish_upload_mission(const struct header &hdr, const rfile &r, const uint8_t *b);
-    bool finish_upload_fence(const struct header &hdr, const rfile &r, const uint8_t *b);
-    bool finish_upload_rally(const struct header &hdr, const rfile &r, const uint8_t *b);
+    bool finish_upload_mission(const struct upload &u);
+    bool finish_upload_fence(const struct upload &u);
+    bool finish_upload_rally(const struct upload &u);
+
+    // free an upload and anything it has allocated
+    void free_upload(rfile &r);
 
     // see if a block of memory is all zero
     bool all_zero(const uint8_t *b, uint8_t size) const;
@@ -0,0 +1,307 @@
+/*
+  check that mission uploads through mission.dat give the uploaded
+  mission whether writes arrive in order or not, that only a bounded
+  amount of data after a gap is held, that an upload with no room to
+  be staged is refused, and that an upload which is not completed
+  leaves the current mission untouched
+ */
+#include <AP_gtest.h>
+
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_Filesystem/AP_Filesystem_Mission.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_FILESYSTEM_MISSION_ENABLED
+
+#include <AP_Mission/AP_Mission.h>
+
+#include <algorithm>
+#include <vector>
+
+class AP_Mission_Test
+{
+public:
+    // store home and set the number of commands, as the vehicle does on boot
+    static bool setup(AP_Mission &mission, uint16_t num_cmds)
+    {
+        for (uint16_t i = 0; i < num_cmds; i++) {
+            AP_Mission::Mission_Command cmd {};
+            cmd.id = MAV_CMD_NAV_WAYPOINT;
+            cmd.content.location.lat = i;
+            if (!mission.write_cmd_to_storage(i, cmd)) {
+                return false;
+            }
+        }
+        mission._cmd_total.set(num_cmds);
+        return true;
+    }
+};
+
+class MissionCallbacks
+{
+public:
+    AP_Mission mission{
+        FUNCTOR_BIND_MEMBER(&MissionCallbacks::start_cmd, bool, const AP_Mission::Mission_Command &),
+        FUNCTOR_BIND_MEMBER(&MissionCallbacks::verify_cmd, bool, const AP_Mission::Mission_Command &),
+        FUNCTOR_BIND_MEMBER(&MissionCallbacks::mission_complete, void)};
+
+private:
+    bool start_cmd(const AP_Mission::Mission_Command &) { return true; }
+    bool verify_cmd(const AP_Mission::Mission_Command &) { return true; }
+    void mission_complete() {}
+};
+
+static MissionCallbacks callbacks;
+static AP_Mission &mission = callbacks.mission;
+static AP_Filesystem_Mission fs;
+
+static void init_mission()
+{
+    static bool done;
+    if (!done) {
+        mission.init();
+        done = true;
+    }
+}
+
+static const uint8_t item_size = MAVLINK_MSG_ID_MISSION_ITEM_INT_LEN;
+
+/*
+  a file replacing the mission from index 1 with num_items waypoints,
+  whose latitudes start at lat. The old mission is not cleared, so home
+  need not be set
+ */
+static std::vector<uint8_t> mission_file(uint16_t num_items, int32_t lat)
+{
+    const uint16_t header[] { 0x763d, MAV_MISSION_TYPE_MISSION, 1, 1, num_items };
+    std::vector<uint8_t> file(sizeof(header) + num_items * item_size);
+    memcpy(file.data(), header, sizeof(header));
+    for (uint16_t i = 0; i < num_items; i++) {
+        mavlink_mission_item_int_t m {};
+        m.command = MAV_CMD_NAV_WAYPOINT;
+        m.frame = MAV_FRAME_GLOBAL_RELATIVE_ALT_INT;
+        m.x = lat + i;
+        m.y = 1490000000;
+        m.z = 100;
+        memcpy(&file[sizeof(header) + i * item_size], &m, item_size);
+    }
+    return file;
+}
+
+// write the parts of the file given by chunk_ofs, each chunk_len long
+static bool write_file(int fd, const std::vector<uint8_t> &file, const std::vector<uint32_t> &chunk_ofs, uint32_t chunk_len)
+{
+    for (uint32_t ofs : chunk_ofs) {
+        const uint32_t n = MIN(chunk_len, file.size() - ofs);
+        if (fs.lseek(fd, ofs, SEEK_SET) != int32_t(ofs) ||
+            fs.write(fd, &file[ofs], n) != int32_t(n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::vector<uint32_t> in_order(const std::vector<uint8_t> &file, uint32_t chunk_len)
+{
+    std::vector<uint32_t> chunk_ofs;
+    for (uint32_t ofs = 0; ofs < file.size(); ofs += chunk_len) {
+        chunk_ofs.push_back(ofs);
+    }
+    return chunk_ofs;
+}
+
+// the latitudes of the mission's commands after home, which identify them
+static std::vector<int32_t> mission_lats()
+{
+    std::vector<int32_t> lats;
+    for (uint16_t i = 1; i < mission.num_commands(); i++) {
+        AP_Mission::Mission_Command cmd;
+        if (!mission.read_cmd_from_storage(i, cmd)) {
+            break;
+        }
+        lats.push_back(cmd.content.location.lat);
+    }
+    return lats;
+}
+
+static std::vector<int32_t> expected_lats(const std::vector<int32_t> &old_lats, uint16_t num_items, int32_t lat)
+{
+    std::vector<int32_t> lats = old_lats;
+    lats.resize(MAX(lats.size(), size_t(num_items)));
+    for (uint16_t i = 0; i < num_items; i++) {
+        lats[i] = lat + i;
+    }
+    return lats;
+}
+
+TEST(AP_Filesystem_Mission, Upload)
+{
+    init_mission();
+
+    // in order with some chunks resent, out of order, then with a lost
+    // chunk resent after the next few
+    for (uint8_t order = 0; order < 3; order++) {
+        ASSERT_TRUE(AP_Mission_Test::setup(mission, 5));
+        const std::vector<int32_t> old_lats = mission_lats();
+        const uint16_t num_items = 20;
+        const std::vector<uint8_t> file = mission_file(num_items, 1000);
+
+        // chunks which don't line up with items
+        const uint32_t chunk_len = 50;
+        std::vector<uint32_t> chunk_ofs = in_order(file, chunk_len);
+        if (order == 0) {
+            chunk_ofs.insert(chunk_ofs.begin() + 5, chunk_ofs[3]);
+            chunk_ofs.insert(chunk_ofs.begin() + 9, chunk_ofs[8]);
+        } else if (order == 1) {
+            // a gap after the first two chunks, then data from before it resent
+            std::reverse(chunk_ofs.begin() + 2, chunk_ofs.end());
+            chunk_ofs.push_back(0);
+            chunk_ofs.push_back(75);
+        } else if (order == 2) {
+            std::rotate(chunk_ofs.begin() + 3, chunk_ofs.begin() + 4, chunk_ofs.begin() + 7);
+            std::rotate(chunk_ofs.begin() + 10, chunk_ofs.begin() + 11, chunk_ofs.begin() + 13);
+        }
+
+        const int fd = fs.open("mission.dat", O_WRONLY);
+        ASSERT_GE(fd, 0);
+        ASSERT_TRUE(write_file(fd, file, chunk_ofs, chunk_len)) << "order " << unsigned(order);
+
+        // nothing is changed until the upload is complete
+        EXPECT_EQ(mission_lats(), old_lats) << "order " << unsigned(order);
+
+        ASSERT_EQ(fs.close(fd), 0) << "order " << unsigned(order);
+        EXPECT_EQ(mission_lats(), expected_lats(old_lats, num_items, 1000)) << "order " << unsigned(order);
+    }
+}
+
+TEST(AP_Filesystem_Mission, NoRoomToStage)
+{
+    init_mission();
+
+    // a nearly full mission leaves no room to stage the upload, which
+    // is refused rather than held in memory
+    ASSERT_TRUE(AP_Mission_Test::setup(mission, mission.num_commands_max() - 5));
+    const std::vector<int32_t> old_lats = mission_lats();
+    const std::vector<uint8_t> file = mission_file(20, 3000);
+    const int fd = fs.open("mission.dat", O_WRONLY);
+    ASSERT_GE(fd, 0);
+    errno = 0;
+    EXPECT_EQ(fs.write(fd, file.data(), 50), -1);
+    EXPECT_EQ(errno, ENOSPC);
+    EXPECT_EQ(fs.close(fd), -1);
+    EXPECT_EQ(mission_lats(), old_lats);
+}
+
+TEST(AP_Filesystem_Mission, PendingLimit)
+{
+    init_mission();
+    ASSERT_TRUE(AP_Mission_Test::setup(mission, 5));
+    const std::vector<int32_t> old_lats = mission_lats();
+    const uint16_t num_items = 60;
+    const std::vector<uint8_t> file = mission_file(num_items, 4000);
+    const uint32_t chunk_len = 50;
+    const int fd = fs.open("mission.dat", O_WRONLY);
+    ASSERT_GE(fd, 0);
+
+    // the second chunk is lost, and a second gap can't be held
+    ASSERT_TRUE(write_file(fd, file, { 0, 2 * chunk_len }, chunk_len));
+    errno = 0;
+    EXPECT_FALSE(write_file(fd, file, { 4 * chunk_len }, chunk_len));
+    EXPECT_EQ(errno, ENOSPC);
+
+    // the writes after the lost chunk are held until there is no more room
+    uint32_t ofs = 3 * chunk_len;
+    while (write_file(fd, file, { ofs }, chunk_len)) {
+        ofs += chunk_len;
+        ASSERT_LT(ofs, file.size());
+    }
+    EXPECT_EQ(errno, ENOSPC);
+    EXPECT_GT(ofs, 10 * chunk_len);
+    EXPECT_LT(ofs, file.size() / 2);
+
+    // refused writes can be sent again once the gap is filled
+    std::vector<uint32_t> chunk_ofs = in_order(file, chunk_len);
+    chunk_ofs.erase(chunk_ofs.begin() + 2, chunk_ofs.begin() + ofs / chunk_len);
+    chunk_ofs.erase(chunk_ofs.begin());
+    ASSERT_TRUE(write_file(fd, file, chunk_ofs, chunk_len));
+    ASSERT_EQ(fs.close(fd), 0);
+    EXPECT_EQ(mission_lats(), expected_lats(old_lats, num_items, 4000));
+}
+
+TEST(AP_Filesystem_Mission, AbortedUpload)
+{
+    init_mission();
+    for (uint8_t order = 0; order < 2; order++) {
+        ASSERT_TRUE(AP_Mission_Test::setup(mission, 5));
+        const std::vector<int32_t> old_lats = mission_lats();
+        const uint16_t num_items = 20;
+        std::vector<uint8_t> file = mission_file(num_items, 2000);
+        const uint32_t chunk_len = 50;
+
+        // a chunk is missing
+        std::vector<uint32_t> chunk_ofs = in_order(file, chunk_len);
+        chunk_ofs.erase(chunk_ofs.begin() + 7);
+        if (order == 1) {
+            std::reverse(chunk_ofs.begin() + 2, chunk_ofs.end());
+        }
+        int fd = fs.open("mission.dat", O_WRONLY);
+        ASSERT_GE(fd, 0);
+        if (order == 1) {
+            // the first write before the missing chunk leaves a second gap
+            EXPECT_FALSE(write_file(fd, file, chunk_ofs, chunk_len));
+        } else {
+            ASSERT_TRUE(write_file(fd, file, chunk_ofs, chunk_len));
+        }
+        EXPECT_EQ(fs.close(fd), -1) << "order " << unsigned(order);
+        EXPECT_EQ(mission_lats(), old_lats) << "order " << unsigned(order);
+
+        // the file ends early
+        chunk_ofs = in_order(file, chunk_len);
+        chunk_ofs.pop_back();
+        if (order == 1) {
+            std::reverse(chunk_ofs.begin() + 2, chunk_ofs.end());
+        }
+        fd = fs.open("mission.dat", O_WRONLY);
+        ASSERT_GE(fd, 0);
+        ASSERT_TRUE(write_file(fd, file, chunk_ofs, chunk_len));
+        EXPECT_EQ(fs.close(fd), -1) << "order " << unsigned(order);
+        EXPECT_EQ(mission_lats(), old_lats) << "order " << unsigned(order);
+
+        // an item near the end is invalid, which is found when the
+        // write holding it or filling the gap before it is decoded
+        mavlink_mission_item_int_t m {};
+        m.command = MAV_CMD_NAV_WAYPOINT;
+        m.frame = MAV_FRAME_GLOBAL_RELATIVE_ALT_INT;
+        m.x = 100 * 10000000;
+        memcpy(&file[file.size() - 2 * item_size], &m, item_size);
+        fd = fs.open("mission.dat", O_WRONLY);
+        ASSERT_GE(fd, 0);
+        chunk_ofs = in_order(file, chunk_len);
+        if (order == 1) {
+            std::reverse(chunk_ofs.begin() + 2, chunk_ofs.end());
+        }
+        EXPECT_FALSE(write_file(fd, file, chunk_ofs, chunk_len));
+        EXPECT_EQ(fs.close(fd), -1) << "order " << unsigned(order);
+        EXPECT_EQ(mission_lats(), old_lats) << "order " << unsigned(order);
+
+        // more data than the header says
+        file = mission_file(num_items, 2000);
+        file.resize(file.size() + item_size, 1);
+        chunk_ofs = in_order(file, chunk_len);
+        if (order == 1) {
+            // rejected as soon as it arrives, rather than held
+            std::reverse(chunk_ofs.begin() + 2, chunk_ofs.end());
+            chunk_ofs.resize(3);
+        }
+        fd = fs.open("mission.dat", O_WRONLY);
+        ASSERT_GE(fd, 0);
+        EXPECT_FALSE(write_file(fd, file, chunk_ofs, chunk_len));
+        EXPECT_EQ(fs.close(fd), -1) << "order " << unsigned(order);
+        EXPECT_EQ(mission_lats(), old_lats) << "order " << unsigned(order);
+    }
+}
+
+#endif  // AP_FILESYSTEM_MISSION_ENABLED
+
+AP_GTEST_MAIN()
@@ -75,6 +75,33 @@ ssize_t AP_HAL::UARTDriver::read_locked(uint8_t *buf, size_t count, uint32_t key
     return ret;
 }
 
+const uint8_t *AP_HAL::UARTDriver::read_peek(uint32_t &count)
+{
+    if (lock_read_key != 0) {
+        count = 0;
+        return nullptr;
+    }
+    return _read_peek(count);
+}
+
+bool AP_HAL::UARTDriver::read_advance(uint32_t count)
+{
+    if (lock_read_key != 0) {
+        return false;
+    }
+#if AP_UART_MONITOR_ENABLED
+    auto monitor = _monitor_read_buffer;
+    if (monitor != nullptr) {
+        uint32_t n;
+        const uint8_t *ptr = _read_peek(n);
+        if (ptr != nullptr) {
+            monitor->write(ptr, n < count ? n : count);
+        }
+    }
+#endif
+    return _read_advance(count);
+}
+
 uint32_t AP_HAL::UARTDriver::available_locked(uint32_t key)
 {
     if (lock_read_key != 0 && lock_read_key != key) {
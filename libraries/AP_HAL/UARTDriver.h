@@ -79,6 +79,18 @@ public:
     // read buffer from a locked port. If port is locked and key is not correct then -1 is returned
     ssize_t read_locked(uint8_t *buf, size_t count, uint32_t key) WARN_IF_UNUSED;
 
+    /*
+      zero copy read. Returns a pointer to received bytes which are
+      contiguous in the driver's buffer and sets count to the number
+      there, or returns nullptr if the driver doesn't support it or
+      there is nothing to read. The bytes stay valid until consumed
+      with read_advance(), which must be called by the same thread.
+      The port must not be begun again or have its input discarded
+      in the meantime
+     */
+    const uint8_t *read_peek(uint32_t &count);
+    bool read_advance(uint32_t count);
+
     // get current parity for passthrough use
     uint8_t get_parity(void);
     
@@ -261,6 +273,12 @@ protected:
     // discard incoming data on the port
     virtual bool _discard_input(void) = 0;
 
+    /*
+      backend zero copy read methods, see read_peek()
+     */
+    virtual const uint8_t *_read_peek(uint32_t &count) { count = 0; return nullptr; }
+    virtual bool _read_advance(uint32_t count) { return false; }
+
     // Helper to check if flow control is enabled given the passed setting
     bool flow_control_enabled(enum flow_control flow_control_setting) const;
 
@@ -35,11 +35,15 @@
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <sys/time.h>
+#include <time.h>
 #include <net/if.h>
 #include <linux/can/raw.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
 #include <cstring>
 #include "Scheduler.h"
 #include <AP_CANManager/AP_CANManager.h>
+#include <AP_Math/AP_Math.h>
 #include <AP_Common/ExpandingString.h>
 
 extern const AP_HAL::HAL& hal;
@@ -83,6 +87,27 @@ static AP_HAL::CANFrame makeUavcanFrame(const can_frame& sockcan_frame)
     return uavcan_frame;
 }
 
+/*
+  convert a kernel CLOCK_REALTIME receive timestamp to the
+  AP_HAL::micros64() clock, using the age of the timestamp when the
+  batch was read. Returns false if the timestamp is not plausible, for
+  example a hardware timestamp from a clock which isn't synchronised
+  to the system clock
+ */
+static bool kernel_timestamp_us(const timespec &ts, const timespec &realtime_now, uint64_t now_us, uint64_t &timestamp_us)
+{
+    if (ts.tv_sec == 0 && ts.tv_nsec == 0) {
+        return false;
+    }
+    const int64_t age_us = (int64_t(realtime_now.tv_sec) - ts.tv_sec) * 1000000LL +
+                           (int64_t(realtime_now.tv_nsec) - ts.tv_nsec) / 1000;
+    if (age_us < 0 || age_us > 1000000 || uint64_t(age_us) > now_us) {
+        return false;
+    }
+    timestamp_us = now_us - age_us;
+    return true;
+}
+
 bool CANIface::is_initialized() const
 {
     return _initialized;
@@ -124,8 +149,12 @@ int CANIface::_openSocket(const std::string& iface_name)
     // Configure
     {
         const int on = 1;
-        // Timestamping
-        if (setsockopt(s, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) < 0) {
+        // Timestamping, hardware receive timestamps are used when the
+        // adapter supports them, otherwise the kernel software ones
+        const int ts_flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE |
+                             SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if (setsockopt(s, SOL_SOCKET, SO_TIMESTAMPING, &ts_flags, sizeof(ts_flags)) < 0 &&
+            setsockopt(s, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) < 0) {
             return -1;
         }
         // Socket loopback
@@ -229,137 +258,211 @@ uint32_t CANIface::getErrorCount() const
     return ec;
 }
 
+/*
+  send the highest priority frames in the queue, up to the free space
+  in the socket TX queue, with one sendmmsg() call per batch. Frames
+  which have passed their deadline are dropped
+ */
 void CANIface::_pollWrite()
 {
+    WITH_SEMAPHORE(sem);
     while (_hasReadyTx()) {
-        WITH_SEMAPHORE(sem);
-        if (!_hasReadyTx()) {
+        CanTxItem batch[CAN_IO_BATCH_SIZE];
+        const unsigned space = MIN(_max_frames_in_socket_tx_queue - _frames_in_socket_tx_queue, unsigned(CAN_IO_BATCH_SIZE));
+        const uint64_t curr_time = AP_HAL::micros64();
+        unsigned count = 0;
+        while (count < space && !_tx_queue.empty()) {
+            const CanTxItem &tx = _tx_queue.top();
+            if (tx.deadline >= curr_time) {
+                batch[count++] = tx;
+            } else {
+                stats.tx_timedout++;
+            }
+            _tx_queue.pop();
+        }
+        if (count == 0) {
             break;
         }
-        const CanTxItem tx = _tx_queue.top();
-        uint64_t curr_time = AP_HAL::micros64();
-        if (tx.deadline >= curr_time) {
-            // hal.console->printf("%x TDEAD: %lu CURRT: %lu DEL: %lu\n",tx.frame.id,  tx.deadline, curr_time, tx.deadline-curr_time);
-            const int res = _write(tx.frame);
-            if (res == 1) {                   // Transmitted successfully
-                _incrementNumFramesInSocketTxQueue();
-                if (tx.loopback) {
-                    _pending_loopback_ids.insert(tx.frame.id);
-                }
-                stats.tx_success++;
-                stats.last_transmit_us = curr_time;
-            } else if (res == 0) {            // Not transmitted, nor is it an error
-                stats.tx_overflow++;
-                break;                        // Leaving the loop, the frame remains enqueued for the next retry
-            } else {                          // Transmission error
-                stats.tx_rejected++;
+
+        int error = 0;
+        const unsigned sent = _write(batch, count, error);
+        for (unsigned i = 0; i < sent; i++) {
+            _incrementNumFramesInSocketTxQueue();
+            if (batch[i].loopback) {
+                _pending_loopback_ids.insert(batch[i].frame.id);
             }
-        } else {
-            // hal.console->printf("TDEAD: %lu CURRT: %lu DEL: %lu\n", tx.deadline, curr_time, curr_time-tx.deadline);
-            stats.tx_timedout++;
+            stats.tx_success++;
+            stats.last_transmit_us = curr_time;
+        }
+        if (sent == count) {
+            continue;
         }
 
-        // Removing the frame from the queue even if transmission failed
-        (void)_tx_queue.pop();
+        unsigned retry_from = sent;
+        if (error == ENOBUFS || error == EAGAIN || error == 0) {
+            // Writing is not possible atm, not an error. Frames remain
+            // enqueued for the next retry
+            stats.tx_overflow++;
+        } else {
+            // Transmission error, drop the frame which failed
+            stats.tx_rejected++;
+            retry_from++;
+        }
+        for (unsigned i = retry_from; i < count; i++) {
+            _tx_queue.emplace(batch[i]);
+        }
+        if (retry_from == sent) {
+            break;
+        }
     }
 }
 
+/*
+  read all available frames, CAN_IO_BATCH_SIZE at a time
+ */
 bool CANIface::_pollRead()
 {
-    uint8_t iterations_count = 0;
-    while (iterations_count < CAN_MAX_POLL_ITERATIONS_COUNT)
-    {
-        iterations_count++;
-        CanRxItem rx;
-        rx.timestamp_us = AP_HAL::micros64();  // Monotonic timestamp is not required to be precise (unlike UTC)
-        bool loopback = false;
-        const int res = _read(rx.frame, rx.timestamp_us, loopback);
-        if (res == 1) {
-            bool accept = true;
-            if (loopback) {           // We receive loopback for all CAN frames
-                _confirmSentFrame();
-                rx.flags |= Loopback;
-                accept = _wasInPendingLoopbackSet(rx.frame);
-                stats.tx_confirmed++;
-            }
-            if (accept) {
-                WITH_SEMAPHORE(sem);
-                _rx_queue.push(rx);
-                stats.rx_received++;
-                return true;
-            }
-        } else if (res == 0) {
-            break;
-        } else {
+    bool received = false;
+    for (uint8_t i = 0; i < CAN_MAX_POLL_ITERATIONS_COUNT / CAN_IO_BATCH_SIZE; i++) {
+        const int res = _read();
+        if (res < 0) {
             stats.rx_errors++;
             break;
         }
+        received |= res > 0;
+        if (res < CAN_IO_BATCH_SIZE) {
+            break;
+        }
     }
-    return false;
+    return received;
 }
 
-int CANIface::_write(const AP_HAL::CANFrame& frame) const
+/*
+  write frames with a single sendmmsg() call, returning the number
+  written. error is set to errno if the first unwritten frame failed,
+  or 0 if it wasn't attempted
+ */
+unsigned CANIface::_write(const CanTxItem *items, unsigned count, int &error)
 {
+    error = 0;
     if (_fd < 0) {
-        return -1;
+        error = EBADF;
+        return 0;
     }
-    errno = 0;
 
-    const can_frame sockcan_frame = makeSocketCanFrame(frame);
-
-    const int res = write(_fd, &sockcan_frame, sizeof(sockcan_frame));
-    if (res <= 0) {
-        if (errno == ENOBUFS || errno == EAGAIN) {  // Writing is not possible atm, not an error
-            return 0;
-        }
-        return res;
+    can_frame frames[CAN_IO_BATCH_SIZE];
+    iovec iov[CAN_IO_BATCH_SIZE];
+    mmsghdr msgs[CAN_IO_BATCH_SIZE] {};
+    for (unsigned i = 0; i < count; i++) {
+        frames[i] = makeSocketCanFrame(items[i].frame);
+        iov[i].iov_base = &frames[i];
+        iov[i].iov_len = sizeof(frames[i]);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
     }
-    if (res != sizeof(sockcan_frame)) {
-        return -1;
+
+    stats.tx_syscalls++;
+    const int res = sendmmsg(_fd, msgs, count, MSG_DONTWAIT);
+    if (res < 0) {
+        error = errno;
+        return 0;
     }
-    return 1;
+    return res;
 }
 
-
-int CANIface::_read(AP_HAL::CANFrame& frame, uint64_t& timestamp_us, bool& loopback) const
+/*
+  read up to CAN_IO_BATCH_SIZE frames with a single recvmmsg() call
+  into the RX queue. Loopback frames confirm our own transmissions and
+  are only queued if loopback was requested. Returns the number of
+  frames read, or -1 on error
+ */
+int CANIface::_read()
 {
     if (_fd < 0) {
         return -1;
     }
-    auto iov = iovec();
-    auto sockcan_frame = can_frame();
-    iov.iov_base = &sockcan_frame;
-    iov.iov_len  = sizeof(sockcan_frame);
-    union {
-        uint8_t data[CMSG_SPACE(sizeof(::timeval))];
-        struct cmsghdr align;
-    } control;
-
-    auto msg = msghdr();
-    msg.msg_iov    = &iov;
-    msg.msg_iovlen = 1;
-    msg.msg_control = control.data;
-    msg.msg_controllen = sizeof(control.data);
 
-    const int res = recvmsg(_fd, &msg, MSG_DONTWAIT);
+    can_frame frames[CAN_IO_BATCH_SIZE];
+    iovec iov[CAN_IO_BATCH_SIZE];
+    union control_t {
+        uint8_t data[CMSG_SPACE(sizeof(scm_timestamping)) + CMSG_SPACE(sizeof(::timeval))];
+        struct cmsghdr align;
+    } control[CAN_IO_BATCH_SIZE];
+    mmsghdr msgs[CAN_IO_BATCH_SIZE] {};
+    for (uint8_t i = 0; i < CAN_IO_BATCH_SIZE; i++) {
+        iov[i].iov_base = &frames[i];
+        iov[i].iov_len = sizeof(frames[i]);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = control[i].data;
+        msgs[i].msg_hdr.msg_controllen = sizeof(control[i].data);
+    }
+
+    stats.rx_syscalls++;
+    const int res = recvmmsg(_fd, msgs, CAN_IO_BATCH_SIZE, MSG_DONTWAIT, nullptr);
     if (res <= 0) {
-        return (res < 0 && errno == EWOULDBLOCK) ? 0 : res;
+        return (res < 0 && errno == EWOULDBLOCK) ? 0 : -1;
     }
-    /*
-     * Flags
-     */
-    loopback = (msg.msg_flags & static_cast<int>(MSG_CONFIRM)) != 0;
 
-    if (!loopback) {
-        return 0;
-    }
+    // reference times for converting the kernel timestamps
+    const uint64_t now_us = AP_HAL::micros64();
+    timespec realtime_now {};
+    clock_gettime(CLOCK_REALTIME, &realtime_now);
 
-    frame = makeUavcanFrame(sockcan_frame);
-    /*
-     * Timestamp
-     */
-    timestamp_us = AP_HAL::micros64();
-    return 1;
+    WITH_SEMAPHORE(sem);
+    for (int i = 0; i < res; i++) {
+        msghdr &msg = msgs[i].msg_hdr;
+        if (msgs[i].msg_len != sizeof(can_frame)) {
+            stats.rx_errors++;
+            continue;
+        }
+
+        CanRxItem rx;
+        rx.frame = makeUavcanFrame(frames[i]);
+        rx.timestamp_us = now_us;
+
+        /*
+         * Timestamp
+         */
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET) {
+                continue;
+            }
+            if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                scm_timestamping ts;
+                memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                // ts[2] is the raw hardware timestamp, ts[0] the software one
+                if (kernel_timestamp_us(ts.ts[2], realtime_now, now_us, rx.timestamp_us)) {
+                    stats.rx_hw_timestamps++;
+                } else if (kernel_timestamp_us(ts.ts[0], realtime_now, now_us, rx.timestamp_us)) {
+                    stats.rx_sw_timestamps++;
+                }
+            } else if (cmsg->cmsg_type == SCM_TIMESTAMP) {
+                ::timeval tv;
+                memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+                const timespec ts { tv.tv_sec, tv.tv_usec * 1000 };
+                if (kernel_timestamp_us(ts, realtime_now, now_us, rx.timestamp_us)) {
+                    stats.rx_sw_timestamps++;
+                }
+            }
+        }
+
+        /*
+         * Flags
+         */
+        const bool loopback = (msg.msg_flags & static_cast<int>(MSG_CONFIRM)) != 0;
+        if (loopback) {           // We receive loopback for all CAN frames
+            _confirmSentFrame();
+            stats.tx_confirmed++;
+            if (!_wasInPendingLoopbackSet(rx.frame)) {
+                continue;
+            }
+            rx.flags |= Loopback;
+        }
+        _rx_queue.push(rx);
+        stats.rx_received++;
+    }
+    return res;
 }
 
 // Might block forever, only to be used for testing
@@ -504,7 +607,11 @@ void CANIface::get_stats(ExpandingString &str)
                "num_tx_poll_req:  %u\n"
                "num_poll_waits:   %u\n"
                "num_poll_tx_events: %u\n"
-               "num_poll_rx_events: %u\n",
+               "num_poll_rx_events: %u\n"
+               "tx_syscalls:    %u\n"
+               "rx_syscalls:    %u\n"
+               "rx_hw_timestamps: %u\n"
+               "rx_sw_timestamps: %u\n",
                stats.tx_requests,
                stats.tx_rejected,
                stats.tx_overflow,
@@ -518,7 +625,11 @@ void CANIface::get_stats(ExpandingString &str)
                stats.num_tx_poll_req,
                stats.num_poll_waits,
                stats.num_poll_tx_events,
-               stats.num_poll_rx_events);
+               stats.num_poll_rx_events,
+               stats.tx_syscalls,
+               stats.rx_syscalls,
+               stats.rx_hw_timestamps,
+               stats.rx_sw_timestamps);
 }
 
 #endif
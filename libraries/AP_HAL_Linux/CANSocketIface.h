@@ -52,12 +52,14 @@ enum class SocketCanError
 
 #define CAN_MAX_POLL_ITERATIONS_COUNT 100
 #define CAN_MAX_INIT_TRIES_COUNT 100
+#define CAN_IO_BATCH_SIZE 16                        // frames per recvmmsg()/sendmmsg() call
+#define CAN_MAX_FRAMES_IN_SOCKET_TX_QUEUE 8         // frames sent but not yet confirmed by loopback
 
 class CANIface: public AP_HAL::CANIface {
 public:
     CANIface(int index)
       : _self_index(index)
-      , _max_frames_in_socket_tx_queue(2)
+      , _max_frames_in_socket_tx_queue(CAN_MAX_FRAMES_IN_SOCKET_TX_QUEUE)
       , _frames_in_socket_tx_queue(0)
     { }
 
@@ -112,9 +114,9 @@ private:
 
     bool _pollRead();
 
-    int _write(const AP_HAL::CANFrame& frame) const;
+    unsigned _write(const CanTxItem *items, unsigned count, int &error);
 
-    int _read(AP_HAL::CANFrame& frame, uint64_t& ts_usec, bool& loopback) const;
+    int _read();
 
     void _incrementNumFramesInSocketTxQueue();
 
@@ -160,6 +162,10 @@ private:
         uint32_t num_poll_waits;
         uint32_t num_poll_tx_events;
         uint32_t num_poll_rx_events;
+        uint32_t tx_syscalls;
+        uint32_t rx_syscalls;
+        uint32_t rx_hw_timestamps;
+        uint32_t rx_sw_timestamps;
     } stats;
 
 protected:
@@ -0,0 +1,211 @@
+#include <AP_gbenchmark.h>
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+
+/*
+  compare frame per syscall and batched SocketCAN I/O, as used by
+  Linux::CANIface. Needs a vcan0 interface:
+
+  sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+
+  Frames per second are reported as items_per_second, the CPU time
+  per iteration is the cost of sending or receiving range_x() frames
+ */
+
+#include <net/if.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+#define BATCH_SIZE 16
+
+static int open_vcan(void)
+{
+    int fd = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK, CAN_RAW);
+    if (fd < 0) {
+        fprintf(stderr, "error: couldn't open CAN socket\n");
+        return -1;
+    }
+    struct ifreq ifr {};
+    strncpy(ifr.ifr_name, "vcan0", sizeof(ifr.ifr_name) - 1);
+    struct sockaddr_can addr {};
+    addr.can_family = AF_CAN;
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0) {
+        fprintf(stderr, "error: vcan0 not found\n");
+        close(fd);
+        return -1;
+    }
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "error: couldn't bind to vcan0\n");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void fill_frames(struct can_frame *frames, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        frames[i] = {};
+        frames[i].can_id = (0x1000 + i) | CAN_EFF_FLAG;
+        frames[i].can_dlc = 8;
+        memset(frames[i].data, i, sizeof(frames[i].data));
+    }
+}
+
+static void drain(int fd)
+{
+    struct can_frame frame;
+    while (read(fd, &frame, sizeof(frame)) > 0) {
+    }
+}
+
+static void BM_SendWrite(benchmark::State& state)
+{
+    int tx = open_vcan();
+    int rx = open_vcan();
+    if (tx < 0 || rx < 0) {
+        close(tx);
+        close(rx);
+        return;
+    }
+    struct can_frame frames[BATCH_SIZE];
+    fill_frames(frames, BATCH_SIZE);
+
+    while (state.KeepRunning()) {
+        for (int i = 0; i < state.range_x(); i++) {
+            if (write(tx, &frames[i], sizeof(frames[i])) != sizeof(frames[i])) {
+                break;
+            }
+        }
+        state.PauseTiming();
+        drain(rx);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+
+    close(tx);
+    close(rx);
+}
+
+BENCHMARK(BM_SendWrite)->Arg(1)->Arg(4)->Arg(BATCH_SIZE);
+
+static void BM_SendMmsg(benchmark::State& state)
+{
+    int tx = open_vcan();
+    int rx = open_vcan();
+    if (tx < 0 || rx < 0) {
+        close(tx);
+        close(rx);
+        return;
+    }
+    struct can_frame frames[BATCH_SIZE];
+    struct iovec iov[BATCH_SIZE];
+    struct mmsghdr msgs[BATCH_SIZE] {};
+    fill_frames(frames, BATCH_SIZE);
+    for (uint8_t i = 0; i < BATCH_SIZE; i++) {
+        iov[i].iov_base = &frames[i];
+        iov[i].iov_len = sizeof(frames[i]);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while (state.KeepRunning()) {
+        sendmmsg(tx, msgs, state.range_x(), MSG_DONTWAIT);
+        state.PauseTiming();
+        drain(rx);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+
+    close(tx);
+    close(rx);
+}
+
+BENCHMARK(BM_SendMmsg)->Arg(1)->Arg(4)->Arg(BATCH_SIZE);
+
+static void BM_RecvMsg(benchmark::State& state)
+{
+    int tx = open_vcan();
+    int rx = open_vcan();
+    if (tx < 0 || rx < 0) {
+        close(tx);
+        close(rx);
+        return;
+    }
+    struct can_frame frames[BATCH_SIZE];
+    fill_frames(frames, BATCH_SIZE);
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        for (int i = 0; i < state.range_x(); i++) {
+            if (write(tx, &frames[i], sizeof(frames[i])) != sizeof(frames[i])) {
+                break;
+            }
+        }
+        state.ResumeTiming();
+        for (int i = 0; i < state.range_x(); i++) {
+            struct can_frame frame;
+            struct iovec iov { &frame, sizeof(frame) };
+            struct msghdr msg {};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            if (recvmsg(rx, &msg, MSG_DONTWAIT) <= 0) {
+                break;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+
+    close(tx);
+    close(rx);
+}
+
+BENCHMARK(BM_RecvMsg)->Arg(1)->Arg(4)->Arg(BATCH_SIZE);
+
+static void BM_RecvMmsg(benchmark::State& state)
+{
+    int tx = open_vcan();
+    int rx = open_vcan();
+    if (tx < 0 || rx < 0) {
+        close(tx);
+        close(rx);
+        return;
+    }
+    struct can_frame frames[BATCH_SIZE];
+    struct can_frame received[BATCH_SIZE];
+    struct iovec iov[BATCH_SIZE];
+    struct mmsghdr msgs[BATCH_SIZE] {};
+    fill_frames(frames, BATCH_SIZE);
+    for (uint8_t i = 0; i < BATCH_SIZE; i++) {
+        iov[i].iov_base = &received[i];
+        iov[i].iov_len = sizeof(received[i]);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        for (int i = 0; i < state.range_x(); i++) {
+            if (write(tx, &frames[i], sizeof(frames[i])) != sizeof(frames[i])) {
+                break;
+            }
+        }
+        state.ResumeTiming();
+        recvmmsg(rx, msgs, state.range_x(), MSG_DONTWAIT, nullptr);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+
+    close(tx);
+    close(rx);
+}
+
+BENCHMARK(BM_RecvMmsg)->Arg(1)->Arg(4)->Arg(BATCH_SIZE);
+#endif
+
+BENCHMARK_MAIN()
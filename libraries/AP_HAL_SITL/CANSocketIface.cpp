@@ -74,7 +74,8 @@ int16_t CANIface::send(const AP_HAL::CANFrame& frame, const uint64_t tx_deadline
     tx_item.setup = true;
     tx_item.index = _tx_frame_counter;
     tx_item.deadline = tx_deadline;
-    if (_tx_queue.push(tx_item)) {
+    if (_tx_queue.size() < tx_queue_len) {
+        _tx_queue.push(tx_item);
         _tx_frame_counter++;
         stats.tx_requests++;
     } else {
@@ -109,7 +110,7 @@ int16_t CANIface::receive(AP_HAL::CANFrame& out_frame, uint64_t& out_timestamp_u
 bool CANIface::_hasReadyTx()
 {
     WITH_SEMAPHORE(sem);
-    return !_tx_queue.is_empty();
+    return !_tx_queue.empty();
 }
 
 bool CANIface::_hasReadyRx()
@@ -133,32 +134,48 @@ uint32_t CANIface::getErrorCount() const
     return 0;
 }
 
+/*
+  send the highest priority frames in batches, dropping frames which
+  have passed their deadline
+ */
 void CANIface::_pollWrite()
 {
     if (transport == nullptr) {
         return;
     }
-    while (_hasReadyTx()) {
-        WITH_SEMAPHORE(sem);
-        const CanTxItem *tx = _tx_queue[0];
-        if (tx == nullptr) {
-            break;
-        }
+    WITH_SEMAPHORE(sem);
+    while (!_tx_queue.empty()) {
+        CanTxItem batch[CAN_IO_BATCH_SIZE];
+        AP_HAL::CANFrame frames[CAN_IO_BATCH_SIZE];
         const uint64_t curr_time = AP_HAL::micros64();
-        if (tx->deadline >= curr_time) {
-            bool ok = transport->send(tx->frame);
-            if (ok) {
-                stats.tx_success++;
-                stats.last_transmit_us = curr_time;
+        uint16_t count = 0;
+        while (count < CAN_IO_BATCH_SIZE && !_tx_queue.empty()) {
+            const CanTxItem &tx = _tx_queue.top();
+            if (tx.deadline >= curr_time) {
+                batch[count] = tx;
+                frames[count] = tx.frame;
+                count++;
             } else {
-                break;
+                stats.tx_timedout++;
             }
-        } else {
-            stats.tx_timedout++;
+            _tx_queue.pop();
+        }
+        if (count == 0) {
+            break;
         }
 
-        // Removing the frame from the queue
-        IGNORE_RETURN(_tx_queue.pop());
+        const uint16_t sent = transport->send_batch(frames, count);
+        if (sent > 0) {
+            stats.tx_success += sent;
+            stats.last_transmit_us = curr_time;
+        }
+        if (sent < count) {
+            // the rest remain enqueued for the next retry
+            for (uint16_t i = sent; i < count; i++) {
+                _tx_queue.push(batch[i]);
+            }
+            break;
+        }
     }
 }
 
@@ -167,15 +184,20 @@ bool CANIface::_pollRead()
     if (transport == nullptr) {
         return false;
     }
-    CanRxItem rx {};
-    bool ok = transport->receive(rx.frame);
-    if (!ok) {
+    AP_HAL::CANFrame frames[CAN_IO_BATCH_SIZE];
+    uint64_t timestamps_us[CAN_IO_BATCH_SIZE];
+    const uint16_t n = transport->receive_batch(frames, timestamps_us, CAN_IO_BATCH_SIZE);
+    if (n == 0) {
         return false;
     }
-    rx.timestamp_us = AP_HAL::micros64();
     WITH_SEMAPHORE(sem);
-    add_to_rx_queue(rx);
-    stats.rx_received++;
+    for (uint16_t i = 0; i < n; i++) {
+        CanRxItem rx {};
+        rx.frame = frames[i];
+        rx.timestamp_us = timestamps_us[i];
+        add_to_rx_queue(rx);
+        stats.rx_received++;
+    }
     return true;
 }
 
@@ -185,7 +207,7 @@ void CANIface::flush_tx()
     WITH_SEMAPHORE(sem);
     do {
         _poll(true, true);
-    } while(!_tx_queue.is_empty());
+    } while(!_tx_queue.empty());
 }
 
 void CANIface::clear_rx()
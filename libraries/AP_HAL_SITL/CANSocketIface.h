@@ -25,6 +25,7 @@
 #include <memory>
 #include <map>
 #include <unordered_set>
+#include <queue>
 #include <poll.h>
 #include "CAN_Transport.h"
 
@@ -126,7 +127,9 @@ private:
     AP_HAL::BinarySemaphore *sem_handle;
 
     pollfd _pollfd;
-    ObjectArray<CanTxItem> _tx_queue{100};
+    // highest priority frame first, bounded to tx_queue_len
+    static const uint16_t tx_queue_len = 100;
+    std::priority_queue<CanTxItem> _tx_queue;
     ObjectArray<CanRxItem> _rx_queue{100};
 
     /*
@@ -9,8 +9,12 @@
 #include <poll.h>
 #include <string.h>
 #include <unistd.h>
+#include <time.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 #include <linux/can.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
 #include <errno.h>
 #include <stdlib.h>
 #include "CAN_SocketCAN.h"
@@ -43,6 +47,12 @@ bool CAN_SocketCAN::init(uint8_t instance)
         goto fail;
     }
 
+    {
+        // kernel receive timestamps, used by receive_batch() if available
+        const int ts_flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        IGNORE_RETURN(setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &ts_flags, sizeof(ts_flags)));
+    }
+
     return true;
 
 fail:
@@ -92,4 +102,95 @@ bool CAN_SocketCAN::receive(AP_HAL::CANFrame &frame)
     return true;
 }
 
+/*
+  send frames with a single sendmmsg() call
+ */
+uint16_t CAN_SocketCAN::send_batch(const AP_HAL::CANFrame *frames, uint16_t count)
+{
+    struct can_frame transmit_frames[CAN_IO_BATCH_SIZE] {};
+    struct iovec iov[CAN_IO_BATCH_SIZE];
+    struct mmsghdr msgs[CAN_IO_BATCH_SIZE] {};
+    uint16_t n = 0;
+    while (n < count && n < CAN_IO_BATCH_SIZE && !frames[n].canfd) {
+        transmit_frames[n].can_id = frames[n].id;
+        transmit_frames[n].can_dlc = frames[n].dlc;
+        memcpy(transmit_frames[n].data, frames[n].data, AP_HAL::CANFrame::dlcToDataLength(frames[n].dlc));
+        iov[n].iov_base = &transmit_frames[n];
+        iov[n].iov_len = sizeof(transmit_frames[n]);
+        msgs[n].msg_hdr.msg_iov = &iov[n];
+        msgs[n].msg_hdr.msg_iovlen = 1;
+        n++;
+    }
+    if (n == 0) {
+        return 0;
+    }
+    const int ret = sendmmsg(fd, msgs, n, MSG_DONTWAIT);
+    return ret > 0 ? ret : 0;
+}
+
+/*
+  receive frames with a single recvmmsg() call. The kernel timestamps
+  are converted to the HAL clock using their age when the batch was
+  read, as the SITL clock may not run in real time
+ */
+uint16_t CAN_SocketCAN::receive_batch(AP_HAL::CANFrame *frames, uint64_t *timestamps_us, uint16_t max)
+{
+    struct can_frame receive_frames[CAN_IO_BATCH_SIZE];
+    struct iovec iov[CAN_IO_BATCH_SIZE];
+    union {
+        uint8_t data[CMSG_SPACE(sizeof(struct scm_timestamping))];
+        struct cmsghdr align;
+    } control[CAN_IO_BATCH_SIZE];
+    struct mmsghdr msgs[CAN_IO_BATCH_SIZE] {};
+    if (max > CAN_IO_BATCH_SIZE) {
+        max = CAN_IO_BATCH_SIZE;
+    }
+    for (uint16_t i = 0; i < max; i++) {
+        iov[i].iov_base = &receive_frames[i];
+        iov[i].iov_len = sizeof(receive_frames[i]);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = control[i].data;
+        msgs[i].msg_hdr.msg_controllen = sizeof(control[i].data);
+    }
+    const int ret = recvmmsg(fd, msgs, max, MSG_DONTWAIT, nullptr);
+    if (ret <= 0) {
+        return 0;
+    }
+
+    const uint64_t now_us = AP_HAL::micros64();
+    struct timespec realtime_now {};
+    clock_gettime(CLOCK_REALTIME, &realtime_now);
+
+    uint16_t received = 0;
+    for (int i = 0; i < ret; i++) {
+        if (msgs[i].msg_len != sizeof(struct can_frame)) {
+            continue;
+        }
+        const struct can_frame &rf = receive_frames[i];
+        // run constructor to initialise
+        new(&frames[received]) AP_HAL::CANFrame(rf.can_id, rf.data, rf.can_dlc, false);
+
+        timestamps_us[received] = now_us;
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPING) {
+                continue;
+            }
+            struct scm_timestamping ts;
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            const int64_t age_us = (int64_t(realtime_now.tv_sec) - ts.ts[0].tv_sec) * 1000000LL +
+                                   (int64_t(realtime_now.tv_nsec) - ts.ts[0].tv_nsec) / 1000;
+            if (age_us > 0 && age_us < 1000000 && uint64_t(age_us) < now_us) {
+                timestamps_us[received] = now_us - age_us;
+            }
+        }
+        received++;
+    }
+
+    if (received > 0 && sem_handle != nullptr) {
+        sem_handle->signal();
+    }
+    return received;
+}
+
 #endif // HAL_NUM_CAN_IFACES
@@ -12,6 +12,8 @@ public:
     bool init(uint8_t instance) override;
     bool send(const AP_HAL::CANFrame &frame) override;
     bool receive(AP_HAL::CANFrame &frame) override;
+    uint16_t send_batch(const AP_HAL::CANFrame *frames, uint16_t count) override;
+    uint16_t receive_batch(AP_HAL::CANFrame *frames, uint64_t *timestamps_us, uint16_t max) override;
     int get_read_fd(void) const override {
         return fd;
     }
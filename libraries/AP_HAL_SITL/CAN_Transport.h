@@ -9,6 +9,9 @@
 
 #include <AP_HAL/CANIface.h>
 
+// maximum number of frames passed to send_batch() and receive_batch()
+#define CAN_IO_BATCH_SIZE 16
+
 class CAN_Transport {
 public:
     virtual ~CAN_Transport() {}
@@ -17,6 +20,30 @@ public:
     virtual bool receive(AP_HAL::CANFrame &frame) = 0;
     virtual int get_read_fd(void) const = 0;
 
+    /*
+      send frames in order, returning the number sent. Transports
+      which can send several frames in one system call override this
+     */
+    virtual uint16_t send_batch(const AP_HAL::CANFrame *frames, uint16_t count) {
+        uint16_t sent = 0;
+        while (sent < count && send(frames[sent])) {
+            sent++;
+        }
+        return sent;
+    }
+
+    /*
+      receive up to max frames with their receive timestamps,
+      returning the number received
+     */
+    virtual uint16_t receive_batch(AP_HAL::CANFrame *frames, uint64_t *timestamps_us, uint16_t max) {
+        uint16_t received = 0;
+        while (received < max && receive(frames[received])) {
+            timestamps_us[received++] = AP_HAL::micros64();
+        }
+        return received;
+    }
+
     void set_event_handle(AP_HAL::BinarySemaphore *handle) {
         sem_handle = handle;
     }
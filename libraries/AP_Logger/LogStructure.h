@@ -325,6 +325,16 @@ struct PACKED log_MAV {
     uint32_t GCS_SYSID_last_seen_ms;
 };
 
+struct PACKED log_MAVS {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t chan;
+    uint32_t link_bw;
+    uint8_t utilisation_pct;
+    uint16_t scale_pct;
+    uint16_t rate[10];
+};
+
 struct PACKED log_RSSI {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -505,6 +515,20 @@ struct PACKED log_TERRAIN {
     float reference_offset;
 };
 
+/*
+  terrain cache log structure
+ */
+struct PACKED log_TERRAIN_CACHE {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint32_t lookups;
+    uint32_t misses;
+    uint32_t mmap_loads;
+    uint32_t disk_waits;
+    float lookup_avg_us;
+    uint16_t lookup_max_us;
+};
+
 struct PACKED log_ARSP {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -637,6 +661,16 @@ struct PACKED log_Scripting {
     int32_t run_mem;
 };
 
+struct PACKED log_ScriptingProfile {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    char name[64];
+    uint32_t instructions;
+    uint32_t time;
+    uint32_t alloc;
+    uint32_t calls;
+};
+
 struct PACKED log_MotBatt {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -806,6 +840,24 @@ struct PACKED log_VER {
 // @Field: tf: times buffer was full when a message was going to be sent
 // @Field: mgs: time MAV_GCS_SYSID heartbeat (or manual control) last seen
 
+// @LoggerMessage: MAVS
+// @Description: GCS MAVLink stream shaping statistics
+// @Field: TimeUS: Time since system startup
+// @Field: chan: mavlink channel number
+// @Field: bw: estimated link capacity in bytes per second
+// @Field: util: percentage of the estimated link capacity used
+// @Field: scl: stretch applied to normal-priority stream intervals to hold the link at its target utilisation
+// @Field: R0: achieved rate of the RAW_SENS stream
+// @Field: R1: achieved rate of the EXT_STAT stream
+// @Field: R2: achieved rate of the RC_CHAN stream
+// @Field: R3: achieved rate of the RAW_CTRL stream
+// @Field: R4: achieved rate of the POSITION stream
+// @Field: R5: achieved rate of the EXTRA1 stream
+// @Field: R6: achieved rate of the EXTRA2 stream
+// @Field: R7: achieved rate of the EXTRA3 stream
+// @Field: R8: achieved rate of the PARAMS stream
+// @Field: R9: achieved rate of the ADSB stream
+
 // @LoggerMessage: MAVC
 // @Description: MAVLink command we have just executed
 // @Field: TimeUS: Time since system startup
@@ -1077,6 +1129,16 @@ struct PACKED log_VER {
 // @Field: Loaded: Number of tiles in memory
 // @Field: ROfs: terrain reference offset for arming altitude
 
+// @LoggerMessage: TERC
+// @Description: Terrain cache statistics
+// @Field: TimeUS: Time since system startup
+// @Field: Lookups: Number of grid cache lookups since boot
+// @Field: Misses: Number of grid cache lookups which did not find the grid in memory
+// @Field: MMap: Number of cache misses loaded directly from a memory mapped terrain file
+// @Field: DiskWait: Number of height lookups which found the grid still waiting for a disk read
+// @Field: LAvg: Average time taken to find the grid for a height lookup since the last message
+// @Field: LMax: Longest time taken to find the grid for a height lookup since the last message
+
 // @LoggerMessage: TSYN
 // @Description: Time synchronisation response information
 // @Field: TimeUS: Time since system startup
@@ -1136,6 +1198,15 @@ struct PACKED log_VER {
 // @Field: Total_mem: total memory usage of all scripts
 // @Field: Run_mem: run memory usage
 
+// @LoggerMessage: SCRP
+// @Description: Scripting profile, totals for a script line or binding since scripting started
+// @Field: TimeUS: Time since system startup
+// @Field: Name: script:function:line, or C: followed by the binding name
+// @Field: Instr: estimated VM instructions run
+// @Field: Time: time spent
+// @Field: Alloc: memory allocated
+// @Field: Calls: number of samples for a line, number of calls for a binding
+
 // @LoggerMessage: VER
 // @Description: Ardupilot version
 // @Field: TimeUS: Time since system startup
@@ -1229,6 +1300,8 @@ LOG_STRUCTURE_FROM_AVOIDANCE \
       "SIM","QccCfLLffff","TimeUS,Roll,Pitch,Yaw,Alt,Lat,Lng,Q1,Q2,Q3,Q4", "sddhmDU----", "FBBB0GG0000", true }, \
     { LOG_TERRAIN_MSG, sizeof(log_TERRAIN), \
       "TERR","QBLLHffHHf","TimeUS,Status,Lat,Lng,Spacing,TerrH,CHeight,Pending,Loaded,ROfs", "s-DU-mm--m", "F-GG-00--0", true }, \
+    { LOG_TERRAIN_CACHE_MSG, sizeof(log_TERRAIN_CACHE), \
+      "TERC","QIIIIfH","TimeUS,Lookups,Misses,MMap,DiskWait,LAvg,LMax", "s----ss", "F----FF" }, \
 LOG_STRUCTURE_FROM_ESC_TELEM \
 LOG_STRUCTURE_FROM_SERVO_TELEM \
     { LOG_PIDR_MSG, sizeof(log_PID), \
@@ -1262,6 +1335,8 @@ LOG_STRUCTURE_FROM_FENCE \
       "RALY", "QBBLLhB", "TimeUS,Tot,Seq,Lat,Lng,Alt,Flags", "s--DUm-", "F--GGB-" },  \
     { LOG_MAV_MSG, sizeof(log_MAV),   \
       "MAV", "QBHHHBHHI",   "TimeUS,chan,txp,rxp,rxdp,flags,ss,tf,mgs", "s#----s-s", "F-000-C-C" },   \
+    { LOG_MAVS_MSG, sizeof(log_MAVS),   \
+      "MAVS", "QBIBHHHHHHHHHHH", "TimeUS,chan,bw,util,scl,R0,R1,R2,R3,R4,R5,R6,R7,R8,R9", "s#-%%zzzzzzzzzz", "F-000BBBBBBBBBB" },   \
 LOG_STRUCTURE_FROM_VISUALODOM \
     { LOG_OPTFLOW_MSG, sizeof(log_Optflow), \
       "OF",   "QBffff",   "TimeUS,Qual,flowX,flowY,bodyX,bodyY", "s-EEEE", "F-0000" , true }, \
@@ -1285,6 +1360,8 @@ LOG_STRUCTURE_FROM_VISUALODOM \
 LOG_STRUCTURE_FROM_AIS \
     { LOG_SCRIPTING_MSG, sizeof(log_Scripting), \
       "SCR",   "QNIii", "TimeUS,Name,Runtime,Total_mem,Run_mem", "s#sbb", "F-F--", true }, \
+    { LOG_SCRIPTING_PROFILE_MSG, sizeof(log_ScriptingProfile), \
+      "SCRP",  "QZIIII", "TimeUS,Name,Instr,Time,Alloc,Calls", "s#-sb-", "F--F--", true }, \
     { LOG_VER_MSG, sizeof(log_VER), \
       "VER",   "QBHBBBBIZHBBII", "TimeUS,BT,BST,Maj,Min,Pat,FWT,GH,FWS,APJ,BU,FV,IMI,ICI", "s-------------", "F-------------", false }, \
     { LOG_MOTBATT_MSG, sizeof(log_MotBatt), \
@@ -1362,6 +1439,7 @@ enum LogMessages : uint8_t {
     LOG_EVENT_MSG,
     LOG_WHEELENCODER_MSG,
     LOG_MAV_MSG,
+    LOG_MAVS_MSG,
     LOG_ERROR_MSG,
     LOG_ADSB_MSG,
     LOG_ARM_DISARM_MSG,
@@ -1379,6 +1457,8 @@ enum LogMessages : uint8_t {
     LOG_RCOUT3_MSG,
     LOG_IDS_FROM_FENCE,
     LOG_IDS_FROM_HAL,
+    LOG_TERRAIN_CACHE_MSG,
+    LOG_SCRIPTING_PROFILE_MSG,
 
     _LOG_LAST_MSG_
 };
@@ -0,0 +1,321 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_PolygonIndex.h"
+
+#include <float.h>
+
+#pragma GCC optimize("O2")
+
+#define POLYGON_INDEX_BANDS_MAX     64      // maximum number of bands
+#define POLYGON_INDEX_PRUNE_SCALE   1.001f  // bands are skipped only if clearly further away than the closest edge found
+
+template <typename T>
+void AP_PolygonIndex<T>::clear()
+{
+    delete[] _band_start;
+    _band_start = nullptr;
+    delete[] _band_edges;
+    _band_edges = nullptr;
+    _points = nullptr;
+    _num_edges = 0;
+    _num_bands = 0;
+}
+
+template <typename T>
+bool AP_PolygonIndex<T>::init(const Vector2<T> *V, unsigned n)
+{
+    clear();
+
+    if (V == nullptr || n == 0) {
+        return false;
+    }
+
+    // treat the polygon the same way as the Polygon_*() functions do
+    _complete = Polygon_complete(V, n);
+    if (_complete) {
+        n--;
+    }
+    if (n > UINT16_MAX) {
+        return false;
+    }
+    _points = V;
+    _num_edges = n;
+
+    _bb_min = _bb_max = V[0];
+    for (uint16_t i = 1; i < _num_edges; i++) {
+        _bb_min.x = MIN(_bb_min.x, V[i].x);
+        _bb_min.y = MIN(_bb_min.y, V[i].y);
+        _bb_max.x = MAX(_bb_max.x, V[i].x);
+        _bb_max.y = MAX(_bb_max.y, V[i].y);
+    }
+
+    // roughly two edges per band
+    _num_bands = constrain_int16(_num_edges / 2, 1, POLYGON_INDEX_BANDS_MAX);
+    _band_origin = float(_bb_min.y);
+    _band_height = (float(_bb_max.y) - _band_origin) / _num_bands;
+    if (!is_positive(_band_height)) {
+        _num_bands = 1;
+        _band_height = 1.0f;
+        _band_height_inv = 0.0f;
+    } else {
+        _band_height_inv = 1.0f / _band_height;
+    }
+
+    _band_start = NEW_NOTHROW uint16_t[_num_bands + 1];
+    if (_band_start == nullptr) {
+        clear();
+        return false;
+    }
+    memset(_band_start, 0, (_num_bands + 1) * sizeof(uint16_t));
+
+    // count the edges in each band
+    uint32_t total = 0;
+    for (uint16_t i = 0; i < _num_edges; i++) {
+        const uint16_t lo = edge_first_band(i);
+        const uint16_t hi = band_of(MAX(edge_start(i).y, edge_end(i).y));
+        for (uint16_t b = lo; b <= hi; b++) {
+            _band_start[b]++;
+        }
+        total += hi - lo + 1;
+    }
+    if (total > UINT16_MAX) {
+        clear();
+        return false;
+    }
+
+    // convert counts to the end of each band's edges
+    for (uint16_t b = 1; b < _num_bands; b++) {
+        _band_start[b] += _band_start[b-1];
+    }
+    _band_start[_num_bands] = total;
+
+    _band_edges = NEW_NOTHROW uint16_t[total];
+    if (_band_edges == nullptr) {
+        clear();
+        return false;
+    }
+
+    // fill each band from its end, leaving _band_start at the start of each band
+    for (uint16_t i = 0; i < _num_edges; i++) {
+        const uint16_t lo = edge_first_band(i);
+        const uint16_t hi = band_of(MAX(edge_start(i).y, edge_end(i).y));
+        for (uint16_t b = lo; b <= hi; b++) {
+            _band_edges[--_band_start[b]] = i;
+        }
+    }
+
+    return true;
+}
+
+// band holding a y coordinate (clamped to the bands).  This is
+// monotonic in y so an edge is always in the band of any y
+// coordinate along it
+template <typename T>
+uint16_t AP_PolygonIndex<T>::band_of(float y) const
+{
+    const float b = (y - _band_origin) * _band_height_inv;
+    if (!(b > 0)) {
+        return 0;
+    }
+    if (b >= _num_bands) {
+        return _num_bands - 1;
+    }
+    return uint16_t(b);
+}
+
+// call fn(edge) for each edge held in bands lo to hi, once per edge
+template <typename T>
+template <typename F>
+void AP_PolygonIndex<T>::for_each_edge(uint16_t lo, uint16_t hi, F fn) const
+{
+    for (uint16_t b = lo; b <= hi; b++) {
+        for (uint16_t k = _band_start[b]; k < _band_start[b+1]; k++) {
+            const uint16_t i = _band_edges[k];
+            // edges spanning several bands are visited in the first one
+            if (MAX(edge_first_band(i), lo) == b) {
+                fn(i);
+            }
+        }
+    }
+}
+
+// visit bands outwards from lo..hi, calling fn(edge) for each edge while
+// edges in the band could be closer than closest_sq.  Bands are only
+// skipped if they are clearly further away than closest_sq so rounding
+// cannot change which edge is closest
+template <typename T>
+template <typename F>
+void AP_PolygonIndex<T>::for_each_edge_nearest(uint16_t lo, uint16_t hi, float y_lo, float y_hi, const float &closest_sq, F fn) const
+{
+    for_each_edge(lo, hi, fn);
+
+    // allow for rounding in the band boundaries
+    const float margin = 0.01f * _band_height + 8 * FLT_EPSILON * (fabsf(_band_origin) + _num_bands * _band_height);
+
+    bool down = lo > 0;
+    bool up = hi + 1 < _num_bands;
+    for (uint16_t d = 1; down || up; d++) {
+        if (down) {
+            const uint16_t b = lo - d;
+            const float gap = y_lo - band_hi(b) - margin;
+            if (is_positive(gap) && sq(gap) > closest_sq * POLYGON_INDEX_PRUNE_SCALE) {
+                down = false;
+            } else {
+                for (uint16_t k = _band_start[b]; k < _band_start[b+1]; k++) {
+                    const uint16_t i = _band_edges[k];
+                    // edges also in the band above have already been visited
+                    if (band_of(MAX(edge_start(i).y, edge_end(i).y)) == b) {
+                        fn(i);
+                    }
+                }
+                down = b > 0;
+            }
+        }
+        if (up) {
+            const uint16_t b = hi + d;
+            const float gap = band_lo(b) - y_hi - margin;
+            if (is_positive(gap) && sq(gap) > closest_sq * POLYGON_INDEX_PRUNE_SCALE) {
+                up = false;
+            } else {
+                for (uint16_t k = _band_start[b]; k < _band_start[b+1]; k++) {
+                    const uint16_t i = _band_edges[k];
+                    // edges also in the band below have already been visited
+                    if (edge_first_band(i) == b) {
+                        fn(i);
+                    }
+                }
+                up = b + 1 < _num_bands;
+            }
+        }
+    }
+}
+
+// same as Polygon_outside(P, V, n)
+template <typename T>
+bool AP_PolygonIndex<T>::outside(const Vector2<T> &P) const
+{
+    // no edges can be crossed if P is above or below the polygon
+    if (P.y < _bb_min.y || P.y > _bb_max.y) {
+        return true;
+    }
+
+    // only edges spanning P.y can be crossed, and these are all in P's band
+    const uint16_t b = band_of(float(P.y));
+    bool outside = true;
+    for (uint16_t k = _band_start[b]; k < _band_start[b+1]; k++) {
+        const uint16_t i = _band_edges[k];
+        if (Polygon_edge_crosses(P, edge_start(i), edge_end(i))) {
+            outside = !outside;
+        }
+    }
+    return outside;
+}
+
+// same as Polygon_intersects(V, n, p1, p2, intersection)
+template <typename T>
+bool AP_PolygonIndex<T>::intersects(const Vector2f &p1, const Vector2f &p2, Vector2f &intersection) const
+{
+    const float y_lo = MIN(p1.y, p2.y);
+    const float y_hi = MAX(p1.y, p2.y);
+    if (y_hi < _bb_min.y || y_lo > _bb_max.y) {
+        return false;
+    }
+    if (MAX(p1.x, p2.x) < _bb_min.x || MIN(p1.x, p2.x) > _bb_max.x) {
+        return false;
+    }
+
+    // the closest intersection to p1, taking the first edge if several are equally close
+    float intersect_dist_sq = FLT_MAX;
+    uint16_t intersect_edge = UINT16_MAX;
+    for_each_edge(band_of(y_lo), band_of(y_hi), [&](uint16_t i) {
+        Vector2f intersect_tmp;
+        if (Polygon_edge_intersects(edge_start(i), edge_end(i), p1, p2, intersect_tmp)) {
+            const float dist_sq = sq(intersect_tmp.x - p1.x) + sq(intersect_tmp.y - p1.y);
+            if (dist_sq < intersect_dist_sq || (dist_sq == intersect_dist_sq && i < intersect_edge)) {
+                intersect_dist_sq = dist_sq;
+                intersect_edge = i;
+                intersection = intersect_tmp;
+            }
+        }
+    });
+    return (intersect_dist_sq < FLT_MAX);
+}
+
+// same as Polygon_closest_distance_line(V, n, p1, p2)
+template <typename T>
+float AP_PolygonIndex<T>::closest_distance_line(const Vector2f &p1, const Vector2f &p2) const
+{
+    Vector2f intersection;
+    if (intersects(p1, p2, intersection)) {
+        return -sqrtf(sq(intersection.x - p2.x) + sq(intersection.y - p2.y));
+    }
+
+    // Polygon_closest_distance_line() does not check the edge from
+    // the last point back to the first unless it was passed in
+    const uint16_t skip_edge = _complete ? UINT16_MAX : _num_edges - 1;
+
+    const float y_lo = MIN(p1.y, p2.y);
+    const float y_hi = MAX(p1.y, p2.y);
+    float closest_sq = FLT_MAX;
+    for_each_edge_nearest(band_of(y_lo), band_of(y_hi), y_lo, y_hi, closest_sq, [&](uint16_t i) {
+        if (i == skip_edge) {
+            return;
+        }
+        const float dist_sq = Vector2f::closest_distance_between_lines_squared(edge_start(i), edge_end(i), p1, p2);
+        if (dist_sq < closest_sq) {
+            closest_sq = dist_sq;
+        }
+    });
+    return sqrtf(closest_sq);
+}
+
+// same as Polygon_closest_distance_point(V, n, p, closest_vec)
+template <typename T>
+bool AP_PolygonIndex<T>::closest_distance_point(const Vector2f &p, Vector2f &closest_vec) const
+{
+    if (_num_edges < 3) {
+        return false;
+    }
+
+    // the closest edge, taking the first edge if several are equally close
+    float closest_sq = FLT_MAX;
+    uint16_t closest_edge = UINT16_MAX;
+    Vector2f best_v(0.0f, 0.0f);
+    const uint16_t b = band_of(p.y);
+    for_each_edge_nearest(b, b, p.y, p.y, closest_sq, [&](uint16_t i) {
+        const Vector2f q = Vector2f::closest_point(p, edge_start(i), edge_end(i));
+        const Vector2f v = q - p;
+        const float vsq = v.length_squared();
+        if (vsq < closest_sq || (vsq == closest_sq && i < closest_edge)) {
+            closest_sq = vsq;
+            closest_edge = i;
+            best_v = v;
+        }
+    });
+
+    if (is_equal(closest_sq, FLT_MAX)) {
+        return false;
+    }
+
+    closest_vec = best_v;
+    return true;
+}
+
+// Necessary to avoid linker errors
+template class AP_PolygonIndex<float>;
+template bool AP_PolygonIndex<int32_t>::init(const Vector2l *V, unsigned n);
+template void AP_PolygonIndex<int32_t>::clear();
+template bool AP_PolygonIndex<int32_t>::outside(const Vector2l &P) const;
@@ -0,0 +1,107 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "AP_Math.h"
+
+/*
+  AP_PolygonIndex speeds up repeated queries against a large polygon.
+
+  The polygon's edges are sorted into horizontal bands so a query only
+  tests the edges in the bands it touches.  Each query applies the same
+  per-edge test as the equivalent Polygon_*() function, and breaks ties
+  in the same order, so the answer is identical to the brute-force one.
+
+  The index refers to the polygon's points rather than copying them, so
+  the points must not change or be freed while the index is in use.
+ */
+template <typename T>
+class AP_PolygonIndex {
+public:
+    AP_PolygonIndex() {}
+    ~AP_PolygonIndex() { clear(); }
+
+    CLASS_NO_COPY(AP_PolygonIndex);
+
+    // index the polygon of n points defined by V.  returns false if
+    // out of memory, in which case valid() is false
+    bool init(const Vector2<T> *V, unsigned n);
+
+    // free the index
+    void clear();
+
+    // true if init() has succeeded
+    bool valid() const { return _band_start != nullptr; }
+
+    // bounding box of the polygon's points
+    const Vector2<T> &bb_min() const { return _bb_min; }
+    const Vector2<T> &bb_max() const { return _bb_max; }
+
+    // same as Polygon_outside(P, V, n)
+    bool outside(const Vector2<T> &P) const WARN_IF_UNUSED;
+
+    // same as Polygon_intersects(V, n, p1, p2, intersection)
+    bool intersects(const Vector2f &p1, const Vector2f &p2, Vector2f &intersection) const WARN_IF_UNUSED;
+
+    // same as Polygon_closest_distance_line(V, n, p1, p2)
+    float closest_distance_line(const Vector2f &p1, const Vector2f &p2) const;
+
+    // same as Polygon_closest_distance_point(V, n, p, closest_vec)
+    bool closest_distance_point(const Vector2f &p, Vector2f &closest_vec) const WARN_IF_UNUSED;
+
+private:
+
+    // edge i runs from point i to point i+1, wrapping at the end
+    const Vector2<T> &edge_start(uint16_t i) const { return _points[i]; }
+    const Vector2<T> &edge_end(uint16_t i) const { return _points[(i + 1 >= _num_edges) ? 0 : i + 1]; }
+
+    // band holding a y coordinate (clamped to the bands)
+    uint16_t band_of(float y) const;
+
+    // lowest and highest y coordinate of an edge's band
+    float band_lo(uint16_t band) const { return _band_origin + band * _band_height; }
+    float band_hi(uint16_t band) const { return _band_origin + (band + 1) * _band_height; }
+
+    // first band an edge is held in
+    uint16_t edge_first_band(uint16_t i) const {
+        return band_of(MIN(edge_start(i).y, edge_end(i).y));
+    }
+
+    // call fn(edge) for each edge held in bands lo to hi, once per edge
+    template <typename F>
+    void for_each_edge(uint16_t lo, uint16_t hi, F fn) const;
+
+    // visit bands outwards from lo..hi, calling fn(edge) for each edge
+    // while edges in the band could be closer than closest_sq
+    template <typename F>
+    void for_each_edge_nearest(uint16_t lo, uint16_t hi, float y_lo, float y_hi, const float &closest_sq, F fn) const;
+
+    const Vector2<T> *_points;
+    uint16_t _num_edges;            // number of points with any closing point removed
+    bool _complete;                 // true if the polygon was passed in with a closing point
+
+    Vector2<T> _bb_min;
+    Vector2<T> _bb_max;
+
+    float _band_origin;             // lowest y coordinate of the first band
+    float _band_height;
+    float _band_height_inv;
+    uint16_t _num_bands;
+
+    // edges in each band: the edges in band b are
+    // _band_edges[_band_start[b]] to _band_edges[_band_start[b+1]-1]
+    uint16_t *_band_start = nullptr;
+    uint16_t *_band_edges = nullptr;
+};
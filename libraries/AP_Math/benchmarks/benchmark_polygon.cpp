@@ -0,0 +1,83 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/AP_PolygonIndex.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define POLYGON_POINTS 200
+
+// irregular star shaped polygon around the origin
+static void make_polygon(Vector2f *V, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        const float angle = M_2PI * i / n;
+        const float radius = 100000.0f + 50000.0f * sinf(9 * angle);
+        V[i] = Vector2f{radius * cosf(angle), radius * sinf(angle)};
+    }
+}
+
+static void BM_PolygonOutside(benchmark::State& state)
+{
+    Vector2f V[POLYGON_POINTS];
+    make_polygon(V, POLYGON_POINTS);
+    uint32_t k = 0;
+    while (state.KeepRunning()) {
+        const Vector2f p{float(k % 2000) * 100.0f - 100000.0f, float(k % 1999) * 100.0f - 100000.0f};
+        bool outside = Polygon_outside(p, V, POLYGON_POINTS);
+        gbenchmark_escape(&outside);
+        k++;
+    }
+}
+
+static void BM_PolygonIndexOutside(benchmark::State& state)
+{
+    Vector2f V[POLYGON_POINTS];
+    make_polygon(V, POLYGON_POINTS);
+    AP_PolygonIndex<float> index;
+    IGNORE_RETURN(index.init(V, POLYGON_POINTS));
+    uint32_t k = 0;
+    while (state.KeepRunning()) {
+        const Vector2f p{float(k % 2000) * 100.0f - 100000.0f, float(k % 1999) * 100.0f - 100000.0f};
+        bool outside = index.outside(p);
+        gbenchmark_escape(&outside);
+        k++;
+    }
+}
+
+static void BM_PolygonClosestDistanceLine(benchmark::State& state)
+{
+    Vector2f V[POLYGON_POINTS];
+    make_polygon(V, POLYGON_POINTS);
+    uint32_t k = 0;
+    while (state.KeepRunning()) {
+        const Vector2f p1{float(k % 2000) * 100.0f - 100000.0f, float(k % 1999) * 100.0f - 100000.0f};
+        const Vector2f p2 = p1 + Vector2f{1000.0f, 500.0f};
+        float distance = Polygon_closest_distance_line(V, POLYGON_POINTS, p1, p2);
+        gbenchmark_escape(&distance);
+        k++;
+    }
+}
+
+static void BM_PolygonIndexClosestDistanceLine(benchmark::State& state)
+{
+    Vector2f V[POLYGON_POINTS];
+    make_polygon(V, POLYGON_POINTS);
+    AP_PolygonIndex<float> index;
+    IGNORE_RETURN(index.init(V, POLYGON_POINTS));
+    uint32_t k = 0;
+    while (state.KeepRunning()) {
+        const Vector2f p1{float(k % 2000) * 100.0f - 100000.0f, float(k % 1999) * 100.0f - 100000.0f};
+        const Vector2f p2 = p1 + Vector2f{1000.0f, 500.0f};
+        float distance = index.closest_distance_line(p1, p2);
+        gbenchmark_escape(&distance);
+        k++;
+    }
+}
+
+BENCHMARK(BM_PolygonOutside);
+BENCHMARK(BM_PolygonIndexOutside);
+BENCHMARK(BM_PolygonClosestDistanceLine);
+BENCHMARK(BM_PolygonIndexClosestDistanceLine);
+
+BENCHMARK_MAIN();
@@ -55,57 +55,56 @@ bool Polygon_outside(const Vector2<T> &P, const Vector2<T> *V, unsigned n)
         if (j >= n) {
             j = 0;
         }
-        if ((V[i].y > P.y) == (V[j].y > P.y)) {
-            continue;
-        }
-        const T dx1 = P.x - V[i].x;
-        const T dx2 = V[j].x - V[i].x;
-        const T dy1 = P.y - V[i].y;
-        const T dy2 = V[j].y - V[i].y;
-        const int8_t dx1s = (dx1 < 0) ? -1 : 1;
-        const int8_t dx2s = (dx2 < 0) ? -1 : 1;
-        const int8_t dy1s = (dy1 < 0) ? -1 : 1;
-        const int8_t dy2s = (dy2 < 0) ? -1 : 1;
-        const int8_t m1 = dx1s * dy2s;
-        const int8_t m2 = dx2s * dy1s;
-        // we avoid the 64 bit multiplies if we can based on sign checks.
-        if (dy2 < 0) {
-            if (m1 > m2) {
-                outside = !outside;
-            } else if (m1 < m2) {
-                continue;
-            } else {
-                if (std::is_floating_point<T>::value) {
-                    if ( dx1 * dy2 > dx2 * dy1 ) {
-                        outside = !outside;
-                    }
-                } else {
-                    if ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 ) {
-                        outside = !outside;
-                    }
-                }
-            }
-        } else {
-            if (m1 < m2) {
-                outside = !outside;
-            } else if (m1 > m2) {
-                continue;
-            } else {
-                if (std::is_floating_point<T>::value) {
-                    if ( dx1 * dy2 < dx2 * dy1 ) {
-                        outside = !outside;
-                    }
-                } else {
-                    if ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 ) {
-                        outside = !outside;
-                    }
-                }
-            }
+        if (Polygon_edge_crosses(P, V[i], V[j])) {
+            outside = !outside;
         }
     }
     return outside;
 }
 
+/*
+  return true if a ray from P crosses the edge from V1 to V2.  A point
+  is outside a polygon if an even number of its edges are crossed
+ */
+template <typename T>
+bool Polygon_edge_crosses(const Vector2<T> &P, const Vector2<T> &V1, const Vector2<T> &V2)
+{
+    if ((V1.y > P.y) == (V2.y > P.y)) {
+        return false;
+    }
+    const T dx1 = P.x - V1.x;
+    const T dx2 = V2.x - V1.x;
+    const T dy1 = P.y - V1.y;
+    const T dy2 = V2.y - V1.y;
+    const int8_t dx1s = (dx1 < 0) ? -1 : 1;
+    const int8_t dx2s = (dx2 < 0) ? -1 : 1;
+    const int8_t dy1s = (dy1 < 0) ? -1 : 1;
+    const int8_t dy2s = (dy2 < 0) ? -1 : 1;
+    const int8_t m1 = dx1s * dy2s;
+    const int8_t m2 = dx2s * dy1s;
+    // we avoid the 64 bit multiplies if we can based on sign checks.
+    if (dy2 < 0) {
+        if (m1 > m2) {
+            return true;
+        } else if (m1 < m2) {
+            return false;
+        }
+        if (std::is_floating_point<T>::value) {
+            return ( dx1 * dy2 > dx2 * dy1 );
+        }
+        return ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 );
+    }
+    if (m1 < m2) {
+        return true;
+    } else if (m1 > m2) {
+        return false;
+    }
+    if (std::is_floating_point<T>::value) {
+        return ( dx1 * dy2 < dx2 * dy1 );
+    }
+    return ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 );
+}
+
 /*
  *  check if a polygon is complete.
  *
@@ -122,8 +121,10 @@ bool Polygon_complete(const Vector2<T> *V, unsigned n)
 // Necessary to avoid linker errors
 template bool Polygon_outside<int32_t>(const Vector2l &P, const Vector2l *V, unsigned n);
 template bool Polygon_complete<int32_t>(const Vector2l *V, unsigned n);
+template bool Polygon_edge_crosses<int32_t>(const Vector2l &P, const Vector2l &V1, const Vector2l &V2);
 template bool Polygon_outside<float>(const Vector2f &P, const Vector2f *V, unsigned n);
 template bool Polygon_complete<float>(const Vector2f *V, unsigned n);
+template bool Polygon_edge_crosses<float>(const Vector2f &P, const Vector2f &V1, const Vector2f &V2);
 
 /*
   determine if the polygon of N verticies defined by points V is
@@ -145,23 +146,8 @@ bool Polygon_intersects(const Vector2f *V, unsigned N, const Vector2f &p1, const
         if (j >= N) {
             j = 0;
         }
-        const Vector2f &v1 = V[i];
-        const Vector2f &v2 = V[j];
-        // optimisations for common cases
-        if (v1.x > p1.x && v2.x > p1.x && v1.x > p2.x && v2.x > p2.x) {
-            continue;
-        }
-        if (v1.y > p1.y && v2.y > p1.y && v1.y > p2.y && v2.y > p2.y) {
-            continue;
-        }
-        if (v1.x < p1.x && v2.x < p1.x && v1.x < p2.x && v2.x < p2.x) {
-            continue;
-        }
-        if (v1.y < p1.y && v2.y < p1.y && v1.y < p2.y && v2.y < p2.y) {
-            continue;
-        }
         Vector2f intersect_tmp;
-        if (Vector2f::segment_intersection(v1,v2,p1,p2,intersect_tmp)) {
+        if (Polygon_edge_intersects(V[i], V[j], p1, p2, intersect_tmp)) {
             float dist_sq = sq(intersect_tmp.x - p1.x) + sq(intersect_tmp.y - p1.y);
             if (dist_sq < intersect_dist_sq) {
                 intersect_dist_sq = dist_sq;
@@ -172,6 +158,28 @@ bool Polygon_intersects(const Vector2f *V, unsigned N, const Vector2f &p1, const
     return (intersect_dist_sq < FLT_MAX);
 }
 
+/*
+  determine if the edge from v1 to v2 is intersected by a line from
+  point p1 to point p2
+ */
+bool Polygon_edge_intersects(const Vector2f &v1, const Vector2f &v2, const Vector2f &p1, const Vector2f &p2, Vector2f &intersection)
+{
+    // optimisations for common cases
+    if (v1.x > p1.x && v2.x > p1.x && v1.x > p2.x && v2.x > p2.x) {
+        return false;
+    }
+    if (v1.y > p1.y && v2.y > p1.y && v1.y > p2.y && v2.y > p2.y) {
+        return false;
+    }
+    if (v1.x < p1.x && v2.x < p1.x && v1.x < p2.x && v2.x < p2.x) {
+        return false;
+    }
+    if (v1.y < p1.y && v2.y < p1.y && v1.y < p2.y && v2.y < p2.y) {
+        return false;
+    }
+    return Vector2f::segment_intersection(v1,v2,p1,p2,intersection);
+}
+
 /*
   return the closest distance that a line from p1 to p2 comes to an
   edge of closed polygon V, defined by N points
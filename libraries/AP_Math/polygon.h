@@ -24,6 +24,13 @@ bool        Polygon_outside(const Vector2<T> &P, const Vector2<T> *V, unsigned n
 template <typename T>
 bool        Polygon_complete(const Vector2<T> *V, unsigned n) WARN_IF_UNUSED;
 
+/*
+  return true if a ray from P crosses the edge from V1 to V2.  This is
+  the per-edge test used by Polygon_outside()
+ */
+template <typename T>
+bool        Polygon_edge_crosses(const Vector2<T> &P, const Vector2<T> &V1, const Vector2<T> &V2) WARN_IF_UNUSED;
+
 /*
   determine if the polygon of N verticies defined by points V is
   intersected by a line from point p1 to point p2
@@ -31,6 +38,12 @@ bool        Polygon_complete(const Vector2<T> *V, unsigned n) WARN_IF_UNUSED;
  */
 bool Polygon_intersects(const Vector2f *V, unsigned N, const Vector2f &p1, const Vector2f &p2, Vector2f &intersection) WARN_IF_UNUSED;
 
+/*
+  determine if the edge from v1 to v2 is intersected by a line from
+  point p1 to point p2.  This is the per-edge test used by Polygon_intersects()
+ */
+bool Polygon_edge_intersects(const Vector2f &v1, const Vector2f &v2, const Vector2f &p1, const Vector2f &p2, Vector2f &intersection) WARN_IF_UNUSED;
+
 
 /*
   return the closest distance that a line from p1 to p2 comes to an
@@ -2,6 +2,7 @@
 #include <AP_Common/AP_Common.h>
 
 #include <AP_Math/AP_Math.h>
+#include <AP_Math/AP_PolygonIndex.h>
 
 struct PB {
     Vector2f point;
@@ -355,6 +356,79 @@ TEST(Polygon, simple)
     TEST_POLYGON_POINTS(SIMPLE_boundary, SIMPLE_test_points);
 }
 
+// irregular star shaped polygon of n points around the origin
+static void make_star_polygon(Vector2f *V, uint16_t n, bool closed)
+{
+    const uint16_t num_points = closed ? n - 1 : n;
+    for (uint16_t i = 0; i < num_points; i++) {
+        const float angle = M_2PI * i / num_points;
+        const float radius = 1000.0f + 800.0f * sinf(7 * angle) * cosf(3 * angle) + (rand() % 200);
+        V[i] = Vector2f{radius * cosf(angle), radius * sinf(angle)};
+    }
+    if (closed) {
+        V[n-1] = V[0];
+    }
+}
+
+static Vector2f random_point(float range)
+{
+    return Vector2f{range * ((rand() % 20001) - 10000) * 0.0001f,
+                    range * ((rand() % 20001) - 10000) * 0.0001f};
+}
+
+// the index must give exactly the same answers as the Polygon_*() functions
+TEST(Polygon, index_equal_to_brute_force)
+{
+    srand(1);
+    static const uint16_t sizes[] { 3, 4, 10, 51, 200 };
+    for (const uint16_t n : sizes) {
+        for (const bool closed : { false, true }) {
+            Vector2f V[200];
+            make_star_polygon(V, n, closed);
+            AP_PolygonIndex<float> index;
+            ASSERT_TRUE(index.init(V, n));
+            for (uint16_t k = 0; k < 2000; k++) {
+                const Vector2f p1 = random_point(2500);
+                const Vector2f p2 = (k % 2) ? random_point(2500) : p1 + random_point(200);
+
+                EXPECT_EQ(Polygon_outside(p1, V, n), index.outside(p1));
+
+                Vector2f intersection_brute, intersection_index;
+                const bool intersects = Polygon_intersects(V, n, p1, p2, intersection_brute);
+                EXPECT_EQ(intersects, index.intersects(p1, p2, intersection_index));
+                if (intersects) {
+                    EXPECT_EQ(intersection_brute, intersection_index);
+                }
+
+                EXPECT_EQ(Polygon_closest_distance_line(V, n, p1, p2), index.closest_distance_line(p1, p2));
+
+                Vector2f closest_brute, closest_index;
+                const bool found = Polygon_closest_distance_point(V, n, p1, closest_brute);
+                EXPECT_EQ(found, index.closest_distance_point(p1, closest_index));
+                if (found) {
+                    EXPECT_EQ(closest_brute, closest_index);
+                }
+            }
+            // polygon vertices lie on band boundaries
+            for (uint16_t i = 0; i < n; i++) {
+                EXPECT_EQ(Polygon_outside(V[i], V, n), index.outside(V[i]));
+            }
+        }
+    }
+}
+
+TEST(Polygon, index_outside_long)
+{
+    AP_PolygonIndex<int32_t> index;
+    ASSERT_TRUE(index.init(OBC_boundary, ARRAY_SIZE(OBC_boundary)));
+    for (uint32_t i = 0; i < ARRAY_SIZE(OBC_test_points); i++) {
+        EXPECT_EQ(OBC_test_points[i].outside, index.outside(OBC_test_points[i].point));
+    }
+    for (uint32_t i = 0; i < ARRAY_SIZE(OBC_boundary); i++) {
+        EXPECT_EQ(Polygon_outside(OBC_boundary[i], OBC_boundary, ARRAY_SIZE(OBC_boundary)), index.outside(OBC_boundary[i]));
+    }
+}
+
 AP_GTEST_MAIN()
 
 
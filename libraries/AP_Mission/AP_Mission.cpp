@@ -302,9 +302,107 @@ void AP_Mission::truncate(uint16_t index)
     if ((unsigned)_cmd_total > index) {
         _cmd_total.set_and_save(index);
         _last_change_time_ms = AP_HAL::millis();
+#if AP_MISSION_CMD_CACHE_ENABLED
+        WITH_SEMAPHORE(_rsem);
+        invalidate_cmd_cache();
+#endif
     }
 }
 
+/// begin_staged_upload - prepare to stage num_cmds commands which will be placed at index start
+///     the staging area is at the end of storage so it is clear of the current mission and of
+///     the commands' final positions whenever they are beyond the current mission
+bool AP_Mission::begin_staged_upload(uint16_t start, uint16_t num_cmds)
+{
+    WITH_SEMAPHORE(_rsem);
+
+    _staged.valid = false;
+
+    // slot 0 is always home so is never used for staging
+    const uint16_t in_use = MAX(unsigned(_cmd_total), 1U);
+    if (num_cmds > num_commands_max() ||
+        num_commands_max() - num_cmds < in_use ||
+        start > in_use) {
+        return false;
+    }
+
+    _staged.base = num_commands_max() - num_cmds;
+    _staged.start = start;
+    _staged.count = num_cmds;
+    _staged.written = 0;
+    _staged.valid = true;
+    return true;
+}
+
+/// write_staged_cmd - write the i'th command of a staged upload to storage
+///     commands must be written in order
+bool AP_Mission::write_staged_cmd(uint16_t i, const Mission_Command& cmd)
+{
+    WITH_SEMAPHORE(_rsem);
+
+    if (!_staged.valid || i != _staged.written || i >= _staged.count) {
+        return false;
+    }
+    if (!pack_cmd_to_storage(_staged.base + i, cmd)) {
+        return false;
+    }
+    _staged.written++;
+    return true;
+}
+
+/// commit_staged_upload - copy all staged commands into place, clearing the mission first if clear_mission is true
+///     this has the same result as clear() followed by add_cmd() or replace_cmd() for each command
+bool AP_Mission::commit_staged_upload(bool clear_mission)
+{
+    WITH_SEMAPHORE(_rsem);
+
+    if (!_staged.valid || _staged.written != _staged.count) {
+        _staged.valid = false;
+        return false;
+    }
+    _staged.valid = false;
+
+    if (clear_mission) {
+        // as with a MAVLink upload the commands overwrite the running mission if it can't be cleared
+        clear();
+    }
+    if (_staged.start > (unsigned)_cmd_total) {
+        // there would be a gap in the mission
+        return false;
+    }
+    if (_staged.count > 0 && _cmd_total < 1) {
+        write_home_to_storage();
+    }
+
+    // copy in ascending order.  Each command's final index is never
+    // beyond its staged index so no staged command is overwritten
+    // before it has been copied
+    for (uint16_t i=0; i<_staged.count; i++) {
+        const uint16_t index = _staged.start + i;
+        if (index == 0) {
+            // home is never replaced by an upload
+            continue;
+        }
+        uint8_t b[AP_MISSION_EEPROM_COMMAND_SIZE];
+        const uint16_t src = 4 + ((_staged.base + i) * AP_MISSION_EEPROM_COMMAND_SIZE);
+        const uint16_t dst = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
+        if (src != dst &&
+            (!_storage.read_block(b, src, sizeof(b)) || !_storage.write_block(dst, b, sizeof(b)))) {
+            return false;
+        }
+    }
+
+    const uint16_t end = _staged.start + _staged.count;
+    if (end > (unsigned)_cmd_total) {
+        _cmd_total.set_and_save(end);
+    }
+    _last_change_time_ms = AP_HAL::millis();
+#if AP_MISSION_CMD_CACHE_ENABLED
+    invalidate_cmd_cache();
+#endif
+    return true;
+}
+
 /// update - ensures the command queues are loaded with the next command and calls main programs command_init and command_verify functions to progress the mission
 ///     should be called at 10hz or higher
 void AP_Mission::update()
@@ -325,6 +423,10 @@ void AP_Mission::update()
     // save persistent waypoint_num for watchdog restore
     hal.util->persistent_data.waypoint_num = _nav_cmd.index;
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    update_cmd_cache();
+#endif
+
     // check if we have an active nav command
     if (!_flags.nav_cmd_loaded || _nav_cmd.index == AP_MISSION_CMD_INDEX_NONE) {
         // advance in mission if no active nav command
@@ -553,6 +655,18 @@ bool AP_Mission::get_next_nav_cmd(uint16_t start_index, Mission_Command& cmd)
 {
     // search until the end of the mission command list
     for (uint16_t cmd_index = start_index; cmd_index < (unsigned)_cmd_total; cmd_index++) {
+#if AP_MISSION_CMD_CACHE_ENABLED
+        {
+            // skip straight over "do" commands, which would be passed over below
+            WITH_SEMAPHORE(_rsem);
+            if (cmd_cache_valid()) {
+                cmd_index = _cmd_cache.entries[cmd_index].next_nav_or_jump;
+                if (cmd_index >= (unsigned)_cmd_total) {
+                    return false;
+                }
+            }
+        }
+#endif
         // get next command
         if (!get_next_cmd(cmd_index, cmd, false)) {
             // no more commands so return failure
@@ -832,6 +946,20 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         return false;
     }
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    if (cmd_cache_valid()) {
+        cmd = _cmd_cache.entries[index].cmd;
+        return true;
+    }
+#endif
+
+    return decode_cmd_from_storage(index, cmd);
+}
+
+/// decode_cmd_from_storage - decode a command from storage, index must be in range
+///     true is return if successful
+bool AP_Mission::decode_cmd_from_storage(uint16_t index, Mission_Command& cmd) const
+{
     // ensure all bytes of cmd are zeroed
     cmd = {};
 
@@ -936,6 +1064,32 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
 {
     WITH_SEMAPHORE(_rsem);
 
+    if (!pack_cmd_to_storage(index, cmd)) {
+        return false;
+    }
+
+    // a staged upload can't be committed once anything is written over it
+    if (_staged.valid && index >= _staged.base) {
+        _staged.valid = false;
+    }
+
+    // remember when the mission last changed
+    if (index != 0) {
+        // Update of home location is not a true change
+        _last_change_time_ms = AP_HAL::millis();
+#if AP_MISSION_CMD_CACHE_ENABLED
+        invalidate_cmd_cache();
+#endif
+    }
+
+    // return success
+    return true;
+}
+
+/// pack_cmd_to_storage - write a command to its storage slot
+///     the caller is responsible for recording the change to the mission
+bool AP_Mission::pack_cmd_to_storage(uint16_t index, const Mission_Command& cmd)
+{
     // range check cmd's index
     if (index >= num_commands_max()) {
         return false;
@@ -985,13 +1139,6 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
         _storage.write_block(pos_in_storage+5, packed.bytes, 10);
     }
 
-    // remember when the mission last changed
-    if (index != 0) {
-        // Update of home location is not a true change
-        _last_change_time_ms = AP_HAL::millis();
-    }
-
-    // return success
     return true;
 }
 
@@ -2205,7 +2352,7 @@ bool AP_Mission::get_next_cmd(uint16_t start_index, Mission_Command& cmd, bool i
         // check for do-jump-tag command and convert target tag to do-jump target index and do-jump to it
         if (temp_cmd.id == MAV_CMD_DO_JUMP_TAG) {
             // convert tmp_cmd target from a target tag to a target index
-            temp_cmd.content.jump.target = get_index_of_jump_tag(temp_cmd.content.jump.target);
+            temp_cmd.content.jump.target = get_jump_tag_target(cmd_index, temp_cmd.content.jump.target);
             temp_cmd.id = MAV_CMD_DO_JUMP;
         }
 
@@ -2313,6 +2460,19 @@ bool AP_Mission::jump_to_tag(const uint16_t tag)
     return set_current_cmd(index);
 }
 
+// get the target index of the DO_JUMP_TAG command at index, which
+// jumps to tag.  Returns 0 if no appropriate JUMP_TAG can be found.
+uint16_t AP_Mission::get_jump_tag_target(uint16_t index, uint16_t tag) const
+{
+#if AP_MISSION_CMD_CACHE_ENABLED
+    WITH_SEMAPHORE(_rsem);
+    if (cmd_cache_valid() && index < _cmd_cache.count) {
+        return _cmd_cache.entries[index].jump_target;
+    }
+#endif
+    return get_index_of_jump_tag(tag);
+}
+
 // find the first JUMP_TAG with this tag and return its index.
 // Returns 0 if no appropriate JUMP_TAG match can be found.
 uint16_t AP_Mission::get_index_of_jump_tag(const uint16_t tag) const
@@ -2951,6 +3111,14 @@ const char *AP_Mission::Mission_Command::type() const
  */
 uint16_t AP_Mission::get_command_id(uint16_t index) const
 {
+#if AP_MISSION_CMD_CACHE_ENABLED
+    {
+        WITH_SEMAPHORE(_rsem);
+        if (cmd_cache_valid() && index != 0 && index < _cmd_cache.count) {
+            return _cmd_cache.entries[index].cmd.id;
+        }
+    }
+#endif
     const uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
     uint8_t b[3] {};
     if (!_storage.read_block(b, pos_in_storage, sizeof(b))) {
@@ -2965,6 +3133,98 @@ uint16_t AP_Mission::get_command_id(uint16_t index) const
     return id;
 }
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+/*
+  decode the mission into RAM once it has been unchanged for
+  AP_MISSION_CMD_CACHE_SETTLE_MS, so uploads don't cause a rebuild for
+  every item. The cache is built a chunk at a time, at most
+  AP_MISSION_CMD_CACHE_CHUNK commands per call, and commands are read
+  from storage until it is complete
+ */
+void AP_Mission::update_cmd_cache()
+{
+    WITH_SEMAPHORE(_rsem);
+
+    if (cmd_cache_valid() || _cmd_cache.failed ||
+        AP_HAL::millis() - _last_change_time_ms < AP_MISSION_CMD_CACHE_SETTLE_MS) {
+        return;
+    }
+
+    const uint16_t count = _cmd_total;
+    if (_cmd_cache.decoded == 0) {
+        // start a new build
+        _cmd_cache.valid = false;
+        if (count > AP_MISSION_CMD_CACHE_MAX || count > _commands_max) {
+            _cmd_cache.failed = true;
+            return;
+        }
+        if (count > _cmd_cache.size) {
+            delete[] _cmd_cache.entries;
+            _cmd_cache.entries = NEW_NOTHROW cmd_cache_entry[count];
+            if (_cmd_cache.entries == nullptr) {
+                _cmd_cache.size = 0;
+                _cmd_cache.failed = true;
+                return;
+            }
+            _cmd_cache.size = count;
+        }
+        _cmd_cache.entries[0].cmd = {};
+        _cmd_cache.entries[0].cmd.id = MAV_CMD_NAV_WAYPOINT;
+        _cmd_cache.decoded = 1;
+        _cmd_cache.resolved = 0;
+    }
+
+    cmd_cache_entry *entries = _cmd_cache.entries;
+    uint16_t work = 0;
+
+    // decode the commands
+    while (_cmd_cache.decoded < count && work < AP_MISSION_CMD_CACHE_CHUNK) {
+        if (!decode_cmd_from_storage(_cmd_cache.decoded, entries[_cmd_cache.decoded].cmd)) {
+            _cmd_cache.failed = true;
+            return;
+        }
+        _cmd_cache.decoded++;
+        work++;
+    }
+
+    // then resolve DO_JUMP_TAG targets, the same as get_index_of_jump_tag()
+    while (_cmd_cache.decoded >= count && _cmd_cache.resolved < count && work < AP_MISSION_CMD_CACHE_CHUNK) {
+        cmd_cache_entry &entry = entries[_cmd_cache.resolved++];
+        entry.jump_target = 0;
+        if (entry.cmd.id != MAV_CMD_DO_JUMP_TAG) {
+            continue;
+        }
+        for (uint16_t j = 1; j < count; j++) {
+            if (entries[j].cmd.id == MAV_CMD_JUMP_TAG &&
+                entries[j].cmd.content.jump.target == entry.cmd.content.jump.target) {
+                entry.jump_target = j;
+                break;
+            }
+        }
+        work++;
+    }
+
+    if (_cmd_cache.resolved < count) {
+        // carry on next time
+        return;
+    }
+
+    // index of the next nav or jump command, working back from the end
+    uint16_t next = count;
+    for (uint16_t i = count; i-- > 0; ) {
+        const Mission_Command &cmd = entries[i].cmd;
+        if (is_nav_cmd(cmd) || cmd.id == MAV_CMD_DO_JUMP || cmd.id == MAV_CMD_DO_JUMP_TAG) {
+            next = i;
+        }
+        entries[i].next_nav_or_jump = next;
+    }
+
+    _cmd_cache.count = count;
+    _cmd_cache.valid = true;
+    _cmd_cache.decoded = 0;
+}
+#endif  // AP_MISSION_CMD_CACHE_ENABLED
+
 /*
   see if the mission contains a particular item
  */
@@ -34,6 +34,17 @@
 #endif
 #endif
 
+#ifndef AP_MISSION_CMD_CACHE_MAX
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_1000
+#define AP_MISSION_CMD_CACHE_MAX            2000    // largest mission decoded into RAM, 32 bytes per command
+#else
+#define AP_MISSION_CMD_CACHE_MAX            1000
+#endif
+#endif
+
+#define AP_MISSION_CMD_CACHE_SETTLE_MS      500     // time the mission must be unchanged before it is decoded into RAM
+#define AP_MISSION_CMD_CACHE_CHUNK          20      // commands added to the cache per update()
+
 #define AP_MISSION_JUMP_REPEAT_FOREVER      -1      // when do-jump command's repeat count is -1 this means endless repeat
 
 #define AP_MISSION_CMD_ID_NONE              0       // mavlink cmd id of zero means invalid or missing command
@@ -61,6 +72,7 @@ union PackedContent;
 /// @brief    Object managing Mission
 class AP_Mission
 {
+    friend class AP_Mission_Test;
 
 public:
     // jump command structure
@@ -545,6 +557,23 @@ public:
     /// truncate - truncate any mission items beyond given index
     void truncate(uint16_t index);
 
+    /*
+      staged uploads. Commands are written to the unused end of
+      storage while the current mission is left untouched, then
+      copied into place in one step once the whole upload has been
+      received and validated
+     */
+    /// begin_staged_upload - prepare to stage num_cmds commands which will be placed at index start
+    ///     returns false if there is not enough free storage beyond the current mission
+    bool begin_staged_upload(uint16_t start, uint16_t num_cmds);
+
+    /// write_staged_cmd - write the i'th command of a staged upload to storage
+    bool write_staged_cmd(uint16_t i, const Mission_Command& cmd);
+
+    /// commit_staged_upload - copy all staged commands into place, clearing the mission first if clear_mission is true
+    ///     returns false if the staged commands have been overwritten or cannot be placed
+    bool commit_staged_upload(bool clear_mission);
+
     /// update - ensures the command queues are loaded with the next command and calls main programs command_init and command_verify functions to progress the mission
     ///     should be called at 10hz or higher
     void update();
@@ -939,6 +968,56 @@ private:
     // fast call to get command ID of a mission index
     uint16_t get_command_id(uint16_t index) const;
 
+    // decode a command from storage, index must be in range
+    bool decode_cmd_from_storage(uint16_t index, Mission_Command& cmd) const;
+
+    // get the target index of the DO_JUMP_TAG command at index
+    uint16_t get_jump_tag_target(uint16_t index, uint16_t tag) const;
+
+    // pack a command into its storage slot without marking the mission as changed
+    bool pack_cmd_to_storage(uint16_t index, const Mission_Command& cmd);
+
+    // staged upload in progress, see begin_staged_upload()
+    struct {
+        uint16_t base;              // storage index of the first staged command
+        uint16_t start;             // index the first staged command will be copied to
+        uint16_t count;
+        uint16_t written;           // number of commands staged so far
+        bool valid;
+    } _staged;
+
+#if AP_MISSION_CMD_CACHE_ENABLED
+    /*
+      decoded copy of the mission, built once the mission has stopped
+      changing so that advancing through a running mission doesn't
+      decode every command it passes from storage.  Home (index 0) is
+      never cached as it comes from AHRS
+     */
+    struct cmd_cache_entry {
+        Mission_Command cmd;
+        uint16_t next_nav_or_jump;  // index of first nav or jump command at or after this one
+        uint16_t jump_target;       // index of the JUMP_TAG a DO_JUMP_TAG jumps to, 0 if none
+    };
+    struct {
+        cmd_cache_entry *entries = nullptr;
+        uint16_t size;              // number of entries allocated
+        uint16_t count;             // number of commands in the cache once it is valid
+        uint16_t decoded;           // commands decoded so far while building, 0 when not building
+        uint16_t resolved;          // commands with jump targets resolved so far while building
+        bool valid;
+        bool failed;                // could not be built for the current mission
+    } _cmd_cache {};
+
+    // true if the cache holds the current mission
+    bool cmd_cache_valid() const { return _cmd_cache.valid && _cmd_cache.count == (unsigned)_cmd_total; }
+
+    // discard the cache, and any partly built one, when the mission changes
+    void invalidate_cmd_cache() { _cmd_cache.valid = false; _cmd_cache.failed = false; _cmd_cache.decoded = 0; }
+
+    // rebuild the cache a chunk at a time if the mission has changed
+    void update_cmd_cache();
+#endif
+
     // memoisation of contains-relative:
     bool _contains_terrain_alt_items;  // true if the mission has terrain-relative items
     uint32_t _last_contains_relative_calculated_ms;  // will be equal to _last_change_time_ms if _contains_terrain_alt_items is up-to-date
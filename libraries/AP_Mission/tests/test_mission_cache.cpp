@@ -0,0 +1,261 @@
+/*
+  check that the decoded mission cache is built a chunk at a time, and
+  that it, its next-nav table and its jump tag table give the same
+  commands as reading the mission from storage
+ */
+#include <AP_gtest.h>
+
+#include <AP_Mission/AP_Mission.h>
+
+#include <vector>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_MISSION_CMD_CACHE_ENABLED
+
+class AP_Mission_Test
+{
+public:
+    typedef AP_Mission::Mission_Command Mission_Command;
+
+    // let the cache be built, as if the mission had been unchanged for a while
+    static void settle(AP_Mission &mission) { mission._last_change_time_ms = AP_HAL::millis() - AP_MISSION_CMD_CACHE_SETTLE_MS - 1; }
+
+    static void update_cache(AP_Mission &mission) { mission.update_cmd_cache(); }
+    static bool cache_valid(const AP_Mission &mission) { return mission.cmd_cache_valid(); }
+    static void invalidate_cache(AP_Mission &mission) { mission.invalidate_cmd_cache(); }
+
+    static bool read_cmd(const AP_Mission &mission, uint16_t index, Mission_Command &cmd) { return mission.read_cmd_from_storage(index, cmd); }
+    static bool decode_cmd(const AP_Mission &mission, uint16_t index, Mission_Command &cmd) { return mission.decode_cmd_from_storage(index, cmd); }
+    static uint16_t command_id(const AP_Mission &mission, uint16_t index) { return mission.get_command_id(index); }
+    static uint16_t jump_tag_target(const AP_Mission &mission, uint16_t index, uint16_t tag) { return mission.get_jump_tag_target(index, tag); }
+    static uint16_t index_of_jump_tag(const AP_Mission &mission, uint16_t tag) { return mission.get_index_of_jump_tag(tag); }
+    static void init_jump_tracking(AP_Mission &mission) { mission.init_jump_tracking(); }
+
+    // change the mission total as setting MIS_TOTAL does
+    static void set_total(AP_Mission &mission, uint16_t total) { mission._cmd_total.set(total); }
+
+    // store home, as add_cmd() would using the AHRS home
+    static bool add_home(AP_Mission &mission, const Location &home)
+    {
+        Mission_Command cmd {};
+        cmd.id = MAV_CMD_NAV_WAYPOINT;
+        cmd.content.location = home;
+        if (!mission.write_cmd_to_storage(0, cmd)) {
+            return false;
+        }
+        mission._cmd_total.set(1);
+        return true;
+    }
+};
+
+typedef AP_Mission_Test::Mission_Command Mission_Command;
+
+class MissionCallbacks
+{
+public:
+    AP_Mission mission{
+        FUNCTOR_BIND_MEMBER(&MissionCallbacks::start_cmd, bool, const Mission_Command &),
+        FUNCTOR_BIND_MEMBER(&MissionCallbacks::verify_cmd, bool, const Mission_Command &),
+        FUNCTOR_BIND_MEMBER(&MissionCallbacks::mission_complete, void)};
+
+private:
+    bool start_cmd(const Mission_Command &) { return true; }
+    bool verify_cmd(const Mission_Command &) { return true; }
+    void mission_complete() {}
+};
+
+static MissionCallbacks callbacks;
+static AP_Mission &mission = callbacks.mission;
+
+static uint32_t rand_state = 1;
+
+static uint32_t rand_u32()
+{
+    rand_state = rand_state * 1664525U + 1013904223U;
+    return rand_state >> 8;
+}
+
+/*
+  a mission of runs of do commands between waypoints, with jumps
+  forward and back, and jump tags some of which are missing or
+  repeated
+ */
+static void make_mission(uint16_t num_cmds)
+{
+    ASSERT_TRUE(mission.clear());
+    ASSERT_TRUE(AP_Mission_Test::add_home(mission, Location{-353632620, 1491652370, 0, Location::AltFrame::ABSOLUTE}));
+    for (uint16_t i = 1; i < num_cmds; i++) {
+        Mission_Command cmd {};
+        const uint32_t r = rand_u32() % 20;
+        if (r < 8) {
+            cmd.id = MAV_CMD_NAV_WAYPOINT;
+            cmd.content.location = Location{-353632620 + int32_t(i) * 1000, 1491652370, 5000, Location::AltFrame::ABOVE_HOME};
+        } else if (r < 12) {
+            cmd.id = MAV_CMD_DO_CHANGE_SPEED;
+            cmd.content.speed.speed_type = 0;
+            cmd.content.speed.target_ms = 5 + (i % 10);
+            cmd.content.speed.throttle_pct = 0;
+        } else if (r < 15) {
+            cmd.id = MAV_CMD_DO_SET_SERVO;
+            cmd.content.servo.channel = 9;
+            cmd.content.servo.pwm = 1000 + i;
+        } else if (r < 16) {
+            cmd.id = MAV_CMD_DO_JUMP;
+            cmd.content.jump.target = 1 + rand_u32() % (num_cmds - 1);
+            cmd.content.jump.num_times = 1 + rand_u32() % 3;
+        } else if (r < 18) {
+            cmd.id = MAV_CMD_JUMP_TAG;
+            cmd.content.jump.target = rand_u32() % 10;
+        } else {
+            // tags 10 and above are never defined
+            cmd.id = MAV_CMD_DO_JUMP_TAG;
+            cmd.content.jump.target = rand_u32() % 12;
+            cmd.content.jump.num_times = 1 + rand_u32() % 3;
+        }
+        ASSERT_TRUE(mission.add_cmd(cmd)) << i;
+    }
+    ASSERT_EQ(mission.num_commands(), num_cmds);
+}
+
+// build the cache, returning the number of updates it took
+static uint16_t build_cache()
+{
+    AP_Mission_Test::settle(mission);
+    uint16_t updates = 0;
+    while (!AP_Mission_Test::cache_valid(mission) && updates < 1000) {
+        AP_Mission_Test::update_cache(mission);
+        updates++;
+    }
+    return updates;
+}
+
+static void init_mission()
+{
+    static bool done;
+    if (!done) {
+        mission.init();
+        done = true;
+    }
+}
+
+TEST(AP_Mission, CacheBuiltInChunks)
+{
+    init_mission();
+    const uint16_t num_cmds = MIN(500, mission.num_commands_max());
+    make_mission(num_cmds);
+
+    // nothing is built while the mission is changing
+    AP_Mission_Test::update_cache(mission);
+    EXPECT_FALSE(AP_Mission_Test::cache_valid(mission));
+
+    // then each update decodes a chunk, with commands read from storage until the cache is complete
+    AP_Mission_Test::settle(mission);
+    uint16_t updates = 0;
+    while (!AP_Mission_Test::cache_valid(mission)) {
+        ASSERT_LT(updates, 1000);
+        for (uint16_t i = 1; i < num_cmds; i += 37) {
+            // zeroed first, as == compares every byte including padding
+            Mission_Command cmd {}, expected {};
+            ASSERT_TRUE(AP_Mission_Test::read_cmd(mission, i, cmd));
+            ASSERT_TRUE(AP_Mission_Test::decode_cmd(mission, i, expected));
+            EXPECT_TRUE(cmd == expected) << "update " << updates << " index " << i;
+        }
+        AP_Mission_Test::update_cache(mission);
+        updates++;
+    }
+    // decoding, then resolving the DO_JUMP_TAGs, each AP_MISSION_CMD_CACHE_CHUNK at a time
+    EXPECT_GE(updates, (num_cmds - 1 + AP_MISSION_CMD_CACHE_CHUNK - 1) / AP_MISSION_CMD_CACHE_CHUNK);
+    EXPECT_LE(updates, 2 * ((num_cmds + AP_MISSION_CMD_CACHE_CHUNK - 1) / AP_MISSION_CMD_CACHE_CHUNK));
+
+    // a change part way through a build starts it again
+    AP_Mission_Test::invalidate_cache(mission);
+    AP_Mission_Test::settle(mission);
+    for (uint8_t i = 0; i < 3; i++) {
+        AP_Mission_Test::update_cache(mission);
+    }
+    Mission_Command cmd {};
+    cmd.id = MAV_CMD_DO_SET_SERVO;
+    cmd.content.servo.channel = 10;
+    cmd.content.servo.pwm = 1234;
+    ASSERT_TRUE(mission.replace_cmd(2, cmd));
+    EXPECT_FALSE(AP_Mission_Test::cache_valid(mission));
+    build_cache();
+    ASSERT_TRUE(AP_Mission_Test::cache_valid(mission));
+    Mission_Command cached;
+    ASSERT_TRUE(AP_Mission_Test::read_cmd(mission, 2, cached));
+    EXPECT_EQ(cached.id, MAV_CMD_DO_SET_SERVO);
+    EXPECT_EQ(cached.content.servo.pwm, 1234);
+
+    // and a new mission is built from the start
+    make_mission(num_cmds / 2);
+    EXPECT_FALSE(AP_Mission_Test::cache_valid(mission));
+    build_cache();
+    EXPECT_TRUE(AP_Mission_Test::cache_valid(mission));
+
+    // as is one whose total is set as a parameter, larger than any cached before
+    AP_Mission_Test::set_total(mission, mission.num_commands_max());
+    EXPECT_FALSE(AP_Mission_Test::cache_valid(mission));
+    build_cache();
+    for (uint16_t i = 1; i < mission.num_commands(); i++) {
+        Mission_Command cmd {}, expected {};
+        ASSERT_EQ(AP_Mission_Test::read_cmd(mission, i, cmd), AP_Mission_Test::decode_cmd(mission, i, expected)) << i;
+        EXPECT_TRUE(cmd == expected) << i;
+    }
+}
+
+TEST(AP_Mission, CacheMatchesStorage)
+{
+    init_mission();
+    for (uint8_t m = 0; m < 5; m++) {
+        const uint16_t num_cmds = MIN(50 + 200 * m, mission.num_commands_max());
+        make_mission(num_cmds);
+
+        // expected results from storage
+        std::vector<Mission_Command> cmds(num_cmds);
+        std::vector<uint16_t> ids(num_cmds);
+        std::vector<bool> nav_found(num_cmds);
+        std::vector<Mission_Command> nav_cmds(num_cmds);
+        AP_Mission_Test::init_jump_tracking(mission);
+        ASSERT_FALSE(AP_Mission_Test::cache_valid(mission));
+        for (uint16_t i = 1; i < num_cmds; i++) {
+            ASSERT_TRUE(AP_Mission_Test::read_cmd(mission, i, cmds[i]));
+            ids[i] = AP_Mission_Test::command_id(mission, i);
+            nav_found[i] = mission.get_next_nav_cmd(i, nav_cmds[i]);
+        }
+
+        build_cache();
+        ASSERT_TRUE(AP_Mission_Test::cache_valid(mission)) << unsigned(m);
+
+        uint16_t num_jump_tags = 0, num_nav_found = 0;
+        for (uint16_t i = 1; i < num_cmds; i++) {
+            Mission_Command cmd {};
+            ASSERT_TRUE(AP_Mission_Test::read_cmd(mission, i, cmd));
+            EXPECT_TRUE(cmd == cmds[i]) << "mission " << unsigned(m) << " index " << i;
+            EXPECT_EQ(AP_Mission_Test::command_id(mission, i), ids[i]) << i;
+
+            // the next nav table skips runs of do commands and follows jumps the same way
+            Mission_Command nav_cmd {};
+            const bool found = mission.get_next_nav_cmd(i, nav_cmd);
+            ASSERT_EQ(found, nav_found[i]) << "mission " << unsigned(m) << " index " << i;
+            if (found) {
+                EXPECT_TRUE(nav_cmd == nav_cmds[i]) << "mission " << unsigned(m) << " index " << i;
+                num_nav_found++;
+            }
+
+            // the jump tag table finds the first JUMP_TAG with the tag
+            if (cmd.id == MAV_CMD_DO_JUMP_TAG) {
+                const uint16_t tag = cmd.content.jump.target;
+                EXPECT_EQ(AP_Mission_Test::jump_tag_target(mission, i, tag),
+                          AP_Mission_Test::index_of_jump_tag(mission, tag)) << "mission " << unsigned(m) << " index " << i;
+                num_jump_tags++;
+            }
+        }
+        EXPECT_GT(num_jump_tags, 0);
+        EXPECT_GT(num_nav_found, 0);
+    }
+}
+
+#endif  // AP_MISSION_CMD_CACHE_ENABLED
+
+AP_GTEST_MAIN()
@@ -7,6 +7,7 @@
 #include "AP_MultiHeap.h"
 
 #include <AP_Math/AP_Math.h>
+#include <AP_Common/ExpandingString.h>
 #include <stdio.h>
 
 /*
@@ -18,11 +19,30 @@
 
 extern const AP_HAL::HAL &hal;
 
+#if AP_MULTIHEAP_SLAB_ENABLED
+/*
+  slab header, followed by the objects. Free objects hold a pointer to
+  the next free object in the slab
+ */
+struct MultiHeap::Slab {
+    Slab *prev;                 // partial list of the size class
+    Slab *next;
+    void *free_list;
+    uint16_t used;              // objects allocated
+    uint8_t size_class;
+};
+
+// objects start after the header, keeping them 8 byte aligned
+#define SLAB_HEADER_SIZE ((sizeof(MultiHeap::Slab) + 7U) & ~7U)
+
+static const uint8_t slab_sizes[MULTIHEAP_SLAB_CLASSES] { 16, 24, 32, 48, 64, 96, 128 };
+#endif
+
 /*
   create heaps with a total memory size, splitting over at most
   max_heaps
  */
-bool MultiHeap::create(uint32_t total_size, uint8_t max_heaps, bool _allow_expansion, uint32_t _reserve_size)
+bool MultiHeap::create(uint32_t total_size, uint8_t max_heaps, bool _allow_expansion, uint32_t _reserve_size, bool _use_slabs)
 {
     max_heaps = MIN(MAX_HEAPS, max_heaps);
     if (heaps != nullptr) {
@@ -57,6 +77,15 @@ bool MultiHeap::create(uint32_t total_size, uint8_t max_heaps, bool _allow_expan
     allow_expansion = _allow_expansion;
     reserve_size = _reserve_size;
 
+#if AP_MULTIHEAP_SLAB_ENABLED
+    if (_use_slabs) {
+        // enough room for the whole of the initial heaps to be slabs
+        max_slabs = MIN(sum_size / MULTIHEAP_SLAB_SIZE, uint32_t(UINT16_MAX));
+        slab_table = NEW_NOTHROW Slab*[max_slabs];
+        use_slabs = slab_table != nullptr;
+    }
+#endif
+
     return true;
 }
 
@@ -66,6 +95,18 @@ void MultiHeap::destroy(void)
     if (!available()) {
         return;
     }
+#if AP_MULTIHEAP_SLAB_ENABLED
+    for (uint16_t i=0; i<num_slabs; i++) {
+        heap_free(slab_table[i]);
+    }
+    delete[] slab_table;
+    slab_table = nullptr;
+    num_slabs = 0;
+    max_slabs = 0;
+    use_slabs = false;
+    memset(partial, 0, sizeof(partial));
+    memset(slab_stats, 0, sizeof(slab_stats));
+#endif
     for (uint8_t i=0; i<num_heaps; i++) {
         if (heaps[i].hp != nullptr) {
             heap_destroy(heaps[i].hp);
@@ -86,23 +127,44 @@ bool MultiHeap::available(void) const
 }
 
 /*
-  allocate memory from a heap
+  allocate memory from the existing heaps
  */
-void *MultiHeap::allocate(uint32_t size)
+void *MultiHeap::allocate_existing(uint32_t size)
 {
-    if (!available() || size == 0) {
-        return nullptr;
-    }
     for (uint8_t i=0; i<num_heaps; i++) {
         if (heaps[i].hp == nullptr) {
             break;
         }
         void *newptr = heap_allocate(heaps[i].hp, size);
+        if (newptr != nullptr) {
+            return newptr;
+        }
+    }
+    return nullptr;
+}
+
+/*
+  allocate memory from a heap
+ */
+void *MultiHeap::allocate(uint32_t size)
+{
+    if (!available() || size == 0) {
+        return nullptr;
+    }
+#if AP_MULTIHEAP_SLAB_ENABLED
+    if (use_slabs && size <= MULTIHEAP_SLAB_MAX_OBJECT) {
+        void *newptr = slab_allocate(size);
         if (newptr != nullptr) {
             last_failed = false;
             return newptr;
         }
     }
+#endif
+    void *newptr = allocate_existing(size);
+    if (newptr != nullptr) {
+        last_failed = false;
+        return newptr;
+    }
     if (!allow_expansion || !last_failed) {
         /*
           we only allow expansion when the last allocation
@@ -166,6 +228,13 @@ void MultiHeap::deallocate(void *ptr)
     if (!available() || ptr == nullptr) {
         return;
     }
+#if AP_MULTIHEAP_SLAB_ENABLED
+    Slab *s = slab_find(ptr);
+    if (s != nullptr) {
+        slab_free(s, ptr);
+        return;
+    }
+#endif
     heap_free(ptr);
 }
 
@@ -175,29 +244,247 @@ void MultiHeap::deallocate(void *ptr)
  */
 void *MultiHeap::change_size(void *ptr, uint32_t old_size, uint32_t new_size)
 {
-    if (new_size == 0) {
-        deallocate(ptr);
-        return nullptr;
+#if AP_MULTIHEAP_SLAB_ENABLED
+    // only allocations no larger than the largest slab object can be
+    // in a slab, which saves looking up larger ones
+    Slab *s = nullptr;
+    if (ptr != nullptr && old_size <= MULTIHEAP_SLAB_MAX_OBJECT) {
+        s = slab_find(ptr);
     }
-    /*
-      we don't want to require the underlying allocation system to
-      support realloc() and we also want to be able to handle the case
-      of having to move the allocation to a new heap, so we do a
-      simple alloc/copy/deallocate for reallocation
-     */
-    void *newp = allocate(new_size);
-    if (ptr == nullptr) {
-        return newp;
+    if (s != nullptr && new_size != 0 && new_size <= MULTIHEAP_SLAB_MAX_OBJECT &&
+        s->size_class == slab_class(new_size)) {
+        // still fits the same slab object
+        return ptr;
     }
-    if (newp == nullptr) {
-        if (old_size >= new_size) {
-            // Lua assumes that the allocator never fails when osize >= nsize
-            // the best we can do is return the old pointer
-            return ptr;
+#endif
+    void *newp = nullptr;
+    if (new_size != 0) {
+        /*
+          we don't want to require the underlying allocation system to
+          support realloc() and we also want to be able to handle the case
+          of having to move the allocation to a new heap, so we do a
+          simple alloc/copy/deallocate for reallocation
+         */
+        newp = allocate(new_size);
+        if (ptr == nullptr) {
+            return newp;
         }
-        return nullptr;
+        if (newp == nullptr) {
+            if (old_size >= new_size) {
+                // Lua assumes that the allocator never fails when osize >= nsize
+                // the best we can do is return the old pointer
+                return ptr;
+            }
+            return nullptr;
+        }
+        memcpy(newp, ptr, MIN(old_size, new_size));
     }
-    memcpy(newp, ptr, MIN(old_size, new_size));
+#if AP_MULTIHEAP_SLAB_ENABLED
+    if (s != nullptr) {
+        slab_free(s, ptr);
+        return newp;
+    }
+    if (ptr != nullptr && available()) {
+        heap_free(ptr);
+    }
+#else
     deallocate(ptr);
+#endif
     return newp;
 }
+
+#if AP_MULTIHEAP_SLAB_ENABLED
+// object size of a slab size class
+uint8_t MultiHeap::slab_object_size(uint8_t size_class)
+{
+    return slab_sizes[size_class];
+}
+
+// size class for an allocation of at most MULTIHEAP_SLAB_MAX_OBJECT bytes
+uint8_t MultiHeap::slab_class(uint32_t size)
+{
+    // indexed by size in units of 8 bytes, rounded up
+    static const uint8_t classes[MULTIHEAP_SLAB_MAX_OBJECT/8 + 1] {
+        0, 0, 0, 1, 2, 3, 3, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6
+    };
+    return classes[(size + 7U) / 8U];
+}
+
+/*
+  allocate an object from a slab, returns nullptr if a new slab is
+  needed and there is no room for it
+ */
+void *MultiHeap::slab_allocate(uint32_t size)
+{
+    const uint8_t c = slab_class(size);
+    SlabStats &stats = slab_stats[c];
+    Slab *s = partial[c];
+    if (s == nullptr) {
+        s = slab_create(c);
+        if (s == nullptr) {
+            stats.fallbacks++;
+            return nullptr;
+        }
+    }
+    void *ptr = s->free_list;
+    s->free_list = *(void **)ptr;
+    s->used++;
+    if (s->free_list == nullptr) {
+        // slab is now full
+        partial_remove(s);
+    }
+    stats.allocs++;
+    stats.in_use++;
+    stats.peak = MAX(stats.peak, stats.in_use);
+    return ptr;
+}
+
+/*
+  take a new slab from the heaps. This never expands the heaps, as
+  the allocation can still be made directly from the heaps if there
+  is no room for a whole slab
+ */
+MultiHeap::Slab *MultiHeap::slab_create(uint8_t size_class)
+{
+    if (num_slabs >= max_slabs) {
+        return nullptr;
+    }
+    auto *s = (Slab *)allocate_existing(MULTIHEAP_SLAB_SIZE);
+    if (s == nullptr) {
+        return nullptr;
+    }
+    s->size_class = size_class;
+    s->used = 0;
+
+    // link all of the objects into the free list
+    const uint8_t obj_size = slab_sizes[size_class];
+    const uint16_t num_objects = (MULTIHEAP_SLAB_SIZE - SLAB_HEADER_SIZE) / obj_size;
+    uint8_t *obj = (uint8_t *)s + SLAB_HEADER_SIZE;
+    s->free_list = obj;
+    for (uint16_t i=0; i<num_objects-1; i++) {
+        *(void **)obj = obj + obj_size;
+        obj += obj_size;
+    }
+    *(void **)obj = nullptr;
+
+    // insert into the table keeping it sorted
+    uint16_t i = num_slabs;
+    while (i > 0 && slab_table[i-1] > s) {
+        slab_table[i] = slab_table[i-1];
+        i--;
+    }
+    slab_table[i] = s;
+    num_slabs++;
+
+    partial_add(s);
+    slab_stats[size_class].slabs++;
+    return s;
+}
+
+// return an empty slab to the heaps
+void MultiHeap::slab_destroy(Slab *s)
+{
+    partial_remove(s);
+    uint16_t i = 0;
+    while (slab_table[i] != s) {
+        i++;
+    }
+    num_slabs--;
+    memmove(&slab_table[i], &slab_table[i+1], (num_slabs - i) * sizeof(slab_table[0]));
+    slab_stats[s->size_class].slabs--;
+    heap_free(s);
+}
+
+// find the slab holding ptr, returns nullptr if ptr is not from a slab
+MultiHeap::Slab *MultiHeap::slab_find(const void *ptr) const
+{
+    // binary search for the last slab starting at or before ptr
+    uint16_t lo = 0;
+    uint16_t hi = num_slabs;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if ((const void *)slab_table[mid] <= ptr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return nullptr;
+    }
+    Slab *s = slab_table[lo-1];
+    if ((const uint8_t *)ptr >= (const uint8_t *)s + MULTIHEAP_SLAB_SIZE) {
+        return nullptr;
+    }
+    return s;
+}
+
+// free an object back to its slab
+void MultiHeap::slab_free(Slab *s, void *ptr)
+{
+    if (s->free_list == nullptr) {
+        // slab was full
+        partial_add(s);
+    }
+    *(void **)ptr = s->free_list;
+    s->free_list = ptr;
+    s->used--;
+    SlabStats &stats = slab_stats[s->size_class];
+    stats.in_use--;
+
+    // keep one slab of each size class to avoid repeatedly taking
+    // and freeing a slab for a single object
+    if (s->used == 0 && stats.slabs > 1) {
+        slab_destroy(s);
+    }
+}
+
+// remove a slab from the partial list of its size class
+void MultiHeap::partial_remove(Slab *s)
+{
+    if (s->prev != nullptr) {
+        s->prev->next = s->next;
+    } else if (partial[s->size_class] == s) {
+        partial[s->size_class] = s->next;
+    } else {
+        // not on the list
+        return;
+    }
+    if (s->next != nullptr) {
+        s->next->prev = s->prev;
+    }
+    s->prev = nullptr;
+    s->next = nullptr;
+}
+
+// add a slab to the front of the partial list of its size class
+void MultiHeap::partial_add(Slab *s)
+{
+    Slab *&head = partial[s->size_class];
+    s->prev = nullptr;
+    s->next = head;
+    if (head != nullptr) {
+        head->prev = s;
+    }
+    head = s;
+}
+
+// write a table of slab statistics to str
+void MultiHeap::slab_info(ExpandingString &str) const
+{
+    if (!use_slabs) {
+        return;
+    }
+    str.printf("%-6s %8s %8s %10s %8s %6s\n", "Size", "InUse", "Peak", "Allocs", "Fallback", "Slabs");
+    for (uint8_t i=0; i<MULTIHEAP_SLAB_CLASSES; i++) {
+        const SlabStats &stats = slab_stats[i];
+        str.printf("%-6u %8u %8u %10u %8u %6u\n",
+                   unsigned(slab_sizes[i]),
+                   unsigned(stats.in_use),
+                   unsigned(stats.peak),
+                   unsigned(stats.allocs),
+                   unsigned(stats.fallbacks),
+                   unsigned(stats.slabs));
+    }
+}
+#endif  // AP_MULTIHEAP_SLAB_ENABLED
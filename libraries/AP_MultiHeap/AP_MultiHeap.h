@@ -12,12 +12,25 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#ifndef AP_MULTIHEAP_SLAB_ENABLED
+#define AP_MULTIHEAP_SLAB_ENABLED 1
+#endif
+
+#define MULTIHEAP_SLAB_SIZE         512     // bytes taken from the heaps for each slab
+#define MULTIHEAP_SLAB_MAX_OBJECT   128     // largest allocation served from slabs
+#define MULTIHEAP_SLAB_CLASSES      7       // number of slab object sizes
+
+class ExpandingString;
+
 class MultiHeap {
+    friend class MultiHeap_Test;
+
 public:
     /*
-      allocate/deallocate heaps
+      allocate/deallocate heaps. If use_slabs is true then small
+      allocations are grouped by size into slabs, see below
      */
-    bool create(uint32_t total_size, uint8_t max_heaps, bool allow_expansion, uint32_t reserve_size);
+    bool create(uint32_t total_size, uint8_t max_heaps, bool allow_expansion, uint32_t reserve_size, bool use_slabs=false);
     void destroy(void);
 
     // return true if the heap is available for operations
@@ -40,6 +53,26 @@ public:
         return expanded_to;
     }
 
+#if AP_MULTIHEAP_SLAB_ENABLED
+    // statistics for one slab size class
+    struct SlabStats {
+        uint32_t in_use;            // objects currently allocated
+        uint32_t peak;              // most objects allocated at once
+        uint32_t allocs;            // total number of allocations
+        uint32_t fallbacks;         // allocations which had to go to the heaps
+        uint16_t slabs;             // slabs currently held
+    };
+    const SlabStats &get_slab_stats(uint8_t size_class) const {
+        return slab_stats[size_class];
+    }
+
+    // object size of a slab size class
+    static uint8_t slab_object_size(uint8_t size_class);
+
+    // write a table of slab statistics to str
+    void slab_info(ExpandingString &str) const;
+#endif
+
 private:
     struct Heap {
         void *hp;
@@ -57,6 +90,38 @@ private:
     // re-use memory when possible
     bool last_failed;
 
+    // allocate from the existing heaps without expanding
+    void *allocate_existing(uint32_t size);
+
+#if AP_MULTIHEAP_SLAB_ENABLED
+    /*
+      Lua makes a very large number of small, short lived
+      allocations. Giving each of these its own heap block wastes the
+      block header and leaves the heaps fragmented into small holes,
+      so instead they are carved from fixed size slabs taken from the
+      heaps, with all of the objects in a slab being the same
+      size. Freed objects are reused by the next allocation of the
+      same size, and slabs are returned to the heaps once empty.
+     */
+    struct Slab;
+
+    bool use_slabs;
+    Slab *partial[MULTIHEAP_SLAB_CLASSES];  // slabs with free objects, per size class
+    Slab **slab_table;                      // all slabs, sorted by address
+    uint16_t num_slabs;
+    uint16_t max_slabs;
+    SlabStats slab_stats[MULTIHEAP_SLAB_CLASSES];
+
+    static uint8_t slab_class(uint32_t size);
+    void *slab_allocate(uint32_t size);
+    Slab *slab_create(uint8_t size_class);
+    void slab_destroy(Slab *s);
+    Slab *slab_find(const void *ptr) const;
+    void slab_free(Slab *s, void *ptr);
+    void partial_remove(Slab *s);
+    void partial_add(Slab *s);
+#endif
+
 
     /*
       low level allocation functions
@@ -0,0 +1,50 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_MultiHeap/AP_MultiHeap.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// sizes similar to a Lua script: mostly small strings, tables and
+// userdata with some larger buffers
+static uint32_t lua_like_size()
+{
+    const uint16_t r = get_random16() % 100;
+    if (r < 70) {
+        return 8 + get_random16() % 57;
+    }
+    if (r < 90) {
+        return 65 + get_random16() % 64;
+    }
+    return 129 + get_random16() % 900;
+}
+
+// Lua-like allocations, reallocations and frees, with and without slabs
+static void BM_MultiHeapLuaLike(benchmark::State& state)
+{
+    static MultiHeap h;
+    h.create(1000000, 1, false, 0, state.range(0) != 0);
+
+    const uint32_t max_allocs = 2000;
+    struct alloc {
+        void *ptr;
+        uint32_t size;
+    };
+    auto *allocs = new alloc[max_allocs] {};
+    while (state.KeepRunning()) {
+        auto &a = allocs[get_random16() % max_allocs];
+        const uint32_t size = (get_random16() % 4 == 0) ? 0 : lua_like_size();
+        a.ptr = h.change_size(a.ptr, a.size, size);
+        a.size = size;
+        gbenchmark_escape(a.ptr);
+    }
+    for (uint32_t i=0; i<max_allocs; i++) {
+        h.deallocate(allocs[i].ptr);
+    }
+    delete[] allocs;
+    h.destroy();
+}
+
+BENCHMARK(BM_MultiHeapLuaLike)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
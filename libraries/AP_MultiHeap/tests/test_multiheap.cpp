@@ -3,6 +3,10 @@
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Math/AP_Math.h>
 
+#include <map>
+#include <set>
+#include <vector>
+
 const AP_HAL::HAL& hal = AP_HAL::get_HAL();
 
 TEST(MultiHeap, Tests)
@@ -54,4 +58,275 @@ TEST(MultiHeap, Tests)
     delete[] allocs;
 }
 
+#if AP_MULTIHEAP_SLAB_ENABLED
+TEST(MultiHeap, Slabs)
+{
+    static MultiHeap h;
+
+    EXPECT_TRUE(h.create(50000, 1, false, 0, true));
+
+    // resizing within a size class keeps the same object
+    void *p = h.allocate(20);
+    EXPECT_NE(p, nullptr);
+    EXPECT_EQ(h.change_size(p, 20, 24), p);
+    EXPECT_EQ(h.change_size(p, 24, 17), p);
+    EXPECT_EQ(h.get_slab_stats(1).in_use, 1U);
+
+    // moving to another size class keeps the contents
+    memset(p, 0x5a, 17);
+    void *p2 = h.change_size(p, 17, 100);
+    EXPECT_NE(p2, p);
+    EXPECT_EQ(((uint8_t *)p2)[16], 0x5a);
+    EXPECT_EQ(h.get_slab_stats(1).in_use, 0U);
+    EXPECT_EQ(h.get_slab_stats(6).in_use, 1U);
+
+    // large allocations don't use slabs
+    void *big = h.allocate(MULTIHEAP_SLAB_MAX_OBJECT + 1);
+    EXPECT_NE(big, nullptr);
+    h.deallocate(big);
+
+    // fill more than one slab of a size class and free it again
+    const uint16_t n = 2 * MULTIHEAP_SLAB_SIZE / 16;
+    void *ptrs[n];
+    for (uint16_t i=0; i<n; i++) {
+        ptrs[i] = h.allocate(16);
+        EXPECT_NE(ptrs[i], nullptr);
+    }
+    EXPECT_GE(h.get_slab_stats(0).slabs, 3U);
+    for (uint16_t i=0; i<n; i++) {
+        h.deallocate(ptrs[i]);
+    }
+    // empty slabs are returned to the heap, apart from one per class
+    EXPECT_EQ(h.get_slab_stats(0).in_use, 0U);
+    EXPECT_EQ(h.get_slab_stats(0).slabs, 1U);
+    EXPECT_EQ(h.get_slab_stats(0).peak, uint32_t(n));
+
+    h.deallocate(p2);
+    h.destroy();
+}
+
+class MultiHeap_Test
+{
+public:
+    // true if ptr is an object in one of the heap's slabs
+    static bool in_slab(const MultiHeap &h, const void *ptr) { return h.slab_find(ptr) != nullptr; }
+
+    // the slabs held, each of which is a block taken from the heaps
+    static std::set<const void *> slabs(const MultiHeap &h) { return {h.slab_table, h.slab_table + h.num_slabs}; }
+};
+
+/*
+  first fit heap with a header on each block, as in the ChibiOS
+  heap. The malloc backend used in SITL leaves the placement of blocks
+  to the system allocator, so the blocks taken from a MultiHeap are
+  replayed into this to see how fragmented a heap would become
+ */
+class HeapModel
+{
+public:
+    HeapModel(uint32_t size) { free_blocks[0] = size; }
+
+    bool allocate(const void *ptr, uint32_t size)
+    {
+        size = ((size + 7U) & ~7U) + 8U;
+        for (auto it = free_blocks.begin(); it != free_blocks.end(); ++it) {
+            if (it->second < size) {
+                continue;
+            }
+            const uint32_t ofs = it->first;
+            const uint32_t remaining = it->second - size;
+            free_blocks.erase(it);
+            if (remaining > 0) {
+                free_blocks[ofs + size] = remaining;
+            }
+            used[ptr] = {ofs, size};
+            return true;
+        }
+        return false;
+    }
+
+    void free(const void *ptr)
+    {
+        const auto u = used.find(ptr);
+        ASSERT_NE(u, used.end());
+        uint32_t ofs = u->second.first;
+        uint32_t size = u->second.second;
+        used.erase(u);
+
+        // merge with the free blocks either side
+        auto next = free_blocks.lower_bound(ofs);
+        if (next != free_blocks.end() && next->first == ofs + size) {
+            size += next->second;
+            next = free_blocks.erase(next);
+        }
+        if (next != free_blocks.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == ofs) {
+                prev->second += size;
+                return;
+            }
+        }
+        free_blocks[ofs] = size;
+    }
+
+    uint32_t largest_free() const
+    {
+        uint32_t largest = 0;
+        for (const auto &b : free_blocks) {
+            largest = MAX(largest, b.second);
+        }
+        return largest;
+    }
+
+private:
+    std::map<uint32_t, uint32_t> free_blocks;                       // offset to size
+    std::map<const void *, std::pair<uint32_t, uint32_t>> used;     // offset and size
+};
+
+/*
+  soak test with a mix of allocation sizes similar to a Lua script:
+  mostly small strings, tables and userdata with some larger
+  buffers
+ */
+static uint32_t lua_like_size()
+{
+    const uint16_t r = get_random16() % 100;
+    if (r < 70) {
+        return 8 + get_random16() % 57;
+    }
+    if (r < 90) {
+        return 65 + get_random16() % 64;
+    }
+    return 129 + get_random16() % 900;
+}
+
+static const uint32_t soak_heap_size = 400000;
+
+/*
+  record the largest free block of the modelled heap after each phase,
+  while the same amount of memory is allocated and freed. Also checks
+  that the number of slabs does not keep growing
+ */
+static void soak(MultiHeap &h, bool use_slabs, std::vector<uint32_t> &largest_free)
+{
+    const uint32_t max_allocs = 2000;
+    const uint32_t phases = 20;
+    const uint32_t ops_per_phase = 50000;
+    struct alloc {
+        void *ptr;
+        uint32_t size;
+    };
+    auto *allocs = new alloc[max_allocs] {};
+    uint32_t first_phase_slabs = 0;
+
+    HeapModel model{soak_heap_size};
+    std::set<const void *> slabs;
+    uint16_t class_slabs[MULTIHEAP_SLAB_CLASSES] {};
+
+    for (uint32_t phase=0; phase<phases; phase++) {
+        for (uint32_t i=0; i<ops_per_phase; i++) {
+            auto &a = allocs[get_random16() % max_allocs];
+            const uint32_t size = (get_random16() % 4 == 0) ? 0 : lua_like_size();
+            void *old_ptr = a.ptr;
+            const bool old_in_heap = old_ptr != nullptr && !(use_slabs && MultiHeap_Test::in_slab(h, old_ptr));
+            a.ptr = h.change_size(a.ptr, a.size, size);
+            ASSERT_TRUE(size==0?a.ptr == nullptr : a.ptr != nullptr);
+            a.size = size;
+
+            // replay the blocks taken from and returned to the heaps
+            // in the order change_size() does
+            std::set<const void *> new_slabs = slabs;
+            bool slabs_changed = false;
+            for (uint8_t c=0; c<MULTIHEAP_SLAB_CLASSES; c++) {
+                slabs_changed |= h.get_slab_stats(c).slabs != class_slabs[c];
+                class_slabs[c] = h.get_slab_stats(c).slabs;
+            }
+            if (slabs_changed) {
+                new_slabs = MultiHeap_Test::slabs(h);
+                for (const void *s : new_slabs) {
+                    if (slabs.count(s) == 0) {
+                        ASSERT_TRUE(model.allocate(s, MULTIHEAP_SLAB_SIZE));
+                    }
+                }
+            }
+            if (a.ptr != old_ptr) {
+                if (a.ptr != nullptr && !(use_slabs && MultiHeap_Test::in_slab(h, a.ptr))) {
+                    ASSERT_TRUE(model.allocate(a.ptr, size));
+                }
+                if (old_in_heap) {
+                    model.free(old_ptr);
+                }
+            }
+            if (slabs_changed) {
+                for (const void *s : slabs) {
+                    if (new_slabs.count(s) == 0) {
+                        model.free(s);
+                    }
+                }
+                slabs = new_slabs;
+            }
+        }
+        largest_free.push_back(model.largest_free());
+
+        if (!use_slabs) {
+            continue;
+        }
+        uint32_t num_slabs = 0;
+        uint32_t in_use = 0;
+        for (uint8_t c=0; c<MULTIHEAP_SLAB_CLASSES; c++) {
+            num_slabs += h.get_slab_stats(c).slabs;
+            in_use += h.get_slab_stats(c).in_use;
+        }
+        uint32_t small = 0;
+        for (uint32_t i=0; i<max_allocs; i++) {
+            if (allocs[i].ptr != nullptr && allocs[i].size <= MULTIHEAP_SLAB_MAX_OBJECT) {
+                small++;
+            }
+        }
+        EXPECT_EQ(in_use, small);
+        if (phase == 0) {
+            first_phase_slabs = num_slabs;
+        } else {
+            EXPECT_LE(num_slabs, first_phase_slabs + first_phase_slabs / 2 + MULTIHEAP_SLAB_CLASSES);
+        }
+    }
+
+    for (uint32_t i=0; i<max_allocs; i++) {
+        h.deallocate(allocs[i].ptr);
+    }
+    delete[] allocs;
+}
+
+TEST(MultiHeap, SlabSoak)
+{
+    static MultiHeap h_slab;
+    static MultiHeap h_plain;
+
+    EXPECT_TRUE(h_slab.create(soak_heap_size, 1, false, 0, true));
+    EXPECT_TRUE(h_plain.create(soak_heap_size, 1, false, 0));
+
+    std::vector<uint32_t> slab_largest, plain_largest;
+    soak(h_slab, true, slab_largest);
+    soak(h_plain, false, plain_largest);
+
+    // fragmentation is bounded, and the slabs leave more of the heap
+    // in one piece than giving each allocation its own block
+    for (uint32_t phase=0; phase<slab_largest.size(); phase++) {
+        EXPECT_GE(slab_largest[phase], slab_largest[0] * 0.85) << "phase " << phase;
+        EXPECT_GT(slab_largest[phase], plain_largest[phase]) << "phase " << phase;
+    }
+
+    for (uint8_t c=0; c<MULTIHEAP_SLAB_CLASSES; c++) {
+        const auto &stats = h_slab.get_slab_stats(c);
+        EXPECT_EQ(stats.in_use, 0U);
+        EXPECT_LE(stats.slabs, 1U);
+        EXPECT_EQ(stats.fallbacks, 0U);
+        EXPECT_GT(stats.allocs, 0U);
+    }
+
+    h_slab.destroy();
+    h_plain.destroy();
+}
+#endif  // AP_MULTIHEAP_SLAB_ENABLED
+
 AP_GTEST_MAIN()
@@ -269,6 +269,11 @@ private:
 
         bool send_receive(void);
 
+#if AP_NETWORKING_TESTS_ENABLED
+        // time spent in send_receive() moving data, for the port loopback test
+        uint32_t io_time_us;
+#endif
+
     private:
         bool init_buffers(const uint32_t size_rx, const uint32_t size_tx);
         void thread_create(AP_HAL::MemberProc);
@@ -277,6 +282,8 @@ private:
         void _begin(uint32_t b, uint16_t rxS, uint16_t txS) override;
         size_t _write(const uint8_t *buffer, size_t size) override;
         ssize_t _read(uint8_t *buffer, uint16_t count) override;
+        const uint8_t *_read_peek(uint32_t &count) override;
+        bool _read_advance(uint32_t count) override;
         uint32_t _available() override;
         void _end() override {}
         void _flush() override {}
@@ -307,6 +314,14 @@ private:
 
         HAL_Semaphore sem;
 
+        // held by the port thread while a socket call uses the
+        // buffers, so they can't be resized under it. Taken before sem
+        HAL_Semaphore io_sem;
+
+        // counts discard_input() calls, so data received at the same
+        // time is discarded too
+        uint32_t read_discards;
+
     protected:
 #if HAL_UART_STATS_ENABLED
         // Getters for cumulative tx and rx counts
@@ -326,6 +341,7 @@ private:
         TEST_TCP_DISCARD = (1U<<2),
         TEST_TCP_REFLECT = (1U<<3),
         TEST_CONNECTOR_LOOPBACK = (1U<<4),
+        TEST_PORT_LOOPBACK = (1U<<5),
     };
     void start_tests(void);
     void test_UDP_client(void);
@@ -333,6 +349,7 @@ private:
     void test_TCP_discard(void);
     void test_TCP_reflect(void);
     void test_connector_loopback(void);
+    void test_port_loopback(void);
 #endif // AP_NETWORKING_TESTS_ENABLED
 
 #if AP_NETWORKING_REGISTER_PORT_ENABLED
@@ -25,6 +25,16 @@ extern const AP_HAL::HAL& hal;
 #define AP_NETWORKING_PORT_MIN_RXSIZE 2048
 #endif
 
+// largest single socket send or receive, one TCP segment on ethernet
+#ifndef AP_NETWORKING_PORT_MAX_IO
+#define AP_NETWORKING_PORT_MAX_IO 1460
+#endif
+
+// stack buffer for data which wraps around the end of a port buffer
+#ifndef AP_NETWORKING_PORT_BOUNCE_SIZE
+#define AP_NETWORKING_PORT_BOUNCE_SIZE 300U
+#endif
+
 #ifndef AP_NETWORKING_PORT_STACK_SIZE
 #define AP_NETWORKING_PORT_STACK_SIZE 1300
 #endif
@@ -318,36 +328,66 @@ void AP_Networking::Port::tcp_client_loop(void)
  */
 bool AP_Networking::Port::send_receive(void)
 {
+#if AP_NETWORKING_TESTS_ENABLED
+    const uint32_t start_us = AP_HAL::micros();
+#endif
 
     bool active = false;
-    uint32_t space;
-
 
-    // handle incoming packets
+    /*
+      handle incoming packets. We receive straight into space reserved
+      in the read buffer, without holding the semaphore during the
+      socket call so other threads can still read from the port. If
+      the free space wraps around the end of the buffer then we
+      receive into a bounce buffer instead, so a UDP packet is never
+      truncated by a short contiguous region
+     */
     {
-        WITH_SEMAPHORE(sem);
-        space = readbuffer->space();
-    }
-    if (space > 0) {
-        const uint32_t n = MIN(300U, space);
-        uint8_t buf[n];
-        const auto ret = sock->recv(buf, n, 0);
-        if (close_on_recv_error && ret == 0) {
-            GCS_SEND_TEXT(MAV_SEVERITY_INFO, "TCP[%u]: closed connection", unsigned(state.idx));
-            delete sock;
-            sock = nullptr;
-            return false;
-        }
-        if (ret > 0) {
+        // the buffers can't be resized until the data is committed
+        WITH_SEMAPHORE(io_sem);
+        ByteBuffer::IoVec vec[2];
+        uint8_t nvec = 0;
+        uint32_t n = 0;
+        uint32_t discards;
+        {
             WITH_SEMAPHORE(sem);
-            readbuffer->write(buf, ret);
-
-            // Cant track dropped read packets because we only read in what there is space for
-            // The socket buffer becomes full and data is lost there
-            rx_stats_bytes += ret;
+            n = MIN(uint32_t(AP_NETWORKING_PORT_MAX_IO), readbuffer->space());
+            if (n > 0) {
+                nvec = readbuffer->reserve(vec, n);
+            }
+            discards = read_discards;
+        }
+        if (n > 0) {
+            ssize_t ret;
+            if (nvec == 1 && vec[0].len == n) {
+                ret = sock->recv(vec[0].data, n, 0);
+                WITH_SEMAPHORE(sem);
+                // input discarded while receiving is dropped too
+                if (ret > 0 && discards == read_discards) {
+                    readbuffer->commit(ret);
+                }
+            } else {
+                uint8_t buf[MIN(AP_NETWORKING_PORT_BOUNCE_SIZE, n)];
+                ret = sock->recv(buf, sizeof(buf), 0);
+                WITH_SEMAPHORE(sem);
+                if (ret > 0 && discards == read_discards) {
+                    readbuffer->write(buf, ret);
+                }
+            }
+            if (close_on_recv_error && ret == 0) {
+                GCS_SEND_TEXT(MAV_SEVERITY_INFO, "TCP[%u]: closed connection", unsigned(state.idx));
+                delete sock;
+                sock = nullptr;
+                return false;
+            }
+            if (ret > 0) {
+                // Cant track dropped read packets because we only read in what there is space for
+                // The socket buffer becomes full and data is lost there
+                rx_stats_bytes += ret;
 
-            active = true;
-            have_received = true;
+                active = true;
+                have_received = true;
+            }
         }
     }
 
@@ -376,43 +416,49 @@ bool AP_Networking::Port::send_receive(void)
     }
 
     if (connected) {
-        // handle outgoing packets
-        uint32_t available;
-
+        /*
+          handle outgoing packets. We send straight from the write
+          buffer, without holding the semaphore during the socket call
+          so other threads can still write to the port. Only this
+          thread advances the read pointer, so the data can't be
+          overwritten. A packetised MAVLink packet which wraps around
+          the end of the buffer goes via a bounce buffer to keep it in
+          one UDP packet
+         */
+        // the buffers can't be resized until the data is sent
+        WITH_SEMAPHORE(io_sem);
+        const uint8_t *ptr;
+        uint32_t n;
+#if AP_MAVLINK_PACKETISE_ENABLED
+        uint8_t buf[AP_NETWORKING_PORT_BOUNCE_SIZE];
+#endif
         {
             WITH_SEMAPHORE(sem);
-            available = writebuffer->available();
-            available = MIN(300U, available);
+            uint32_t contiguous = 0;
+            ptr = writebuffer->readptr(contiguous);
+            n = ptr != nullptr ? MIN(uint32_t(AP_NETWORKING_PORT_MAX_IO), contiguous) : 0;
 #if AP_MAVLINK_PACKETISE_ENABLED
-            if (packetise) {
-                available = mavlink_packetise(*writebuffer, available);
+            if (packetise && n > 0) {
+                n = mavlink_packetise(*writebuffer, MIN(uint32_t(AP_NETWORKING_PORT_BOUNCE_SIZE), writebuffer->available()));
+                if (n > contiguous) {
+                    n = writebuffer->peekbytes(buf, n);
+                    ptr = buf;
+                }
             }
 #endif
-            if (available == 0) {
-                return active;
-            }
-        }
-        uint8_t buf[available];
-        uint32_t n;
-        {
-            WITH_SEMAPHORE(sem);
-            n = writebuffer->peekbytes(buf, available);
-        }
-
-        // nothing to send return
-        if (n <= 0) {
-            return active;
         }
 
         ssize_t ret = -1;
-        if (type == NetworkPortType::UDP_SERVER) {
+        if (n == 0) {
+            // nothing to send
+        } else if (type == NetworkPortType::UDP_SERVER) {
             // UDP Server uses sendto, allowing us to change the destination address port on the fly
             if(last_udp_connect_address != 0 && last_udp_connect_port != 0) {
-                ret = sock->sendto(buf, n, last_udp_connect_address, last_udp_connect_port);
+                ret = sock->sendto(ptr, n, last_udp_connect_address, last_udp_connect_port);
             }
         } else {
             // TCP Server and Client and UDP Client use send
-            ret = sock->send(buf, n);
+            ret = sock->send(ptr, n);
         }
 
         if (ret > 0) {
@@ -420,7 +466,7 @@ bool AP_Networking::Port::send_receive(void)
             writebuffer->advance(ret);
             tx_stats_bytes += ret;
             active = true;
-        } else if (errno == ENOTCONN &&
+        } else if (n > 0 && errno == ENOTCONN &&
             (type == NetworkPortType::TCP_CLIENT || type == NetworkPortType::TCP_SERVER)) {
             // close socket and mark as disconnected, so we can reconnect with another client or when server comes back
             GCS_SEND_TEXT(MAV_SEVERITY_INFO, "TCP[%u]: disconnected", unsigned(state.idx));
@@ -431,6 +477,12 @@ bool AP_Networking::Port::send_receive(void)
         }
     }
 
+#if AP_NETWORKING_TESTS_ENABLED
+    if (active) {
+        io_time_us += AP_HAL::micros() - start_us;
+    }
+#endif
+
     return active;
 }
 
@@ -462,6 +514,25 @@ ssize_t AP_Networking::Port::_read(uint8_t *buffer, uint16_t count)
     return readbuffer->read(buffer, count);
 }
 
+/*
+  zero copy read from the read buffer. The port thread only writes to
+  the free space, so the bytes stay valid until the caller advances
+  past them, as long as the caller is the only reader and doesn't
+  begin() or discard input on the port in the meantime. Those resize
+  or empty the buffer
+ */
+const uint8_t *AP_Networking::Port::_read_peek(uint32_t &count)
+{
+    WITH_SEMAPHORE(sem);
+    return readbuffer->readptr(count);
+}
+
+bool AP_Networking::Port::_read_advance(uint32_t count)
+{
+    WITH_SEMAPHORE(sem);
+    return readbuffer->advance(count);
+}
+
 uint32_t AP_Networking::Port::_available()
 {
     WITH_SEMAPHORE(sem);
@@ -473,6 +544,7 @@ bool AP_Networking::Port::_discard_input()
 {
     WITH_SEMAPHORE(sem);
     readbuffer->clear();
+    read_discards++;
     return true;
 }
 
@@ -485,6 +557,8 @@ bool AP_Networking::Port::init_buffers(const uint32_t size_rx, const uint32_t si
         size_rx == last_size_rx) {
         return true;
     }
+    // wait for any socket call using the buffers to finish
+    WITH_SEMAPHORE(io_sem);
     WITH_SEMAPHORE(sem);
     if (readbuffer == nullptr) {
         readbuffer = NEW_NOTHROW ByteBuffer(size_rx);
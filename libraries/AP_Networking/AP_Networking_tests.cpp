@@ -43,6 +43,13 @@ void AP_Networking::start_tests(void)
                                      "connector_loopback",
                                      8192, AP_HAL::Scheduler::PRIORITY_IO, -1);
     }
+#if AP_NETWORKING_REGISTER_PORT_ENABLED
+    if (param.tests & TEST_PORT_LOOPBACK) {
+        hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&AP_Networking::test_port_loopback, void),
+                                     "port_loopback",
+                                     8192, AP_HAL::Scheduler::PRIORITY_IO, -1);
+    }
+#endif
 }
 
 /*
@@ -273,4 +280,98 @@ void AP_Networking::test_connector_loopback(void)
     }
 }
 
+#if AP_NETWORKING_REGISTER_PORT_ENABLED
+/*
+  throughput test of a network port through the UARTDriver API, as
+  used by MAVLink. NET_P1 must be a TCP server with its serial
+  protocol set to None. We connect to it, reflect everything it sends
+  and read it back from the port without copying. The port thread
+  time is reported per kbyte moved in each direction
+ */
+void AP_Networking::test_port_loopback(void)
+{
+    startup_wait();
+    auto &p = ports[0];
+    if (p.type != NetworkPortType::TCP_SERVER) {
+        GCS_SEND_TEXT(MAV_SEVERITY_ERROR, "port_loopback: NET_P1 must be a TCP server");
+        return;
+    }
+    GCS_SEND_TEXT(MAV_SEVERITY_INFO, "port_loopback: starting");
+
+    p.begin(0, 8192, 8192);
+
+    auto *sock = NEW_NOTHROW SocketAPM(false);
+    if (sock == nullptr) {
+        GCS_SEND_TEXT(MAV_SEVERITY_ERROR, "port_loopback: failed to create socket");
+        return;
+    }
+    char ipstr[16];
+    SocketAPM::inet_addr_to_str(get_ip_active(), ipstr, sizeof(ipstr));
+    while (!sock->connect(ipstr, p.port.get())) {
+        hal.scheduler->delay(10);
+    }
+    sock->set_blocking(false);
+    GCS_SEND_TEXT(MAV_SEVERITY_INFO, "port_loopback: connected");
+
+    uint8_t txbuf[1024];
+    for (uint16_t i=0; i<sizeof(txbuf); i++) {
+        txbuf[i] = i;
+    }
+    uint8_t buf[1024];
+    uint32_t reflect_len = 0;
+    uint32_t last_report_ms = AP_HAL::millis();
+    uint32_t total_rx = 0;
+    p.io_time_us = 0;
+    while (true) {
+        if ((param.tests & TEST_PORT_LOOPBACK) == 0) {
+            hal.scheduler->delay(1);
+            continue;
+        }
+        bool active = false;
+
+        // write as MAVLink does
+        if (p.txspace() >= sizeof(txbuf)) {
+            p.write(txbuf, sizeof(txbuf));
+            active = true;
+        }
+
+        // reflect what the port sent back to it
+        if (reflect_len == 0) {
+            const ssize_t ret = sock->recv(buf, sizeof(buf), 0);
+            if (ret > 0) {
+                reflect_len = ret;
+            }
+        }
+        if (reflect_len > 0) {
+            const ssize_t ret = sock->send(buf, reflect_len);
+            if (ret > 0) {
+                reflect_len -= ret;
+                memmove(buf, &buf[ret], reflect_len);
+                active = true;
+            }
+        }
+
+        // read back in place
+        uint32_t n;
+        if (p.read_peek(n) != nullptr) {
+            p.read_advance(n);
+            total_rx += n;
+            active = true;
+        }
+
+        if (AP_HAL::millis() - last_report_ms >= 1000) {
+            const uint32_t kbytes = total_rx/1024;
+            GCS_SEND_TEXT(MAV_SEVERITY_INFO, "port_loopback throughput %u kbytes/sec %u us/kbyte",
+                          unsigned(kbytes), unsigned(kbytes>0?p.io_time_us/(2*kbytes):0));
+            total_rx = 0;
+            p.io_time_us = 0;
+            last_report_ms = AP_HAL::millis();
+        }
+        if (!active) {
+            hal.scheduler->delay_microseconds(100);
+        }
+    }
+}
+#endif // AP_NETWORKING_REGISTER_PORT_ENABLED
+
 #endif // AP_NETWORKING_ENABLED && AP_NETWORKING_TESTS_ENABLED
@@ -24,6 +24,7 @@
 #include "AP_Param.h"
 
 #include <cmath>
+#include <ctype.h>
 #include <string.h>
 
 #include <AP_Common/AP_Common.h>
@@ -104,6 +105,22 @@ uint16_t AP_Param::_count_marker;
 uint16_t AP_Param::_count_marker_done;
 HAL_Semaphore AP_Param::_count_sem;
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+AP_Param::NameIndexEntry *AP_Param::_name_index;
+uint16_t AP_Param::_name_index_count;
+uint16_t AP_Param::_name_index_marker;
+bool AP_Param::_name_index_built;
+HAL_Semaphore AP_Param::_name_index_sem;
+#endif
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+AP_Param::StorageIndexEntry *AP_Param::_storage_index;
+uint16_t AP_Param::_storage_index_count;
+uint16_t AP_Param::_storage_index_size;
+bool AP_Param::_storage_index_valid;
+HAL_Semaphore AP_Param::_storage_index_sem;
+#endif
+
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
 
@@ -187,6 +204,11 @@ void AP_Param::erase_all(void)
 
     // add a sentinel directly after the header
     write_sentinel(sizeof(struct EEPROM_header));
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    WITH_SEMAPHORE(_storage_index_sem);
+    _storage_index_count = 0;
+#endif
 }
 
 /* the 'group_id' of a element of a group is the 18 bit identifier
@@ -762,6 +784,20 @@ bool AP_Param::is_sentinel(const Param_header &phdr)
 // if the sentinel isn't found either, the offset is set to 0xFFFF
 bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
 {
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_storage_index_sem);
+        if (_storage_index_valid) {
+            bool found;
+            if (storage_index_scan(*target, *pofs, found)) {
+                return found;
+            }
+            // storage has changed under us; stop trusting the index
+            storage_index_clear();
+        }
+    }
+#endif
+
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
     while (ofs < _storage.size()) {
@@ -786,6 +822,113 @@ bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
     return false;
 }
 
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+/*
+  the storage index is sorted on the key, then group element, then
+  type, so all the variables of an object are adjacent
+ */
+uint32_t AP_Param::storage_index_key(const Param_header &phdr)
+{
+    return (uint32_t(get_key(phdr)) << 23) | (uint32_t(phdr.group_element) << 5) | phdr.type;
+}
+
+int AP_Param::storage_index_compare(const void *v1, const void *v2)
+{
+    const auto *e1 = (const StorageIndexEntry *)v1;
+    const auto *e2 = (const StorageIndexEntry *)v2;
+    if (e1->sort_key != e2->sort_key) {
+        return e1->sort_key < e2->sort_key ? -1 : 1;
+    }
+    // a duplicate header should never happen, but if it does the
+    // first one in storage wins, as it does for a linear scan
+    return int(e1->ofs) - int(e2->ofs);
+}
+
+// grow the index to hold at least count entries
+bool AP_Param::storage_index_reserve(uint16_t count)
+{
+    if (count <= _storage_index_size) {
+        return true;
+    }
+    StorageIndexEntry *new_index = NEW_NOTHROW StorageIndexEntry[count];
+    if (new_index == nullptr) {
+        return false;
+    }
+    if (_storage_index_count > 0) {
+        memcpy(new_index, _storage_index, _storage_index_count*sizeof(StorageIndexEntry));
+    }
+    delete[] _storage_index;
+    _storage_index = new_index;
+    _storage_index_size = count;
+    return true;
+}
+
+void AP_Param::storage_index_clear(void)
+{
+    delete[] _storage_index;
+    _storage_index = nullptr;
+    _storage_index_count = 0;
+    _storage_index_size = 0;
+    _storage_index_valid = false;
+}
+
+// add a newly saved variable to the index
+void AP_Param::storage_index_insert(const Param_header &phdr, uint16_t ofs)
+{
+    WITH_SEMAPHORE(_storage_index_sem);
+    if (!_storage_index_valid) {
+        return;
+    }
+    if (_storage_index_count == _storage_index_size &&
+        !storage_index_reserve(_storage_index_size + 16)) {
+        storage_index_clear();
+        return;
+    }
+    const uint32_t sort_key = storage_index_key(phdr);
+    uint16_t i = _storage_index_count;
+    while (i > 0 && _storage_index[i-1].sort_key > sort_key) {
+        i--;
+    }
+    memmove(&_storage_index[i+1], &_storage_index[i], (_storage_index_count-i)*sizeof(StorageIndexEntry));
+    _storage_index[i].sort_key = sort_key;
+    _storage_index[i].ofs = ofs;
+    _storage_index_count++;
+}
+
+/*
+  look up a header in the index, giving the same result as a linear
+  scan() would. Returns false if storage doesn't agree with the index
+ */
+bool AP_Param::storage_index_scan(const Param_header &target, uint16_t &ofs, bool &found)
+{
+    const uint32_t sort_key = storage_index_key(target);
+    uint16_t lo = 0;
+    uint16_t hi = _storage_index_count;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if (_storage_index[mid].sort_key < sort_key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    struct Param_header phdr;
+    if (lo < _storage_index_count && _storage_index[lo].sort_key == sort_key) {
+        ofs = _storage_index[lo].ofs;
+        _storage.read_block(&phdr, ofs, sizeof(phdr));
+        found = true;
+        return storage_index_key(phdr) == sort_key;
+    }
+
+    // not stored, so the caller wants the sentinel
+    ofs = sentinel_offset;
+    _storage.read_block(&phdr, ofs, sizeof(phdr));
+    found = false;
+    return is_sentinel(phdr);
+}
+#endif  // AP_PARAM_STORAGE_INDEX_ENABLED
+
 /**
  * add a _X, _Y, _Z suffix to the name of a Vector3f element
  * @param buffer
@@ -917,6 +1060,12 @@ AP_Param::find_group(const char *name, uint16_t vindex, ptrdiff_t group_offset,
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
 {
+#if AP_PARAM_NAME_INDEX_ENABLED
+    AP_Param *indexed = name_index_find(name, ptype, flags, nullptr);
+    if (indexed != nullptr) {
+        return indexed;
+    }
+#endif
     for (uint16_t i=0; i<_num_vars; i++) {
         const auto &info = var_info(i);
         uint8_t type = info.type;
@@ -982,6 +1131,12 @@ AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token
 AP_Param* AP_Param::find_by_name(const char* name, enum ap_var_type *ptype, ParamToken *token)
 {
     AP_Param *ap;
+#if AP_PARAM_NAME_INDEX_ENABLED
+    ap = name_index_find(name, ptype, nullptr, token);
+    if (ap != nullptr) {
+        return ap;
+    }
+#endif
     for (ap = AP_Param::first(token, ptype);
          ap && *ptype != AP_PARAM_GROUP && *ptype != AP_PARAM_NONE;
          ap = AP_Param::next_scalar(token, ptype)) {
@@ -1003,6 +1158,185 @@ AP_Param* AP_Param::find_by_name(const char* name, enum ap_var_type *ptype, Para
     return ap;
 }
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+/*
+  case-insensitive FNV-1a hash of a parameter name
+ */
+uint32_t AP_Param::name_hash(const char *name)
+{
+    uint32_t h = 2166136261U;
+    for (uint8_t i=0; i<AP_MAX_NAME_SIZE && name[i] != 0; i++) {
+        h ^= (uint8_t)toupper(name[i]);
+        h *= 16777619U;
+    }
+    return h & 0x7FFFFFFFU;
+}
+
+int AP_Param::name_index_compare(const void *v1, const void *v2)
+{
+    const auto *e1 = (const NameIndexEntry *)v1;
+    const auto *e2 = (const NameIndexEntry *)v2;
+    if (e1->hash != e2->hash) {
+        return e1->hash < e2->hash ? -1 : 1;
+    }
+    // keep duplicate names in tree order so the first one wins, as
+    // it does in the full search
+    if (e1->token.key != e2->token.key) {
+        return e1->token.key < e2->token.key ? -1 : 1;
+    }
+    if (e1->token.group_element != e2->token.group_element) {
+        return e1->token.group_element < e2->token.group_element ? -1 : 1;
+    }
+    return int(e1->token.idx) - int(e2->token.idx);
+}
+
+/*
+  (re)build the name index. This walks the whole tree twice, once to
+  size the allocation and once to fill it. Called with
+  _name_index_sem held
+ */
+void AP_Param::name_index_build(void)
+{
+    delete[] _name_index;
+    _name_index = nullptr;
+    _name_index_count = 0;
+    _name_index_marker = _count_marker;
+    _name_index_built = true;
+
+    ParamToken token {};
+    enum ap_var_type type;
+    uint16_t count = 0;
+    for (AP_Param *ap = first(&token, &type);
+         ap != nullptr;
+         ap = next(&token, &type, false)) {
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+    _name_index = NEW_NOTHROW NameIndexEntry[count];
+    if (_name_index == nullptr) {
+        // lookups fall back to the full search
+        return;
+    }
+
+    // all parameters in a group after an enable parameter may be
+    // hidden from the scalar iteration, which find_by_name() must
+    // honour, so we note the top level key we last saw one in
+    int32_t enable_key = -1;
+    uint16_t n = 0;
+    for (AP_Param *ap = first(&token, &type);
+         ap != nullptr && n < count;
+         ap = next(&token, &type, false)) {
+        uint32_t group_element;
+        const struct GroupInfo *ginfo;
+        struct GroupNesting group_nesting {};
+        uint8_t idx;
+        const struct Info *info = ap->find_var_info_token(token, &group_element, ginfo, group_nesting, &idx);
+        if (info == nullptr) {
+            continue;
+        }
+        char name[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_info(info, ginfo, group_nesting, idx, name, sizeof(name), token.idx != 0);
+        name[AP_MAX_NAME_SIZE] = 0;
+        if (ginfo != nullptr && (ginfo->flags & AP_PARAM_FLAG_ENABLE)) {
+            enable_key = token.key;
+        }
+        NameIndexEntry &e = _name_index[n++];
+        e.hash = name_hash(name);
+        e.hideable = (enable_key == token.key);
+        e.token = token;
+        e.token.last_disabled = 0;
+        e.ptr = ap;
+    }
+    _name_index_count = n;
+
+    qsort(_name_index, _name_index_count, sizeof(NameIndexEntry), name_index_compare);
+}
+
+/*
+  look up a name in the index, building it first if needed. A nullptr
+  return means the caller should do the full search. If token is
+  non-null then this is a find_by_name() lookup, which is case
+  insensitive and only considers the parameters a scalar iteration
+  would return
+ */
+AP_Param *AP_Param::name_index_find(const char *name, enum ap_var_type *ptype, uint16_t *flags, ParamToken *token)
+{
+    WITH_SEMAPHORE(_name_index_sem);
+
+    if (_num_vars == 0) {
+        return nullptr;
+    }
+    if (!_name_index_built || _name_index_marker != _count_marker) {
+        name_index_build();
+    }
+
+    const uint32_t hash = name_hash(name);
+
+    // find the first entry with this hash
+    uint16_t lo = 0;
+    uint16_t hi = _name_index_count;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if (_name_index[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for (uint16_t i=lo; i<_name_index_count && _name_index[i].hash == hash; i++) {
+        const NameIndexEntry &e = _name_index[i];
+        const bool vector_element = e.token.idx != 0;
+        if (token != nullptr && (e.hideable || vector_element)) {
+            // the scalar iteration names these differently or may
+            // hide them
+            return nullptr;
+        }
+        /*
+          check the entry still describes this name. This also catches
+          objects which have been reallocated since the index was
+          built, as their parameters will no longer be found at the
+          old address
+         */
+        uint32_t group_element;
+        const struct GroupInfo *ginfo;
+        struct GroupNesting group_nesting {};
+        uint8_t idx;
+        const struct Info *info = e.ptr->find_var_info_token(e.token, &group_element, ginfo, group_nesting, &idx);
+        if (info == nullptr) {
+            return nullptr;
+        }
+        char buf[AP_MAX_NAME_SIZE+1];
+        e.ptr->copy_name_info(info, ginfo, group_nesting, idx, buf, sizeof(buf), vector_element);
+        buf[AP_MAX_NAME_SIZE] = 0;
+        const int cmp = token != nullptr ? strcasecmp(name, buf) : strcmp(name, buf);
+        if (cmp != 0) {
+            continue;
+        }
+        enum ap_var_type type;
+        if (vector_element) {
+            type = AP_PARAM_FLOAT;
+        } else {
+            type = (enum ap_var_type)(ginfo != nullptr ? ginfo->type : info->type);
+        }
+        if (token != nullptr) {
+            if (type > AP_PARAM_FLOAT) {
+                return nullptr;
+            }
+            *token = e.token;
+        }
+        *ptype = type;
+        if (flags != nullptr) {
+            *flags = ginfo != nullptr ? ginfo->flags : 0;
+        }
+        return e.ptr;
+    }
+    return nullptr;
+}
+#endif  // AP_PARAM_NAME_INDEX_ENABLED
+
 /*
   Find a variable by pointer, returning key. This is used for loading pointer variables
 */
@@ -1236,6 +1570,9 @@ void AP_Param::save_sync(bool force_save, bool send_to_gcs)
     write_sentinel(ofs + sizeof(phdr) + type_size((enum ap_var_type)phdr.type));
     eeprom_write_check(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
     eeprom_write_check(&phdr, ofs, sizeof(phdr));
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    storage_index_insert(phdr, ofs);
+#endif
 
     if (send_to_gcs) {
         send_parameter(name, (enum ap_var_type)phdr.type, idx);
@@ -1566,12 +1903,26 @@ bool AP_Param::load_all()
         registered_save_handler = true;
         hal.scheduler->register_io_process(FUNCTOR_BIND((&save_dummy), &AP_Param::save_io_handler, void));
     }
-    
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    // build the storage index as we go, so that later scans for
+    // objects and old parameters don't need to walk storage again
+    WITH_SEMAPHORE(_storage_index_sem);
+    storage_index_clear();
+    bool indexing = true;
+#endif
+
     while (ofs < _storage.size()) {
         _storage.read_block(&phdr, ofs, sizeof(phdr));
         if (is_sentinel(phdr)) {
             // we've reached the sentinel
             sentinel_offset = ofs;
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+            if (indexing) {
+                qsort(_storage_index, _storage_index_count, sizeof(StorageIndexEntry), storage_index_compare);
+                _storage_index_valid = true;
+            }
+#endif
             return true;
         }
 
@@ -1583,11 +1934,29 @@ bool AP_Param::load_all()
             _storage.read_block(ptr, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
         }
 
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+        if (indexing &&
+            _storage_index_count == _storage_index_size &&
+            !storage_index_reserve(_storage_index_size + MAX(_storage_index_size/2U, 64U))) {
+            // scans fall back to walking storage
+            storage_index_clear();
+            indexing = false;
+        }
+        if (indexing) {
+            _storage_index[_storage_index_count].sort_key = storage_index_key(phdr);
+            _storage_index[_storage_index_count].ofs = ofs;
+            _storage_index_count++;
+        }
+#endif
+
         ofs += type_size((enum ap_var_type)phdr.type) + sizeof(phdr);
     }
 
     // we didn't find the sentinel
     Debug("no sentinel in load_all");
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    storage_index_clear();
+#endif
     return false;
 }
 
@@ -1681,7 +2050,21 @@ void AP_Param::load_object_from_eeprom(const void *object_pointer, const struct
         DEV_PRINTF("ERROR: Unable to find param pointer\n");
         return;
     }
-    
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    // the top level var_info entry holding the object, so we can
+    // work out the header of each element and look it up directly
+    ParamToken token {};
+    bool have_token = false;
+    for (uint16_t v=0; v<_num_vars; v++) {
+        if (var_info(v).key == key) {
+            token.key = v;
+            have_token = true;
+            break;
+        }
+    }
+#endif
+
     for (uint8_t i=0; group_info[i].type != AP_PARAM_NONE; i++) {
         if (group_info[i].type == AP_PARAM_GROUP) {
             ptrdiff_t new_offset = 0;
@@ -1693,6 +2076,26 @@ void AP_Param::load_object_from_eeprom(const void *object_pointer, const struct
                 load_object_from_eeprom((void *)(((ptrdiff_t)object_pointer)+new_offset), ginfo);
             }
         }
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+        if (have_token && group_info[i].type != AP_PARAM_GROUP) {
+            AP_Param *ap = (AP_Param *)(((ptrdiff_t)object_pointer)+group_info[i].offset);
+            uint32_t group_element;
+            const struct GroupInfo *ginfo;
+            struct GroupNesting group_nesting {};
+            uint8_t idx;
+            const struct Info *info = ap->find_var_info_token(token, &group_element, ginfo, group_nesting, &idx);
+            if (info != nullptr && ginfo != nullptr && idx == 0) {
+                phdr.type = ginfo->type;
+                set_key(phdr, key);
+                phdr.group_element = group_element;
+                uint16_t ofs;
+                if (scan(&phdr, &ofs)) {
+                    _storage.read_block(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
+                }
+                continue;
+            }
+        }
+#endif
         uint16_t ofs = sizeof(AP_Param::EEPROM_header);
         while (ofs < _storage.size()) {
             _storage.read_block(&phdr, ofs, sizeof(phdr));
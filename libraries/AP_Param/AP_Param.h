@@ -199,6 +199,8 @@ enum ap_var_type {
 ///
 class AP_Param
 {
+    friend class AP_Param_Test;
+
 public:
     // the Info and GroupInfo structures are passed by the main
     // program in setup() to give information on how variables are
@@ -818,6 +820,62 @@ private:
     static HAL_Semaphore        _count_sem;
     static const struct Info *  _var_info;
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+    /*
+      index of parameter names, sorted by a hash of the name. Entries
+      are checked against the var_info tree on each hit, so a stale or
+      colliding entry costs a fallback to the full search, never a
+      wrong answer
+     */
+    struct NameIndexEntry {
+        uint32_t hash:31;
+        uint32_t hideable:1;    // may be hidden by an enable parameter
+        ParamToken token;
+        AP_Param *ptr;
+    };
+    static NameIndexEntry *     _name_index;
+    static uint16_t             _name_index_count;
+    static uint16_t             _name_index_marker;
+    static bool                 _name_index_built;
+    static HAL_Semaphore        _name_index_sem;
+
+    static uint32_t             name_hash(const char *name);
+    static int                  name_index_compare(const void *v1, const void *v2);
+    static void                 name_index_build(void);
+    static AP_Param *           name_index_find(
+                                    const char *name,
+                                    enum ap_var_type *ptype,
+                                    uint16_t *flags,
+                                    ParamToken *token);
+#endif
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    /*
+      index of the variables in storage, built by load_all() and
+      sorted by key, group element and type. Each hit is checked
+      against the header in storage before it is used
+     */
+    struct PACKED StorageIndexEntry {
+        uint32_t sort_key;
+        uint16_t ofs;
+    };
+    static StorageIndexEntry *  _storage_index;
+    static uint16_t             _storage_index_count;
+    static uint16_t             _storage_index_size;
+    static bool                 _storage_index_valid;
+    static HAL_Semaphore        _storage_index_sem;
+
+    static uint32_t             storage_index_key(const Param_header &phdr);
+    static int                  storage_index_compare(const void *v1, const void *v2);
+    static bool                 storage_index_reserve(uint16_t count);
+    static void                 storage_index_insert(const Param_header &phdr, uint16_t ofs);
+    static void                 storage_index_clear(void);
+    static bool                 storage_index_scan(
+                                    const Param_header &target,
+                                    uint16_t &ofs,
+                                    bool &found);
+#endif
+
 #if AP_PARAM_DYNAMIC_ENABLED
     // allow for a dynamically allocated var table
     static uint16_t             _num_vars_base;
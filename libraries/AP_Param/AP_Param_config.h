@@ -11,3 +11,14 @@
 #ifndef FORCE_APJ_DEFAULT_PARAMETERS
 #define FORCE_APJ_DEFAULT_PARAMETERS 0
 #endif
+
+// keep a sorted index of parameter names for fast lookup by name
+#ifndef AP_PARAM_NAME_INDEX_ENABLED
+#define AP_PARAM_NAME_INDEX_ENABLED (HAL_PROGRAM_SIZE_LIMIT_KB > 1024)
+#endif
+
+// keep an index of where each parameter is in storage, so lookups
+// after boot don't need to scan the whole storage area
+#ifndef AP_PARAM_STORAGE_INDEX_ENABLED
+#define AP_PARAM_STORAGE_INDEX_ENABLED (HAL_PROGRAM_SIZE_LIMIT_KB > 1024)
+#endif
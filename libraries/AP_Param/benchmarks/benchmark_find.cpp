@@ -0,0 +1,144 @@
+/*
+ * Benchmarks for looking up parameters by name
+ */
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Param/AP_Param.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// a typical controller-sized group
+class BenchGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+
+    AP_Int8 enable;
+    AP_Float p;
+    AP_Float i;
+    AP_Float d;
+    AP_Float ff;
+    AP_Float imax;
+    AP_Float filt_t;
+    AP_Float filt_e;
+    AP_Float filt_d;
+    AP_Int16 rate;
+    AP_Int32 options;
+    AP_Vector3f ofs;
+};
+
+const AP_Param::GroupInfo BenchGroup::var_info[] = {
+    AP_GROUPINFO("ENABLE", 1, BenchGroup, enable, 1),
+    AP_GROUPINFO("P", 2, BenchGroup, p, 0.1),
+    AP_GROUPINFO("I", 3, BenchGroup, i, 0.1),
+    AP_GROUPINFO("D", 4, BenchGroup, d, 0),
+    AP_GROUPINFO("FF", 5, BenchGroup, ff, 0),
+    AP_GROUPINFO("IMAX", 6, BenchGroup, imax, 0.5),
+    AP_GROUPINFO("FLTT", 7, BenchGroup, filt_t, 20),
+    AP_GROUPINFO("FLTE", 8, BenchGroup, filt_e, 0),
+    AP_GROUPINFO("FLTD", 9, BenchGroup, filt_d, 20),
+    AP_GROUPINFO("RATE", 10, BenchGroup, rate, 50),
+    AP_GROUPINFO("OPTIONS", 11, BenchGroup, options, 0),
+    AP_GROUPINFO("OFS", 12, BenchGroup, ofs, 0),
+    AP_GROUPEND
+};
+
+#define NUM_GROUPS 50
+
+static AP_Int16 format_version;
+static BenchGroup groups[NUM_GROUPS];
+
+#define BENCH_GROUP(t, u) { "G" #t #u "_", (const void *)&groups[t*10+u], {group_info : BenchGroup::var_info}, 0, 1+t*10+u, AP_PARAM_GROUP }
+#define BENCH_GROUPS(t) \
+    BENCH_GROUP(t, 0), BENCH_GROUP(t, 1), BENCH_GROUP(t, 2), BENCH_GROUP(t, 3), BENCH_GROUP(t, 4), \
+    BENCH_GROUP(t, 5), BENCH_GROUP(t, 6), BENCH_GROUP(t, 7), BENCH_GROUP(t, 8), BENCH_GROUP(t, 9)
+
+static const AP_Param::Info var_info[] = {
+    { "FORMAT_VERSION", (const void *)&format_version, {def_value : 0}, 0, 0, AP_PARAM_INT16 },
+    BENCH_GROUPS(0),
+    BENCH_GROUPS(1),
+    BENCH_GROUPS(2),
+    BENCH_GROUPS(3),
+    BENCH_GROUPS(4),
+    AP_VAREND
+};
+
+static AP_Param param_loader{var_info};
+
+// names spread through the tree, as a defaults file or script would
+// ask for them
+static const char *names[] = {
+    "FORMAT_VERSION",
+    "G00_ENABLE",
+    "G07_IMAX",
+    "G13_OPTIONS",
+    "G21_FLTD",
+    "G28_OFS_Y",
+    "G34_P",
+    "G42_RATE",
+    "G49_OPTIONS",
+};
+
+// first lookup after the tree changes, which pays for building the
+// index; this is the cost seen once at boot
+static void BM_ParamFindCold(benchmark::State& state)
+{
+    enum ap_var_type ptype;
+    while (state.KeepRunning()) {
+        AP_Param::invalidate_count();
+        AP_Param *p = AP_Param::find("G49_OPTIONS", &ptype);
+        gbenchmark_escape(p);
+    }
+}
+
+static void BM_ParamFind(benchmark::State& state)
+{
+    enum ap_var_type ptype;
+    uint8_t i = 0;
+    while (state.KeepRunning()) {
+        AP_Param *p = AP_Param::find(names[i], &ptype);
+        gbenchmark_escape(p);
+        i = (i + 1) % ARRAY_SIZE(names);
+    }
+}
+
+static void BM_ParamFindWithFlags(benchmark::State& state)
+{
+    enum ap_var_type ptype;
+    uint16_t flags;
+    uint8_t i = 0;
+    while (state.KeepRunning()) {
+        AP_Param *p = AP_Param::find(names[i], &ptype, &flags);
+        gbenchmark_escape(p);
+        i = (i + 1) % ARRAY_SIZE(names);
+    }
+}
+
+static void BM_ParamFindByName(benchmark::State& state)
+{
+    enum ap_var_type ptype;
+    AP_Param::ParamToken token;
+    uint8_t i = 0;
+    while (state.KeepRunning()) {
+        AP_Param *p = AP_Param::find_by_name(names[i], &ptype, &token);
+        gbenchmark_escape(p);
+        i = (i + 1) % ARRAY_SIZE(names);
+    }
+}
+
+static void BM_ParamFindMissing(benchmark::State& state)
+{
+    enum ap_var_type ptype;
+    while (state.KeepRunning()) {
+        AP_Param *p = AP_Param::find("G50_NOT_THERE", &ptype);
+        gbenchmark_escape(p);
+    }
+}
+
+BENCHMARK(BM_ParamFindCold);
+BENCHMARK(BM_ParamFind);
+BENCHMARK(BM_ParamFindWithFlags);
+BENCHMARK(BM_ParamFindByName);
+BENCHMARK(BM_ParamFindMissing);
+
+BENCHMARK_MAIN();
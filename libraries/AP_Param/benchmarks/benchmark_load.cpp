@@ -0,0 +1,143 @@
+/*
+ * Benchmarks for loading parameters from a full storage image
+ */
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Param/AP_Param.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// a typical controller-sized group
+class BenchGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+
+    AP_Int8 enable;
+    AP_Float p;
+    AP_Float i;
+    AP_Float d;
+    AP_Float ff;
+    AP_Float imax;
+    AP_Float filt_t;
+    AP_Float filt_e;
+    AP_Float filt_d;
+    AP_Int16 rate;
+    AP_Int32 options;
+    AP_Vector3f ofs;
+};
+
+const AP_Param::GroupInfo BenchGroup::var_info[] = {
+    AP_GROUPINFO("ENABLE", 1, BenchGroup, enable, 1),
+    AP_GROUPINFO("P", 2, BenchGroup, p, 0.1),
+    AP_GROUPINFO("I", 3, BenchGroup, i, 0.1),
+    AP_GROUPINFO("D", 4, BenchGroup, d, 0),
+    AP_GROUPINFO("FF", 5, BenchGroup, ff, 0),
+    AP_GROUPINFO("IMAX", 6, BenchGroup, imax, 0.5),
+    AP_GROUPINFO("FLTT", 7, BenchGroup, filt_t, 20),
+    AP_GROUPINFO("FLTE", 8, BenchGroup, filt_e, 0),
+    AP_GROUPINFO("FLTD", 9, BenchGroup, filt_d, 20),
+    AP_GROUPINFO("RATE", 10, BenchGroup, rate, 50),
+    AP_GROUPINFO("OPTIONS", 11, BenchGroup, options, 0),
+    AP_GROUPINFO("OFS", 12, BenchGroup, ofs, 0),
+    AP_GROUPEND
+};
+
+// more groups than fit in parameter storage on any board, so that
+// storage can be filled
+#define NUM_GROUPS 200
+
+static AP_Int16 format_version;
+static BenchGroup groups[NUM_GROUPS];
+
+#define BENCH_GROUP(t, u) { "G" #t #u "_", (const void *)&groups[t*10+u], {group_info : BenchGroup::var_info}, 0, 1+t*10+u, AP_PARAM_GROUP }
+#define BENCH_GROUPS(t) \
+    BENCH_GROUP(t, 0), BENCH_GROUP(t, 1), BENCH_GROUP(t, 2), BENCH_GROUP(t, 3), BENCH_GROUP(t, 4), \
+    BENCH_GROUP(t, 5), BENCH_GROUP(t, 6), BENCH_GROUP(t, 7), BENCH_GROUP(t, 8), BENCH_GROUP(t, 9)
+
+static const AP_Param::Info var_info[] = {
+    { "FORMAT_VERSION", (const void *)&format_version, {def_value : 0}, 0, 0, AP_PARAM_INT16 },
+    BENCH_GROUPS(0),
+    BENCH_GROUPS(1),
+    BENCH_GROUPS(2),
+    BENCH_GROUPS(3),
+    BENCH_GROUPS(4),
+    BENCH_GROUPS(5),
+    BENCH_GROUPS(6),
+    BENCH_GROUPS(7),
+    BENCH_GROUPS(8),
+    BENCH_GROUPS(9),
+    BENCH_GROUPS(10),
+    BENCH_GROUPS(11),
+    BENCH_GROUPS(12),
+    BENCH_GROUPS(13),
+    BENCH_GROUPS(14),
+    BENCH_GROUPS(15),
+    BENCH_GROUPS(16),
+    BENCH_GROUPS(17),
+    BENCH_GROUPS(18),
+    BENCH_GROUPS(19),
+    AP_VAREND
+};
+
+static AP_Param param_loader{var_info};
+
+// the last variable that fitted in storage
+static AP_Param *last_saved;
+
+// room for the largest variable, a Vector3f, and the sentinel
+#define MAX_VAR_STORAGE (3*sizeof(float) + 2*4)
+
+/*
+  save variables, last group first so that storage is not in key
+  order, until there is no room for more
+ */
+static void fill_storage(void)
+{
+    if (last_saved != nullptr) {
+        return;
+    }
+    AP_Param::erase_all();
+    for (int16_t g=NUM_GROUPS-1; g>=0; g--) {
+        AP_Param *vars[] {
+            &groups[g].enable, &groups[g].p, &groups[g].i, &groups[g].d,
+            &groups[g].ff, &groups[g].imax, &groups[g].filt_t, &groups[g].filt_e,
+            &groups[g].filt_d, &groups[g].rate, &groups[g].options, &groups[g].ofs,
+        };
+        for (AP_Param *ap : vars) {
+            if (AP_Param::storage_used() + MAX_VAR_STORAGE >= AP_Param::storage_size()) {
+                return;
+            }
+            ap->save_sync(true, false);
+            last_saved = ap;
+        }
+    }
+}
+
+// boot time load of every stored variable, which also builds the
+// storage index
+static void BM_ParamLoadAll(benchmark::State& state)
+{
+    fill_storage();
+    while (state.KeepRunning()) {
+        bool ret = AP_Param::load_all();
+        gbenchmark_escape(&ret);
+    }
+}
+
+// load of a single variable at the end of full storage, as done when
+// an object is loaded or an old parameter converted after boot
+static void BM_ParamLoadLast(benchmark::State& state)
+{
+    fill_storage();
+    AP_Param::load_all();
+    while (state.KeepRunning()) {
+        bool ret = last_saved->load();
+        gbenchmark_escape(&ret);
+    }
+}
+
+BENCHMARK(BM_ParamLoadAll);
+BENCHMARK(BM_ParamLoadLast);
+
+BENCHMARK_MAIN();
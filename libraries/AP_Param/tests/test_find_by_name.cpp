@@ -85,4 +85,24 @@ TEST(FindByName, Bob)
     }
 }
 
+TEST(FindByName, Find)
+{
+    for (uint8_t pass=0; pass<2; pass++) {
+        // the second pass finds everything again after the name index
+        // has been discarded
+        for (const auto &x : TestVehicle::var_info) {
+            enum ap_var_type ptype = (ap_var_type)-1;
+            uint16_t flags = 0xFFFF;
+            AP_Param *p = AP_Param::find(x.name, &ptype, &flags);
+            EXPECT_EQ(p, (AP_Param *)x.ptr);
+            EXPECT_EQ(ptype, AP_PARAM_INT8);
+            EXPECT_EQ(flags, 0);
+        }
+        AP_Param::invalidate_count();
+    }
+    enum ap_var_type ptype;
+    EXPECT_EQ(AP_Param::find("D", &ptype), nullptr);
+    EXPECT_EQ(AP_Param::find("", &ptype), nullptr);
+}
+
 AP_GTEST_MAIN()
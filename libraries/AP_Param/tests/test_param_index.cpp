@@ -0,0 +1,225 @@
+/*
+  check that find() and find_by_name() give the same answers for
+  group members, nested groups and Vector3f elements as a full search
+  of var_info, whether or not the name index is used
+ */
+#define AP_PARAM_VEHICLE_NAME testvehicle
+
+#include <AP_gtest.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Param/AP_Param.h>
+#include <AP_Vehicle/AP_Vehicle.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+class TestSubGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+
+    AP_Int8 s8;
+    AP_Float sf;
+    AP_Vector3f svec;
+};
+
+const AP_Param::GroupInfo TestSubGroup::var_info[] = {
+    AP_GROUPINFO("S8", 1, TestSubGroup, s8, 3),
+    AP_GROUPINFO("SF", 2, TestSubGroup, sf, 1.5f),
+    AP_GROUPINFO("SVEC", 3, TestSubGroup, svec, 0),
+    AP_GROUPEND
+};
+
+class TestGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+
+    AP_Int16 i16;
+    AP_Float f;
+    AP_Vector3f vec;
+    TestSubGroup sub;
+};
+
+const AP_Param::GroupInfo TestGroup::var_info[] = {
+    AP_GROUPINFO("I16", 1, TestGroup, i16, 100),
+    AP_GROUPINFO("F", 2, TestGroup, f, 0.5f),
+    AP_GROUPINFO("VEC", 3, TestGroup, vec, 0),
+    AP_SUBGROUPINFO(sub, "SUB_", 4, TestGroup, TestSubGroup),
+    AP_GROUPEND
+};
+
+class Parameters {
+public:
+    enum {
+        k_param_a,
+        k_param_v,
+        k_param_grp,
+    };
+    AP_Int8 a;
+    AP_Vector3f v;
+};
+
+class TestVehicle : public AP_Vehicle {
+public:
+    TestVehicle() { unused_log_bitmask.set(-1); }
+    // HAL::Callbacks implementation.
+    void load_parameters(void) override {};
+    void get_scheduler_tasks(const AP_Scheduler::Task *&tasks,
+                             uint8_t &task_count,
+                             uint32_t &log_bit) override {
+        tasks = nullptr;
+        task_count = 0;
+        log_bit = 0;
+    };
+
+    virtual bool set_mode(const uint8_t new_mode, const ModeReason reason) override { return true; }
+    virtual uint8_t get_mode() const override { return 0; }
+
+    AP_Int32 unused_log_bitmask; // logging is magic for Test; this is unused
+    struct LogStructure log_structure[256] = {
+    };
+
+protected:
+
+    const AP_Int32 &get_log_bitmask() override { return unused_log_bitmask; }
+    const struct LogStructure *get_log_structures() const override {
+        return log_structure;
+    }
+    uint8_t get_num_log_structures() const override {
+        return uint8_t(ARRAY_SIZE(log_structure));
+    }
+
+    void init_ardupilot() override {};
+
+public:
+
+    static const AP_Param::Info var_info[];
+
+    Parameters g;
+    TestGroup grp;
+    // setup the var_info table
+    AP_Param param_loader{var_info};
+
+};
+static TestVehicle testvehicle;
+
+const AP_Param::Info TestVehicle::var_info[] {
+    GSCALAR(a,         "A", 0),
+    GSCALAR(v,         "V", 0),
+    GOBJECT(grp,       "G_", TestGroup),
+    AP_VAREND
+};
+
+// pointer to element i of a Vector3f parameter, as find() returns it
+static AP_Param *element(AP_Vector3f &v, uint8_t i)
+{
+    return (AP_Param *)(((AP_Float *)&v) + i);
+}
+
+/*
+  the search find_by_name() does without the index: a walk of every
+  scalar, comparing names
+ */
+static AP_Param *find_by_name_full(const char *name, enum ap_var_type *ptype, AP_Param::ParamToken *token)
+{
+    AP_Param *ap;
+    for (ap = AP_Param::first(token, ptype);
+         ap && *ptype != AP_PARAM_GROUP && *ptype != AP_PARAM_NONE;
+         ap = AP_Param::next_scalar(token, ptype)) {
+        char buf[AP_MAX_NAME_SIZE];
+        ap->copy_name_token(*token, buf, AP_MAX_NAME_SIZE);
+        if (strncasecmp(name, buf, AP_MAX_NAME_SIZE) == 0) {
+            break;
+        }
+    }
+    return ap;
+}
+
+TEST(ParamIndex, Find)
+{
+    TestGroup &grp = testvehicle.grp;
+    const struct {
+        const char *name;
+        AP_Param *ptr;
+        enum ap_var_type type;
+    } expected[] {
+        { "A",            &testvehicle.g.a,       AP_PARAM_INT8 },
+        { "V",            &testvehicle.g.v,       AP_PARAM_VECTOR3F },
+        { "G_I16",        &grp.i16,               AP_PARAM_INT16 },
+        { "G_F",          &grp.f,                 AP_PARAM_FLOAT },
+        { "G_VEC",        &grp.vec,               AP_PARAM_VECTOR3F },
+        { "G_VEC_X",      element(grp.vec, 0),    AP_PARAM_FLOAT },
+        { "G_VEC_Y",      element(grp.vec, 1),    AP_PARAM_FLOAT },
+        { "G_VEC_Z",      element(grp.vec, 2),    AP_PARAM_FLOAT },
+        { "G_SUB_S8",     &grp.sub.s8,            AP_PARAM_INT8 },
+        { "G_SUB_SF",     &grp.sub.sf,            AP_PARAM_FLOAT },
+        { "G_SUB_SVEC",   &grp.sub.svec,          AP_PARAM_VECTOR3F },
+        { "G_SUB_SVEC_X", element(grp.sub.svec, 0), AP_PARAM_FLOAT },
+        { "G_SUB_SVEC_Z", element(grp.sub.svec, 2), AP_PARAM_FLOAT },
+    };
+    for (uint8_t pass=0; pass<2; pass++) {
+        // the second pass finds everything again after the name index
+        // has been discarded
+        for (const auto &x : expected) {
+            enum ap_var_type ptype = (ap_var_type)-1;
+            EXPECT_EQ(AP_Param::find(x.name, &ptype), x.ptr) << x.name;
+            EXPECT_EQ(ptype, x.type) << x.name;
+        }
+        AP_Param::invalidate_count();
+    }
+
+    const char *missing[] { "G_", "G_SUB_", "G_NOPE", "G_SUB_NOPE", "G_VEC_W", "G_SUB_SVEC_", "SUB_S8" };
+    for (const char *name : missing) {
+        enum ap_var_type ptype;
+        EXPECT_EQ(AP_Param::find(name, &ptype), nullptr) << name;
+    }
+}
+
+TEST(ParamIndex, FindByName)
+{
+    // every scalar, by both of the names it is known by, plus the
+    // lower case versions of those
+    uint16_t count = 0;
+    AP_Param::ParamToken token {};
+    enum ap_var_type type;
+    for (AP_Param *ap = AP_Param::first(&token, &type);
+         ap != nullptr;
+         ap = AP_Param::next_scalar(&token, &type)) {
+        char names[4][AP_MAX_NAME_SIZE+1] {};
+        ap->copy_name_token(token, names[0], AP_MAX_NAME_SIZE, true);
+        ap->copy_name_token(token, names[1], AP_MAX_NAME_SIZE, false);
+        for (uint8_t i=0; i<2; i++) {
+            for (uint8_t j=0; names[i][j] != 0; j++) {
+                names[i+2][j] = tolower(names[i][j]);
+            }
+        }
+        for (const char *name : names) {
+            enum ap_var_type full_type = AP_PARAM_NONE;
+            AP_Param::ParamToken full_token {};
+            AP_Param *full = find_by_name_full(name, &full_type, &full_token);
+
+            enum ap_var_type found_type = AP_PARAM_NONE;
+            AP_Param::ParamToken found_token {};
+            AP_Param *found = AP_Param::find_by_name(name, &found_type, &found_token);
+
+            EXPECT_EQ(found, full) << name;
+            if (found != nullptr && found == full) {
+                EXPECT_EQ(found_type, full_type) << name;
+                EXPECT_EQ(found_token.key, full_token.key) << name;
+                EXPECT_EQ(found_token.group_element, full_token.group_element) << name;
+                EXPECT_EQ(found_token.idx, full_token.idx) << name;
+            }
+        }
+        count++;
+    }
+    // A, V_X/Y/Z, G_I16, G_F, G_VEC_X/Y/Z, G_SUB_S8, G_SUB_SF, G_SUB_SVEC_X/Y/Z
+    EXPECT_EQ(count, 14);
+
+    // a scalar iteration can reach every Vector3f element by name
+    enum ap_var_type ptype;
+    AP_Param::ParamToken t {};
+    EXPECT_EQ(AP_Param::find_by_name("G_SUB_SVEC_Y", &ptype, &t), element(testvehicle.grp.sub.svec, 1));
+    EXPECT_EQ(ptype, AP_PARAM_FLOAT);
+    EXPECT_EQ(AP_Param::find_by_name("g_vec_z", &ptype, &t), element(testvehicle.grp.vec, 2));
+    EXPECT_EQ(AP_Param::find_by_name("G_SUB_NOPE", &ptype, &t), nullptr);
+}
+
+AP_GTEST_MAIN()
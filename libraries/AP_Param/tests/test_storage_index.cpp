@@ -0,0 +1,209 @@
+/*
+  check that the storage index built by load_all() follows storage as
+  variables are saved, erased and reloaded, and that it is thrown away
+  if storage is changed behind its back
+ */
+#include <AP_gtest.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Param/AP_Param.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+
+class TestGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+
+    AP_Int8 enable;
+    AP_Float p;
+    AP_Int16 rate;
+    AP_Vector3f ofs;
+};
+
+const AP_Param::GroupInfo TestGroup::var_info[] = {
+    AP_GROUPINFO("ENABLE", 1, TestGroup, enable, 0),
+    AP_GROUPINFO("P", 2, TestGroup, p, 0.1f),
+    AP_GROUPINFO("RATE", 3, TestGroup, rate, 50),
+    AP_GROUPINFO("OFS", 4, TestGroup, ofs, 0),
+    AP_GROUPEND
+};
+
+static AP_Int16 format_version;
+static AP_Int32 i32;
+static TestGroup groups[2];
+
+static const AP_Param::Info var_info[] = {
+    { "FORMAT_VERSION", (const void *)&format_version, {def_value : 0}, 0, 0, AP_PARAM_INT16 },
+    { "I32", (const void *)&i32, {def_value : 0}, 0, 1, AP_PARAM_INT32 },
+    { "G0_", (const void *)&groups[0], {group_info : TestGroup::var_info}, 0, 2, AP_PARAM_GROUP },
+    { "G1_", (const void *)&groups[1], {group_info : TestGroup::var_info}, 0, 3, AP_PARAM_GROUP },
+    AP_VAREND
+};
+
+static AP_Param param_loader{var_info};
+
+class AP_Param_Test
+{
+public:
+    static bool valid() { return AP_Param::_storage_index_valid; }
+    static uint16_t count() { return AP_Param::_storage_index_count; }
+
+    // the index is sorted and every entry points at a header that
+    // matches it
+    static bool consistent()
+    {
+        for (uint16_t i=0; i<AP_Param::_storage_index_count; i++) {
+            const auto &e = AP_Param::_storage_index[i];
+            if (i > 0 && AP_Param::_storage_index[i-1].sort_key >= e.sort_key) {
+                return false;
+            }
+            AP_Param::Param_header phdr;
+            AP_Param::_storage.read_block(&phdr, e.ofs, sizeof(phdr));
+            if (AP_Param::storage_index_key(phdr) != e.sort_key) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // overwrite the header of the first variable in storage with one
+    // that belongs to no variable, without telling the index
+    static void clobber_first_header()
+    {
+        AP_Param::Param_header phdr {};
+        AP_Param::_storage.read_block(&phdr, sizeof(AP_Param::EEPROM_header), sizeof(phdr));
+        AP_Param::set_key(phdr, 200);
+        AP_Param::_storage.write_block(sizeof(AP_Param::EEPROM_header), &phdr, sizeof(phdr));
+    }
+};
+
+// start each test from empty storage and a freshly built index
+static void reset_storage(void)
+{
+    AP_Param::erase_all();
+    ASSERT_TRUE(AP_Param::load_all());
+    ASSERT_TRUE(AP_Param_Test::valid());
+    ASSERT_EQ(AP_Param_Test::count(), 0);
+}
+
+TEST(ParamStorageIndex, Insert)
+{
+    reset_storage();
+
+    // saved out of key order, so each insert lands in a different place
+    groups[1].rate.set(10);
+    groups[1].rate.save_sync(false, false);
+    i32.set(1234);
+    i32.save_sync(false, false);
+    groups[0].ofs.set(Vector3f(1, 2, 3));
+    groups[0].ofs.save_sync(false, false);
+    groups[1].p.set(0.5f);
+    groups[1].p.save_sync(false, false);
+    format_version.set(7);
+    format_version.save_sync(false, false);
+    EXPECT_TRUE(AP_Param_Test::valid());
+    EXPECT_EQ(AP_Param_Test::count(), 5);
+    EXPECT_TRUE(AP_Param_Test::consistent());
+
+    // saving a variable already in storage rewrites it in place
+    i32.set(4321);
+    i32.save_sync(false, false);
+    EXPECT_EQ(AP_Param_Test::count(), 5);
+
+    // a variable still at its default isn't stored
+    groups[0].enable.save_sync(false, false);
+    EXPECT_EQ(AP_Param_Test::count(), 5);
+
+    // every saved variable is found through the index
+    i32.set(0);
+    groups[0].ofs.set(Vector3f());
+    groups[1].rate.set(0);
+    EXPECT_TRUE(i32.load());
+    EXPECT_TRUE(groups[0].ofs.load());
+    EXPECT_TRUE(groups[1].rate.load());
+    EXPECT_FALSE(groups[0].enable.load());
+    EXPECT_EQ(i32.get(), 4321);
+    EXPECT_EQ(groups[0].ofs.get(), Vector3f(1, 2, 3));
+    EXPECT_EQ(groups[1].rate.get(), 10);
+    EXPECT_TRUE(AP_Param_Test::valid());
+}
+
+TEST(ParamStorageIndex, EraseAll)
+{
+    reset_storage();
+
+    i32.set(99);
+    i32.save_sync(false, false);
+    groups[0].p.set(0.9f);
+    groups[0].p.save_sync(false, false);
+    EXPECT_EQ(AP_Param_Test::count(), 2);
+
+    // erasing empties the index, and nothing is found afterwards
+    AP_Param::erase_all();
+    EXPECT_TRUE(AP_Param_Test::valid());
+    EXPECT_EQ(AP_Param_Test::count(), 0);
+    EXPECT_FALSE(i32.load());
+    EXPECT_FALSE(groups[0].p.load());
+    EXPECT_FLOAT_EQ(groups[0].p.get(), 0.1f);
+
+    // and saves after the erase are indexed from the start of storage:
+    // the storage header, then one variable header and its value
+    groups[0].p.set(0.9f);
+    groups[0].p.save_sync(false, false);
+    EXPECT_EQ(AP_Param_Test::count(), 1);
+    EXPECT_TRUE(AP_Param_Test::consistent());
+    EXPECT_EQ(AP_Param::storage_used(), 4 + 4 + sizeof(float));
+}
+
+TEST(ParamStorageIndex, SaveReload)
+{
+    reset_storage();
+
+    i32.set(5);
+    i32.save_sync(false, false);
+    groups[1].enable.set(1);
+    groups[1].enable.save_sync(false, false);
+    groups[0].rate.set(25);
+    groups[0].rate.save_sync(false, false);
+
+    // a reload rebuilds the same index and restores the values
+    i32.set(0);
+    groups[1].enable.set(0);
+    groups[0].rate.set(0);
+    EXPECT_TRUE(AP_Param::load_all());
+    EXPECT_TRUE(AP_Param_Test::valid());
+    EXPECT_EQ(AP_Param_Test::count(), 3);
+    EXPECT_TRUE(AP_Param_Test::consistent());
+    EXPECT_EQ(i32.get(), 5);
+    EXPECT_EQ(groups[1].enable.get(), 1);
+    EXPECT_EQ(groups[0].rate.get(), 25);
+
+    // storage changed without the index knowing; the next lookup that
+    // hits the stale entry drops the index and gives the answer a walk
+    // of storage gives
+    AP_Param_Test::clobber_first_header();
+    EXPECT_FALSE(i32.load());
+    EXPECT_FALSE(AP_Param_Test::valid());
+    EXPECT_EQ(AP_Param_Test::count(), 0);
+    EXPECT_TRUE(groups[0].rate.load());
+    EXPECT_EQ(groups[0].rate.get(), 25);
+
+    // saves work without the index, and don't bring it back
+    groups[1].p.set(0.3f);
+    groups[1].p.save_sync(false, false);
+    EXPECT_FALSE(AP_Param_Test::valid());
+
+    // the next reload indexes storage as it now is
+    EXPECT_TRUE(AP_Param::load_all());
+    EXPECT_TRUE(AP_Param_Test::valid());
+    EXPECT_EQ(AP_Param_Test::count(), 4);
+    EXPECT_TRUE(AP_Param_Test::consistent());
+    EXPECT_FALSE(i32.load());
+    EXPECT_TRUE(groups[1].p.load());
+    EXPECT_FLOAT_EQ(groups[1].p.get(), 0.3f);
+}
+
+#endif  // AP_PARAM_STORAGE_INDEX_ENABLED
+
+AP_GTEST_MAIN()
@@ -127,6 +127,14 @@ const AP_Param::GroupInfo AP_Proximity::var_info[] = {
     AP_SUBGROUPVARPTR(drivers[4], "5_",  31, AP_Proximity, backend_var_info[4]),
 #endif
 
+    // @Param: _SECTORS
+    // @DisplayName: Proximity boundary sectors
+    // @Description: Number of horizontal sectors the proximity boundary is split into. More sectors keep more of a high resolution sensor's detail, allowing the vehicle to pass closer to obstacles, but use more memory and CPU. The number of sectors is limited to 8 on boards with less than 1MB of flash
+    // @Range: 8 36
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("_SECTORS", 32, AP_Proximity, _num_sectors, PROXIMITY_NUM_SECTORS_DEFAULT),
+
     AP_GROUPEND
 };
 
@@ -152,6 +160,11 @@ void AP_Proximity::init()
         return;
     }
 
+    // allocate boundary.  failure is reported by the pre-arm checks
+    if (boundary.get_num_sectors() == 0) {
+        IGNORE_RETURN(boundary.init(_num_sectors));
+    }
+
     // instantiate backends
     uint8_t serial_instance = 0;
     (void)serial_instance;  // in case no serial backends are compiled in
@@ -350,6 +363,10 @@ AP_Proximity_Backend *AP_Proximity::get_backend(uint8_t id) const
 // prearm checks
 bool AP_Proximity::prearm_healthy(char *failure_msg, const uint8_t failure_msg_len) const
 {
+    if ((num_instances > 0) && (boundary.get_num_sectors() == 0)) {
+        hal.util->snprintf(failure_msg, failure_msg_len, "PRX: boundary out of memory");
+        return false;
+    }
     for (uint8_t i=0; i<num_instances; i++) {
         switch (get_instance_status(i)) {
         case Status::NoData:
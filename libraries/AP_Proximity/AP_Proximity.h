@@ -233,6 +233,7 @@ private:
     AP_Int8 _ign_gnd_enable;                    // true if land detection should be enabled
     AP_Float _filt_freq;                        // cutoff frequency for low pass filter
     AP_Float _alt_min_m;                        // Minimum altitude -in meters- below which proximity should not work.
+    AP_Int8 _num_sectors;                       // number of horizontal sectors in the boundary
 
     // get alt from rangefinder in meters. This reading is corrected for vehicle tilt
     bool get_rangefinder_alt(float &alt_m) const;
@@ -42,7 +42,7 @@ public:
 
 private:
     SITL::SIM *sitl = AP::sitl();
-    AP_Proximity_Temp_Boundary temp_boundary;
+    AP_Proximity_Temp_Boundary temp_boundary{frontend.boundary};
 
 };
 
@@ -17,26 +17,84 @@
 
 #define PROXIMITY_BOUNDARY_3D_TIMEOUT_MS 750 // we should check the 3D boundary faces after this many ms
 
-/*
-  Constructor. 
-  This incorporates initialisation as well.
-*/
-AP_Proximity_Boundary_3D::AP_Proximity_Boundary_3D() 
+// allocate the boundary with num_sectors horizontal sectors, each (360 / num_sectors) degrees wide.
+// falls back to PROXIMITY_NUM_SECTORS_DEFAULT if out of memory.  returns false if no boundary could be allocated
+bool AP_Proximity_Boundary_3D::init(uint8_t num_sectors)
+{
+    num_sectors = constrain_int16(num_sectors, PROXIMITY_NUM_SECTORS_MIN, AP_PROXIMITY_BOUNDARY_SECTORS_MAX);
+    if (!alloc(num_sectors) && !alloc(PROXIMITY_NUM_SECTORS_DEFAULT)) {
+        return false;
+    }
+    init_geometry();
+    return true;
+}
+
+// allocate arrays for num_sectors sectors.  returns false if out of memory
+bool AP_Proximity_Boundary_3D::alloc(uint8_t num_sectors)
+{
+    free_arrays();
+
+    const uint16_t num_faces = PROXIMITY_NUM_LAYERS * num_sectors;
+    _sector_edge_vector = NEW_NOTHROW Vector3f[num_faces];
+    _boundary_points = NEW_NOTHROW Vector3f[num_faces];
+    _angle_deg = NEW_NOTHROW float[num_faces];
+    _pitch_deg = NEW_NOTHROW float[num_faces];
+    _distance = NEW_NOTHROW float[num_faces];
+    _filtered_distance = NEW_NOTHROW float[num_faces];
+    _last_update_ms = NEW_NOTHROW uint32_t[num_faces];
+    _prx_instance = NEW_NOTHROW uint8_t[num_faces];
+    _distance_valid = NEW_NOTHROW bool[num_faces];
+    if (_sector_edge_vector == nullptr || _boundary_points == nullptr ||
+        _angle_deg == nullptr || _pitch_deg == nullptr || _distance == nullptr ||
+        _filtered_distance == nullptr || _last_update_ms == nullptr ||
+        _prx_instance == nullptr || _distance_valid == nullptr) {
+        free_arrays();
+        return false;
+    }
+
+    _num_sectors = num_sectors;
+    _num_faces = num_faces;
+    _sector_width_deg = 360.0f / num_sectors;
+    return true;
+}
+
+// free all arrays
+void AP_Proximity_Boundary_3D::free_arrays()
 {
-    // initialise sector edge vector used for building the boundary fence
-    init();
+    // no face may be accessed once the arrays are freed
+    _num_sectors = 0;
+    _num_faces = 0;
+
+    delete[] _sector_edge_vector;
+    _sector_edge_vector = nullptr;
+    delete[] _boundary_points;
+    _boundary_points = nullptr;
+    delete[] _angle_deg;
+    _angle_deg = nullptr;
+    delete[] _pitch_deg;
+    _pitch_deg = nullptr;
+    delete[] _distance;
+    _distance = nullptr;
+    delete[] _filtered_distance;
+    _filtered_distance = nullptr;
+    delete[] _last_update_ms;
+    _last_update_ms = nullptr;
+    delete[] _prx_instance;
+    _prx_instance = nullptr;
+    delete[] _distance_valid;
+    _distance_valid = nullptr;
 }
 
 // initialise the boundary and sector_edge_vector array used for object avoidance
-//   should be called if the sector_middle_deg or _sector_width_deg arrays are changed
-void AP_Proximity_Boundary_3D::init()
+void AP_Proximity_Boundary_3D::init_geometry()
 {
     for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
         const float pitch = ((float)_pitch_middle_deg[layer]);
-        for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            const float angle_rad = ((float)_sector_middle_deg[sector]+(PROXIMITY_SECTOR_WIDTH_DEG/2.0f));
-            _sector_edge_vector[layer][sector].offset_bearing(angle_rad, pitch, 100.0f);
-            _boundary_points[layer][sector] = _sector_edge_vector[layer][sector] * PROXIMITY_BOUNDARY_DIST_DEFAULT;
+        for (uint8_t sector=0; sector < _num_sectors; sector++) {
+            const uint16_t i = face_index(layer, sector);
+            const float angle_deg = get_sector_middle_deg(sector) + (_sector_width_deg * 0.5f);
+            _sector_edge_vector[i].offset_bearing(angle_deg, pitch, 100.0f);
+            _boundary_points[i] = _sector_edge_vector[i] * PROXIMITY_BOUNDARY_DIST_DEFAULT;
         }
     }
 }
@@ -46,7 +104,15 @@ void AP_Proximity_Boundary_3D::init()
 // yaw is the horizontal body-frame angle (in degrees) to the obstacle (0=directly ahead of the vehicle, 90 is to the right of the vehicle)
 AP_Proximity_Boundary_3D::Face AP_Proximity_Boundary_3D::get_face(float pitch, float yaw) const
 {
-    const uint8_t sector = wrap_360(yaw + (PROXIMITY_SECTOR_WIDTH_DEG * 0.5f)) / 45.0f;
+    if (_num_sectors == 0) {
+        // boundary has not been allocated
+        return Face();
+    }
+    uint8_t sector = wrap_360(yaw + (_sector_width_deg * 0.5f)) / _sector_width_deg;
+    if (sector >= _num_sectors) {
+        // rounding may push angles just below 360 into the next sector
+        sector = 0;
+    }
     const float pitch_limited = constrain_float(pitch, -75.0f, 74.9f);
     const uint8_t layer = (pitch_limited + 75.0f)/PROXIMITY_PITCH_WIDTH_DEG;
     return Face{layer, sector};
@@ -59,24 +125,25 @@ AP_Proximity_Boundary_3D::Face AP_Proximity_Boundary_3D::get_face(float pitch, f
 // prx_instance should be set to the proximity sensor backend instance number
 void AP_Proximity_Boundary_3D::set_face_attributes(const Face &face, float pitch, float angle, float distance, uint8_t prx_instance)
 {
-    if (!face.valid()) {
+    if (!face_in_boundary(face)) {
         return;
     }
+    const uint16_t i = face_index(face.layer, face.sector);
 
     // ignore update if another instance has provided a shorter distance within the last 0.2 seconds
-    if ((prx_instance != _prx_instance[face.layer][face.sector]) && _distance_valid[face.layer][face.sector] && (_filtered_distance[face.layer][face.sector].get() < distance)) {
+    if ((prx_instance != _prx_instance[i]) && _distance_valid[i] && (_filtered_distance[i] < distance)) {
         // check if recent
         const uint32_t now_ms = AP_HAL::millis();
-        if (now_ms - _last_update_ms[face.layer][face.sector] < PROXIMITY_FACE_RESET_MS) {
+        if (now_ms - _last_update_ms[i] < PROXIMITY_FACE_RESET_MS) {
             return;
         }
     }
 
-    _angle_deg[face.layer][face.sector] = angle;
-    _pitch_deg[face.layer][face.sector] = pitch;
-    _distance[face.layer][face.sector] = distance;
-    _distance_valid[face.layer][face.sector] = true;
-    _prx_instance[face.layer][face.sector] = prx_instance;
+    _angle_deg[i] = angle;
+    _pitch_deg[i] = pitch;
+    _distance[i] = distance;
+    _distance_valid[i] = true;
+    _prx_instance[i] = prx_instance;
 
     // apply filter
     set_filtered_distance(face, distance);
@@ -85,36 +152,23 @@ void AP_Proximity_Boundary_3D::set_face_attributes(const Face &face, float pitch
     update_boundary(face);
 }
 
-// apply a new cutoff_freq to low-pass filter
-void AP_Proximity_Boundary_3D::apply_filter_freq(float cutoff_freq)
-{
-    for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
-        for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            _filtered_distance[layer][sector].set_cutoff_frequency(cutoff_freq);
-        }
-    }
-}
-
 // Apply low pass filter on the raw distance
 void AP_Proximity_Boundary_3D::set_filtered_distance(const Face &face, float distance)
 {
-    if (!face.valid()) {
+    if (!face_in_boundary(face)) {
         return;
     }
-    if (!is_equal(_filtered_distance[face.layer][face.sector].get_cutoff_freq(), _filter_freq)) {
-        // cutoff freq has changed
-        apply_filter_freq(_filter_freq);
-    }
+    const uint16_t i = face_index(face.layer, face.sector);
 
     const uint32_t now_ms = AP_HAL::millis();
-    const uint32_t dt = now_ms - _last_update_ms[face.layer][face.sector];
-    if (dt < PROXIMITY_FILT_RESET_TIME) {
-        _filtered_distance[face.layer][face.sector].apply(distance, dt* 0.001f);
+    const uint32_t dt = now_ms - _last_update_ms[i];
+    if ((dt < PROXIMITY_FILT_RESET_TIME) && (_last_update_ms[i] != 0)) {
+        _filtered_distance[i] += (distance - _filtered_distance[i]) * calc_lowpass_alpha_dt(dt * 0.001f, _filter_freq);
     } else {
         // reset filter since last distance was passed a long time back
-        _filtered_distance[face.layer][face.sector].reset(distance);
+        _filtered_distance[i] = distance;
     }
-    _last_update_ms[face.layer][face.sector] = now_ms;
+    _last_update_ms[i] = now_ms;
 }
 
 // update boundary points used for object avoidance based on a single sector and pitch distance changing
@@ -123,11 +177,17 @@ void AP_Proximity_Boundary_3D::set_filtered_distance(const Face &face, float dis
 void AP_Proximity_Boundary_3D::update_boundary(const Face &face)
 {
     // sanity check
-    if (!face.valid()) {
+    if (!face_in_boundary(face)) {
         return;
     }
 
-    const uint8_t layer = face.layer;
+    // faces in this layer
+    const uint16_t layer_start = face_index(face.layer, 0);
+    const bool *distance_valid = &_distance_valid[layer_start];
+    const float *filtered_distance = &_filtered_distance[layer_start];
+    const Vector3f *sector_edge_vector = &_sector_edge_vector[layer_start];
+    Vector3f *boundary_points = &_boundary_points[layer_start];
+
     const uint8_t sector = face.sector;
 
     // find adjacent sector (clockwise)
@@ -135,49 +195,47 @@ void AP_Proximity_Boundary_3D::update_boundary(const Face &face)
 
     // boundary point lies on the line between the two sectors at the shorter distance found in the two sectors
     float shortest_distance = PROXIMITY_BOUNDARY_DIST_DEFAULT;
-    if (_distance_valid[layer][sector] && _distance_valid[layer][next_sector]) {
-        shortest_distance = MIN(_filtered_distance[layer][sector].get(), _filtered_distance[layer][next_sector].get());
-    } else if (_distance_valid[layer][sector]) {
-        shortest_distance = _filtered_distance[layer][sector].get();
-    } else if (_distance_valid[layer][next_sector]) {
-        shortest_distance = _filtered_distance[layer][next_sector].get();
+    if (distance_valid[sector] && distance_valid[next_sector]) {
+        shortest_distance = MIN(filtered_distance[sector], filtered_distance[next_sector]);
+    } else if (distance_valid[sector]) {
+        shortest_distance = filtered_distance[sector];
+    } else if (distance_valid[next_sector]) {
+        shortest_distance = filtered_distance[next_sector];
     }
     if (shortest_distance < PROXIMITY_BOUNDARY_DIST_MIN) {
         shortest_distance = PROXIMITY_BOUNDARY_DIST_MIN;
     }
-    _boundary_points[layer][sector] = _sector_edge_vector[layer][sector] * shortest_distance;
+    boundary_points[sector] = sector_edge_vector[sector] * shortest_distance;
 
     // if the next sector (clockwise) has an invalid distance, set boundary to create a cup like boundary
-    if (!_distance_valid[layer][next_sector]) {
-        _boundary_points[layer][next_sector] = _sector_edge_vector[layer][next_sector] * shortest_distance;
+    if (!distance_valid[next_sector]) {
+        boundary_points[next_sector] = sector_edge_vector[next_sector] * shortest_distance;
     }
 
     // repeat for edge between sector and previous sector
     const uint8_t prev_sector = get_prev_sector(sector);
     shortest_distance = PROXIMITY_BOUNDARY_DIST_DEFAULT;
-    if (_distance_valid[layer][prev_sector] && _distance_valid[layer][sector]) {
-        shortest_distance = MIN(_filtered_distance[layer][prev_sector].get(), _filtered_distance[layer][sector].get());
-    } else if (_distance_valid[layer][prev_sector]) {
-        shortest_distance = _filtered_distance[layer][prev_sector].get();
-    } else if (_distance_valid[layer][sector]) {
-        shortest_distance = _filtered_distance[layer][sector].get();
+    if (distance_valid[prev_sector] && distance_valid[sector]) {
+        shortest_distance = MIN(filtered_distance[prev_sector], filtered_distance[sector]);
+    } else if (distance_valid[prev_sector]) {
+        shortest_distance = filtered_distance[prev_sector];
+    } else if (distance_valid[sector]) {
+        shortest_distance = filtered_distance[sector];
     }
-    _boundary_points[layer][prev_sector] = _sector_edge_vector[layer][prev_sector] * shortest_distance;
+    boundary_points[prev_sector] = sector_edge_vector[prev_sector] * shortest_distance;
 
     // if the sector counter-clockwise from the previous sector has an invalid distance, set boundary to create a cup-like boundary
     const uint8_t prev_sector_ccw = get_prev_sector(prev_sector);
-    if (!_distance_valid[layer][prev_sector_ccw]) {
-        _boundary_points[layer][prev_sector_ccw] = _sector_edge_vector[layer][prev_sector_ccw] * shortest_distance;
+    if (!distance_valid[prev_sector_ccw]) {
+        boundary_points[prev_sector_ccw] = sector_edge_vector[prev_sector_ccw] * shortest_distance;
     }
 }
 
 // reset boundary.  marks all distances as invalid
 void AP_Proximity_Boundary_3D::reset()
 {
-    for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
-        for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            _distance_valid[layer][sector] = false;
-        }
+    for (uint16_t i=0; i < _num_faces; i++) {
+        _distance_valid[i] = false;
     }
 }
 
@@ -186,24 +244,25 @@ void AP_Proximity_Boundary_3D::reset()
 // prx_instance should be set to the proximity sensor's backend instance number
 void AP_Proximity_Boundary_3D::reset_face(const Face &face, uint8_t prx_instance)
 {
-    if (!face.valid()) {
+    if (!face_in_boundary(face)) {
         return;
     }
+    const uint16_t i = face_index(face.layer, face.sector);
 
     // return immediately if face already has no valid distance
-    if (!_distance_valid[face.layer][face.sector]) {
+    if (!_distance_valid[i]) {
         return;
     }
 
     // ignore reset if another instance provided this face's distance within the last 0.2 seconds
-    if (prx_instance != _prx_instance[face.layer][face.sector]) {
+    if (prx_instance != _prx_instance[i]) {
         const uint32_t now_ms = AP_HAL::millis();
-        if (now_ms - _last_update_ms[face.layer][face.sector] < 200) {
+        if (now_ms - _last_update_ms[i] < 200) {
             return;
         }
     }
 
-    _distance_valid[face.layer][face.sector] = false;
+    _distance_valid[i] = false;
 
     // update simple avoidance boundary
     update_boundary(face);
@@ -220,11 +279,12 @@ void AP_Proximity_Boundary_3D::check_face_timeout()
     _last_check_face_timeout_ms = now_ms;
 
     for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
-        for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            if (_distance_valid[layer][sector]) {
-                if ((now_ms - _last_update_ms[layer][sector]) > PROXIMITY_FACE_RESET_MS) {
+        for (uint8_t sector=0; sector < _num_sectors; sector++) {
+            const uint16_t i = face_index(layer, sector);
+            if (_distance_valid[i]) {
+                if ((now_ms - _last_update_ms[i]) > PROXIMITY_FACE_RESET_MS) {
                     // this face has a valid distance but wasn't updated for a long time, reset it
-                    _distance_valid[layer][sector] = false;
+                    _distance_valid[i] = false;
                     update_boundary(AP_Proximity_Boundary_3D::Face{layer, sector});
                 }
             }
@@ -235,11 +295,12 @@ void AP_Proximity_Boundary_3D::check_face_timeout()
 // get distance for a face.  returns true on success and fills in distance argument with distance in meters
 bool AP_Proximity_Boundary_3D::get_distance(const Face &face, float &distance) const
 {
-    if (!face.valid()) {
+    if (!face_in_boundary(face)) {
         return false;
     }
-    if (_distance_valid[face.layer][face.sector]) {
-        distance = _distance[face.layer][face.sector];
+    const uint16_t i = face_index(face.layer, face.sector);
+    if (_distance_valid[i]) {
+        distance = _distance[i];
         return true;
     }
 
@@ -249,7 +310,7 @@ bool AP_Proximity_Boundary_3D::get_distance(const Face &face, float &distance) c
 // get the total number of obstacles 
 uint8_t AP_Proximity_Boundary_3D::get_obstacle_count() const
 {
-    return PROXIMITY_NUM_LAYERS * PROXIMITY_NUM_SECTORS;
+    return _num_faces;
 }
 
 // Converts obstacle_num passed from avoidance library into appropriate face of the boundary
@@ -259,16 +320,21 @@ uint8_t AP_Proximity_Boundary_3D::get_obstacle_count() const
 // The resultant is packed into a Boundary Location object and returned by reference as "face"
 bool AP_Proximity_Boundary_3D::convert_obstacle_num_to_face(uint8_t obstacle_num, Face& face) const
 {
+    if (obstacle_num >= _num_faces) {
+        return false;
+    }
+
     // obstacle num is just "flattened layers, and sectors"
-    const uint8_t layer = obstacle_num / PROXIMITY_NUM_SECTORS;
-    const uint8_t sector = obstacle_num % PROXIMITY_NUM_SECTORS;
+    const uint8_t layer = obstacle_num / _num_sectors;
+    const uint8_t sector = obstacle_num % _num_sectors;
     face.sector = sector;
     face.layer = layer;
 
+    const bool *distance_valid = &_distance_valid[face_index(layer, 0)];
     uint8_t valid_sector = sector;
     // check for 3 adjacent sectors
     for (uint8_t i=0; i < 3; i++) {
-        if (_distance_valid[layer][valid_sector]) {
+        if (distance_valid[valid_sector]) {
             // update boundary has manipulated this face
             return true;
         }
@@ -294,8 +360,8 @@ bool AP_Proximity_Boundary_3D::get_obstacle(uint8_t obstacle_num, Vector3f& vec_
     const uint8_t sector_end = face.sector;
     const uint8_t sector_start = get_next_sector(face.sector);
     
-    const Vector3f start = _boundary_points[face.layer][sector_start];
-    const Vector3f end = _boundary_points[face.layer][sector_end];
+    const Vector3f &start = _boundary_points[face_index(face.layer, sector_start)];
+    const Vector3f &end = _boundary_points[face_index(face.layer, sector_end)];
     vec_to_obstacle = Vector3f::point_on_line_closest_to_other_point(start, end, Vector3f{});
     return true;
 }
@@ -318,8 +384,8 @@ bool AP_Proximity_Boundary_3D::closest_point_from_segment_to_obstacle(uint8_t ob
 
     const uint8_t sector_end = face.sector;
     const uint8_t sector_start = get_next_sector(face.sector);
-    const Vector3f start = _boundary_points[face.layer][sector_start];
-    const Vector3f end = _boundary_points[face.layer][sector_end];
+    const Vector3f &start = _boundary_points[face_index(face.layer, sector_start)];
+    const Vector3f &end = _boundary_points[face_index(face.layer, sector_end)];
 
     // closest point between passed line segment and boundary
     Vector3f::segment_to_segment_closest_point(seg_start, seg_end, start, end, closest_point);
@@ -336,27 +402,23 @@ bool AP_Proximity_Boundary_3D::closest_point_from_segment_to_obstacle(uint8_t ob
 bool AP_Proximity_Boundary_3D::get_closest_object(float& angle_deg, float &distance) const
 {
     bool closest_found = false;
-    uint8_t closest_sector = 0;
-    uint8_t closest_layer = 0;
+    uint16_t closest_face = 0;
 
     // check boundary for shortest distance
     // only check for middle layers and higher
     // lower layers might contain ground, which will give false pre-arm failure
-    for (uint8_t layer=PROXIMITY_MIDDLE_LAYER; layer<PROXIMITY_NUM_LAYERS; layer++) {
-        for (uint8_t sector=0; sector<PROXIMITY_NUM_SECTORS; sector++) {
-            if (_distance_valid[layer][sector]) {
-                if (!closest_found || (_distance[layer][sector] < _distance[closest_layer][closest_sector])) {
-                    closest_layer = layer;
-                    closest_sector = sector;
-                    closest_found = true;
-                }
+    for (uint16_t i=face_index(PROXIMITY_MIDDLE_LAYER, 0); i<_num_faces; i++) {
+        if (_distance_valid[i]) {
+            if (!closest_found || (_distance[i] < _distance[closest_face])) {
+                closest_face = i;
+                closest_found = true;
             }
         }
     }
 
     if (closest_found) {
-        angle_deg = _angle_deg[closest_layer][closest_sector];
-        distance = _distance[closest_layer][closest_sector];
+        angle_deg = _angle_deg[closest_face];
+        distance = _distance[closest_face];
     }
     return closest_found;
 }
@@ -364,16 +426,20 @@ bool AP_Proximity_Boundary_3D::get_closest_object(float& angle_deg, float &dista
 // get number of objects, used for non-GPS avoidance
 uint8_t AP_Proximity_Boundary_3D::get_horizontal_object_count() const
 {
-    return PROXIMITY_NUM_SECTORS;
+    return _num_sectors;
 }
 
 // get an object's angle and distance, used for non-GPS avoidance
 // returns false if no angle or distance could be returned for some reason
 bool AP_Proximity_Boundary_3D::get_horizontal_object_angle_and_distance(uint8_t object_number, float &angle_deg, float &distance) const
 {
-    if ((object_number < PROXIMITY_NUM_SECTORS) && _distance_valid[PROXIMITY_MIDDLE_LAYER][object_number]) {
-        angle_deg = _angle_deg[PROXIMITY_MIDDLE_LAYER][object_number];
-        distance = _filtered_distance[PROXIMITY_MIDDLE_LAYER][object_number].get();
+    if (object_number >= _num_sectors) {
+        return false;
+    }
+    const uint16_t i = face_index(PROXIMITY_MIDDLE_LAYER, object_number);
+    if (_distance_valid[i]) {
+        angle_deg = _angle_deg[i];
+        distance = _filtered_distance[i];
         return true;
     }
     return false;
@@ -384,12 +450,13 @@ bool AP_Proximity_Boundary_3D::get_horizontal_object_angle_and_distance(uint8_t
 bool AP_Proximity_Boundary_3D::get_obstacle_info(uint8_t obstacle_num, float &angle_deg, float &pitch_deg, float &distance) const
 {
     // obstacle num is just "flattened layers, and sectors"
-    const uint8_t layer = obstacle_num / PROXIMITY_NUM_SECTORS;
-    const uint8_t sector = obstacle_num % PROXIMITY_NUM_SECTORS;
-    if (_distance_valid[layer][sector]) {
-        angle_deg = _angle_deg[layer][sector];
-        pitch_deg = _pitch_deg[layer][sector];
-        distance = _filtered_distance[layer][sector].get();
+    if (obstacle_num >= _num_faces) {
+        return false;
+    }
+    if (_distance_valid[obstacle_num]) {
+        angle_deg = _angle_deg[obstacle_num];
+        pitch_deg = _pitch_deg[obstacle_num];
+        distance = _filtered_distance[obstacle_num];
         return true;
     }
 
@@ -399,53 +466,73 @@ bool AP_Proximity_Boundary_3D::get_obstacle_info(uint8_t obstacle_num, float &an
 // Return filtered distance for the passed in face
 bool AP_Proximity_Boundary_3D::get_filtered_distance(const Face &face, float &distance) const
 {
-    if (!face.valid()) {
+    if (!face_in_boundary(face)) {
         return false;
     }
+    const uint16_t i = face_index(face.layer, face.sector);
 
-    if (!_distance_valid[face.layer][face.sector]) {
+    if (!_distance_valid[i]) {
         // invalid distace
         return false;
     }
 
-    distance = _filtered_distance[face.layer][face.sector].get();
+    distance = _filtered_distance[i];
     return true;
 }
 
 // Get raw and filtered distances in 8 directions per layer
+// each direction holds the shortest distances of the sectors whose middle is within 22.5 degrees of it
 bool AP_Proximity_Boundary_3D::get_layer_distances(uint8_t layer_number, float dist_max, Proximity_Distance_Array &prx_dist_array, Proximity_Distance_Array &prx_filt_dist_array) const
 {
     // cycle through all sectors filling in distances and orientations
     // see MAV_SENSOR_ORIENTATION for orientations (0 = forward, 1 = 45 degree clockwise from north, etc)
-    bool valid_distances = false;
     prx_dist_array.offset_valid = 0;
     prx_filt_dist_array.offset_valid = 0;
+    if (layer_number >= PROXIMITY_NUM_LAYERS) {
+        return false;
+    }
     for (uint8_t i=0; i<PROXIMITY_MAX_DIRECTION; i++) {
         prx_dist_array.orientation[i] = i;
-        const AP_Proximity_Boundary_3D::Face face(layer_number, i);
-        if (!face.valid()) {
-            return false;
+        prx_dist_array.distance[i] = dist_max;
+        prx_filt_dist_array.distance[i] = dist_max;
+    }
+
+    bool valid_distances = false;
+    for (uint8_t sector=0; sector<_num_sectors; sector++) {
+        const AP_Proximity_Boundary_3D::Face face(layer_number, sector);
+        float distance, filt_distance;
+        if (!get_distance(face, distance) || !get_filtered_distance(face, filt_distance)) {
+            continue;
+        }
+        const uint8_t dir = uint8_t(wrap_360(get_sector_middle_deg(sector) + 22.5f) / 45.0f) % PROXIMITY_MAX_DIRECTION;
+        const uint8_t dir_mask = (1U << dir);
+        if (!(prx_dist_array.offset_valid & dir_mask) || (distance < prx_dist_array.distance[dir])) {
+            prx_dist_array.distance[dir] = distance;
         }
-        if (get_distance(face, prx_dist_array.distance[i]) && get_filtered_distance(face, prx_filt_dist_array.distance[i])) {
-            valid_distances = true;
-            prx_dist_array.offset_valid |= (1U << i);
-            prx_filt_dist_array.offset_valid |= (1U << i);
-        } else {
-            prx_dist_array.distance[i] = dist_max;
-            prx_filt_dist_array.distance[i] = dist_max;
+        if (!(prx_filt_dist_array.offset_valid & dir_mask) || (filt_distance < prx_filt_dist_array.distance[dir])) {
+            prx_filt_dist_array.distance[dir] = filt_distance;
         }
+        prx_dist_array.offset_valid |= dir_mask;
+        prx_filt_dist_array.offset_valid |= dir_mask;
+        valid_distances = true;
     }
 
     return valid_distances;
 }
 
+// constructor. Allocates the same number of sectors as boundary, which must already be initialised
+AP_Proximity_Temp_Boundary::AP_Proximity_Temp_Boundary(const AP_Proximity_Boundary_3D &boundary)
+{
+    _faces = NEW_NOTHROW TempFace[PROXIMITY_NUM_LAYERS * boundary.get_num_sectors()];
+    _num_sectors = (_faces != nullptr) ? boundary.get_num_sectors() : 0;
+    reset();
+}
+
 // reset the temporary boundary. This fills in distances with FLT_MAX
 void AP_Proximity_Temp_Boundary::reset()
 {
-    for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
-        for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            _distances[layer][sector] = FLT_MAX;
-        }
+    for (uint16_t i=0; i < PROXIMITY_NUM_LAYERS * _num_sectors; i++) {
+        _faces[i].distance = FLT_MAX;
     }
 }
 
@@ -453,10 +540,14 @@ void AP_Proximity_Temp_Boundary::reset()
 // pitch and yaw are in degrees, distance is in meters
 void AP_Proximity_Temp_Boundary::add_distance(const AP_Proximity_Boundary_3D::Face &face, float pitch_deg, float yaw_deg, float distance_m)
 {
-    if (face.valid() && distance_m < _distances[face.layer][face.sector]) {
-        _distances[face.layer][face.sector] = distance_m;
-        _angle_deg[face.layer][face.sector] = yaw_deg;
-        _pitch_deg[face.layer][face.sector] = pitch_deg;
+    if (!face.valid() || (face.sector >= _num_sectors)) {
+        return;
+    }
+    TempFace &temp_face = _faces[face_index(face.layer, face.sector)];
+    if (distance_m < temp_face.distance) {
+        temp_face.distance = distance_m;
+        temp_face.angle_deg = yaw_deg;
+        temp_face.pitch_deg = pitch_deg;
     }
 }
 
@@ -464,11 +555,13 @@ void AP_Proximity_Temp_Boundary::add_distance(const AP_Proximity_Boundary_3D::Fa
 // prx_instance should be set to the proximity sensor's backend instance number
 void AP_Proximity_Temp_Boundary::update_3D_boundary(uint8_t prx_instance, AP_Proximity_Boundary_3D &boundary)
 {
+    const uint8_t num_sectors = MIN(_num_sectors, boundary.get_num_sectors());
     for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
-        for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            if (_distances[layer][sector] < FLT_MAX) {
+        for (uint8_t sector=0; sector < num_sectors; sector++) {
+            const TempFace &temp_face = _faces[face_index(layer, sector)];
+            if (temp_face.distance < FLT_MAX) {
                 AP_Proximity_Boundary_3D::Face face{layer, sector};
-                boundary.set_face_attributes(face, _pitch_deg[layer][sector], _angle_deg[layer][sector], _distances[layer][sector], prx_instance);
+                boundary.set_face_attributes(face, temp_face.pitch_deg, temp_face.angle_deg, temp_face.distance, prx_instance);
             }
         }
     }
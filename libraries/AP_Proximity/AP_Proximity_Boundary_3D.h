@@ -15,15 +15,15 @@
 
 #pragma once
 
+#include "AP_Proximity_config.h"
 #include <AP_Common/AP_Common.h>
 #include <AP_Math/AP_Math.h>
-#include <Filter/LowPassFilter.h>
 
-#define PROXIMITY_NUM_SECTORS         8       // number of sectors
+#define PROXIMITY_NUM_SECTORS_DEFAULT 8       // default number of sectors
+#define PROXIMITY_NUM_SECTORS_MIN     8       // minimum number of sectors, one for each direction sent to the ground station
 #define PROXIMITY_NUM_LAYERS          5       // num of layers in a sector
 #define PROXIMITY_MIDDLE_LAYER        2       // middle layer
 #define PROXIMITY_PITCH_WIDTH_DEG     30      // width between each layer in degrees
-#define PROXIMITY_SECTOR_WIDTH_DEG    (360.0f/PROXIMITY_NUM_SECTORS)   // width of sectors in degrees
 #define PROXIMITY_BOUNDARY_DIST_MIN   0.6f    // minimum distance for a boundary point.  This ensures the object avoidance code doesn't think we are outside the boundary.
 #define PROXIMITY_BOUNDARY_DIST_DEFAULT 100   // if we have no data for a sector, boundary is placed 100m out
 #define PROXIMITY_FILT_RESET_TIME     1000    // reset filter if last distance was pushed more than this many ms away
@@ -42,11 +42,21 @@ struct Proximity_Distance_Array {
     uint8_t offset_valid; // bitmask
 };
 
+static_assert(AP_PROXIMITY_BOUNDARY_SECTORS_MAX >= PROXIMITY_NUM_SECTORS_MIN, "AP_PROXIMITY_BOUNDARY_SECTORS_MAX too small");
+static_assert(AP_PROXIMITY_BOUNDARY_SECTORS_MAX * PROXIMITY_NUM_LAYERS <= UINT8_MAX, "too many faces for obstacle numbers");
+
 class AP_Proximity_Boundary_3D
 {
 public:
-    // constructor. This incorporates initialisation as well.
-	AP_Proximity_Boundary_3D();
+    AP_Proximity_Boundary_3D() {}
+    ~AP_Proximity_Boundary_3D() { free_arrays(); }
+
+    CLASS_NO_COPY(AP_Proximity_Boundary_3D);
+
+    // allocate the boundary with num_sectors horizontal sectors, each (360 / num_sectors) degrees wide.
+    // num_sectors is constrained to between PROXIMITY_NUM_SECTORS_MIN and AP_PROXIMITY_BOUNDARY_SECTORS_MAX.
+    // falls back to PROXIMITY_NUM_SECTORS_DEFAULT if out of memory.  returns false if no boundary could be allocated
+    bool init(uint8_t num_sectors);
 
     // stores the layer and sector as a single object to access and modify the 3-D boundary
     // Objects of this class are used temporarily to modify the boundary, i,e they are not persistant or stored anywhere
@@ -58,20 +68,21 @@ public:
 	    Face() { layer = sector = UINT8_MAX; }
 	    Face(uint8_t _layer, uint8_t _sector) { layer = _layer; sector = _sector; }
 
-	    // return true if face has valid layer and sector values
-	    bool valid() const { return ((layer < PROXIMITY_NUM_LAYERS) && (sector < PROXIMITY_NUM_SECTORS)); }
+	    // return true if face has valid layer and sector values for the largest possible boundary
+	    bool valid() const { return ((layer < PROXIMITY_NUM_LAYERS) && (sector < AP_PROXIMITY_BOUNDARY_SECTORS_MAX)); }
 
 	    // comparison operator
 	    bool operator ==(const Face &other) const { return ((layer == other.layer) && (sector == other.sector)); }
 	    bool operator !=(const Face &other) const { return ((layer != other.layer) || (sector != other.sector)); }
 
         uint8_t layer;  // vertical "steps" on the 3D Boundary. 0th layer is the bottom most layer, 1st layer is 30 degrees above (in body frame) and so on
-        uint8_t sector; // horizontal "steps" on the 3D Boundary. 0th sector is directly in front of the vehicle. Each sector is 45 degrees wide.
+        uint8_t sector; // horizontal "steps" on the 3D Boundary. 0th sector is directly in front of the vehicle. Each sector is 45 degrees wide by default.
     };
 
     // returns face corresponding to the provided yaw and (optionally) pitch
     // pitch is the vertical body-frame angle (in degrees) to the obstacle (0=directly ahead, 90 is above the vehicle?)
     // yaw is the horizontal body-frame angle (in degrees) to the obstacle (0=directly ahead of the vehicle, 90 is to the right of the vehicle)
+    // returns an invalid face if the boundary has not been allocated
     Face get_face(float pitch, float yaw) const;
     Face get_face(float yaw) const { return get_face(0, yaw); }
 
@@ -127,29 +138,44 @@ public:
     // get number of layers
     uint8_t get_num_layers() const { return PROXIMITY_NUM_LAYERS; }
 
+    // get number of sectors in each layer
+    uint8_t get_num_sectors() const { return _num_sectors; }
+
+    // get middle yaw angle of a sector in degrees
+    float get_sector_middle_deg(uint8_t sector) const { return sector * _sector_width_deg; }
+
     // get raw and filtered distances in 8 directions per layer.
     bool get_layer_distances(uint8_t layer_number, float dist_max, Proximity_Distance_Array &prx_dist_array, Proximity_Distance_Array &prx_filt_dist_array) const;
 
     // pass down filter cut-off freq from params
     void set_filter_freq(float filt_freq) { _filter_freq = filt_freq; }
 
-    // sectors
-    static_assert(PROXIMITY_NUM_SECTORS == 8, "PROXIMITY_NUM_SECTOR must be 8");
-    const uint16_t _sector_middle_deg[PROXIMITY_NUM_SECTORS] {0, 45, 90, 135, 180, 225, 270, 315};    // middle angle of each sector
     // layers
     static_assert(PROXIMITY_NUM_LAYERS == 5, "PROXIMITY_NUM_LAYERS must be 5");
     const int16_t _pitch_middle_deg[PROXIMITY_NUM_LAYERS] {-60, -30, 0, 30, 60};
 
 private:
 
+    // allocate arrays for num_sectors sectors.  returns false if out of memory
+    bool alloc(uint8_t num_sectors);
+
+    // free all arrays
+    void free_arrays();
+
     // initialise the boundary and sector_edge_vector array used for object avoidance
-    void init();
+    void init_geometry();
+
+    // face data is stored in arrays of layers, each holding _num_sectors sectors
+    uint16_t face_index(uint8_t layer, uint8_t sector) const { return layer * _num_sectors + sector; }
+
+    // returns true if the face is within this boundary
+    bool face_in_boundary(const Face &face) const { return face.valid() && (face.sector < _num_sectors); }
 
     // get the next sector which is CW to the passed sector
-    uint8_t get_next_sector(uint8_t sector) const {return ((sector >= PROXIMITY_NUM_SECTORS-1) ? 0 : sector+1); }
+    uint8_t get_next_sector(uint8_t sector) const {return ((sector >= _num_sectors-1) ? 0 : sector+1); }
 
     // get the prev sector which is CCW to the passed sector
-    uint8_t get_prev_sector(uint8_t sector) const {return ((sector <= 0) ? PROXIMITY_NUM_SECTORS-1 : sector-1); }
+    uint8_t get_prev_sector(uint8_t sector) const {return ((sector <= 0) ? _num_sectors-1 : sector-1); }
 
     // Converts obstacle_num passed from avoidance library into appropriate face of the boundary
     // Returns false if the face is invalid
@@ -158,25 +184,27 @@ private:
     // The resultant is packed into a Boundary Location object and returned by reference as "face"
     bool convert_obstacle_num_to_face(uint8_t obstacle_num, Face& face) const WARN_IF_UNUSED;
 
-    // Apply a new cutoff_freq to low-pass filter
-    void apply_filter_freq(float cutoff_freq);
-
     // Apply low pass filter on the raw distance
     void set_filtered_distance(const Face &face, float distance);
 
     // Return filtered distance for the passed in face
     bool get_filtered_distance(const Face &face, float &distance) const;
 
-    Vector3f _sector_edge_vector[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];
-    Vector3f _boundary_points[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];
+    uint8_t _num_sectors;               // number of sectors in each layer
+    uint8_t _num_faces;                 // number of faces in all layers
+    float _sector_width_deg;            // width of each sector in degrees
+
+    // arrays of _num_faces elements, indexed by face_index()
+    Vector3f *_sector_edge_vector = nullptr; // unit vector (scaled to cm) along the CW edge of each face
+    Vector3f *_boundary_points = nullptr;   // boundary point on the CW edge of each face
+    float *_angle_deg = nullptr;            // yaw angle in degrees to closest object within each sector and layer
+    float *_pitch_deg = nullptr;            // pitch angle in degrees to the closest object within each sector and layer
+    float *_distance = nullptr;             // distance to closest object within each sector and layer
+    float *_filtered_distance = nullptr;    // low pass filtered distance within each sector and layer
+    uint32_t *_last_update_ms = nullptr;    // time when distance was last updated
+    uint8_t *_prx_instance = nullptr;       // proximity sensor backend instance that provided the distance
+    bool *_distance_valid = nullptr;        // true if a valid distance received for each sector and layer
 
-    float _angle_deg[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];          // yaw angle in degrees to closest object within each sector and layer
-    float _pitch_deg[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];          // pitch angle in degrees to the closest object within each sector and layer
-    float _distance[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];       // distance to closest object within each sector and layer
-    bool _distance_valid[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];  // true if a valid distance received for each sector and layer
-    uint32_t _last_update_ms[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS]; // time when distance was last updated
-    uint8_t _prx_instance[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS]; // proximity sensor backend instance that provided the distance
-    LowPassFilterFloat _filtered_distance[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS]; // low pass filter
     float _filter_freq;                                                 // cutoff freq of low pass filter
     uint32_t _last_check_face_timeout_ms;                               // system time to throttle check_face_timeout method
 };
@@ -187,8 +215,11 @@ private:
 class AP_Proximity_Temp_Boundary
 {
 public:
-    // constructor. This incorporates initialisation as well.
-	AP_Proximity_Temp_Boundary() { reset(); }
+    // constructor. Allocates the same number of sectors as boundary, which must already be initialised
+    AP_Proximity_Temp_Boundary(const AP_Proximity_Boundary_3D &boundary);
+    ~AP_Proximity_Temp_Boundary() { delete[] _faces; }
+
+    CLASS_NO_COPY(AP_Proximity_Temp_Boundary);
 
     // reset the temporary boundary. This fills in distances with FLT_MAX
     void reset();
@@ -204,7 +235,16 @@ public:
 
 private:
 
-    float _distances[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];  // distance to closest object within each sector and layer. Will start with FLT_MAX, and then be changed to a valid distance if needed
-    float _angle_deg[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];  // yaw angle in degrees to closest object within each sector and layer
-    float _pitch_deg[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];      // pitch angle in degrees to the closest object within each sector and layer
+    // closest object within a sector and layer
+    struct TempFace {
+        float distance;     // distance in meters. Will start with FLT_MAX, and then be changed to a valid distance if needed
+        float angle_deg;    // yaw angle in degrees
+        float pitch_deg;    // pitch angle in degrees
+    };
+
+    // faces are stored in arrays of layers, each holding _num_sectors sectors
+    uint16_t face_index(uint8_t layer, uint8_t sector) const { return layer * _num_sectors + sector; }
+
+    uint8_t _num_sectors;           // number of sectors in each layer, zero if out of memory
+    TempFace *_faces;               // array of PROXIMITY_NUM_LAYERS * _num_sectors faces
 };
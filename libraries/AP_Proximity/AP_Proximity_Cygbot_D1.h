@@ -77,7 +77,7 @@ private:
     uint32_t _last_init_ms;                 // system time of last sensor init
     uint32_t _last_distance_received_ms;    // system time of last distance measurement received from sensor
 
-    AP_Proximity_Temp_Boundary _temp_boundary; // temporary boundary to store incoming payload
+    AP_Proximity_Temp_Boundary _temp_boundary{frontend.boundary}; // temporary boundary to store incoming payload
 
 };
 
@@ -35,7 +35,7 @@ private:
     // handle mavlink OBSTACLE_DISTANCE_3D messages
     void handle_obstacle_distance_3d_msg(const mavlink_message_t &msg);
 
-   AP_Proximity_Temp_Boundary temp_boundary;
+   AP_Proximity_Temp_Boundary temp_boundary{frontend.boundary};
 
     // horizontal distance support
     uint32_t _last_update_ms;   // system time of last mavlink message received
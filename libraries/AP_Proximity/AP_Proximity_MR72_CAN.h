@@ -33,7 +33,7 @@ public:
 
     static const struct AP_Param::GroupInfo var_info[];
 
-    AP_Proximity_Temp_Boundary _temp_boundary;
+    AP_Proximity_Temp_Boundary _temp_boundary{frontend.boundary};
 
 private:
 
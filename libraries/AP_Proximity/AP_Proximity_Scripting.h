@@ -34,7 +34,7 @@ public:
 private:
 
     // temp boundary to store and sort distances
-    AP_Proximity_Temp_Boundary temp_boundary;
+    AP_Proximity_Temp_Boundary temp_boundary{frontend.boundary};
 
     // horizontal distance support
     uint32_t _last_update_ms;   // system time of last script message received
@@ -81,3 +81,12 @@
 #ifndef AP_PROXIMITY_MR72_DRIVER_ENABLED
 #define AP_PROXIMITY_MR72_DRIVER_ENABLED (AP_PROXIMITY_MR72_ENABLED  || AP_PROXIMITY_HEXSOONRADAR_ENABLED)
 #endif  // AP_PROXIMITY_MR72_DRIVER_ENABLED
+
+// maximum number of horizontal sectors the boundary may be split into (see PRX_SECTORS)
+#ifndef AP_PROXIMITY_BOUNDARY_SECTORS_MAX
+#if HAL_PROGRAM_SIZE_LIMIT_KB > 1024
+#define AP_PROXIMITY_BOUNDARY_SECTORS_MAX 36
+#else
+#define AP_PROXIMITY_BOUNDARY_SECTORS_MAX 8
+#endif
+#endif
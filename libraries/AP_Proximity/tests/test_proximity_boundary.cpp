@@ -0,0 +1,111 @@
+/*
+  check the 3D boundary and temporary boundary at the default and
+  higher resolutions, and before the boundary has been allocated
+ */
+#include <AP_gtest.h>
+
+#include <AP_Proximity/AP_Proximity_Boundary_3D.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+TEST(AP_Proximity_Boundary_3D, NotInitialised)
+{
+    AP_Proximity_Boundary_3D boundary;
+    EXPECT_EQ(boundary.get_num_sectors(), 0);
+    EXPECT_EQ(boundary.get_obstacle_count(), 0);
+
+    // no face is returned, and faces are ignored
+    for (float yaw = 0; yaw < 360; yaw += 10) {
+        EXPECT_FALSE(boundary.get_face(yaw).valid()) << yaw;
+    }
+    const AP_Proximity_Boundary_3D::Face face {PROXIMITY_MIDDLE_LAYER, 0};
+    boundary.set_face_attributes(face, 0, 5, 0);
+    float distance;
+    EXPECT_FALSE(boundary.get_distance(face, distance));
+
+    // a temporary boundary made for it holds nothing
+    AP_Proximity_Temp_Boundary temp_boundary{boundary};
+    temp_boundary.add_distance(face, 0, 5);
+    temp_boundary.update_3D_boundary(0, boundary);
+    EXPECT_FALSE(boundary.get_distance(face, distance));
+}
+
+TEST(AP_Proximity_Boundary_3D, Resolutions)
+{
+    for (uint8_t num_sectors : {8, 12, 16, 24, 36}) {
+        AP_Proximity_Boundary_3D boundary;
+        ASSERT_TRUE(boundary.init(num_sectors));
+        const uint8_t expected_sectors = MIN(num_sectors, AP_PROXIMITY_BOUNDARY_SECTORS_MAX);
+        ASSERT_EQ(boundary.get_num_sectors(), expected_sectors);
+        EXPECT_EQ(boundary.get_obstacle_count(), PROXIMITY_NUM_LAYERS * expected_sectors);
+        const float sector_width_deg = 360.0f / expected_sectors;
+
+        // each yaw falls in the sector centred closest to it
+        for (float yaw = -180; yaw < 540; yaw += 0.5f) {
+            const AP_Proximity_Boundary_3D::Face face = boundary.get_face(yaw);
+            ASSERT_TRUE(face.valid()) << yaw;
+            ASSERT_LT(face.sector, expected_sectors) << yaw;
+            EXPECT_EQ(face.layer, PROXIMITY_MIDDLE_LAYER) << yaw;
+            const float error_deg = fabsf(wrap_180(yaw - boundary.get_sector_middle_deg(face.sector)));
+            EXPECT_LE(error_deg, sector_width_deg * 0.5f + 0.001f) << "sectors " << unsigned(num_sectors) << " yaw " << yaw;
+        }
+        EXPECT_EQ(boundary.get_face(-60, 0).layer, 0);
+        EXPECT_EQ(boundary.get_face(60, 0).layer, PROXIMITY_NUM_LAYERS - 1);
+
+        // the temporary boundary keeps the closest object in each face, including
+        // those past the eighth sector
+        AP_Proximity_Temp_Boundary temp_boundary{boundary};
+        for (uint8_t sector = 0; sector < expected_sectors; sector++) {
+            const float yaw = boundary.get_sector_middle_deg(sector);
+            temp_boundary.add_distance(boundary.get_face(yaw + 1), yaw + 1, 20.0f + sector);
+            temp_boundary.add_distance(boundary.get_face(yaw - 1), yaw - 1, 5.0f + sector * 0.1f);
+            temp_boundary.add_distance(boundary.get_face(yaw), yaw, 10.0f + sector);
+        }
+        // faces outside the boundary are ignored
+        temp_boundary.add_distance(AP_Proximity_Boundary_3D::Face{PROXIMITY_MIDDLE_LAYER, expected_sectors}, 0, 1.0f);
+        temp_boundary.update_3D_boundary(0, boundary);
+
+        for (uint8_t sector = 0; sector < expected_sectors; sector++) {
+            float distance;
+            ASSERT_TRUE(boundary.get_distance(AP_Proximity_Boundary_3D::Face{PROXIMITY_MIDDLE_LAYER, sector}, distance)) << unsigned(sector);
+            EXPECT_FLOAT_EQ(distance, 5.0f + sector * 0.1f) << "sectors " << unsigned(num_sectors) << " sector " << unsigned(sector);
+            EXPECT_FALSE(boundary.get_distance(AP_Proximity_Boundary_3D::Face{0, sector}, distance));
+        }
+
+        // closest object is the one just left of ahead
+        float angle_deg, distance;
+        ASSERT_TRUE(boundary.get_closest_object(angle_deg, distance));
+        EXPECT_FLOAT_EQ(distance, 5.0f);
+        EXPECT_FLOAT_EQ(angle_deg, -1.0f);
+        EXPECT_EQ(boundary.get_horizontal_object_count(), expected_sectors);
+
+        // the ground station is sent the closest distance in each of 8 directions
+        Proximity_Distance_Array dist_array {}, filt_dist_array {};
+        ASSERT_TRUE(boundary.get_layer_distances(PROXIMITY_MIDDLE_LAYER, 100.0f, dist_array, filt_dist_array));
+        for (uint8_t dir = 0; dir < PROXIMITY_MAX_DIRECTION; dir++) {
+            ASSERT_TRUE(dist_array.valid(dir)) << unsigned(dir);
+            float expected = FLT_MAX;
+            for (uint8_t sector = 0; sector < expected_sectors; sector++) {
+                // sectors centred on a direction's clockwise edge belong to the next direction
+                const uint8_t sector_dir = uint8_t(wrap_360(boundary.get_sector_middle_deg(sector) + 22.5f) / 45.0f) % PROXIMITY_MAX_DIRECTION;
+                if (sector_dir == dir) {
+                    expected = MIN(expected, 5.0f + sector * 0.1f);
+                }
+            }
+            EXPECT_FLOAT_EQ(dist_array.distance[dir], expected) << "sectors " << unsigned(num_sectors) << " direction " << unsigned(dir);
+        }
+
+        // obstacles are no further away than faces without data
+        uint8_t num_obstacles = 0;
+        for (uint8_t i = 0; i < boundary.get_obstacle_count(); i++) {
+            Vector3f vec_to_obstacle;
+            if (boundary.get_obstacle(i, vec_to_obstacle)) {
+                EXPECT_LE(vec_to_obstacle.length(), PROXIMITY_BOUNDARY_DIST_DEFAULT * 100.0f + 1.0f);
+                num_obstacles++;
+            }
+        }
+        EXPECT_GT(num_obstacles, 0);
+    }
+}
+
+AP_GTEST_MAIN()
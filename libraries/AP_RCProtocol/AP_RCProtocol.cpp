@@ -124,6 +124,7 @@ void AP_RCProtocol::init()
 #if AP_RCPROTOCOL_EMLID_RCIO_ENABLED
     backend[AP_RCProtocol::EMLID_RCIO] = NEW_NOTHROW AP_RCProtocol_Emlid_RCIO(*this);
 #endif
+    init_classifier();
 }
 
 AP_RCProtocol::~AP_RCProtocol()
@@ -244,6 +245,19 @@ void AP_RCProtocol::process_pulse_list(const uint32_t *widths, uint16_t n, bool
 
 bool AP_RCProtocol::process_byte(uint8_t byte, uint32_t baudrate)
 {
+    return process_bytes(&byte, 1, baudrate);
+}
+
+/*
+  process a block of bytes, as read from a UART. Once a protocol is
+  detected the whole block goes to its backend in one call
+ */
+bool AP_RCProtocol::process_bytes(const uint8_t *bytes, uint16_t n, uint32_t baudrate)
+{
+    if (n == 0) {
+        return false;
+    }
+
     uint32_t now = AP_HAL::millis();
     bool searching = should_search(now);
 
@@ -263,7 +277,7 @@ bool AP_RCProtocol::process_byte(uint8_t byte, uint32_t baudrate)
 
     // first try current protocol
     if (_detected_protocol != AP_RCProtocol::NONE && !searching) {
-        backend[_detected_protocol]->process_byte(byte, baudrate);
+        backend[_detected_protocol]->process_bytes(bytes, n, baudrate);
         if (backend[_detected_protocol]->new_input()) {
             _new_input = true;
             _last_input_ms = now;
@@ -271,38 +285,132 @@ bool AP_RCProtocol::process_byte(uint8_t byte, uint32_t baudrate)
         return true;
     }
 
-    // otherwise scan all protocols
+    // otherwise scan the protocols which could be in this block
+    const uint32_t candidates = search_candidates(bytes, n, baudrate, now);
+    if (candidates == 0) {
+        return false;
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        if (!search_byte(bytes[i], baudrate, candidates, now)) {
+            continue;
+        }
+        // the rest of the block belongs to the detected protocol
+        if (i+1 < n) {
+            backend[_detected_protocol]->process_bytes(&bytes[i+1], n-(i+1), baudrate);
+            if (backend[_detected_protocol]->new_input()) {
+                _new_input = true;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+bool AP_RCProtocol::search_byte(uint8_t byte, uint32_t baudrate, uint32_t candidates, uint32_t now_ms)
+{
     for (uint8_t i = 0; i < ARRAY_SIZE(backend); i++) {
-        if (backend[i] != nullptr) {
-            if (!protocol_enabled(rcprotocol_t(i))) {
+        if ((candidates & (1U << i)) == 0) {
+            continue;
+        }
+        const uint32_t frame_count = backend[i]->get_rc_frame_count();
+        const uint32_t input_count = backend[i]->get_rc_input_count();
+        backend[i]->process_byte(byte, baudrate);
+        const uint32_t frame_count2 = backend[i]->get_rc_frame_count();
+        if (frame_count2 > frame_count) {
+            if (requires_3_frames((rcprotocol_t)i) && frame_count2 < 3) {
                 continue;
             }
-            const uint32_t frame_count = backend[i]->get_rc_frame_count();
-            const uint32_t input_count = backend[i]->get_rc_input_count();
-            backend[i]->process_byte(byte, baudrate);
-            const uint32_t frame_count2 = backend[i]->get_rc_frame_count();
-            if (frame_count2 > frame_count) {
-                if (requires_3_frames((rcprotocol_t)i) && frame_count2 < 3) {
-                    continue;
-                }
-                _new_input = (input_count != backend[i]->get_rc_input_count());
-                _detected_protocol = (enum AP_RCProtocol::rcprotocol_t)i;
-                _last_input_ms = now;
-                _detected_with_bytes = true;
-                for (uint8_t j = 0; j < ARRAY_SIZE(backend); j++) {
-                    if (backend[j]) {
-                        backend[j]->reset_rc_frame_count();
-                    }
+            _new_input = (input_count != backend[i]->get_rc_input_count());
+            _detected_protocol = (enum AP_RCProtocol::rcprotocol_t)i;
+            _last_input_ms = now_ms;
+            _detected_with_bytes = true;
+            for (uint8_t j = 0; j < ARRAY_SIZE(backend); j++) {
+                if (backend[j]) {
+                    backend[j]->reset_rc_frame_count();
                 }
-                // stop decoding pulses to save CPU
-                hal.rcin->pulse_input_enable(false);
-                return true;
             }
+            // stop decoding pulses to save CPU
+            hal.rcin->pulse_input_enable(false);
+            return true;
         }
     }
     return false;
 }
 
+/*
+  collect the frame start bytes of the byte protocols
+ */
+void AP_RCProtocol::init_classifier(void)
+{
+    classify = {};
+    for (uint8_t i = 0; i < ARRAY_SIZE(backend); i++) {
+        if (backend[i] == nullptr) {
+            continue;
+        }
+        const uint8_t *start;
+        const uint8_t nstart = backend[i]->frame_start_bytes(start);
+        if (nstart == 0 || classify.num_start_bytes + nstart > ARRAY_SIZE(classify.start_bytes)) {
+            // searched with every byte
+            continue;
+        }
+        for (uint8_t j = 0; j < nstart; j++) {
+            const uint8_t b = start[j];
+            classify.start_bits[b >> 3] |= 1U << (b & 7);
+            classify.start_bytes[classify.num_start_bytes].byte = b;
+            classify.start_bytes[classify.num_start_bytes].protocol = i;
+            classify.num_start_bytes++;
+        }
+        classify.start_mask |= 1U << i;
+    }
+}
+
+/*
+  cut down the backends to search with a block of bytes. Backends
+  which can't decode at this baudrate are dropped, as are backends
+  with fixed frame start bytes which haven't seen one recently. The
+  start bytes in the block count, so a backend always sees the start
+  of the frame which made it a candidate
+ */
+uint32_t AP_RCProtocol::search_candidates(const uint8_t *bytes, uint16_t n, uint32_t baudrate, uint32_t now_ms)
+{
+    if (baudrate != classify.baudrate) {
+        classify.baudrate = baudrate;
+        classify.baud_mask = 0;
+        for (uint8_t i = 0; i < ARRAY_SIZE(backend); i++) {
+            if (backend[i] != nullptr && backend[i]->baudrate_supported(baudrate)) {
+                classify.baud_mask |= 1U << i;
+            }
+        }
+    }
+
+    const uint16_t now16 = now_ms;
+    for (uint16_t i = 0; i < n; i++) {
+        const uint8_t b = bytes[i];
+        if ((classify.start_bits[b >> 3] & (1U << (b & 7))) == 0) {
+            continue;
+        }
+        for (uint8_t j = 0; j < classify.num_start_bytes; j++) {
+            if (classify.start_bytes[j].byte == b) {
+                classify.last_start_ms[classify.start_bytes[j].protocol] = now16;
+            }
+        }
+    }
+
+    uint32_t candidates = 0;
+    for (uint8_t i = 0; i < ARRAY_SIZE(backend); i++) {
+        if ((classify.baud_mask & (1U << i)) == 0 ||
+            !protocol_enabled(rcprotocol_t(i))) {
+            continue;
+        }
+        if ((classify.start_mask & (1U << i)) != 0 &&
+            uint16_t(now16 - classify.last_start_ms[i]) > AP_RCPROTOCOL_START_BYTE_TIMEOUT_MS) {
+            continue;
+        }
+        candidates |= 1U << i;
+    }
+    return candidates;
+}
+
 // handshake if nothing else has succeeded so far
 void AP_RCProtocol::process_handshake( uint32_t baudrate)
 {
@@ -355,6 +463,7 @@ static const AP_RCProtocol::SerialConfig serial_configs[] {
 };
 
 static_assert(ARRAY_SIZE(serial_configs) > 0, "must have at least one serial config");
+static_assert(AP_RCProtocol::NONE <= 32, "candidate masks must fit in 32 bits");
 
 void AP_RCProtocol::check_added_uart(void)
 {
@@ -378,13 +487,13 @@ void AP_RCProtocol::check_added_uart(void)
     const uint32_t current_baud = serial_configs[added.config_num].baud;
     process_handshake(current_baud);
 
-    uint32_t n = added.uart->available();
-    n = MIN(n, 255U);
-    for (uint8_t i=0; i<n; i++) {
-        int16_t b = added.uart->read();
-        if (b >= 0) {
-            process_byte(uint8_t(b), current_baud);
+    uint8_t buf[64];
+    for (uint8_t i=0; i<4; i++) {
+        const ssize_t n = added.uart->read(buf, sizeof(buf));
+        if (n <= 0) {
+            break;
         }
+        process_bytes(buf, n, current_baud);
     }
     if (searching) {
         if (now - added.last_config_change_ms > 1000) {
@@ -27,6 +27,17 @@
 #define MAX_RCIN_CHANNELS 18
 #define MIN_RCIN_CHANNELS  5
 
+// maximum number of frame start bytes over all byte protocols
+#ifndef AP_RCPROTOCOL_MAX_START_BYTES
+#define AP_RCPROTOCOL_MAX_START_BYTES 24
+#endif
+
+// a protocol with fixed frame start bytes is only searched while one
+// of its start bytes has been seen within this time
+#ifndef AP_RCPROTOCOL_START_BYTE_TIMEOUT_MS
+#define AP_RCPROTOCOL_START_BYTE_TIMEOUT_MS 100
+#endif
+
 class AP_RCProtocol_Backend;
 
 class AP_RCProtocol {
@@ -120,6 +131,7 @@ public:
     void process_pulse(uint32_t width_s0, uint32_t width_s1);
     void process_pulse_list(const uint32_t *widths, uint16_t n, bool need_swap);
     bool process_byte(uint8_t byte, uint32_t baudrate);
+    bool process_bytes(const uint8_t *bytes, uint16_t n, uint32_t baudrate);
     void process_handshake(uint32_t baudrate);
     void update(void);
 
@@ -280,6 +292,29 @@ private:
     // having them make an "add_input" callback):
     bool detect_async_protocol(rcprotocol_t protocol);
 
+    // feed a byte to the candidate backends while searching, returns
+    // true if a protocol was detected
+    bool search_byte(uint8_t byte, uint32_t baudrate, uint32_t candidates, uint32_t now_ms);
+
+    // pre-classify a block of bytes, returning a mask of the backends
+    // worth searching
+    uint32_t search_candidates(const uint8_t *bytes, uint16_t n, uint32_t baudrate, uint32_t now_ms);
+    void init_classifier(void);
+
+    // pre-classifier state for byte input
+    struct {
+        uint32_t baudrate;       // baudrate baud_mask was built for
+        uint32_t baud_mask;      // backends which can decode at baudrate
+        uint32_t start_mask;     // backends with fixed frame start bytes
+        uint8_t start_bits[32];  // bitmap of all frame start bytes
+        struct {
+            uint8_t byte;
+            uint8_t protocol;
+        } start_bytes[AP_RCPROTOCOL_MAX_START_BYTES];
+        uint8_t num_start_bytes;
+        uint16_t last_start_ms[NONE];
+    } classify;
+
     enum rcprotocol_t _detected_protocol = NONE;
     uint16_t _disabled_for_pulses;
     bool _detected_with_bytes;
@@ -47,6 +47,13 @@ bool AP_RCProtocol_Backend::new_input()
     return ret;
 }
 
+void AP_RCProtocol_Backend::process_bytes(const uint8_t *bytes, uint16_t n, uint32_t baudrate)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        process_byte(bytes[i], baudrate);
+    }
+}
+
 uint8_t AP_RCProtocol_Backend::num_channels() const
 {
     return _num_channels;
@@ -32,12 +32,28 @@ public:
     virtual ~AP_RCProtocol_Backend() {}
     virtual void process_pulse(uint32_t width_s0, uint32_t width_s1) {}
     virtual void process_byte(uint8_t byte, uint32_t baudrate) {}
+    // process a block of bytes, as read from a UART
+    virtual void process_bytes(const uint8_t *bytes, uint16_t n, uint32_t baudrate);
     virtual void process_handshake(uint32_t baudrate) {}
     uint16_t read(uint8_t chan);
     void read(uint16_t *pwm, uint8_t n);
     bool new_input();
     uint8_t num_channels() const;
 
+    /*
+      pre-classification of byte input while searching for a
+      protocol. Return false if bytes at this baudrate can never be
+      decoded by this backend
+     */
+    virtual bool baudrate_supported(uint32_t baudrate) const { return true; }
+
+    /*
+      point bytes at the bytes which can start a frame and return how
+      many there are. Backends without fixed start bytes return 0 and
+      are searched with every byte
+     */
+    virtual uint8_t frame_start_bytes(const uint8_t *&bytes) const { return 0; }
+
     // support for receivers that have FC initiated bind support
     virtual void start_bind() {}
 
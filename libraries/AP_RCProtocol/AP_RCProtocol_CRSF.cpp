@@ -165,12 +165,35 @@ uint16_t AP_RCProtocol_CRSF::get_link_rate(ProtocolType protocol) const {
 void AP_RCProtocol_CRSF::process_byte(uint8_t byte, uint32_t baudrate)
 {
     // reject RC data if we have been configured for standalone mode
-    if ((baudrate != CRSF_BAUDRATE && baudrate != CRSF_BAUDRATE_1MBIT && baudrate != CRSF_BAUDRATE_2MBIT) || _uart) {
+    if (!baudrate_supported(baudrate) || _uart) {
         return;
     }
     _process_byte(byte);
 }
 
+void AP_RCProtocol_CRSF::process_bytes(const uint8_t *bytes, uint16_t n, uint32_t baudrate)
+{
+    // reject RC data if we have been configured for standalone mode
+    if (!baudrate_supported(baudrate) || _uart) {
+        return;
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        _process_byte(bytes[i]);
+    }
+}
+
+bool AP_RCProtocol_CRSF::baudrate_supported(uint32_t baudrate) const
+{
+    return baudrate == CRSF_BAUDRATE || baudrate == CRSF_BAUDRATE_1MBIT || baudrate == CRSF_BAUDRATE_2MBIT;
+}
+
+uint8_t AP_RCProtocol_CRSF::frame_start_bytes(const uint8_t *&bytes) const
+{
+    static const uint8_t start[] { AP_CRSF_Protocol::CRSF_ADDRESS_FLIGHT_CONTROLLER };
+    bytes = start;
+    return ARRAY_SIZE(start);
+}
+
 // process a byte provided by a uart
 void AP_RCProtocol_CRSF::_process_byte(uint8_t byte)
 {
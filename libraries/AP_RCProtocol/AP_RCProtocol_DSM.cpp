@@ -533,10 +533,15 @@ void AP_RCProtocol_DSM::_process_byte(uint32_t timestamp_ms, uint8_t b)
 // support byte input
 void AP_RCProtocol_DSM::process_byte(uint8_t b, uint32_t baudrate)
 {
-    if (baudrate != 115200) {
+    if (!baudrate_supported(baudrate)) {
         return;
     }
     _process_byte(AP_HAL::millis(), b);
 }
 
+bool AP_RCProtocol_DSM::baudrate_supported(uint32_t baudrate) const
+{
+    return baudrate == 115200;
+}
+
 #endif  // AP_RCPROTOCOL_DSM_ENABLED
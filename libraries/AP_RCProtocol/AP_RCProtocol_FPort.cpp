@@ -313,10 +313,22 @@ bool AP_RCProtocol_FPort::check_checksum(void)
 // support byte input
 void AP_RCProtocol_FPort::process_byte(uint8_t b, uint32_t baudrate)
 {
-    if (baudrate != 115200) {
+    if (!baudrate_supported(baudrate)) {
         return;
     }
     _process_byte(AP_HAL::micros(), b);
 }
 
+bool AP_RCProtocol_FPort::baudrate_supported(uint32_t baudrate) const
+{
+    return baudrate == 115200;
+}
+
+uint8_t AP_RCProtocol_FPort::frame_start_bytes(const uint8_t *&bytes) const
+{
+    static const uint8_t start[] { FRAME_HEAD };
+    bytes = start;
+    return ARRAY_SIZE(start);
+}
+
 #endif  // AP_RCPROTOCOL_FPORT_ENABLED
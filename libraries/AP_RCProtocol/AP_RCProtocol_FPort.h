@@ -34,6 +34,8 @@ public:
     AP_RCProtocol_FPort(AP_RCProtocol &_frontend, bool inverted);
     void process_pulse(uint32_t width_s0, uint32_t width_s1) override;
     void process_byte(uint8_t byte, uint32_t baudrate) override;
+    bool baudrate_supported(uint32_t baudrate) const override;
+    uint8_t frame_start_bytes(const uint8_t *&bytes) const override;
 
 private:
     void decode_control(const FPort_Frame &frame);
@@ -292,10 +292,34 @@ bool AP_RCProtocol_FPort2::check_checksum(void)
 // support byte input
 void AP_RCProtocol_FPort2::process_byte(uint8_t b, uint32_t baudrate)
 {
-    if (baudrate != 115200) {
+    if (!baudrate_supported(baudrate)) {
         return;
     }
     _process_byte(AP_HAL::micros(), b);
 }
 
+// process a block of bytes, all read from the UART at the same time
+void AP_RCProtocol_FPort2::process_bytes(const uint8_t *bytes, uint16_t n, uint32_t baudrate)
+{
+    if (!baudrate_supported(baudrate)) {
+        return;
+    }
+    const uint32_t now_us = AP_HAL::micros();
+    for (uint16_t i = 0; i < n; i++) {
+        _process_byte(now_us, bytes[i]);
+    }
+}
+
+bool AP_RCProtocol_FPort2::baudrate_supported(uint32_t baudrate) const
+{
+    return baudrate == 115200;
+}
+
+uint8_t AP_RCProtocol_FPort2::frame_start_bytes(const uint8_t *&bytes) const
+{
+    static const uint8_t start[] { FRAME_LEN_8, FRAME_LEN_16, FRAME_LEN_24, FRAME_LEN_DOWNLINK };
+    bytes = start;
+    return ARRAY_SIZE(start);
+}
+
 #endif  // AP_RCPROTOCOL_FPORT2_ENABLED
@@ -34,6 +34,9 @@ public:
     AP_RCProtocol_FPort2(AP_RCProtocol &_frontend, bool inverted);
     void process_pulse(uint32_t width_s0, uint32_t width_s1) override;
     void process_byte(uint8_t byte, uint32_t baudrate) override;
+    void process_bytes(const uint8_t *bytes, uint16_t n, uint32_t baudrate) override;
+    bool baudrate_supported(uint32_t baudrate) const override;
+    uint8_t frame_start_bytes(const uint8_t *&bytes) const override;
 
 private:
     void decode_control(const FPort2_Frame &frame);
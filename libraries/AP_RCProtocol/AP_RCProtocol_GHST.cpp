@@ -428,12 +428,36 @@ bool AP_RCProtocol_GHST::is_telemetry_supported() const
 void AP_RCProtocol_GHST::process_byte(uint8_t byte, uint32_t baudrate)
 {
     // reject RC data if we have been configured for standalone mode
-    if (baudrate != CRSF_BAUDRATE && baudrate != GHST_BAUDRATE) {
+    if (!baudrate_supported(baudrate)) {
         return;
     }
     _process_byte(AP_HAL::micros(), byte);
 }
 
+// process a block of bytes, all read from the UART at the same time
+void AP_RCProtocol_GHST::process_bytes(const uint8_t *bytes, uint16_t n, uint32_t baudrate)
+{
+    if (!baudrate_supported(baudrate)) {
+        return;
+    }
+    const uint32_t now_us = AP_HAL::micros();
+    for (uint16_t i = 0; i < n; i++) {
+        _process_byte(now_us, bytes[i]);
+    }
+}
+
+bool AP_RCProtocol_GHST::baudrate_supported(uint32_t baudrate) const
+{
+    return baudrate == CRSF_BAUDRATE || baudrate == GHST_BAUDRATE;
+}
+
+uint8_t AP_RCProtocol_GHST::frame_start_bytes(const uint8_t *&bytes) const
+{
+    static const uint8_t start[] { uint8_t(DeviceAddress::GHST_ADDRESS_FLIGHT_CONTROLLER) };
+    bytes = start;
+    return ARRAY_SIZE(start);
+}
+
 // change the bootstrap baud rate to Ghost standard if configured
 void AP_RCProtocol_GHST::process_handshake(uint32_t baudrate)
 {
@@ -36,6 +36,9 @@ public:
     AP_RCProtocol_GHST(AP_RCProtocol &_frontend);
     virtual ~AP_RCProtocol_GHST();
     void process_byte(uint8_t byte, uint32_t baudrate) override;
+    void process_bytes(const uint8_t *bytes, uint16_t n, uint32_t baudrate) override;
+    bool baudrate_supported(uint32_t baudrate) const override;
+    uint8_t frame_start_bytes(const uint8_t *&bytes) const override;
     void process_handshake(uint32_t baudrate) override;
     void update(void) override;
 
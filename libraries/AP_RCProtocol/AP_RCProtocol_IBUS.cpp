@@ -99,10 +99,22 @@ void AP_RCProtocol_IBUS::_process_byte(uint32_t timestamp_us, uint8_t b)
 // support byte input
 void AP_RCProtocol_IBUS::process_byte(uint8_t b, uint32_t baudrate)
 {
-    if (baudrate != 115200) {
+    if (!baudrate_supported(baudrate)) {
         return;
     }
     _process_byte(AP_HAL::micros(), b);
 }
 
+bool AP_RCProtocol_IBUS::baudrate_supported(uint32_t baudrate) const
+{
+    return baudrate == 115200;
+}
+
+uint8_t AP_RCProtocol_IBUS::frame_start_bytes(const uint8_t *&bytes) const
+{
+    static const uint8_t start[] { 0x20 };
+    bytes = start;
+    return ARRAY_SIZE(start);
+}
+
 #endif  // AP_RCPROTOCOL_IBUS_ENABLED
@@ -205,12 +205,36 @@ void AP_RCProtocol_SBUS::_process_byte(uint32_t timestamp_us, uint8_t b)
 // support byte input
 void AP_RCProtocol_SBUS::process_byte(uint8_t b, uint32_t baudrate)
 {
-    // note that if we're here we're not actually using SoftSerial,
-    // but it does record our configured baud rate:
-    if (baudrate != ss.baud()) {
+    if (!baudrate_supported(baudrate)) {
         return;
     }
     _process_byte(AP_HAL::micros(), b);
 }
 
+// process a block of bytes, all read from the UART at the same time
+void AP_RCProtocol_SBUS::process_bytes(const uint8_t *bytes, uint16_t n, uint32_t baudrate)
+{
+    if (!baudrate_supported(baudrate)) {
+        return;
+    }
+    const uint32_t now_us = AP_HAL::micros();
+    for (uint16_t i = 0; i < n; i++) {
+        _process_byte(now_us, bytes[i]);
+    }
+}
+
+bool AP_RCProtocol_SBUS::baudrate_supported(uint32_t baudrate) const
+{
+    // note that if we're here we're not actually using SoftSerial,
+    // but it does record our configured baud rate:
+    return baudrate == ss.baud();
+}
+
+uint8_t AP_RCProtocol_SBUS::frame_start_bytes(const uint8_t *&bytes) const
+{
+    static const uint8_t start[] { 0x0F };
+    bytes = start;
+    return ARRAY_SIZE(start);
+}
+
 #endif  // AP_RCPROTOCOL_SBUS_ENABLED
@@ -280,10 +280,22 @@ void AP_RCProtocol_SRXL::_process_byte(uint32_t timestamp_us, uint8_t byte)
  */
 void AP_RCProtocol_SRXL::process_byte(uint8_t byte, uint32_t baudrate)
 {
-    if (baudrate != 115200) {
+    if (!baudrate_supported(baudrate)) {
         return;
     }
     _process_byte(AP_HAL::micros(), byte);
 }
 
+bool AP_RCProtocol_SRXL::baudrate_supported(uint32_t baudrate) const
+{
+    return baudrate == 115200;
+}
+
+uint8_t AP_RCProtocol_SRXL::frame_start_bytes(const uint8_t *&bytes) const
+{
+    static const uint8_t start[] { SRXL_HEADER_V1, SRXL_HEADER_V2, SRXL_HEADER_V5 };
+    bytes = start;
+    return ARRAY_SIZE(start);
+}
+
 #endif  // AP_RCPROTOCOL_SRXL_ENABLED
@@ -242,13 +242,25 @@ void AP_RCProtocol_SRXL2::start_bind(void)
 // process a byte provided by a uart
 void AP_RCProtocol_SRXL2::process_byte(uint8_t byte, uint32_t baudrate)
 {
-    if (baudrate != 115200) {
+    if (!baudrate_supported(baudrate)) {
         return;
     }
 
     _process_byte(AP_HAL::micros(), byte);
 }
 
+bool AP_RCProtocol_SRXL2::baudrate_supported(uint32_t baudrate) const
+{
+    return baudrate == 115200;
+}
+
+uint8_t AP_RCProtocol_SRXL2::frame_start_bytes(const uint8_t *&bytes) const
+{
+    static const uint8_t start[] { SPEKTRUM_SRXL_ID };
+    bytes = start;
+    return ARRAY_SIZE(start);
+}
+
 // handshake
 void AP_RCProtocol_SRXL2::process_handshake(uint32_t baudrate)
 {
@@ -234,10 +234,22 @@ void AP_RCProtocol_ST24::_process_byte(uint8_t byte)
 
 void AP_RCProtocol_ST24::process_byte(uint8_t byte, uint32_t baudrate)
 {
-    if (baudrate != 115200) {
+    if (!baudrate_supported(baudrate)) {
         return;
     }
     _process_byte(byte);
 }
 
+bool AP_RCProtocol_ST24::baudrate_supported(uint32_t baudrate) const
+{
+    return baudrate == 115200;
+}
+
+uint8_t AP_RCProtocol_ST24::frame_start_bytes(const uint8_t *&bytes) const
+{
+    static const uint8_t start[] { ST24_STX1 };
+    bytes = start;
+    return ARRAY_SIZE(start);
+}
+
 #endif  // AP_RCPROTOCOL_ST24_ENABLED
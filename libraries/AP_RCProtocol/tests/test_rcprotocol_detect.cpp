@@ -0,0 +1,226 @@
+/*
+  test protocol detection and decoding of byte input, one byte at a
+  time and with whole UART reads. The number of frames and CPU time
+  needed to detect each protocol, and the CPU time per frame once
+  detected, are printed for both
+ */
+#include <AP_gtest.h>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/crc.h>
+#include <AP_SBusOut/AP_SBusOut.h>
+#include <AP_SerialManager/AP_SerialManager.h>
+#include <AP_RCProtocol/AP_RCProtocol.h>
+#include <RC_Channel/RC_Channel.h>
+#include <stdio.h>
+#include <unistd.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+class RC_Channel_Test : public RC_Channel {};
+
+class RC_Channels_Test : public RC_Channels
+{
+public:
+    RC_Channel_Test obj_channels[NUM_RC_CHANNELS];
+
+    RC_Channel_Test *channel(const uint8_t chan) override {
+        if (chan >= NUM_RC_CHANNELS) {
+            return nullptr;
+        }
+        return &obj_channels[chan];
+    }
+
+protected:
+    int8_t flight_mode_channel_number() const override { return 5; }
+};
+
+#define RC_CHANNELS_SUBCLASS RC_Channels_Test
+#define RC_CHANNEL_SUBCLASS RC_Channel_Test
+
+#include <RC_Channel/RC_Channels_VarInfo.h>
+
+static RC_Channels_Test rchannels;
+static AP_SerialManager serial_manager;
+
+// long enough for the frame gap of SBUS and IBUS
+#define FRAME_GAP_US 3000
+
+#define MAX_FRAMES 20
+#define STEADY_FRAMES 200
+
+struct Frame {
+    uint8_t bytes[64];
+    uint8_t len;
+};
+
+static void sbus_frame(Frame &f)
+{
+    uint16_t values[8] { 1500, 1500, 1000, 1500, 1800, 1200, 1500, 1500 };
+    AP_SBusOut::sbus_format_frame(values, ARRAY_SIZE(values), f.bytes);
+    f.len = 25;
+}
+
+static void ibus_frame(Frame &f)
+{
+    f.bytes[0] = 0x20;
+    f.bytes[1] = 0x40;
+    uint16_t chksum = 0xFFFF - 0x20 - 0x40;
+    for (uint8_t i=0; i<14; i++) {
+        const uint16_t v = i == 2 ? 1000 : 1500;
+        f.bytes[2+i*2] = v & 0xFF;
+        f.bytes[3+i*2] = v >> 8;
+        chksum -= f.bytes[2+i*2] + f.bytes[3+i*2];
+    }
+    f.bytes[30] = chksum & 0xFF;
+    f.bytes[31] = chksum >> 8;
+    f.len = 32;
+}
+
+static void crsf_frame(Frame &f)
+{
+    // 16 channels of 11 bits, 992 is 1500us
+    memset(f.bytes, 0, sizeof(f.bytes));
+    f.bytes[0] = 0xC8;
+    f.bytes[1] = 24;
+    f.bytes[2] = 0x16;
+    uint32_t bitpos = 0;
+    for (uint8_t i=0; i<16; i++) {
+        const uint16_t v = i == 2 ? 191 : 992;
+        for (uint8_t b=0; b<11; b++, bitpos++) {
+            if (v & (1U<<b)) {
+                f.bytes[3 + bitpos/8] |= 1U << (bitpos%8);
+            }
+        }
+    }
+    f.bytes[25] = crc8_dvb_s2_update(0, &f.bytes[2], 23);
+    f.len = 26;
+}
+
+struct Result {
+    uint8_t frames_to_detect;
+    uint32_t detect_us;
+    uint32_t frame_ns;
+    uint16_t chan1;
+    uint16_t chan3;
+};
+
+/*
+  feed frames to a new AP_RCProtocol until it detects a protocol,
+  then time decoding of STEADY_FRAMES more frames. The sleeps between
+  frames give the frame gaps and are not timed
+ */
+static Result run(const Frame &f, uint32_t baudrate, bool batch, AP_RCProtocol::rcprotocol_t expected)
+{
+    Result r {};
+    AP_RCProtocol rcprot;
+    rcprot.init();
+
+    auto feed = [&]() -> uint32_t {
+        const uint64_t start_us = AP_HAL::micros64();
+        if (batch) {
+            rcprot.process_bytes(f.bytes, f.len, baudrate);
+        } else {
+            for (uint8_t i=0; i<f.len; i++) {
+                rcprot.process_byte(f.bytes[i], baudrate);
+            }
+        }
+        return uint32_t(AP_HAL::micros64() - start_us);
+    };
+
+    while (r.frames_to_detect < MAX_FRAMES &&
+           rcprot.protocol_detected() == AP_RCProtocol::NONE) {
+        usleep(FRAME_GAP_US);
+        r.detect_us += feed();
+        r.frames_to_detect++;
+    }
+    if (rcprot.protocol_detected() != expected) {
+        r.frames_to_detect = 0;
+        return r;
+    }
+
+    uint64_t steady_us = 0;
+    for (uint16_t i=0; i<STEADY_FRAMES; i++) {
+        usleep(FRAME_GAP_US);
+        steady_us += feed();
+    }
+    r.frame_ns = steady_us * 1000 / STEADY_FRAMES;
+    r.chan1 = rcprot.read(0);
+    r.chan3 = rcprot.read(2);
+    return r;
+}
+
+static void check_protocol(const char *name, const Frame &f, uint32_t baudrate, AP_RCProtocol::rcprotocol_t expected)
+{
+    const Result per_byte = run(f, baudrate, false, expected);
+    const Result per_read = run(f, baudrate, true, expected);
+
+    ASSERT_GT(per_byte.frames_to_detect, 0) << name << " not detected with process_byte()";
+    ASSERT_GT(per_read.frames_to_detect, 0) << name << " not detected with process_bytes()";
+    EXPECT_EQ(per_byte.frames_to_detect, per_read.frames_to_detect);
+    EXPECT_EQ(per_read.chan1, 1500);
+    EXPECT_EQ(per_byte.chan3, per_read.chan3);
+
+    printf("%-6s detect: %u frames, %u us per byte, %u us per read; per frame: %u ns per byte, %u ns per read\n",
+           name, unsigned(per_read.frames_to_detect),
+           unsigned(per_byte.detect_us), unsigned(per_read.detect_us),
+           unsigned(per_byte.frame_ns), unsigned(per_read.frame_ns));
+}
+
+TEST(RCProtocolDetect, sbus)
+{
+    Frame f;
+    sbus_frame(f);
+    check_protocol("SBUS", f, 100000, AP_RCProtocol::SBUS);
+}
+
+TEST(RCProtocolDetect, ibus)
+{
+    Frame f;
+    ibus_frame(f);
+    check_protocol("IBUS", f, 115200, AP_RCProtocol::IBUS);
+}
+
+TEST(RCProtocolDetect, crsf)
+{
+    Frame f;
+    crsf_frame(f);
+    check_protocol("CRSF", f, 416666, AP_RCProtocol::CRSF);
+}
+
+// a frame at a baudrate its protocol can't run at is never detected
+TEST(RCProtocolDetect, wrong_baudrate)
+{
+    Frame f;
+    sbus_frame(f);
+    AP_RCProtocol rcprot;
+    rcprot.init();
+    for (uint8_t i=0; i<MAX_FRAMES; i++) {
+        usleep(FRAME_GAP_US);
+        rcprot.process_bytes(f.bytes, f.len, 416666);
+    }
+    EXPECT_EQ(rcprot.protocol_detected(), AP_RCProtocol::NONE);
+}
+
+// noise without any frame start bytes doesn't delay detection
+TEST(RCProtocolDetect, after_noise)
+{
+    Frame f;
+    ibus_frame(f);
+    AP_RCProtocol rcprot;
+    rcprot.init();
+    uint8_t noise[64];
+    memset(noise, 0x33, sizeof(noise));
+    for (uint8_t i=0; i<50; i++) {
+        rcprot.process_bytes(noise, sizeof(noise), 115200);
+    }
+    uint8_t frames = 0;
+    while (frames < MAX_FRAMES && rcprot.protocol_detected() == AP_RCProtocol::NONE) {
+        usleep(FRAME_GAP_US);
+        rcprot.process_bytes(f.bytes, f.len, 115200);
+        frames++;
+    }
+    EXPECT_EQ(rcprot.protocol_detected(), AP_RCProtocol::IBUS);
+    EXPECT_LE(frames, 2);
+}
+
+AP_GTEST_MAIN()
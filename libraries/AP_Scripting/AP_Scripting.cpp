@@ -24,6 +24,7 @@
 #include <AP_Arming/AP_Arming.h>
 
 #include "lua_scripts.h"
+#include "lua_profiler.h"
 #include "AP_Scripting_helpers.h"
 
 // ensure that we have a set of stack sizes, and enforce constraints around it
@@ -98,6 +99,7 @@ const AP_Param::GroupInfo AP_Scripting::var_info[] = {
     // @Bitmask: 4: Disable pre-arm check
     // @Bitmask: 5: Save CRC of current scripts to loaded and running checksum parameters enabling pre-arm
     // @Bitmask: 6: Disable heap expansion on allocation failure
+    // @Bitmask: 7: Profile scripts, results are logged and in @SYS/scripting.txt
     // @User: Advanced
     AP_GROUPINFO("DEBUG_OPTS", 4, AP_Scripting, _debug_options, 0),
 
@@ -165,6 +167,16 @@ const AP_Param::GroupInfo AP_Scripting::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("THD_PRIORITY", 14, AP_Scripting, _thd_priority, uint8_t(ThreadPriority::NORMAL)),
 
+#if AP_SCRIPTING_MAX_VMS > 1
+    // @Param: VM_COUNT
+    // @DisplayName: Number of scripting VMs
+    // @Description: Number of independent Lua VMs. Each VM runs in its own thread with its own heap of SCR_HEAP_SIZE, so a slow or faulty script only delays the scripts in its own VM. The first VM runs scripts from the scripts directory and ROMFS, additional VMs run scripts from the vm1, vm2 etc subdirectories of the scripts directory. Each VM receives its own copy of the MAVLink messages it registers for. Mission commands for scripts and data from scripting serial devices are shared, each is received by only one VM.
+    // @Range: 1 4
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("VM_COUNT", 19, AP_Scripting, _vm_count, 1),
+#endif
+
 #if AP_SCRIPTING_SERIALDEVICE_ENABLED
     // @Param: SDEV_EN
     // @DisplayName: Scripting serial device enable
@@ -254,10 +266,31 @@ void AP_Scripting::init(void) {
         }
     }
 
-    if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&AP_Scripting::thread, void),
-                                      "Scripting", SCRIPTING_STACK_SIZE, priority, 0)) {
-        GCS_SEND_TEXT(MAV_SEVERITY_ERROR, "Scripting: %s", "failed to start");
-        _thread_failed = true;
+    static const char *thread_names[] { "Scripting", "Scripting1", "Scripting2", "Scripting3" };
+    static_assert(AP_SCRIPTING_MAX_VMS <= ARRAY_SIZE(thread_names), "not enough thread names");
+#if AP_SCRIPTING_MAX_VMS > 1
+    const uint8_t num_vms = constrain_int16(_vm_count, 1, AP_SCRIPTING_MAX_VMS);
+    lua_scripts::set_multiple_vms(num_vms > 1);
+#else
+    const uint8_t num_vms = 1;
+#endif
+
+    // the first VM starts the others, so create its thread last
+    for (int8_t i=num_vms-1; i>=0; i--) {
+        _vm_threads[i].scripting = this;
+        _vm_threads[i].vm = i;
+        _num_vms++;
+        if (!hal.scheduler->thread_create(FUNCTOR_BIND(&_vm_threads[i], &AP_Scripting::vm_thread::run, void),
+                                          thread_names[i], SCRIPTING_STACK_SIZE, priority, 0)) {
+            GCS_SEND_TEXT(MAV_SEVERITY_ERROR, "Scripting: %s", "failed to start");
+            _thread_failed = true;
+            _num_vms--;
+            if (i == 0) {
+                // nothing will start the other VMs
+                WITH_SEMAPHORE(_vm_sem);
+                _first_vm_failed = true;
+            }
+        }
     }
 }
 
@@ -294,18 +327,20 @@ MAV_RESULT AP_Scripting::handle_command_int_packet(const mavlink_command_int_t &
 }
 #endif
 
-void AP_Scripting::thread(void) {
+/*
+  run a VM. The first VM owns the resources shared by all VMs, it
+  starts the other VMs and frees the shared resources once they have
+  all stopped
+ */
+void AP_Scripting::thread(uint8_t vm) {
+    uint32_t start_count = 0;
     while (true) {
-        // reset flags
-        _stop = false;
-        _restart = false;
-        _init_failed = false;
+        if (vm == 0) {
+            // reset flags
+            _stop = false;
+            _restart = false;
+            _init_failed = false;
 
-        lua_scripts *lua = NEW_NOTHROW lua_scripts(_script_vm_exec_count, _script_heap_size, _debug_options);
-        if (lua == nullptr || !lua->heap_allocated()) {
-            GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Scripting: %s", "Unable to allocate memory");
-            _init_failed = true;
-        } else {
 #if AP_SCRIPTING_SERIALDEVICE_ENABLED
             // clear data in serial buffers that the script wasn't ready to
             // receive
@@ -315,6 +350,31 @@ void AP_Scripting::thread(void) {
             // Clear any dangling pre-arms from previous script loads
             AP_Arming::get_singleton()->reset_all_aux_auths();
 #endif
+            WITH_SEMAPHORE(_vm_sem);
+            _vms_running = _num_vms;
+            _vm_start_count++;
+        } else {
+            // wait to be started by the first VM
+            while (true) {
+                {
+                    WITH_SEMAPHORE(_vm_sem);
+                    if (_first_vm_failed) {
+                        return;
+                    }
+                    if (_vm_start_count != start_count) {
+                        start_count = _vm_start_count;
+                        break;
+                    }
+                }
+                hal.scheduler->delay(100);
+            }
+        }
+
+        lua_scripts *lua = NEW_NOTHROW lua_scripts(_script_vm_exec_count, _script_heap_size, _debug_options, vm);
+        if (lua == nullptr || !lua->heap_allocated()) {
+            GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Scripting: %s", "Unable to allocate memory");
+            _init_failed = true;
+        } else {
             // run won't return while scripting is still active
             lua->run();
 
@@ -324,6 +384,25 @@ void AP_Scripting::thread(void) {
         delete lua;
         lua = nullptr;
 
+        {
+            WITH_SEMAPHORE(_vm_sem);
+            _vms_running--;
+        }
+        if (vm != 0) {
+            continue;
+        }
+
+        // wait for the other VMs to stop before freeing what they share
+        while (true) {
+            {
+                WITH_SEMAPHORE(_vm_sem);
+                if (_vms_running == 0) {
+                    break;
+                }
+            }
+            hal.scheduler->delay(100);
+        }
+
         // clear allocated i2c devices
         for (uint8_t i=0; i<SCRIPTING_MAX_NUM_I2C_DEVICE; i++) {
             delete _i2c_dev[i];
@@ -369,6 +448,9 @@ void AP_Scripting::thread(void) {
             }
         }
 
+        // free the last error message
+        lua_scripts::clear_error_message();
+
         bool cleared = false;
         while(true) {
             // 1hz check if we should restart
@@ -473,22 +555,31 @@ void AP_Scripting::restart_all()
     _stop = true;
 }
 
+#if AP_SCRIPTING_PROFILER_ENABLED
+// write the script profile for @SYS/scripting.txt
+void AP_Scripting::profile_info(ExpandingString &str)
+{
+    lua_scripts::info(str);
+}
+#endif
+
 #if HAL_GCS_ENABLED
 void AP_Scripting::handle_message(const mavlink_message_t &msg, const mavlink_channel_t chan) {
-    if (mavlink_data.rx_buffer == nullptr) {
-        return;
-    }
-
     struct mavlink_msg data {msg, chan, AP_HAL::millis()};
 
-    WITH_SEMAPHORE(mavlink_data.sem);
-    for (uint16_t i = 0; i < mavlink_data.accept_msg_ids_size; i++) {
-        if (mavlink_data.accept_msg_ids[i] == UINT32_MAX) {
-            return;
+    for (auto &vm_data : mavlink_data) {
+        if (vm_data.rx_buffer == nullptr) {
+            continue;
         }
-        if (mavlink_data.accept_msg_ids[i] == msg.msgid) {
-            mavlink_data.rx_buffer->push(data);
-            return;
+        WITH_SEMAPHORE(vm_data.sem);
+        for (uint16_t i = 0; i < vm_data.accept_msg_ids_size; i++) {
+            if (vm_data.accept_msg_ids[i] == UINT32_MAX) {
+                break;
+            }
+            if (vm_data.accept_msg_ids[i] == msg.msgid) {
+                vm_data.rx_buffer->push(data);
+                break;
+            }
         }
     }
 }
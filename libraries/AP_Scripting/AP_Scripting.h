@@ -41,6 +41,8 @@
 class SocketAPM;
 #endif
 
+class ExpandingString;
+
 #if AP_SCRIPTING_SERIALDEVICE_ENABLED
 #include "AP_Scripting_SerialDevice.h"
 #endif
@@ -86,6 +88,11 @@ public:
     void restart_all(void);
     void stop(void) { _stop = true; }
 
+#if AP_SCRIPTING_PROFILER_ENABLED
+    // write VM statistics and the script profile for @SYS/scripting.txt
+    void profile_info(ExpandingString &str);
+#endif
+
    // User parameters for inputs into scripts 
    AP_Float _user[6];
 
@@ -121,8 +128,6 @@ public:
     // PWMSource storage
     uint8_t num_pwm_source;
     AP_HAL::PWMSource *_pwm_source[SCRIPTING_MAX_NUM_PWM_SOURCE];
-    int get_current_env_ref() { return current_env_ref; }
-    void set_current_env_ref(int ref) { current_env_ref = ref; }
 
 #if AP_NETWORKING_ENABLED
     // SocketAPM storage
@@ -135,12 +140,13 @@ public:
         uint32_t timestamp_ms;
     };
 
+    // each VM receives its own copy of the messages it registers for
     struct mavlink {
         ObjectBuffer<struct mavlink_msg> *rx_buffer;
         uint32_t *accept_msg_ids;
         uint16_t accept_msg_ids_size;
         HAL_Semaphore sem;
-    } mavlink_data;
+    } mavlink_data[AP_SCRIPTING_MAX_VMS];
 
     struct command_block_list {
         uint16_t id;
@@ -161,11 +167,27 @@ public:
         DISABLE_PRE_ARM = 1U << 4,
         SAVE_CHECKSUM = 1U << 5,
         DISABLE_HEAP_EXPANSION = 1U << 6,
+        PROFILE = 1U << 7,
     };
 
 private:
 
-    void thread(void); // main script execution thread
+    void thread(uint8_t vm); // script execution thread of a VM
+
+    // each VM has its own thread
+    struct vm_thread {
+        AP_Scripting *scripting;
+        uint8_t vm;
+        void run(void) { scripting->thread(vm); }
+    } _vm_threads[AP_SCRIPTING_MAX_VMS];
+
+    // number of VMs with a thread, VMs are started together and
+    // resources shared between VMs are freed once all have stopped
+    uint8_t _num_vms;
+    uint8_t _vms_running;
+    uint32_t _vm_start_count;
+    bool _first_vm_failed;      // the first VM's thread could not be created, the others exit
+    HAL_Semaphore _vm_sem;
 
     // Check if DEBUG_OPTS bit has been set to save current checksum values to params
     void save_checksum();
@@ -195,6 +217,9 @@ private:
     AP_Int32 _required_running_checksum;
 
     AP_Enum<ThreadPriority> _thd_priority;
+#if AP_SCRIPTING_MAX_VMS > 1
+    AP_Int8 _vm_count;
+#endif
 
     bool option_is_set(DebugOption option) const {
         return (uint8_t(_debug_options.get()) & uint8_t(option)) != 0;
@@ -210,7 +235,6 @@ private:
     bool _stop; // true if scripts should be stopped
 
     static AP_Scripting *_singleton;
-    int current_env_ref;
 };
 
 namespace AP {
@@ -16,6 +16,19 @@
     #endif
 #endif
 
+#ifndef AP_SCRIPTING_PROFILER_ENABLED
+#define AP_SCRIPTING_PROFILER_ENABLED AP_SCRIPTING_ENABLED
+#endif
+
+// maximum number of independent Lua VMs, each with its own thread and heap
+#ifndef AP_SCRIPTING_MAX_VMS
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define AP_SCRIPTING_MAX_VMS 4
+#else
+#define AP_SCRIPTING_MAX_VMS 1
+#endif
+#endif
+
 #ifndef AP_SCRIPTING_SERIALDEVICE_ENABLED
 #define AP_SCRIPTING_SERIALDEVICE_ENABLED AP_SERIALMANAGER_REGISTER_ENABLED && (HAL_PROGRAM_SIZE_LIMIT_KB>1024)
 #endif
@@ -218,7 +218,7 @@ int DroneCAN_Handle::broadcast(lua_State *L)
     transfer.data_type_signature = h->signature;
     transfer.data_type_id = h->data_type;
     transfer.inout_transfer_id = &h->transfer_id;
-    transfer.priority = 0;
+    transfer.priority = h->priority;
     transfer.payload = data;
     transfer.payload_len = data_length;
     transfer.iface_mask = IFACE_ALL;
@@ -254,7 +254,7 @@ int DroneCAN_Handle::request(lua_State *L)
     transfer.data_type_signature = h->signature;
     transfer.data_type_id = h->data_type;
     transfer.inout_transfer_id = &h->transfer_id;
-    transfer.priority = 0;
+    transfer.priority = h->priority;
     transfer.payload = data;
     transfer.payload_len = data_length;
     transfer.iface_mask = IFACE_ALL;
@@ -52,6 +52,7 @@ public:
     uint64_t signature;
     uint16_t data_type;
     uint8_t transfer_id;
+    uint8_t priority;
     bool canfd;
 
 private:
@@ -389,8 +389,9 @@ function Cylinder_Status_ud:ignition_timing_deg(value) end
 efi = {}
 
 -- desc
+---@param out? EFI_State_ud -- filled in and returned instead of a new userdata
 ---@return EFI_State_ud
-function efi:get_state() end
+function efi:get_state(out) end
 
 -- get last update time in milliseconds
 ---@return uint32_t_ud
@@ -839,8 +840,19 @@ local Vector2f_ud = {}
 function Vector2f() end
 
 -- Copy this Vector2f returning a new userdata object
+---@param out? Vector2f_ud -- filled in and returned instead of a new userdata
 ---@return Vector2f_ud -- a copy of this Vector2f
-function Vector2f_ud:copy() end
+function Vector2f_ud:copy(out) end
+
+-- get all components without allocating
+---@return number -- x
+---@return number -- y
+function Vector2f_ud:unpack() end
+
+-- set all components
+---@param x number
+---@param y number
+function Vector2f_ud:pack(x, y) end
 
 -- get y component
 ---@return number
@@ -899,8 +911,21 @@ local Vector3f_ud = {}
 function Vector3f() end
 
 -- Copy this Vector3f returning a new userdata object
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud -- a copy of this Vector3f
-function Vector3f_ud:copy() end
+function Vector3f_ud:copy(out) end
+
+-- get all components without allocating
+---@return number -- x
+---@return number -- y
+---@return number -- z
+function Vector3f_ud:unpack() end
+
+-- set all components
+---@param x number
+---@param y number
+---@param z number
+function Vector3f_ud:pack(x, y, z) end
 
 -- get z component
 ---@return number
@@ -928,13 +953,15 @@ function Vector3f_ud:x(value) end
 
 -- Return a new Vector3 based on this one with scaled length and the same changing direction
 ---@param scale_factor number
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud -- scaled copy of this vector
-function Vector3f_ud:scale(scale_factor) end
+function Vector3f_ud:scale(scale_factor, out) end
 
 -- Cross product of two Vector3fs
 ---@param vector Vector3f_ud
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud -- result
-function Vector3f_ud:cross(vector) end
+function Vector3f_ud:cross(vector, out) end
 
 -- Dot product of two Vector3fs
 ---@param vector Vector3f_ud
@@ -970,8 +997,9 @@ function Vector3f_ud:angle(v2) end
 function Vector3f_ud:rotate_xy(param1) end
 
 -- return the x and y components of this vector as a Vector2f
+---@param out? Vector2f_ud -- filled in and returned instead of a new userdata
 ---@return Vector2f_ud
-function Vector3f_ud:xy() end
+function Vector3f_ud:xy(out) end
 
 -- desc
 ---@class (exact) Quaternion_ud
@@ -981,6 +1009,20 @@ local Quaternion_ud = {}
 ---@return Quaternion_ud
 function Quaternion() end
 
+-- get all fields without allocating
+---@return number -- q1
+---@return number -- q2
+---@return number -- q3
+---@return number -- q4
+function Quaternion_ud:unpack() end
+
+-- set all fields
+---@param q1 number
+---@param q2 number
+---@param q3 number
+---@param q4 number
+function Quaternion_ud:pack(q1, q2, q3, q4) end
+
 -- get field
 ---@return number
 function Quaternion_ud:q4() end
@@ -1018,8 +1060,9 @@ function Quaternion_ud:q1(value) end
 function Quaternion_ud:earth_to_body(vec) end
 
 -- Returns inverse of quaternion
+---@param out? Quaternion_ud -- filled in and returned instead of a new userdata
 ---@return Quaternion_ud
-function Quaternion_ud:inverse() end
+function Quaternion_ud:inverse(out) end
 
 -- Integrates angular velocity over small time delta
 ---@param angular_velocity Vector3f_ud
@@ -1071,8 +1114,9 @@ local Location_ud = {}
 function Location() end
 
 -- Copy this location returning a new userdata object
+---@param out? Location_ud -- filled in and returned instead of a new userdata
 ---@return Location_ud -- a copy of this location
-function Location_ud:copy() end
+function Location_ud:copy(out) end
 
 -- get loiter xtrack
 ---@return boolean -- Get if the location is used for a loiter location this flags if the aircraft should track from the center point, or from the exit location of the loiter.
@@ -1106,6 +1150,18 @@ function Location_ud:relative_alt() end
 ---@param value boolean -- set true if altitude is relative to home
 function Location_ud:relative_alt(value) end
 
+-- get latitude, longitude and altitude without allocating
+---@return integer -- latitude in degrees * 1e7
+---@return integer -- longitude in degrees * 1e7
+---@return integer -- altitude in cm
+function Location_ud:unpack() end
+
+-- set latitude, longitude and altitude, leaving the altitude frame unchanged
+---@param lat integer -- latitude in degrees * 1e7
+---@param lng integer -- longitude in degrees * 1e7
+---@param alt integer -- altitude in cm
+function Location_ud:pack(lat, lng, alt) end
+
 -- get altitude in cm
 ---@return integer -- altitude in cm
 function Location_ud:alt() end
@@ -1158,13 +1214,15 @@ function Location_ud:set_alt_m(alt, frame) end
 
 -- Given a Location this calculates the north and east distance between the two locations in meters.
 ---@param loc Location_ud -- location to compare with
+---@param out? Vector2f_ud -- filled in and returned instead of a new userdata
 ---@return Vector2f_ud -- North east distance vector in meters
-function Location_ud:get_distance_NE(loc) end
+function Location_ud:get_distance_NE(loc, out) end
 
 -- Given a Location this calculates the north, east and down distance between the two locations in meters.
 ---@param loc Location_ud -- location to compare with
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud -- North east down distance vector in meters
-function Location_ud:get_distance_NED(loc) end
+function Location_ud:get_distance_NED(loc, out) end
 
 -- Given a Location this calculates the relative bearing to the location in radians
 ---@param loc Location_ud -- location to compare with
@@ -1173,18 +1231,21 @@ function Location_ud:get_bearing(loc) end
 
 -- Returns the offset from the EKF origin to this location (in cm)
 -- Returns nil if the EKF origin wasn’t available at the time this was called.
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud|nil -- Vector between origin and location north east up in cm
-function Location_ud:get_vector_from_origin_NEU_cm() end
+function Location_ud:get_vector_from_origin_NEU_cm(out) end
 
 -- Returns the offset from the EKF origin to this location (in metres).
 -- Returns nil if the EKF origin wasn’t available at the time this was called.
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud|nil -- Vector between origin and location north east up in meters
-function Location_ud:get_vector_from_origin_NEU_m() end
+function Location_ud:get_vector_from_origin_NEU_m(out) end
 
 --- Deprecated method returning offset from EKF origin
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud|nil -- Vector between origin and location north east up in centimetres
 ---@deprecated -- Use get_vector_from_origin_NEU_cm or get_vector_from_origin_NEU_m
-function Location_ud:get_vector_from_origin_NEU() end
+function Location_ud:get_vector_from_origin_NEU(out) end
 
 -- Translates this Location by the specified  distance given a bearing.
 ---@param bearing_deg number -- bearing in degrees
@@ -1221,8 +1282,9 @@ function AP_EFI_Backend_ud:handle_scripting(state) end
 local ScriptingCANBuffer_ud = {}
 
 -- desc
+---@param out? CANFrame_ud -- filled in and returned instead of a new userdata
 ---@return CANFrame_ud|nil
-function ScriptingCANBuffer_ud:read_frame() end
+function ScriptingCANBuffer_ud:read_frame(out) end
 
 -- Add a filter to the CAN buffer, mask is bitwise ANDed with the frame id and compared to value if not match frame is not buffered
 -- By default no filters are added and all frames are buffered, write is not affected by filters
@@ -1469,8 +1531,9 @@ function AP_Camera__camera_state_t_ud:take_pic_incr() end
 
 -- desc
 ---@param instance integer
+---@param out? AP_Camera__camera_state_t_ud -- filled in and returned instead of a new userdata
 ---@return AP_Camera__camera_state_t_ud|nil
-function camera:get_state(instance) end
+function camera:get_state(instance, out) end
 
 -- Change a camera setting to a given value
 ---@param instance integer
@@ -1744,8 +1807,9 @@ function mount:set_attitude_euler(instance, roll_deg, pitch_deg, yaw_deg) end
 
 -- desc
 ---@param instance integer
+---@param out? Location_ud -- filled in and returned instead of a new userdata
 ---@return Location_ud|nil
-function mount:get_location_target(instance) end
+function mount:get_location_target(instance, out) end
 
 -- desc
 ---@param instance integer
@@ -1915,8 +1979,9 @@ function FWVersion:string() end
 periph = {}
 
 -- desc
+---@param out? uint64_t_ud -- filled in and returned instead of a new userdata
 ---@return uint64_t_ud
-function periph:get_vehicle_state() end
+function periph:get_vehicle_state(out) end
 
 -- desc
 ---@return number
@@ -1964,13 +2029,15 @@ function ins:calibrating() end
 
 -- Get the value of a specific gyroscope
 ---@param instance integer -- the 0-based index of the gyroscope instance to return.
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud
-function ins:get_gyro(instance) end
+function ins:get_gyro(instance, out) end
 
 -- Get the value of a specific accelerometer
 ---@param instance integer -- the 0-based index of the accelerometer instance to return.
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud
-function ins:get_accel(instance) end
+function ins:get_accel(instance, out) end
 
 -- desc
 Motors_dynamic = {}
@@ -2234,8 +2301,9 @@ function mission:set_item(index, item) end
 
 -- get any WP items in any order in a mavlink-ish kinda way.
 ---@param index integer
+---@param out? mavlink_mission_item_int_t_ud -- filled in and returned instead of a new userdata
 ---@return mavlink_mission_item_int_t_ud|nil
-function mission:get_item(index) end
+function mission:get_item(index, out) end
 
 -- num_commands - returns total number of commands in the mission
 --                 this number includes offset 0, the home location
@@ -2786,8 +2854,9 @@ function vehicle:set_target_pos_NED(target_pos, use_yaw, yaw_deg, use_yaw_rate,
 function vehicle:update_target_location(current_target, new_target) end
 
 -- Get the current target location if available in current mode
+---@param out? Location_ud -- filled in and returned instead of a new userdata
 ---@return Location_ud|nil -- target location
-function vehicle:get_target_location() end
+function vehicle:get_target_location(out) end
 
 -- Set the target veicle location in a guided mode
 ---@param target_loc Location_ud -- target location
@@ -2915,12 +2984,14 @@ function AP_Vehicle__custom_mode_state_ud:allow_entry(value) end
 onvif = {}
 
 -- desc
+---@param out? Vector2f_ud -- filled in and returned instead of a new userdata
 ---@return Vector2f_ud
-function onvif:get_pan_tilt_limit_max() end
+function onvif:get_pan_tilt_limit_max(out) end
 
 -- desc
+---@param out? Vector2f_ud -- filled in and returned instead of a new userdata
 ---@return Vector2f_ud
-function onvif:get_pan_tilt_limit_min() end
+function onvif:get_pan_tilt_limit_min(out) end
 
 -- desc
 ---@param pan number
@@ -3196,8 +3267,9 @@ function AP_RangeFinder_Backend_ud:distance() end
 function AP_RangeFinder_Backend_ud:signal_quality() end
 
 -- State of most recent range finder measurment
+---@param out? RangeFinder_State_ud -- filled in and returned instead of a new userdata
 ---@return RangeFinder_State_ud
-function AP_RangeFinder_Backend_ud:get_state() end
+function AP_RangeFinder_Backend_ud:get_state(out) end
 
 
 -- desc
@@ -3210,8 +3282,9 @@ function rangefinder:get_backend(rangefinder_instance) end
 
 -- desc
 ---@param orientation integer
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud
-function rangefinder:get_pos_offset_orient(orientation) end
+function rangefinder:get_pos_offset_orient(orientation, out) end
 
 -- desc
 ---@param orientation integer
@@ -3388,8 +3461,9 @@ gps.NO_GPS = enum_integer
 
 -- get unix time
 ---@param instance integer -- instance number
+---@param out? uint64_t_ud -- filled in and returned instead of a new userdata
 ---@return uint64_t_ud -- unix time microseconds
-function gps:time_epoch_usec(instance) end
+function gps:time_epoch_usec(instance, out) end
 
 -- get yaw from GPS in degrees
 ---@param instance integer -- instance number
@@ -3404,8 +3478,9 @@ function gps:first_unconfigured_gps() end
 
 -- Returns a Vector3f that contains the offsets of the GPS in meters in the body frame.
 ---@param instance integer -- instance number
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud -- anteena offset vector forward, right, down in meters
-function gps:get_antenna_offset(instance) end
+function gps:get_antenna_offset(instance, out) end
 
 -- Returns true if the GPS instance can report the vertical velocity.
 ---@param instance integer -- instance number
@@ -3460,8 +3535,9 @@ function gps:ground_speed(instance) end
 -- Returns a Vector3f that contains the velocity as observed by the GPS.
 -- You must check the status to know if the velocity is still current.
 ---@param instance integer -- instance number
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud -- 3D velocity in m/s, in NED format
-function gps:velocity(instance) end
+function gps:velocity(instance, out) end
 
 -- desc
 ---@param instance integer -- instance number
@@ -3480,8 +3556,9 @@ function gps:speed_accuracy(instance) end
 
 -- eturns a Location userdata for the last GPS position. You must check the status to know if the location is still current, if it is NO_GPS, or NO_FIX then it will be returning old data.
 ---@param instance integer -- instance number
+---@param out? Location_ud -- filled in and returned instead of a new userdata
 ---@return Location_ud --gps location
-function gps:location(instance) end
+function gps:location(instance, out) end
 
 -- Returns the GPS fix status. Compare this to one of the GPS fix types.
 -- Posible status are provided as values on the gps object. eg: gps.GPS_OK_FIX_3D
@@ -3702,8 +3779,9 @@ ahrs = {}
 function ahrs:handle_external_position_estimate(location, accuracy, timestamp_ms) end
 
 -- desc
+---@param out? Quaternion_ud -- filled in and returned instead of a new userdata
 ---@return Quaternion_ud|nil
-function ahrs:get_quaternion() end
+function ahrs:get_quaternion(out) end
 
 -- desc
 ---@return integer
@@ -3719,8 +3797,9 @@ function ahrs:initialised() end
 function ahrs:set_origin(loc) end
 
 -- desc
+---@param out? Location_ud -- filled in and returned instead of a new userdata
 ---@return Location_ud|nil
-function ahrs:get_origin() end
+function ahrs:get_origin(out) end
 
 -- desc
 ---@param loc Location_ud
@@ -3729,9 +3808,11 @@ function ahrs:set_home(loc) end
 
 -- desc
 ---@param source integer
+---@param out1? Vector3f_ud -- filled in and returned instead of a new userdata
+---@param out2? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud|nil
 ---@return Vector3f_ud|nil
-function ahrs:get_vel_innovations_and_variances_for_source(source) end
+function ahrs:get_vel_innovations_and_variances_for_source(source, out1, out2) end
 
 -- desc
 ---@param source_set_idx integer
@@ -3741,12 +3822,13 @@ function ahrs:get_vel_innovations_and_variances_for_source(source) end
 function ahrs:set_posvelyaw_source_set(source_set_idx) end
 
 -- desc
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return number|nil
 ---@return number|nil
 ---@return number|nil
 ---@return Vector3f_ud|nil
 ---@return number|nil
-function ahrs:get_variances() end
+function ahrs:get_variances(out) end
 
 -- desc
 ---@return number
@@ -3754,17 +3836,20 @@ function ahrs:get_EAS2TAS() end
 
 -- desc
 ---@param vector Vector3f_ud
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud
-function ahrs:body_to_earth(vector) end
+function ahrs:body_to_earth(vector, out) end
 
 -- desc
 ---@param vector Vector3f_ud
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud
-function ahrs:earth_to_body(vector) end
+function ahrs:earth_to_body(vector, out) end
 
 -- desc
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud
-function ahrs:get_vibration() end
+function ahrs:get_vibration(out) end
 
 -- Return the Equivalent Air Speed of the vehicle if available
 ---@return number|nil -- airspeed in meters / second if available
@@ -3788,24 +3873,29 @@ function ahrs:home_is_set() end
 function ahrs:get_relative_position_D_home() end
 
 -- desc
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud|nil
-function ahrs:get_relative_position_NED_origin() end
+function ahrs:get_relative_position_NED_origin(out) end
 
 -- desc
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud|nil
-function ahrs:get_relative_position_NED_home() end
+function ahrs:get_relative_position_NED_home(out) end
 
 -- Returns nil, or a Vector3f containing the current NED vehicle velocity in meters/second in north, east, and down components.
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud|nil -- North, east, down velcoity in meters / second if available
-function ahrs:get_velocity_NED() end
+function ahrs:get_velocity_NED(out) end
 
 -- Get current groundspeed vector in meter / second
+---@param out? Vector2f_ud -- filled in and returned instead of a new userdata
 ---@return Vector2f_ud -- ground speed vector, North East, meters / second
-function ahrs:groundspeed_vector() end
+function ahrs:groundspeed_vector(out) end
 
 -- Returns a Vector3f containing the current wind estimate for the vehicle.
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud -- wind estiamte North, East, Down meters / second
-function ahrs:wind_estimate() end
+function ahrs:wind_estimate(out) end
 
 -- Determine how aligned heading_deg is with the wind. Return result
 -- is 1.0 when perfectly aligned heading into wind, -1 when perfectly
@@ -3824,25 +3914,30 @@ function ahrs:head_wind() end
 function ahrs:get_hagl() end
 
 -- desc
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud
-function ahrs:get_accel() end
+function ahrs:get_accel(out) end
 
 -- Returns a Vector3f containing the current smoothed and filtered gyro rates (in radians/second)
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud -- roll, pitch, yaw gyro rates in radians / second
-function ahrs:get_gyro() end
+function ahrs:get_gyro(out) end
 
 -- Returns a Location that contains the vehicles current home waypoint.
+---@param out? Location_ud -- filled in and returned instead of a new userdata
 ---@return Location_ud -- home location
-function ahrs:get_home() end
+function ahrs:get_home(out) end
 
 -- Returns nil or Location userdata that contains the vehicles current position.
 -- Note: This will only return a Location if the system considers the current estimate to be reasonable.
+---@param out? Location_ud -- filled in and returned instead of a new userdata
 ---@return Location_ud|nil -- current location if available
-function ahrs:get_location() end
+function ahrs:get_location(out) end
 
 -- same as `get_location` will be removed
+---@param out? Location_ud -- filled in and returned instead of a new userdata
 ---@return Location_ud|nil
-function ahrs:get_position() end
+function ahrs:get_position(out) end
 
 -- Returns the current vehicle euler yaw angle in radians.
 ---@return number -- yaw angle in radians.
@@ -3903,29 +3998,36 @@ poscontrol = {}
 function poscontrol:set_posvelaccel_offset(pos_offset_NED, vel_offset_NED, accel_offset_NED) end
 
 -- get position controller's target position, velocity and acceleration offsets
+---@param out1? Vector3f_ud -- filled in and returned instead of a new userdata
+---@param out2? Vector3f_ud -- filled in and returned instead of a new userdata
+---@param out3? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud|nil
 ---@return Vector3f_ud|nil
 ---@return Vector3f_ud|nil
-function poscontrol:get_posvelaccel_offset() end
+function poscontrol:get_posvelaccel_offset(out1, out2, out3) end
 
 -- get position controller's target velocity in m/s in NED frame
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud|nil
-function poscontrol:get_vel_target() end
+function poscontrol:get_vel_target(out) end
 
 -- get position controller's target acceleration in m/s/s in NED frame
+---@param out? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud|nil
-function poscontrol:get_accel_target() end
+function poscontrol:get_accel_target(out) end
 
 -- precision landing access
 precland = {}
 
 -- get Location of target or nil if target not acquired
+---@param out? Location_ud -- filled in and returned instead of a new userdata
 ---@return Location_ud|nil
-function precland:get_target_location() end
+function precland:get_target_location(out) end
 
 -- get NE velocity of target or nil if not available
+---@param out? Vector2f_ud -- filled in and returned instead of a new userdata
 ---@return Vector2f_ud|nil
-function precland:get_target_velocity() end
+function precland:get_target_velocity(out) end
 
 -- get the time of the last valid target
 ---@return uint32_t_ud
@@ -3951,14 +4053,18 @@ function follow:get_target_sysid() end
 function follow:get_target_heading_deg() end
 
 -- get target's estimated location and velocity (in NED)
+---@param out1? Location_ud -- filled in and returned instead of a new userdata
+---@param out2? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Location_ud|nil -- location
 ---@return Vector3f_ud|nil -- velocity
-function follow:get_target_location_and_velocity() end
+function follow:get_target_location_and_velocity(out1, out2) end
 
 -- get target's estimated location with offsets added, and velocity (in NED)
+---@param out1? Location_ud -- filled in and returned instead of a new userdata
+---@param out2? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Location_ud|nil -- location
 ---@return Vector3f_ud|nil -- velocity
-function follow:get_target_location_and_velocity_ofs() end
+function follow:get_target_location_and_velocity_ofs(out1, out2) end
 
 -- desc
 ---@return uint32_t_ud
@@ -3969,10 +4075,13 @@ function follow:get_last_update_ms() end
 function follow:have_target() end
 
 -- get distance vector to target (in meters) and target's velocity all in NED frame
+---@param out1? Vector3f_ud -- filled in and returned instead of a new userdata
+---@param out2? Vector3f_ud -- filled in and returned instead of a new userdata
+---@param out3? Vector3f_ud -- filled in and returned instead of a new userdata
 ---@return Vector3f_ud|nil -- distance NED
 ---@return Vector3f_ud|nil -- distance NED with offsets
 ---@return Vector3f_ud|nil -- velocity NED
-function follow:get_target_dist_and_vel_NED_m() end
+function follow:get_target_dist_and_vel_NED_m(out1, out2, out3) end
 
 -- desc
 scripting = {}
@@ -4087,20 +4196,23 @@ function fence:get_breach_distance(fence_type) end
 
 -- Returns the direction and distance in meters to the nearest fence in NED frame given by the type bitmask
 ---@param fence_type integer
+---@param out1? Vector3f_ud -- filled in and returned instead of a new userdata
+---@param out2? Location_ud -- filled in and returned instead of a new userdata
 ---| 1 # Maximim altitude
 ---| 2 # Circle
 ---| 4 # Polygon
 ---| 8 # Minimum altitude
 ---@return Vector3f_ud|nil -- direction and distance to breach in NED frame
 ---@return Location_ud|nil -- location at the time of the breach
-function fence:get_breach_direction_NED(fence_type) end
+function fence:get_breach_direction_NED(fence_type, out1, out2) end
 
 -- Rally library
 rally = {}
 -- Returns a specfic rally by index as a Location 
 ---@param index integer -- 0 indexed
+---@param out? Location_ud -- filled in and returned instead of a new userdata
 ---@return Location_ud|nil
-function rally:get_rally_location(index) end
+function rally:get_rally_location(index, out) end
 
 -- desc
 ---@class (exact) stat_t_ud
@@ -4162,8 +4274,9 @@ fs = {}
 
 -- desc
 ---@param param1 string
+---@param out? stat_t_ud -- filled in and returned instead of a new userdata
 ---@return stat_t_ud|nil
-function fs:stat(param1) end
+function fs:stat(param1, out) end
 
 -- Format the SD card. This is a async operation, use get_format_status to get the status of the format
 ---@return boolean
@@ -4222,8 +4335,9 @@ servo_telem = {}
 
 -- get servo telem for the given servo number
 ---@param servo_index integer -- 0 indexed servo number
+---@param out? AP_Servo_Telem_Data_ud -- filled in and returned instead of a new userdata
 ---@return AP_Servo_Telem_Data_ud|nil
-function servo_telem:get_telem(servo_index) end
+function servo_telem:get_telem(servo_index, out) end
 
 -- Servo telemetry userdata object
 ---@class AP_Servo_Telem_Data_ud
@@ -4406,3 +4520,11 @@ function DroneCAN_Handle_ud:request(target_node, payload) end
 ---@return boolean -- true if send succeeded
 function DroneCAN_Handle_ud:broadcast(payload) end
 
+-- get the priority of broadcasts and requests, 0 being the highest
+---@return integer -- priority
+function DroneCAN_Handle_ud:priority() end
+
+-- set the priority of broadcasts and requests, 0 being the highest and the default
+---@param value integer -- priority, 0 to 31
+function DroneCAN_Handle_ud:priority(value) end
+
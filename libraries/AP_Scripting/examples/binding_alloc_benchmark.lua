@@ -0,0 +1,118 @@
+-- Compares bindings which allocate a new userdata for each result with
+-- passing in userdata to be filled in and with unpack()/pack().
+--
+-- Each test is run in turn and its average time per call, including
+-- any garbage collection it causes, is reported every 10 seconds.
+-- Set bit 7 of SCR_DEBUG_OPTS to profile scripts, the Alloc column of
+-- @SYS/scripting.txt then shows the bytes allocated by each test.
+
+local LOOPS = 50
+local REPORT_MS = 10000
+
+local vel = Vector3f()
+local gyro = Vector3f()
+local loc = Location()
+local v = Vector3f()
+
+local function alloc_velocity()
+  for _ = 1, LOOPS do
+    ahrs:get_velocity_NED()
+  end
+end
+
+local function reuse_velocity()
+  for _ = 1, LOOPS do
+    ahrs:get_velocity_NED(vel)
+  end
+end
+
+local function alloc_gyro()
+  for _ = 1, LOOPS do
+    ahrs:get_gyro()
+  end
+end
+
+local function reuse_gyro()
+  for _ = 1, LOOPS do
+    ahrs:get_gyro(gyro)
+  end
+end
+
+local function alloc_location()
+  for _ = 1, LOOPS do
+    ahrs:get_location()
+  end
+end
+
+local function reuse_location()
+  for _ = 1, LOOPS do
+    ahrs:get_location(loc)
+  end
+end
+
+local function components()
+  local x, y, z
+  for _ = 1, LOOPS do
+    x = v:x()
+    y = v:y()
+    z = v:z()
+    v:x(z)
+    v:y(x)
+    v:z(y)
+  end
+end
+
+local function unpack_pack()
+  local x, y, z
+  for _ = 1, LOOPS do
+    x, y, z = v:unpack()
+    v:pack(z, x, y)
+  end
+end
+
+local tests = {
+  { name = "get_velocity_NED()", fn = alloc_velocity },
+  { name = "get_velocity_NED(v)", fn = reuse_velocity },
+  { name = "get_gyro()", fn = alloc_gyro },
+  { name = "get_gyro(v)", fn = reuse_gyro },
+  { name = "get_location()", fn = alloc_location },
+  { name = "get_location(loc)", fn = reuse_location },
+  { name = "x() y() z()", fn = components },
+  { name = "unpack() pack()", fn = unpack_pack },
+}
+
+for _, t in ipairs(tests) do
+  t.time_us = 0
+  t.runs = 0
+end
+
+local next_test = 1
+local last_report_ms = millis()
+
+local function report()
+  for _, t in ipairs(tests) do
+    if t.runs > 0 then
+      local per_call_ns = t.time_us:tofloat() * 1000 / (t.runs * LOOPS)
+      gcs:send_text(6, string.format("%-20s %6.0f ns", t.name, per_call_ns))
+    end
+    t.time_us = 0
+    t.runs = 0
+  end
+end
+
+function update()
+  local t = tests[next_test]
+  local start_us = micros()
+  t.fn()
+  t.time_us = t.time_us + (micros() - start_us)
+  t.runs = t.runs + 1
+  next_test = (next_test % #tests) + 1
+
+  if millis() - last_report_ms > REPORT_MS then
+    last_report_ms = millis()
+    report()
+  end
+  return update, 10
+end
+
+return update()
@@ -12,6 +12,18 @@ int binding_argcheck(lua_State *L, int expected_arg_count) {
     return 0;
 }
 
+// check arguments for a method which can write its userdata results
+// into up to out_arg_count optional out arguments
+int binding_argcheck_out(lua_State *L, int expected_arg_count, int out_arg_count) {
+    const int args = lua_gettop(L);
+    if (args > expected_arg_count + out_arg_count) {
+        return luaL_argerror(L, args, "too many arguments");
+    } else if (args < expected_arg_count) {
+        return luaL_argerror(L, args, "too few arguments");
+    }
+    return 0;
+}
+
 int field_argerror(lua_State *L) {
     return binding_argcheck(L, -1); // force too many args error
 }
@@ -4,6 +4,7 @@
 
 void load_generated_sandbox(lua_State *L);
 int binding_argcheck(lua_State *L, int expected_arg_count);
+int binding_argcheck_out(lua_State *L, int expected_arg_count, int out_arg_count);
 int field_argerror(lua_State *L);
 bool userdata_zero_arg_check(lua_State *L);
 lua_Integer get_integer(lua_State *L, int arg_num, lua_Integer min_val, lua_Integer max_val);
@@ -33,6 +33,7 @@ char keyword_creation[]            = "creation";
 char keyword_manual_operator[]     = "manual_operator";
 char keyword_operator_getter[]     = "operator_getter";
 char keyword_field_valid_mask[]    = "valid_mask";
+char keyword_unpack[]              = "unpack";
 
 
 // attributes (should include the leading ' )
@@ -413,6 +414,8 @@ struct userdata_enum {
   char * name;     // enum name
 };
 
+#define MAX_UNPACK_FIELDS 8
+
 struct userdata {
   struct userdata * next;
   char *name;  // name of the C++ singleton
@@ -429,6 +432,8 @@ struct userdata {
   char *creation; // name of a manual creation function if set, note that this will not be used internally
   int creation_args; // number of args for custom creation function
   char *operator_getter; // Custom function to get values for use in operators
+  char **unpack_fields; // fields read and written together by unpack() and pack()
+  int unpack_count;
 };
 
 static struct userdata *parsed_userdata;
@@ -1085,6 +1090,23 @@ void handle_userdata(void) {
     handle_manual(node, ALIAS_TYPE_MANUAL_OPERATOR);
     node->operations |= OP_MANUAL;
 
+  } else if (strcmp(type, keyword_unpack) == 0) {
+      if (node->unpack_fields != NULL) {
+        error(ERROR_USERDATA, "Userdata only support a single unpack list");
+      }
+      node->unpack_fields = (char **)allocate(sizeof(char *) * MAX_UNPACK_FIELDS);
+      char *name;
+      while ((name = next_token()) != NULL) {
+        if (node->unpack_count >= MAX_UNPACK_FIELDS) {
+          error(ERROR_USERDATA, "Userdata %s can only unpack %d fields", node->name, MAX_UNPACK_FIELDS);
+        }
+        string_copy(&(node->unpack_fields[node->unpack_count]), name);
+        node->unpack_count++;
+      }
+      if (node->unpack_count == 0) {
+        error(ERROR_USERDATA, "Expected a list of fields to unpack for %s", node->name);
+      }
+
   } else if (strcmp(type, keyword_operator_getter) == 0) {
       if (node->operator_getter != NULL) {
         error(ERROR_USERDATA, "Userdata only support a single getter string");
@@ -1918,8 +1940,31 @@ void emit_ap_object_fields() {
   }
 }
 
+// emit a userdata result, written into the caller's out argument if one was given
+void emit_userdata_result(const char *sanitized_name, const char *value, int out_arg, const char *tab) {
+  if (out_arg == 0) {
+    fprintf(source, "%s*new_%s(L) = %s;\n", tab, sanitized_name, value);
+    return;
+  }
+  fprintf(source, "%sif (out_%d != nullptr) {\n", tab, out_arg);
+  fprintf(source, "%s    *out_%d = %s;\n", tab, out_arg, value);
+  fprintf(source, "%s    lua_pushvalue(L, %d);\n", tab, out_arg);
+  fprintf(source, "%s} else {\n", tab);
+  fprintf(source, "%s    *new_%s(L) = %s;\n", tab, sanitized_name, value);
+  fprintf(source, "%s}\n", tab);
+}
+
+// return from a method, releasing the binding lock once the results have been pushed
+void emit_method_return(const int binding_lock, const int return_count, const char * tab) {
+  if (binding_lock) {
+    fprintf(source, "%slua_scripts::binding_unlock(L);\n", tab);
+  }
+  fprintf(source, "%sreturn %d;\n", tab, return_count);
+}
+
 // emit references functions for a call, return the number of arguments added
-int emit_references(const struct argument *arg, const char * tab) {
+// out_arg is the argument number of the out argument for the first userdata result, 0 if there are none
+int emit_references(const struct argument *arg, int out_arg, const char * tab) {
   int arg_index = NULLABLE_ARG_COUNT_BASE + 2;
   int return_count = 0;
   // count arguments to return so we know if we need to check the stack
@@ -1957,9 +2002,15 @@ int emit_references(const struct argument *arg, const char * tab) {
         case TYPE_STRING:
           fprintf(source, "%slua_pushstring(L, data_%d);\n", tab, arg_index);
           break;
-        case TYPE_USERDATA:
-          fprintf(source, "%s*new_%s(L) = data_%d;\n", tab, arg->type.data.ud.sanitized_name, arg_index);
+        case TYPE_USERDATA: {
+          char value[32];
+          snprintf(value, sizeof(value), "data_%d", arg_index);
+          emit_userdata_result(arg->type.data.ud.sanitized_name, value, out_arg, tab);
+          if (out_arg != 0) {
+            out_arg++;
+          }
           break;
+        }
         case TYPE_NONE:
           error(ERROR_INTERNAL, "Attempted to emit a nullable or reference argument of type none");
           break;
@@ -2006,7 +2057,23 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
     }
     arg = arg->next;
   }
-  fprintf(source, "    binding_argcheck(L, %d);\n", arg_count);
+  // userdata results can be written into optional trailing out arguments
+  // instead of allocating new userdata, so scripts can reuse them
+  int out_count = (method->return_type.type == TYPE_USERDATA) ? 1 : 0;
+  arg = method->arguments;
+  while (arg != NULL) {
+    if ((arg->type.flags & (TYPE_FLAGS_NULLABLE | TYPE_FLAGS_REFERENCE)) && (arg->type.type == TYPE_USERDATA)) {
+      out_count++;
+    }
+    arg = arg->next;
+  }
+  const int first_out_arg = (out_count > 0) ? arg_count + 1 : 0;
+
+  if (out_count > 0) {
+    fprintf(source, "    binding_argcheck_out(L, %d, %d);\n", arg_count, out_count);
+  } else {
+    fprintf(source, "    binding_argcheck(L, %d);\n", arg_count);
+  }
 
   switch (data->ud_type) {
     case UD_USERDATA:
@@ -2044,9 +2111,34 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
     arg = arg->next;
   }
 
+  // out arguments, in the order the results are returned: references first
+  int out_arg = first_out_arg;
+  arg = method->arguments;
+  while (arg != NULL) {
+    if ((arg->type.flags & (TYPE_FLAGS_NULLABLE | TYPE_FLAGS_REFERENCE)) && (arg->type.type == TYPE_USERDATA)) {
+      fprintf(source, "    %s *out_%d = lua_isnoneornil(L, %d) ? nullptr : check_%s(L, %d);\n",
+              arg->type.data.ud.name, out_arg, out_arg, arg->type.data.ud.sanitized_name, out_arg);
+      out_arg++;
+    }
+    arg = arg->next;
+  }
+  const int return_out_arg = (method->return_type.type == TYPE_USERDATA) ? out_arg : 0;
+  if (return_out_arg != 0) {
+    fprintf(source, "    %s *out_%d = lua_isnoneornil(L, %d) ? nullptr : check_%s(L, %d);\n",
+            method->return_type.data.ud.name, out_arg, out_arg, method->return_type.data.ud.sanitized_name, out_arg);
+  }
+
   const char *ud_name = (data->flags & UD_FLAG_LITERAL)?data->name:"ud";
   const char *ud_access = (data->flags & UD_FLAG_REFERENCE)?".":"->";
 
+  // singletons and AP_Objects are shared between VMs, serialise calls into them.
+  // the lock is held until the results have been pushed, if that raises an error
+  // the lock is released after the script has run
+  const int binding_lock = (data->ud_type == UD_SINGLETON) || (data->ud_type == UD_AP_OBJECT);
+  if (binding_lock) {
+    fprintf(source, "    lua_scripts::binding_lock(L);\n");
+  }
+
   if (data->flags & UD_FLAG_SEMAPHORE) {
     fprintf(source, "    %s%sget_semaphore().take_blocking();\n", ud_name, ud_access);
   } else if (data->flags & UD_FLAG_SEMAPHORE_POINTER) {
@@ -2196,7 +2288,7 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
   if (method->flags & TYPE_FLAGS_REFERENCE) {
     arg = method->arguments;
     // number of arguments to return
-    return_count += emit_references(arg,"    ");
+    return_count += emit_references(arg, first_out_arg, "    ");
   }
 
   switch (method->return_type.type) {
@@ -2205,10 +2297,10 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
         fprintf(source, "    if (data) {\n");
         // we need to emit out nullable arguments, iterate the args again, creating and copying objects, while keeping a new count
         arg = method->arguments;
-        return_count = emit_references(arg,"        ");
-        fprintf(source, "        return %d;\n", return_count);
+        return_count = emit_references(arg, first_out_arg, "        ");
+        emit_method_return(binding_lock, return_count, "        ");
         fprintf(source, "    }\n");
-        fprintf(source, "    return 0;\n");
+        emit_method_return(binding_lock, 0, "    ");
       } else {
         fprintf(source, "    lua_pushboolean(L, data);\n");
       }
@@ -2231,11 +2323,11 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
       fprintf(source, "    lua_pushstring(L, data);\n");
       break;
     case TYPE_USERDATA:
-      fprintf(source, "    *new_%s(L) = data;\n", method->return_type.data.ud.sanitized_name);
+      emit_userdata_result(method->return_type.data.ud.sanitized_name, "data", return_out_arg, "    ");
       break;
     case TYPE_AP_OBJECT:
       fprintf(source, "    if (data == NULL) {\n");
-      fprintf(source, "        return 0;\n");
+      emit_method_return(binding_lock, 0, "        ");
       fprintf(source, "    }\n");
       fprintf(source, "    *new_%s(L) = data;\n", method->return_type.data.ud.sanitized_name);
       break;
@@ -2247,7 +2339,7 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
   }
 
   if ((method->return_type.type != TYPE_BOOLEAN) || ((method->flags & TYPE_FLAGS_NULLABLE) == 0)) {
-      fprintf(source, "    return %d;\n", return_count);
+      emit_method_return(binding_lock, return_count, "    ");
   }
 
   fprintf(source, "}\n");
@@ -2442,6 +2534,85 @@ void emit_operators(struct userdata *data) {
   end_dependency(source, data->dependency);
 }
 
+struct userdata_field *find_unpack_field(const struct userdata *data, const char *name) {
+  struct userdata_field *field = data->fields;
+  while (field != NULL && strcmp(field->name, name)) {
+    field = field->next;
+  }
+  if (field == NULL) {
+    error(ERROR_USERDATA, "Userdata %s has no field %s to unpack", data->name, name);
+  }
+  if ((field->array_len != NULL) || (field->dependency != NULL) || (field->type.valid_mask.name != NULL)) {
+    error(ERROR_USERDATA, "Userdata %s field %s can't be unpacked", data->name, name);
+  }
+  switch (field->type.type) {
+    case TYPE_BOOLEAN:
+    case TYPE_FLOAT:
+    case TYPE_INT8_T:
+    case TYPE_INT16_T:
+    case TYPE_INT32_T:
+    case TYPE_UINT8_T:
+    case TYPE_UINT16_T:
+      break;
+    default:
+      error(ERROR_USERDATA, "Userdata %s field %s must be a number or boolean to unpack", data->name, name);
+      break;
+  }
+  return field;
+}
+
+// true if all of the unpacked fields can be written by pack()
+int can_pack(const struct userdata *data) {
+  for (int i = 0; i < data->unpack_count; i++) {
+    if ((find_unpack_field(data, data->unpack_fields[i])->access_flags & ACCESS_FLAG_WRITE) == 0) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+// unpack() returns several fields at once, and pack() sets them, without allocating
+void emit_unpack(const struct userdata *data) {
+  if (data->ud_type != UD_USERDATA) {
+    error(ERROR_USERDATA, "Only userdata can be unpacked (%s)", data->name);
+  }
+
+  start_dependency(source, data->dependency);
+
+  fprintf(source, "static int %s_unpack(lua_State *L) {\n", data->sanitized_name);
+  fprintf(source, "    binding_argcheck(L, 1);\n");
+  fprintf(source, "    %s * ud = check_%s(L, 1);\n", data->name, data->sanitized_name);
+  for (int i = 0; i < data->unpack_count; i++) {
+    const struct userdata_field *field = find_unpack_field(data, data->unpack_fields[i]);
+    if (field->type.type == TYPE_FLOAT) {
+      fprintf(source, "    lua_pushnumber(L, ud->%s);\n", field->name);
+    } else if (field->type.type == TYPE_BOOLEAN) {
+      fprintf(source, "    lua_pushboolean(L, ud->%s);\n", field->name);
+    } else {
+      fprintf(source, "    lua_pushinteger(L, ud->%s);\n", field->name);
+    }
+  }
+  fprintf(source, "    return %d;\n", data->unpack_count);
+  fprintf(source, "}\n\n");
+
+  if (can_pack(data)) {
+    fprintf(source, "static int %s_pack(lua_State *L) {\n", data->sanitized_name);
+    fprintf(source, "    binding_argcheck(L, %d);\n", data->unpack_count + 1);
+    fprintf(source, "    %s * ud = check_%s(L, 1);\n", data->name, data->sanitized_name);
+    for (int i = 0; i < data->unpack_count; i++) {
+      const struct userdata_field *field = find_unpack_field(data, data->unpack_fields[i]);
+      emit_checker(field->type, i + 2, 0, "    ");
+    }
+    for (int i = 0; i < data->unpack_count; i++) {
+      fprintf(source, "    ud->%s = data_%d;\n", data->unpack_fields[i], i + 2);
+    }
+    fprintf(source, "    return 0;\n");
+    fprintf(source, "}\n\n");
+  }
+
+  end_dependency(source, data->dependency);
+}
+
 void emit_methods(struct userdata *node) {
   while(node) {
     // methods
@@ -2451,6 +2622,10 @@ void emit_methods(struct userdata *node) {
       method = method->next;
     }
 
+    if (node->unpack_fields != NULL) {
+      emit_unpack(node);
+    }
+
     // operators
     if (node->operations) {
       emit_operators(node);
@@ -2493,6 +2668,13 @@ void emit_index(struct userdata *head) {
       field = field->next;
     }
 
+    if (node->unpack_fields != NULL) {
+      fprintf(source, "    {\"unpack\", %s_unpack},\n", node->sanitized_name);
+      if (can_pack(node)) {
+        fprintf(source, "    {\"pack\", %s_pack},\n", node->sanitized_name);
+      }
+    }
+
     struct method_alias *alias = node->method_aliases;
     while(alias) {
       start_dependency(source, alias->dependency);
@@ -2696,6 +2878,23 @@ void emit_docs_method(const char *name, const char *method_name, struct method *
     arg = arg->next;
   }
 
+  // optional out arguments for userdata results, in the order the results are returned
+  int out_count = 0;
+  arg = method->arguments;
+  while (arg != NULL) {
+    if ((arg->type.flags & (TYPE_FLAGS_NULLABLE | TYPE_FLAGS_REFERENCE)) && (arg->type.type == TYPE_USERDATA)) {
+      out_count++;
+      fprintf(docs, "---@param out%i?", out_count);
+      emit_docs_type(arg->type, "", " -- filled in and returned instead of a new userdata\n");
+    }
+    arg = arg->next;
+  }
+  if (method->return_type.type == TYPE_USERDATA) {
+    out_count++;
+    fprintf(docs, "---@param out%i?", out_count);
+    emit_docs_type(method->return_type, "", " -- filled in and returned instead of a new userdata\n");
+  }
+
   // return type
   if ((method->flags & TYPE_FLAGS_NULLABLE) == 0) {
     emit_docs_return_type(method->return_type, FALSE);
@@ -2718,6 +2917,9 @@ void emit_docs_method(const char *name, const char *method_name, struct method *
       fprintf(docs, ", ");
     }
   }
+  for (int i = 1; i <= out_count; ++i) {
+    fprintf(docs, "%sout%i", (count + i > 2) ? ", " : "", i);
+  }
   fprintf(docs, ") end\n\n");
 }
 
@@ -2823,6 +3025,29 @@ void emit_docs(struct userdata *node, int is_userdata, int emit_creation) {
       method = method->next;
     }
 
+    // bulk field access
+    if (node->unpack_fields != NULL) {
+      fprintf(docs, "-- get fields\n");
+      for (int i = 0; i < node->unpack_count; i++) {
+        emit_docs_type(find_unpack_field(node, node->unpack_fields[i])->type, "---@return", "\n");
+      }
+      fprintf(docs, "function %s:unpack() end\n\n", name);
+
+      if (can_pack(node)) {
+        fprintf(docs, "-- set fields\n");
+        for (int i = 0; i < node->unpack_count; i++) {
+          char param_name[40];
+          snprintf(param_name, sizeof(param_name), "---@param %s", node->unpack_fields[i]);
+          emit_docs_param_type(find_unpack_field(node, node->unpack_fields[i])->type, param_name, "\n");
+        }
+        fprintf(docs, "function %s:pack(", name);
+        for (int i = 0; i < node->unpack_count; i++) {
+          fprintf(docs, "%s%s", node->unpack_fields[i], (i < node->unpack_count-1) ? ", " : "");
+        }
+        fprintf(docs, ") end\n\n");
+      }
+    }
+
     // aliases
     struct method_alias *alias = node->method_aliases;
     while(alias) {
@@ -13,6 +13,7 @@
 #include <AP_GPS/AP_GPS.h>
 
 #include "lua_bindings.h"
+#include "lua_scripts.h"
 
 #include "lua_boxed_numerics.h"
 #include <AP_Scripting/lua_generated_bindings.h>
@@ -60,6 +61,12 @@ int lua_micros(lua_State *L) {
 }
 
 #if HAL_GCS_ENABLED
+// MAVLink received for the VM running L
+static struct AP_Scripting::mavlink &vm_mavlink_data(lua_State *L)
+{
+    return AP::scripting()->mavlink_data[ls_object_from_state(L)->get_vm()];
+}
+
 int lua_mavlink_init(lua_State *L) {
     fix_dot_access_never_add_another_call(L, "mavlink");
 
@@ -69,7 +76,7 @@ int lua_mavlink_init(lua_State *L) {
     // get number of msgs to accept
     const uint32_t num_msgs = get_uint32(L, 3, 0, 25);
 
-    struct AP_Scripting::mavlink &data = AP::scripting()->mavlink_data;
+    struct AP_Scripting::mavlink &data = vm_mavlink_data(L);
     bool failed = false;
     {
         WITH_SEMAPHORE(data.sem);
@@ -106,7 +113,7 @@ int lua_mavlink_receive_chan(lua_State *L) {
     binding_argcheck(L, 1);
 
     struct AP_Scripting::mavlink_msg msg;
-    ObjectBuffer<struct AP_Scripting::mavlink_msg> *rx_buffer = AP::scripting()->mavlink_data.rx_buffer;
+    ObjectBuffer<struct AP_Scripting::mavlink_msg> *rx_buffer = vm_mavlink_data(L).rx_buffer;
 
     if (rx_buffer == nullptr) {
         return luaL_error(L, "RX not initialized");
@@ -130,33 +137,42 @@ int lua_mavlink_register_rx_msgid(lua_State *L) {
 
     const uint32_t msgid = get_uint32(L, 2, 0, (1 << 24) - 1);
 
-    struct AP_Scripting::mavlink &data = AP::scripting()->mavlink_data;
+    struct AP_Scripting::mavlink &data = vm_mavlink_data(L);
 
-    // check that we aren't currently watching this ID
-    for (uint8_t i = 0; i < data.accept_msg_ids_size; i++) {
-        if (data.accept_msg_ids[i] == msgid) {
-            lua_pushboolean(L, false);
-            return 1;
+    bool registered = false;
+    bool full = false;
+    {
+        // the list is read by handle_message()
+        WITH_SEMAPHORE(data.sem);
+
+        // check that we aren't currently watching this ID
+        for (uint8_t i = 0; i < data.accept_msg_ids_size; i++) {
+            if (data.accept_msg_ids[i] == msgid) {
+                registered = true;
+                break;
+            }
         }
-    }
 
-    int i = 0;
-    for (i = 0; i < data.accept_msg_ids_size; i++) {
-        if (data.accept_msg_ids[i] == UINT32_MAX) {
-            break;
+        if (!registered) {
+            int i = 0;
+            for (i = 0; i < data.accept_msg_ids_size; i++) {
+                if (data.accept_msg_ids[i] == UINT32_MAX) {
+                    break;
+                }
+            }
+            if (i >= data.accept_msg_ids_size) {
+                full = true;
+            } else {
+                data.accept_msg_ids[i] = msgid;
+            }
         }
-    }
+    } // release semaphore here as luaL_error will NOT do that!
 
-    if (i >= data.accept_msg_ids_size) {
+    if (full) {
         return luaL_error(L, "no registrations free");
     }
 
-    {
-        WITH_SEMAPHORE(data.sem);
-        data.accept_msg_ids[i] = msgid;
-    }
-
-    lua_pushboolean(L, true);
+    lua_pushboolean(L, !registered);
     return 1;
 }
 
@@ -519,19 +535,26 @@ int lua_get_i2c_device(lua_State *L) {
     auto *scripting = AP::scripting();
 
     static_assert(SCRIPTING_MAX_NUM_I2C_DEVICE >= 0, "There cannot be a negative number of I2C devices");
-    if (scripting->num_i2c_devices >= SCRIPTING_MAX_NUM_I2C_DEVICE) {
-        return luaL_argerror(L, 1, "no i2c devices available");
+    AP_HAL::I2CDevice *dev = nullptr;
+    lua_scripts::binding_lock(L);
+    const uint8_t index = scripting->num_i2c_devices;
+    if (index < SCRIPTING_MAX_NUM_I2C_DEVICE) {
+        dev = hal.i2c_mgr->get_device_ptr(bus, address, bus_clock, use_smbus);
+        if (dev != nullptr) {
+            scripting->_i2c_dev[index] = dev;
+            scripting->num_i2c_devices++;
+        }
     }
+    lua_scripts::binding_unlock(L);
 
-    scripting->_i2c_dev[scripting->num_i2c_devices] = hal.i2c_mgr->get_device_ptr(bus, address, bus_clock, use_smbus);
-
-    if (scripting->_i2c_dev[scripting->num_i2c_devices] == nullptr) {
+    if (index >= SCRIPTING_MAX_NUM_I2C_DEVICE) {
+        return luaL_argerror(L, 1, "no i2c devices available");
+    }
+    if (dev == nullptr) {
         return luaL_argerror(L, 1, "i2c device nullptr");
     }
 
-    *new_AP_HAL__I2CDevice(L) = scripting->_i2c_dev[scripting->num_i2c_devices];
-
-    scripting->num_i2c_devices++;
+    *new_AP_HAL__I2CDevice(L) = dev;
 
     return 1;
 }
@@ -616,20 +639,24 @@ int lua_get_CAN_device(lua_State *L) {
 
     auto *scripting = AP::scripting();
 
+    lua_scripts::binding_lock(L);
     if (scripting->_CAN_dev == nullptr) {
         scripting->_CAN_dev = NEW_NOTHROW ScriptingCANSensor(AP_CAN::Protocol::Scripting);
-        if (scripting->_CAN_dev == nullptr) {
-            return luaL_argerror(L, 1, "CAN device nullptr");
-        }
+    }
+    ScriptingCANSensor *dev = scripting->_CAN_dev;
+    lua_scripts::binding_unlock(L);
+
+    if (dev == nullptr) {
+        return luaL_argerror(L, 1, "CAN device nullptr");
     }
 
-    if (!scripting->_CAN_dev->initialized()) {
+    if (!dev->initialized()) {
         // Driver not initialized, probably because there is no can driver set to scripting
         // Return nil
         return 0;
     }
 
-    *new_ScriptingCANBuffer(L) = scripting->_CAN_dev->add_buffer(buffer_len);
+    *new_ScriptingCANBuffer(L) = dev->add_buffer(buffer_len);
 
     return 1;
 }
@@ -644,20 +671,24 @@ int lua_get_CAN_device2(lua_State *L) {
 
     auto *scripting = AP::scripting();
 
+    lua_scripts::binding_lock(L);
     if (scripting->_CAN_dev2 == nullptr) {
         scripting->_CAN_dev2 = NEW_NOTHROW ScriptingCANSensor(AP_CAN::Protocol::Scripting2);
-        if (scripting->_CAN_dev2 == nullptr) {
-            return luaL_argerror(L, 1, "CAN device nullptr");
-        }
     }
+    ScriptingCANSensor *dev = scripting->_CAN_dev2;
+    lua_scripts::binding_unlock(L);
 
-    if (!scripting->_CAN_dev2->initialized()) {
+    if (dev == nullptr) {
+        return luaL_argerror(L, 1, "CAN device nullptr");
+    }
+
+    if (!dev->initialized()) {
         // Driver not initialized, probably because there is no can driver set to scripting 2
         // Return nil
         return 0;
     }
 
-    *new_ScriptingCANBuffer(L) = scripting->_CAN_dev2->add_buffer(buffer_len);
+    *new_ScriptingCANBuffer(L) = dev->add_buffer(buffer_len);
 
     return 1;
 }
@@ -837,18 +868,26 @@ int lua_get_PWMSource(lua_State *L) {
     auto *scripting = AP::scripting();
 
     static_assert(SCRIPTING_MAX_NUM_PWM_SOURCE >= 0, "There cannot be a negative number of PWMSources");
-    if (scripting->num_pwm_source >= SCRIPTING_MAX_NUM_PWM_SOURCE) {
-        return luaL_argerror(L, 1, "no PWMSources available");
+    AP_HAL::PWMSource *source = nullptr;
+    lua_scripts::binding_lock(L);
+    const uint8_t index = scripting->num_pwm_source;
+    if (index < SCRIPTING_MAX_NUM_PWM_SOURCE) {
+        source = NEW_NOTHROW AP_HAL::PWMSource;
+        if (source != nullptr) {
+            scripting->_pwm_source[index] = source;
+            scripting->num_pwm_source++;
+        }
     }
+    lua_scripts::binding_unlock(L);
 
-    scripting->_pwm_source[scripting->num_pwm_source] = NEW_NOTHROW AP_HAL::PWMSource;
-    if (scripting->_pwm_source[scripting->num_pwm_source] == nullptr) {
+    if (index >= SCRIPTING_MAX_NUM_PWM_SOURCE) {
+        return luaL_argerror(L, 1, "no PWMSources available");
+    }
+    if (source == nullptr) {
         return luaL_argerror(L, 1, "PWMSources device nullptr");
     }
 
-    *new_AP_HAL__PWMSource(L) = scripting->_pwm_source[scripting->num_pwm_source];
-
-    scripting->num_pwm_source++;
+    *new_AP_HAL__PWMSource(L) = source;
 
     return 1;
 }
@@ -866,15 +905,24 @@ int lua_get_SocketAPM(lua_State *L) {
     if (sock == nullptr) {
         return luaL_argerror(L, 1, "SocketAPM device nullptr");
     }
+    bool stored = false;
+    lua_scripts::binding_lock(L);
     for (uint8_t i=0; i<SCRIPTING_MAX_NUM_NET_SOCKET; i++) {
         if (scripting->_net_sockets[i] == nullptr) {
             scripting->_net_sockets[i] = sock;
-            *new_SocketAPM(L) = scripting->_net_sockets[i];
-            return 1;
+            stored = true;
+            break;
         }
     }
+    lua_scripts::binding_unlock(L);
+
+    if (!stored) {
+        delete sock;
+        return luaL_argerror(L, 1, "no sockets available");
+    }
 
-    return luaL_argerror(L, 1, "no sockets available");
+    *new_SocketAPM(L) = sock;
+    return 1;
 }
 
 /*
@@ -888,15 +936,22 @@ int SocketAPM_close(lua_State *L) {
     auto *scripting = AP::scripting();
 
     // clear allocated socket
+    bool found = false;
+    lua_scripts::binding_lock(L);
     for (uint8_t i=0; i<SCRIPTING_MAX_NUM_NET_SOCKET; i++) {
         if (scripting->_net_sockets[i] == ud) {
             ud->close();
             delete ud;
             scripting->_net_sockets[i] = nullptr;
-            *check_SocketAPM(L, 1) = nullptr;
+            found = true;
             break;
         }
     }
+    lua_scripts::binding_unlock(L);
+
+    if (found) {
+        *check_SocketAPM(L, 1) = nullptr;
+    }
 
     return 0;
 }
@@ -974,19 +1029,23 @@ int SocketAPM_accept(lua_State *L) {
     auto *scripting = AP::scripting();
 
     // find an empty slot
+    SocketAPM *sock = nullptr;
+    lua_scripts::binding_lock(L);
     for (uint8_t i=0; i<SCRIPTING_MAX_NUM_NET_SOCKET; i++) {
         if (scripting->_net_sockets[i] == nullptr) {
-            scripting->_net_sockets[i] = ud->accept(0);
-            if (scripting->_net_sockets[i] == nullptr) {
-                return 0;
-            }
-            *new_SocketAPM(L) = scripting->_net_sockets[i];
-            return 1;
+            sock = ud->accept(0);
+            scripting->_net_sockets[i] = sock;
+            break;
         }
     }
+    lua_scripts::binding_unlock(L);
 
-    // out of socket slots, return nil, caller can retry
-    return 0;
+    if (sock == nullptr) {
+        // nothing to accept or out of socket slots, return nil, caller can retry
+        return 0;
+    }
+    *new_SocketAPM(L) = sock;
+    return 1;
 }
 
 /*
@@ -1017,10 +1076,9 @@ int SocketAPM_string_to_ipv4_addr(lua_State *L) {
 #endif // AP_NETWORKING_ENABLED
 
 
-int lua_get_current_env_ref()
+int lua_get_current_env_ref(lua_State *L)
 {
-    auto *scripting = AP::scripting();
-    return scripting->get_current_env_ref();
+    return ls_object_from_state(L)->get_current_env_ref();
 }
 
 // This is used when loading modules with require, lua must only look in enabled directory's
@@ -11,7 +11,8 @@
   #endif // HAL_OS_FATFS_IO || HAL_OS_LITTLEFS_IO
 #endif // SCRIPTING_DIRECTORY
 
-int lua_get_current_env_ref();
+struct lua_State;
+int lua_get_current_env_ref(struct lua_State *L);
 const char* lua_get_modules_path();
 void lua_abort(void) __attribute__((noreturn));
 
@@ -0,0 +1,266 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Scripting_config.h"
+
+#if AP_SCRIPTING_PROFILER_ENABLED
+
+#include "lua_profiler.h"
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Logger/AP_Logger.h>
+#include <AP_Common/ExpandingString.h>
+
+extern const AP_HAL::HAL& hal;
+
+// FNV-1a hash of a string
+static uint32_t hash_string(uint32_t hash, const char *s)
+{
+    while (*s) {
+        hash = (hash ^ uint8_t(*s++)) * 16777619U;
+    }
+    return hash;
+}
+
+// file name of a script without its directory
+static const char *script_basename(const char *src)
+{
+    const char *slash = strrchr(src, '/');
+    return slash != nullptr ? slash + 1 : src;
+}
+
+lua_profiler::lua_profiler()
+{
+    entries = NEW_NOTHROW entry[LUA_PROFILER_MAX_ENTRIES] {};
+}
+
+lua_profiler::~lua_profiler()
+{
+    delete[] entries;
+}
+
+// start a script run with a budget of vm_steps instructions
+int lua_profiler::start_run(int32_t vm_steps)
+{
+    steps_remaining = vm_steps;
+    call_depth = 0;
+    last_sample_us = AP_HAL::micros();
+    last_sample_alloc = allocated_bytes;
+
+    // each sample stands for LUA_PROFILER_SAMPLE_STEPS instructions,
+    // so starting at a random point gives scripts which run fewer
+    // instructions than that the right share of samples on average
+    sample_steps = MIN(int32_t(1 + get_random16() % LUA_PROFILER_SAMPLE_STEPS), steps_remaining);
+    return sample_steps;
+}
+
+// find or add the entry for prefix followed by name and line, returns nullptr if the table is full
+lua_profiler::entry *lua_profiler::find_entry(const char *prefix, const char *name, int line)
+{
+    if (entries == nullptr) {
+        return nullptr;
+    }
+    uint32_t key = hash_string(hash_string(2166136261U, prefix), name);
+    key = (key ^ uint32_t(line)) * 16777619U;
+    if (key == 0) {
+        // zero marks an empty entry
+        key = 1;
+    }
+
+    // open addressing, the table is never cleared so entries are
+    // never removed
+    for (uint16_t i=0; i<LUA_PROFILER_MAX_ENTRIES; i++) {
+        entry &e = entries[(key + i) % LUA_PROFILER_MAX_ENTRIES];
+        if (e.key == key) {
+            return &e;
+        }
+        if (e.key == 0) {
+            memset(&e, 0, sizeof(e));
+            e.key = key;
+            if (line >= 0) {
+                hal.util->snprintf(e.name, sizeof(e.name), "%s%s:%d", prefix, name, line);
+            } else {
+                hal.util->snprintf(e.name, sizeof(e.name), "%s%s", prefix, name);
+            }
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+// record a sample of the line being run
+void lua_profiler::sample(lua_State *L, lua_Debug *ar)
+{
+    const uint32_t now_us = AP_HAL::micros();
+    const uint32_t alloc = allocated_bytes;
+
+    if (lua_getinfo(L, "Sln", ar)) {
+        char prefix[LUA_PROFILER_NAME_LEN];
+        hal.util->snprintf(prefix, sizeof(prefix), "%s:", script_basename(ar->short_src));
+        const char *func = ar->name;
+        if (func == nullptr) {
+            func = (strcmp(ar->what, "main") == 0) ? "main" : "?";
+        }
+
+        WITH_SEMAPHORE(_sem);
+        entry *e = find_entry(prefix, func, ar->currentline);
+        if (e != nullptr) {
+            e->instructions += LUA_PROFILER_SAMPLE_STEPS;
+            e->time_us += now_us - last_sample_us;
+            e->alloc_bytes += alloc - last_sample_alloc;
+            e->calls++;
+        } else {
+            dropped++;
+        }
+    }
+
+    last_sample_us = now_us;
+    last_sample_alloc = alloc;
+}
+
+// handle a hook event, returns true if the script has used all of its instructions
+bool lua_profiler::hook(lua_State *L, lua_Debug *ar)
+{
+    switch (ar->event) {
+    case LUA_HOOKCOUNT: {
+        steps_remaining -= sample_steps;
+        sample(L, ar);
+        if (steps_remaining <= 0) {
+            return true;
+        }
+        const int32_t next_steps = MIN(steps_remaining, int32_t(LUA_PROFILER_SAMPLE_STEPS));
+        if (next_steps != sample_steps) {
+            sample_steps = next_steps;
+            lua_sethook(L, lua_gethook(L), hook_mask, sample_steps);
+        }
+        break;
+    }
+
+    case LUA_HOOKCALL: {
+        // only bindings are timed
+        if (call_depth >= LUA_PROFILER_MAX_DEPTH ||
+            !lua_getinfo(L, "S", ar) || ar->what[0] != 'C' ||
+            !lua_getinfo(L, "n", ar)) {
+            break;
+        }
+        WITH_SEMAPHORE(_sem);
+        binding_call &c = calls[call_depth];
+        c.e = find_entry("C:", ar->name != nullptr ? ar->name : "?", -1);
+        if (c.e == nullptr) {
+            dropped++;
+            break;
+        }
+        c.ci = ar->i_ci;
+        c.start_us = AP_HAL::micros();
+        c.start_alloc = allocated_bytes;
+        call_depth++;
+        break;
+    }
+
+    case LUA_HOOKRET:
+        // a binding which raised an error never returns, so look
+        // past the top of the stack for the call
+        for (int8_t i=call_depth-1; i>=0; i--) {
+            const binding_call &c = calls[i];
+            if (c.ci != ar->i_ci) {
+                continue;
+            }
+            WITH_SEMAPHORE(_sem);
+            c.e->time_us += AP_HAL::micros() - c.start_us;
+            c.e->alloc_bytes += allocated_bytes - c.start_alloc;
+            c.e->calls++;
+            call_depth = i;
+            break;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+// log all entries
+void lua_profiler::write_log()
+{
+#if HAL_LOGGING_ENABLED
+    if (entries == nullptr) {
+        return;
+    }
+    const uint64_t now_us = AP_HAL::micros64();
+    WITH_SEMAPHORE(_sem);
+    for (uint16_t i=0; i<LUA_PROFILER_MAX_ENTRIES; i++) {
+        const entry &e = entries[i];
+        if (e.key == 0) {
+            continue;
+        }
+        struct log_ScriptingProfile pkt {
+            LOG_PACKET_HEADER_INIT(LOG_SCRIPTING_PROFILE_MSG),
+            time_us      : now_us,
+            name         : {},
+            instructions : e.instructions,
+            time         : e.time_us,
+            alloc        : e.alloc_bytes,
+            calls        : e.calls
+        };
+        strncpy_noterm(pkt.name, e.name, sizeof(pkt.name));
+        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+    }
+#endif
+}
+
+// write a table of all entries to str, most instructions first
+void lua_profiler::report(ExpandingString &str)
+{
+    WITH_SEMAPHORE(_sem);
+    if (entries == nullptr) {
+        str.printf("Profiler out of memory\n");
+        return;
+    }
+    const lua_profiler &p = *this;
+
+    // insertion sort of the used entries
+    uint8_t order[LUA_PROFILER_MAX_ENTRIES];
+    uint8_t n = 0;
+    for (uint8_t i=0; i<LUA_PROFILER_MAX_ENTRIES; i++) {
+        if (p.entries[i].key == 0) {
+            continue;
+        }
+        uint8_t j = n++;
+        while (j > 0) {
+            const entry &prev = p.entries[order[j-1]];
+            if (prev.instructions > p.entries[i].instructions ||
+                (prev.instructions == p.entries[i].instructions && prev.time_us >= p.entries[i].time_us)) {
+                break;
+            }
+            order[j] = order[j-1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    str.printf("%-39s %10s %10s %10s %8s\n", "Name", "Instr", "TimeUS", "Alloc", "Calls");
+    for (uint8_t i=0; i<n; i++) {
+        const entry &e = p.entries[order[i]];
+        str.printf("%-39s %10u %10u %10u %8u\n", e.name,
+                   unsigned(e.instructions), unsigned(e.time_us), unsigned(e.alloc_bytes), unsigned(e.calls));
+    }
+    if (p.dropped != 0) {
+        str.printf("%u samples dropped, table full\n", unsigned(p.dropped));
+    }
+}
+
+#endif  // AP_SCRIPTING_PROFILER_ENABLED
@@ -0,0 +1,123 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "AP_Scripting_config.h"
+
+#if AP_SCRIPTING_PROFILER_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <AP_HAL/Semaphores.h>
+
+#include "lua/src/lua.hpp"
+
+class ExpandingString;
+
+#define LUA_PROFILER_MAX_ENTRIES    64      // number of script:function:line and binding entries
+#define LUA_PROFILER_NAME_LEN       40
+#define LUA_PROFILER_SAMPLE_STEPS   250     // VM instructions between samples
+#define LUA_PROFILER_MAX_DEPTH      8       // depth of nested binding calls tracked
+
+/*
+  sampling profiler for scripts, enabled with SCR_DEBUG_OPTS.
+
+  The instruction count hook used to enforce SCR_VM_I_COUNT is run
+  every LUA_PROFILER_SAMPLE_STEPS instructions instead, and each time
+  it runs the instructions, wall time and heap allocations since the
+  last sample are attributed to the line being run.  The first sample
+  of each run is at a random offset so that scripts which run fewer
+  instructions than the sample period are still profiled fairly.
+
+  Calls into C bindings are timed individually using the call and
+  return hooks.  Binding times include any Lua called back from the
+  binding, and line times include any bindings called since the
+  previous sample.
+ */
+class lua_profiler
+{
+public:
+    lua_profiler();
+    ~lua_profiler();
+
+    CLASS_NO_COPY(lua_profiler);
+
+    // start a script run with a budget of vm_steps instructions,
+    // returns the hook count to use
+    int start_run(int32_t vm_steps);
+
+    // hook mask to use while profiling
+    static constexpr int hook_mask = LUA_MASKCOUNT | LUA_MASKCALL | LUA_MASKRET;
+
+    // handle a hook event, returns true if the script has used all of
+    // its instructions
+    bool hook(lua_State *L, lua_Debug *ar);
+
+    // count memory allocated from the Lua heap
+    void count_alloc(const void *ptr, size_t osize, size_t nsize) {
+        if (ptr == nullptr) {
+            // osize is the type of a new object
+            allocated_bytes += nsize;
+        } else if (nsize > osize) {
+            allocated_bytes += nsize - osize;
+        }
+    }
+
+    // log all entries
+    void write_log();
+
+    // write a table of all entries to str
+    void report(ExpandingString &str);
+
+private:
+
+    struct entry {
+        uint32_t key;
+        uint32_t instructions;
+        uint32_t time_us;
+        uint32_t alloc_bytes;
+        uint32_t calls;             // number of calls for bindings, samples for lines
+        char name[LUA_PROFILER_NAME_LEN];
+    };
+
+    // find or add the entry for a name, returns nullptr if the table is full
+    entry *find_entry(const char *prefix, const char *name, int line);
+
+    // record a sample of the line being run
+    void sample(lua_State *L, lua_Debug *ar);
+
+    entry *entries;
+    uint32_t dropped;               // samples and calls not recorded as the table was full
+
+    int32_t steps_remaining;        // instructions left for this run
+    int32_t sample_steps;           // instructions counted by the next sample
+    uint32_t last_sample_us;
+    uint32_t last_sample_alloc;
+
+    // bindings being run
+    struct binding_call {
+        const void *ci;
+        entry *e;
+        uint32_t start_us;
+        uint32_t start_alloc;
+    } calls[LUA_PROFILER_MAX_DEPTH];
+    uint8_t call_depth;
+
+    uint32_t allocated_bytes;
+
+    // protects entries from report()
+    HAL_Semaphore _sem;
+};
+
+#endif  // AP_SCRIPTING_PROFILER_ENABLED
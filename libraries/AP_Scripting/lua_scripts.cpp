@@ -21,6 +21,7 @@
 #include <AP_HAL/AP_HAL.h>
 #include "AP_Scripting.h"
 #include <AP_Logger/AP_Logger.h>
+#include <AP_Common/ExpandingString.h>
 
 #include <AP_Scripting/lua_generated_bindings.h>
 
@@ -29,7 +30,6 @@
 extern const AP_HAL::HAL& hal;
 #define ENABLE_DEBUG_MODULE 0
 
-bool lua_scripts::overtime;
 char *lua_scripts::error_msg_buf;
 HAL_Semaphore lua_scripts::error_msg_buf_sem;
 uint8_t lua_scripts::print_error_count;
@@ -39,6 +39,11 @@ uint32_t lua_scripts::loaded_checksum;
 uint32_t lua_scripts::running_checksum;
 HAL_Semaphore lua_scripts::crc_sem;
 
+lua_scripts *lua_scripts::running_vms[AP_SCRIPTING_MAX_VMS];
+HAL_Semaphore lua_scripts::running_vms_sem;
+bool lua_scripts::multiple_vms;
+HAL_Semaphore lua_scripts::binding_sem;
+
 // return string error message for error object at top of stack
 static const char *get_error_object_message(lua_State *L) {
     const char *m = lua_tostring(L, -1);
@@ -48,12 +53,13 @@ static const char *get_error_object_message(lua_State *L) {
     return m;
 }
 
-lua_scripts::lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, AP_Int8 &debug_options)
-    : _vm_steps(vm_steps),
+lua_scripts::lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, AP_Int8 &debug_options, uint8_t vm)
+    : _vm(vm),
+      _vm_steps(vm_steps),
       _debug_options(debug_options)
 {
     const bool allow_heap_expansion = !option_is_set(AP_Scripting::DebugOption::DISABLE_HEAP_EXPANSION);
-    _heap.create(heap_size, 10, allow_heap_expansion, 20*1024);
+    _heap.create(heap_size, 10, allow_heap_expansion, 20*1024, true);
 }
 
 lua_scripts::~lua_scripts() {
@@ -61,7 +67,17 @@ lua_scripts::~lua_scripts() {
 }
 
 void lua_scripts::hook(lua_State *L, lua_Debug *ar) {
-    lua_scripts::overtime = true;
+    lua_scripts *ls = ls_object_from_state(L);
+#if AP_SCRIPTING_PROFILER_ENABLED
+    // when profiling the hook runs more often, but still ends the
+    // script once it has used all of its instructions
+    lua_profiler *profiler = ls->_profiler;
+    if (profiler != nullptr && !ls->overtime && !profiler->hook(L, ar)) {
+        return;
+    }
+#endif
+
+    ls->overtime = true;
 
     // we need to aggressively bail out as we are over time
     // so we will aggressively trap errors until we clear out
@@ -86,10 +102,8 @@ void lua_scripts::set_and_print_new_error_message(MAV_SEVERITY severity, const c
 
     // reset buffer and print count
     print_error_count = 0;
-    if (error_msg_buf) {
-        _heap.deallocate(error_msg_buf);
-        error_msg_buf = nullptr;
-    }
+    delete[] error_msg_buf;
+    error_msg_buf = nullptr;
 
     // generate va_list and create a copy
     va_list arg_list, arg_list_copy;
@@ -109,8 +123,8 @@ void lua_scripts::set_and_print_new_error_message(MAV_SEVERITY severity, const c
         return;
     }
 
-    // allocate buffer on scripting heap
-    error_msg_buf = (char *)_heap.allocate(len+1);
+    // allocate buffer outside of the scripting heaps as it is shared by all VMs
+    error_msg_buf = NEW_NOTHROW char[len+1];
     if (!error_msg_buf) {
         // allocation failed
         va_end(arg_list);
@@ -303,6 +317,7 @@ void lua_scripts::load_all_scripts_in_dir(lua_State *L, const char *dirname) {
             continue;
         }
         reschedule_script(script); // reschedule if load succeeded
+        stats.scripts++;
 
 #if HAL_LOGGER_FILE_CONTENTS_ENABLED
         if (!option_is_set(AP_Scripting::DebugOption::SUPPRESS_SCRIPT_LOG)) {
@@ -317,6 +332,12 @@ void lua_scripts::reset_loop_overtime(lua_State *L) {
     overtime = false;
     // reset the hook to clear the counter
     const int32_t vm_steps = MAX(_vm_steps, 1000);
+#if AP_SCRIPTING_PROFILER_ENABLED
+    if (_profiler != nullptr) {
+        lua_sethook(L, hook, lua_profiler::hook_mask, _profiler->start_run(vm_steps));
+        return;
+    }
+#endif
     lua_sethook(L, hook, LUA_MASKCOUNT, vm_steps);
 }
 
@@ -342,7 +363,7 @@ void lua_scripts::run_next_script(lua_State *L) {
     // pop the function to the top of the stack
     lua_rawgeti(L, LUA_REGISTRYINDEX, script->run_ref);
     // set current environment for other users
-    AP::scripting()->set_current_env_ref(script->env_ref);
+    current_env_ref = script->env_ref;
 
     if(lua_pcall(L, 0, LUA_MULTRET, 0)) {
         if (overtime) {
@@ -428,6 +449,7 @@ void lua_scripts::remove_script(lua_State *L, script_info *script) {
         // state will be nullptr when we are tearing down
         luaL_unref(L, LUA_REGISTRYINDEX, script->env_ref);
         luaL_unref(L, LUA_REGISTRYINDEX, script->run_ref);
+        stats.scripts--;
     }
     _heap.deallocate(script->name);
     _heap.deallocate(script);
@@ -468,11 +490,14 @@ void lua_scripts::reschedule_script(script_info *script) {
     previous->next = script;
 }
 
-MultiHeap lua_scripts::_heap;
-
 void *lua_scripts::alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
-    (void)ud; /* not used */
-    return _heap.change_size(ptr, osize, nsize);
+    lua_scripts *ls = static_cast<lua_scripts *>(ud);
+#if AP_SCRIPTING_PROFILER_ENABLED
+    if (ls->_profiler != nullptr) {
+        ls->_profiler->count_alloc(ptr, osize, nsize);
+    }
+#endif
+    return ls->_heap.change_size(ptr, osize, nsize);
 }
 
 void lua_scripts::run(void) {
@@ -481,7 +506,7 @@ void lua_scripts::run(void) {
         return;
     }
 
-    lua_State *L = lua_newstate(alloc, NULL);
+    lua_State *L = lua_newstate(alloc, this);
     if (L == nullptr) {
         GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Lua: Couldn't allocate a lua state");
         return;
@@ -490,6 +515,17 @@ void lua_scripts::run(void) {
     // (see ls_object_from_state)
     *static_cast<lua_scripts**>(lua_getextraspace(L)) = this;
 
+#if AP_SCRIPTING_PROFILER_ENABLED
+    if (option_is_set(AP_Scripting::DebugOption::PROFILE)) {
+        _profiler = NEW_NOTHROW lua_profiler();
+    }
+#endif
+
+    {
+        WITH_SEMAPHORE(running_vms_sem);
+        running_vms[_vm] = this;
+    }
+
     // call main engine function in protected mode now that Lua itself is ready.
     // this catches any errors raised by the code between here and Lua scripts.
     // our current function must not use any Lua API which can raise an error!
@@ -498,24 +534,44 @@ void lua_scripts::run(void) {
         set_and_print_new_error_message(MAV_SEVERITY_CRITICAL,
             "Engine Error: %s", get_error_object_message(L));
     }
+    release_binding_lock();
     // we are now finished with Lua, tear everything down
 
+    {
+        WITH_SEMAPHORE(running_vms_sem);
+        running_vms[_vm] = nullptr;
+    }
+
     lua_close(L); // shut down the state
     L = nullptr;
 
+#if AP_SCRIPTING_PROFILER_ENABLED
+    delete _profiler;
+    _profiler = nullptr;
+#endif
+
     while (scripts != nullptr) { // remove all scripts from the engine list
         remove_script(nullptr, scripts);
     }
 
-    // free error message
-    error_msg_buf_sem.take_blocking();
-    if (error_msg_buf != nullptr) {
-        _heap.deallocate(error_msg_buf);
-        error_msg_buf = nullptr;
+    // heap is now empty
+}
+
+// release the binding lock if a Lua error was raised while it was held
+void lua_scripts::release_binding_lock()
+{
+    while (binding_lock_count > 0) {
+        binding_lock_count--;
+        binding_sem.give();
     }
-    error_msg_buf_sem.give();
+}
 
-    // heap is now empty
+// free the last error message, called once all VMs have stopped
+void lua_scripts::clear_error_message()
+{
+    WITH_SEMAPHORE(error_msg_buf_sem);
+    delete[] error_msg_buf;
+    error_msg_buf = nullptr;
 }
 
 int lua_scripts::run_engine(lua_State *L) {
@@ -541,16 +597,26 @@ int lua_scripts::run_engine(lua_State *L) {
     // Skip those directores disabled with SCR_DIR_DISABLE param
     uint16_t dir_disable = AP_Scripting::get_singleton()->get_disabled_dir();
     bool loaded = false;
-    if ((dir_disable & uint16_t(AP_Scripting::SCR_DIR::SCRIPTS)) == 0) {
-        load_all_scripts_in_dir(L, SCRIPTING_DIRECTORY);
+    if (_vm != 0) {
+        // additional VMs each have their own directory
+        if ((dir_disable & uint16_t(AP_Scripting::SCR_DIR::SCRIPTS)) == 0) {
+            char dirname[sizeof(SCRIPTING_DIRECTORY) + 5];
+            hal.util->snprintf(dirname, sizeof(dirname), SCRIPTING_DIRECTORY "/vm%u", unsigned(_vm));
+            load_all_scripts_in_dir(L, dirname);
+        }
         loaded = true;
-    }
+    } else {
+        if ((dir_disable & uint16_t(AP_Scripting::SCR_DIR::SCRIPTS)) == 0) {
+            load_all_scripts_in_dir(L, SCRIPTING_DIRECTORY);
+            loaded = true;
+        }
 #ifdef HAL_HAVE_AP_ROMFS_EMBEDDED_LUA
-    if ((dir_disable & uint16_t(AP_Scripting::SCR_DIR::ROMFS)) == 0) {
-        load_all_scripts_in_dir(L, "@ROMFS/scripts");
-        loaded = true;
-    }
+        if ((dir_disable & uint16_t(AP_Scripting::SCR_DIR::ROMFS)) == 0) {
+            load_all_scripts_in_dir(L, "@ROMFS/scripts");
+            loaded = true;
+        }
 #endif
+    }
     if (!loaded) {
         GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Lua: All directory's disabled see SCR_DIR_DISABLE");
     }
@@ -604,6 +670,9 @@ int lua_scripts::run_engine(lua_State *L) {
             // anything that was in *scripts after this call.
             run_next_script(L);
 
+            // a binding may have raised an error while holding the binding lock
+            release_binding_lock();
+
             const uint32_t runEnd = AP_HAL::micros();
             const int endMem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
 
@@ -613,6 +682,18 @@ int lua_scripts::run_engine(lua_State *L) {
 
             update_stats(script_name, runEnd - loadEnd, endMem, endMem - startMem);
 
+            stats.runs++;
+            stats.run_time_us += runEnd - loadEnd;
+            stats.max_run_time_us = MAX(stats.max_run_time_us, runEnd - loadEnd);
+            stats.mem = endMem;
+
+#if AP_SCRIPTING_PROFILER_ENABLED
+            if (_profiler != nullptr && AP_HAL::millis() - _profile_log_ms > 10000) {
+                _profile_log_ms = AP_HAL::millis();
+                _profiler->write_log();
+            }
+#endif
+
 
             // garbage collect after each script, this shouldn't matter, but seems to resolve a memory leak
             lua_gc(L, LUA_GCCOLLECT, 0);
@@ -635,9 +716,10 @@ int lua_scripts::run_engine(lua_State *L) {
             set_and_print_new_error_message(MAV_SEVERITY_WARNING, "Required SCR_HEAP_SIZE over %u", unsigned(expansion_size));
         }
 
-        // re-print the latest error message every 10 seconds 10 times
+        // re-print the latest error message every 10 seconds 10 times,
+        // the message is shared so only the first VM prints it
         const uint8_t error_prints = 10;
-        if ((print_error_count < error_prints) && (AP_HAL::millis() - last_print_ms > 10000)) {
+        if ((_vm == 0) && (print_error_count < error_prints) && (AP_HAL::millis() - last_print_ms > 10000)) {
             // note that we do not clear the buffer after we have finished printing, this allows it to be used for a pre-arm check
             print_error(MAV_SEVERITY_DEBUG);
             print_error_count++;
@@ -647,6 +729,35 @@ int lua_scripts::run_engine(lua_State *L) {
     return 0; // no results
 }
 
+// write statistics and profile of each running VM to str
+void lua_scripts::info(ExpandingString &str)
+{
+    WITH_SEMAPHORE(running_vms_sem);
+    for (uint8_t i=0; i<AP_SCRIPTING_MAX_VMS; i++) {
+        lua_scripts *ls = running_vms[i];
+        if (ls == nullptr) {
+            continue;
+        }
+        str.printf("VM%u: %u scripts, %u runs, avg %u us, max %u us, mem %u\n",
+                   unsigned(i),
+                   unsigned(ls->stats.scripts),
+                   unsigned(ls->stats.runs),
+                   unsigned(ls->stats.runs > 0 ? ls->stats.run_time_us / ls->stats.runs : 0),
+                   unsigned(ls->stats.max_run_time_us),
+                   unsigned(ls->stats.mem));
+#if AP_MULTIHEAP_SLAB_ENABLED
+        ls->_heap.slab_info(str);
+#endif
+#if AP_SCRIPTING_PROFILER_ENABLED
+        if (ls->_profiler != nullptr) {
+            ls->_profiler->report(str);
+        } else {
+            str.printf("Profiling disabled, set SCR_DEBUG_OPTS bit 7 and restart scripting\n");
+        }
+#endif
+    }
+}
+
 // Return the file checksums of running and loaded scripts
 uint32_t lua_scripts::get_loaded_checksum()
 {
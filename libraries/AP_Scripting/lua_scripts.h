@@ -28,6 +28,7 @@
 #include <AP_HAL/Semaphores.h>
 #include <AP_MultiHeap/AP_MultiHeap.h>
 #include "lua_common_defs.h"
+#include "lua_profiler.h"
 
 #include "lua/src/lua.hpp"
 
@@ -42,7 +43,7 @@ static inline lua_scripts* ls_object_from_state(lua_State *L) {
 class lua_scripts
 {
 public:
-    lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, AP_Int8 &debug_options);
+    lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, AP_Int8 &debug_options, uint8_t vm);
 
     ~lua_scripts();
 
@@ -54,7 +55,35 @@ public:
     // run scripts, does not return unless an error occured
     void run(void);
 
-    static bool overtime; // script exceeded it's execution slot, and we are bailing out
+    // write statistics and profile of each running VM to str
+    static void info(ExpandingString &str);
+
+    // bindings which use state shared between VMs must hold this
+    // lock, it is only taken if more than one VM is in use. If a Lua
+    // error is raised while it is held it is released once the
+    // script has finished running
+    static void set_multiple_vms(bool multiple) { multiple_vms = multiple; }
+    static void binding_lock(lua_State *L) {
+        if (multiple_vms) {
+            binding_sem.take_blocking();
+            ls_object_from_state(L)->binding_lock_count++;
+        }
+    }
+    static void binding_unlock(lua_State *L) {
+        if (multiple_vms) {
+            ls_object_from_state(L)->binding_lock_count--;
+            binding_sem.give();
+        }
+    }
+
+    // index of this VM
+    uint8_t get_vm() const { return _vm; }
+
+    // environment of the script being run, for require
+    int get_current_env_ref() const { return current_env_ref; }
+
+    // free the last error message
+    static void clear_error_message();
 
 private:
 
@@ -88,6 +117,19 @@ private:
     void reschedule_script(script_info *script);
 
     script_info *scripts; // linked list of scripts to be run, sorted by next run time (soonest first)
+    int current_env_ref;  // environment of the script being run
+
+    const uint8_t _vm;    // index of this VM, VMs other than the first load scripts from SCRIPTING_DIRECTORY/vmN
+    bool overtime;        // script exceeded it's execution slot, and we are bailing out
+
+    // run statistics of this VM
+    struct {
+        uint16_t scripts;
+        uint32_t runs;
+        uint64_t run_time_us;
+        uint32_t max_run_time_us;
+        uint32_t mem;
+    } stats;
 
     // hook will be run when CPU time for a script is exceeded
     // it must be static to be passed to the C API
@@ -102,7 +144,13 @@ private:
 
     static void *alloc(void *ud, void *ptr, size_t osize, size_t nsize);
 
-    static MultiHeap _heap;
+    MultiHeap _heap;
+
+#if AP_SCRIPTING_PROFILER_ENABLED
+    // profiler, only allocated if enabled in SCR_DEBUG_OPTS
+    lua_profiler *_profiler;
+    uint32_t _profile_log_ms;
+#endif
 
     // helper for print and log of runtime stats
     void update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem);
@@ -114,6 +162,17 @@ private:
     static uint8_t print_error_count;
     static uint32_t last_print_ms;
 
+    // running VMs, for info()
+    static lua_scripts *running_vms[AP_SCRIPTING_MAX_VMS];
+    static HAL_Semaphore running_vms_sem;
+
+    static bool multiple_vms;
+    static HAL_Semaphore binding_sem;
+
+    // number of times this VM holds the binding lock
+    uint8_t binding_lock_count;
+    void release_binding_lock();
+
     // XOR of crc32 of running scripts
     static uint32_t loaded_checksum;
     static uint32_t running_checksum;
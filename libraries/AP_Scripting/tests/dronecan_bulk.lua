@@ -0,0 +1,45 @@
+--[[
+   flood the first DroneCAN driver with lowest priority broadcasts, as
+   bulk traffic such as a firmware update would, so the TX queue
+   budgets can be checked while flying on DroneCAN ESCs
+--]]
+
+local MAGNETICFIELDSTRENGTHHIRES_ID = 1043
+local MAGNETICFIELDSTRENGTHHIRES_SIGNATURE = uint64_t(0x3053EBE3, 0xD750286F)
+local CANARD_TRANSFER_PRIORITY_LOWEST = 31
+
+local MAV_SEVERITY = {EMERGENCY=0, ALERT=1, CRITICAL=2, ERROR=3, WARNING=4, NOTICE=5, INFO=6, DEBUG=7}
+
+local handle = DroneCAN_Handle(0, MAGNETICFIELDSTRENGTHHIRES_SIGNATURE, MAGNETICFIELDSTRENGTHHIRES_ID)
+if not handle then
+  error("no DroneCAN driver")
+end
+handle:priority(CANARD_TRANSFER_PRIORITY_LOWEST)
+
+-- a multi-frame transfer
+local payload = string.pack("Bfff", 7, 1, 2, 3)
+
+local sent = 0
+local rejected = 0
+local last_report_ms = millis()
+
+local function update()
+  -- far more than the bus can take in 10ms
+  for _ = 1, 100 do
+    if handle:broadcast(payload) then
+      sent = sent + 1
+    else
+      rejected = rejected + 1
+    end
+  end
+  local now_ms = millis()
+  if now_ms - last_report_ms > 5000 then
+    last_report_ms = now_ms
+    gcs:send_text(MAV_SEVERITY.INFO, string.format("DroneCAN bulk: sent %d rejected %d", sent, rejected))
+  end
+  return update, 10
+end
+
+gcs:send_text(MAV_SEVERITY.INFO, "DroneCAN bulk: started")
+
+return update()
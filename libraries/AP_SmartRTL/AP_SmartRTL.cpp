@@ -30,8 +30,8 @@ const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
 
     // @Param: POINTS
     // @DisplayName: SmartRTL maximum number of points on path
-    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL.  100 points consumes about 3k of memory.
-    // @Range: 0 500
+    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL.  100 points consumes about 3k of memory.  Boards with less than 1MB of flash support at most 500 points.
+    // @Range: 0 5000
     // @User: Advanced
     // @RebootRequired: True
     AP_GROUPINFO("POINTS", 1, AP_SmartRTL, _points_max, SMARTRTL_POINTS_DEFAULT),
@@ -67,6 +67,12 @@ const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
 *    2. Simplification uses the Ramer-Douglas-Peucker algorithm. See Wikipedia
 *    for a more complete description.
 *
+*    Pruning only compares segments which are near each other: the segments
+*    are held in a uniform grid and each segment is compared with those in the
+*    grid cells it covers.  Simplification only checks points added since it
+*    last completed.  This keeps the cost of each new point roughly independent
+*    of the length of the path.
+*
 *    The simplification and pruning algorithms run in the background and do not
 *    alter the path in memory.  Two definitions, SMARTRTL_SIMPLIFY_TIME_US and
 *    SMARTRTL_PRUNING_LOOP_TIME_US are used to limit how long each algorithm will
@@ -88,6 +94,7 @@ AP_SmartRTL::AP_SmartRTL(bool example_mode) :
 {
     AP_Param::setup_object_defaults(this, var_info);
     _simplify.bitmask.setall();
+    _simplify.removal_start = UINT16_MAX;
 }
 
 // initialise safe rtl including setting up background processes
@@ -127,6 +134,21 @@ void AP_SmartRTL::init()
 
     _path_points_max = _points_max;
 
+    // allocate the segment index, up to two points per bucket.  If this fails loop detection compares every pair of segments
+    _segment_index.buckets_max = 16;
+    while (_segment_index.buckets_max < _path_points_max / 2) {
+        _segment_index.buckets_max *= 2;
+    }
+    _segment_index.entries_max = _path_points_max * SMARTRTL_SEGMENT_INDEX_ENTRIES_MULT;
+    _segment_index.bucket_start = (uint16_t*)calloc(_segment_index.buckets_max + 2, sizeof(uint16_t));
+    _segment_index.entries = (uint16_t*)calloc(_segment_index.entries_max, sizeof(uint16_t));
+    if (_segment_index.bucket_start == nullptr || _segment_index.entries == nullptr) {
+        free(_segment_index.bucket_start);
+        free(_segment_index.entries);
+        _segment_index.bucket_start = nullptr;
+        _segment_index.entries = nullptr;
+    }
+
     // when running the example sketch, we want the cleanup tasks to run when we tell them to, not in the background (so that they can be timed.)
     if (!_example_mode){
         // register background cleanup to run in IO thread
@@ -552,6 +574,9 @@ void AP_SmartRTL::detect_simplifications()
                 _simplify.bitmask.clear(i);
                 _simplify.removal_required = true;
             }
+            if (start_index + 1 < _simplify.removal_start) {
+                _simplify.removal_start = start_index + 1;
+            }
         }
     }
     _simplify.path_points_completed = _simplify.path_points_count;
@@ -562,6 +587,8 @@ void AP_SmartRTL::detect_simplifications()
 *   This method runs for the allotted time, and detects loops in a path. Any detected loops are added to _prune.loops,
 *   this function does not alter the path in memory. It works by comparing the line segment between any two sequential points
 *   to the line segment between any other two sequential points. If they get close enough, anything between them could be pruned.
+*   Each segment is paired with the earliest segment that comes close to it.  When the segment index is available only the
+*   segments near each segment are compared, otherwise every pair of segments is compared.  Both find the same loops.
 *
 *   reset_pruning should have been called at least once before this function is called to setup the indexes (_prune.i, etc)
 */
@@ -576,6 +603,28 @@ void AP_SmartRTL::detect_loops()
     // capture start time
     const uint32_t start_time_us = AP_HAL::micros();
 
+    if (segment_index_ready()) {
+        // check a whole segment at a time
+        _prune.j = 0;
+        while (AP_HAL::micros() - start_time_us < SMARTRTL_PRUNING_LOOP_TIME_US) {
+            uint16_t loop_start;
+            Vector3f midpoint;
+            if (find_loop_to_segment(_prune.i, loop_start, midpoint) && !add_loop(loop_start, _prune.i-1, midpoint)) {
+                // if the buffer is full, stop trying to prune
+                _prune.complete = true;
+                return;
+            }
+            // move to the next segment, complete when there are no new segments to check
+            _prune.i--;
+            if (_prune.i < 4 || _prune.i < _prune.path_points_completed) {
+                _prune.complete = true;
+                _prune.path_points_completed = _prune.path_points_count;
+                return;
+            }
+        }
+        return;
+    }
+
     // run for defined amount of time
     while (AP_HAL::micros() - start_time_us < SMARTRTL_PRUNING_LOOP_TIME_US) {
 
@@ -608,6 +657,160 @@ void AP_SmartRTL::detect_loops()
     }
 }
 
+// returns true if the segment index holds the segments checked by the current loop search, building it if necessary
+bool AP_SmartRTL::segment_index_ready()
+{
+    if (_segment_index.state == SegmentIndexState::NEEDS_BUILD) {
+        _segment_index.state = build_segment_index() ? SegmentIndexState::READY : SegmentIndexState::FAILED;
+    }
+    return _segment_index.state == SegmentIndexState::READY;
+}
+
+// index segments 1 to _prune.path_points_count-1 so each segment is only compared with those near it
+// returns false if the index could not be built
+bool AP_SmartRTL::build_segment_index()
+{
+    // comparing every pair of segments is quicker for short paths or when only a few new segments need checking
+    const uint16_t num_points = _prune.path_points_count;
+    if ((_segment_index.bucket_start == nullptr) || (num_points < SMARTRTL_SEGMENT_INDEX_POINTS_MIN) ||
+        (num_points < _prune.path_points_completed + SMARTRTL_SEGMENT_INDEX_NEW_POINTS_MIN)) {
+        return false;
+    }
+
+    // roughly two points per bucket
+    _segment_index.num_buckets = 16;
+    while ((_segment_index.num_buckets < num_points / 2) && (_segment_index.num_buckets < _segment_index.buckets_max)) {
+        _segment_index.num_buckets *= 2;
+    }
+
+    // cells at least as large as the average segment so most segments are held in four cells or fewer
+    float length_sum = 0.0f;
+    for (uint16_t j = 1; j < num_points; j++) {
+        length_sum += (_path[j] - _path[j-1]).xy().length();
+    }
+    float cell_size = MAX(length_sum / (num_points - 1), SMARTRTL_PRUNING_DELTA * 2);
+
+    // count the segments in each bucket, using larger cells if they do not fit
+    uint32_t total = 0;
+    for (uint8_t attempt = 0; attempt < 4; attempt++) {
+        _segment_index.cell_size_inv = 1.0f / cell_size;
+        memset(_segment_index.bucket_start, 0, (_segment_index.num_buckets + 2) * sizeof(uint16_t));
+        total = 0;
+        for (uint16_t j = 1; j < num_points && total <= _segment_index.entries_max; j++) {
+            int32_t x_min, y_min, x_max, y_max;
+            const uint32_t num_cells = segment_cells(_path[j-1], _path[j], 0.0f, x_min, y_min, x_max, y_max);
+            if (num_cells > SMARTRTL_SEGMENT_INDEX_CELLS_MAX) {
+                _segment_index.bucket_start[_segment_index.num_buckets]++;
+                total++;
+                continue;
+            }
+            for (int32_t x = x_min; x <= x_max; x++) {
+                for (int32_t y = y_min; y <= y_max; y++) {
+                    _segment_index.bucket_start[segment_index_bucket(x, y)]++;
+                }
+            }
+            total += num_cells;
+        }
+        if (total <= _segment_index.entries_max) {
+            break;
+        }
+        cell_size *= 2;
+    }
+    if (total > _segment_index.entries_max) {
+        return false;
+    }
+
+    // convert counts to the end of each bucket's segments
+    for (uint16_t b = 1; b <= _segment_index.num_buckets; b++) {
+        _segment_index.bucket_start[b] += _segment_index.bucket_start[b-1];
+    }
+    _segment_index.bucket_start[_segment_index.num_buckets + 1] = total;
+
+    // fill each bucket from its end, leaving bucket_start at the start of each bucket
+    for (uint16_t j = 1; j < num_points; j++) {
+        int32_t x_min, y_min, x_max, y_max;
+        const uint32_t num_cells = segment_cells(_path[j-1], _path[j], 0.0f, x_min, y_min, x_max, y_max);
+        if (num_cells > SMARTRTL_SEGMENT_INDEX_CELLS_MAX) {
+            _segment_index.entries[--_segment_index.bucket_start[_segment_index.num_buckets]] = j;
+            continue;
+        }
+        for (int32_t x = x_min; x <= x_max; x++) {
+            for (int32_t y = y_min; y <= y_max; y++) {
+                _segment_index.entries[--_segment_index.bucket_start[segment_index_bucket(x, y)]] = j;
+            }
+        }
+    }
+
+    return true;
+}
+
+// grid cells covered by the horizontal bounding box of a line, expanded by margin
+// returns the number of cells covered
+uint32_t AP_SmartRTL::segment_cells(const Vector3f &p1, const Vector3f &p2, float margin, int32_t &x_min, int32_t &y_min, int32_t &x_max, int32_t &y_max) const
+{
+    // cell coordinates are limited so that the number of cells cannot overflow
+    const float cell_limit = 1.0e4f;
+    const float inv = _segment_index.cell_size_inv;
+    x_min = (int32_t)floorf(constrain_float((MIN(p1.x, p2.x) - margin) * inv, -cell_limit, cell_limit));
+    x_max = (int32_t)floorf(constrain_float((MAX(p1.x, p2.x) + margin) * inv, -cell_limit, cell_limit));
+    y_min = (int32_t)floorf(constrain_float((MIN(p1.y, p2.y) - margin) * inv, -cell_limit, cell_limit));
+    y_max = (int32_t)floorf(constrain_float((MAX(p1.y, p2.y) + margin) * inv, -cell_limit, cell_limit));
+    return uint32_t(x_max - x_min + 1) * uint32_t(y_max - y_min + 1);
+}
+
+// bucket holding a grid cell
+uint16_t AP_SmartRTL::segment_index_bucket(int32_t x, int32_t y) const
+{
+    return ((uint32_t(x) * 73856093U) ^ (uint32_t(y) * 19349663U)) & (_segment_index.num_buckets - 1);
+}
+
+// find the first segment which comes close to segment i (the line from point i-1 to point i)
+// segment j is the line from point j-1 to point j, only segments 1 to i-2 are checked
+// returns true and the segment and midpoint of the closest approach if one was found
+bool AP_SmartRTL::find_loop_to_segment(uint16_t i, uint16_t &loop_start, Vector3f &midpoint) const
+{
+    // segments before first_found which come close to segment i, first_found is i-1 if none have been found
+    uint16_t first_found = i - 1;
+    auto check_segment = [&](uint16_t j) {
+        if (j < first_found) {
+            const dist_point dp = segment_segment_dist(_path[i], _path[i-1], _path[j-1], _path[j]);
+            if (dp.distance < SMARTRTL_PRUNING_DELTA) {
+                first_found = j;
+                midpoint = dp.midpoint;
+            }
+        }
+    };
+
+    // a segment can only come within PRUNING_DELTA of segment i if it shares a cell with segment i's expanded bounding box
+    int32_t x_min, y_min, x_max, y_max;
+    const uint32_t num_cells = segment_cells(_path[i-1], _path[i], SMARTRTL_PRUNING_DELTA, x_min, y_min, x_max, y_max);
+    if (num_cells > SMARTRTL_SEGMENT_INDEX_CELLS_MAX) {
+        // long segments are compared with every earlier segment
+        for (uint16_t j = 1; j < first_found; j++) {
+            check_segment(j);
+        }
+    } else {
+        for (int32_t x = x_min; x <= x_max; x++) {
+            for (int32_t y = y_min; y <= y_max; y++) {
+                const uint16_t b = segment_index_bucket(x, y);
+                for (uint16_t k = _segment_index.bucket_start[b]; k < _segment_index.bucket_start[b+1]; k++) {
+                    check_segment(_segment_index.entries[k]);
+                }
+            }
+        }
+        const uint16_t b = _segment_index.num_buckets;
+        for (uint16_t k = _segment_index.bucket_start[b]; k < _segment_index.bucket_start[b+1]; k++) {
+            check_segment(_segment_index.entries[k]);
+        }
+    }
+
+    if (first_found < i - 1) {
+        loop_start = first_found;
+        return true;
+    }
+    return false;
+}
+
 // restart simplify if new points have been added to path
 // path_points_count is _path_points_count but passed in to avoid having to take the semaphore
 void AP_SmartRTL::restart_simplify_if_new_points(uint16_t path_points_count)
@@ -633,6 +836,7 @@ void AP_SmartRTL::restart_simplification(uint16_t path_points_count)
     _simplify.complete = false;
     _simplify.removal_required = false;
     _simplify.bitmask.setall();
+    _simplify.removal_start = UINT16_MAX;
     _simplify.stack_count = 0;
     _simplify.path_points_count = path_points_count;
 }
@@ -651,6 +855,7 @@ void AP_SmartRTL::restart_pruning(uint16_t path_points_count)
     _prune.i = (path_points_count > 0) ? path_points_count - 1 : 0;
     _prune.j = 0;
     _prune.path_points_count = path_points_count;
+    _segment_index.state = SegmentIndexState::NEEDS_BUILD;
 }
 
 // reset pruning algorithm so that it will re-check all points in the path
@@ -668,9 +873,11 @@ void AP_SmartRTL::remove_points_by_simplify_bitmask()
     if (!_path_sem.take_nonblocking()) {
         return;
     }
-    uint16_t dest = 1;
+    // only points checked since simplification last completed can have been flagged
+    const uint16_t first_point = MAX(_simplify.removal_start, 1);
+    uint16_t dest = first_point;
     uint16_t removed = 0;
-    for (uint16_t src = 1; src < _path_points_count; src++) {
+    for (uint16_t src = first_point; src < _path_points_count; src++) {
         if (!_simplify.bitmask.get(src)) {
             log_action(Action::POINT_SIMPLIFY, _path[src]);
             removed++;
@@ -694,7 +901,11 @@ void AP_SmartRTL::remove_points_by_simplify_bitmask()
 
     // flag point removal is complete
     _simplify.bitmask.setall();
+    _simplify.removal_start = UINT16_MAX;
     _simplify.removal_required = false;
+
+    // segments have moved so any loop search in progress needs a new index
+    _segment_index.state = SegmentIndexState::NEEDS_BUILD;
 }
 
 // remove loops until at least num_point_to_delete have been removed from path
@@ -712,47 +923,76 @@ bool AP_SmartRTL::remove_points_by_loops(uint16_t num_points_to_remove)
         return false;
     }
 
-    uint16_t removed_points = 0;
-    uint16_t i = _prune.loops_count;
-    while ((i > 0) && (removed_points < num_points_to_remove)) {
-        i--;
-        prune_loop_t loop = _prune.loops[i];
+    // discard loops which are no longer on the path (because points have been popped)
+    uint16_t loops_count = 0;
+    for (uint16_t i = 0; i < _prune.loops_count; i++) {
+        if ((_prune.loops[i].end_index > _prune.loops[i].start_index) && (_prune.loops[i].end_index < _path_points_count)) {
+            _prune.loops[loops_count++] = _prune.loops[i];
+        }
+    }
+    _prune.loops_count = loops_count;
 
-        // midpoint goes into start_index (this is the end point of the first segment)
-        _path[loop.start_index] = loop.midpoint;
+    // loops are removed from the end of the loops array until enough points have been removed
+    uint16_t removed_points = 0;
+    uint16_t first_loop = _prune.loops_count;
+    while ((first_loop > 0) && (removed_points < num_points_to_remove)) {
+        first_loop--;
+        removed_points += _prune.loops[first_loop].end_index - _prune.loops[first_loop].start_index;
+    }
+    if (removed_points == 0) {
+        _path_sem.give();
+        return true;
+    }
 
-        // shift points after the end of the loop down by the number of points in the loop
-        uint16_t loop_num_points_to_remove = loop.end_index - loop.start_index;
-        for (uint16_t dest = loop.start_index + 1; dest < _path_points_count - loop_num_points_to_remove; dest++) {
-            log_action(Action::POINT_PRUNE, _path[dest]);
-            _path[dest] = _path[dest + loop_num_points_to_remove];
+    // sort the loops being removed by position on the path
+    // loops never overlap (add_loop removes overlapping loops) so each can be removed in turn
+    for (uint16_t i = first_loop + 1; i < _prune.loops_count; i++) {
+        const prune_loop_t loop = _prune.loops[i];
+        uint16_t k = i;
+        while ((k > first_loop) && (_prune.loops[k-1].start_index > loop.start_index)) {
+            _prune.loops[k] = _prune.loops[k-1];
+            k--;
         }
+        _prune.loops[k] = loop;
+    }
 
-        if (_path_points_count > loop_num_points_to_remove) {
-            _path_points_count -= loop_num_points_to_remove;
-            removed_points += loop_num_points_to_remove;
-        } else {
-            // this is an error that should never happen so deactivate
-            deactivate(Action::DEACTIVATED_PROGRAM_ERROR, "program error");
-            _path_sem.give();
-            // we return true so thorough_cleanup does not get stuck
-            return true;
+    // remove the loops in a single pass over the path.  The midpoint goes into
+    // start_index (this is the end point of the first segment) and the points
+    // up to and including end_index are removed
+    uint16_t dest = _prune.loops[first_loop].start_index;
+    uint16_t src = dest;
+    for (uint16_t i = first_loop; i < _prune.loops_count; i++) {
+        const prune_loop_t &loop = _prune.loops[i];
+        while (src < loop.start_index) {
+            _path[dest++] = _path[src++];
         }
-
-        // fix the indices of any existing prune loops
-        // we do not check for overlapping loops because add_loops should have caught them
-        for (uint16_t loop_cnt = 0; loop_cnt < i; loop_cnt++) {
-            if (_prune.loops[loop_cnt].start_index >= loop.end_index) {
-                _prune.loops[loop_cnt].start_index -= loop_num_points_to_remove;
-            }
-            if (_prune.loops[loop_cnt].end_index >= loop.end_index) {
-                _prune.loops[loop_cnt].end_index -= loop_num_points_to_remove;
-            }
+        _path[dest++] = loop.midpoint;
+        for (src = loop.start_index + 1; src <= loop.end_index; src++) {
+            log_action(Action::POINT_PRUNE, _path[src]);
         }
-
-        // remove last prune loop from array
-        _prune.loops_count--;
     }
+    while (src < _path_points_count) {
+        _path[dest++] = _path[src++];
+    }
+    _path_points_count -= removed_points;
+
+    // fix the indices of the remaining prune loops, each moves down by the points removed before it
+    // we do not check for overlapping loops because add_loops should have caught them
+    for (uint16_t loop_cnt = 0; loop_cnt < first_loop; loop_cnt++) {
+        prune_loop_t &remaining = _prune.loops[loop_cnt];
+        uint16_t shift = 0;
+        for (uint16_t i = first_loop; (i < _prune.loops_count) && (_prune.loops[i].end_index <= remaining.start_index); i++) {
+            shift += _prune.loops[i].end_index - _prune.loops[i].start_index;
+        }
+        remaining.start_index -= shift;
+        remaining.end_index -= shift;
+    }
+
+    // remove the pruned loops from the array
+    _prune.loops_count = first_loop;
+
+    // segments have moved so any loop search in progress needs a new index
+    _segment_index.state = SegmentIndexState::NEEDS_BUILD;
 
     _path_sem.give();
     return true;
@@ -7,8 +7,14 @@
 
 // definitions and macros
 #define SMARTRTL_ACCURACY_DEFAULT        2.0f   // default _ACCURACY parameter value.  Points will be no closer than this distance (in meters) together.
-#define SMARTRTL_POINTS_DEFAULT          300    // default _POINTS parameter value.  High numbers improve path pruning but use more memory and CPU for cleanup. Memory used will be 20bytes * this number.
+#define SMARTRTL_POINTS_DEFAULT          300    // default _POINTS parameter value.  High numbers improve path pruning but use more memory and CPU for cleanup. Memory used will be 25bytes * this number.
+#ifndef SMARTRTL_POINTS_MAX
+#if HAL_PROGRAM_SIZE_LIMIT_KB > 1024
+#define SMARTRTL_POINTS_MAX              5000   // the absolute maximum number of points this library can support.
+#else
 #define SMARTRTL_POINTS_MAX              500    // the absolute maximum number of points this library can support.
+#endif
+#endif
 #define SMARTRTL_TIMEOUT                 15000  // the time in milliseconds with no points saved to the path (for whatever reason), before SmartRTL is disabled for the flight
 #define SMARTRTL_CLEANUP_POINT_TRIGGER   50     // simplification will trigger when this many points are added to the path
 #define SMARTRTL_CLEANUP_START_MARGIN    10     // routine cleanup algorithms begin when the path array has only this many empty slots remaining
@@ -21,6 +27,10 @@
 #define SMARTRTL_PRUNING_DELTA (_accuracy * 0.99)   // How many meters apart must two points be, such that we can assume that there is no obstacle between them.  must be smaller than _ACCURACY parameter
 #define SMARTRTL_PRUNING_LOOP_BUFFER_LEN_MULT 0.25f // pruning loop buffer size as compared to maximum number of points
 #define SMARTRTL_PRUNING_LOOP_TIME_US    200    // maximum time (in microseconds) that the loop finding algorithm will run before returning
+#define SMARTRTL_SEGMENT_INDEX_ENTRIES_MULT  2  // segment index entries as compared to maximum number of points
+#define SMARTRTL_SEGMENT_INDEX_POINTS_MIN   64  // loop detection only uses the segment index for paths with at least this many points
+#define SMARTRTL_SEGMENT_INDEX_NEW_POINTS_MIN 8 // loop detection only uses the segment index when at least this many new points need checking
+#define SMARTRTL_SEGMENT_INDEX_CELLS_MAX    16  // segments covering more grid cells than this are compared with every segment
 
 class AP_SmartRTL {
 
@@ -155,6 +165,25 @@ private:
     // returns false if it failed to remove points (because it could not take semaphore)
     bool remove_points_by_loops(uint16_t num_points_to_remove);
 
+    // index the segments checked by the current loop search so each segment is only compared with those near it
+    // returns false if the index could not be built, in which case detect_loops compares every pair of segments
+    bool build_segment_index();
+
+    // returns true if the segment index holds the segments checked by the current loop search, building it if necessary
+    bool segment_index_ready();
+
+    // find the first segment which comes close to segment i (the line from point i-1 to point i)
+    // segment j is the line from point j-1 to point j, only segments 1 to i-2 are checked
+    // returns true and the segment and midpoint of the closest approach if one was found
+    bool find_loop_to_segment(uint16_t i, uint16_t &loop_start, Vector3f &midpoint) const;
+
+    // grid cells covered by the bounding box of a line, expanded by margin
+    // returns the number of cells covered
+    uint32_t segment_cells(const Vector3f &p1, const Vector3f &p2, float margin, int32_t &x_min, int32_t &y_min, int32_t &x_max, int32_t &y_max) const;
+
+    // bucket holding a grid cell
+    uint16_t segment_index_bucket(int32_t x, int32_t y) const;
+
     // add loop to loops array
     //  returns true if loop added successfully, false on failure (because loop array is full)
     //  checks if loop overlaps with an existing loop, keeps only the longer loop
@@ -218,6 +247,7 @@ private:
         uint16_t stack_max;     // maximum number of elements in the _simplify_stack array
         uint16_t stack_count;   // number of elements in _simplify_stack array
         Bitmask<SMARTRTL_POINTS_MAX> bitmask;  // simplify algorithm clears bits for each point that can be removed
+        uint16_t removal_start; // lowest point whose bit has been cleared, points before this are not touched by removal
     } _simplify;
 
     // Pruning
@@ -238,6 +268,26 @@ private:
         uint16_t loops_count;   // number of elements in the _prunable_loops array
     } _prune;
 
+    // uniform grid of the path's segments used by detect_loops.  Segment j (the line from point j-1 to point j)
+    // is held in every cell covered by its horizontal bounding box, segments covering too many cells are held
+    // in the extra bucket num_buckets and are checked against every segment
+    enum class SegmentIndexState : uint8_t {
+        NEEDS_BUILD = 0,    // the path or the loop search has changed since the index was built
+        READY,              // holds segments 1 to _prune.path_points_count-1
+        FAILED,             // not built for this loop search (out of memory or the brute force search is quicker)
+    };
+    struct {
+        // segments in each bucket, in compressed row form: the segments in bucket b
+        // are entries[bucket_start[b]] to entries[bucket_start[b+1]-1]
+        uint16_t *bucket_start;
+        uint16_t *entries;
+        uint16_t num_buckets;   // number of grid buckets in use, a power of 2
+        uint16_t buckets_max;   // maximum number of grid buckets (bucket_start holds buckets_max+2 elements)
+        uint16_t entries_max;   // maximum number of elements in the entries array
+        float cell_size_inv;    // 1 / length of each side of a cell
+        SegmentIndexState state;
+    } _segment_index;
+
     // returns true if the two loops overlap (used within add_loop to determine which loops to keep or throw away)
     bool loops_overlap(const prune_loop_t& loop1, const prune_loop_t& loop2) const;
 };
@@ -0,0 +1,150 @@
+#include <AP_gtest.h>
+
+#include <AP_SmartRTL/AP_SmartRTL.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+GCS_Dummy _gcs;
+
+// each test uses its own object as SmartRTL can only be initialised once
+static AP_SmartRTL srtl_race_track{true};
+static AP_SmartRTL srtl_out_and_back{true};
+static AP_SmartRTL srtl_random_walk{true};
+
+static const float accuracy = 2.0f;
+
+// initialise SmartRTL with the given maximum number of points and save home
+static void setup_smartrtl(AP_SmartRTL &srtl, uint16_t points_max, const Vector3p &home)
+{
+    ASSERT_TRUE(AP_Param::set_object_value(&srtl, AP_SmartRTL::var_info, "POINTS", points_max));
+    ASSERT_TRUE(AP_Param::set_object_value(&srtl, AP_SmartRTL::var_info, "ACCURACY", accuracy));
+    srtl.init();
+    srtl.set_home(true, home);
+    ASSERT_TRUE(srtl.is_active());
+}
+
+// add a position to the path, running the background cleanup as the IO thread would between updates
+static void fly_to(AP_SmartRTL &srtl, const Vector3p &pos)
+{
+    srtl.update(true, pos);
+    for (uint8_t i = 0; i < 20; i++) {
+        srtl.run_background_cleanup();
+    }
+}
+
+// run the thorough cleanup the vehicle requests when entering SmartRTL mode
+static void thorough_cleanup(AP_SmartRTL &srtl)
+{
+    uint32_t iterations = 0;
+    while (!srtl.request_thorough_cleanup(AP_SmartRTL::THOROUGH_CLEAN_ALL)) {
+        srtl.run_background_cleanup();
+        ASSERT_LT(++iterations, 1000000U);
+    }
+}
+
+// the path must start at home and end within the accuracy of the last position
+static void check_path_ends(const AP_SmartRTL &srtl, const Vector3p &home, const Vector3p &last)
+{
+    ASSERT_GE(srtl.get_num_points(), 2U);
+    EXPECT_LT((srtl.get_point(0).topostype() - home).length(), 0.01);
+    EXPECT_LT((srtl.get_point(srtl.get_num_points() - 1).topostype() - last).length(), accuracy);
+}
+
+// many laps of an oval track.  The laps add far more points than the path can
+// hold so loop pruning must keep removing the previous laps
+TEST(SmartRTL, RaceTrackLaps)
+{
+    const Vector3p home {100, 0, -10};
+    setup_smartrtl(srtl_race_track, 2000, home);
+
+    Vector3p pos = home;
+    const uint16_t laps = 20;
+    const uint16_t steps_per_lap = 300;
+    for (uint32_t k = 0; k <= laps * steps_per_lap; k++) {
+        const float angle = M_2PI * k / steps_per_lap;
+        // drift slowly sideways so laps do not exactly repeat
+        pos = Vector3p(100 * cosf(angle) + k * 0.002f, 60 * sinf(angle), -10);
+        fly_to(srtl_race_track, pos);
+        ASSERT_TRUE(srtl_race_track.is_active());
+    }
+
+    thorough_cleanup(srtl_race_track);
+    ASSERT_TRUE(srtl_race_track.is_active());
+    check_path_ends(srtl_race_track, home, pos);
+
+    // the way home is at most about one lap
+    EXPECT_LT(srtl_race_track.get_num_points(), steps_per_lap);
+}
+
+// a long straight flight out and back along the same line should leave
+// little more than the line itself
+TEST(SmartRTL, OutAndBack)
+{
+    const Vector3p home {0, 0, -20};
+    setup_smartrtl(srtl_out_and_back, 2000, home);
+
+    Vector3p pos = home;
+    const float length = 3000;
+    const float step = 2.5f;
+    for (float x = 0; x <= length; x += step) {
+        pos = Vector3p(x, 0.3f * sinf(x * 0.1f), -20);
+        fly_to(srtl_out_and_back, pos);
+    }
+    for (float x = length; x >= 50; x -= step) {
+        pos = Vector3p(x, 0.5f + 0.3f * cosf(x * 0.1f), -20);
+        fly_to(srtl_out_and_back, pos);
+    }
+    ASSERT_TRUE(srtl_out_and_back.is_active());
+
+    thorough_cleanup(srtl_out_and_back);
+    ASSERT_TRUE(srtl_out_and_back.is_active());
+    check_path_ends(srtl_out_and_back, home, pos);
+    EXPECT_LT(srtl_out_and_back.get_num_points(), 100U);
+}
+
+// a long track wandering around a small area, crossing itself many times
+TEST(SmartRTL, LongRandomTrack)
+{
+    const Vector3p home {0, 0, 0};
+    const uint16_t points_max = MIN(4000, SMARTRTL_POINTS_MAX);
+    setup_smartrtl(srtl_random_walk, points_max, home);
+
+    uint32_t seed = 1;
+    auto rand_float = [&seed]() {
+        seed = seed * 1664525U + 1013904223U;
+        return ((seed >> 8) & 0xFFFF) / 65536.0f - 0.5f;
+    };
+
+    Vector3p pos = home;
+    double track_length = 0;
+    float heading = 0;
+    const float area_size = 300;
+    const uint32_t steps = points_max * 4;
+    for (uint32_t k = 0; k < steps; k++) {
+        // wander at 3m per step, turning back towards home when leaving the area
+        heading += rand_float();
+        if ((pos.xy().length() > area_size) && (pos.x * cosf(heading) + pos.y * sinf(heading) > 0)) {
+            heading += M_PI;
+        }
+        const Vector3p step {3 * cosf(heading), 3 * sinf(heading), 0};
+        pos += step;
+        track_length += step.length();
+        fly_to(srtl_random_walk, pos);
+        ASSERT_TRUE(srtl_random_walk.is_active());
+    }
+
+    thorough_cleanup(srtl_random_walk);
+    ASSERT_TRUE(srtl_random_walk.is_active());
+    check_path_ends(srtl_random_walk, home, pos);
+    EXPECT_LE(srtl_random_walk.get_num_points(), points_max);
+
+    // pruning the crossings leaves a much shorter way home
+    double path_length = 0;
+    for (uint16_t i = 1; i < srtl_random_walk.get_num_points(); i++) {
+        path_length += (srtl_random_walk.get_point(i) - srtl_random_walk.get_point(i-1)).length();
+    }
+    EXPECT_LT(path_length, track_length * 0.25);
+}
+
+AP_GTEST_MAIN()
@@ -135,7 +135,16 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
     calculate_grid_info(loc, info);
 
     // find the grid
-    const struct grid_block &grid = find_grid_cache(info).grid;
+    const uint32_t lookup_start_us = AP_HAL::micros();
+    const struct grid_cache &gcache = find_grid_cache(info);
+    const uint32_t lookup_us = AP_HAL::micros() - lookup_start_us;
+    cache_stats.height_lookups++;
+    cache_stats.height_lookup_us += lookup_us;
+    cache_stats.height_lookup_max_us = MAX(cache_stats.height_lookup_max_us, MIN(lookup_us, 0xFFFFU));
+    if (gcache.state == GRID_CACHE_DISKWAIT) {
+        cache_stats.disk_waits++;
+    }
+    const struct grid_block &grid = gcache.grid;
 
     /*
       note that we rely on the one square overlap to ensure these
@@ -321,6 +330,9 @@ float AP_Terrain::lookahead(float bearing, float distance, float climb_ratio)
         return 0;
     }
 
+    // remember how far ahead to prefetch mission terrain
+    last_lookahead_distance = distance;
+
     Location loc;
     if (!AP::ahrs().get_location(loc)) {
         // we don't know where we are
@@ -485,6 +497,23 @@ void AP_Terrain::log_terrain_data()
         reference_offset : have_reference_offset?reference_offset:0,
     };
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
+
+    const struct log_TERRAIN_CACHE cpkt {
+        LOG_PACKET_HEADER_INIT(LOG_TERRAIN_CACHE_MSG),
+        time_us        : AP_HAL::micros64(),
+        lookups        : cache_stats.lookups,
+        misses         : cache_stats.misses,
+        mmap_loads     : cache_stats.mmap_loads,
+        disk_waits     : cache_stats.disk_waits,
+        lookup_avg_us  : cache_stats.height_lookups > 0 ? float(cache_stats.height_lookup_us) / cache_stats.height_lookups : 0.0f,
+        lookup_max_us  : cache_stats.height_lookup_max_us,
+    };
+    AP::logger().WriteBlock(&cpkt, sizeof(cpkt));
+
+    // lookup times are logged per interval
+    cache_stats.height_lookups = 0;
+    cache_stats.height_lookup_us = 0;
+    cache_stats.height_lookup_max_us = 0;
 }
 #endif
 
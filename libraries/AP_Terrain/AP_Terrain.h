@@ -47,8 +47,27 @@
 
 // number of grid_blocks in the LRU memory cache
 #ifndef TERRAIN_GRID_BLOCK_CACHE_SIZE
+#if AP_TERRAIN_MMAP_ENABLED
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE 64
+#else
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 #endif
+#endif
+
+// number of grids ahead of the vehicle kept loaded while flying a mission
+#ifndef TERRAIN_PREFETCH_WINDOW
+#define TERRAIN_PREFETCH_WINDOW 16
+#endif
+
+// seconds of flight at the current groundspeed covered by the prefetch window
+#ifndef TERRAIN_PREFETCH_TIME_S
+#define TERRAIN_PREFETCH_TIME_S 60
+#endif
+
+// number of degree files kept memory mapped
+#ifndef TERRAIN_MMAP_FILES
+#define TERRAIN_MMAP_FILES 4
+#endif
 
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
@@ -76,6 +95,8 @@
  */
 
 class AP_Terrain {
+    friend class AP_Terrain_Test;
+
 public:
     AP_Terrain();
 
@@ -186,6 +207,21 @@ public:
      */
     void get_statistics(uint16_t &pending, uint16_t &loaded) const;
 
+    /*
+      grid cache statistics. TERRAIN_REPORT has no room for these so
+      they are logged in TERC
+     */
+    struct CacheStatistics {
+        uint32_t lookups;               // grid lookups since boot, not counting prefetching
+        uint32_t misses;                // lookups of grids not in memory
+        uint32_t mmap_loads;            // misses loaded from a memory mapped file
+        uint32_t disk_waits;            // height lookups of grids waiting for a disk read
+        uint32_t height_lookups;        // height lookups since last logged
+        uint32_t height_lookup_us;      // total time to find their grids
+        uint16_t height_lookup_max_us;  // longest time to find a grid
+    };
+    const CacheStatistics &get_cache_statistics() const { return cache_stats; }
+
     /*
       get grid spacing in meters
      */
@@ -308,6 +344,7 @@ private:
       find a grid structure given a grid_info
     */
     struct grid_cache &find_grid_cache(const struct grid_info &info);
+    struct grid_cache &load_grid_cache(const struct grid_info &info, bool &missed);
 
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
@@ -343,6 +380,8 @@ private:
       disk IO functions
      */
     int16_t find_io_idx(enum GridCacheState state);
+    bool format_file_path(char *&path, int8_t lat_degrees, int16_t lon_degrees) const;
+    bool disk_block_valid(struct grid_block &block, int32_t lat, int32_t lon);
     uint16_t get_block_crc(struct grid_block &block);
     void check_disk_read(void);
     void check_disk_write(void);
@@ -361,6 +400,26 @@ private:
      */
     void update_mission_data(void);
 
+    /*
+      a mission leg to prefetch terrain along, extended past its end
+      by the lookahead distance and including any loiter at its end
+     */
+    struct prefetch_leg {
+        Location start;
+        Location end;
+        float bearing;          // degrees
+        float length;           // meters, including any extension
+        float loiter_radius;    // meters
+    };
+    void setup_prefetch_leg(struct prefetch_leg &leg, const Location &start, const Location &end,
+                            float extension, float loiter_radius) const;
+    float prefetch_step(void) const;
+    bool prefetch_leg_sample(const struct prefetch_leg &leg, uint16_t n, Location &loc) const;
+    bool prefetch_grid(const Location &loc);
+    void update_mission_corridor(void);
+    void update_prefetch_window(void);
+    bool add_prefetch_window(const Location &loc);
+
     /*
       check for missing rally data
      */
@@ -455,8 +514,22 @@ private:
     // next mission command to check
     uint16_t next_mission_index;
 
-    // next mission position to check
-    uint8_t next_mission_pos;
+    // next sample along the mission leg to check
+    uint16_t next_mission_pos;
+
+    // start of the next mission leg to check
+    Location next_mission_leg_start;
+    bool have_mission_leg_start;
+
+    // distance last passed to lookahead(). Mission legs are extended
+    // by this so the terrain ahead is available on each leg
+    float last_lookahead_distance;
+
+    // grids along the track ahead of the vehicle, nearest first. These
+    // are kept in the cache and have priority for disk reads and GCS
+    // requests
+    struct grid_info prefetch_window[TERRAIN_PREFETCH_WINDOW];
+    uint8_t prefetch_window_count;
 
     // last time the mission changed
     uint32_t last_mission_change_ms;
@@ -475,6 +548,38 @@ private:
 
     char *file_path = nullptr;
 
+#if AP_TERRAIN_MMAP_ENABLED
+    /*
+      memory mapped degree files, used by the main thread to load
+      grids on a cache miss. The IO thread maps them on request and
+      still does all writes
+     */
+    struct mapped_file {
+        int fd = -1;            // -1 when the slot is unused
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+        int8_t lat_degrees;
+        int16_t lon_degrees;
+        uint32_t last_access_ms;
+    };
+    struct mapped_file mapped_files[TERRAIN_MMAP_FILES];
+    char *mmap_file_path = nullptr;
+
+    // degree file the main thread wants mapped, with at least min_size bytes
+    struct {
+        int8_t lat_degrees;
+        int16_t lon_degrees;
+        size_t min_size;
+    } mmap_request;
+    volatile bool mmap_request_pending;
+
+    bool mmap_load_grid(struct grid_cache &gcache);
+    void mmap_map_file(void);
+    void mmap_close_file(struct mapped_file &mf);
+#endif
+
+    CacheStatistics cache_stats;
+
     // status
     enum TerrainStatus system_status = TerrainStatusDisabled;
 
@@ -85,8 +85,9 @@ bool AP_Terrain::request_missing(GCS_MAVLINK &link, struct grid_cache &gcache)
  */
 bool AP_Terrain::request_missing(GCS_MAVLINK &link, const struct grid_info &info)
 {
-    // find the grid
-    struct grid_cache &gcache = find_grid_cache(info);
+    // find the grid. Lookups for GCS requests are not counted in the cache statistics
+    bool missed;
+    struct grid_cache &gcache = load_grid_cache(info, missed);
     return request_missing(link, gcache);
 }
 
@@ -140,6 +141,13 @@ void AP_Terrain::send_request(GCS_MAVLINK &link)
         return;
     }
 
+    // then the grids along the mission track ahead of the vehicle
+    for (uint8_t i=0; i<prefetch_window_count; i++) {
+        if (request_missing(link, prefetch_window[i])) {
+            return;
+        }
+    }
+
     // check cache blocks that may have been setup by a TERRAIN_CHECK,
     // mission items, rally items, squares surrounding our current
     // location, favourite holiday destination, scripting, height
@@ -33,6 +33,18 @@ extern const AP_HAL::HAL& hal;
  */
 void AP_Terrain::check_disk_read(void)
 {
+    // grids ahead of the vehicle first
+    for (uint8_t w=0; w<prefetch_window_count; w++) {
+        for (uint16_t i=0; i<cache_size; i++) {
+            if (cache[i].state == GRID_CACHE_DISKWAIT &&
+                cache[i].grid.lat == prefetch_window[w].grid_lat &&
+                cache[i].grid.lon == prefetch_window[w].grid_lon) {
+                disk_block.block = cache[i].grid;
+                disk_io_state = DiskIoWaitRead;
+                return;
+            }
+        }
+    }
     for (uint16_t i=0; i<cache_size; i++) {
         if (cache[i].state == GRID_CACHE_DISKWAIT) {
             disk_block.block = cache[i].grid;
@@ -116,6 +128,62 @@ void AP_Terrain::schedule_disk_io(void)
 }
 
 
+/*
+  fill in the path of a degree file, allocating the path on first
+  use. Returns false on failure
+ */
+bool AP_Terrain::format_file_path(char *&path, int8_t lat_degrees, int16_t lon_degrees) const
+{
+    if (path == nullptr) {
+        const char* terrain_dir = hal.util->get_custom_terrain_directory();
+        if (terrain_dir == nullptr) {
+            terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
+        }
+        if (asprintf(&path, "%s/NxxExxx.DAT", terrain_dir) <= 0) {
+            path = nullptr;
+            return false;
+        }
+    }
+    if (path == nullptr) {
+        return false;
+    }
+    char *p = &path[strlen(path)-12];
+    if (*p != '/') {
+        return false;
+    }
+    // our fancy templatified MIN macro get gcc 9.3.0 all confused; it
+    // thinks there are more digits than there can be so says there's
+    // a buffer overflow in the snprintf.  Constrain it long-form:
+    uint32_t lat_tmp = abs((int32_t)lat_degrees);
+    if (lat_tmp > 99U) {
+        lat_tmp = 99U;
+    }
+    uint32_t lon_tmp = abs((int32_t)lon_degrees);
+    if (lon_tmp > 999U) {
+        lon_tmp = 999;
+    }
+    hal.util->snprintf(p, 13, "/%c%02u%c%03u.DAT",
+             lat_degrees<0?'S':'N',
+             (unsigned)lat_tmp,
+             lon_degrees<0?'W':'E',
+             (unsigned)lon_tmp);
+    return true;
+}
+
+/*
+  check a block read from disk is the one wanted and holds valid data
+ */
+bool AP_Terrain::disk_block_valid(struct grid_block &block, int32_t lat, int32_t lon)
+{
+    return TERRAIN_LATLON_EQUAL(block.lat,lat) &&
+        TERRAIN_LATLON_EQUAL(block.lon,lon) &&
+        block.bitmap != 0 &&
+        block.spacing == grid_spacing &&
+        block.version == TERRAIN_GRID_FORMAT_VERSION &&
+        block.crc == get_block_crc(block);
+}
+
+
 /********************************************************
 All the functions below this point run in the IO timer context, which
 is a separate thread. The code uses the state machine controlled by
@@ -126,7 +194,9 @@ The IO timer context owns the data when disk_io_state is
 DiskIoWaitWrite or DiskIoWaitRead. The main thread owns the data when
 disk_io_state is DiskIoIdle, DiskIoDoneWrite or DiskIoDoneRead
 
-All file operations are done by the IO thread.
+All file operations are done by the IO thread. The main thread only
+copies grids out of the files the IO thread has memory mapped for it,
+see TerrainMmap.cpp
 *********************************************************/
 
 
@@ -145,42 +215,11 @@ void AP_Terrain::open_file(void)
         // already open on right file
         return;
     }
-    if (file_path == nullptr) {
-        const char* terrain_dir = hal.util->get_custom_terrain_directory();
-        if (terrain_dir == nullptr) {
-            terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
-        }
-        if (asprintf(&file_path, "%s/NxxExxx.DAT", terrain_dir) <= 0) {
-            io_failure = true;
-            file_path = nullptr;
-            return;
-        }
-    }
-    if (file_path == nullptr) {
+    if (!format_file_path(file_path, block.lat_degrees, block.lon_degrees)) {
         io_failure = true;
         return;
     }
     char *p = &file_path[strlen(file_path)-12];
-    if (*p != '/') {
-        io_failure = true;
-        return;        
-    }
-    // our fancy templatified MIN macro get gcc 9.3.0 all confused; it
-    // thinks there are more digits than there can be so says there's
-    // a buffer overflow in the snprintf.  Constrain it long-form:
-    uint32_t lat_tmp = abs((int32_t)block.lat_degrees);
-    if (lat_tmp > 99U) {
-        lat_tmp = 99U;
-    }
-    uint32_t lon_tmp = abs((int32_t)block.lon_degrees);
-    if (lon_tmp > 999U) {
-        lon_tmp = 999;
-    }
-    hal.util->snprintf(p, 13, "/%c%02u%c%03u.DAT",
-             block.lat_degrees<0?'S':'N',
-             (unsigned)lat_tmp,
-             block.lon_degrees<0?'W':'E',
-             (unsigned)lon_tmp);
 
     // create directory if need be
     if (!directory_created) {
@@ -301,12 +340,7 @@ void AP_Terrain::read_block(void)
 
     ssize_t ret = AP::FS().read(fd, &disk_block, sizeof(disk_block));
     if (ret != sizeof(disk_block) || 
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lat,lat) ||
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lon,lon) ||
-        disk_block.block.bitmap == 0 ||
-        disk_block.block.spacing != grid_spacing ||
-        disk_block.block.version != TERRAIN_GRID_FORMAT_VERSION ||
-        disk_block.block.crc != get_block_crc(disk_block.block)) {
+        !disk_block_valid(disk_block.block, lat, lon)) {
 #if TERRAIN_DEBUG
         printf("read empty block at %ld %ld ret=%d (%ld %ld %u 0x%08lx) 0x%04x:0x%04x\n",
                (long)lat,
@@ -354,6 +388,13 @@ void AP_Terrain::io_timer(void)
 
     update_reference_offset();
 
+#if AP_TERRAIN_MMAP_ENABLED
+    if (mmap_request_pending) {
+        mmap_map_file();
+        mmap_request_pending = false;
+    }
+#endif
+
     switch (disk_io_state) {
     case DiskIoIdle:
     case DiskIoDoneRead:
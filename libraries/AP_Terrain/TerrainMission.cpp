@@ -26,6 +26,7 @@
 #include <AP_Mission/AP_Mission.h>
 #include <AP_Rally/AP_Rally.h>
 #include <AP_GPS/AP_GPS.h>
+#include <AP_AHRS/AP_AHRS.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -34,6 +35,135 @@ extern const AP_HAL::HAL& hal;
  */
 void AP_Terrain::update_mission_data(void)
 {
+#if AP_MISSION_ENABLED
+    update_mission_corridor();
+
+    // the window ahead of the vehicle is touched last so it is the most
+    // recently used part of the cache
+    update_prefetch_window();
+#endif  // AP_MISSION_ENABLED
+}
+
+#if AP_MISSION_ENABLED
+/*
+  return the radius of any loiter done by a mission command
+ */
+static float mission_loiter_radius(const AP_Mission::Mission_Command &cmd)
+{
+    switch (cmd.id) {
+    case MAV_CMD_NAV_LOITER_UNLIM:
+    case MAV_CMD_NAV_LOITER_TO_ALT:
+        return cmd.p1;
+    case MAV_CMD_NAV_LOITER_TURNS: {
+        // radii above 255m are stored divided by 10
+        const float radius = HIGHBYTE(cmd.p1);
+        return (cmd.type_specific_bits & (1U << 0)) ? radius * 10 : radius;
+    }
+    default:
+        return 0;
+    }
+}
+
+/*
+  read the next mission command at or after index which has a
+  location, returning false at the end of the mission
+ */
+static bool mission_next_location_cmd(const AP_Mission &mission, uint16_t &index, AP_Mission::Mission_Command &cmd)
+{
+    while (mission.read_cmd_from_storage(index, cmd)) {
+        if (AP_Mission::is_nav_cmd(cmd) &&
+            AP_Mission::cmd_has_location(cmd.id) &&
+            (cmd.content.location.lat != 0 || cmd.content.location.lng != 0)) {
+            return true;
+        }
+        index++;
+    }
+    return false;
+}
+#endif  // AP_MISSION_ENABLED
+
+/*
+  distance between prefetch samples. This is half the smallest side of
+  a grid block so a leg can't step over a block
+ */
+float AP_Terrain::prefetch_step(void) const
+{
+    return 0.5f * grid_spacing * MIN(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y);
+}
+
+/*
+  setup a leg from start to end, extended past the end by extension
+  meters
+ */
+void AP_Terrain::setup_prefetch_leg(struct prefetch_leg &leg, const Location &start, const Location &end,
+                                    float extension, float loiter_radius) const
+{
+    leg.start = start;
+    leg.end = end;
+    leg.bearing = start.get_bearing_to(end) * 0.01f;
+    leg.length = start.get_distance(end) + MAX(extension, 0.0f);
+    leg.loiter_radius = MAX(loiter_radius, 0.0f);
+}
+
+/*
+  get the n'th sample point covering a leg. Samples run along the leg
+  and each side of it, then around any loiter at the end. Returns
+  false once all samples have been returned
+ */
+bool AP_Terrain::prefetch_leg_sample(const struct prefetch_leg &leg, uint16_t n, Location &loc) const
+{
+    const float step = prefetch_step();
+    if (!is_positive(step)) {
+        return false;
+    }
+
+    // points along the leg, one step either side of the track
+    const uint16_t along_count = MIN(leg.length / step + 2, float(UINT16_MAX / 3));
+    if (n < along_count * 3) {
+        loc = leg.start;
+        loc.offset_bearing(leg.bearing, MIN((n / 3) * step, leg.length));
+        if (n % 3 != 1) {
+            loc.offset_bearing(leg.bearing + 90, (n % 3 == 0) ? -step : step);
+        }
+        return true;
+    }
+    n -= along_count * 3;
+
+    // points around the loiter, one step either side of the circle
+    if (!is_positive(leg.loiter_radius)) {
+        return false;
+    }
+    const uint16_t ring_count = MIN(ceilf(M_2PI * (leg.loiter_radius + step) / step), float(UINT16_MAX / 3));
+    if (n >= ring_count * 3) {
+        return false;
+    }
+    const float radius = leg.loiter_radius + ((n % 3) - 1) * step;
+    loc = leg.end;
+    if (is_positive(radius)) {
+        loc.offset_bearing((n / 3) * 360.0f / ring_count, radius);
+    }
+    return true;
+}
+
+/*
+  make sure the grid holding loc is in the cache, returning true if
+  it had to be loaded
+ */
+bool AP_Terrain::prefetch_grid(const Location &loc)
+{
+    struct grid_info info;
+    calculate_grid_info(loc, info);
+    bool missed;
+    load_grid_cache(info, missed);
+    return missed;
+}
+
+/*
+  walk the whole mission, loading the grids along each leg so they are
+  fetched from the GCS and saved to disk before they are needed
+ */
+void AP_Terrain::update_mission_corridor(void)
+{
 #if AP_MISSION_ENABLED
     const AP_Mission *mission = AP::mission();
     if (mission == nullptr) {
@@ -45,10 +175,11 @@ void AP_Terrain::update_mission_data(void)
         // the mission has changed - start again
         next_mission_index = 1;
         next_mission_pos = 0;
+        have_mission_leg_start = false;
         last_mission_change_ms = mission->last_change_time_ms();
         last_mission_spacing = grid_spacing;
     }
-    if (next_mission_index == 0) {
+    if (next_mission_index == 0 || grid_spacing <= 0) {
         // nothing to do
         return;
     }
@@ -60,56 +191,121 @@ void AP_Terrain::update_mission_data(void)
         return;
     }
 
-    // don't do more than 20 waypoints at a time, to prevent too much
+    // limit the grids loaded at a time so they are all still in the
+    // cache when the GCS sends them, and the samples checked to limit
     // CPU usage
-    for (uint8_t i=0; i<20; i++) {
-        // get next mission command
+    const uint16_t new_grids_max = MAX(cache_size / 4, 1);
+    uint16_t new_grids = 0;
+    for (uint8_t i=0; i<100; i++) {
         AP_Mission::Mission_Command cmd;
-        if (!mission->read_cmd_from_storage(next_mission_index, cmd)) {
+        if (!mission_next_location_cmd(*mission, next_mission_index, cmd)) {
             // nothing more to do
             next_mission_index = 0;
+            next_mission_pos = 0;
             return;
         }
 
-        // we only want nav waypoint commands. That should be enough to
-        // prefill the terrain data and makes many things much simpler
-        while ((cmd.id != MAV_CMD_NAV_WAYPOINT &&
-                cmd.id != MAV_CMD_NAV_SPLINE_WAYPOINT) ||
-               (cmd.content.location.lat == 0 && cmd.content.location.lng == 0)) {
+        const Location &start = have_mission_leg_start ? next_mission_leg_start : cmd.content.location;
+        struct prefetch_leg leg;
+        setup_prefetch_leg(leg, start, cmd.content.location, last_lookahead_distance, mission_loiter_radius(cmd));
+
+        Location loc;
+        if (!prefetch_leg_sample(leg, next_mission_pos, loc)) {
+#if TERRAIN_DEBUG
+            hal.console->printf("checked waypoint %u\n", (unsigned)next_mission_index);
+#endif
+            // move to next leg
+            next_mission_leg_start = cmd.content.location;
+            have_mission_leg_start = true;
             next_mission_index++;
-            if (!mission->read_cmd_from_storage(next_mission_index, cmd)) {
-                // nothing more to do
-                next_mission_index = 0;
-                next_mission_pos = 0;
-                return;
-            }
+            next_mission_pos = 0;
+            continue;
         }
+        next_mission_pos++;
 
-        // we will fetch 5 points around the waypoint. Four at 10 grid
-        // spacings away at 45, 135, 225 and 315 degrees, and the
-        // point itself
-        if (next_mission_pos != 4) {
-            cmd.content.location.offset_bearing(45+90*next_mission_pos, grid_spacing.get() * 10);
+        if (prefetch_grid(loc) && ++new_grids >= new_grids_max) {
+            // check again once these have been filled
+            return;
         }
+    }
+#endif  // AP_MISSION_ENABLED
+}
 
-        // we have a mission command to check
-        float height;
-        if (!height_amsl(cmd.content.location, height)) {
-            // if we can't get data for a mission item then return and
-            // check again next time
-            return;
+/*
+  add the grid holding loc to the prefetch window, returning false if
+  the window is full
+ */
+bool AP_Terrain::add_prefetch_window(const Location &loc)
+{
+    struct grid_info info;
+    calculate_grid_info(loc, info);
+    for (uint8_t i=0; i<prefetch_window_count; i++) {
+        if (prefetch_window[i].grid_lat == info.grid_lat &&
+            prefetch_window[i].grid_lon == info.grid_lon) {
+            return true;
         }
+    }
+    const uint8_t window_max = MIN(TERRAIN_PREFETCH_WINDOW, MAX(cache_size / 2, 1));
+    if (prefetch_window_count >= window_max) {
+        return false;
+    }
+    prefetch_window[prefetch_window_count++] = info;
+    return true;
+}
 
-        next_mission_pos++;
-        if (next_mission_pos == 5) {
-#if TERRAIN_DEBUG
-            hal.console->printf("checked waypoint %u\n", (unsigned)next_mission_index);
-#endif
+/*
+  keep the grids along the track ahead of the vehicle in the cache,
+  covering the lookahead distance plus the distance flown at the
+  current groundspeed in TERRAIN_PREFETCH_TIME_S
+ */
+void AP_Terrain::update_prefetch_window(void)
+{
+    prefetch_window_count = 0;
 
-            // move to next waypoint
-            next_mission_index++;
-            next_mission_pos = 0;
+#if AP_MISSION_ENABLED
+    const AP_Mission *mission = AP::mission();
+    if (mission == nullptr ||
+        mission->state() != AP_Mission::MISSION_RUNNING ||
+        grid_spacing <= 0) {
+        return;
+    }
+    const AP_AHRS &ahrs = AP::ahrs();
+    Location start;
+    if (!ahrs.get_location(start)) {
+        return;
+    }
+
+    float distance = MAX(last_lookahead_distance + ahrs.groundspeed() * TERRAIN_PREFETCH_TIME_S, 2 * prefetch_step());
+    uint16_t index = mission->get_current_nav_index();
+    bool window_full = !add_prefetch_window(start);
+
+    // a few legs from the vehicle's position, in the order they will be flown
+    for (uint8_t legs=0; legs<5 && !window_full && is_positive(distance); legs++) {
+        AP_Mission::Mission_Command cmd;
+        if (!mission_next_location_cmd(*mission, index, cmd)) {
+            break;
         }
+        struct prefetch_leg leg;
+        setup_prefetch_leg(leg, start, cmd.content.location, 0, mission_loiter_radius(cmd));
+        if (leg.length > distance) {
+            // the end of this leg is beyond the window
+            leg.length = distance;
+            leg.loiter_radius = 0;
+        }
+        distance -= leg.length;
+
+        Location loc;
+        for (uint16_t n=0; !window_full && prefetch_leg_sample(leg, n, loc); n++) {
+            window_full = !add_prefetch_window(loc);
+        }
+        start = cmd.content.location;
+        index++;
+    }
+
+    // load the furthest grids first so the nearest are the most recently used
+    for (int8_t i=prefetch_window_count-1; i>=0; i--) {
+        bool missed;
+        load_grid_cache(prefetch_window[i], missed);
     }
 #endif  // AP_MISSION_ENABLED
 }
@@ -0,0 +1,193 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  load grids from memory mapped terrain files
+
+  On boards with an operating system the degree files can be mapped
+  into memory, so a cache miss can be filled straight away in the main
+  thread rather than waiting for the IO thread to read the block.
+
+  The main thread only ever copies blocks out of existing
+  mappings. Opening, mapping and faulting in the files is done by the
+  IO thread when the main thread asks for a file it doesn't have
+  mapped, and the grid is read from disk as before meanwhile. The IO
+  thread still does all writes, which the mappings see through the
+  page cache.
+ */
+
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_MMAP_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  fill in a grid that missed the cache from its mapped degree
+  file. Blocks in the file which have not been written are loaded
+  empty, the same as an empty disk read. Returns false if the block is
+  not mapped, in which case the IO thread is asked to map it and the
+  grid is left for the IO thread to read
+ */
+bool AP_Terrain::mmap_load_grid(struct grid_cache &gcache)
+{
+    if (mmap_request_pending) {
+        // the IO thread owns mapped_files until it has dealt with the request
+        return false;
+    }
+
+    struct grid_block &grid = gcache.grid;
+
+    // same offset as seek_offset()
+    const uint32_t blocknum = east_blocks(grid) * grid.grid_idx_x + grid.grid_idx_y;
+    const size_t file_offset = blocknum * sizeof(union grid_io_block);
+    const size_t min_size = file_offset + sizeof(struct grid_block);
+
+    for (struct mapped_file &mf : mapped_files) {
+        if (mf.fd != -1 &&
+            mf.lat_degrees == grid.lat_degrees &&
+            mf.lon_degrees == grid.lon_degrees &&
+            mf.size >= min_size) {
+            mf.last_access_ms = AP_HAL::millis();
+            struct grid_block block;
+            memcpy(&block, &mf.data[file_offset], sizeof(block));
+            if (disk_block_valid(block, grid.lat, grid.lon)) {
+                grid = block;
+            }
+            gcache.state = GRID_CACHE_VALID;
+            return true;
+        }
+    }
+
+    // not mapped, or the IO thread has extended the file since it was
+    // mapped
+    mmap_request.lat_degrees = grid.lat_degrees;
+    mmap_request.lon_degrees = grid.lon_degrees;
+    mmap_request.min_size = min_size;
+    mmap_request_pending = true;
+    return false;
+}
+
+
+/********************************************************
+The functions below run in the IO timer context. The IO thread owns
+mapped_files while mmap_request_pending is set, and the main thread
+owns them otherwise
+*********************************************************/
+
+
+/*
+  map the degree file in mmap_request, replacing the least recently
+  used mapping, or remap it if the file has grown since it was
+  mapped. Files which don't exist yet are left for the disk read to
+  create
+ */
+void AP_Terrain::mmap_map_file(void)
+{
+    const int8_t lat_degrees = mmap_request.lat_degrees;
+    const int16_t lon_degrees = mmap_request.lon_degrees;
+
+    // find the file, or the least recently used slot to map it into
+    struct mapped_file *mf = nullptr;
+    uint8_t oldest_i = 0;
+    for (uint8_t i=0; i<ARRAY_SIZE(mapped_files); i++) {
+        struct mapped_file &f = mapped_files[i];
+        if (f.fd != -1 &&
+            f.lat_degrees == lat_degrees &&
+            f.lon_degrees == lon_degrees) {
+            mf = &f;
+            break;
+        }
+        const struct mapped_file &oldest = mapped_files[oldest_i];
+        if (oldest.fd != -1 && (f.fd == -1 || f.last_access_ms < oldest.last_access_ms)) {
+            oldest_i = i;
+        }
+    }
+
+    if (mf == nullptr) {
+        if (!format_file_path(mmap_file_path, lat_degrees, lon_degrees)) {
+            return;
+        }
+        const char *fname = mmap_file_path;
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+        // AP_Filesystem keeps SITL files under the current directory
+        if (*fname == '/') {
+            fname++;
+        }
+#endif
+        const int new_fd = ::open(fname, O_RDONLY|O_CLOEXEC);
+        if (new_fd == -1) {
+            return;
+        }
+        mf = &mapped_files[oldest_i];
+        mmap_close_file(*mf);
+        mf->fd = new_fd;
+        mf->lat_degrees = lat_degrees;
+        mf->lon_degrees = lon_degrees;
+        mf->last_access_ms = AP_HAL::millis();
+    }
+
+    if (mf->size >= mmap_request.min_size) {
+        return;
+    }
+    struct stat st;
+    if (::fstat(mf->fd, &st) != 0) {
+        mmap_close_file(*mf);
+        return;
+    }
+    const size_t size = st.st_size;
+    if (size == 0 || size <= mf->size) {
+        // not grown
+        return;
+    }
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, mf->fd, 0);
+    if (data == MAP_FAILED) {
+        return;
+    }
+    if (mf->data != nullptr) {
+        ::munmap(const_cast<uint8_t *>(mf->data), mf->size);
+    }
+    mf->data = (const uint8_t *)data;
+    mf->size = size;
+
+    // fault the pages in now so the main thread's reads don't wait on
+    // the disk. They can still be reclaimed under memory pressure
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    for (size_t ofs = 0; ofs < size; ofs += page_size) {
+        (void)*(const volatile uint8_t *)&mf->data[ofs];
+    }
+}
+
+/*
+  unmap and close a degree file
+ */
+void AP_Terrain::mmap_close_file(struct mapped_file &mf)
+{
+    if (mf.data != nullptr) {
+        ::munmap(const_cast<uint8_t *>(mf.data), mf.size);
+    }
+    if (mf.fd != -1) {
+        ::close(mf.fd);
+    }
+    mf = {};
+}
+
+#endif // AP_TERRAIN_MMAP_ENABLED
@@ -102,12 +102,38 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
 
 
 /*
-  find a grid structure given a grid_info
+  find a grid structure given a grid_info, counting the lookup in the
+  cache statistics
  */
 AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+{
+    bool missed;
+    struct grid_cache &grid = load_grid_cache(info, missed);
+
+    cache_stats.lookups++;
+    if (missed) {
+        cache_stats.misses++;
+#if AP_TERRAIN_MMAP_ENABLED
+        if (grid.state == GRID_CACHE_VALID) {
+            // filled from a memory mapped file rather than waiting for disk
+            cache_stats.mmap_loads++;
+        }
+#endif
+    }
+    return grid;
+}
+
+/*
+  find a grid structure given a grid_info, loading it if it is not in
+  the cache. missed is set if it had to be loaded. Prefetching uses
+  this directly so it doesn't skew the cache statistics
+ */
+AP_Terrain::grid_cache &AP_Terrain::load_grid_cache(const struct grid_info &info, bool &missed)
 {
     uint16_t oldest_i = 0;
 
+    missed = false;
+
     // see if we have that grid
     const auto now_ms = AP_HAL::millis();
     for (uint16_t i=0; i<cache_size; i++) {
@@ -124,6 +150,7 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
 
     // Not found. Use the oldest grid and make it this grid,
     // initially unpopulated
+    missed = true;
     struct grid_cache &grid = cache[oldest_i];
     memset(&grid, 0, sizeof(grid));
 
@@ -137,6 +164,12 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
     grid.last_access_ms = now_ms;
 
+#if AP_TERRAIN_MMAP_ENABLED
+    if (!diskless() && mmap_load_grid(grid)) {
+        return grid;
+    }
+#endif
+
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
 
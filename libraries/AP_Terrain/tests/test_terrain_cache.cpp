@@ -0,0 +1,70 @@
+/*
+  check that prefetching grids loads them into the cache without
+  counting towards the cache statistics, which are for height lookups
+ */
+#include <AP_gtest.h>
+
+#include <AP_Terrain/AP_Terrain.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_TERRAIN_AVAILABLE
+
+class AP_Terrain_Test
+{
+public:
+    static void init(AP_Terrain &terrain, uint8_t cache_size)
+    {
+        terrain.grid_spacing.set(100);
+        // no disk, so misses wait for the GCS
+        terrain.options.set(uint16_t(AP_Terrain::Options::DisableDisk));
+        terrain.cache_size = cache_size;
+        terrain.cache = (AP_Terrain::grid_cache *)calloc(cache_size, sizeof(AP_Terrain::grid_cache));
+    }
+
+    static bool prefetch_grid(AP_Terrain &terrain, const Location &loc) { return terrain.prefetch_grid(loc); }
+
+    static void find_grid(AP_Terrain &terrain, const Location &loc)
+    {
+        AP_Terrain::grid_info info;
+        terrain.calculate_grid_info(loc, info);
+        terrain.find_grid_cache(info);
+    }
+};
+
+static AP_Terrain terrain;
+
+TEST(AP_Terrain, PrefetchStatistics)
+{
+    AP_Terrain_Test::init(terrain, 4);
+    const AP_Terrain::CacheStatistics &stats = terrain.get_cache_statistics();
+
+    Location loc {-353632620, 1491652370, 0, Location::AltFrame::ABSOLUTE};
+    Location loc2 = loc;
+    loc2.offset(5000, 0);
+
+    // prefetching reports whether the grid was loaded, and isn't counted
+    EXPECT_TRUE(AP_Terrain_Test::prefetch_grid(terrain, loc));
+    EXPECT_FALSE(AP_Terrain_Test::prefetch_grid(terrain, loc));
+    EXPECT_TRUE(AP_Terrain_Test::prefetch_grid(terrain, loc2));
+    EXPECT_EQ(stats.lookups, 0U);
+    EXPECT_EQ(stats.misses, 0U);
+
+    // so a lookup of a prefetched grid is a hit
+    AP_Terrain_Test::find_grid(terrain, loc);
+    AP_Terrain_Test::find_grid(terrain, loc2);
+    EXPECT_EQ(stats.lookups, 2U);
+    EXPECT_EQ(stats.misses, 0U);
+
+    Location loc3 = loc;
+    loc3.offset(0, 5000);
+    AP_Terrain_Test::find_grid(terrain, loc3);
+    EXPECT_EQ(stats.lookups, 3U);
+    EXPECT_EQ(stats.misses, 1U);
+    EXPECT_EQ(stats.mmap_loads, 0U);
+    EXPECT_FALSE(AP_Terrain_Test::prefetch_grid(terrain, loc3));
+}
+
+#endif  // AP_TERRAIN_AVAILABLE
+
+AP_GTEST_MAIN()
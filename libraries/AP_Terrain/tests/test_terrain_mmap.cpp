@@ -0,0 +1,305 @@
+/*
+  check that grids which miss the terrain cache are loaded from the
+  memory mapped degree files once the IO thread has mapped them, and
+  that the least recently used file is the one unmapped
+ */
+#include <AP_gtest.h>
+
+#include <AP_Terrain/AP_Terrain.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_TERRAIN_MMAP_ENABLED
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TERRAIN_TEST_DIR "terrain_mmap_test"
+
+class AP_Terrain_Test
+{
+public:
+    typedef AP_Terrain::grid_cache grid_cache;
+
+    static void init(AP_Terrain &terrain)
+    {
+        terrain.grid_spacing.set(100);
+        free(terrain.mmap_file_path);
+        terrain.mmap_file_path = strdup(TERRAIN_TEST_DIR "/NxxExxx.DAT");
+    }
+
+    // an empty grid for loc, as find_grid_cache() makes on a miss
+    static grid_cache empty_grid(const AP_Terrain &terrain, const Location &loc)
+    {
+        AP_Terrain::grid_info info;
+        terrain.calculate_grid_info(loc, info);
+        grid_cache gcache {};
+        gcache.grid.lat = info.grid_lat;
+        gcache.grid.lon = info.grid_lon;
+        gcache.grid.spacing = terrain.grid_spacing;
+        gcache.grid.grid_idx_x = info.grid_idx_x;
+        gcache.grid.grid_idx_y = info.grid_idx_y;
+        gcache.grid.lat_degrees = info.lat_degrees;
+        gcache.grid.lon_degrees = info.lon_degrees;
+        gcache.grid.version = TERRAIN_GRID_FORMAT_VERSION;
+        return gcache;
+    }
+
+    // write the grid for loc to its degree file, as the IO thread does
+    static void write_grid(AP_Terrain &terrain, const Location &loc, int16_t height)
+    {
+        grid_cache gcache = empty_grid(terrain, loc);
+        AP_Terrain::grid_block &block = gcache.grid;
+        block.bitmap = AP_Terrain::bitmap_mask;
+        for (uint8_t x = 0; x < TERRAIN_GRID_BLOCK_SIZE_X; x++) {
+            for (uint8_t y = 0; y < TERRAIN_GRID_BLOCK_SIZE_Y; y++) {
+                block.height[x][y] = height + x + y;
+            }
+        }
+        block.crc = terrain.get_block_crc(block);
+
+        ASSERT_TRUE(terrain.format_file_path(terrain.mmap_file_path, block.lat_degrees, block.lon_degrees));
+        const int fd = ::open(terrain.mmap_file_path, O_WRONLY|O_CREAT, 0644);
+        ASSERT_NE(fd, -1);
+        const uint32_t blocknum = terrain.east_blocks(block) * block.grid_idx_x + block.grid_idx_y;
+        AP_Terrain::grid_io_block io_block {};
+        io_block.block = block;
+        EXPECT_EQ(::pwrite(fd, &io_block, sizeof(io_block), blocknum * sizeof(io_block)), ssize_t(sizeof(io_block)));
+        ::close(fd);
+    }
+
+    static bool load_grid(AP_Terrain &terrain, grid_cache &gcache) { return terrain.mmap_load_grid(gcache); }
+    static bool valid(const grid_cache &gcache) { return gcache.state == AP_Terrain::GRID_CACHE_VALID; }
+    static bool request_pending(const AP_Terrain &terrain) { return terrain.mmap_request_pending; }
+
+    // what io_timer() does with a request
+    static void io_timer(AP_Terrain &terrain)
+    {
+        if (terrain.mmap_request_pending) {
+            terrain.mmap_map_file();
+            terrain.mmap_request_pending = false;
+        }
+    }
+
+    // true if the degree file holding loc is mapped
+    static bool mapped(const AP_Terrain &terrain, const Location &loc)
+    {
+        AP_Terrain::grid_info info;
+        terrain.calculate_grid_info(loc, info);
+        for (const AP_Terrain::mapped_file &mf : terrain.mapped_files) {
+            if (mf.fd != -1 && mf.lat_degrees == info.lat_degrees && mf.lon_degrees == info.lon_degrees) {
+                return mf.data != nullptr;
+            }
+        }
+        return false;
+    }
+
+    static uint8_t num_mapped(const AP_Terrain &terrain)
+    {
+        uint8_t count = 0;
+        for (const AP_Terrain::mapped_file &mf : terrain.mapped_files) {
+            if (mf.fd != -1) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    static void unmap_all(AP_Terrain &terrain)
+    {
+        for (AP_Terrain::mapped_file &mf : terrain.mapped_files) {
+            terrain.mmap_close_file(mf);
+        }
+    }
+};
+
+typedef AP_Terrain_Test::grid_cache grid_cache;
+
+static AP_Terrain terrain;
+
+static Location degree_loc(int8_t lat_degrees, int16_t lon_degrees, float north_m = 500, float east_m = 500)
+{
+    Location loc {lat_degrees * 10000000, lon_degrees * 10000000, 0, Location::AltFrame::ABSOLUTE};
+    loc.offset(north_m, east_m);
+    return loc;
+}
+
+// the time moves on so mappings are used in a known order
+static void wait_ms(uint32_t ms)
+{
+    const uint32_t start_ms = AP_HAL::millis();
+    while (AP_HAL::millis() - start_ms <= ms) {
+    }
+}
+
+static void remove_files()
+{
+    DIR *d = opendir(TERRAIN_TEST_DIR);
+    if (d == nullptr) {
+        return;
+    }
+    char path[sizeof(TERRAIN_TEST_DIR "/") + sizeof(dirent::d_name)];
+    for (struct dirent *de = readdir(d); de != nullptr; de = readdir(d)) {
+        if (de->d_name[0] != '.') {
+            snprintf(path, sizeof(path), TERRAIN_TEST_DIR "/%s", de->d_name);
+            unlink(path);
+        }
+    }
+    closedir(d);
+    rmdir(TERRAIN_TEST_DIR);
+}
+
+TEST(AP_Terrain, MappedLookup)
+{
+    remove_files();
+    ASSERT_EQ(mkdir(TERRAIN_TEST_DIR, 0755), 0);
+    AP_Terrain_Test::init(terrain);
+
+    const Location loc1 = degree_loc(-35, 149);
+    const Location loc2 = degree_loc(-35, 149, 20000, 30000);
+    const Location loc3 = degree_loc(-35, 149, 60000, 50000);
+    const Location loc_unwritten = degree_loc(-35, 149, 10000, 2000);
+    AP_Terrain_Test::write_grid(terrain, loc1, 100);
+    AP_Terrain_Test::write_grid(terrain, loc2, 200);
+
+    // the first miss asks the IO thread to map the file, and is left for the disk read
+    grid_cache gcache = AP_Terrain_Test::empty_grid(terrain, loc1);
+    EXPECT_FALSE(AP_Terrain_Test::load_grid(terrain, gcache));
+    EXPECT_TRUE(AP_Terrain_Test::request_pending(terrain));
+    EXPECT_FALSE(AP_Terrain_Test::valid(gcache));
+
+    // nothing is loaded while the IO thread owns the mappings
+    EXPECT_FALSE(AP_Terrain_Test::load_grid(terrain, gcache));
+    EXPECT_FALSE(AP_Terrain_Test::mapped(terrain, loc1));
+
+    AP_Terrain_Test::io_timer(terrain);
+    EXPECT_FALSE(AP_Terrain_Test::request_pending(terrain));
+    EXPECT_TRUE(AP_Terrain_Test::mapped(terrain, loc1));
+
+    // then grids in the file are loaded from the mapping
+    ASSERT_TRUE(AP_Terrain_Test::load_grid(terrain, gcache));
+    EXPECT_TRUE(AP_Terrain_Test::valid(gcache));
+    EXPECT_NE(gcache.grid.bitmap, 0U);
+    EXPECT_EQ(gcache.grid.height[0][0], 100);
+    EXPECT_EQ(gcache.grid.height[3][4], 107);
+
+    gcache = AP_Terrain_Test::empty_grid(terrain, loc2);
+    ASSERT_TRUE(AP_Terrain_Test::load_grid(terrain, gcache));
+    EXPECT_EQ(gcache.grid.height[1][1], 202);
+    EXPECT_FALSE(AP_Terrain_Test::request_pending(terrain));
+
+    // a block in the file that hasn't been written is loaded empty
+    gcache = AP_Terrain_Test::empty_grid(terrain, loc_unwritten);
+    ASSERT_TRUE(AP_Terrain_Test::load_grid(terrain, gcache));
+    EXPECT_TRUE(AP_Terrain_Test::valid(gcache));
+    EXPECT_EQ(gcache.grid.bitmap, 0U);
+
+    // a block past the end of the file is left for the disk read until
+    // the file is extended and remapped
+    gcache = AP_Terrain_Test::empty_grid(terrain, loc3);
+    EXPECT_FALSE(AP_Terrain_Test::load_grid(terrain, gcache));
+
+    // and while the IO thread has the request even mapped grids aren't loaded
+    grid_cache gcache2 = AP_Terrain_Test::empty_grid(terrain, loc2);
+    EXPECT_FALSE(AP_Terrain_Test::load_grid(terrain, gcache2));
+    AP_Terrain_Test::io_timer(terrain);
+    EXPECT_TRUE(AP_Terrain_Test::load_grid(terrain, gcache2));
+
+    EXPECT_FALSE(AP_Terrain_Test::load_grid(terrain, gcache));
+    AP_Terrain_Test::io_timer(terrain);
+    AP_Terrain_Test::write_grid(terrain, loc3, 300);
+    EXPECT_FALSE(AP_Terrain_Test::load_grid(terrain, gcache));
+    AP_Terrain_Test::io_timer(terrain);
+    ASSERT_TRUE(AP_Terrain_Test::load_grid(terrain, gcache));
+    EXPECT_EQ(gcache.grid.height[0][0], 300);
+
+    // grids in files which don't exist are left for the disk read
+    gcache = AP_Terrain_Test::empty_grid(terrain, degree_loc(-36, 149));
+    EXPECT_FALSE(AP_Terrain_Test::load_grid(terrain, gcache));
+    AP_Terrain_Test::io_timer(terrain);
+    EXPECT_FALSE(AP_Terrain_Test::request_pending(terrain));
+    EXPECT_EQ(AP_Terrain_Test::num_mapped(terrain), 1);
+
+    AP_Terrain_Test::unmap_all(terrain);
+    remove_files();
+}
+
+TEST(AP_Terrain, MappedEviction)
+{
+    remove_files();
+    ASSERT_EQ(mkdir(TERRAIN_TEST_DIR, 0755), 0);
+    AP_Terrain_Test::init(terrain);
+
+    // the first file mapped gets descriptor zero
+    const int saved_stdin = dup(0);
+    ASSERT_NE(saved_stdin, -1);
+    ::close(0);
+
+    Location locs[TERRAIN_MMAP_FILES+1];
+    for (uint8_t i = 0; i < ARRAY_SIZE(locs); i++) {
+        locs[i] = degree_loc(-35, 140 + i);
+        AP_Terrain_Test::write_grid(terrain, locs[i], 100 * i);
+    }
+
+    // fill every slot
+    for (uint8_t i = 0; i < TERRAIN_MMAP_FILES; i++) {
+        grid_cache gcache = AP_Terrain_Test::empty_grid(terrain, locs[i]);
+        EXPECT_FALSE(AP_Terrain_Test::load_grid(terrain, gcache));
+        AP_Terrain_Test::io_timer(terrain);
+        ASSERT_TRUE(AP_Terrain_Test::load_grid(terrain, gcache)) << unsigned(i);
+        EXPECT_EQ(gcache.grid.height[0][0], 100 * i);
+        wait_ms(2);
+    }
+    EXPECT_EQ(AP_Terrain_Test::num_mapped(terrain), TERRAIN_MMAP_FILES);
+
+    // using the first file again leaves the second least recently used
+    grid_cache gcache = AP_Terrain_Test::empty_grid(terrain, locs[0]);
+    ASSERT_TRUE(AP_Terrain_Test::load_grid(terrain, gcache));
+    wait_ms(2);
+
+    // so mapping one more file replaces it
+    gcache = AP_Terrain_Test::empty_grid(terrain, locs[TERRAIN_MMAP_FILES]);
+    EXPECT_FALSE(AP_Terrain_Test::load_grid(terrain, gcache));
+    AP_Terrain_Test::io_timer(terrain);
+    ASSERT_TRUE(AP_Terrain_Test::load_grid(terrain, gcache));
+    EXPECT_EQ(gcache.grid.height[0][0], 100 * TERRAIN_MMAP_FILES);
+    EXPECT_EQ(AP_Terrain_Test::num_mapped(terrain), TERRAIN_MMAP_FILES);
+    EXPECT_TRUE(AP_Terrain_Test::mapped(terrain, locs[0]));
+    EXPECT_FALSE(AP_Terrain_Test::mapped(terrain, locs[1]));
+    for (uint8_t i = 2; i < ARRAY_SIZE(locs); i++) {
+        EXPECT_TRUE(AP_Terrain_Test::mapped(terrain, locs[i])) << unsigned(i);
+    }
+
+    // and the evicted file is mapped again when next needed
+    gcache = AP_Terrain_Test::empty_grid(terrain, locs[1]);
+    EXPECT_FALSE(AP_Terrain_Test::load_grid(terrain, gcache));
+    AP_Terrain_Test::io_timer(terrain);
+    ASSERT_TRUE(AP_Terrain_Test::load_grid(terrain, gcache));
+    EXPECT_EQ(gcache.grid.height[0][0], 100);
+    EXPECT_FALSE(AP_Terrain_Test::mapped(terrain, locs[2]));
+
+    // the file on descriptor zero is remapped in place when it grows
+    const Location loc_far = degree_loc(-35, 140, 60000, 500);
+    gcache = AP_Terrain_Test::empty_grid(terrain, loc_far);
+    EXPECT_FALSE(AP_Terrain_Test::load_grid(terrain, gcache));
+    AP_Terrain_Test::write_grid(terrain, loc_far, 50);
+    AP_Terrain_Test::io_timer(terrain);
+    ASSERT_TRUE(AP_Terrain_Test::load_grid(terrain, gcache));
+    EXPECT_EQ(gcache.grid.height[0][0], 50);
+    EXPECT_EQ(AP_Terrain_Test::num_mapped(terrain), TERRAIN_MMAP_FILES);
+    for (uint8_t i = 0; i < ARRAY_SIZE(locs); i++) {
+        EXPECT_EQ(AP_Terrain_Test::mapped(terrain, locs[i]), i != 2) << unsigned(i);
+    }
+
+    AP_Terrain_Test::unmap_all(terrain);
+    EXPECT_EQ(AP_Terrain_Test::num_mapped(terrain), 0);
+    dup2(saved_stdin, 0);
+    ::close(saved_stdin);
+    remove_files();
+}
+
+#endif  // AP_TERRAIN_MMAP_ENABLED
+
+AP_GTEST_MAIN()
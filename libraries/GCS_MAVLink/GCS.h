@@ -179,6 +179,7 @@ public:
     friend class GCS_FTP;
 #endif
     friend class MAVLink_routing;
+    friend class GCS_MAVLINK_Test;
 
     GCS_MAVLINK(AP_HAL::UARTDriver &uart);
     virtual ~GCS_MAVLINK() {}
@@ -218,6 +219,12 @@ public:
     // this is called when we discover we'd like to send something but can't:
     void out_of_space_to_send() { out_of_space_to_send_count++; }
 
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+    // this is called as bytes are written to the port so we can
+    // measure how much of the link we are using:
+    void record_bytes_sent(uint16_t nbytes) { stream_shaping.bytes_sent += nbytes; }
+#endif
+
     void send_mission_ack(const mavlink_message_t &msg,
                           MAV_MISSION_TYPE mission_type,
                           MAV_MISSION_RESULT result) const {
@@ -551,6 +558,13 @@ protected:
     }
     AP_Int8 options_were_converted;
 
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+    // target link utilisation; zero disables shaping
+    AP_Int8 bw_target_pct;
+    // bitmask of streams which are given a larger share of the link
+    AP_Int16 bw_priority_streams;
+#endif
+
     virtual void handle_command_ack(const mavlink_message_t &msg);
     void handle_set_mode(const mavlink_message_t &msg);
     void handle_command_int(const mavlink_message_t &msg);
@@ -896,6 +910,10 @@ private:
         Bitmask<MSG_LAST> ap_message_ids;
         uint16_t interval_ms;
         uint16_t last_sent_ms; // from AP_HAL::millis16()
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+        uint8_t weight;        // share of the link relative to other buckets
+        uint32_t virtual_time; // weighted-fair-queuing finish tag
+#endif
     };
     deferred_message_bucket_t deferred_message_bucket[10];
     static const uint8_t no_bucket_to_send = -1;
@@ -907,6 +925,44 @@ private:
     void find_next_bucket_to_send(uint16_t now16_ms);
     void remove_message_from_bucket(int8_t bucket, ap_message id);
 
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+    // weighted fair queuing of the deferred message buckets.  When
+    // the link is congested the bucket intervals are stretched, with
+    // low-weight buckets stretched more than high-weight ones, and
+    // buckets which are overdue are serviced in virtual-time order.
+    static const uint8_t SHAPING_WEIGHT_NORMAL = 1;
+    static const uint8_t SHAPING_WEIGHT_PRIORITY = 4;
+    static const uint16_t SHAPING_SCALE_MAX_PCT = 1000;
+    struct {
+        uint32_t window_start_ms;
+        uint32_t bytes_sent;             // bytes written in current window
+        uint16_t out_of_space_count;     // out_of_space_to_send_count at window start
+        uint32_t link_bytes_per_second;  // estimated link capacity
+        uint8_t radio_capacity_pct = 100; // estimate of radio capacity relative to the UART
+        uint8_t utilisation_pct;         // measured over the last window
+        uint16_t scale_pct = 100;        // interval stretch applied to weight-1 buckets
+        uint32_t virtual_time;           // finish tag of the last bucket serviced
+        uint16_t sent_count[NUM_STREAMS];
+        uint16_t achieved_rate_cHz[NUM_STREAMS]; // only logged, in MAVS
+    } stream_shaping;
+
+    // stream each ap_message belongs to; NUM_STREAMS if none
+    static uint8_t ap_message_stream[MSG_LAST];
+    static bool ap_message_stream_initialised;
+    static void init_ap_message_stream_map();
+
+    // with MAVn_BW_TARG at zero buckets are sent exactly as without shaping
+    bool stream_shaping_enabled() const { return bw_target_pct > 0; }
+    uint8_t shaping_weight_for_ap_message(ap_message id) const;
+    void update_bucket_weight(deferred_message_bucket_t &bucket) const;
+    void update_stream_shaping(uint32_t now_ms);
+    void stream_shaping_message_sent(ap_message id);
+    void stream_shaping_bucket_sent(deferred_message_bucket_t &bucket, uint8_t num_sent);
+#if HAL_LOGGING_ENABLED
+    void log_stream_shaping_stats() const;
+#endif
+#endif  // AP_MAVLINK_STREAM_SHAPING_ENABLED
+
     // bitmask of IDs the code has spontaneously decided it wants to
     // send out.  Examples include HEARTBEAT (gcs_send_heartbeat)
     Bitmask<MSG_LAST> pushed_ap_message_ids;
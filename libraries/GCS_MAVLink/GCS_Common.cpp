@@ -128,6 +128,11 @@ uint32_t GCS_MAVLINK::reserve_param_space_start_ms;
 // don't get broadcasts or fwded packets
 mavlink_channel_mask_t GCS_MAVLINK::mavlink_private = 0;
 
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+uint8_t GCS_MAVLINK::ap_message_stream[MSG_LAST];
+bool GCS_MAVLINK::ap_message_stream_initialised;
+#endif
+
 GCS *GCS::_singleton = nullptr;
 
 GCS_MAVLINK_InProgress GCS_MAVLINK_InProgress::in_progress_tasks[1];
@@ -936,6 +941,17 @@ void GCS_MAVLINK::handle_radio_status(const mavlink_message_t &msg)
         }
     }
 
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+    // the radio's buffer filling up means the air link is slower
+    // than the UART feeding it; back our estimate of the link
+    // capacity off quickly and recover it slowly:
+    if (packet.txbuf < 50) {
+        stream_shaping.radio_capacity_pct = MAX(stream_shaping.radio_capacity_pct * 3U / 4U, 10U);
+    } else if (packet.txbuf > 90) {
+        stream_shaping.radio_capacity_pct = MIN(stream_shaping.radio_capacity_pct + 5U, 100U);
+    }
+#endif
+
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
     if (stream_slowdown_ms > max_slowdown_ms) {
         max_slowdown_ms = stream_slowdown_ms;
@@ -1255,6 +1271,15 @@ uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t
 
     interval_ms += stream_slowdown_ms;
 
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+    // stretch the interval if we are over our bandwidth target.
+    // Buckets containing priority streams are stretched less:
+    if (stream_shaping_enabled() && stream_shaping.scale_pct > 100 && deferred.weight != 0) {
+        const uint32_t scale_pct = 100U + (stream_shaping.scale_pct - 100U) / deferred.weight;
+        interval_ms = interval_ms * scale_pct / 100U;
+    }
+#endif
+
     // slow most messages down if we're transfering parameters or
     // waypoints:
     if (_queued_parameter) {
@@ -1308,6 +1333,16 @@ void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
             sending_bucket_id = i;
             ms_before_send_next_bucket_to_send = ms_before_send_this_bucket;
         }
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+        else if (stream_shaping_enabled() &&
+                 ms_before_send_this_bucket == 0 &&
+                 ms_before_send_next_bucket_to_send == 0 &&
+                 int32_t(deferred_message_bucket[i].virtual_time - deferred_message_bucket[sending_bucket_id].virtual_time) < 0) {
+            // several buckets are overdue; service the one which has
+            // had the least of its fair share of the link first
+            sending_bucket_id = i;
+        }
+#endif
     }
     if (sending_bucket_id != no_bucket_to_send) {
         bucket_message_ids_to_send = deferred_message_bucket[sending_bucket_id].ap_message_ids;
@@ -1579,6 +1614,10 @@ void GCS_MAVLINK::update_send()
         deferred_messages_initialised = true;
     }
 
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+    update_stream_shaping(AP_HAL::millis());
+#endif
+
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
     uint32_t retry_deferred_body_start = AP_HAL::micros();
 #endif
@@ -1654,7 +1693,14 @@ void GCS_MAVLINK::update_send()
                 break;
             }
             bucket_message_ids_to_send.clear(next);
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+            stream_shaping_message_sent(next);
+#endif
             if (bucket_message_ids_to_send.count() == 0) {
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+                stream_shaping_bucket_sent(deferred_message_bucket[sending_bucket_id],
+                                           deferred_message_bucket[sending_bucket_id].ap_message_ids.count());
+#endif
                 // we sent everything in the bucket.  Reschedule it.
                 // we try to keep output on a regular clock to avoid
                 // user support questions:
@@ -1702,6 +1748,9 @@ void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
         deferred_message_bucket[bucket].interval_ms = 0;
         deferred_message_bucket[bucket].last_sent_ms = 0;
     }
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+    update_bucket_weight(deferred_message_bucket[bucket]);
+#endif
 
     if (bucket == sending_bucket_id) {
         bucket_message_ids_to_send.clear(id);
@@ -1722,6 +1771,148 @@ void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
     }
 }
 
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+/*
+  build a map from ap_message to the stream it is a member of.  The
+  stream entries are static, so this is shared between all links.
+ */
+void GCS_MAVLINK::init_ap_message_stream_map()
+{
+    if (ap_message_stream_initialised) {
+        return;
+    }
+    memset(ap_message_stream, NUM_STREAMS, sizeof(ap_message_stream));
+    for (uint8_t i=0; all_stream_entries[i].ap_message_ids != nullptr; i++) {
+        const GCS_MAVLINK::stream_entries &entries = all_stream_entries[i];
+        for (uint8_t j=0; j<entries.num_ap_message_ids; j++) {
+            const ap_message id = entries.ap_message_ids[j];
+            if (id < MSG_LAST && ap_message_stream[id] == NUM_STREAMS) {
+                ap_message_stream[id] = entries.stream_id;
+            }
+        }
+    }
+    ap_message_stream_initialised = true;
+}
+
+// return the weight an ap_message carries when competing for the link
+uint8_t GCS_MAVLINK::shaping_weight_for_ap_message(ap_message id) const
+{
+    init_ap_message_stream_map();
+    const uint8_t stream = ap_message_stream[id];
+    if (stream < NUM_STREAMS &&
+        (uint16_t(bw_priority_streams.get()) & (1U<<stream)) != 0) {
+        return SHAPING_WEIGHT_PRIORITY;
+    }
+    return SHAPING_WEIGHT_NORMAL;
+}
+
+// a bucket is as important as the most important message in it
+void GCS_MAVLINK::update_bucket_weight(deferred_message_bucket_t &bucket) const
+{
+    bucket.weight = 0;
+    for (uint16_t i=0; i<MSG_LAST; i++) {
+        if (bucket.ap_message_ids.get(i)) {
+            bucket.weight = MAX(bucket.weight, shaping_weight_for_ap_message(ap_message(i)));
+        }
+    }
+}
+
+void GCS_MAVLINK::stream_shaping_message_sent(ap_message id)
+{
+    const uint8_t stream = ap_message_stream[id];
+    if (stream < NUM_STREAMS) {
+        stream_shaping.sent_count[stream]++;
+    }
+}
+
+/*
+  advance a bucket's finish tag once all of its messages have gone
+  out.  Heavier buckets advance more slowly, so they win more often
+  when several buckets are overdue at the same time.
+ */
+void GCS_MAVLINK::stream_shaping_bucket_sent(deferred_message_bucket_t &bucket, uint8_t num_sent)
+{
+    if (!stream_shaping_enabled()) {
+        return;
+    }
+    const uint8_t weight = MAX(bucket.weight, 1U);
+    if (int32_t(bucket.virtual_time - stream_shaping.virtual_time) < 0) {
+        // bucket has been idle; don't let it claim back its share
+        bucket.virtual_time = stream_shaping.virtual_time;
+    }
+    stream_shaping.virtual_time = bucket.virtual_time;
+    bucket.virtual_time += (uint32_t(num_sent) * SHAPING_WEIGHT_PRIORITY) / weight;
+}
+
+/*
+  once per second, work out how much of the link we used and adjust
+  the stretch applied to the bucket intervals to hold the link at the
+  MAVn_BW_TARG utilisation
+ */
+void GCS_MAVLINK::update_stream_shaping(uint32_t now_ms)
+{
+    const uint32_t dt_ms = now_ms - stream_shaping.window_start_ms;
+    if (dt_ms < 1000) {
+        return;
+    }
+
+    for (uint8_t i=0; i<NUM_STREAMS; i++) {
+        stream_shaping.achieved_rate_cHz[i] = MIN(stream_shaping.sent_count[i] * 100000U / dt_ms, uint32_t(UINT16_MAX));
+        stream_shaping.sent_count[i] = 0;
+    }
+
+    // the UART tells us the most we could ever send; a radio on the
+    // other end of it may be able to move much less than that
+    uint32_t capacity = _port->bw_in_bytes_per_second();
+    if (AP_HAL::millis() - last_radio_status.received_ms < 5000) {
+        capacity = capacity * stream_shaping.radio_capacity_pct / 100U;
+    }
+    stream_shaping.link_bytes_per_second = MAX(capacity, 1U);
+
+    const uint32_t bytes_per_second = uint64_t(stream_shaping.bytes_sent) * 1000U / dt_ms;
+    stream_shaping.utilisation_pct = MIN(bytes_per_second * 100U / stream_shaping.link_bytes_per_second, 255U);
+    const bool ran_out_of_space = out_of_space_to_send_count != stream_shaping.out_of_space_count;
+
+    const int8_t target_pct = bw_target_pct.get();
+    if (target_pct <= 0) {
+        stream_shaping.scale_pct = 100;
+    } else if (ran_out_of_space || stream_shaping.utilisation_pct > target_pct) {
+        // slow down in proportion to how far over target we are
+        const uint32_t over_pct = MAX(stream_shaping.utilisation_pct, uint8_t(target_pct)) * 100U / target_pct;
+        const uint32_t scale_pct = stream_shaping.scale_pct * MAX(over_pct, 110U) / 100U;
+        stream_shaping.scale_pct = MIN(scale_pct, uint32_t(SHAPING_SCALE_MAX_PCT));
+    } else if (stream_shaping.utilisation_pct < target_pct * 8 / 10) {
+        // plenty of headroom; speed back up gently
+        const uint16_t reduction = MAX((stream_shaping.scale_pct - 100U) / 4U, 1U);
+        stream_shaping.scale_pct = MAX(uint32_t(stream_shaping.scale_pct - reduction), 100U);
+    }
+
+    stream_shaping.bytes_sent = 0;
+    stream_shaping.out_of_space_count = out_of_space_to_send_count;
+    stream_shaping.window_start_ms = now_ms;
+}
+
+#if HAL_LOGGING_ENABLED
+/*
+  record the link estimate and the rate achieved by each stream
+ */
+void GCS_MAVLINK::log_stream_shaping_stats() const
+{
+    struct log_MAVS pkt{
+        LOG_PACKET_HEADER_INIT(LOG_MAVS_MSG),
+        time_us         : AP_HAL::micros64(),
+        chan            : (uint8_t)chan,
+        link_bw         : stream_shaping.link_bytes_per_second,
+        utilisation_pct : stream_shaping.utilisation_pct,
+        scale_pct       : stream_shaping.scale_pct,
+    };
+    static_assert(ARRAY_SIZE(pkt.rate) == NUM_STREAMS, "MAVS must have a rate for each stream");
+    memcpy(pkt.rate, stream_shaping.achieved_rate_cHz, sizeof(pkt.rate));
+    AP::logger().WriteBlock(&pkt, sizeof(pkt));
+}
+#endif  // HAL_LOGGING_ENABLED
+#endif  // AP_MAVLINK_STREAM_SHAPING_ENABLED
+
 bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_ms)
 {
     if (id == MSG_NEXT_PARAM) {
@@ -1813,10 +2004,18 @@ bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_
         // allocate a bucket for this interval
         deferred_message_bucket[empty_bucket_id].interval_ms = interval_ms;
         deferred_message_bucket[empty_bucket_id].last_sent_ms = AP_HAL::millis16();
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+        // new buckets start level with the bucket most recently serviced
+        deferred_message_bucket[empty_bucket_id].virtual_time = stream_shaping.virtual_time;
+#endif
         closest_bucket = empty_bucket_id;
     }
 
     deferred_message_bucket[closest_bucket].ap_message_ids.set(id);
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+    deferred_message_bucket[closest_bucket].weight = MAX(deferred_message_bucket[closest_bucket].weight,
+                                                         shaping_weight_for_ap_message(id));
+#endif
 
     if (sending_bucket_id == no_bucket_to_send) {
         sending_bucket_id = closest_bucket;
@@ -1940,10 +2139,34 @@ GCS_MAVLINK::update_receive(uint32_t max_time_us)
 
     status.packet_rx_drop_count = 0;
 
+    /*
+      parse straight from the port's buffer if the driver supports
+      zero copy reads. Alternative protocol handlers are given the
+      port, so use byte reads while one is installed
+     */
+    uint32_t rxlen = 0;
+    uint32_t consumed = 0;
+    const uint8_t *rxptr = alternative.handler == nullptr ? _port->read_peek(rxlen) : nullptr;
+    const bool peeking = rxptr != nullptr;
+
     const uint16_t nbytes = _port->available();
     for (uint16_t i=0; i<nbytes; i++)
     {
-        const uint8_t c = (uint8_t)_port->read();
+        uint8_t c;
+        if (peeking) {
+            if (consumed == rxlen) {
+                // release what we have parsed and get the next contiguous block
+                _port->read_advance(consumed);
+                consumed = 0;
+                rxptr = _port->read_peek(rxlen);
+                if (rxptr == nullptr) {
+                    break;
+                }
+            }
+            c = rxptr[consumed++];
+        } else {
+            c = (uint8_t)_port->read();
+        }
         const uint32_t protocol_timeout = 4000;
         
         if (alternative.handler &&
@@ -1972,6 +2195,13 @@ GCS_MAVLINK::update_receive(uint32_t max_time_us)
         // Try to get a new message
         const uint8_t framing = mavlink_frame_char_buffer(channel_buffer(), channel_status(), c, &msg, &status);
         if (framing != MAVLINK_FRAMING_INCOMPLETE) {
+            if (peeking) {
+                // message handlers may use or resize the port, so
+                // release the bytes first and peek again afterwards
+                _port->read_advance(consumed);
+                consumed = 0;
+                rxlen = 0;
+            }
             hal.util->persistent_data.last_mavlink_msgid = msg.msgid;
             raw_packetReceived(framing, status, msg);
             if (framing == MAVLINK_FRAMING_OK) {
@@ -1999,6 +2229,9 @@ GCS_MAVLINK::update_receive(uint32_t max_time_us)
             }
         }
     }
+    if (peeking) {
+        _port->read_advance(consumed);
+    }
 
     const uint32_t tnow = AP_HAL::millis();
 
@@ -2020,6 +2253,9 @@ GCS_MAVLINK::update_receive(uint32_t max_time_us)
     if (is_active() || is_streaming()) {
         if (tnow - last_mavlink_stats_logged > 1000) {
             log_mavlink_stats();
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+            log_stream_shaping_stats();
+#endif
             last_mavlink_stats_logged = tnow;
         }
     }
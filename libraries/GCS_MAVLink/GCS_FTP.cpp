@@ -40,6 +40,10 @@ GCS_FTP *GCS_FTP::ftp;
 // timeout for session inactivity, when we will kill an idle session
 #define FTP_SESSION_KILL_TIMEOUT 20000
 
+// worker sleep when there is nothing to do, which is also the longest
+// a new request waits while bursts are paced
+#define FTP_IDLE_DELAY_MS 2U
+
 bool GCS_FTP::init(void)
 {
     if (initialised) {
@@ -293,15 +297,216 @@ int GCS_FTP::Session::close(void)
 {
     int result = 0;
 
+    burst_stop();
+
     if (fd != -1) {
         result = AP::FS().close(fd);
         fd = -1;
     }
     last_send_ms = 0;
 
+    delete[] burst.buf;
+    burst.buf = nullptr;
+    burst.buf_size = 0;
+
     return result;
 }
 
+/*
+  start a burst read.  Returns true if the burst is underway, false
+  if reply has been filled in with a NACK to be sent instead
+ */
+bool GCS_FTP::Session::burst_start(const Transaction &request, Transaction &reply)
+{
+    const uint8_t max_read = (request.size == 0?sizeof(reply.data):request.size);
+
+    // must actually be working on a file
+    if (fd == -1) {
+        GCS_FTP::error(reply, FTP_ERROR::FileNotFound);
+        return false;
+    }
+
+    // must have the file in read mode
+    if ((mode != FTP_FILE_MODE::Read)) {
+        GCS_FTP::error(reply, FTP_ERROR::Fail);
+        return false;
+    }
+
+    // seek to requested offset
+    if (AP::FS().lseek(fd, request.offset, SEEK_SET) == -1) {
+        GCS_FTP::error(reply, FTP_ERROR::FailErrno);
+        return false;
+    }
+
+    if (burst.buf == nullptr) {
+        // try for a large buffer, but a single packet's worth will do
+        burst.buf = NEW_NOTHROW uint8_t[AP_MAVLINK_FTP_BURST_PREFETCH_SIZE];
+        burst.buf_size = AP_MAVLINK_FTP_BURST_PREFETCH_SIZE;
+        if (burst.buf == nullptr) {
+            burst.buf = NEW_NOTHROW uint8_t[sizeof(reply.data)];
+            burst.buf_size = sizeof(reply.data);
+        }
+        if (burst.buf == nullptr) {
+            burst.buf_size = 0;
+            GCS_FTP::error(reply, FTP_ERROR::Fail);
+            return false;
+        }
+    }
+
+    /*
+      calculate a burst delay so that FTP burst
+      transfer doesn't use more than 1/3 of
+      available bandwidth on links that don't have
+      flow control. This reduces the chance of
+      lost packets a lot, which results in overall
+      faster transfers
+    */
+    uint32_t burst_delay_ms = 0;
+    if (valid_channel(request.chan)) {
+        auto *port = mavlink_comm_port[request.chan];
+        if (port != nullptr && port->get_flow_control() != AP_HAL::UARTDriver::FLOW_CONTROL_ENABLE) {
+            const uint32_t bw = port->bw_in_bytes_per_second();
+            const uint16_t pkt_size = PAYLOAD_SIZE(request.chan, FILE_TRANSFER_PROTOCOL) - (sizeof(reply.data) - max_read);
+            burst_delay_ms = 3000 * pkt_size / bw;
+        }
+    }
+
+    burst.session = request.session;
+    burst.max_read = max_read;
+    burst.seq_number = reply.seq_number;
+    // this transfer size is enough for a full parameter file with max parameters
+    burst.packets_remaining = 2000;
+    burst.delay_ms = MIN(burst_delay_ms, uint32_t(UINT16_MAX));
+    burst.last_packet_ms = AP_HAL::millis() - burst.delay_ms;
+    burst.offset = request.offset;
+    burst.buf_len = 0;
+    burst.buf_ofs = 0;
+    burst.eof = false;
+    burst.read_failed = false;
+    burst.last_complete = false;
+    burst.active = true;
+
+    // get the first chunk in hand before the first packet goes out
+    burst_prefetch();
+
+    return true;
+}
+
+void GCS_FTP::Session::burst_stop(void)
+{
+    burst.active = false;
+    burst.buf_len = 0;
+    burst.buf_ofs = 0;
+}
+
+/*
+  top up the prefetch buffer from the file.  Returns true if any data
+  was read
+ */
+bool GCS_FTP::Session::burst_prefetch(void)
+{
+    if (burst.eof || burst.buf == nullptr) {
+        return false;
+    }
+    if (burst.buf_ofs > 0) {
+        // move the unsent data to the start of the buffer
+        memmove(burst.buf, &burst.buf[burst.buf_ofs], burst.buf_len - burst.buf_ofs);
+        burst.buf_len -= burst.buf_ofs;
+        burst.buf_ofs = 0;
+    }
+    if (burst.buf_size - burst.buf_len < burst.max_read) {
+        // already have enough for the next packet
+        return false;
+    }
+    const ssize_t read_bytes = AP::FS().read(fd, &burst.buf[burst.buf_len], burst.buf_size - burst.buf_len);
+    if (read_bytes <= 0) {
+        burst.read_failed = (read_bytes == -1);
+        burst.eof = true;
+        return false;
+    }
+    burst.buf_len += read_bytes;
+    return true;
+}
+
+/*
+  milliseconds until the next packet of an active burst read is due
+ */
+uint32_t GCS_FTP::Session::burst_wait_ms(void) const
+{
+    const uint32_t since_ms = AP_HAL::millis() - burst.last_packet_ms;
+    return since_ms < burst.delay_ms ? burst.delay_ms - since_ms : 0;
+}
+
+/*
+  send the next packet of an active burst read.  Returns true if any
+  work was done
+ */
+bool GCS_FTP::Session::burst_update(void)
+{
+    if (!burst.active) {
+        return false;
+    }
+
+    // read ahead while we wait for the link
+    const uint32_t now = AP_HAL::millis();
+    if (now - burst.last_packet_ms < burst.delay_ms) {
+        return burst_prefetch();
+    }
+    const uint16_t available = burst.buf_len - burst.buf_ofs;
+    if (available < burst.max_read && !burst.eof) {
+        burst_prefetch();
+    }
+
+    Transaction reply {};
+    reply.req_opcode = FTP_OP::BurstReadFile;
+    reply.session = burst.session;
+    reply.seq_number = burst.seq_number;
+    reply.chan = chan;
+    reply.sysid = sysid;
+    reply.compid = compid;
+    reply.offset = burst.offset;
+
+    const uint8_t read_bytes = MIN(burst.buf_len - burst.buf_ofs, burst.max_read);
+    if (read_bytes == 0) {
+        GCS_FTP::error(reply, burst.read_failed ? FTP_ERROR::FailErrno : FTP_ERROR::EndOfFile);
+        reply.burst_complete = burst.last_complete;
+    } else {
+        memcpy(reply.data, &burst.buf[burst.buf_ofs], read_bytes);
+        reply.opcode = FTP_OP::Ack;
+        reply.size = read_bytes;
+        reply.burst_complete = (read_bytes < burst.max_read) || (burst.packets_remaining == 1);
+    }
+
+    if (!send_reply(reply)) {
+        // no room on the link; make use of the time
+        return burst_prefetch();
+    }
+    last_send_ms = now; // Used to detect active FTP session
+    burst.last_packet_ms = now;
+
+    if (reply.opcode == FTP_OP::Nack) {
+        burst_stop();
+        return true;
+    }
+
+    burst.buf_ofs += read_bytes;
+    burst.offset += read_bytes;
+    burst.seq_number++;
+    burst.packets_remaining--;
+    burst.last_complete = reply.burst_complete;
+
+    if (burst.packets_remaining == 0) {
+        burst_stop();
+    } else if (read_bytes < burst.max_read) {
+        // a short read means the end of the file; we follow it with
+        // an EOF NACK at the next offset
+        burst.buf_ofs = burst.buf_len;
+        burst.eof = true;
+    }
+
+    return true;
+}
+
 /*
   handle one request on a session
 
@@ -552,91 +757,10 @@ bool GCS_FTP::Session::handle_request(Transaction &request, Transaction &reply)
         break;
     }
     case FTP_OP::BurstReadFile:
-    {
-        const uint16_t max_read = (request.size == 0?sizeof(reply.data):request.size);
-        // must actually be working on a file
-        if (fd == -1) {
-            GCS_FTP::error(reply, FTP_ERROR::FileNotFound);
-            break;
-        }
-
-        // must have the file in read mode
-        if ((mode != FTP_FILE_MODE::Read)) {
-            GCS_FTP::error(reply, FTP_ERROR::Fail);
-            break;
-        }
-
-        // seek to requested offset
-        if (AP::FS().lseek(fd, request.offset, SEEK_SET) == -1) {
-            GCS_FTP::error(reply, FTP_ERROR::FailErrno);
-            break;
-        }
-
-        /*
-          calculate a burst delay so that FTP burst
-          transfer doesn't use more than 1/3 of
-          available bandwidth on links that don't have
-          flow control. This reduces the chance of
-          lost packets a lot, which results in overall
-          faster transfers
-        */
-        uint32_t burst_delay_ms = 0;
-        if (valid_channel(request.chan)) {
-            auto *port = mavlink_comm_port[request.chan];
-            if (port != nullptr && port->get_flow_control() != AP_HAL::UARTDriver::FLOW_CONTROL_ENABLE) {
-                const uint32_t bw = port->bw_in_bytes_per_second();
-                const uint16_t pkt_size = PAYLOAD_SIZE(request.chan, FILE_TRANSFER_PROTOCOL) - (sizeof(reply.data) - max_read);
-                burst_delay_ms = 3000 * pkt_size / bw;
-            }
-        }
-
-        // this transfer size is enough for a full parameter file with max parameters
-        const uint32_t transfer_size = 2000;
-        for (uint32_t i = 0; (i < transfer_size); i++) {
-            // fill the buffer
-            const ssize_t read_bytes = AP::FS().read(fd, reply.data, MIN(sizeof(reply.data), max_read));
-            if (read_bytes == -1) {
-                GCS_FTP::error(reply, FTP_ERROR::FailErrno);
-                break;
-            }
-
-            if (read_bytes != sizeof(reply.data)) {
-                // don't send any old data
-                memset(reply.data + read_bytes, 0, sizeof(reply.data) - read_bytes);
-            }
-
-            if (read_bytes == 0) {
-                GCS_FTP::error(reply, FTP_ERROR::EndOfFile);
-                break;
-            }
-
-            reply.opcode = FTP_OP::Ack;
-            reply.offset = request.offset + i * max_read;
-            reply.burst_complete = ((read_bytes < max_read) || (i == (transfer_size - 1)));
-            reply.size = (uint8_t)read_bytes;
-
-            push_reply(reply);
-
-            if (read_bytes < max_read) {
-                // ensure the NACK which we send next is at the right offset
-                reply.offset += read_bytes;
-            }
-
-            // prep the reply to be used again
-            reply.seq_number++;
-
-            if (burst_delay_ms > 0) {
-                hal.scheduler->delay(burst_delay_ms);
-            }
-        }
-
-        if (reply.opcode != FTP_OP::Nack) {
-            // prevent a duplicate packet send for
-            // normal replies of burst reads
-            skip_push_reply = true;
-        }
+        // the worker streams the burst out; don't send a reply now
+        // unless we failed to start it
+        skip_push_reply = burst_start(request, reply);
         break;
-    }
 
     case FTP_OP::Rename: {
         // sanity check that the request looks well formed
@@ -733,106 +857,149 @@ void GCS_FTP::setup_reply(const Transaction &request, Transaction &reply)
 }
 
 /*
-  main FTP thread
+  handle one request from the queue.  Returns false if there were no
+  requests waiting
  */
-void GCS_FTP::worker(void)
+bool GCS_FTP::handle_next_request(Transaction &request, Transaction &reply)
 {
-    Transaction request;
-    Transaction reply {};
-    reply.session = -1; // flag the reply as invalid for any reuse
+    if (!requests.pop(request)) {
+        return false;
+    }
 
-    while (true) {
-        while (!requests.pop(request)) {
-            // nothing to handle, delay ourselves a bit then check again. Ideally we'd use conditional waits here
-            hal.scheduler->delay(2);
-
-            // kill any dead sessions
-            const uint32_t now = AP_HAL::millis();
-            for (auto &s : sessions) {
-                if (s.last_send_ms != 0 &&
-                    now - s.last_send_ms > FTP_SESSION_KILL_TIMEOUT) {
-                    s.close();   // error code ignored
-                }
+    if (request.opcode == FTP_OP::ResetSessions) {
+        /*
+          close all sessions for this channel, compid and sysid
+         */
+        for (auto &s : sessions) {
+            if (request.sysid == s.sysid &&
+                request.compid == s.compid &&
+                request.chan == s.chan) {
+                // close this session
+                s.close();   // error code ignored
             }
         }
+        // always ACK, even if no sessions were closed
+        setup_reply(request, reply);
+        reply.opcode = FTP_OP::Ack;
+        send_reply(reply);
+        return true;
+    }
 
-        if (request.opcode == FTP_OP::ResetSessions) {
-            /*
-              close all sessions for this channel, compid and sysid
-             */
-            for (auto &s : sessions) {
-                if (request.sysid == s.sysid &&
-                    request.compid == s.compid &&
-                    request.chan == s.chan) {
-                    // close this session
-                    s.close();   // error code ignored
-                }
-            }
-            // always ACK, even if no sessions were closed
-            setup_reply(request, reply);
-            reply.opcode = FTP_OP::Ack;
-            send_reply(reply);
-            continue;
+    Session *session = nullptr;
+    for (uint8_t i=0; i<ARRAY_SIZE(sessions); i++) {
+        auto &s = sessions[i];
+        if (request.sysid == s.sysid &&
+            request.compid == s.compid &&
+            request.chan == s.chan &&
+            request.session == s.session_id) {
+            // found the session
+            session = &s;
+            break;
         }
+    }
 
-        Session *session = nullptr;
-        for (uint8_t i=0; i<ARRAY_SIZE(sessions); i++) {
+    if (session == nullptr) {
+        /*
+          find the oldest session to possibly reuse
+         */
+        const uint32_t now = AP_HAL::millis();
+        session = &sessions[0];
+        for (uint8_t i=1; i<ARRAY_SIZE(sessions); i++) {
             auto &s = sessions[i];
-            if (request.sysid == s.sysid &&
-                request.compid == s.compid &&
-                request.chan == s.chan &&
-                request.session == s.session_id) {
-                // found the session
+            if ((now - s.last_send_ms) > (now - session->last_send_ms)) {
                 session = &s;
-                break;
             }
         }
 
-        if (session == nullptr) {
-            /*
-              find the oldest session to possibly reuse
-             */
-            const uint32_t now = AP_HAL::millis();
-            session = &sessions[0];
-            for (uint8_t i=1; i<ARRAY_SIZE(sessions); i++) {
-                auto &s = sessions[i];
-                if ((now - s.last_send_ms) > (now - session->last_send_ms)) {
-                    session = &s;
-                }
-            }
+        // only reuse the session if it is not active
+        auto &s = *session;
+        if (s.last_send_ms != 0 &&
+            now - s.last_send_ms < FTP_SESSION_TIMEOUT) {
+            // the oldest session is still active, reject the request
+            setup_reply(request, reply);
+            error(reply, FTP_ERROR::NoSessionsAvailable);
+            send_reply(reply);
+            return true;
+        }
+        // claim the session
+        s.close();   // error code ignored
+        s.session_id = request.session;
+        s.sysid = request.sysid;
+        s.compid = request.compid;
+        s.chan = request.chan;
+    }
 
-            // only reuse the session if it is not active
-            auto &s = *session;
-            if (s.last_send_ms != 0 &&
-                now - s.last_send_ms < FTP_SESSION_TIMEOUT) {
-                // the oldest session is still active, reject the request
-                setup_reply(request, reply);
-                error(reply, FTP_ERROR::NoSessionsAvailable);
-                send_reply(reply);
-                continue;
+    // any new request on a session supersedes a burst in progress
+    session->burst_stop();
+
+    // if it's a rerequest and we still have the last response then send it
+    if ((request.sysid == reply.sysid) && (request.compid == reply.compid) &&
+        (request.session == reply.session) && (request.seq_number + 1 == reply.seq_number) &&
+        reply.data[0] != uint8_t(FTP_ERROR::NoSessionsAvailable)) {
+        session->push_reply(reply);
+        return true;
+    }
+
+    setup_reply(request, reply);
+
+    bool skip_push_reply = session->handle_request(request, reply);
+
+    if (!skip_push_reply) {
+        session->push_reply(reply);
+    } else if (session->burst_active()) {
+        // the burst packets carry their own sequence numbers; a
+        // repeat of the burst request restarts the burst
+        reply.session = -1;
+    }
+
+    return true;
+}
+
+/*
+  main FTP thread
+ */
+void GCS_FTP::worker(void)
+{
+    Transaction request;
+    Transaction reply {};
+    reply.session = -1; // flag the reply as invalid for any reuse
+
+    while (true) {
+        bool did_work = handle_next_request(request, reply);
+
+        // move each burst read along by one packet, so that several
+        // GCSs and companions can download at once
+        bool bursting = false;
+        uint32_t wait_ms = FTP_IDLE_DELAY_MS;
+        for (auto &s : sessions) {
+            did_work |= s.burst_update();
+            if (s.burst_active()) {
+                bursting = true;
+                wait_ms = MIN(wait_ms, s.burst_wait_ms());
             }
-            // claim the session
-            s.close();   // error code ignored
-            s.session_id = request.session;
-            s.sysid = request.sysid;
-            s.compid = request.compid;
-            s.chan = request.chan;
-        }
-
-        // if it's a rerequest and we still have the last response then send it
-        if ((request.sysid == reply.sysid) && (request.compid == reply.compid) &&
-            (request.session == reply.session) && (request.seq_number + 1 == reply.seq_number) &&
-            reply.data[0] != uint8_t(FTP_ERROR::NoSessionsAvailable)) {
-            session->push_reply(reply);
+        }
+
+        if (did_work) {
             continue;
         }
 
-        setup_reply(request, reply);
+        if (bursting) {
+            // sleep until the next burst packet is due, or for a tick if
+            // waiting on space in the link
+            hal.scheduler->delay(MAX(wait_ms, 1U));
+            continue;
+        }
 
-        bool skip_push_reply = session->handle_request(request, reply);
+        // nothing to handle, delay ourselves a bit then check again. Ideally we'd use conditional waits here
+        hal.scheduler->delay(FTP_IDLE_DELAY_MS);
 
-        if (!skip_push_reply) {
-            session->push_reply(reply);
+        // kill any dead sessions
+        const uint32_t now = AP_HAL::millis();
+        for (auto &s : sessions) {
+            if (s.last_send_ms != 0 &&
+                now - s.last_send_ms > FTP_SESSION_KILL_TIMEOUT) {
+                s.close();   // error code ignored
+            }
         }
     }
 }
@@ -14,6 +14,17 @@
 #define AP_MAVLINK_FTP_MAX_SESSIONS 5
 #endif
 
+// size of the per-session buffer burst reads are streamed from.
+// Reading the file in large chunks is much cheaper than a
+// filesystem read per packet, particularly on SD cards
+#ifndef AP_MAVLINK_FTP_BURST_PREFETCH_SIZE
+#if HAL_PROGRAM_SIZE_LIMIT_KB > 1024
+#define AP_MAVLINK_FTP_BURST_PREFETCH_SIZE 2048
+#else
+#define AP_MAVLINK_FTP_BURST_PREFETCH_SIZE 512
+#endif
+#endif
+
 class GCS_FTP {
 public:
     static void handle_file_transfer_protocol(const mavlink_message_t &msg, mavlink_channel_t chan);
@@ -95,7 +106,37 @@ private:
         void push_reply(Transaction &reply);
         bool handle_request(Transaction &request, Transaction &reply);
 
+        // burst reads are streamed out by the worker a packet at a
+        // time, interleaved with the other sessions, rather than
+        // blocking the worker until the whole burst has gone
+        bool burst_active(void) const { return burst.active; }
+        bool burst_update(void);
+        uint32_t burst_wait_ms(void) const;
+        void burst_stop(void);
+
         int close(void);
+
+    private:
+        bool burst_start(const Transaction &request, Transaction &reply);
+        bool burst_prefetch(void);
+
+        struct {
+            bool active;
+            bool eof;                 // no more file data to read
+            bool read_failed;
+            bool last_complete;       // burst_complete flag of the last packet sent
+            uint8_t session;
+            uint8_t max_read;         // bytes per packet
+            uint16_t seq_number;      // of the next packet
+            uint16_t packets_remaining;
+            uint16_t delay_ms;        // between packets, on links without flow control
+            uint32_t last_packet_ms;
+            uint32_t offset;          // file offset of the next packet
+            uint8_t *buf;             // prefetched file data
+            uint16_t buf_size;
+            uint16_t buf_len;         // bytes of valid data in buf
+            uint16_t buf_ofs;         // bytes of buf already sent
+        } burst;
     };
     Session sessions[AP_MAVLINK_FTP_MAX_SESSIONS];
 
@@ -110,6 +151,7 @@ private:
     void setup_reply(const Transaction &request, Transaction &reply);
 
     void worker(void);
+    bool handle_next_request(Transaction &request, Transaction &reply);
 
     // GCS_FTP instance created by static handle_file_transfer_protocol()
     static GCS_FTP *ftp;
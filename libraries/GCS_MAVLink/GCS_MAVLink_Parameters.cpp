@@ -221,6 +221,25 @@ const AP_Param::GroupInfo GCS_MAVLINK::var_info[] = {
     // This allows one time conversion while allowing user to flash between versions with and without converted params
     AP_GROUPINFO_FLAGS("_OPTIONSCNV",   21, GCS_MAVLINK, options_were_converted, 0, AP_PARAM_FLAG_HIDDEN),
 
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+    // @Param: _BW_TARG
+    // @DisplayName: Link utilisation target
+    // @Description: Percentage of the estimated link capacity this channel aims to use for streamed messages. The link capacity is estimated from the port's baud rate and from RADIO_STATUS reports. When the link is busier than this, stream intervals are stretched, with priority streams (see MAVx_BW_PRIO) being stretched less than others. Zero disables bandwidth shaping.
+    // @Units: %
+    // @Range: 0 100
+    // @Increment: 1
+    // @User: Advanced
+    AP_GROUPINFO("_BW_TARG",   22, GCS_MAVLINK, bw_target_pct, 0),
+
+    // @Param: _BW_PRIO
+    // @DisplayName: Priority streams
+    // @Description: Streams which are given a larger share of the link when bandwidth shaping is active (see MAVx_BW_TARG)
+    // @Bitmask: 0:RAW_SENS, 1:EXT_STAT, 2:RC_CHAN, 3:RAW_CTRL, 4:POSITION, 5:EXTRA1, 6:EXTRA2, 7:EXTRA3, 8:PARAMS, 9:ADSB
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("_BW_PRIO",   23, GCS_MAVLINK, bw_priority_streams, (1U<<GCS_MAVLINK::STREAM_EXTENDED_STATUS) | (1U<<GCS_MAVLINK::STREAM_POSITION) | (1U<<GCS_MAVLINK::STREAM_EXTRA1)),
+#endif
+
     AP_GROUPEND
 };
 #undef DRATE
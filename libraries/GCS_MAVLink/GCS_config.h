@@ -143,6 +143,11 @@
 #define AP_MAVLINK_MSG_VIDEO_STREAM_INFORMATION_ENABLED HAL_GCS_ENABLED
 #endif
 
+// bandwidth-aware, weighted shaping of stream-rated messages
+#ifndef AP_MAVLINK_STREAM_SHAPING_ENABLED
+#define AP_MAVLINK_STREAM_SHAPING_ENABLED HAL_GCS_ENABLED && (HAL_PROGRAM_SIZE_LIMIT_KB > 1024)
+#endif  // AP_MAVLINK_STREAM_SHAPING_ENABLED
+
 #ifndef AP_MAVLINK_MSG_FLIGHT_INFORMATION_ENABLED
 #define AP_MAVLINK_MSG_FLIGHT_INFORMATION_ENABLED HAL_GCS_ENABLED && AP_ARMING_ENABLED
 #endif  // AP_MAVLINK_MSG_FLIGHT_INFORMATION_ENABLED
@@ -0,0 +1,234 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file	MAVLink_RouteTable.cpp
+/// @brief	hashed table of learned MAVLink routes, keyed by sysid/compid
+
+#include "GCS_config.h"
+
+#if HAL_GCS_ENABLED
+
+#include "MAVLink_RouteTable.h"
+
+/*
+  multiplicative (Fibonacci) hashing; the middle bits of the product
+  are well mixed for the small keys we have
+ */
+uint16_t MAVLink_RouteTable::route_hash(uint8_t sysid, uint8_t compid)
+{
+    const uint32_t key = (uint32_t(sysid) << 8) | compid;
+    return ((key * 2654435761U) >> 16) & (NUM_SLOTS - 1);
+}
+
+uint16_t MAVLink_RouteTable::system_hash(uint8_t sysid)
+{
+    return ((uint32_t(sysid) * 2654435761U) >> 16) & (NUM_SLOTS - 1);
+}
+
+/*
+  return the slot holding sysid/compid, or the empty slot where it
+  would be placed.  There is always at least one empty slot, so this
+  terminates.
+ */
+uint16_t MAVLink_RouteTable::route_slot(uint8_t sysid, uint8_t compid) const
+{
+    uint16_t i = route_hash(sysid, compid);
+    while (routes[i].sysid != 0) {
+        if (routes[i].sysid == sysid && routes[i].compid == compid) {
+            break;
+        }
+        i = next_slot(i);
+    }
+    return i;
+}
+
+uint16_t MAVLink_RouteTable::system_slot(uint8_t sysid) const
+{
+    uint16_t i = system_hash(sysid);
+    while (systems[i].sysid != 0 && systems[i].sysid != sysid) {
+        i = next_slot(i);
+    }
+    return i;
+}
+
+const MAVLink_RouteTable::Route *MAVLink_RouteTable::find(uint8_t sysid, uint8_t compid) const
+{
+    if (sysid == 0) {
+        return nullptr;
+    }
+    const uint16_t i = route_slot(sysid, compid);
+    return routes[i].sysid != 0 ? &routes[i] : nullptr;
+}
+
+MAVLink_RouteTable::Route *MAVLink_RouteTable::find(uint8_t sysid, uint8_t compid)
+{
+    if (sysid == 0) {
+        return nullptr;
+    }
+    const uint16_t i = route_slot(sysid, compid);
+    return routes[i].sysid != 0 ? &routes[i] : nullptr;
+}
+
+mavlink_channel_mask_t MAVLink_RouteTable::system_channels(uint8_t sysid) const
+{
+    if (sysid == 0) {
+        return 0;
+    }
+    return systems[system_slot(sysid)].channels;
+}
+
+MAVLink_RouteTable::Route *MAVLink_RouteTable::learn(uint8_t sysid, uint8_t compid, mavlink_channel_t chan, uint32_t now_ms)
+{
+    if (sysid == 0) {
+        // zero marks empty slots; we never route to the broadcast system
+        return nullptr;
+    }
+
+    uint16_t i = route_slot(sysid, compid);
+    if (routes[i].sysid == 0) {
+        if (num_routes >= MAVLINK_MAX_ROUTES) {
+            if (expire(now_ms) == 0) {
+                return nullptr;
+            }
+            // removal may have shifted entries; probe again
+            i = route_slot(sysid, compid);
+        }
+        routes[i] = Route {
+            sysid: sysid,
+            compid: compid,
+            mavtype: 0,
+            channels: 0,
+            last_seen_ms: now_ms,
+        };
+        num_routes++;
+
+        const uint16_t s = system_slot(sysid);
+        systems[s].sysid = sysid;
+        systems[s].num_routes++;
+    }
+
+    Route &route = routes[i];
+    route.last_seen_ms = now_ms;
+
+    const mavlink_channel_mask_t chan_bit = 1U << (chan - MAVLINK_COMM_0);
+    if ((route.channels & chan_bit) == 0) {
+        route.channels |= chan_bit;
+        systems[system_slot(sysid)].channels |= chan_bit;
+        routed_channels |= chan_bit;
+    }
+
+    return &route;
+}
+
+/*
+  forget every route which has been quiet for long enough that it has
+  probably gone away.  Removal shifts later entries back into the
+  freed slot, so a slot is checked again after a removal
+ */
+uint16_t MAVLink_RouteTable::expire(uint32_t now_ms)
+{
+    uint16_t removed = 0;
+    for (uint16_t i=0; i<NUM_SLOTS; ) {
+        if (routes[i].sysid != 0 &&
+            now_ms - routes[i].last_seen_ms > MAVLINK_ROUTE_EXPIRE_MS) {
+            forget(i);
+            removed++;
+            continue;
+        }
+        i++;
+    }
+    if (removed == 0) {
+        return 0;
+    }
+
+    routed_channels = 0;
+    for (uint16_t i=0; i<NUM_SLOTS; i++) {
+        routed_channels |= routes[i].channels;
+    }
+
+    return removed;
+}
+
+// remove the route in slot i and update its system
+void MAVLink_RouteTable::forget(uint16_t i)
+{
+    const uint8_t sysid = routes[i].sysid;
+    remove_route(i);
+
+    const uint16_t s = system_slot(sysid);
+    if (--systems[s].num_routes == 0) {
+        remove_system(s);
+    } else {
+        update_system_channels(sysid);
+    }
+}
+
+/*
+  remove a route using backward-shift deletion so that no tombstones
+  are needed: entries after the hole are moved back into it unless
+  their home slot lies between the hole and where they sit now
+ */
+void MAVLink_RouteTable::remove_route(uint16_t i)
+{
+    uint16_t j = i;
+    while (true) {
+        j = next_slot(j);
+        if (routes[j].sysid == 0) {
+            break;
+        }
+        const uint16_t k = route_hash(routes[j].sysid, routes[j].compid);
+        const bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+        if (stays) {
+            continue;
+        }
+        routes[i] = routes[j];
+        i = j;
+    }
+    routes[i] = Route {};
+    num_routes--;
+}
+
+void MAVLink_RouteTable::remove_system(uint16_t i)
+{
+    uint16_t j = i;
+    while (true) {
+        j = next_slot(j);
+        if (systems[j].sysid == 0) {
+            break;
+        }
+        const uint16_t k = system_hash(systems[j].sysid);
+        const bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+        if (stays) {
+            continue;
+        }
+        systems[i] = systems[j];
+        i = j;
+    }
+    systems[i] = System {};
+}
+
+// recalculate the channels a system is reachable on after a route is removed
+void MAVLink_RouteTable::update_system_channels(uint8_t sysid)
+{
+    mavlink_channel_mask_t channels = 0;
+    for (uint16_t i=0; i<NUM_SLOTS; i++) {
+        if (routes[i].sysid == sysid) {
+            channels |= routes[i].channels;
+        }
+    }
+    systems[system_slot(sysid)].channels = channels;
+}
+
+#endif  // HAL_GCS_ENABLED
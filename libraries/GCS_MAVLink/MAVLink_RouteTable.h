@@ -0,0 +1,123 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file	MAVLink_RouteTable.h
+/// @brief	hashed table of learned MAVLink routes, keyed by sysid/compid
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include "GCS_MAVLink.h"
+
+#ifndef MAVLINK_MAX_ROUTES
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+// companion-heavy and swarm setups relay for many components
+#define MAVLINK_MAX_ROUTES 256
+#elif HAL_PROGRAM_SIZE_LIMIT_KB > 1024
+#define MAVLINK_MAX_ROUTES 64
+#else
+#define MAVLINK_MAX_ROUTES 20
+#endif
+#endif  // MAVLINK_MAX_ROUTES
+
+// a route which hasn't been heard from for this long is forgotten
+#ifndef MAVLINK_ROUTE_EXPIRE_MS
+#define MAVLINK_ROUTE_EXPIRE_MS 30000U
+#endif
+
+// number of slots in the route table; a power of two comfortably
+// above MAVLINK_MAX_ROUTES so probe sequences stay short
+static constexpr uint16_t mavlink_route_table_slots(uint16_t n=8)
+{
+    return n >= MAVLINK_MAX_ROUTES + MAVLINK_MAX_ROUTES/2 ? n : mavlink_route_table_slots(n*2);
+}
+
+/*
+  open-addressed (linear probing) hash table of routes.  Each route
+  records every channel a sysid/compid has been heard on, and a
+  second table keyed on sysid alone holds the union of those channels
+  so that system-wide forwarding decisions are also a single lookup.
+ */
+class MAVLink_RouteTable
+{
+    friend class MAVLink_RouteTable_Test;
+public:
+    struct Route {
+        uint8_t sysid;      // zero marks an empty slot
+        uint8_t compid;
+        uint8_t mavtype;
+        mavlink_channel_mask_t channels;
+        uint32_t last_seen_ms;
+    };
+
+    static const uint16_t NUM_SLOTS = mavlink_route_table_slots();
+    static uint16_t num_slots() { return NUM_SLOTS; }
+
+    /*
+      note that sysid/compid has been heard on chan.  Returns the
+      route, or nullptr if the table is full of recently-heard routes
+     */
+    Route *learn(uint8_t sysid, uint8_t compid, mavlink_channel_t chan, uint32_t now_ms);
+
+    /*
+      forget routes which haven't been heard from for
+      MAVLINK_ROUTE_EXPIRE_MS.  Returns the number removed
+     */
+    uint16_t expire(uint32_t now_ms);
+
+    // return the route for sysid/compid, or nullptr if not known
+    const Route *find(uint8_t sysid, uint8_t compid) const;
+    Route *find(uint8_t sysid, uint8_t compid);
+
+    // channels on which any component of sysid has been heard
+    mavlink_channel_mask_t system_channels(uint8_t sysid) const;
+
+    // channels on which any component at all has been heard
+    mavlink_channel_mask_t all_channels() const { return routed_channels; }
+
+    uint16_t count() const { return num_routes; }
+
+    // slot-order access for the (rare) searches that aren't keyed on
+    // sysid/compid.  Returns nullptr for empty slots
+    const Route *slot(uint16_t i) const {
+        return routes[i].sysid != 0 ? &routes[i] : nullptr;
+    }
+
+private:
+    static_assert((NUM_SLOTS & (NUM_SLOTS-1)) == 0, "route table must be a power of two");
+    static_assert(NUM_SLOTS > MAVLINK_MAX_ROUTES, "route table must have free slots");
+
+    struct System {
+        uint8_t sysid;      // zero marks an empty slot
+        uint16_t num_routes;
+        mavlink_channel_mask_t channels;
+    };
+
+    Route routes[NUM_SLOTS];
+    System systems[NUM_SLOTS];
+    uint16_t num_routes;
+    mavlink_channel_mask_t routed_channels;
+
+    static uint16_t route_hash(uint8_t sysid, uint8_t compid);
+    static uint16_t system_hash(uint8_t sysid);
+    static uint16_t next_slot(uint16_t i) { return (i + 1) & (NUM_SLOTS - 1); }
+
+    uint16_t route_slot(uint8_t sysid, uint8_t compid) const;
+    uint16_t system_slot(uint8_t sysid) const;
+
+    void forget(uint16_t i);
+    void remove_route(uint16_t i);
+    void remove_system(uint16_t i);
+    void update_system_channels(uint8_t sysid);
+};
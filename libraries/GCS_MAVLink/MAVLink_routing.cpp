@@ -33,7 +33,7 @@ extern const AP_HAL::HAL& hal;
 #define ROUTING_DEBUG 0
 
 // constructor
-MAVLink_routing::MAVLink_routing(void) : num_routes(0) {}
+MAVLink_routing::MAVLink_routing(void) {}
 
 /*
   forward a MAVLink message to the right port. This also
@@ -204,45 +204,52 @@ bool MAVLink_routing::forward(GCS_MAVLINK &in_link,
         return true;
     }
 
+    // work out which channels have routes matching the targets
+    mavlink_channel_mask_t out_channels;
+    if (broadcast_system) {
+        out_channels = route_table.all_channels();
+    } else if (broadcast_component || !match_system) {
+        out_channels = route_table.system_channels(target_system);
+    } else {
+        out_channels = 0;
+    }
+
+    // private channels only get packets explicitly targeted at a
+    // component we have seen on them
+    out_channels &= ~GCS_MAVLINK::private_channel_mask();
+    if (!broadcast_system && target_component != -1) {
+        const MAVLink_RouteTable::Route *route = route_table.find(target_system, target_component);
+        if (route != nullptr) {
+            out_channels |= route->channels;
+        }
+    }
+
+    // never send back out the channel it came in on
+    out_channels &= ~(1U<<(in_link.get_chan()-MAVLINK_COMM_0));
+
     // forward on any channels matching the targets
     bool forwarded = false;
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-    for (uint8_t i=0; i<num_routes; i++) {
+    while (out_channels != 0) {
+        const mavlink_channel_t channel = first_channel(out_channels);
+        out_channels &= ~(1U<<(channel-MAVLINK_COMM_0));
 
-        // Skip if channel is private and the target system or component IDs do not match
-        GCS_MAVLINK *out_link = gcs().chan(routes[i].channel);
+        GCS_MAVLINK *out_link = gcs().chan(channel);
         if (out_link == nullptr) {
             // this is bad
             continue;
         }
-        if (out_link->is_private() &&
-            (target_system != routes[i].sysid ||
-             target_component != routes[i].compid)) {
-            continue;
-        }
-
-        if (broadcast_system || (target_system == routes[i].sysid &&
-                                 (broadcast_component || 
-                                  target_component == routes[i].compid ||
-                                  !match_system))) {
-
-            if (&in_link != out_link && !sent_to_chan[routes[i].channel]) {
-                if (out_link->check_payload_size(msg.len)) {
+        if (out_link->check_payload_size(msg.len)) {
 #if ROUTING_DEBUG
-                    ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
-                             msg.msgid,
-                             (unsigned)in_link.get_chan(),
-                             (unsigned)routes[i].channel,
-                             (int)target_system,
-                             (int)target_component);
+            ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
+                     msg.msgid,
+                     (unsigned)in_link.get_chan(),
+                     (unsigned)channel,
+                     (int)target_system,
+                     (int)target_component);
 #endif
-                    _mavlink_resend_uart(routes[i].channel, &msg);
-                }
-                sent_to_chan[routes[i].channel] = true;
-                forwarded = true;
-            }
+            _mavlink_resend_uart(channel, &msg);
         }
+        forwarded = true;
     }
 
     if ((!forwarded && match_system) ||
@@ -269,29 +276,23 @@ void MAVLink_routing::send_to_components(uint32_t msgid, const char *pkt, uint8_
 
 void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entry_t *entry, const uint8_t pkt_len)
 {
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS] {};
+    // channels on which our system ID has been seen
+    mavlink_channel_mask_t channels = route_table.system_channels(mavlink_system.sysid);
 
-    // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid != mavlink_system.sysid) {
-            // our system ID hasn't been seen on this link
-            continue;
-        }
-        if (sent_to_chan[routes[i].channel]) {
-            // we've already send it on this link
-            continue;
-        }
-        if (comm_get_txspace(routes[i].channel) <
-            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
+    while (channels != 0) {
+        const mavlink_channel_t channel = first_channel(channels);
+        channels &= ~(1U<<(channel-MAVLINK_COMM_0));
+
+        if (comm_get_txspace(channel) <
+            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(channel)) {
             // it doesn't fit on this channel
             continue;
         }
 #if ROUTING_DEBUG
-        ::printf("send msg %u on chan %u sysid=%u compid=%u\n",
+        ::printf("send msg %u on chan %u sysid=%u\n",
                  entry->msgid,
-                 (unsigned)routes[i].channel,
-                 (unsigned)routes[i].sysid,
-                 (unsigned)routes[i].compid);
+                 (unsigned)channel,
+                 (unsigned)mavlink_system.sysid);
 #endif
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         if (entry->max_msg_len > pkt_len) {
@@ -299,28 +300,31 @@ void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entr
                           entry->max_msg_len, pkt_len);
         }
 #endif
-        _mav_finalize_message_chan_send(routes[i].channel,
+        _mav_finalize_message_chan_send(channel,
                                         entry->msgid,
                                         pkt,
                                         entry->min_msg_len,
                                         MIN(entry->max_msg_len, pkt_len),
                                         entry->crc_extra);
-        sent_to_chan[routes[i].channel] = true;
     }
 }
 
 /*
-  search for the first vehicle or component in the routing table with given mav_type and retrieve it's sysid, compid and channel
+  search for a vehicle or component in the routing table with given mav_type and retrieve it's sysid, compid and channel
   returns true if a match is found
+
+  these searches aren't keyed on sysid/compid so must walk the table,
+  but they are only used when setting up peripherals
  */
 bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &compid, mavlink_channel_t &channel)
 {
     // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].mavtype == mavtype) {
-            sysid = routes[i].sysid;
-            compid = routes[i].compid;
-            channel = routes[i].channel;
+    for (uint16_t i=0; i<route_table.num_slots(); i++) {
+        const MAVLink_RouteTable::Route *route = route_table.slot(i);
+        if (route != nullptr && route->mavtype == mavtype) {
+            sysid = route->sysid;
+            compid = route->compid;
+            channel = first_channel(route->channels);
             return true;
         }
     }
@@ -330,15 +334,16 @@ bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &
 }
 
 /*
-  search for the first vehicle or component in the routing table with given mav_type and component id and retrieve its sysid and channel
+  search for a vehicle or component in the routing table with given mav_type and component id and retrieve its sysid and channel
   returns true if a match is found
  */
 bool MAVLink_routing::find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid, uint8_t &sysid, mavlink_channel_t &channel) const
 {
-    for (uint8_t i=0; i<num_routes; i++) {
-        if ((routes[i].mavtype == mavtype) && (routes[i].compid == compid)) {
-            sysid = routes[i].sysid;
-            channel = routes[i].channel;
+    for (uint16_t i=0; i<route_table.num_slots(); i++) {
+        const MAVLink_RouteTable::Route *route = route_table.slot(i);
+        if (route != nullptr && route->mavtype == mavtype && route->compid == compid) {
+            sysid = route->sysid;
+            channel = first_channel(route->channels);
             return true;
         }
     }
@@ -350,7 +355,6 @@ bool MAVLink_routing::find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid
 */
 void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t &msg)
 {
-    uint8_t i;
     if (msg.sysid == 0) {
         // don't learn routes to the broadcast system
         return;
@@ -368,31 +372,31 @@ void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t
         return;
     }
     const mavlink_channel_t in_channel = in_link.get_chan();
-    for (i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid &&
-            routes[i].compid == msg.compid &&
-            routes[i].channel == in_channel) {
-            if (routes[i].mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
-            }
-            break;
-        }
+#if ROUTING_DEBUG
+    const uint16_t old_count = route_table.count();
+#endif
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_expire_ms >= 1000) {
+        // forget routes to components which have gone away
+        last_expire_ms = now_ms;
+        route_table.expire(now_ms);
+    }
+    MAVLink_RouteTable::Route *route = route_table.learn(msg.sysid, msg.compid, in_channel, now_ms);
+    if (route == nullptr) {
+        // table full of live routes
+        return;
+    }
+    if (route->mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        route->mavtype = mavlink_msg_heartbeat_get_type(&msg);
     }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
-        routes[i].sysid = msg.sysid;
-        routes[i].compid = msg.compid;
-        routes[i].channel = in_channel;
-        if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-            routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
-        }
-        num_routes++;
 #if ROUTING_DEBUG
+    if (route_table.count() != old_count) {
         ::printf("learned route %u %u via %u\n",
                  (unsigned)msg.sysid,
                  (unsigned)msg.compid,
                  (unsigned)in_channel);
-#endif
     }
+#endif
 }
 
 
@@ -415,10 +419,9 @@ void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_
     mask &= ~no_route_mask;
     
     // mask out channels that are known sources for this sysid/compid
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid && routes[i].compid == msg.compid) {
-            mask &= ~(1U<<((unsigned)(routes[i].channel-MAVLINK_COMM_0)));
-        }
+    const MAVLink_RouteTable::Route *route = route_table.find(msg.sysid, msg.compid);
+    if (route != nullptr) {
+        mask &= ~route->channels;
     }
 
     if (mask == 0) {
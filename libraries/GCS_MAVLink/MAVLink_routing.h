@@ -4,10 +4,7 @@
 
 #include <AP_Common/AP_Common.h>
 #include "GCS_MAVLink.h"
-
-// 20 routes should be enough for now. This may need to increase as
-// we make more extensive use of MAVLink forwarding
-#define MAVLINK_MAX_ROUTES 20
+#include "MAVLink_RouteTable.h"
 
 /*
   object to handle MAVLink packet routing
@@ -40,28 +37,27 @@ public:
     void send_to_components(uint32_t msgid, const char *pkt, uint8_t pkt_len);
 
     /*
-      search for the first vehicle or component in the routing table with given mav_type and retrieve it's sysid, compid and channel
+      search for a vehicle or component in the routing table with given mav_type and retrieve it's sysid, compid and channel
       returns true if a match is found
      */
     bool find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &compid, mavlink_channel_t &channel);
 
     /*
-      search for the first vehicle or component in the routing table with given mav_type and component id and retrieve its sysid and channel
+      search for a vehicle or component in the routing table with given mav_type and component id and retrieve its sysid and channel
       returns true if a match is found
      */
     bool find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid, uint8_t &sysid, mavlink_channel_t &channel) const;
 
 private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
-    uint8_t num_routes;
-    struct route {
-        uint8_t sysid;
-        uint8_t compid;
-        mavlink_channel_t channel;
-        uint8_t mavtype;
-    } routes[MAVLINK_MAX_ROUTES];
-    
+    // routes we have learned, hashed on sysid/compid
+    MAVLink_RouteTable route_table;
+    uint32_t last_expire_ms;
+
+    // return the lowest-numbered channel in a non-empty channel mask
+    static mavlink_channel_t first_channel(mavlink_channel_mask_t channels) {
+        return (mavlink_channel_t)(MAVLINK_COMM_0 + __builtin_ctz(channels));
+    }
+
     // a channel mask to block routing as required
     uint8_t no_route_mask;
     
@@ -0,0 +1,86 @@
+/*
+ * Benchmarks for the hashed MAVLink route table
+ */
+#include <AP_gbenchmark.h>
+
+#include <GCS_MAVLink/MAVLink_RouteTable.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// spread components across systems and channels the way a relay
+// vehicle in a swarm sees them: a few components per system
+static void fill_table(MAVLink_RouteTable &table, uint16_t num_components)
+{
+    for (uint16_t i=0; i<num_components; i++) {
+        const uint8_t sysid = 1 + i / 4;
+        const uint8_t compid = 1 + i % 4;
+        table.learn(sysid, compid, (mavlink_channel_t)(MAVLINK_COMM_0 + i % MAVLINK_COMM_NUM_BUFFERS), 0);
+    }
+}
+
+// every received packet re-learns (refreshes) its source route
+static void BM_RouteTableLearn(benchmark::State& state)
+{
+    const uint16_t num_components = MIN(state.range(0), MAVLINK_MAX_ROUTES);
+    MAVLink_RouteTable *table = new MAVLink_RouteTable();
+    fill_table(*table, num_components);
+
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        const uint8_t sysid = 1 + i / 4;
+        const uint8_t compid = 1 + i % 4;
+        auto *route = table->learn(sysid, compid, MAVLINK_COMM_0, 1000);
+        gbenchmark_escape(route);
+        if (++i == num_components) {
+            i = 0;
+        }
+    }
+    delete table;
+}
+
+// forwarding decisions for targeted and system-wide packets
+static void BM_RouteTableForward(benchmark::State& state)
+{
+    const uint16_t num_components = MIN(state.range(0), MAVLINK_MAX_ROUTES);
+    MAVLink_RouteTable *table = new MAVLink_RouteTable();
+    fill_table(*table, num_components);
+
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        const uint8_t sysid = 1 + i / 4;
+        const uint8_t compid = 1 + i % 4;
+        mavlink_channel_mask_t channels = table->system_channels(sysid);
+        const auto *route = table->find(sysid, compid);
+        if (route != nullptr) {
+            channels |= route->channels;
+        }
+        gbenchmark_escape(&channels);
+        if (++i == num_components) {
+            i = 0;
+        }
+    }
+    delete table;
+}
+
+// a full table being churned by new components replacing stale ones
+static void BM_RouteTableEvict(benchmark::State& state)
+{
+    MAVLink_RouteTable *table = new MAVLink_RouteTable();
+    fill_table(*table, MAVLINK_MAX_ROUTES);
+
+    uint32_t now_ms = MAVLINK_ROUTE_EXPIRE_MS + 1;
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        auto *route = table->learn(200 + i % 50, 100 + i / 50, MAVLINK_COMM_0, now_ms);
+        gbenchmark_escape(route);
+        i = (i + 1) % 2500;
+        now_ms += MAVLINK_ROUTE_EXPIRE_MS + 1;
+    }
+    delete table;
+}
+
+BENCHMARK(BM_RouteTableLearn)->Arg(20)->Arg(64)->Arg(256);
+BENCHMARK(BM_RouteTableForward)->Arg(20)->Arg(64)->Arg(256);
+BENCHMARK(BM_RouteTableEvict);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,374 @@
+/*
+  check that the route table finds every route it has learned as
+  routes are added, refreshed and expired, including routes whose
+  probe sequence wraps around the end of the table and routes moved
+  back by the deletion of an earlier entry
+ */
+#include <AP_gtest.h>
+
+#include <GCS_MAVLink/GCS_config.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_GCS_ENABLED
+
+#include <GCS_MAVLink/MAVLink_RouteTable.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+typedef MAVLink_RouteTable::Route Route;
+typedef std::pair<uint8_t, uint8_t> RouteKey;
+
+class MAVLink_RouteTable_Test
+{
+public:
+    static uint16_t home_slot(uint8_t sysid, uint8_t compid) { return MAVLink_RouteTable::route_hash(sysid, compid); }
+
+    // the slot a route is stored in
+    static uint16_t slot_of(const MAVLink_RouteTable &table, uint8_t sysid, uint8_t compid)
+    {
+        return table.find(sysid, compid) - &table.routes[0];
+    }
+
+    // keys whose home slot is slot, sysids first
+    static std::vector<RouteKey> keys_for_slot(uint16_t slot, uint8_t count)
+    {
+        std::vector<RouteKey> keys;
+        for (uint16_t sysid = 1; sysid < 256 && keys.size() < count; sysid++) {
+            for (uint16_t compid = 0; compid < 256 && keys.size() < count; compid++) {
+                if (home_slot(sysid, compid) == slot) {
+                    keys.push_back({uint8_t(sysid), uint8_t(compid)});
+                }
+            }
+        }
+        return keys;
+    }
+
+    /*
+      every route is reachable from its home slot without crossing an
+      empty slot, and the route and system counts and channels agree
+     */
+    static void check_consistent(const MAVLink_RouteTable &table)
+    {
+        const uint16_t n = MAVLink_RouteTable::NUM_SLOTS;
+        uint16_t num_routes = 0;
+        std::map<uint8_t, std::pair<uint16_t, mavlink_channel_mask_t>> systems;
+        for (uint16_t i = 0; i < n; i++) {
+            const Route &r = table.routes[i];
+            if (r.sysid == 0) {
+                continue;
+            }
+            num_routes++;
+            systems[r.sysid].first++;
+            systems[r.sysid].second |= r.channels;
+            for (uint16_t j = home_slot(r.sysid, r.compid); j != i; j = (j + 1) % n) {
+                ASSERT_NE(table.routes[j].sysid, 0) << "route " << unsigned(r.sysid) << "/" << unsigned(r.compid) << " cut off at slot " << j;
+            }
+        }
+        EXPECT_EQ(table.count(), num_routes);
+
+        uint16_t num_systems = 0;
+        for (uint16_t i = 0; i < n; i++) {
+            const auto &s = table.systems[i];
+            if (s.sysid == 0) {
+                continue;
+            }
+            num_systems++;
+            ASSERT_EQ(systems.count(s.sysid), 1U) << "system " << unsigned(s.sysid) << " has no routes";
+            EXPECT_EQ(s.num_routes, systems[s.sysid].first) << unsigned(s.sysid);
+            EXPECT_EQ(s.channels, systems[s.sysid].second) << unsigned(s.sysid);
+            EXPECT_EQ(table.system_channels(s.sysid), systems[s.sysid].second) << unsigned(s.sysid);
+        }
+        EXPECT_EQ(num_systems, systems.size());
+    }
+};
+
+static mavlink_channel_t chan(uint8_t i)
+{
+    return mavlink_channel_t(MAVLINK_COMM_0 + i % MAVLINK_COMM_NUM_BUFFERS);
+}
+
+static mavlink_channel_mask_t chan_bit(uint8_t i)
+{
+    return 1U << (chan(i) - MAVLINK_COMM_0);
+}
+
+TEST(MAVLink_RouteTable, LearnFind)
+{
+    MAVLink_RouteTable *table = new MAVLink_RouteTable();
+
+    EXPECT_NE(table->learn(1, 1, chan(0), 1000), nullptr);
+    EXPECT_NE(table->learn(1, 2, chan(1), 1000), nullptr);
+    EXPECT_NE(table->learn(2, 1, chan(0), 1000), nullptr);
+    // heard again on another channel
+    const Route *route = table->learn(1, 1, chan(2), 1100);
+    ASSERT_NE(route, nullptr);
+    EXPECT_EQ(table->count(), 3);
+
+    EXPECT_EQ(table->find(1, 1), route);
+    EXPECT_EQ(route->channels, chan_bit(0) | chan_bit(2));
+    EXPECT_EQ(route->last_seen_ms, 1100U);
+    ASSERT_NE(table->find(1, 2), nullptr);
+    EXPECT_EQ(table->find(1, 2)->channels, chan_bit(1));
+    ASSERT_NE(table->find(2, 1), nullptr);
+    EXPECT_EQ(table->find(2, 1)->channels, chan_bit(0));
+
+    EXPECT_EQ(table->find(1, 3), nullptr);
+    EXPECT_EQ(table->find(3, 1), nullptr);
+
+    EXPECT_EQ(table->system_channels(1), chan_bit(0) | chan_bit(1) | chan_bit(2));
+    EXPECT_EQ(table->system_channels(2), chan_bit(0));
+    EXPECT_EQ(table->system_channels(3), 0);
+    EXPECT_EQ(table->all_channels(), chan_bit(0) | chan_bit(1) | chan_bit(2));
+
+    // sysid zero marks empty slots and is never routed to
+    EXPECT_EQ(table->learn(0, 1, chan(0), 1000), nullptr);
+    EXPECT_EQ(table->find(0, 1), nullptr);
+    EXPECT_EQ(table->system_channels(0), 0);
+    EXPECT_EQ(table->count(), 3);
+
+    MAVLink_RouteTable_Test::check_consistent(*table);
+    delete table;
+}
+
+TEST(MAVLink_RouteTable, Expiry)
+{
+    MAVLink_RouteTable *table = new MAVLink_RouteTable();
+
+    ASSERT_NE(table->learn(1, 1, chan(0), 1000), nullptr);
+    ASSERT_NE(table->learn(1, 2, chan(1), 5000), nullptr);
+    ASSERT_NE(table->learn(2, 1, chan(2), 1000), nullptr);
+
+    // routes are kept until they have been quiet for longer than the expiry time
+    EXPECT_EQ(table->expire(1000 + MAVLINK_ROUTE_EXPIRE_MS), 0);
+    EXPECT_EQ(table->count(), 3);
+    EXPECT_EQ(table->expire(1001 + MAVLINK_ROUTE_EXPIRE_MS), 2);
+    EXPECT_EQ(table->count(), 1);
+
+    EXPECT_EQ(table->find(1, 1), nullptr);
+    EXPECT_NE(table->find(1, 2), nullptr);
+    EXPECT_EQ(table->find(2, 1), nullptr);
+    EXPECT_EQ(table->system_channels(1), chan_bit(1));
+    EXPECT_EQ(table->system_channels(2), 0);
+    EXPECT_EQ(table->all_channels(), chan_bit(1));
+    MAVLink_RouteTable_Test::check_consistent(*table);
+
+    // an expired route is learned again
+    EXPECT_NE(table->learn(1, 1, chan(0), 40000), nullptr);
+    EXPECT_EQ(table->system_channels(1), chan_bit(0) | chan_bit(1));
+    MAVLink_RouteTable_Test::check_consistent(*table);
+
+    // ages are measured across the wrap of the millisecond clock
+    const uint32_t before_wrap_ms = UINT32_MAX - 1000;
+    ASSERT_NE(table->learn(3, 1, chan(0), before_wrap_ms), nullptr);
+    table->learn(1, 1, chan(0), before_wrap_ms);
+    table->learn(1, 2, chan(1), before_wrap_ms);
+    EXPECT_EQ(table->expire(before_wrap_ms + MAVLINK_ROUTE_EXPIRE_MS), 0);
+    EXPECT_EQ(table->expire(before_wrap_ms + MAVLINK_ROUTE_EXPIRE_MS + 1), 3);
+    EXPECT_EQ(table->count(), 0);
+    EXPECT_EQ(table->all_channels(), 0);
+    MAVLink_RouteTable_Test::check_consistent(*table);
+
+    delete table;
+}
+
+TEST(MAVLink_RouteTable, FullTable)
+{
+    MAVLink_RouteTable *table = new MAVLink_RouteTable();
+
+    // a few components per system, as seen by a relay in a swarm
+    for (uint16_t i = 0; i < MAVLINK_MAX_ROUTES; i++) {
+        ASSERT_NE(table->learn(1 + i / 4, 1 + i % 4, chan(i), 1000 + i), nullptr) << i;
+    }
+    EXPECT_EQ(table->count(), MAVLINK_MAX_ROUTES);
+    MAVLink_RouteTable_Test::check_consistent(*table);
+
+    // no room for another while all are recent, but known routes can still be refreshed
+    const uint8_t new_sysid = 1 + MAVLINK_MAX_ROUTES / 4 + 1;
+    EXPECT_EQ(table->learn(new_sysid, 1, chan(0), 2000), nullptr);
+    EXPECT_NE(table->learn(1, 1, chan(0), 1000 + MAVLINK_ROUTE_EXPIRE_MS), nullptr);
+    EXPECT_EQ(table->count(), MAVLINK_MAX_ROUTES);
+
+    // once the oldest have expired a new route takes their place
+    const uint32_t now_ms = 1000 + MAVLINK_ROUTE_EXPIRE_MS + 10;
+    ASSERT_NE(table->learn(new_sysid, 1, chan(0), now_ms), nullptr);
+    EXPECT_EQ(table->count(), MAVLINK_MAX_ROUTES - 9 + 1);
+    EXPECT_NE(table->find(1, 1), nullptr);
+    EXPECT_EQ(table->find(1, 2), nullptr);
+    for (uint16_t i = 10; i < MAVLINK_MAX_ROUTES; i++) {
+        EXPECT_NE(table->find(1 + i / 4, 1 + i % 4), nullptr) << i;
+    }
+    MAVLink_RouteTable_Test::check_consistent(*table);
+
+    delete table;
+}
+
+TEST(MAVLink_RouteTable, Wraparound)
+{
+    MAVLink_RouteTable *table = new MAVLink_RouteTable();
+
+    // the highest and lowest ids are all usable
+    for (const RouteKey &key : { RouteKey{255, 255}, RouteKey{255, 0}, RouteKey{1, 0}, RouteKey{1, 255} }) {
+        ASSERT_NE(table->learn(key.first, key.second, chan(1), 1000), nullptr);
+    }
+    for (const RouteKey &key : { RouteKey{255, 255}, RouteKey{255, 0}, RouteKey{1, 0}, RouteKey{1, 255} }) {
+        const Route *route = table->find(key.first, key.second);
+        ASSERT_NE(route, nullptr);
+        EXPECT_EQ(route->sysid, key.first);
+        EXPECT_EQ(route->compid, key.second);
+    }
+    EXPECT_EQ(table->find(255, 1), nullptr);
+    EXPECT_EQ(table->system_channels(255), chan_bit(1));
+
+    // routes whose home is the last slot spill over into the start of the table
+    const uint16_t last_slot = MAVLink_RouteTable::num_slots() - 1;
+    const std::vector<RouteKey> keys = MAVLink_RouteTable_Test::keys_for_slot(last_slot, 4);
+    ASSERT_EQ(keys.size(), 4U);
+    for (const auto &key : keys) {
+        ASSERT_NE(table->learn(key.first, key.second, chan(0), 2000), nullptr);
+    }
+    EXPECT_EQ(MAVLink_RouteTable_Test::slot_of(*table, keys[0].first, keys[0].second), last_slot);
+    EXPECT_LT(MAVLink_RouteTable_Test::slot_of(*table, keys[3].first, keys[3].second), last_slot);
+    MAVLink_RouteTable_Test::check_consistent(*table);
+
+    // removing the one in the last slot moves the next back across the end of the table
+    table->learn(keys[1].first, keys[1].second, chan(0), 3000);
+    table->learn(keys[2].first, keys[2].second, chan(0), 3000);
+    table->learn(keys[3].first, keys[3].second, chan(0), 3000);
+    EXPECT_EQ(table->expire(2001 + MAVLINK_ROUTE_EXPIRE_MS), 5);
+    EXPECT_EQ(table->find(keys[0].first, keys[0].second), nullptr);
+    for (uint8_t i = 1; i < keys.size(); i++) {
+        ASSERT_NE(table->find(keys[i].first, keys[i].second), nullptr) << unsigned(i);
+    }
+    EXPECT_EQ(MAVLink_RouteTable_Test::slot_of(*table, keys[1].first, keys[1].second), last_slot);
+    MAVLink_RouteTable_Test::check_consistent(*table);
+    delete table;
+
+    // a hole just before the end of the table must not pull back routes homed after the wrap
+    table = new MAVLink_RouteTable();
+    const std::vector<RouteKey> wrapped = MAVLink_RouteTable_Test::keys_for_slot(0, 2);
+    ASSERT_EQ(wrapped.size(), 2U);
+    const std::vector<RouteKey> run {
+        MAVLink_RouteTable_Test::keys_for_slot(last_slot - 1, 1).at(0),
+        MAVLink_RouteTable_Test::keys_for_slot(last_slot, 1).at(0),
+        wrapped[0],
+        wrapped[1],
+    };
+    for (uint8_t i = 0; i < run.size(); i++) {
+        ASSERT_NE(table->learn(run[i].first, run[i].second, chan(i), i == 0 ? 1000 : 5000), nullptr);
+    }
+    EXPECT_EQ(table->expire(1001 + MAVLINK_ROUTE_EXPIRE_MS), 1);
+    for (uint8_t i = 1; i < run.size(); i++) {
+        ASSERT_NE(table->find(run[i].first, run[i].second), nullptr) << unsigned(i);
+    }
+    EXPECT_EQ(MAVLink_RouteTable_Test::slot_of(*table, run[1].first, run[1].second), last_slot);
+    EXPECT_EQ(MAVLink_RouteTable_Test::slot_of(*table, run[2].first, run[2].second), 0);
+    EXPECT_EQ(table->slot(last_slot - 1), nullptr);
+    MAVLink_RouteTable_Test::check_consistent(*table);
+    delete table;
+}
+
+/*
+  a run of routes sharing a home slot, followed by routes homed just
+  after it which have been pushed along by the run.  Each route in
+  turn is expired and the rest must still be found
+ */
+TEST(MAVLink_RouteTable, BackwardShiftDeletion)
+{
+    const uint16_t home = 100;
+    std::vector<RouteKey> keys = MAVLink_RouteTable_Test::keys_for_slot(home, 4);
+    for (uint16_t slot = home + 1; slot < home + 4; slot++) {
+        const std::vector<RouteKey> more = MAVLink_RouteTable_Test::keys_for_slot(slot, 1);
+        keys.insert(keys.end(), more.begin(), more.end());
+    }
+    ASSERT_EQ(keys.size(), 7U);
+
+    for (uint8_t removed = 0; removed < keys.size(); removed++) {
+        MAVLink_RouteTable *table = new MAVLink_RouteTable();
+        for (uint8_t i = 0; i < keys.size(); i++) {
+            const uint32_t seen_ms = (i == removed) ? 1000 : 5000;
+            ASSERT_NE(table->learn(keys[i].first, keys[i].second, chan(i), seen_ms), nullptr);
+        }
+        // the run fills consecutive slots from the shared home
+        for (uint8_t i = 0; i < keys.size(); i++) {
+            EXPECT_EQ(MAVLink_RouteTable_Test::slot_of(*table, keys[i].first, keys[i].second), home + i);
+        }
+
+        EXPECT_EQ(table->expire(1001 + MAVLINK_ROUTE_EXPIRE_MS), 1) << unsigned(removed);
+        EXPECT_EQ(table->find(keys[removed].first, keys[removed].second), nullptr);
+        for (uint8_t i = 0; i < keys.size(); i++) {
+            if (i == removed) {
+                continue;
+            }
+            const Route *route = table->find(keys[i].first, keys[i].second);
+            ASSERT_NE(route, nullptr) << "removed " << unsigned(removed) << " lost " << unsigned(i);
+            EXPECT_EQ(route->channels, chan_bit(i));
+            // entries after the hole move back unless that would take them before their home
+            const uint16_t home_i = MAVLink_RouteTable_Test::home_slot(keys[i].first, keys[i].second);
+            EXPECT_GE(MAVLink_RouteTable_Test::slot_of(*table, keys[i].first, keys[i].second), home_i);
+        }
+        // the run closed up, leaving no gap
+        EXPECT_EQ(table->slot(home + keys.size() - 1), nullptr) << unsigned(removed);
+        MAVLink_RouteTable_Test::check_consistent(*table);
+        delete table;
+    }
+}
+
+// random traffic from a changing set of components, checked against a simple model
+TEST(MAVLink_RouteTable, RandomTraffic)
+{
+    MAVLink_RouteTable *table = new MAVLink_RouteTable();
+    std::map<RouteKey, std::pair<uint32_t, mavlink_channel_mask_t>> model;
+
+    uint32_t rand_state = 1;
+    auto rand_u32 = [&rand_state]() {
+        rand_state = rand_state * 1664525U + 1013904223U;
+        return rand_state >> 8;
+    };
+
+    // start near the wrap of the millisecond clock
+    uint32_t now_ms = UINT32_MAX - 100000;
+    for (uint32_t step = 0; step < 20000; step++) {
+        now_ms += rand_u32() % 40;
+        // a few hundred components, so the table fills and expires routes
+        const RouteKey key { uint8_t(1 + rand_u32() % 100), uint8_t(rand_u32() % 4 == 0 ? rand_u32() % 256 : 1 + rand_u32() % 3) };
+        const uint8_t c = rand_u32() % MAVLINK_COMM_NUM_BUFFERS;
+
+        if (model.count(key) == 0 && model.size() >= MAVLINK_MAX_ROUTES) {
+            for (auto it = model.begin(); it != model.end(); ) {
+                if (now_ms - it->second.first > MAVLINK_ROUTE_EXPIRE_MS) {
+                    it = model.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        const bool room = model.count(key) != 0 || model.size() < MAVLINK_MAX_ROUTES;
+        const Route *route = table->learn(key.first, key.second, chan(c), now_ms);
+        ASSERT_EQ(route != nullptr, room) << "step " << step;
+        if (room) {
+            model[key].first = now_ms;
+            model[key].second |= chan_bit(c);
+        }
+        ASSERT_EQ(table->count(), model.size()) << "step " << step;
+
+        if (step % 500 == 0) {
+            for (const auto &m : model) {
+                const Route *r = table->find(m.first.first, m.first.second);
+                ASSERT_NE(r, nullptr) << "step " << step;
+                EXPECT_EQ(r->last_seen_ms, m.second.first);
+                EXPECT_EQ(r->channels, m.second.second);
+            }
+            MAVLink_RouteTable_Test::check_consistent(*table);
+        }
+    }
+    EXPECT_GT(model.size(), MAVLINK_MAX_ROUTES / 2);
+
+    delete table;
+}
+
+#endif  // HAL_GCS_ENABLED
+
+AP_GTEST_MAIN()
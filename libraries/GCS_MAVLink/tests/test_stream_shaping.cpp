@@ -0,0 +1,113 @@
+/*
+  check the order deferred message buckets are sent in with stream
+  shaping off, where it must match the behaviour without shaping, and
+  on, where overdue buckets share the link by weight
+ */
+#include <AP_gtest.h>
+
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_MAVLINK_STREAM_SHAPING_ENABLED
+
+GCS_Dummy _gcs;
+
+class GCS_MAVLINK_Test
+{
+public:
+    static const uint8_t num_buckets = 3;
+
+    // three buckets of one message each, all long overdue, with their
+    // finish tags in the opposite order to their indexes
+    static void setup(GCS_MAVLINK &link, int8_t bw_target_pct, const uint8_t weights[num_buckets])
+    {
+        link.bw_target_pct.set(bw_target_pct);
+        link.stream_shaping.virtual_time = 0;
+        link.stream_shaping.scale_pct = 100;
+        const ap_message ids[num_buckets] { MSG_ATTITUDE, MSG_LOCATION, MSG_SYS_STATUS };
+        const uint16_t now16_ms = AP_HAL::millis16();
+        for (uint8_t i = 0; i < ARRAY_SIZE(link.deferred_message_bucket); i++) {
+            auto &bucket = link.deferred_message_bucket[i];
+            bucket.ap_message_ids.clearall();
+            if (i < num_buckets) {
+                bucket.ap_message_ids.set(ids[i]);
+                bucket.interval_ms = 100;
+                bucket.last_sent_ms = now16_ms - 10000;
+                bucket.weight = weights[i];
+                bucket.virtual_time = 3 - i;
+            }
+        }
+    }
+
+    // send the next bucket, leaving it overdue, and return its index
+    static uint8_t send_next(GCS_MAVLINK &link)
+    {
+        link.find_next_bucket_to_send(AP_HAL::millis16());
+        const uint8_t id = link.sending_bucket_id;
+        if (id < num_buckets) {
+            link.stream_shaping_bucket_sent(link.deferred_message_bucket[id], 1);
+        }
+        return id;
+    }
+
+    static uint32_t virtual_time(const GCS_MAVLINK &link, uint8_t bucket) { return link.deferred_message_bucket[bucket].virtual_time; }
+
+    // the interval a bucket is rescheduled at with the given stretch
+    static uint16_t interval_ms(GCS_MAVLINK &link, uint8_t bucket, uint16_t scale_pct)
+    {
+        const uint16_t old_scale_pct = link.stream_shaping.scale_pct;
+        link.stream_shaping.scale_pct = scale_pct;
+        const uint16_t ret = link.get_reschedule_interval_ms(link.deferred_message_bucket[bucket]);
+        link.stream_shaping.scale_pct = old_scale_pct;
+        return ret;
+    }
+};
+
+static GCS_MAVLINK_Dummy gcs_link{*hal.serial(0)};
+
+static const uint8_t weights[GCS_MAVLINK_Test::num_buckets] { 1, 4, 1 };
+
+TEST(GCS_MAVLINK, BucketOrderShapingOff)
+{
+    GCS_MAVLINK_Test::setup(gcs_link, 0, weights);
+
+    // the first overdue bucket is always sent, and the finish tags are untouched
+    for (uint8_t i = 0; i < 30; i++) {
+        EXPECT_EQ(GCS_MAVLINK_Test::send_next(gcs_link), 0) << unsigned(i);
+    }
+    for (uint8_t b = 0; b < GCS_MAVLINK_Test::num_buckets; b++) {
+        EXPECT_EQ(GCS_MAVLINK_Test::virtual_time(gcs_link, b), 3U - b);
+    }
+
+    // intervals are not stretched, even if a stretch was left over from when shaping was on
+    EXPECT_EQ(GCS_MAVLINK_Test::interval_ms(gcs_link, 0, 300), GCS_MAVLINK_Test::interval_ms(gcs_link, 0, 100));
+}
+
+TEST(GCS_MAVLINK, BucketOrderShapingOn)
+{
+    GCS_MAVLINK_Test::setup(gcs_link, 80, weights);
+
+    // the bucket with the earliest finish tag goes first
+    EXPECT_EQ(GCS_MAVLINK_Test::send_next(gcs_link), 2);
+
+    // then the overdue buckets share the link in proportion to their weights
+    uint16_t sent[GCS_MAVLINK_Test::num_buckets] {};
+    for (uint16_t i = 0; i < 600; i++) {
+        const uint8_t id = GCS_MAVLINK_Test::send_next(gcs_link);
+        ASSERT_LT(id, GCS_MAVLINK_Test::num_buckets);
+        sent[id]++;
+    }
+    EXPECT_NEAR(sent[0], 100, 2);
+    EXPECT_NEAR(sent[1], 400, 2);
+    EXPECT_NEAR(sent[2], 100, 2);
+
+    // light buckets are stretched more than heavy ones when over target
+    const uint16_t base_ms = GCS_MAVLINK_Test::interval_ms(gcs_link, 0, 100);
+    EXPECT_EQ(GCS_MAVLINK_Test::interval_ms(gcs_link, 0, 300), base_ms * 3);
+    EXPECT_EQ(GCS_MAVLINK_Test::interval_ms(gcs_link, 1, 300), base_ms * 3 / 2);
+}
+
+#endif  // AP_MAVLINK_STREAM_SHAPING_ENABLED
+
+AP_GTEST_MAIN()